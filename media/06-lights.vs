@@ -11,6 +11,9 @@ uniform mat4 u_model;
 uniform mat4 u_modelView;
 uniform mat4 u_modelViewProj;
 
+// same expression as 06-lights_depth.vs, so the shading pass can test against the depth pre-pass with GL_EQUAL
+invariant gl_Position;
+
 void main()
 {
 	v_texcoord = a_texcoord;
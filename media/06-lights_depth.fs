@@ -0,0 +1,6 @@
+#version 330 core
+
+// depth pre-pass, color writes are off
+void main()
+{
+}
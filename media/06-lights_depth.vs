@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec3 a_position;
+
+uniform mat4 u_modelViewProj;
+
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = u_modelViewProj * vec4(a_position, 1.0);
+}
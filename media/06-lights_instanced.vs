@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 a_position;
+layout (location = 1) in vec3 a_normal;
+layout (location = 2) in vec2 a_texcoord;
+layout (location = 3) in mat4 a_model;
+
+out vec2 v_texcoord;
+out vec3 v_modelPosition;
+out vec3 v_normal;
+
+uniform mat4 u_view;
+uniform mat4 u_viewProj;
+
+void main()
+{
+	v_texcoord = a_texcoord;
+	
+    vec4 modelPosition = a_model * vec4(a_position, 1.0);
+    v_modelPosition = vec3(modelPosition);
+
+	// instances are rigid, the inverse transpose of the model view reduces to its rotation
+	v_normal = mat3(u_view) * mat3(a_model) * a_normal;
+
+    gl_Position = u_viewProj * modelPosition;
+}
@@ -0,0 +1,29 @@
+#version 330 core
+layout (location = 0) in vec3 a_position;
+layout (location = 1) in vec3 a_normal;
+layout (location = 2) in vec2 a_texcoord;
+layout (location = 3) in vec4 a_translationScale;
+layout (location = 4) in vec4 a_rotation;
+
+out vec2 v_texcoord;
+out vec3 v_modelPosition;
+out vec3 v_normal;
+
+uniform mat4 u_view;
+uniform mat4 u_viewProj;
+
+vec3 rotate(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+	v_texcoord = a_texcoord;
+	
+    v_modelPosition = rotate(a_rotation, a_position * a_translationScale.w) + a_translationScale.xyz;
+
+	v_normal = mat3(u_view) * rotate(a_rotation, a_normal);
+
+    gl_Position = u_viewProj * vec4(v_modelPosition, 1.0);
+}
@@ -0,0 +1,40 @@
+#version 430 core
+layout (location = 0) in vec3 a_position;
+layout (location = 1) in vec3 a_normal;
+layout (location = 2) in vec2 a_texcoord;
+layout (location = 3) in uint a_drawId;
+
+struct DrawData {
+	mat4 model;
+	uint material;
+	uint padding0;
+	uint padding1;
+	uint padding2;
+};
+
+layout (std430, binding = 0) readonly buffer DrawDatas {
+	DrawData draws[];
+};
+
+out vec2 v_texcoord;
+out vec3 v_modelPosition;
+out vec3 v_normal;
+flat out uint v_material;
+
+uniform mat4 u_view;
+uniform mat4 u_viewProj;
+
+void main()
+{
+	// a_drawId advances with the base instance of each indirect command
+	mat4 model = draws[a_drawId].model;
+	v_material = draws[a_drawId].material;
+	v_texcoord = a_texcoord;
+
+    vec4 modelPosition = model * vec4(a_position, 1.0);
+    v_modelPosition = vec3(modelPosition);
+
+	v_normal = mat3(u_view) * mat3(model) * a_normal;
+
+    gl_Position = u_viewProj * modelPosition;
+}
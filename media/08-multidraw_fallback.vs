@@ -0,0 +1,32 @@
+#version 330 core
+layout (location = 0) in vec3 a_position;
+layout (location = 1) in vec3 a_normal;
+layout (location = 2) in vec2 a_texcoord;
+
+// five texels per draw, the model matrix columns then the material (see DrawIndirectData)
+uniform usamplerBuffer u_drawData;
+uniform int u_drawId;
+
+out vec2 v_texcoord;
+out vec3 v_modelPosition;
+out vec3 v_normal;
+flat out uint v_material;
+
+uniform mat4 u_view;
+uniform mat4 u_viewProj;
+
+void main()
+{
+	int first = u_drawId * 5;
+	mat4 model = mat4(uintBitsToFloat(texelFetch(u_drawData, first)), uintBitsToFloat(texelFetch(u_drawData, first + 1)),
+		uintBitsToFloat(texelFetch(u_drawData, first + 2)), uintBitsToFloat(texelFetch(u_drawData, first + 3)));
+	v_material = texelFetch(u_drawData, first + 4).x;
+	v_texcoord = a_texcoord;
+
+    vec4 modelPosition = model * vec4(a_position, 1.0);
+    v_modelPosition = vec3(modelPosition);
+
+	v_normal = mat3(u_view) * mat3(model) * a_normal;
+
+    gl_Position = u_viewProj * modelPosition;
+}
@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) in vec3 a_position;
+layout (location = 1) in vec3 a_normal;
+layout (location = 2) in vec2 a_texcoord;
+
+out vec2 v_texcoord;
+out vec3 v_modelPosition;
+out vec3 v_normal;
+
+layout (std140) uniform DrawData {
+	mat4 u_model;
+	mat4 u_modelView;
+	mat4 u_modelViewProj;
+};
+
+void main()
+{
+	v_texcoord = a_texcoord;
+	
+    v_modelPosition = vec3(u_model * vec4(a_position, 1.0));
+
+	// objects are rigid, the inverse transpose of the model view reduces to its rotation
+	v_normal = mat3(u_modelView) * a_normal;
+
+    gl_Position = u_modelViewProj * vec4(a_position, 1.0);
+}
@@ -0,0 +1,69 @@
+#version 330 core
+struct Material {
+	sampler2D diffuse;
+	sampler2D specular;
+	float shininess;
+};
+
+out vec4 o_color;
+
+in vec2 v_texcoord;
+in vec3 v_viewPosition;
+in vec3 v_normal;
+
+uniform Material u_material;
+uniform vec3 u_ambient;
+uniform vec3 u_sunDirection;	// view space, towards the sun
+uniform vec3 u_sunColor;
+uniform int u_heatmap;
+
+// filled by LightGrid_Bind
+uniform samplerBuffer u_lightGridLights;	// 2 texels per light: view position and radius, color
+uniform usamplerBuffer u_lightGridClusters;	// offset and count per cluster
+uniform usamplerBuffer u_lightGridIndices;
+uniform int u_lightGridTilesX;
+uniform int u_lightGridTilesY;
+uniform int u_lightGridSlices;
+uniform vec4 u_lightGridScale;				// tiles per pixel, then slice = log(depth) * z + w
+
+vec3 Shade(vec3 lightDir, vec3 radiance, vec3 norm, vec3 viewDir, vec3 albedo, vec3 specularColor)
+{
+	float diff = max(dot(norm, lightDir), 0.0);
+	vec3 halfway = normalize(lightDir + viewDir);
+	float spec = pow(max(dot(norm, halfway), 0.0), u_material.shininess);
+	return radiance * (diff * albedo + spec * specularColor);
+}
+
+void main()
+{
+	vec3 norm = normalize(v_normal);
+	vec3 viewDir = normalize(-v_viewPosition);
+	vec3 albedo = vec3(texture(u_material.diffuse, v_texcoord));
+	vec3 specularColor = vec3(texture(u_material.specular, v_texcoord));
+
+	ivec2 tile = min(ivec2(gl_FragCoord.xy * u_lightGridScale.xy), ivec2(u_lightGridTilesX, u_lightGridTilesY) - 1);
+	int slice = clamp(int(log(-v_viewPosition.z) * u_lightGridScale.z + u_lightGridScale.w), 0, u_lightGridSlices - 1);
+	int cluster = (slice * u_lightGridTilesY + tile.y) * u_lightGridTilesX + tile.x;
+	uvec2 range = texelFetch(u_lightGridClusters, cluster).xy;
+
+	vec3 result = albedo * u_ambient + Shade(u_sunDirection, u_sunColor, norm, viewDir, albedo, specularColor);
+	for (uint i = 0u; i < range.y; i++) {
+		int light = int(texelFetch(u_lightGridIndices, int(range.x + i)).x);
+		vec4 positionRadius = texelFetch(u_lightGridLights, 2 * light);
+		vec3 toLight = positionRadius.xyz - v_viewPosition;
+		float distanceSquared = dot(toLight, toLight);
+		// windowed inverse square, reaches zero at the radius the light was clustered with
+		float ratio = distanceSquared / (positionRadius.w * positionRadius.w);
+		float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+		float attenuation = window * window / (distanceSquared + 1.0);
+		vec3 radiance = texelFetch(u_lightGridLights, 2 * light + 1).rgb * attenuation;
+		result += Shade(toLight * inversesqrt(distanceSquared), radiance, norm, viewDir, albedo, specularColor);
+	}
+
+	if (u_heatmap != 0) {
+		// blue to red up to 32 lights per cluster
+		float heat = clamp(float(range.y) / 32.0, 0.0, 1.0);
+		result = mix(result, vec3(heat, 4.0 * heat * (1.0 - heat), 1.0 - heat), 0.6);
+	}
+	o_color = vec4(result, 1.0);
+}
@@ -0,0 +1,48 @@
+#version 330 core
+out vec4 o_color;
+
+uniform sampler2D u_gbufferAlbedo;
+uniform sampler2D u_gbufferNormal;
+uniform sampler2D u_gbufferDepth;
+uniform vec4 u_projectionParams;
+uniform vec2 u_inverseScreenSize;
+
+uniform vec3 u_ambient;
+uniform vec3 u_sunDirection;	// view space, towards the sun
+uniform vec3 u_sunColor;
+uniform vec3 u_background;
+uniform float u_shininess;
+
+vec3 DecodeNormal(vec2 encoded)
+{
+	vec2 f = encoded * 2.0 - 1.0;
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+vec3 ViewPosition(vec2 uv, float depth)
+{
+	vec3 ndc = vec3(uv, depth) * 2.0 - 1.0;
+	float z = -u_projectionParams.w / (ndc.z + u_projectionParams.z);
+	return vec3(ndc.xy * u_projectionParams.xy * -z, z);
+}
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(u_gbufferDepth, pixel, 0).r;
+	if (depth == 1.0) {
+		o_color = vec4(u_background, 1.0);
+		return;
+	}
+	vec4 albedoSpecular = texelFetch(u_gbufferAlbedo, pixel, 0);
+	vec3 norm = DecodeNormal(texelFetch(u_gbufferNormal, pixel, 0).xy);
+	vec3 viewDir = normalize(-ViewPosition(gl_FragCoord.xy * u_inverseScreenSize, depth));
+
+	float diff = max(dot(norm, u_sunDirection), 0.0);
+	float spec = pow(max(dot(norm, normalize(u_sunDirection + viewDir)), 0.0), u_shininess);
+	vec3 result = albedoSpecular.rgb * u_ambient + u_sunColor * (diff * albedoSpecular.rgb + spec * albedoSpecular.a);
+	o_color = vec4(result, 1.0);
+}
@@ -0,0 +1,39 @@
+#version 330 core
+out vec4 o_color;
+
+uniform sampler2D u_gbufferAlbedo;
+uniform sampler2D u_gbufferNormal;
+uniform sampler2D u_gbufferDepth;
+uniform sampler2D u_lighting;
+uniform vec4 u_projectionParams;
+uniform int u_view;				// DeferredView
+
+vec3 DecodeNormal(vec2 encoded)
+{
+	vec2 f = encoded * 2.0 - 1.0;
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+void main()
+{
+	// the window may be larger than the G-buffer while it is being resized
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec3 result;
+	if (u_view == 1) {
+		result = texelFetch(u_gbufferAlbedo, pixel, 0).rgb;
+	} else if (u_view == 2) {
+		result = vec3(texelFetch(u_gbufferAlbedo, pixel, 0).a);
+	} else if (u_view == 3) {
+		result = DecodeNormal(texelFetch(u_gbufferNormal, pixel, 0).xy) * 0.5 + 0.5;
+	} else if (u_view == 4) {
+		float depth = texelFetch(u_gbufferDepth, pixel, 0).r;
+		float z = u_projectionParams.w / (depth * 2.0 - 1.0 + u_projectionParams.z);
+		result = vec3(1.0 - exp(-z * 0.05));
+	} else {
+		result = texelFetch(u_lighting, pixel, 0).rgb;
+	}
+	o_color = vec4(result, 1.0);
+}
@@ -0,0 +1,7 @@
+#version 330 core
+layout (location = 0) in vec2 a_position;
+
+void main()
+{
+	gl_Position = vec4(a_position, 0.0, 1.0);
+}
@@ -0,0 +1,68 @@
+#version 330 core
+out vec4 o_color;
+
+uniform sampler2D u_gbufferAlbedo;
+uniform sampler2D u_gbufferNormal;
+uniform sampler2D u_gbufferDepth;
+uniform vec4 u_projectionParams;
+uniform vec2 u_inverseScreenSize;
+uniform float u_shininess;
+
+// filled by LightGrid_Bind
+uniform samplerBuffer u_lightGridLights;	// 2 texels per light: view position and radius, color
+uniform usamplerBuffer u_lightGridClusters;	// offset and count per cluster
+uniform usamplerBuffer u_lightGridIndices;
+uniform int u_lightGridTilesX;
+uniform int u_lightGridTilesY;
+uniform int u_lightGridSlices;
+uniform vec4 u_lightGridScale;				// tiles per pixel, then slice = log(depth) * z + w
+
+vec3 DecodeNormal(vec2 encoded)
+{
+	vec2 f = encoded * 2.0 - 1.0;
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+vec3 ViewPosition(vec2 uv, float depth)
+{
+	vec3 ndc = vec3(uv, depth) * 2.0 - 1.0;
+	float z = -u_projectionParams.w / (ndc.z + u_projectionParams.z);
+	return vec3(ndc.xy * u_projectionParams.xy * -z, z);
+}
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(u_gbufferDepth, pixel, 0).r;
+	if (depth == 1.0) {
+		discard;
+	}
+	vec3 position = ViewPosition(gl_FragCoord.xy * u_inverseScreenSize, depth);
+	vec4 albedoSpecular = texelFetch(u_gbufferAlbedo, pixel, 0);
+	vec3 norm = DecodeNormal(texelFetch(u_gbufferNormal, pixel, 0).xy);
+	vec3 viewDir = normalize(-position);
+
+	ivec2 tile = min(ivec2(gl_FragCoord.xy * u_lightGridScale.xy), ivec2(u_lightGridTilesX, u_lightGridTilesY) - 1);
+	int slice = clamp(int(log(-position.z) * u_lightGridScale.z + u_lightGridScale.w), 0, u_lightGridSlices - 1);
+	int cluster = (slice * u_lightGridTilesY + tile.y) * u_lightGridTilesX + tile.x;
+	uvec2 range = texelFetch(u_lightGridClusters, cluster).xy;
+
+	vec3 result = vec3(0.0);
+	for (uint i = 0u; i < range.y; i++) {
+		int light = int(texelFetch(u_lightGridIndices, int(range.x + i)).x);
+		vec4 positionRadius = texelFetch(u_lightGridLights, 2 * light);
+		vec3 toLight = positionRadius.xyz - position;
+		float distanceSquared = dot(toLight, toLight);
+		float ratio = distanceSquared / (positionRadius.w * positionRadius.w);
+		float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+		float attenuation = window * window / (distanceSquared + 1.0);
+		vec3 lightDir = toLight * inversesqrt(distanceSquared);
+		float diff = max(dot(norm, lightDir), 0.0);
+		float spec = pow(max(dot(norm, normalize(lightDir + viewDir)), 0.0), u_shininess);
+		result += texelFetch(u_lightGridLights, 2 * light + 1).rgb * attenuation * (diff * albedoSpecular.rgb + spec * albedoSpecular.a);
+	}
+	o_color = vec4(result, 1.0);
+}
@@ -0,0 +1,52 @@
+#version 330 core
+out vec4 o_color;
+
+flat in vec4 v_lightPositionRadius;
+flat in vec3 v_lightColor;
+
+uniform sampler2D u_gbufferAlbedo;
+uniform sampler2D u_gbufferNormal;
+uniform sampler2D u_gbufferDepth;
+uniform vec4 u_projectionParams;
+uniform vec2 u_inverseScreenSize;
+uniform float u_shininess;
+
+vec3 DecodeNormal(vec2 encoded)
+{
+	vec2 f = encoded * 2.0 - 1.0;
+	vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+	float t = clamp(-n.z, 0.0, 1.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
+
+vec3 ViewPosition(vec2 uv, float depth)
+{
+	vec3 ndc = vec3(uv, depth) * 2.0 - 1.0;
+	float z = -u_projectionParams.w / (ndc.z + u_projectionParams.z);
+	return vec3(ndc.xy * u_projectionParams.xy * -z, z);
+}
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec3 position = ViewPosition(gl_FragCoord.xy * u_inverseScreenSize, texelFetch(u_gbufferDepth, pixel, 0).r);
+	vec3 toLight = v_lightPositionRadius.xyz - position;
+	float distanceSquared = dot(toLight, toLight);
+	float ratio = distanceSquared / (v_lightPositionRadius.w * v_lightPositionRadius.w);
+	if (ratio >= 1.0) {
+		discard;
+	}
+
+	vec4 albedoSpecular = texelFetch(u_gbufferAlbedo, pixel, 0);
+	vec3 norm = DecodeNormal(texelFetch(u_gbufferNormal, pixel, 0).xy);
+	vec3 lightDir = toLight * inversesqrt(distanceSquared);
+	vec3 viewDir = normalize(-position);
+
+	// same falloff as 14-clustered.fs
+	float window = 1.0 - ratio * ratio;
+	float attenuation = window * window / (distanceSquared + 1.0);
+	float diff = max(dot(norm, lightDir), 0.0);
+	float spec = pow(max(dot(norm, normalize(lightDir + viewDir)), 0.0), u_shininess);
+	o_color = vec4(v_lightColor * attenuation * (diff * albedoSpecular.rgb + spec * albedoSpecular.a), 1.0);
+}
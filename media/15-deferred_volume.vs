@@ -0,0 +1,18 @@
+#version 330 core
+layout (location = 0) in vec3 a_position;
+layout (location = 1) in vec4 a_lightPositionRadius;	// view space
+layout (location = 2) in vec4 a_lightColor;
+
+flat out vec4 v_lightPositionRadius;
+flat out vec3 v_lightColor;
+
+uniform mat4 u_projection;
+uniform float u_volumeScale;
+
+void main()
+{
+	v_lightPositionRadius = a_lightPositionRadius;
+	v_lightColor = a_lightColor.rgb;
+	vec3 viewPosition = a_lightPositionRadius.xyz + a_position * a_lightPositionRadius.w * u_volumeScale;
+	gl_Position = u_projection * vec4(viewPosition, 1.0);
+}
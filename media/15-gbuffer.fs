@@ -0,0 +1,31 @@
+#version 330 core
+struct Material {
+	sampler2D diffuse;
+	sampler2D specular;
+};
+
+layout (location = 0) out vec4 o_albedoSpecular;
+layout (location = 1) out vec2 o_normal;
+
+in vec2 v_texcoord;
+in vec3 v_viewPosition;
+in vec3 v_normal;
+
+uniform Material u_material;
+
+// Octahedral mapping: the unit sphere is projected on the octahedron |x| + |y| + |z| = 1, whose lower half is
+// folded over the upper one, then stored in [0, 1].
+vec2 EncodeNormal(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	vec2 folded = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return (n.z >= 0.0 ? n.xy : folded) * 0.5 + 0.5;
+}
+
+void main()
+{
+	vec3 albedo = vec3(texture(u_material.diffuse, v_texcoord));
+	float specular = dot(vec3(texture(u_material.specular, v_texcoord)), vec3(0.299, 0.587, 0.114));
+	o_albedoSpecular = vec4(albedo, specular);
+	o_normal = EncodeNormal(normalize(v_normal));
+}
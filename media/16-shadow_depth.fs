@@ -0,0 +1,6 @@
+#version 330 core
+
+// depth only, the shadow map target has no color attachment
+void main()
+{
+}
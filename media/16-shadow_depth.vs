@@ -0,0 +1,10 @@
+#version 330 core
+layout (location = 0) in vec3 a_position;
+layout (location = 3) in mat4 a_model;
+
+uniform mat4 u_viewProjection;
+
+void main()
+{
+	gl_Position = u_viewProjection * a_model * vec4(a_position, 1.0);
+}
@@ -0,0 +1,75 @@
+#version 330 core
+struct Material {
+	sampler2D diffuse;
+	sampler2D specular;
+	float shininess;
+};
+
+out vec4 o_color;
+
+in vec2 v_texcoord;
+in vec3 v_viewPosition;
+in vec3 v_normal;
+
+uniform Material u_material;
+uniform vec3 u_ambient;
+uniform vec3 u_sunDirection;	// view space, towards the sun
+uniform vec3 u_sunColor;
+uniform int u_showCascades;
+
+// filled by CascadedShadows_Bind
+uniform sampler2DShadow u_shadowMap;		// 2 x 2 atlas, one cascade per tile
+uniform mat4 u_shadowMatrices[4];			// view space to the [0, 1] coordinates and depth of each cascade
+uniform int u_shadowCascadesCount;
+uniform float u_shadowTexelSize;			// in atlas coordinates
+
+const vec3 cCascadeColors[4] = vec3[4](vec3(1.0, 0.3, 0.3), vec3(0.3, 1.0, 0.3), vec3(0.3, 0.3, 1.0), vec3(1.0, 1.0, 0.3));
+
+// First cascade holding the position with room for the filter footprint, -1 past the last one.
+int SelectCascade(vec3 viewPosition, out vec3 coords)
+{
+	float border = 2.0 * u_shadowTexelSize * 2.0;	// filter radius in cascade coordinates, tiles are half the atlas
+	for (int i = 0; i < u_shadowCascadesCount; i++) {
+		coords = vec3(u_shadowMatrices[i] * vec4(viewPosition, 1.0));
+		if (all(greaterThanEqual(coords, vec3(border, border, 0.0))) && all(lessThanEqual(coords, vec3(1.0 - border, 1.0 - border, 1.0)))) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// 3 x 3 bilinear comparisons, 4 x 4 texels.
+float Shadow(int cascade, vec3 coords)
+{
+	vec2 tile = vec2(float(cascade % 2), float(cascade / 2)) * 0.5;
+	vec2 uv = coords.xy * 0.5 + tile;
+	float lit = 0.0;
+	for (int y = -1; y <= 1; y++) {
+		for (int x = -1; x <= 1; x++) {
+			lit += texture(u_shadowMap, vec3(uv + vec2(x, y) * u_shadowTexelSize, coords.z));
+		}
+	}
+	return lit / 9.0;
+}
+
+void main()
+{
+	vec3 norm = normalize(v_normal);
+	vec3 viewDir = normalize(-v_viewPosition);
+	vec3 albedo = vec3(texture(u_material.diffuse, v_texcoord));
+	vec3 specularColor = vec3(texture(u_material.specular, v_texcoord));
+
+	vec3 coords;
+	int cascade = SelectCascade(v_viewPosition, coords);
+	float lit = cascade >= 0 ? Shadow(cascade, coords) : 1.0;
+
+	float diff = max(dot(norm, u_sunDirection), 0.0);
+	vec3 halfway = normalize(u_sunDirection + viewDir);
+	float spec = pow(max(dot(norm, halfway), 0.0), u_material.shininess);
+	vec3 result = albedo * u_ambient + lit * u_sunColor * (diff * albedo + spec * specularColor);
+
+	if (u_showCascades != 0 && cascade >= 0) {
+		result *= cCascadeColors[cascade];
+	}
+	o_color = vec4(result, 1.0);
+}
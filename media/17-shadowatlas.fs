@@ -0,0 +1,107 @@
+#version 330 core
+struct Material {
+	sampler2D diffuse;
+	sampler2D specular;
+	float shininess;
+};
+
+out vec4 o_color;
+
+in vec2 v_texcoord;
+in vec3 v_viewPosition;
+in vec3 v_normal;
+
+uniform Material u_material;
+uniform vec3 u_ambient;
+uniform samplerBuffer u_lights;				// 3 texels per light: position and radius, color and type, spot direction and cone cosine
+uniform int u_lightsCount;
+uniform int u_showShadows;
+
+// filled by ShadowAtlas_Bind
+uniform sampler2DShadow u_shadowAtlas;
+uniform samplerBuffer u_shadowAtlasLights;	// 5 texels per light, see ShadowAtlas.cpp
+uniform float u_shadowAtlasTexelSize;
+uniform mat4 u_shadowAtlasInverseView;
+
+// axes of the cube faces +X, -X, +Y, -Y, +Z, -Z as rendered by ShadowAtlas_Update
+const vec3 cFaceX[6] = vec3[6](vec3(0, 0, 1), vec3(0, 0, -1), vec3(1, 0, 0), vec3(-1, 0, 0), vec3(-1, 0, 0), vec3(1, 0, 0));
+const vec3 cFaceY[6] = vec3[6](vec3(0, 1, 0), vec3(0, 1, 0), vec3(0, 0, 1), vec3(0, 0, 1), vec3(0, 1, 0), vec3(0, 1, 0));
+const vec3 cFaceZ[6] = vec3[6](vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1));
+
+// One bilinear comparison in the tile of the light, 1 when the light has no shadow yet.
+float Shadow(int light, vec3 worldPosition)
+{
+	vec4 tile = texelFetch(u_shadowAtlasLights, 5 * light);
+	if (tile.w == 0.0) {
+		return 1.0;
+	}
+	// keeps the filter footprint inside the face
+	float border = u_shadowAtlasTexelSize / tile.z;
+	vec2 uv;
+	float depth;
+	vec2 faceOffset = vec2(0.0);
+	if (tile.w == 2.0) {
+		vec3 toPosition = worldPosition - texelFetch(u_shadowAtlasLights, 5 * light + 1).xyz;
+		vec3 axis = abs(toPosition);
+		int face = axis.x >= axis.y && axis.x >= axis.z ? (toPosition.x > 0.0 ? 0 : 1) : (axis.y >= axis.z ? (toPosition.y > 0.0 ? 2 : 3) : (toPosition.z > 0.0 ? 4 : 5));
+		float distance = dot(toPosition, cFaceZ[face]);
+		vec2 depthParams = texelFetch(u_shadowAtlasLights, 5 * light + 2).xy;
+		uv = vec2(dot(toPosition, cFaceX[face]), dot(toPosition, cFaceY[face])) / distance * 0.5 + 0.5;
+		depth = depthParams.x + depthParams.y / distance;
+		faceOffset = vec2(float(face % 3), float(face / 3));
+	} else {
+		vec4 position = vec4(worldPosition, 1.0);
+		vec4 local = vec4(dot(texelFetch(u_shadowAtlasLights, 5 * light + 1), position), dot(texelFetch(u_shadowAtlasLights, 5 * light + 2), position),
+			dot(texelFetch(u_shadowAtlasLights, 5 * light + 3), position), dot(texelFetch(u_shadowAtlasLights, 5 * light + 4), position));
+		uv = local.xy / local.w;
+		depth = local.z / local.w;
+	}
+	uv = clamp(uv, vec2(border), vec2(1.0 - border));
+	return texture(u_shadowAtlas, vec3(tile.xy + (faceOffset + uv) * tile.z, depth));
+}
+
+void main()
+{
+	vec3 worldPosition = vec3(u_shadowAtlasInverseView * vec4(v_viewPosition, 1.0));
+	vec3 norm = normalize(mat3(u_shadowAtlasInverseView) * v_normal);
+	vec3 viewDir = normalize(u_shadowAtlasInverseView[3].xyz - worldPosition);
+	vec3 albedo = vec3(texture(u_material.diffuse, v_texcoord));
+	vec3 specularColor = vec3(texture(u_material.specular, v_texcoord));
+	// a small push along the normal, on top of the slope scaled offset of the depth pass
+	vec3 shadowPosition = worldPosition + norm * 0.03;
+
+	vec3 result = albedo * u_ambient;
+	float shadowed = 0.0;
+	for (int i = 0; i < u_lightsCount; i++) {
+		vec4 positionRadius = texelFetch(u_lights, 3 * i);
+		vec3 toLight = positionRadius.xyz - worldPosition;
+		float distanceSquared = dot(toLight, toLight);
+		if (distanceSquared >= positionRadius.w * positionRadius.w) {
+			continue;
+		}
+		vec4 colorType = texelFetch(u_lights, 3 * i + 1);
+		vec3 lightDir = toLight * inversesqrt(distanceSquared);
+		float ratio = distanceSquared / (positionRadius.w * positionRadius.w);
+		float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+		float attenuation = window * window / (distanceSquared + 1.0);
+		if (colorType.w > 0.5) {
+			vec4 spot = texelFetch(u_lights, 3 * i + 2);
+			attenuation *= smoothstep(spot.w, spot.w + 0.05, dot(-lightDir, spot.xyz));
+		}
+		if (attenuation <= 0.0) {
+			continue;
+		}
+		float lit = Shadow(i, shadowPosition);
+		shadowed += 1.0 - lit;
+
+		float diff = max(dot(norm, lightDir), 0.0);
+		vec3 halfway = normalize(lightDir + viewDir);
+		float spec = pow(max(dot(norm, halfway), 0.0), u_material.shininess);
+		result += lit * colorType.rgb * attenuation * (diff * albedo + spec * specularColor);
+	}
+
+	if (u_showShadows != 0) {
+		result = mix(result, vec3(1.0, 0.2, 0.2), 0.5 * clamp(shadowed, 0.0, 1.0));
+	}
+	o_color = vec4(result, 1.0);
+}
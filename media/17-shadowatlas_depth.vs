@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 a_position;
+layout (location = 3) in mat4 a_model;
+
+// filled by ShadowAtlas_Update: the projection of every face, and the scale and offset placing its clip space in
+// the atlas one
+uniform mat4 u_faceMatrices[6];
+uniform vec4 u_faceRects[6];
+uniform int u_facesCount;
+
+out float gl_ClipDistance[4];
+
+void main()
+{
+	// point light batches draw every instance once per face
+	int face = gl_InstanceID % u_facesCount;
+	vec4 clip = u_faceMatrices[face] * a_model * vec4(a_position, 1.0);
+
+	// the faces of a point light share the scissor rectangle, the clip planes keep each one inside its own tile
+	gl_ClipDistance[0] = clip.w + clip.x;
+	gl_ClipDistance[1] = clip.w - clip.x;
+	gl_ClipDistance[2] = clip.w + clip.y;
+	gl_ClipDistance[3] = clip.w - clip.y;
+	gl_Position = vec4(clip.xy * u_faceRects[face].xy + u_faceRects[face].zw * clip.w, clip.zw);
+}
@@ -0,0 +1,35 @@
+#version 330 core
+out vec4 o_color;
+
+uniform sampler2D u_scene;			// bilinear, only the u_renderSize corner holds the frame
+uniform vec2 u_outputSize;
+uniform vec2 u_renderSize;
+uniform vec2 u_inverseTargetSize;
+uniform float u_sharpness;			// 0 for plain bilinear
+
+vec3 SampleScene(vec2 pixel)
+{
+	// stay half a texel inside the rendered corner, the texels around it are left from larger frames
+	pixel = clamp(pixel, vec2(0.5), u_renderSize - 0.5);
+	return texture(u_scene, pixel * u_inverseTargetSize).rgb;
+}
+
+void main()
+{
+	vec2 pixel = gl_FragCoord.xy * (u_renderSize / u_outputSize);
+	vec3 color = SampleScene(pixel);
+	if (u_sharpness > 0.0) {
+		// contrast adaptive sharpening: the cross neighbors one render texel away are subtracted with a weight that
+		// falls off where the local contrast is already high, which keeps edges free of halos
+		vec3 north = SampleScene(pixel + vec2(0.0, 1.0));
+		vec3 south = SampleScene(pixel - vec2(0.0, 1.0));
+		vec3 east = SampleScene(pixel + vec2(1.0, 0.0));
+		vec3 west = SampleScene(pixel - vec2(1.0, 0.0));
+		vec3 minimum = min(color, min(min(north, south), min(east, west)));
+		vec3 maximum = max(color, max(max(north, south), max(east, west)));
+		vec3 amount = sqrt(clamp(min(minimum, 1.0 - maximum) / max(maximum, vec3(1e-4)), 0.0, 1.0));
+		vec3 weight = -amount / mix(8.0, 5.0, u_sharpness);
+		color = clamp((color + (north + south + east + west) * weight) / (1.0 + 4.0 * weight), 0.0, 1.0);
+	}
+	o_color = vec4(color, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+out vec4 o_color;
+
+uniform sampler2D u_source;			// bilinear, same size as the target
+uniform vec2 u_inverseOutputSize;
+uniform vec2 u_direction;			// one texel along the blur axis
+
+// 9 taps gaussian in 5 bilinear fetches
+const float cOffsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float cWeights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main()
+{
+	vec2 uv = gl_FragCoord.xy * u_inverseOutputSize;
+	vec3 color = texture(u_source, uv).rgb * cWeights[0];
+	for (int i = 1; i < 3; i++) {
+		vec2 offset = u_direction * cOffsets[i];
+		color += (texture(u_source, uv + offset).rgb + texture(u_source, uv - offset).rgb) * cWeights[i];
+	}
+	o_color = vec4(color, 1.0);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+out vec4 o_color;
+
+uniform sampler2D u_source;			// bilinear, twice the size of the target so each fetch averages 2x2 texels
+uniform vec2 u_inverseOutputSize;
+uniform float u_threshold;
+
+void main()
+{
+	vec3 color = texture(u_source, gl_FragCoord.xy * u_inverseOutputSize).rgb;
+	float brightness = max(color.r, max(color.g, color.b));
+	o_color = vec4(color * (max(brightness - u_threshold, 0.0) / max(brightness, 1e-4)), 1.0);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+out vec4 o_color;
+
+uniform sampler2D u_scene;
+uniform sampler2D u_bloom;			// bilinear, half the size of the output
+uniform sampler2D u_edges;
+uniform vec2 u_inverseOutputSize;
+uniform int u_useBloom;
+uniform int u_useEdges;
+uniform float u_bloomIntensity;
+uniform float u_exposure;
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	vec3 color = texelFetch(u_scene, pixel, 0).rgb;
+	if (u_useBloom != 0) {
+		color += texture(u_bloom, gl_FragCoord.xy * u_inverseOutputSize).rgb * u_bloomIntensity;
+	}
+	color = vec3(1.0) - exp(-color * u_exposure);
+	if (u_useEdges != 0) {
+		color *= 1.0 - texelFetch(u_edges, pixel, 0).r;
+	}
+	o_color = vec4(color, 1.0);
+}
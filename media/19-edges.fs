@@ -0,0 +1,23 @@
+#version 330 core
+out vec4 o_color;
+
+uniform sampler2D u_depth;
+uniform vec2 u_depthRange;			// near and far planes
+
+float LinearDepth(ivec2 pixel)
+{
+	float depth = texelFetch(u_depth, pixel, 0).r * 2.0 - 1.0;
+	return 2.0 * u_depthRange.x * u_depthRange.y / (u_depthRange.y + u_depthRange.x - depth * (u_depthRange.y - u_depthRange.x));
+}
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	ivec2 last = textureSize(u_depth, 0) - 1;
+	float center = LinearDepth(pixel);
+	float neighbors = LinearDepth(min(pixel + ivec2(1, 0), last)) + LinearDepth(max(pixel - ivec2(1, 0), ivec2(0))) +
+		LinearDepth(min(pixel + ivec2(0, 1), last)) + LinearDepth(max(pixel - ivec2(0, 1), ivec2(0)));
+	// second derivative of the depth relative to the depth, flat and sloped surfaces stay at 0
+	float edge = clamp(abs(neighbors - 4.0 * center) / center * 4.0, 0.0, 1.0);
+	o_color = vec4(edge, 0.0, 0.0, 1.0);
+}
@@ -0,0 +1,61 @@
+#version 430 core
+layout (local_size_x = 64) in;
+
+struct Meshlet {
+	vec4 sphere;
+	vec4 cone;
+	uint firstIndex;
+	uint indexCount;
+	uint padding0;
+	uint padding1;
+};
+
+struct DrawCommand {
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer Meshlets {
+	Meshlet meshlets[];
+};
+
+layout (std430, binding = 1) writeonly buffer Commands {
+	DrawCommand commands[];
+};
+
+uniform mat4 u_model;
+uniform float u_scale;
+uniform vec3 u_cameraPosition;
+uniform vec4 u_planes[6];
+uniform int u_meshletCount;
+
+void main()
+{
+	uint index = gl_GlobalInvocationID.x;
+	if (index >= uint(u_meshletCount)) {
+		return;
+	}
+
+	Meshlet meshlet = meshlets[index];
+	vec3 center = vec3(u_model * vec4(meshlet.sphere.xyz, 1.0));
+	float radius = meshlet.sphere.w * u_scale;
+
+	bool visible = true;
+	for (int i = 0; i < 6; i++) {
+		visible = visible && (dot(u_planes[i].xyz, center) + u_planes[i].w >= -radius);
+	}
+	if (visible && meshlet.cone.w < 1.0) {
+		vec3 axis = mat3(u_model) * meshlet.cone.xyz / u_scale;
+		vec3 view = center - u_cameraPosition;
+		visible = dot(view, axis) < meshlet.cone.w * length(view) + radius;
+	}
+
+	commands[index].count = visible ? meshlet.indexCount : 0u;
+	commands[index].instanceCount = 1u;
+	commands[index].firstIndex = meshlet.firstIndex;
+	commands[index].baseVertex = 0;
+	commands[index].baseInstance = 0u;
+}
@@ -184,7 +184,7 @@ int main() {
 	gCamera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
 
 	glm::vec3 lightPosition(1.2f, 1.0f, 2.0f);
-	float lastFrameTime = 0.0f;
+	double lastFrameTime = 0.0;
 	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
 
 	glEnable(GL_DEPTH_TEST);
@@ -195,14 +195,14 @@ int main() {
 	glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, 0.1f, 100.0f);
 
 	while (!glfwWindowShouldClose(window)) {
-		float currentFrameTime = float(glfwGetTime());
-		float deltaTime = currentFrameTime - lastFrameTime;
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
 		lastFrameTime = currentFrameTime;
 
 		glm::vec3 lightColor;
-		lightColor.x = sin(currentFrameTime * 2.0f);
-		lightColor.y = sin(currentFrameTime * 0.7f);
-		lightColor.z = sin(currentFrameTime * 1.3f);
+		lightColor.x = float(sin(currentFrameTime * 2.0));
+		lightColor.y = float(sin(currentFrameTime * 0.7));
+		lightColor.z = float(sin(currentFrameTime * 1.3));
 		glm::vec3 diffuseColor = lightColor * glm::vec3(0.5f);
 		glm::vec3 ambientColor = diffuseColor * glm::vec3(0.2f);
 
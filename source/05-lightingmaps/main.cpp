@@ -205,7 +205,7 @@ int main() {
 	gCamera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
 
 	glm::vec3 lightPosition(1.2f, 1.0f, 2.0f);
-	float lastFrameTime = 0.0f;
+	double lastFrameTime = 0.0;
 	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
 
 	glEnable(GL_DEPTH_TEST);
@@ -216,14 +216,14 @@ int main() {
 	glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, 0.1f, 100.0f);
 
 	while (!glfwWindowShouldClose(window)) {
-		float currentFrameTime = float(glfwGetTime());
-		float deltaTime = currentFrameTime - lastFrameTime;
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
 		lastFrameTime = currentFrameTime;
 
 		glm::mat4 view = gCamera.GetViewMatrix();
 		
-		lightPosition.x = 1.0f + sin(currentFrameTime) * 2.0f;
-		lightPosition.y = sin(currentFrameTime / 2.0f) * 1.0f;
+		lightPosition.x = 1.0f + float(sin(currentFrameTime)) * 2.0f;
+		lightPosition.y = float(sin(currentFrameTime / 2.0)) * 1.0f;
 
 		processInput(window, deltaTime);
 
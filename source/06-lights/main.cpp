@@ -4,6 +4,8 @@
 #include "Texture.h"
 #include "StringUtils.h"
 #include "Camera.h"
+#include "Culling.h"
+#include "DepthPrepass.h"
 #include "InputManager.h"
 
 #include "glm/gtc/matrix_transform.hpp"
@@ -18,6 +20,9 @@ bool gFirstMouse = true;
 bool gUseDirectional = true;
 
 Camera gCamera;
+DepthPrepass gDepthPrepass;
+
+const char* cPrepassModeNames[DepthPrepassMode::Count] = { "off", "on", "auto" };
 
 }
 
@@ -77,6 +82,12 @@ void UsePointLight() {
 	gUseDirectional = false;
 }
 
+void CycleDepthPrepassMode() {
+	const DepthPrepassMode::Enum mode = DepthPrepassMode::Enum((gDepthPrepass.mParams.mMode + 1) % DepthPrepassMode::Count);
+	DepthPrepass_SetMode(gDepthPrepass, mode);
+	Log(tinyngine::Logger::Information, "DEPTH PRE-PASS: %s", cPrepassModeNames[mode]);
+}
+
 int main() {
 	const uint32_t cScreenWidth = 800;
 	const uint32_t cScreenHeight = 600;
@@ -106,6 +117,7 @@ int main() {
 	Input_Initialize(window);
 	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_1, UseDirectionalLight);
 	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_2, UsePointLight);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_P, CycleDepthPrepassMode);
 
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
 		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
@@ -121,6 +133,14 @@ int main() {
 		return 1;
 	}
 
+	StringUtils::ReadFileToString("06-lights_depth.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("06-lights_depth.fs", params.mFragmentShaderData);
+	ShaderProgramHandle depthProgramHandle = ShaderProgram_Create(params);
+	if (!depthProgramHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
 	StringUtils::ReadFileToString("dbg_light.vs", params.mVertexShaderData);
 	StringUtils::ReadFileToString("dbg_light.fs", params.mFragmentShaderData);
 	ShaderProgramHandle lightProgramHandle = ShaderProgram_Create(params);
@@ -198,6 +218,15 @@ int main() {
 		glm::vec3(-1.3f,  1.0f, -1.5f)
 	};
 
+	// bounding spheres of the rotated unit cubes, centered on the cube positions
+	CullingSpheres cubeSpheres;
+	Culling_Resize(cubeSpheres, 10);
+	for (uint32_t i = 0; i < 10; i++) {
+		Culling_SetSphere(cubeSpheres, i, cubePositions[i], 0.87f);
+	}
+	uint32_t visibleCubes[10];
+	glm::mat4 cubeModels[10];
+
 	unsigned int VBO;
 	glGenBuffers(1, &VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -228,19 +257,23 @@ int main() {
 
 	glm::vec4 lightPosition(1.2f, 1.0f, 2.0f, 1.0f);
 	glm::vec4 lightDirection(-0.2f, -1.0f, -0.3f, 0.0);
-	float lastFrameTime = 0.0f;
+	double lastFrameTime = 0.0;
 	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
 
 	glEnable(GL_DEPTH_TEST);
 
+	// the depth pre-pass pays off when the cubes overlap on screen, e.g. looking along the column they form
+	DepthPrepass_Initialize(gDepthPrepass, DepthPrepassParams());
+	double lastReportTime = 0.0;
+
 	glm::mat4 model;
 	glm::mat4 modelView;
 	glm::mat4 modelViewProj;
 	glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, 0.1f, 100.0f);
 
 	while (!glfwWindowShouldClose(window)) {
-		float currentFrameTime = float(glfwGetTime());
-		float deltaTime = currentFrameTime - lastFrameTime;
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
 		lastFrameTime = currentFrameTime;
 
 		glm::mat4 view = gCamera.GetViewMatrix();
@@ -250,9 +283,33 @@ int main() {
 		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+		Frustum frustum = Frustum_FromMatrix(projection * view);
+		uint32_t visibleCount = Culling_TestSpheres(frustum, cubeSpheres, 0, 10, visibleCubes);
+		for (uint32_t v = 0; v < visibleCount; v++) {
+			uint32_t i = visibleCubes[v];
+			float angle = 20.0f * i;
+			model = glm::mat4(1.0f);
+			model = glm::translate(model, cubePositions[i]);
+			cubeModels[v] = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+		}
+
+		glBindVertexArray(cubeVAO);
+		if (DepthPrepass_BeginFrame(gDepthPrepass)) {
+			// same vertices and transforms as the shading pass below
+			DepthPrepass_BeginDepth(gDepthPrepass);
+			ShaderProgram_Use(depthProgramHandle);
+			for (uint32_t v = 0; v < visibleCount; v++) {
+				modelViewProj = projection * view * cubeModels[v];
+				ShaderProgram_SetMat4(depthProgramHandle, "u_modelViewProj", modelViewProj);
+				glDrawArrays(GL_TRIANGLES, 0, 36);
+			}
+			DepthPrepass_EndDepth(gDepthPrepass);
+		}
+
 		Texture_Bind(textureHandle1, 0);
 		Texture_Bind(textureHandle2, 1);
 
+		DepthPrepass_BeginShading(gDepthPrepass);
 		ShaderProgram_Use(programHandle);
 		ShaderProgram_SetInt(programHandle, "u_material.diffuse", 0);
 		ShaderProgram_SetInt(programHandle, "u_material.specular", 1);
@@ -268,12 +325,8 @@ int main() {
 		
 		ShaderProgram_SetVec3(programHandle, "u_viewPosition", gCamera.GetPosition());
 
-		glBindVertexArray(cubeVAO);
-		for (uint32_t i = 0; i < 10; i++) {
-			float angle = 20.0f * i;
-			model = glm::mat4(1.0f);
-			model = glm::translate(model, cubePositions[i]);
-			model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+		for (uint32_t v = 0; v < visibleCount; v++) {
+			model = cubeModels[v];
 			modelView = view * model;
 			modelViewProj = projection * view * model;
 
@@ -282,6 +335,7 @@ int main() {
 			ShaderProgram_SetMat4(programHandle, "u_modelViewProj", modelViewProj);
 			glDrawArrays(GL_TRIANGLES, 0, 36);
 		}
+		DepthPrepass_EndShading(gDepthPrepass);
 
 		model = glm::mat4(1.0f);
 		model = glm::translate(model, glm::vec3(lightPosition.x, lightPosition.y, lightPosition.z));
@@ -295,14 +349,26 @@ int main() {
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
+
+		if (currentFrameTime - lastReportTime >= 2.0) {
+			const DepthPrepassStats& prepassStats = DepthPrepass_GetStats(gDepthPrepass);
+			Log(tinyngine::Logger::Information, "depth pre-pass %s (%s), overdraw %.2f, gpu: pre-pass %.3f ms + shading %.3f ms, shading alone %.3f ms, %u switches",
+				cPrepassModeNames[gDepthPrepass.mParams.mMode], prepassStats.mRunning ? "running" : "skipped", prepassStats.mOverdraw,
+				prepassStats.mDepthMilliseconds, prepassStats.mPrepassMilliseconds, prepassStats.mForwardMilliseconds, prepassStats.mSwitches);
+			DepthPrepass_ResetStats(gDepthPrepass);
+			lastReportTime = currentFrameTime;
+		}
 	}
 
+	DepthPrepass_Destroy(gDepthPrepass);
+
 	glDeleteVertexArrays(1, &lightVAO);
 	glDeleteVertexArrays(1, &cubeVAO);
 	glDeleteBuffers(1, &VBO);
 	Texture_Destroy(textureHandle2);
 	Texture_Destroy(textureHandle1);
 	ShaderProgram_Destroy(lightProgramHandle);
+	ShaderProgram_Destroy(depthProgramHandle);
 	ShaderProgram_Destroy(programHandle);
 
 	glfwTerminate();
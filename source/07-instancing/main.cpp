@@ -0,0 +1,472 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "Instancing.h"
+#include "PipelineState.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+enum class RenderMode : uint8_t {
+	PerDraw = 0,
+	InstancedMatrix,
+	InstancedTRS,
+	Count
+};
+
+const char* cRenderModeNames[] = {
+	"PER-DRAW",
+	"INSTANCED MATRIX",
+	"INSTANCED TRS",
+};
+
+constexpr uint32_t cDefaultCubesCount = 1000;
+constexpr uint32_t cStressCubesCount = 100000;
+constexpr uint32_t cBenchmarkWarmupFrames = 30;
+constexpr uint32_t cBenchmarkFrames = 300;
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+bool gStress = false;
+bool gBenchmarkRequested = false;
+RenderMode gRenderMode = RenderMode::InstancedMatrix;
+
+Camera gCamera;
+
+struct FrameStats {
+	double mAccumulated = 0.0;
+	uint32_t mFrames = 0;
+	double mLastReport = 0.0;
+};
+
+// Runs every render mode for a fixed number of frames and reports the average frame time of each one.
+struct Benchmark {
+	bool mRunning = false;
+	uint32_t mMode = 0;
+	uint32_t mFrame = 0;
+	double mAccumulated = 0.0;
+	double mResults[uint32_t(RenderMode::Count)];
+};
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void SelectRenderMode(RenderMode mode) {
+	Log(tinyngine::Logger::Information, "SELECT RENDER MODE: %s", cRenderModeNames[uint32_t(mode)]);
+	gRenderMode = mode;
+}
+
+void ToggleStress() {
+	gStress = !gStress;
+	Log(tinyngine::Logger::Information, "STRESS MODE: %s", gStress ? "ON" : "OFF");
+}
+
+void RequestBenchmark() {
+	gBenchmarkRequested = true;
+}
+
+void BuildCubeTransforms(uint32_t count, std::vector<glm::mat4>& transforms) {
+	// cubes laid out on a grid in front of the camera, rotated like the 06-lights containers
+	uint32_t side = 1;
+	while (side * side * side < count) {
+		side++;
+	}
+	const float spacing = 1.6f;
+	const float offset = float(side - 1) * spacing * 0.5f;
+
+	transforms.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t x = i % side;
+		uint32_t y = (i / side) % side;
+		uint32_t z = i / (side * side);
+		glm::vec3 position(float(x) * spacing - offset, float(y) * spacing - offset, -float(z) * spacing - 2.0f);
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+		transforms[i] = glm::rotate(model, glm::radians(20.0f * float(i % 18)), glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f)));
+	}
+}
+
+void SetupLighting(const ShaderProgramHandle& programHandle, const glm::vec4& lightPosition) {
+	ShaderProgram_Use(programHandle);
+	ShaderProgram_SetInt(programHandle, "u_material.diffuse", 0);
+	ShaderProgram_SetInt(programHandle, "u_material.specular", 1);
+	ShaderProgram_SetFloat(programHandle, "u_material.shininess", 32.0f);
+
+	ShaderProgram_SetVec4(programHandle, "u_light.direction", lightPosition);
+	ShaderProgram_SetVec3(programHandle, "u_light.ambient", 0.05f, 0.05f, 0.05f);
+	ShaderProgram_SetVec3(programHandle, "u_light.diffuse", 1.0f, 1.0f, 0.8f);
+	ShaderProgram_SetVec3(programHandle, "u_light.specular", 1.0f, 1.0f, 1.0f);
+	ShaderProgram_SetFloat(programHandle, "u_light.constant", 1.0f);
+	ShaderProgram_SetFloat(programHandle, "u_light.linear", 0.009f);
+	ShaderProgram_SetFloat(programHandle, "u_light.quadratic", 0.0032f);
+
+	ShaderProgram_SetVec3(programHandle, "u_viewPosition", gCamera.GetPosition());
+}
+
+int main(int argc, char** argv) {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--stress") == 0) {
+			gStress = true;
+			gBenchmarkRequested = true;
+		}
+	}
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// frame times are only meaningful without vsync
+	glfwSwapInterval(0);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_1, []() { SelectRenderMode(RenderMode::PerDraw); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_2, []() { SelectRenderMode(RenderMode::InstancedMatrix); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_3, []() { SelectRenderMode(RenderMode::InstancedTRS); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_4, ToggleStress);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_B, RequestBenchmark);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString("06-lights.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("06-lights.fs", params.mFragmentShaderData);
+	ShaderProgramHandle programHandle = ShaderProgram_Create(params);
+	if (!programHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	StringUtils::ReadFileToString("06-lights_instanced.vs", params.mVertexShaderData);
+	ShaderProgramHandle instancedProgramHandle = ShaderProgram_Create(params);
+	if (!instancedProgramHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	StringUtils::ReadFileToString("06-lights_instanced_trs.vs", params.mVertexShaderData);
+	ShaderProgramHandle instancedTRSProgramHandle = ShaderProgram_Create(params);
+	if (!instancedTRSProgramHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	StringUtils::ReadFileToString("dbg_light.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("dbg_light.fs", params.mFragmentShaderData);
+	ShaderProgramHandle lightProgramHandle = ShaderProgram_Create(params);
+	if (!lightProgramHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices, sizeof(vertices));
+
+	MeshParams cubeParams;
+	cubeParams.mVertexBuffers[0] = vertexBuffer;
+	cubeParams.mVertexBuffersCount = 1;
+	cubeParams.mAttributesCount = 3;
+	cubeParams.mAttributes[0].mLocation = 0;
+	cubeParams.mAttributes[0].mComponents = 3;
+	cubeParams.mAttributes[0].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[1].mLocation = 1;
+	cubeParams.mAttributes[1].mComponents = 3;
+	cubeParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	cubeParams.mAttributes[1].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[2].mLocation = 2;
+	cubeParams.mAttributes[2].mComponents = 2;
+	cubeParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	cubeParams.mAttributes[2].mStride = 8 * sizeof(float);
+	cubeParams.mVertexCount = 36;
+	MeshHandle cubeMesh = Mesh_Create(cubeParams);
+
+	MeshParams lightParams = cubeParams;
+	lightParams.mAttributesCount = 1;
+	MeshHandle lightMesh = Mesh_Create(lightParams);
+
+	InstanceBatchParams batchParams;
+	batchParams.mMesh = cubeParams;
+	batchParams.mMaxInstances = cStressCubesCount;
+	batchParams.mTextures[0] = textureHandle1;
+	batchParams.mTextures[1] = textureHandle2;
+	batchParams.mTexturesCount = 2;
+
+	batchParams.mFormat = InstanceFormat::Matrix;
+	batchParams.mProgram = instancedProgramHandle;
+	InstanceBatchHandle matrixBatch = Instancing_CreateBatch(batchParams);
+
+	batchParams.mFormat = InstanceFormat::TRS;
+	batchParams.mProgram = instancedTRSProgramHandle;
+	InstanceBatchHandle trsBatch = Instancing_CreateBatch(batchParams);
+
+	if (!cubeMesh.IsValid() || !lightMesh.IsValid() || !matrixBatch.IsValid() || !trsBatch.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create meshes");
+		return 1;
+	}
+
+	gCamera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+	glm::vec4 lightPosition(1.2f, 1.0f, 2.0f, 1.0f);
+	double lastFrameTime = 0.0;
+	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
+
+	PipelineState_ApplyDepth(DepthState());
+
+	glm::mat4 model;
+	glm::mat4 modelView;
+	glm::mat4 modelViewProj;
+	glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, 0.1f, 200.0f);
+
+	std::vector<glm::mat4> transforms;
+	bool stress = !gStress;
+	FrameStats stats;
+	Benchmark benchmark;
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		if (stress != gStress) {
+			stress = gStress;
+			BuildCubeTransforms(stress ? cStressCubesCount : cDefaultCubesCount, transforms);
+			stats = FrameStats();
+		}
+		if (gBenchmarkRequested && !benchmark.mRunning) {
+			gBenchmarkRequested = false;
+			benchmark = Benchmark();
+			benchmark.mRunning = true;
+			Log(tinyngine::Logger::Information, "BENCHMARK: %u cubes", uint32_t(transforms.size()));
+		}
+
+		RenderMode mode = benchmark.mRunning ? RenderMode(benchmark.mMode) : gRenderMode;
+
+		glm::mat4 view = gCamera.GetViewMatrix();
+		glm::mat4 viewProj = projection * view;
+
+		processInput(window, deltaTime);
+
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		if (mode == RenderMode::PerDraw) {
+			Texture_Bind(textureHandle1, 0);
+			Texture_Bind(textureHandle2, 1);
+			SetupLighting(programHandle, lightPosition);
+
+			for (const glm::mat4& transform : transforms) {
+				modelView = view * transform;
+				modelViewProj = viewProj * transform;
+
+				ShaderProgram_SetMat4(programHandle, "u_model", transform);
+				ShaderProgram_SetMat4(programHandle, "u_modelView", modelView);
+				ShaderProgram_SetMat4(programHandle, "u_modelViewProj", modelViewProj);
+				Mesh_Draw(cubeMesh);
+			}
+		} else {
+			const bool useTRS = (mode == RenderMode::InstancedTRS);
+			InstanceBatchHandle batch = useTRS ? trsBatch : matrixBatch;
+			ShaderProgramHandle batchProgram = useTRS ? instancedTRSProgramHandle : instancedProgramHandle;
+
+			SetupLighting(batchProgram, lightPosition);
+			ShaderProgram_SetMat4(batchProgram, "u_view", view);
+			ShaderProgram_SetMat4(batchProgram, "u_viewProj", viewProj);
+
+			Instancing_Clear(batch);
+			for (const glm::mat4& transform : transforms) {
+				Instancing_Add(batch, transform);
+			}
+			Instancing_Submit(batch);
+		}
+
+		model = glm::mat4(1.0f);
+		model = glm::translate(model, glm::vec3(lightPosition.x, lightPosition.y, lightPosition.z));
+		model = glm::scale(model, glm::vec3(0.2f));
+		modelViewProj = viewProj * model;
+		ShaderProgram_Use(lightProgramHandle);
+		ShaderProgram_SetMat4(lightProgramHandle, "u_modelViewProj", modelViewProj);
+		Mesh_Draw(lightMesh);
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		double frameTime = glfwGetTime() - currentFrameTime;
+		if (benchmark.mRunning) {
+			if (benchmark.mFrame++ >= cBenchmarkWarmupFrames) {
+				benchmark.mAccumulated += frameTime;
+			}
+			if (benchmark.mFrame == cBenchmarkWarmupFrames + cBenchmarkFrames) {
+				benchmark.mResults[benchmark.mMode] = benchmark.mAccumulated * 1000.0 / cBenchmarkFrames;
+				benchmark.mAccumulated = 0.0;
+				benchmark.mFrame = 0;
+				if (++benchmark.mMode == uint32_t(RenderMode::Count)) {
+					benchmark.mRunning = false;
+					const double perDraw = benchmark.mResults[uint32_t(RenderMode::PerDraw)];
+					for (uint32_t i = 0; i < uint32_t(RenderMode::Count); i++) {
+						Log(tinyngine::Logger::Information, "BENCHMARK %-16s %8.3f ms/frame (x%.2f vs per-draw)",
+							cRenderModeNames[i], benchmark.mResults[i], perDraw / benchmark.mResults[i]);
+					}
+				}
+			}
+		} else {
+			stats.mAccumulated += frameTime;
+			stats.mFrames++;
+			if (currentFrameTime - stats.mLastReport >= 2.0) {
+				Log(tinyngine::Logger::Information, "%s: %u cubes, %.3f ms/frame", cRenderModeNames[uint32_t(mode)],
+					uint32_t(transforms.size()), stats.mAccumulated * 1000.0 / stats.mFrames);
+				stats.mAccumulated = 0.0;
+				stats.mFrames = 0;
+				stats.mLastReport = currentFrameTime;
+			}
+		}
+	}
+
+	Instancing_DestroyBatch(trsBatch);
+	Instancing_DestroyBatch(matrixBatch);
+	Mesh_Destroy(lightMesh);
+	Mesh_Destroy(cubeMesh);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(lightProgramHandle);
+	ShaderProgram_Destroy(instancedTRSProgramHandle);
+	ShaderProgram_Destroy(instancedProgramHandle);
+	ShaderProgram_Destroy(programHandle);
+
+	glfwTerminate();
+	return 0;
+}
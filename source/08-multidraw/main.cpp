@@ -0,0 +1,377 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "DrawIndirect.h"
+#include "PipelineState.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+constexpr uint32_t cDefaultObjectsCount = 20000;
+constexpr uint32_t cMaterialsCount = 8;
+constexpr uint32_t cVertexStride = 8;
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+bool gUseMultiDraw = true;
+
+Camera gCamera;
+
+struct Object {
+	uint32_t mMesh;
+	uint32_t mMaterial;
+	glm::mat4 mModel;
+};
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void UseMultiDraw() {
+	Log(tinyngine::Logger::Information, "SELECT SUBMISSION: MULTI-DRAW INDIRECT");
+	gUseMultiDraw = true;
+}
+
+void UseDrawLoop() {
+	Log(tinyngine::Logger::Information, "SELECT SUBMISSION: DRAW LOOP");
+	gUseMultiDraw = false;
+}
+
+// Flat shaded mesh from a triangle list, texture coordinates are projected along the dominant axis of each face.
+DrawIndirectMesh AppendFlatMesh(DrawIndirectGeometry& geometry, const glm::vec3* positions, uint32_t count) {
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+	vertices.reserve(count * cVertexStride);
+	indices.reserve(count);
+	for (uint32_t i = 0; i + 2 < count; i += 3) {
+		glm::vec3 normal = glm::normalize(glm::cross(positions[i + 1] - positions[i], positions[i + 2] - positions[i]));
+		glm::vec3 axis = glm::abs(normal);
+		for (uint32_t j = 0; j < 3; j++) {
+			const glm::vec3& p = positions[i + j];
+			glm::vec2 uv = (axis.x >= axis.y && axis.x >= axis.z) ? glm::vec2(p.z, p.y) : (axis.y >= axis.z) ? glm::vec2(p.x, p.z) : glm::vec2(p.x, p.y);
+			const float vertex[cVertexStride] = { p.x, p.y, p.z, normal.x, normal.y, normal.z, uv.x + 0.5f, uv.y + 0.5f };
+			vertices.insert(vertices.end(), vertex, vertex + cVertexStride);
+			indices.push_back(i + j);
+		}
+	}
+	return DrawIndirect_AppendMesh(geometry, vertices.data(), count, indices.data(), count);
+}
+
+void BuildMeshes(DrawIndirectGeometry& geometry, std::vector<DrawIndirectMesh>& meshes) {
+	const glm::vec3 c[8] = {
+		glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.5f, -0.5f, -0.5f), glm::vec3(0.5f, 0.5f, -0.5f), glm::vec3(-0.5f, 0.5f, -0.5f),
+		glm::vec3(-0.5f, -0.5f, 0.5f), glm::vec3(0.5f, -0.5f, 0.5f), glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(-0.5f, 0.5f, 0.5f),
+	};
+	const glm::vec3 cube[] = {
+		c[0], c[2], c[1], c[0], c[3], c[2],		// back
+		c[4], c[5], c[6], c[4], c[6], c[7],		// front
+		c[0], c[4], c[7], c[0], c[7], c[3],		// left
+		c[1], c[2], c[6], c[1], c[6], c[5],		// right
+		c[0], c[1], c[5], c[0], c[5], c[4],		// bottom
+		c[3], c[7], c[6], c[3], c[6], c[2],		// top
+	};
+	const glm::vec3 apex(0.0f, 0.5f, 0.0f);
+	const glm::vec3 pyramid[] = {
+		c[0], c[1], c[5], c[0], c[5], c[4],
+		c[4], c[5], apex, c[5], c[1], apex, c[1], c[0], apex, c[0], c[4], apex,
+	};
+	const glm::vec3 o[6] = {
+		glm::vec3(0.6f, 0.0f, 0.0f), glm::vec3(-0.6f, 0.0f, 0.0f), glm::vec3(0.0f, 0.6f, 0.0f),
+		glm::vec3(0.0f, -0.6f, 0.0f), glm::vec3(0.0f, 0.0f, 0.6f), glm::vec3(0.0f, 0.0f, -0.6f),
+	};
+	const glm::vec3 octahedron[] = {
+		o[4], o[0], o[2], o[0], o[5], o[2], o[5], o[1], o[2], o[1], o[4], o[2],
+		o[0], o[4], o[3], o[5], o[0], o[3], o[1], o[5], o[3], o[4], o[1], o[3],
+	};
+
+	geometry.mVertexStride = cVertexStride;
+	meshes.push_back(AppendFlatMesh(geometry, cube, TINYNGINE_COUNTOF(cube)));
+	meshes.push_back(AppendFlatMesh(geometry, pyramid, TINYNGINE_COUNTOF(pyramid)));
+	meshes.push_back(AppendFlatMesh(geometry, octahedron, TINYNGINE_COUNTOF(octahedron)));
+}
+
+void BuildObjects(uint32_t count, uint32_t meshesCount, std::vector<Object>& objects) {
+	uint32_t side = 1;
+	while (side * side * side < count) {
+		side++;
+	}
+	const float spacing = 1.6f;
+	const float offset = float(side - 1) * spacing * 0.5f;
+
+	std::srand(1234);
+	objects.resize(count);
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t x = i % side;
+		uint32_t y = (i / side) % side;
+		uint32_t z = i / (side * side);
+		glm::vec3 position(float(x) * spacing - offset, float(y) * spacing - offset, -float(z) * spacing - 2.0f);
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+
+		Object& object = objects[i];
+		object.mMesh = uint32_t(std::rand()) % meshesCount;
+		object.mMaterial = uint32_t(std::rand()) % cMaterialsCount;
+		object.mModel = glm::rotate(model, glm::radians(float(std::rand() % 360)), glm::vec3(1.0f, 0.3f, 0.5f));
+	}
+}
+
+int main(int argc, char** argv) {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	uint32_t objectsCount = cDefaultObjectsCount;
+	for (int i = 1; i + 1 < argc; i++) {
+		if (std::strcmp(argv[i], "--count") == 0) {
+			objectsCount = uint32_t(std::strtoul(argv[i + 1], nullptr, 10));
+		}
+	}
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// frame times are only meaningful without vsync
+	glfwSwapInterval(0);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_1, UseMultiDraw);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_2, UseDrawLoop);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	// the multi draw program needs GL 4.3, the fallback one runs everywhere
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString("08-multidraw.fs", params.mFragmentShaderData);
+	ShaderProgramHandle programHandle = ShaderProgramHandle(cInvalidHandle);
+	if (DrawIndirect_IsMultiDrawSupported()) {
+		StringUtils::ReadFileToString("08-multidraw.vs", params.mVertexShaderData);
+		programHandle = ShaderProgram_Create(params);
+		if (!programHandle.IsValid()) {
+			Log(tinyngine::Logger::Error, "Failed to create shader program");
+			return 1;
+		}
+	} else {
+		Log(tinyngine::Logger::Warning, "Multi-draw indirect not supported, falling back to the draw loop");
+	}
+	StringUtils::ReadFileToString("08-multidraw_fallback.vs", params.mVertexShaderData);
+	ShaderProgramHandle fallbackProgramHandle = ShaderProgram_Create(params);
+	if (!fallbackProgramHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	DrawIndirectGeometry geometry;
+	std::vector<DrawIndirectMesh> meshes;
+	BuildMeshes(geometry, meshes);
+
+	BufferHandle vertexBuffer = BufferHandle(cInvalidHandle);
+	BufferHandle indexBuffer = BufferHandle(cInvalidHandle);
+	if (!DrawIndirect_CreateGeometryBuffers(geometry, vertexBuffer, indexBuffer)) {
+		Log(tinyngine::Logger::Error, "Failed to create geometry buffers");
+		return 1;
+	}
+
+	// rgb tint, a shininess
+	const glm::vec4 materials[cMaterialsCount] = {
+		glm::vec4(1.0f, 1.0f, 1.0f, 32.0f), glm::vec4(1.0f, 0.4f, 0.4f, 16.0f),
+		glm::vec4(0.4f, 1.0f, 0.4f, 64.0f), glm::vec4(0.4f, 0.4f, 1.0f, 8.0f),
+		glm::vec4(1.0f, 1.0f, 0.4f, 32.0f), glm::vec4(0.4f, 1.0f, 1.0f, 128.0f),
+		glm::vec4(1.0f, 0.4f, 1.0f, 4.0f), glm::vec4(0.6f, 0.6f, 0.6f, 256.0f),
+	};
+	BufferHandle materialBuffer = Buffer_Create(BufferType::Uniform, materials, sizeof(materials));
+	ShaderProgram_SetUniformBlock(programHandle, "MaterialTints", 1);
+	ShaderProgram_SetUniformBlock(fallbackProgramHandle, "MaterialTints", 1);
+
+	DrawIndirectBuilderParams builderParams;
+	builderParams.mMesh.mVertexBuffers[0] = vertexBuffer;
+	builderParams.mMesh.mVertexBuffersCount = 1;
+	builderParams.mMesh.mAttributesCount = 3;
+	builderParams.mMesh.mAttributes[0].mLocation = 0;
+	builderParams.mMesh.mAttributes[0].mComponents = 3;
+	builderParams.mMesh.mAttributes[0].mStride = cVertexStride * sizeof(float);
+	builderParams.mMesh.mAttributes[1].mLocation = 1;
+	builderParams.mMesh.mAttributes[1].mComponents = 3;
+	builderParams.mMesh.mAttributes[1].mOffset = 3 * sizeof(float);
+	builderParams.mMesh.mAttributes[1].mStride = cVertexStride * sizeof(float);
+	builderParams.mMesh.mAttributes[2].mLocation = 2;
+	builderParams.mMesh.mAttributes[2].mComponents = 2;
+	builderParams.mMesh.mAttributes[2].mOffset = 6 * sizeof(float);
+	builderParams.mMesh.mAttributes[2].mStride = cVertexStride * sizeof(float);
+	builderParams.mMesh.mIndexBuffer = indexBuffer;
+	builderParams.mMesh.mIndexFormat = IndexFormat::UInt32;
+	builderParams.mMaxDraws = objectsCount;
+	builderParams.mProgram = programHandle;
+	builderParams.mFallbackProgram = fallbackProgramHandle;
+	builderParams.mTextures[0] = textureHandle1;
+	builderParams.mTextures[1] = textureHandle2;
+	builderParams.mTexturesCount = 2;
+	DrawIndirectBuilderHandle builder = DrawIndirect_CreateBuilder(builderParams);
+	if (!builder.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create draw indirect builder");
+		return 1;
+	}
+
+	std::vector<Object> objects;
+	BuildObjects(objectsCount, uint32_t(meshes.size()), objects);
+
+	gCamera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+	glm::vec4 lightPosition(1.2f, 1.0f, 2.0f, 1.0f);
+	double lastFrameTime = 0.0;
+	double lastReportTime = 0.0;
+	double accumulatedFrameTime = 0.0;
+	uint32_t accumulatedFrames = 0;
+	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
+
+	PipelineState_ApplyDepth(DepthState());
+
+	glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, 0.1f, 200.0f);
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		glm::mat4 view = gCamera.GetViewMatrix();
+
+		processInput(window, deltaTime);
+
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		const bool useMultiDraw = DrawIndirect_UsesMultiDraw(builder, gUseMultiDraw);
+		const ShaderProgramHandle& program = useMultiDraw ? programHandle : fallbackProgramHandle;
+		ShaderProgram_Use(program);
+		ShaderProgram_SetInt(program, "u_material.diffuse", 0);
+		ShaderProgram_SetInt(program, "u_material.specular", 1);
+
+		ShaderProgram_SetVec4(program, "u_light.direction", lightPosition);
+		ShaderProgram_SetVec3(program, "u_light.ambient", 0.05f, 0.05f, 0.05f);
+		ShaderProgram_SetVec3(program, "u_light.diffuse", 1.0f, 1.0f, 0.8f);
+		ShaderProgram_SetVec3(program, "u_light.specular", 1.0f, 1.0f, 1.0f);
+		ShaderProgram_SetFloat(program, "u_light.constant", 1.0f);
+		ShaderProgram_SetFloat(program, "u_light.linear", 0.009f);
+		ShaderProgram_SetFloat(program, "u_light.quadratic", 0.0032f);
+
+		ShaderProgram_SetVec3(program, "u_viewPosition", gCamera.GetPosition());
+		ShaderProgram_SetMat4(program, "u_view", view);
+		ShaderProgram_SetMat4(program, "u_viewProj", projection * view);
+		Buffer_BindBase(materialBuffer, 1);
+
+		DrawIndirect_Clear(builder);
+		for (const Object& object : objects) {
+			DrawIndirect_Add(builder, meshes[object.mMesh], object.mModel, object.mMaterial);
+		}
+		DrawIndirect_Submit(builder, useMultiDraw);
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		accumulatedFrameTime += glfwGetTime() - currentFrameTime;
+		accumulatedFrames++;
+		if (currentFrameTime - lastReportTime >= 2.0) {
+			Log(tinyngine::Logger::Information, "%s: %u draws, %.3f ms/frame", DrawIndirect_UsesMultiDraw(builder, gUseMultiDraw) ? "MULTI-DRAW INDIRECT" : "DRAW LOOP",
+				DrawIndirect_GetCount(builder), accumulatedFrameTime * 1000.0 / accumulatedFrames);
+			accumulatedFrameTime = 0.0;
+			accumulatedFrames = 0;
+			lastReportTime = currentFrameTime;
+		}
+	}
+
+	DrawIndirect_DestroyBuilder(builder);
+	Buffer_Destroy(materialBuffer);
+	Buffer_Destroy(indexBuffer);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(fallbackProgramHandle);
+	ShaderProgram_Destroy(programHandle);
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,352 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "PipelineState.h"
+#include "RenderQueue.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+constexpr uint32_t cObjectsCount = 4000;
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+bool gSortQueue = true;
+
+Camera gCamera;
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void UseSortedQueue() {
+	Log(tinyngine::Logger::Information, "SELECT ORDER: SORTED");
+	gSortQueue = true;
+}
+
+void UseSubmissionOrder() {
+	Log(tinyngine::Logger::Information, "SELECT ORDER: SUBMISSION");
+	gSortQueue = false;
+}
+
+int main() {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_1, UseSortedQueue);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_2, UseSubmissionOrder);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString("06-lights.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("06-lights.fs", params.mFragmentShaderData);
+	ShaderProgramHandle lightsProgramHandle = ShaderProgram_Create(params);
+	if (!lightsProgramHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	StringUtils::ReadFileToString("09-translucent.fs", params.mFragmentShaderData);
+	ShaderProgramHandle translucentProgramHandle = ShaderProgram_Create(params);
+	if (!translucentProgramHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	StringUtils::ReadFileToString("05-lightingmaps.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("05-lightingmaps.fs", params.mFragmentShaderData);
+	ShaderProgramHandle lightingMapsProgramHandle = ShaderProgram_Create(params);
+	if (!lightingMapsProgramHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	TextureHandle textureHandle3 = Texture_Create("matrix.jpg", TextureFormats::RGB8);
+	TextureHandle textureHandle4 = Texture_Create("container.jpg", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid() || !textureHandle2.IsValid() || !textureHandle3.IsValid() || !textureHandle4.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	// the lighting maps shader samples an emissive map, the others do not
+	Material materials[3];
+	materials[0].mDiffuse = textureHandle1;
+	materials[0].mSpecular = textureHandle2;
+	materials[1].mDiffuse = textureHandle1;
+	materials[1].mSpecular = textureHandle2;
+	materials[1].mEmissive = textureHandle3;
+	materials[2].mDiffuse = textureHandle4;
+	materials[2].mSpecular = textureHandle2;
+	materials[2].mShininess = 8.0f;
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices, sizeof(vertices));
+
+	MeshParams cubeParams;
+	cubeParams.mVertexBuffers[0] = vertexBuffer;
+	cubeParams.mVertexBuffersCount = 1;
+	cubeParams.mAttributesCount = 3;
+	cubeParams.mAttributes[0].mLocation = 0;
+	cubeParams.mAttributes[0].mComponents = 3;
+	cubeParams.mAttributes[0].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[1].mLocation = 1;
+	cubeParams.mAttributes[1].mComponents = 3;
+	cubeParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	cubeParams.mAttributes[1].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[2].mLocation = 2;
+	cubeParams.mAttributes[2].mComponents = 2;
+	cubeParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	cubeParams.mAttributes[2].mStride = 8 * sizeof(float);
+	cubeParams.mVertexCount = 36;
+	MeshHandle cubeMesh = Mesh_Create(cubeParams);
+
+	// open box: the cube without its bottom and top faces
+	MeshParams boxParams = cubeParams;
+	boxParams.mVertexCount = 24;
+	MeshHandle boxMesh = Mesh_Create(boxParams);
+
+	if (!cubeMesh.IsValid() || !boxMesh.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create meshes");
+		return 1;
+	}
+
+	// objects are generated in random order, so draw order alone does not group any state
+	std::srand(1234);
+	std::vector<RenderPacket> packets(cObjectsCount);
+	for (uint32_t i = 0; i < cObjectsCount; i++) {
+		RenderPacket& packet = packets[i];
+		glm::vec3 position(float(std::rand() % 400) * 0.1f - 20.0f, float(std::rand() % 400) * 0.1f - 20.0f, -float(std::rand() % 600) * 0.1f);
+		packet.mModel = glm::translate(glm::mat4(1.0f), position);
+		packet.mModel = glm::rotate(packet.mModel, glm::radians(float(std::rand() % 360)), glm::vec3(1.0f, 0.3f, 0.5f));
+		packet.mMesh = (std::rand() % 2) ? cubeMesh : boxMesh;
+
+		switch (std::rand() % 5) {
+		case 0:
+			packet.mProgram = lightingMapsProgramHandle;
+			packet.mMaterial = 1;
+			break;
+		case 1:
+			packet.mProgram = translucentProgramHandle;
+			packet.mMaterial = (std::rand() % 2) ? 0 : 2;
+			packet.mTranslucent = true;
+			break;
+		default:
+			packet.mProgram = lightsProgramHandle;
+			packet.mMaterial = (std::rand() % 2) ? 0 : 2;
+			break;
+		}
+	}
+
+	gCamera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+	glm::vec3 lightPosition(1.2f, 1.0f, 2.0f);
+	double lastFrameTime = 0.0;
+	double lastReportTime = 0.0;
+	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
+	const float cNearPlane = 0.1f;
+	const float cFarPlane = 100.0f;
+
+	PipelineState_ApplyDepth(DepthState());
+
+	glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, cNearPlane, cFarPlane);
+
+	RenderQueueProgramCallback setupLighting = [&](const ShaderProgramHandle& programHandle) {
+		if (programHandle.mHandle == lightingMapsProgramHandle.mHandle) {
+			ShaderProgram_SetVec3(programHandle, "u_light.position", lightPosition);
+		} else {
+			ShaderProgram_SetVec4(programHandle, "u_light.direction", glm::vec4(lightPosition, 1.0f));
+			ShaderProgram_SetFloat(programHandle, "u_light.constant", 1.0f);
+			ShaderProgram_SetFloat(programHandle, "u_light.linear", 0.009f);
+			ShaderProgram_SetFloat(programHandle, "u_light.quadratic", 0.0032f);
+		}
+		ShaderProgram_SetVec3(programHandle, "u_light.ambient", 0.05f, 0.05f, 0.05f);
+		ShaderProgram_SetVec3(programHandle, "u_light.diffuse", 1.0f, 1.0f, 0.8f);
+		ShaderProgram_SetVec3(programHandle, "u_light.specular", 1.0f, 1.0f, 1.0f);
+		ShaderProgram_SetVec3(programHandle, "u_viewPosition", gCamera.GetPosition());
+	};
+
+	RenderQueue queue;
+	RenderQueueStats unsortedStats;
+	RenderQueueStats submitStats;
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		glm::mat4 view = gCamera.GetViewMatrix();
+
+		processInput(window, deltaTime);
+
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		RenderQueue_Begin(queue, view, projection, cNearPlane, cFarPlane);
+		for (const RenderPacket& packet : packets) {
+			RenderQueue_Add(queue, packet);
+		}
+		RenderQueue_CountStateChanges(queue, materials, TINYNGINE_COUNTOF(materials), unsortedStats);
+		if (gSortQueue) {
+			RenderQueue_Sort(queue);
+		}
+		PipelineState_ResetStats();
+		RenderQueue_Submit(queue, materials, TINYNGINE_COUNTOF(materials), setupLighting, &submitStats);
+		const PipelineStateStats& pipelineStats = PipelineState_GetStats();
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		if (currentFrameTime - lastReportTime >= 2.0) {
+			Log(tinyngine::Logger::Information, "%u draws, state changes (program/material/texture/mesh) unsorted %u/%u/%u/%u submitted %u/%u/%u/%u, pipeline calls %u (skipped %u), %.3f ms/frame",
+				submitStats.mDraws, unsortedStats.mProgramChanges, unsortedStats.mMaterialChanges, unsortedStats.mTextureBinds, unsortedStats.mMeshChanges,
+				submitStats.mProgramChanges, submitStats.mMaterialChanges, submitStats.mTextureBinds, submitStats.mMeshChanges,
+				pipelineStats.mStateCalls, pipelineStats.mSkippedCalls, deltaTime * 1000.0f);
+			lastReportTime = currentFrameTime;
+		}
+	}
+
+	Mesh_Destroy(boxMesh);
+	Mesh_Destroy(cubeMesh);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle4);
+	Texture_Destroy(textureHandle3);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(lightingMapsProgramHandle);
+	ShaderProgram_Destroy(translucentProgramHandle);
+	ShaderProgram_Destroy(lightsProgramHandle);
+
+	glfwTerminate();
+	return 0;
+}
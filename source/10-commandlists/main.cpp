@@ -0,0 +1,368 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "CommandList.h"
+#include "Frustum.h"
+#include "PipelineState.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+#include "JobSystem.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+constexpr uint32_t cObjectsCount = 40000;
+constexpr uint32_t cDrawDataBinding = 0;
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+bool gMultithreaded = true;
+
+Camera gCamera;
+
+struct Object {
+	glm::vec3 mPosition;
+	glm::vec3 mAxis;
+	float mSpeed;
+};
+
+struct DrawData {
+	glm::mat4 mModel;
+	glm::mat4 mModelView;
+	glm::mat4 mModelViewProj;
+};
+
+struct FrameContext {
+	glm::mat4 mView;
+	glm::mat4 mViewProj;
+	Frustum mFrustum;
+	double mTime;
+	ShaderProgramHandle mProgram;
+	TextureHandle mDiffuse;
+	TextureHandle mSpecular;
+	MeshHandle mMesh;
+};
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void UseMultithreadedRecording() {
+	Log(tinyngine::Logger::Information, "SELECT RECORDING: MULTITHREADED");
+	gMultithreaded = true;
+}
+
+void UseSingleThreadRecording() {
+	Log(tinyngine::Logger::Information, "SELECT RECORDING: SINGLE THREAD");
+	gMultithreaded = false;
+}
+
+// Animates, culls and records the draws of objects [first, last) into list; no GL call happens here.
+void RecordObjects(const FrameContext& context, const std::vector<Object>& objects, uint32_t first, uint32_t last, CommandList& list) {
+	CommandList_Reset(list);
+	CommandList_BindProgram(list, context.mProgram);
+	CommandList_BindTexture(list, context.mDiffuse, 0);
+	CommandList_BindTexture(list, context.mSpecular, 1);
+
+	DrawData data;
+	for (uint32_t i = first; i < last; i++) {
+		const Object& object = objects[i];
+		if (!Frustum_TestSphere(context.mFrustum, object.mPosition, 0.87f)) {
+			continue;
+		}
+		data.mModel = glm::translate(glm::mat4(1.0f), object.mPosition);
+		data.mModel = glm::rotate(data.mModel, float(std::fmod(context.mTime * object.mSpeed, glm::two_pi<double>())), object.mAxis);
+		data.mModelView = context.mView * data.mModel;
+		data.mModelViewProj = context.mViewProj * data.mModel;
+
+		CommandList_SetUniformBlock(list, cDrawDataBinding, &data, sizeof(data));
+		CommandList_Draw(list, context.mMesh);
+	}
+}
+
+int main() {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	glfwSwapInterval(0);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_1, UseMultithreadedRecording);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_2, UseSingleThreadRecording);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString("10-commandlists.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("06-lights.fs", params.mFragmentShaderData);
+	ShaderProgramHandle programHandle = ShaderProgram_Create(params);
+	if (!programHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+	ShaderProgram_SetUniformBlock(programHandle, "DrawData", cDrawDataBinding);
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices, sizeof(vertices));
+
+	MeshParams cubeParams;
+	cubeParams.mVertexBuffers[0] = vertexBuffer;
+	cubeParams.mVertexBuffersCount = 1;
+	cubeParams.mAttributesCount = 3;
+	cubeParams.mAttributes[0].mLocation = 0;
+	cubeParams.mAttributes[0].mComponents = 3;
+	cubeParams.mAttributes[0].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[1].mLocation = 1;
+	cubeParams.mAttributes[1].mComponents = 3;
+	cubeParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	cubeParams.mAttributes[1].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[2].mLocation = 2;
+	cubeParams.mAttributes[2].mComponents = 2;
+	cubeParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	cubeParams.mAttributes[2].mStride = 8 * sizeof(float);
+	cubeParams.mVertexCount = 36;
+	MeshHandle cubeMesh = Mesh_Create(cubeParams);
+	if (!cubeMesh.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create mesh");
+		return 1;
+	}
+
+	// grows on the first frames, Buffer_Update orphans it every frame
+	BufferHandle uniformBuffer = Buffer_Create(BufferType::Uniform, nullptr, 1 << 20, BufferUsage::Stream);
+
+	std::srand(1234);
+	std::vector<Object> objects(cObjectsCount);
+	for (Object& object : objects) {
+		object.mPosition = glm::vec3(float(std::rand() % 800) * 0.1f - 40.0f, float(std::rand() % 800) * 0.1f - 40.0f, -float(std::rand() % 800) * 0.1f);
+		object.mAxis = glm::normalize(glm::vec3(float(std::rand() % 100) + 1.0f, float(std::rand() % 100), float(std::rand() % 100)));
+		object.mSpeed = float(std::rand() % 100) * 0.02f;
+	}
+
+	const uint32_t workersCount = Job_GetThreadsCount();
+	std::vector<CommandList> lists(workersCount);
+
+	gCamera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+	glm::vec4 lightPosition(1.2f, 1.0f, 2.0f, 1.0f);
+	double lastFrameTime = 0.0;
+	double lastReportTime = 0.0;
+	double recordTime = 0.0;
+	double replayTime = 0.0;
+	uint32_t framesCount = 0;
+	uint32_t commandsCount = 0;
+	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
+
+	PipelineState_ApplyDepth(DepthState());
+
+	glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, 0.1f, 200.0f);
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		processInput(window, deltaTime);
+
+		FrameContext context;
+		context.mView = gCamera.GetViewMatrix();
+		context.mViewProj = projection * context.mView;
+		context.mFrustum = Frustum_FromMatrix(context.mViewProj);
+		context.mTime = currentFrameTime;
+		context.mProgram = programHandle;
+		context.mDiffuse = textureHandle1;
+		context.mSpecular = textureHandle2;
+		context.mMesh = cubeMesh;
+
+		auto recordStart = std::chrono::high_resolution_clock::now();
+		uint32_t listsCount = gMultithreaded ? workersCount : 1;
+		uint32_t objectsPerList = (cObjectsCount + listsCount - 1) / listsCount;
+		Job_RunSlices(listsCount, [&](uint32_t i) {
+			uint32_t first = i * objectsPerList;
+			uint32_t last = (first + objectsPerList < cObjectsCount) ? first + objectsPerList : cObjectsCount;
+			RecordObjects(context, objects, first, last, lists[i]);
+		});
+		auto recordEnd = std::chrono::high_resolution_clock::now();
+
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		ShaderProgram_Use(programHandle);
+		ShaderProgram_SetInt(programHandle, "u_material.diffuse", 0);
+		ShaderProgram_SetInt(programHandle, "u_material.specular", 1);
+		ShaderProgram_SetFloat(programHandle, "u_material.shininess", 32.0f);
+
+		ShaderProgram_SetVec4(programHandle, "u_light.direction", lightPosition);
+		ShaderProgram_SetVec3(programHandle, "u_light.ambient", 0.05f, 0.05f, 0.05f);
+		ShaderProgram_SetVec3(programHandle, "u_light.diffuse", 1.0f, 1.0f, 0.8f);
+		ShaderProgram_SetVec3(programHandle, "u_light.specular", 1.0f, 1.0f, 1.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.constant", 1.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.linear", 0.009f);
+		ShaderProgram_SetFloat(programHandle, "u_light.quadratic", 0.0032f);
+
+		ShaderProgram_SetVec3(programHandle, "u_viewPosition", gCamera.GetPosition());
+
+		commandsCount = CommandList_Execute(lists.data(), listsCount, uniformBuffer);
+		auto replayEnd = std::chrono::high_resolution_clock::now();
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		recordTime += std::chrono::duration<double, std::milli>(recordEnd - recordStart).count();
+		replayTime += std::chrono::duration<double, std::milli>(replayEnd - recordEnd).count();
+		framesCount++;
+		if (currentFrameTime - lastReportTime >= 2.0) {
+			Log(tinyngine::Logger::Information, "%s (%u lists): %u commands, record %.3f ms, replay %.3f ms",
+				gMultithreaded ? "MULTITHREADED" : "SINGLE THREAD", listsCount, commandsCount, recordTime / framesCount, replayTime / framesCount);
+			recordTime = 0.0;
+			replayTime = 0.0;
+			framesCount = 0;
+			lastReportTime = currentFrameTime;
+		}
+	}
+
+	Buffer_Destroy(uniformBuffer);
+	Mesh_Destroy(cubeMesh);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(programHandle);
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,583 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "Bvh.h"
+#include "Culling.h"
+#include "Instancing.h"
+#include "Occlusion.h"
+#include "PipelineState.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+#include "JobSystem.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+enum class CullingMode : uint8_t {
+	Off = 0,
+	SingleThread,
+	Parallel,
+	Hierarchy,
+	Count
+};
+
+const char* cCullingModeNames[] = {
+	"OFF",
+	"SINGLE THREAD",
+	"PARALLEL",
+	"BVH",
+};
+
+constexpr uint32_t cDefaultCubesCount = 200000;
+constexpr float cFieldSize = 400.0f;
+constexpr float cNearPlane = 0.1f;
+constexpr float cFarPlane = 150.0f;
+constexpr uint32_t cBenchmarkIterations = 50;
+constexpr uint32_t cMovingCubesDivisor = 100;		// one cube out of a hundred moves when motion is on
+constexpr uint32_t cBvhOptimizeInterval = 60;
+constexpr float cPickDistance = 500.0f;
+constexpr uint32_t cWallsCount = 96;
+constexpr uint32_t cOcclusionDivisor = 4;			// occlusion buffer at a quarter of the window resolution
+
+// low poly occluder of the walls, the unit cube as 8 corners and 12 triangles
+const float cOccluderPositions[] = {
+	-0.5f, -0.5f, -0.5f,	0.5f, -0.5f, -0.5f,		0.5f, 0.5f, -0.5f,		-0.5f, 0.5f, -0.5f,
+	-0.5f, -0.5f, 0.5f,		0.5f, -0.5f, 0.5f,		0.5f, 0.5f, 0.5f,		-0.5f, 0.5f, 0.5f,
+};
+const uint32_t cOccluderIndices[] = {
+	0, 1, 2, 0, 2, 3,	4, 6, 5, 4, 7, 6,	0, 4, 5, 0, 5, 1,
+	3, 2, 6, 3, 6, 7,	0, 3, 7, 0, 7, 4,	1, 5, 6, 1, 6, 2,
+};
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+bool gBenchmarkRequested = false;
+bool gPickRequested = false;
+bool gMoving = false;
+bool gOcclusion = true;
+CullingMode gCullingMode = CullingMode::Parallel;
+
+Camera gCamera;
+
+struct FrameStats {
+	double mAccumulated = 0.0;
+	double mCullAccumulated = 0.0;
+	double mOcclusionAccumulated = 0.0;
+	uint64_t mVisible = 0;
+	uint64_t mOccluded = 0;
+	uint32_t mFrames = 0;
+	double mLastReport = 0.0;
+};
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void SelectCullingMode(CullingMode mode) {
+	Log(tinyngine::Logger::Information, "SELECT CULLING MODE: %s", cCullingModeNames[uint32_t(mode)]);
+	gCullingMode = mode;
+}
+
+void CycleCullingPath() {
+	CullingPath::Enum path = CullingPath::Enum((Culling_GetPath() + 1) % (Culling_GetBestPath() + 1));
+	Culling_SetPath(path);
+	Log(tinyngine::Logger::Information, "CULLING PATH: %s", Culling_GetPathName(Culling_GetPath()));
+}
+
+void RequestBenchmark() {
+	gBenchmarkRequested = true;
+}
+
+void RequestPick() {
+	gPickRequested = true;
+}
+
+void ToggleMotion() {
+	gMoving = !gMoving;
+	Log(tinyngine::Logger::Information, "MOTION: %s", gMoving ? "ON" : "OFF");
+}
+
+void ToggleOcclusion() {
+	gOcclusion = !gOcclusion;
+	Log(tinyngine::Logger::Information, "OCCLUSION CULLING: %s", gOcclusion ? "ON" : "OFF");
+}
+
+// Large flat boxes standing in the cubes field, drawn with the cubes and rasterized as occluders.
+void BuildWalls(std::vector<glm::mat4>& walls) {
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> position(-cFieldSize * 0.5f, cFieldSize * 0.5f);
+	std::uniform_real_distribution<float> angle(0.0f, 180.0f);
+	walls.resize(cWallsCount);
+	for (glm::mat4& wall : walls) {
+		wall = glm::translate(glm::mat4(1.0f), glm::vec3(position(generator), position(generator) * 0.25f, position(generator)));
+		wall = glm::rotate(wall, glm::radians(angle(generator)), glm::vec3(0.0f, 1.0f, 0.0f));
+		wall = glm::scale(wall, glm::vec3(40.0f, 30.0f, 1.0f));
+	}
+}
+
+// Box of the rotated unit cube placed by model.
+BvhAabb CubeBounds(const glm::mat4& model) {
+	const glm::vec3 center(model[3]);
+	glm::vec3 extent(0.0f);
+	for (uint32_t axis = 0; axis < 3; axis++) {
+		extent += glm::abs(glm::vec3(model[axis])) * 0.5f;
+	}
+	BvhAabb bounds;
+	bounds.mMin = center - extent;
+	bounds.mMax = center + extent;
+	return bounds;
+}
+
+void BuildCubes(uint32_t count, std::vector<glm::mat4>& transforms, CullingSpheres& spheres, CullingBoxes& boxes, Bvh& bvh) {
+	std::mt19937 generator(42);
+	std::uniform_real_distribution<float> position(-cFieldSize * 0.5f, cFieldSize * 0.5f);
+	std::uniform_real_distribution<float> angle(0.0f, 360.0f);
+
+	transforms.resize(count);
+	Culling_Resize(spheres, count);
+	Culling_Resize(boxes, count);
+	std::vector<BvhAabb> bounds(count);
+	for (uint32_t i = 0; i < count; i++) {
+		glm::vec3 center(position(generator), position(generator), position(generator));
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), center);
+		model = glm::rotate(model, glm::radians(angle(generator)), glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f)));
+		transforms[i] = model;
+
+		// the unit cube rotated: sphere of half its diagonal, box of its projected half extents
+		Culling_SetSphere(spheres, i, center, 0.87f);
+		bounds[i] = CubeBounds(model);
+		Culling_SetBox(boxes, i, bounds[i].mMin, bounds[i].mMax);
+	}
+	Bvh_Build(bvh, bounds.data(), count);
+}
+
+// Moves a subset of the cubes up and down, the BVH is refitted over the moved leaves only.
+void MoveCubes(double time, std::vector<glm::mat4>& transforms, CullingSpheres& spheres, CullingBoxes& boxes, Bvh& bvh) {
+	const uint32_t count = static_cast<uint32_t>(transforms.size());
+	for (uint32_t i = 0; i < count; i += cMovingCubesDivisor) {
+		glm::mat4& model = transforms[i];
+		model[3].y += float(std::sin(time * 2.0 + double(i))) * 0.1f;
+		const BvhAabb bounds = CubeBounds(model);
+		Culling_SetSphere(spheres, i, glm::vec3(model[3]), 0.87f);
+		Culling_SetBox(boxes, i, bounds.mMin, bounds.mMax);
+		Bvh_SetObjectBounds(bvh, i, bounds);
+	}
+	Bvh_Refit(bvh);
+}
+
+void Pick(const Bvh& bvh) {
+	// camera forward is the negated third row of the view rotation
+	const glm::mat4 view = gCamera.GetViewMatrix();
+	const glm::vec3 forward(-view[0][2], -view[1][2], -view[2][2]);
+
+	BvhRayHit hit;
+	auto start = std::chrono::high_resolution_clock::now();
+	bool found = Bvh_RayCast(bvh, gCamera.GetPosition(), forward, cPickDistance, hit);
+	auto end = std::chrono::high_resolution_clock::now();
+	const double time = std::chrono::duration<double, std::micro>(end - start).count();
+	if (found) {
+		Log(tinyngine::Logger::Information, "PICK: cube %u at %.2f (%.1f us)", hit.mObject, hit.mDistance, time);
+	} else {
+		Log(tinyngine::Logger::Information, "PICK: nothing (%.1f us)", time);
+	}
+}
+
+// Times every supported path over a single or all threads and reports the throughput in objects per microsecond.
+void RunBenchmark(const Frustum& frustum, const CullingSpheres& spheres, const CullingBoxes& boxes, const Bvh& bvh, uint32_t threadsCount, std::vector<uint32_t>& visible) {
+	const CullingPath::Enum previousPath = Culling_GetPath();
+	const uint32_t threadCounts[] = { 1, threadsCount };
+
+	Log(tinyngine::Logger::Information, "BENCHMARK: %u objects, %u iterations", spheres.mCount, cBenchmarkIterations);
+	for (uint32_t path = 0; path <= uint32_t(Culling_GetBestPath()); path++) {
+		Culling_SetPath(CullingPath::Enum(path));
+		for (uint32_t threads : threadCounts) {
+			uint32_t visibleSpheres = 0;
+			auto start = std::chrono::high_resolution_clock::now();
+			for (uint32_t i = 0; i < cBenchmarkIterations; i++) {
+				visibleSpheres = Culling_TestSpheresParallel(frustum, spheres, threads, visible.data());
+			}
+			auto middle = std::chrono::high_resolution_clock::now();
+			uint32_t visibleBoxes = 0;
+			for (uint32_t i = 0; i < cBenchmarkIterations; i++) {
+				visibleBoxes = Culling_TestBoxesParallel(frustum, boxes, threads, visible.data());
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+
+			const double objects = double(spheres.mCount) * cBenchmarkIterations;
+			const double spheresTime = std::chrono::duration<double, std::micro>(middle - start).count();
+			const double boxesTime = std::chrono::duration<double, std::micro>(end - middle).count();
+			Log(tinyngine::Logger::Information, "BENCHMARK %-6s %2u threads: spheres %8.1f objects/us (%u visible), boxes %8.1f objects/us (%u visible)",
+				Culling_GetPathName(CullingPath::Enum(path)), threads, objects / spheresTime, visibleSpheres, objects / boxesTime, visibleBoxes);
+		}
+	}
+	Culling_SetPath(previousPath);
+
+	uint32_t visibleBvh = 0;
+	BvhStats bvhStats;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < cBenchmarkIterations; i++) {
+		visibleBvh = Bvh_CullFrustum(bvh, frustum, visible.data(), &bvhStats);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	const double bvhTime = std::chrono::duration<double, std::micro>(end - start).count();
+	Log(tinyngine::Logger::Information, "BENCHMARK BVH     1 threads: boxes %8.1f objects/us (%u visible, %u nodes visited, SAH cost %.1f)",
+		double(boxes.mCount) * cBenchmarkIterations / bvhTime, visibleBvh, bvhStats.mNodesVisited, Bvh_GetCost(bvh));
+}
+
+void SetupLighting(const ShaderProgramHandle& programHandle, const glm::vec4& lightPosition) {
+	ShaderProgram_Use(programHandle);
+	ShaderProgram_SetInt(programHandle, "u_material.diffuse", 0);
+	ShaderProgram_SetInt(programHandle, "u_material.specular", 1);
+	ShaderProgram_SetFloat(programHandle, "u_material.shininess", 32.0f);
+
+	ShaderProgram_SetVec4(programHandle, "u_light.direction", lightPosition);
+	ShaderProgram_SetVec3(programHandle, "u_light.ambient", 0.05f, 0.05f, 0.05f);
+	ShaderProgram_SetVec3(programHandle, "u_light.diffuse", 1.0f, 1.0f, 0.8f);
+	ShaderProgram_SetVec3(programHandle, "u_light.specular", 1.0f, 1.0f, 1.0f);
+	ShaderProgram_SetFloat(programHandle, "u_light.constant", 1.0f);
+	ShaderProgram_SetFloat(programHandle, "u_light.linear", 0.009f);
+	ShaderProgram_SetFloat(programHandle, "u_light.quadratic", 0.0032f);
+
+	ShaderProgram_SetVec3(programHandle, "u_viewPosition", gCamera.GetPosition());
+}
+
+int main(int argc, char** argv) {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	uint32_t cubesCount = cDefaultCubesCount;
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--benchmark") == 0) {
+			gBenchmarkRequested = true;
+		} else if (std::strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+			cubesCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		}
+	}
+	const uint32_t threadsCount = Job_GetThreadsCount();
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// frame times are only meaningful without vsync
+	glfwSwapInterval(0);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_1, []() { SelectCullingMode(CullingMode::Off); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_2, []() { SelectCullingMode(CullingMode::SingleThread); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_3, []() { SelectCullingMode(CullingMode::Parallel); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_4, []() { SelectCullingMode(CullingMode::Hierarchy); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_P, CycleCullingPath);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_M, ToggleMotion);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_F, RequestPick);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_O, ToggleOcclusion);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_B, RequestBenchmark);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString("06-lights_instanced.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("06-lights.fs", params.mFragmentShaderData);
+	ShaderProgramHandle instancedProgramHandle = ShaderProgram_Create(params);
+	if (!instancedProgramHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices, sizeof(vertices));
+
+	MeshParams cubeParams;
+	cubeParams.mVertexBuffers[0] = vertexBuffer;
+	cubeParams.mVertexBuffersCount = 1;
+	cubeParams.mAttributesCount = 3;
+	cubeParams.mAttributes[0].mLocation = 0;
+	cubeParams.mAttributes[0].mComponents = 3;
+	cubeParams.mAttributes[0].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[1].mLocation = 1;
+	cubeParams.mAttributes[1].mComponents = 3;
+	cubeParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	cubeParams.mAttributes[1].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[2].mLocation = 2;
+	cubeParams.mAttributes[2].mComponents = 2;
+	cubeParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	cubeParams.mAttributes[2].mStride = 8 * sizeof(float);
+	cubeParams.mVertexCount = 36;
+
+	InstanceBatchParams batchParams;
+	batchParams.mMesh = cubeParams;
+	batchParams.mMaxInstances = cubesCount + cWallsCount;
+	batchParams.mTextures[0] = textureHandle1;
+	batchParams.mTextures[1] = textureHandle2;
+	batchParams.mTexturesCount = 2;
+	batchParams.mFormat = InstanceFormat::Matrix;
+	batchParams.mProgram = instancedProgramHandle;
+	InstanceBatchHandle batch = Instancing_CreateBatch(batchParams);
+	if (!batch.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create meshes");
+		return 1;
+	}
+
+	std::vector<glm::mat4> transforms;
+	CullingSpheres spheres;
+	CullingBoxes boxes;
+	Bvh bvh;
+	BuildCubes(cubesCount, transforms, spheres, boxes, bvh);
+	std::vector<glm::mat4> walls;
+	BuildWalls(walls);
+	OcclusionBuffer occlusion;
+	Occlusion_Initialize(occlusion, cScreenWidth / cOcclusionDivisor, cScreenHeight / cOcclusionDivisor);
+	uint32_t frameIndex = 0;
+	std::vector<uint32_t> visible(cubesCount);
+
+	Log(tinyngine::Logger::Information, "%u cubes, %u threads, culling path %s", cubesCount, threadsCount, Culling_GetPathName(Culling_GetPath()));
+
+	gCamera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+	glm::vec4 lightPosition(-0.2f, -1.0f, -0.3f, 0.0f);
+	double lastFrameTime = 0.0;
+	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
+
+	PipelineState_ApplyDepth(DepthState());
+
+	FrameStats stats;
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		processInput(window, deltaTime);
+
+		glm::mat4 view = gCamera.GetViewMatrix();
+		glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, cNearPlane, cFarPlane);
+		glm::mat4 viewProj = projection * view;
+		Frustum frustum = Frustum_FromCamera(gCamera, aspectRation, cNearPlane, cFarPlane);
+
+		if (gMoving) {
+			MoveCubes(currentFrameTime, transforms, spheres, boxes, bvh);
+			if (++frameIndex % cBvhOptimizeInterval == 0 && Bvh_Optimize(bvh)) {
+				Log(tinyngine::Logger::Information, "BVH rebuilt, SAH cost %.1f", Bvh_GetCost(bvh));
+			}
+		}
+		if (gBenchmarkRequested) {
+			gBenchmarkRequested = false;
+			RunBenchmark(frustum, spheres, boxes, bvh, threadsCount, visible);
+		}
+		if (gPickRequested) {
+			gPickRequested = false;
+			Pick(bvh);
+		}
+
+		auto cullStart = std::chrono::high_resolution_clock::now();
+		uint32_t visibleCount = cubesCount;
+		if (gCullingMode == CullingMode::SingleThread) {
+			visibleCount = Culling_TestBoxes(frustum, boxes, 0, cubesCount, visible.data());
+		} else if (gCullingMode == CullingMode::Parallel) {
+			visibleCount = Culling_TestBoxesParallel(frustum, boxes, threadsCount, visible.data());
+		} else if (gCullingMode == CullingMode::Hierarchy) {
+			visibleCount = Bvh_CullFrustum(bvh, frustum, visible.data());
+		}
+		auto cullEnd = std::chrono::high_resolution_clock::now();
+
+		const uint32_t frustumVisibleCount = visibleCount;
+		if (gOcclusion && gCullingMode != CullingMode::Off) {
+			Occlusion_Begin(occlusion, viewProj);
+			for (const glm::mat4& wall : walls) {
+				OcclusionOccluder occluder;
+				occluder.mPositions = cOccluderPositions;
+				occluder.mVertexCount = 8;
+				occluder.mIndices = cOccluderIndices;
+				occluder.mIndexCount = 36;
+				occluder.mModel = wall;
+				Occlusion_AddOccluder(occlusion, occluder);
+			}
+			Occlusion_Rasterize(occlusion, threadsCount);
+			visibleCount = Occlusion_TestBoxes(occlusion, boxes, visible.data(), visibleCount, threadsCount, visible.data());
+		}
+		auto occlusionEnd = std::chrono::high_resolution_clock::now();
+
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		SetupLighting(instancedProgramHandle, lightPosition);
+		ShaderProgram_SetMat4(instancedProgramHandle, "u_view", view);
+		ShaderProgram_SetMat4(instancedProgramHandle, "u_viewProj", viewProj);
+
+		Instancing_Clear(batch);
+		if (gCullingMode == CullingMode::Off) {
+			for (const glm::mat4& transform : transforms) {
+				Instancing_Add(batch, transform);
+			}
+		} else {
+			for (uint32_t i = 0; i < visibleCount; i++) {
+				Instancing_Add(batch, transforms[visible[i]]);
+			}
+		}
+		for (const glm::mat4& wall : walls) {
+			Instancing_Add(batch, wall);
+		}
+		Instancing_Submit(batch);
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		stats.mAccumulated += glfwGetTime() - currentFrameTime;
+		stats.mCullAccumulated += std::chrono::duration<double, std::milli>(cullEnd - cullStart).count();
+		stats.mOcclusionAccumulated += std::chrono::duration<double, std::milli>(occlusionEnd - cullEnd).count();
+		stats.mVisible += visibleCount;
+		stats.mOccluded += frustumVisibleCount - visibleCount;
+		stats.mFrames++;
+		if (currentFrameTime - stats.mLastReport >= 2.0) {
+			Log(tinyngine::Logger::Information, "CULL %s (%s): %u/%u visible (%u occluded), cull %.3f ms, occlusion %.3f ms, %.3f ms/frame",
+				cCullingModeNames[uint32_t(gCullingMode)], Culling_GetPathName(Culling_GetPath()), uint32_t(stats.mVisible / stats.mFrames), cubesCount,
+				uint32_t(stats.mOccluded / stats.mFrames), stats.mCullAccumulated / stats.mFrames, stats.mOcclusionAccumulated / stats.mFrames,
+				stats.mAccumulated * 1000.0 / stats.mFrames);
+			stats = FrameStats();
+			stats.mLastReport = currentFrameTime;
+		}
+	}
+
+	Instancing_DestroyBatch(batch);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(instancedProgramHandle);
+
+	glfwTerminate();
+	return 0;
+}
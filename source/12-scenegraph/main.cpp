@@ -0,0 +1,468 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "Instancing.h"
+#include "PipelineState.h"
+#include "SceneGraph.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+#include "JobSystem.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+enum class AnimationMode : uint8_t {
+	Systems = 0,		// suns spin, every node moves
+	Moons,				// only the moons spin, a subset of the hierarchy moves
+	Paused,				// nothing changes, updates are free
+	Count
+};
+
+const char* cAnimationModeNames[] = {
+	"SYSTEMS",
+	"MOONS",
+	"PAUSED",
+};
+
+// suns -> planets -> moons -> satellites, 20 * 10 * 10 * 50 = 100k satellites
+constexpr uint32_t cSunsCount = 20;
+constexpr uint32_t cPlanetsPerSun = 10;
+constexpr uint32_t cMoonsPerPlanet = 10;
+constexpr uint32_t cSatellitesPerMoon = 50;
+constexpr float cSunsSpacing = 60.0f;
+constexpr uint32_t cBenchmarkIterations = 20;
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+bool gBenchmarkRequested = false;
+AnimationMode gAnimationMode = AnimationMode::Moons;
+
+Camera gCamera;
+
+struct FrameStats {
+	double mAccumulated = 0.0;
+	double mUpdateAccumulated = 0.0;
+	uint64_t mWorldUpdates = 0;
+	uint32_t mFrames = 0;
+	double mLastReport = 0.0;
+};
+
+// The same hierarchy kept the straightforward way, as reference for the benchmark: nodes are created after
+// their parent so a single pass in creation order recomputes every world matrix.
+struct NaiveHierarchy {
+	std::vector<uint32_t> mParents;
+	std::vector<glm::vec3> mTranslations;
+	std::vector<glm::quat> mRotations;
+	std::vector<glm::vec3> mScales;
+	std::vector<glm::mat4> mWorld;
+};
+
+struct SolarSystems {
+	SceneGraph mGraph;
+	NaiveHierarchy mNaive;
+	std::vector<SceneNode> mSuns;
+	std::vector<SceneNode> mMoons;
+};
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void SelectAnimationMode(AnimationMode mode) {
+	Log(tinyngine::Logger::Information, "SELECT ANIMATION MODE: %s", cAnimationModeNames[uint32_t(mode)]);
+	gAnimationMode = mode;
+}
+
+void RequestBenchmark() {
+	gBenchmarkRequested = true;
+}
+
+SceneNode AddNode(SolarSystems& systems, SceneNode parent, const glm::vec3& translation, float scale) {
+	NaiveHierarchy& naive = systems.mNaive;
+	naive.mParents.push_back(parent);
+	naive.mTranslations.push_back(translation);
+	naive.mRotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	naive.mScales.push_back(glm::vec3(scale));
+	naive.mWorld.push_back(glm::mat4(1.0f));
+	return SceneGraph_AddNode(systems.mGraph, parent, translation, glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(scale));
+}
+
+void BuildSystems(SolarSystems& systems) {
+	// children positions are in the parent space, the scales shrink every level
+	const float offset = float(cSunsCount / 5 - 1) * cSunsSpacing * 0.5f;
+	for (uint32_t sun = 0; sun < cSunsCount; sun++) {
+		const glm::vec3 position(float(sun / 5) * cSunsSpacing - offset, 0.0f, -float(sun % 5) * cSunsSpacing - 20.0f);
+		const SceneNode sunNode = AddNode(systems, cInvalidHandle, position, 2.0f);
+		systems.mSuns.push_back(sunNode);
+		for (uint32_t planet = 0; planet < cPlanetsPerSun; planet++) {
+			const float planetAngle = glm::two_pi<float>() * float(planet) / float(cPlanetsPerSun);
+			const float planetRadius = 4.0f + float(planet % 3) * 2.0f;
+			const SceneNode planetNode = AddNode(systems, sunNode, glm::vec3(std::cos(planetAngle), 0.0f, std::sin(planetAngle)) * planetRadius, 0.3f);
+			for (uint32_t moon = 0; moon < cMoonsPerPlanet; moon++) {
+				const float moonAngle = glm::two_pi<float>() * float(moon) / float(cMoonsPerPlanet);
+				const SceneNode moonNode = AddNode(systems, planetNode, glm::vec3(std::cos(moonAngle), std::sin(moonAngle) * 0.3f, std::sin(moonAngle)) * 4.0f, 0.4f);
+				systems.mMoons.push_back(moonNode);
+				for (uint32_t satellite = 0; satellite < cSatellitesPerMoon; satellite++) {
+					const float satelliteAngle = glm::two_pi<float>() * float(satellite) / float(cSatellitesPerMoon);
+					AddNode(systems, moonNode, glm::vec3(std::cos(satelliteAngle), 0.0f, std::sin(satelliteAngle)) * 2.5f, 0.2f);
+				}
+			}
+		}
+	}
+}
+
+void SetRotation(SolarSystems& systems, SceneNode node, const glm::quat& rotation) {
+	systems.mNaive.mRotations[node] = rotation;
+	SceneGraph_SetRotation(systems.mGraph, node, rotation);
+}
+
+// The angles are wrapped in double precision, a float time loses the sub frame steps after a few hours.
+void Animate(SolarSystems& systems, AnimationMode mode, double time) {
+	const glm::vec3 axis(0.0f, 1.0f, 0.0f);
+	if (mode == AnimationMode::Systems) {
+		for (uint32_t i = 0; i < uint32_t(systems.mSuns.size()); i++) {
+			SetRotation(systems, systems.mSuns[i], glm::angleAxis(float(std::fmod(time * 0.2, glm::two_pi<double>())) + float(i), axis));
+		}
+	} else if (mode == AnimationMode::Moons) {
+		for (uint32_t i = 0; i < uint32_t(systems.mMoons.size()); i++) {
+			SetRotation(systems, systems.mMoons[i], glm::angleAxis(float(std::fmod(time * 1.5, glm::two_pi<double>())) + float(i), axis));
+		}
+	}
+}
+
+// Recomputes every world matrix from scratch, the way it is done without dirty flags.
+void UpdateNaive(NaiveHierarchy& naive) {
+	const uint32_t count = static_cast<uint32_t>(naive.mParents.size());
+	for (uint32_t i = 0; i < count; i++) {
+		glm::mat4 local = glm::translate(glm::mat4(1.0f), naive.mTranslations[i]);
+		local = local * glm::mat4_cast(naive.mRotations[i]);
+		local = glm::scale(local, naive.mScales[i]);
+		const uint32_t parent = naive.mParents[i];
+		naive.mWorld[i] = (parent == cInvalidHandle) ? local : naive.mWorld[parent] * local;
+	}
+}
+
+// Compares the naive full recompute against the scene graph, with every node, the moons subtrees or nothing changed.
+void RunBenchmark(SolarSystems& systems, uint32_t threadsCount) {
+	const uint32_t count = SceneGraph_GetCount(systems.mGraph);
+	Log(tinyngine::Logger::Information, "BENCHMARK: %u nodes, %u iterations", count, cBenchmarkIterations);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < cBenchmarkIterations; i++) {
+		UpdateNaive(systems.mNaive);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	Log(tinyngine::Logger::Information, "BENCHMARK %-20s %8.3f ms (%u world matrices)", "NAIVE",
+		std::chrono::duration<double, std::milli>(end - start).count() / cBenchmarkIterations, count);
+
+	const uint32_t threadCounts[] = { 1, threadsCount };
+	for (uint32_t mode = 0; mode < uint32_t(AnimationMode::Count); mode++) {
+		for (uint32_t threads : threadCounts) {
+			double time = 0.0;
+			SceneGraphStats updateStats;
+			for (uint32_t i = 0; i < cBenchmarkIterations; i++) {
+				Animate(systems, AnimationMode(mode), float(i) * 0.01f);
+				start = std::chrono::high_resolution_clock::now();
+				SceneGraph_Update(systems.mGraph, threads, &updateStats);
+				end = std::chrono::high_resolution_clock::now();
+				time += std::chrono::duration<double, std::milli>(end - start).count();
+			}
+			Log(tinyngine::Logger::Information, "BENCHMARK %-8s %2u threads %8.3f ms (%u world matrices, %u levels)", cAnimationModeNames[mode], threads,
+				time / cBenchmarkIterations, updateStats.mWorldUpdates, updateStats.mLevelsVisited);
+		}
+	}
+}
+
+void SetupLighting(const ShaderProgramHandle& programHandle, const glm::vec4& lightPosition) {
+	ShaderProgram_Use(programHandle);
+	ShaderProgram_SetInt(programHandle, "u_material.diffuse", 0);
+	ShaderProgram_SetInt(programHandle, "u_material.specular", 1);
+	ShaderProgram_SetFloat(programHandle, "u_material.shininess", 32.0f);
+
+	ShaderProgram_SetVec4(programHandle, "u_light.direction", lightPosition);
+	ShaderProgram_SetVec3(programHandle, "u_light.ambient", 0.05f, 0.05f, 0.05f);
+	ShaderProgram_SetVec3(programHandle, "u_light.diffuse", 1.0f, 1.0f, 0.8f);
+	ShaderProgram_SetVec3(programHandle, "u_light.specular", 1.0f, 1.0f, 1.0f);
+	ShaderProgram_SetFloat(programHandle, "u_light.constant", 1.0f);
+	ShaderProgram_SetFloat(programHandle, "u_light.linear", 0.009f);
+	ShaderProgram_SetFloat(programHandle, "u_light.quadratic", 0.0032f);
+
+	ShaderProgram_SetVec3(programHandle, "u_viewPosition", gCamera.GetPosition());
+}
+
+int main(int argc, char** argv) {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--benchmark") == 0) {
+			gBenchmarkRequested = true;
+		}
+	}
+	const uint32_t threadsCount = Job_GetThreadsCount();
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// frame times are only meaningful without vsync
+	glfwSwapInterval(0);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_1, []() { SelectAnimationMode(AnimationMode::Systems); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_2, []() { SelectAnimationMode(AnimationMode::Moons); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_3, []() { SelectAnimationMode(AnimationMode::Paused); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_B, RequestBenchmark);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString("06-lights_instanced.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("06-lights.fs", params.mFragmentShaderData);
+	ShaderProgramHandle instancedProgramHandle = ShaderProgram_Create(params);
+	if (!instancedProgramHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices, sizeof(vertices));
+
+	MeshParams cubeParams;
+	cubeParams.mVertexBuffers[0] = vertexBuffer;
+	cubeParams.mVertexBuffersCount = 1;
+	cubeParams.mAttributesCount = 3;
+	cubeParams.mAttributes[0].mLocation = 0;
+	cubeParams.mAttributes[0].mComponents = 3;
+	cubeParams.mAttributes[0].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[1].mLocation = 1;
+	cubeParams.mAttributes[1].mComponents = 3;
+	cubeParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	cubeParams.mAttributes[1].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[2].mLocation = 2;
+	cubeParams.mAttributes[2].mComponents = 2;
+	cubeParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	cubeParams.mAttributes[2].mStride = 8 * sizeof(float);
+	cubeParams.mVertexCount = 36;
+
+	SolarSystems systems;
+	BuildSystems(systems);
+	const uint32_t nodesCount = SceneGraph_GetCount(systems.mGraph);
+
+	InstanceBatchParams batchParams;
+	batchParams.mMesh = cubeParams;
+	batchParams.mMaxInstances = nodesCount;
+	batchParams.mTextures[0] = textureHandle1;
+	batchParams.mTextures[1] = textureHandle2;
+	batchParams.mTexturesCount = 2;
+	batchParams.mFormat = InstanceFormat::Matrix;
+	batchParams.mProgram = instancedProgramHandle;
+	InstanceBatchHandle batch = Instancing_CreateBatch(batchParams);
+	if (!batch.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create meshes");
+		return 1;
+	}
+
+	Log(tinyngine::Logger::Information, "%u nodes, %u threads", nodesCount, threadsCount);
+
+	gCamera.SetPosition(glm::vec3(0.0f, 10.0f, 40.0f));
+
+	glm::vec4 lightPosition(-0.2f, -1.0f, -0.3f, 0.0f);
+	double lastFrameTime = 0.0;
+	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
+
+	PipelineState_ApplyDepth(DepthState());
+
+	FrameStats stats;
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		processInput(window, deltaTime);
+
+		if (gBenchmarkRequested) {
+			gBenchmarkRequested = false;
+			RunBenchmark(systems, threadsCount);
+		}
+
+		auto updateStart = std::chrono::high_resolution_clock::now();
+		Animate(systems, gAnimationMode, currentFrameTime);
+		const uint32_t worldUpdates = SceneGraph_Update(systems.mGraph, threadsCount);
+		auto updateEnd = std::chrono::high_resolution_clock::now();
+
+		glm::mat4 view = gCamera.GetViewMatrix();
+		glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, 0.1f, 400.0f);
+		glm::mat4 viewProj = projection * view;
+
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		SetupLighting(instancedProgramHandle, lightPosition);
+		ShaderProgram_SetMat4(instancedProgramHandle, "u_view", view);
+		ShaderProgram_SetMat4(instancedProgramHandle, "u_viewProj", viewProj);
+
+		Instancing_Clear(batch);
+		for (SceneNode node = 0; node < nodesCount; node++) {
+			Instancing_Add(batch, SceneGraph_GetWorld(systems.mGraph, node));
+		}
+		Instancing_Submit(batch);
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		stats.mAccumulated += glfwGetTime() - currentFrameTime;
+		stats.mUpdateAccumulated += std::chrono::duration<double, std::milli>(updateEnd - updateStart).count();
+		stats.mWorldUpdates += worldUpdates;
+		stats.mFrames++;
+		if (currentFrameTime - stats.mLastReport >= 2.0) {
+			Log(tinyngine::Logger::Information, "%s: %u/%u world matrices updated, update %.3f ms, %.3f ms/frame",
+				cAnimationModeNames[uint32_t(gAnimationMode)], uint32_t(stats.mWorldUpdates / stats.mFrames), nodesCount,
+				stats.mUpdateAccumulated / stats.mFrames, stats.mAccumulated * 1000.0 / stats.mFrames);
+			stats = FrameStats();
+			stats.mLastReport = currentFrameTime;
+		}
+	}
+
+	Instancing_DestroyBatch(batch);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(instancedProgramHandle);
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,575 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "Ecs.h"
+#include "EcsRender.h"
+#include "FrameLoop.h"
+#include "Frustum.h"
+#include "Instancing.h"
+#include "PipelineState.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+#include "JobSystem.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+constexpr uint32_t cDefaultCubesCount = 200000;
+constexpr float cFieldSize = 400.0f;
+constexpr float cNearPlane = 0.1f;
+constexpr float cFarPlane = 150.0f;
+constexpr uint32_t cMortalDivisor = 20;				// one cube out of twenty has a lifetime and respawns elsewhere
+constexpr uint32_t cBenchmarkIterations = 20;
+constexpr float cPipelinedCullingFovScale = 1.2f;	// the camera may turn between culling and rendering a snapshot
+
+// Components of the sample, registered after the render ones.
+struct Spin {
+	glm::vec3 mAxis;
+	float mSpeed;
+};
+
+struct Lifetime {
+	float mRemaining;
+};
+
+struct SampleComponents {
+	uint32_t mSpin = cInvalidHandle;
+	uint32_t mLifetime = cInvalidHandle;
+};
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+bool gBenchmarkRequested = false;
+bool gParallel = true;
+uint32_t gLightIndex = 0;
+FrameLoopParams gFrameLoopParams;
+
+Camera gCamera;
+
+struct FrameStats {
+	double mAccumulated = 0.0;
+	double mSimulationAccumulated = 0.0;
+	double mExtractAccumulated = 0.0;
+	double mSimulationWaitAccumulated = 0.0;
+	double mGpuWaitAccumulated = 0.0;
+	double mRenderAccumulated = 0.0;
+	uint64_t mVisible = 0;
+	uint64_t mRespawned = 0;
+	uint32_t mFrames = 0;
+	double mLastReport = 0.0;
+};
+
+// Everything the systems of the sample need besides the world.
+struct Simulation {
+	SampleComponents mComponents;
+	EcsQuery mSpinning;
+	EcsQuery mMortal;
+	std::vector<EcsCommandBuffer> mCommands;		// one per thread
+	EcsRenderMesh mCubeMesh;
+	uint32_t mSeed = 0;
+};
+
+// What the simulation of a frame hands over to the renderer, the frame loop alternates between two of them.
+struct RenderSnapshot {
+	std::vector<RenderPacket> mPackets;
+	std::vector<EcsLightInstance> mLights;
+	uint32_t mEntities = 0;
+	uint32_t mRespawned = 0;
+	double mSimulation = 0.0;						// ms
+	double mExtract = 0.0;
+};
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void ToggleParallel() {
+	gParallel = !gParallel;
+	Log(tinyngine::Logger::Information, "SYSTEMS: %s", gParallel ? "PARALLEL" : "SINGLE THREAD");
+}
+
+void CycleLight() {
+	gLightIndex++;
+}
+
+void TogglePipelining() {
+	gFrameLoopParams.mPipelined = !gFrameLoopParams.mPipelined;
+	Log(tinyngine::Logger::Information, "FRAME LOOP: %s", gFrameLoopParams.mPipelined ? "PIPELINED" : "SEQUENTIAL");
+}
+
+void CycleFrameLatency() {
+	gFrameLoopParams.mMaxFrameLatency = gFrameLoopParams.mMaxFrameLatency % cFrameLoopMaxLatency + 1;
+	Log(tinyngine::Logger::Information, "MAX FRAME LATENCY: %u", gFrameLoopParams.mMaxFrameLatency);
+}
+
+void RequestBenchmark() {
+	gBenchmarkRequested = true;
+}
+
+// Records the creation of a cube at a random place, with a lifetime when mortal is set.
+void RecordCube(Simulation& simulation, EcsCommandBuffer& commands, std::mt19937& generator, bool mortal) {
+	std::uniform_real_distribution<float> position(-cFieldSize * 0.5f, cFieldSize * 0.5f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	EcsComponentMask mask = Ecs_Mask(EcsRenderComponent::Transform) | Ecs_Mask(EcsRenderComponent::RenderMesh) |
+		Ecs_Mask(EcsRenderComponent::Bounds) | Ecs_Mask(simulation.mComponents.mSpin);
+	if (mortal) {
+		mask |= Ecs_Mask(simulation.mComponents.mLifetime);
+	}
+	const Entity entity = Ecs_RecordCreate(commands, mask);
+
+	EcsTransform transform;
+	transform.mTranslation = glm::vec3(position(generator), position(generator), position(generator));
+	Ecs_RecordAdd(commands, entity, EcsRenderComponent::Transform, transform);
+	Ecs_RecordAdd(commands, entity, EcsRenderComponent::RenderMesh, simulation.mCubeMesh);
+	Ecs_RecordAdd(commands, entity, EcsRenderComponent::Bounds, EcsBounds());
+
+	Spin spin;
+	spin.mAxis = glm::normalize(glm::vec3(unit(generator), unit(generator), unit(generator)) + glm::vec3(0.01f));
+	spin.mSpeed = 0.2f + unit(generator) * 2.0f;
+	Ecs_RecordAdd(commands, entity, simulation.mComponents.mSpin, spin);
+	if (mortal) {
+		Lifetime lifetime;
+		lifetime.mRemaining = 1.0f + unit(generator) * 10.0f;
+		Ecs_RecordAdd(commands, entity, simulation.mComponents.mLifetime, lifetime);
+	}
+}
+
+void BuildWorld(EcsWorld& world, Simulation& simulation, uint32_t cubesCount) {
+	std::mt19937 generator(42);
+	EcsCommandBuffer& commands = simulation.mCommands[0];
+	for (uint32_t i = 0; i < cubesCount; i++) {
+		RecordCube(simulation, commands, generator, i % cMortalDivisor == 0);
+	}
+
+	// a directional light and a point light, the shaders only take one at a time
+	EcsLight sun;
+	sun.mDirectional = true;
+	sun.mDiffuse = glm::vec3(1.0f, 1.0f, 0.8f);
+	EcsTransform sunTransform;
+	sunTransform.mRotation = glm::quat(glm::vec3(glm::radians(-60.0f), glm::radians(20.0f), 0.0f));
+	Entity light = Ecs_RecordCreate(commands, Ecs_Mask(EcsRenderComponent::Transform) | Ecs_Mask(EcsRenderComponent::Light));
+	Ecs_RecordAdd(commands, light, EcsRenderComponent::Transform, sunTransform);
+	Ecs_RecordAdd(commands, light, EcsRenderComponent::Light, sun);
+
+	EcsLight lamp;
+	lamp.mLinear = 0.009f;
+	lamp.mQuadratic = 0.0032f;
+	EcsTransform lampTransform;
+	lampTransform.mTranslation = glm::vec3(0.0f, 5.0f, 0.0f);
+	light = Ecs_RecordCreate(commands, Ecs_Mask(EcsRenderComponent::Transform) | Ecs_Mask(EcsRenderComponent::Light));
+	Ecs_RecordAdd(commands, light, EcsRenderComponent::Transform, lampTransform);
+	Ecs_RecordAdd(commands, light, EcsRenderComponent::Light, lamp);
+
+	Ecs_Playback(world, commands);
+}
+
+// Spins the cubes and ages the mortal ones; expired cubes are destroyed and replaced through the per thread
+// command buffers, played back once every thread is done. Returns the number of cubes respawned.
+uint32_t Simulate(EcsWorld& world, Simulation& simulation, float deltaTime, uint32_t threadsCount) {
+	const uint32_t spin = simulation.mComponents.mSpin;
+	Ecs_ForEachParallel(world, simulation.mSpinning, threadsCount, [spin, deltaTime](const EcsChunkView& chunk, uint32_t threadIndex) {
+		TINYNGINE_UNUSED(threadIndex);
+		EcsTransform* transforms = Ecs_GetArray<EcsTransform>(chunk, EcsRenderComponent::Transform);
+		const Spin* spins = Ecs_GetArray<Spin>(chunk, spin);
+		for (uint32_t i = 0; i < chunk.mCount; i++) {
+			transforms[i].mRotation = glm::normalize(glm::angleAxis(spins[i].mSpeed * deltaTime, spins[i].mAxis) * transforms[i].mRotation);
+		}
+	});
+
+	if (simulation.mCommands.size() < threadsCount) {
+		simulation.mCommands.resize(threadsCount);
+	}
+	const uint32_t lifetime = simulation.mComponents.mLifetime;
+	const uint32_t seed = simulation.mSeed++;
+	Ecs_ForEachParallel(world, simulation.mMortal, threadsCount, [&simulation, lifetime, deltaTime, seed](const EcsChunkView& chunk, uint32_t threadIndex) {
+		Lifetime* lifetimes = Ecs_GetArray<Lifetime>(chunk, lifetime);
+		EcsCommandBuffer& commands = simulation.mCommands[threadIndex];
+		std::mt19937 generator(seed * 131 + chunk.mEntities[0]);
+		for (uint32_t i = 0; i < chunk.mCount; i++) {
+			lifetimes[i].mRemaining -= deltaTime;
+			if (lifetimes[i].mRemaining <= 0.0f) {
+				Ecs_RecordDestroy(commands, chunk.mEntities[i]);
+				RecordCube(simulation, commands, generator, true);
+			}
+		}
+	});
+
+	uint32_t respawned = 0;
+	for (uint32_t t = 0; t < threadsCount; t++) {
+		respawned += simulation.mCommands[t].mCreated;
+		Ecs_Playback(world, simulation.mCommands[t]);
+	}
+	return respawned;
+}
+
+// Times the systems of a frame over a single thread and over all of them.
+void RunBenchmark(EcsWorld& world, Simulation& simulation, EcsRenderSystem& renderSystem, const Frustum& frustum, uint32_t threadsCount) {
+	Log(tinyngine::Logger::Information, "BENCHMARK: %u entities, %u iterations", Ecs_GetCount(world), cBenchmarkIterations);
+	std::vector<RenderPacket> packets;
+	const uint32_t threadCounts[] = { 1, threadsCount };
+	for (uint32_t threads : threadCounts) {
+		double simulationTime = 0.0;
+		double transformsTime = 0.0;
+		double extractTime = 0.0;
+		for (uint32_t i = 0; i < cBenchmarkIterations; i++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			Simulate(world, simulation, 1.0f / 60.0f, threads);
+			auto simulated = std::chrono::high_resolution_clock::now();
+			EcsRender_UpdateTransforms(world, renderSystem, threads);
+			auto transformed = std::chrono::high_resolution_clock::now();
+			EcsRender_Extract(world, renderSystem, frustum, threads, packets);
+			auto extracted = std::chrono::high_resolution_clock::now();
+			simulationTime += std::chrono::duration<double, std::milli>(simulated - start).count();
+			transformsTime += std::chrono::duration<double, std::milli>(transformed - simulated).count();
+			extractTime += std::chrono::duration<double, std::milli>(extracted - transformed).count();
+		}
+		const double entities = double(Ecs_GetCount(world));
+		Log(tinyngine::Logger::Information, "BENCHMARK %2u threads: simulation %.3f ms, transforms %.3f ms (%.1f entities/us), extract %.3f ms (%.1f entities/us, %u visible)",
+			threads, simulationTime / cBenchmarkIterations, transformsTime / cBenchmarkIterations, entities * cBenchmarkIterations / (transformsTime * 1000.0),
+			extractTime / cBenchmarkIterations, entities * cBenchmarkIterations / (extractTime * 1000.0), uint32_t(packets.size()));
+	}
+}
+
+void SetupMaterial(const ShaderProgramHandle& programHandle) {
+	ShaderProgram_Use(programHandle);
+	ShaderProgram_SetInt(programHandle, "u_material.diffuse", 0);
+	ShaderProgram_SetInt(programHandle, "u_material.specular", 1);
+	ShaderProgram_SetFloat(programHandle, "u_material.shininess", 32.0f);
+	ShaderProgram_SetVec3(programHandle, "u_viewPosition", gCamera.GetPosition());
+}
+
+int main(int argc, char** argv) {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	uint32_t cubesCount = cDefaultCubesCount;
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--benchmark") == 0) {
+			gBenchmarkRequested = true;
+		} else if (std::strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+			cubesCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		}
+	}
+	const uint32_t threadsCount = Job_GetThreadsCount();
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// frame times are only meaningful without vsync
+	glfwSwapInterval(0);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_1, ToggleParallel);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_L, CycleLight);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_P, TogglePipelining);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_F, CycleFrameLatency);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_B, RequestBenchmark);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString("06-lights_instanced.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("06-lights.fs", params.mFragmentShaderData);
+	ShaderProgramHandle instancedProgramHandle = ShaderProgram_Create(params);
+	if (!instancedProgramHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices, sizeof(vertices));
+
+	MeshParams cubeParams;
+	cubeParams.mVertexBuffers[0] = vertexBuffer;
+	cubeParams.mVertexBuffersCount = 1;
+	cubeParams.mAttributesCount = 3;
+	cubeParams.mAttributes[0].mLocation = 0;
+	cubeParams.mAttributes[0].mComponents = 3;
+	cubeParams.mAttributes[0].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[1].mLocation = 1;
+	cubeParams.mAttributes[1].mComponents = 3;
+	cubeParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	cubeParams.mAttributes[1].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[2].mLocation = 2;
+	cubeParams.mAttributes[2].mComponents = 2;
+	cubeParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	cubeParams.mAttributes[2].mStride = 8 * sizeof(float);
+	cubeParams.mVertexCount = 36;
+
+	InstanceBatchParams batchParams;
+	batchParams.mMesh = cubeParams;
+	batchParams.mMaxInstances = cubesCount;
+	batchParams.mTextures[0] = textureHandle1;
+	batchParams.mTextures[1] = textureHandle2;
+	batchParams.mTexturesCount = 2;
+	batchParams.mFormat = InstanceFormat::Matrix;
+	batchParams.mProgram = instancedProgramHandle;
+	InstanceBatchHandle batch = Instancing_CreateBatch(batchParams);
+	if (!batch.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create meshes");
+		return 1;
+	}
+
+	EcsWorld world;
+	EcsRenderSystem renderSystem;
+	EcsRender_Initialize(world, renderSystem);
+
+	Simulation simulation;
+	simulation.mComponents.mSpin = Ecs_RegisterComponent<Spin>(world);
+	simulation.mComponents.mLifetime = Ecs_RegisterComponent<Lifetime>(world);
+	simulation.mSpinning = Ecs_CreateQuery(Ecs_Mask(EcsRenderComponent::Transform) | Ecs_Mask(simulation.mComponents.mSpin));
+	simulation.mMortal = Ecs_CreateQuery(Ecs_Mask(simulation.mComponents.mLifetime));
+	simulation.mCommands.resize(threadsCount);
+	// the batch owns the cube mesh, the packets are only used for their model matrix
+	simulation.mCubeMesh.mProgram = instancedProgramHandle;
+	BuildWorld(world, simulation, cubesCount);
+
+	RenderSnapshot snapshots[2];
+	FrameLoop frameLoop;
+	FrameLoop_Initialize(frameLoop, gFrameLoopParams);
+
+	Log(tinyngine::Logger::Information, "%u entities, %u threads", Ecs_GetCount(world), threadsCount);
+
+	gCamera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+	double lastFrameTime = 0.0;
+	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
+
+	PipelineState_ApplyDepth(DepthState());
+
+	FrameStats stats;
+
+	// Simulates into a snapshot, possibly on a worker while the previous snapshot is rendered. Frame inputs are
+	// captured by value since the main thread moves on to the next frame meanwhile.
+	auto simulateFrame = [&world, &simulation, &renderSystem, &snapshots](uint32_t index, const FrameTime& time, const Frustum& frustum, uint32_t systemsThreads) {
+		RenderSnapshot& snapshot = snapshots[index];
+		auto simulationStart = std::chrono::high_resolution_clock::now();
+		snapshot.mRespawned = Simulate(world, simulation, float(time.mDelta), systemsThreads);
+		snapshot.mEntities = Ecs_GetCount(world);
+		EcsRender_UpdateTransforms(world, renderSystem, systemsThreads);
+		auto extractStart = std::chrono::high_resolution_clock::now();
+		EcsRender_Extract(world, renderSystem, frustum, systemsThreads, snapshot.mPackets);
+		EcsRender_GatherLights(world, renderSystem, snapshot.mLights);
+		auto extractEnd = std::chrono::high_resolution_clock::now();
+		snapshot.mSimulation = std::chrono::duration<double, std::milli>(extractStart - simulationStart).count();
+		snapshot.mExtract = std::chrono::duration<double, std::milli>(extractEnd - extractStart).count();
+	};
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = FrameLoop_GetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		processInput(window, deltaTime);
+
+		// the view is taken from the latest input when a snapshot is rendered, not when it was simulated
+		glm::mat4 view = gCamera.GetViewMatrix();
+		glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, cNearPlane, cFarPlane);
+		glm::mat4 viewProj = projection * view;
+
+		if (gBenchmarkRequested) {
+			gBenchmarkRequested = false;
+			FrameLoop_Flush(frameLoop);
+			RunBenchmark(world, simulation, renderSystem, Frustum_FromCamera(gCamera, aspectRation, cNearPlane, cFarPlane), threadsCount);
+		}
+
+		FrameLoop_SetParams(frameLoop, gFrameLoopParams);
+		const uint32_t systemsThreads = gParallel ? threadsCount : 1;
+		const float cullingFov = gFrameLoopParams.mPipelined ? gCamera.GetFOV() * cPipelinedCullingFovScale : gCamera.GetFOV();
+		const Frustum frustum = Frustum_FromMatrix(glm::perspective(glm::radians(cullingFov), aspectRation, cNearPlane, cFarPlane) * view);
+
+		FrameLoop_Frame(frameLoop, [&simulateFrame, frustum, systemsThreads](uint32_t index, const FrameTime& time) {
+			simulateFrame(index, time, frustum, systemsThreads);
+		}, [&](uint32_t index, const FrameTime& time) {
+			TINYNGINE_UNUSED(time);
+			const RenderSnapshot& snapshot = snapshots[index];
+			glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			SetupMaterial(instancedProgramHandle);
+			if (!snapshot.mLights.empty()) {
+				EcsRender_SetLight(instancedProgramHandle, snapshot.mLights[gLightIndex % snapshot.mLights.size()]);
+			}
+			ShaderProgram_SetMat4(instancedProgramHandle, "u_view", view);
+			ShaderProgram_SetMat4(instancedProgramHandle, "u_viewProj", viewProj);
+
+			Instancing_Clear(batch);
+			for (const RenderPacket& packet : snapshot.mPackets) {
+				Instancing_Add(batch, packet.mModel);
+			}
+			Instancing_Submit(batch);
+		});
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		const RenderSnapshot& rendered = snapshots[frameLoop.mFront];
+		const FrameLoopStats& loopStats = FrameLoop_GetStats(frameLoop);
+		stats.mAccumulated += FrameLoop_GetTime() - currentFrameTime;
+		stats.mSimulationAccumulated += rendered.mSimulation;
+		stats.mExtractAccumulated += rendered.mExtract;
+		stats.mSimulationWaitAccumulated += loopStats.mSimulationWait;
+		stats.mGpuWaitAccumulated += loopStats.mGpuWait;
+		stats.mRenderAccumulated += loopStats.mRender;
+		stats.mVisible += rendered.mPackets.size();
+		stats.mRespawned += rendered.mRespawned;
+		stats.mFrames++;
+		if (currentFrameTime - stats.mLastReport >= 2.0) {
+			// the entities are counted by the simulation, pipelined it is changing the world meanwhile
+			Log(tinyngine::Logger::Information, "%s, %s: %u entities, %u visible, %u respawned/frame, simulation %.3f ms, extract %.3f ms, render %.3f ms",
+				gParallel ? "PARALLEL" : "SINGLE THREAD", gFrameLoopParams.mPipelined ? "PIPELINED" : "SEQUENTIAL", rendered.mEntities,
+				uint32_t(stats.mVisible / stats.mFrames), uint32_t(stats.mRespawned / stats.mFrames), stats.mSimulationAccumulated / stats.mFrames,
+				stats.mExtractAccumulated / stats.mFrames, stats.mRenderAccumulated / stats.mFrames);
+			Log(tinyngine::Logger::Information, "    waits: simulation %.3f ms, gpu %.3f ms (max latency %u), %.3f ms/frame",
+				stats.mSimulationWaitAccumulated / stats.mFrames, stats.mGpuWaitAccumulated / stats.mFrames, gFrameLoopParams.mMaxFrameLatency,
+				stats.mAccumulated * 1000.0 / stats.mFrames);
+			stats = FrameStats();
+			stats.mLastReport = currentFrameTime;
+		}
+	}
+
+	FrameLoop_Shutdown(frameLoop);
+	Instancing_DestroyBatch(batch);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(instancedProgramHandle);
+
+	glfwTerminate();
+	return 0;
+}
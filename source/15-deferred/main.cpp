@@ -0,0 +1,534 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Deferred.h"
+#include "GpuTimer.h"
+#include "Mesh.h"
+#include "Instancing.h"
+#include "LightGrid.h"
+#include "PipelineState.h"
+#include "RenderTarget.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+#include "JobSystem.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/constants.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+constexpr uint32_t cDefaultLightsCount = 4096;
+constexpr uint32_t cMinLightsCount = 256;
+constexpr uint32_t cMaxLightsCount = 16384;
+constexpr int32_t cFloorSize = 96;					// cubes per side
+constexpr uint32_t cPillarsCount = 1500;			// tall and dense enough for a few layers of overdraw
+constexpr float cNearPlane = 0.1f;
+constexpr float cFarPlane = 150.0f;
+constexpr uint8_t cLightGridStage = 2;				// stages 0 and 1 hold the material textures
+
+// Forward is the clustered path of 14-clustered, the deferred ones come from Deferred.h.
+struct RenderPath {
+	enum Enum {
+		Forward,
+		DeferredVolumes,
+		DeferredTiled,
+		Count
+	};
+};
+
+const char* const cRenderPathNames[] = { "FORWARD", "DEFERRED VOLUMES", "DEFERRED TILED" };
+const char* const cViewNames[] = { "LIGHTING", "ALBEDO", "SPECULAR", "NORMALS", "DEPTH" };
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+RenderPath::Enum gRenderPath = RenderPath::DeferredVolumes;
+DeferredView::Enum gView = DeferredView::Lighting;
+uint32_t gLightsCount = cDefaultLightsCount;
+uint32_t gViewportWidth = 800;
+uint32_t gViewportHeight = 600;
+
+Camera gCamera;
+
+// A light circling around a point above the floor.
+struct OrbitingLight {
+	glm::vec3 mCenter;
+	float mOrbit;
+	float mSpeed;
+	float mPhase;
+};
+
+// GPU times of the passes, the forward path only has the geometry one.
+struct PassTimers {
+	GpuTimer mGeometry;
+	GpuTimer mLighting;
+	GpuTimer mComposite;
+};
+
+struct FrameStats {
+	double mAccumulated = 0.0;
+	double mBuildAccumulated = 0.0;
+	double mGeometryAccumulated = 0.0;
+	double mLightingAccumulated = 0.0;
+	double mCompositeAccumulated = 0.0;
+	uint64_t mVisibleLights = 0;
+	uint32_t mFrames = 0;
+	double mLastReport = 0.0;
+};
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+	gViewportWidth = uint32_t(width);
+	gViewportHeight = uint32_t(height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void CycleRenderPath() {
+	gRenderPath = RenderPath::Enum((gRenderPath + 1) % RenderPath::Count);
+	Log(tinyngine::Logger::Information, "RENDER PATH: %s", cRenderPathNames[gRenderPath]);
+}
+
+void CycleView() {
+	gView = DeferredView::Enum((gView + 1) % DeferredView::Count);
+	Log(tinyngine::Logger::Information, "G-BUFFER VIEW: %s", cViewNames[gView]);
+}
+
+void MoreLights() {
+	gLightsCount = std::min(gLightsCount * 2, cMaxLightsCount);
+	Log(tinyngine::Logger::Information, "LIGHTS: %u", gLightsCount);
+}
+
+void FewerLights() {
+	gLightsCount = std::max(gLightsCount / 2, cMinLightsCount);
+	Log(tinyngine::Logger::Information, "LIGHTS: %u", gLightsCount);
+}
+
+// Unit cubes tiling the floor, with a few pillars stacked on top so lights have something to graze.
+void BuildScene(std::vector<glm::vec3>& cubes) {
+	std::mt19937 generator(42);
+	std::uniform_int_distribution<int32_t> cell(-cFloorSize / 2, cFloorSize / 2 - 1);
+	std::uniform_int_distribution<int32_t> height(1, 12);
+	for (int32_t z = -cFloorSize / 2; z < cFloorSize / 2; z++) {
+		for (int32_t x = -cFloorSize / 2; x < cFloorSize / 2; x++) {
+			cubes.push_back(glm::vec3(float(x), -0.5f, float(z)));
+		}
+	}
+	for (uint32_t i = 0; i < cPillarsCount; i++) {
+		const float x = float(cell(generator));
+		const float z = float(cell(generator));
+		const int32_t levels = height(generator);
+		for (int32_t y = 0; y < levels; y++) {
+			cubes.push_back(glm::vec3(x, 0.5f + float(y), z));
+		}
+	}
+}
+
+void BuildLights(std::vector<OrbitingLight>& orbits, std::vector<PointLight>& lights) {
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> position(-cFloorSize * 0.5f, cFloorSize * 0.5f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	orbits.resize(cMaxLightsCount);
+	lights.resize(cMaxLightsCount);
+	for (uint32_t i = 0; i < cMaxLightsCount; i++) {
+		orbits[i].mCenter = glm::vec3(position(generator), 0.3f + unit(generator) * 3.0f, position(generator));
+		orbits[i].mOrbit = 0.5f + unit(generator) * 3.0f;
+		orbits[i].mSpeed = (unit(generator) - 0.5f) * 2.0f;
+		orbits[i].mPhase = unit(generator) * glm::two_pi<float>();
+
+		// saturated hues, the intensity compensates for the smaller radius of the dimmer ones
+		const float hue = unit(generator) * 6.0f;
+		const glm::vec3 color = glm::clamp(glm::vec3(std::fabs(hue - 3.0f) - 1.0f, 2.0f - std::fabs(hue - 2.0f), 2.0f - std::fabs(hue - 4.0f)), 0.0f, 1.0f);
+		lights[i].mColor = color;
+		lights[i].mRadius = 1.5f + unit(generator) * 2.5f;
+		lights[i].mIntensity = 2.0f * lights[i].mRadius;
+	}
+}
+
+void MoveLights(const std::vector<OrbitingLight>& orbits, std::vector<PointLight>& lights, uint32_t count, double time) {
+	for (uint32_t i = 0; i < count; i++) {
+		const float angle = float(std::fmod(time * orbits[i].mSpeed + orbits[i].mPhase, glm::two_pi<double>()));
+		lights[i].mPosition = orbits[i].mCenter + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * orbits[i].mOrbit;
+	}
+}
+
+ShaderProgramHandle CreateProgram(const char* vertexShader, const char* fragmentShader) {
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString(vertexShader, params.mVertexShaderData);
+	StringUtils::ReadFileToString(fragmentShader, params.mFragmentShaderData);
+	ShaderProgramHandle handle = ShaderProgram_Create(params);
+	if (!handle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program %s", fragmentShader);
+	}
+	return handle;
+}
+
+int main(int argc, char** argv) {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--forward") == 0) {
+			gRenderPath = RenderPath::Forward;
+		} else if (std::strcmp(argv[i], "--lights") == 0 && i + 1 < argc) {
+			gLightsCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+			gLightsCount = std::min(std::max(gLightsCount, cMinLightsCount), cMaxLightsCount);
+		}
+	}
+	const uint32_t threadsCount = Job_GetThreadsCount();
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// frame times are only meaningful without vsync
+	glfwSwapInterval(0);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_M, CycleRenderPath);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_G, CycleView);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_EQUAL, MoreLights);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_MINUS, FewerLights);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	gViewportWidth = uint32_t(framebufferWidth);
+	gViewportHeight = uint32_t(framebufferHeight);
+
+	// the G-buffer pass shares the vertex shader of the forward one, both work in view space
+	ShaderProgramHandle forwardProgram = CreateProgram("14-clustered.vs", "14-clustered.fs");
+	ShaderProgramHandle gbufferProgram = CreateProgram("14-clustered.vs", "15-gbuffer.fs");
+	DeferredParams deferredParams;
+	deferredParams.mWidth = gViewportWidth;
+	deferredParams.mHeight = gViewportHeight;
+	deferredParams.mAmbientProgram = CreateProgram("15-deferred_fullscreen.vs", "15-deferred_ambient.fs");
+	deferredParams.mVolumeProgram = CreateProgram("15-deferred_volume.vs", "15-deferred_volume.fs");
+	deferredParams.mTiledProgram = CreateProgram("15-deferred_fullscreen.vs", "15-deferred_tiled.fs");
+	deferredParams.mCompositeProgram = CreateProgram("15-deferred_fullscreen.vs", "15-deferred_composite.fs");
+	if (!forwardProgram.IsValid() || !gbufferProgram.IsValid() || !deferredParams.mAmbientProgram.IsValid() || !deferredParams.mVolumeProgram.IsValid() ||
+		!deferredParams.mTiledProgram.IsValid() || !deferredParams.mCompositeProgram.IsValid()) {
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices, sizeof(vertices));
+
+	MeshParams cubeParams;
+	cubeParams.mVertexBuffers[0] = vertexBuffer;
+	cubeParams.mVertexBuffersCount = 1;
+	cubeParams.mAttributesCount = 3;
+	cubeParams.mAttributes[0].mLocation = 0;
+	cubeParams.mAttributes[0].mComponents = 3;
+	cubeParams.mAttributes[0].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[1].mLocation = 1;
+	cubeParams.mAttributes[1].mComponents = 3;
+	cubeParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	cubeParams.mAttributes[1].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[2].mLocation = 2;
+	cubeParams.mAttributes[2].mComponents = 2;
+	cubeParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	cubeParams.mAttributes[2].mStride = 8 * sizeof(float);
+	cubeParams.mVertexCount = 36;
+
+	std::vector<glm::vec3> cubes;
+	BuildScene(cubes);
+
+	// one batch per path since a batch is tied to its program, the scene is static so instances are only added once
+	InstanceBatchParams batchParams;
+	batchParams.mMesh = cubeParams;
+	batchParams.mMaxInstances = uint32_t(cubes.size());
+	batchParams.mTextures[0] = textureHandle1;
+	batchParams.mTextures[1] = textureHandle2;
+	batchParams.mTexturesCount = 2;
+	batchParams.mFormat = InstanceFormat::Matrix;
+	batchParams.mProgram = forwardProgram;
+	InstanceBatchHandle forwardBatch = Instancing_CreateBatch(batchParams);
+	batchParams.mProgram = gbufferProgram;
+	InstanceBatchHandle gbufferBatch = Instancing_CreateBatch(batchParams);
+	if (!forwardBatch.IsValid() || !gbufferBatch.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create meshes");
+		return 1;
+	}
+	for (const glm::vec3& cube : cubes) {
+		Instancing_Add(forwardBatch, glm::translate(glm::mat4(1.0f), cube));
+		Instancing_Add(gbufferBatch, glm::translate(glm::mat4(1.0f), cube));
+	}
+
+	DeferredRenderer deferred;
+	if (!Deferred_Initialize(deferred, deferredParams)) {
+		Log(tinyngine::Logger::Error, "Failed to create the G-buffer");
+		return 1;
+	}
+
+	PassTimers timers;
+	GpuTimer_Create(timers.mGeometry);
+	GpuTimer_Create(timers.mLighting);
+	GpuTimer_Create(timers.mComposite);
+
+	std::vector<OrbitingLight> orbits;
+	std::vector<PointLight> lights;
+	BuildLights(orbits, lights);
+
+	LightGrid grid;
+	LightGrid_Initialize(grid);
+	LightGrid_CreateTextures(grid);
+
+	Log(tinyngine::Logger::Information, "%u cubes, %u lights, %s", uint32_t(cubes.size()), gLightsCount, cRenderPathNames[gRenderPath]);
+
+	gCamera.SetPosition(glm::vec3(0.0f, 6.0f, 20.0f));
+
+	double lastFrameTime = 0.0;
+	const glm::vec3 sunDirection = glm::normalize(glm::vec3(0.3f, 1.0f, 0.2f));
+	const glm::vec3 background(0.02f, 0.02f, 0.03f);
+
+	FrameStats stats;
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		processInput(window, deltaTime);
+
+		const float aspect = float(gViewportWidth) / float(std::max(gViewportHeight, 1u));
+		const float fovY = glm::radians(gCamera.GetFOV());
+		glm::mat4 view = gCamera.GetViewMatrix();
+		glm::mat4 projection = glm::perspective(fovY, aspect, cNearPlane, cFarPlane);
+
+		MoveLights(orbits, lights, gLightsCount, currentFrameTime);
+
+		if (gViewportWidth != deferred.mParams.mWidth || gViewportHeight != deferred.mParams.mHeight) {
+			Deferred_Resize(deferred, gViewportWidth, gViewportHeight);
+		}
+
+		// the light volumes only need the culled view space lights, the other paths read the clusters too
+		auto buildStart = std::chrono::high_resolution_clock::now();
+		LightGrid_Build(grid, lights.data(), gLightsCount, view, fovY, aspect, cNearPlane, cFarPlane, threadsCount);
+		if (gRenderPath != RenderPath::DeferredVolumes) {
+			LightGrid_Upload(grid);
+		}
+		auto buildEnd = std::chrono::high_resolution_clock::now();
+
+		if (gRenderPath == RenderPath::Forward) {
+			RenderTarget_BindDefault(gViewportWidth, gViewportHeight);
+			PipelineState_ApplyDepth(DepthState());
+			PipelineState_ApplyBlend(BlendState());
+			PipelineState_ApplyRaster(RasterState());
+			glClearColor(background.r, background.g, background.b, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			GpuTimer_Begin(timers.mGeometry);
+			ShaderProgram_Use(forwardProgram);
+			ShaderProgram_SetInt(forwardProgram, "u_material.diffuse", 0);
+			ShaderProgram_SetInt(forwardProgram, "u_material.specular", 1);
+			ShaderProgram_SetFloat(forwardProgram, "u_material.shininess", 32.0f);
+			ShaderProgram_SetVec3(forwardProgram, "u_ambient", glm::vec3(0.02f));
+			ShaderProgram_SetVec3(forwardProgram, "u_sunDirection", glm::mat3(view) * sunDirection);
+			ShaderProgram_SetVec3(forwardProgram, "u_sunColor", glm::vec3(0.05f, 0.05f, 0.08f));
+			ShaderProgram_SetInt(forwardProgram, "u_heatmap", 0);
+			ShaderProgram_SetMat4(forwardProgram, "u_view", view);
+			ShaderProgram_SetMat4(forwardProgram, "u_projection", projection);
+			LightGrid_Bind(grid, forwardProgram, cLightGridStage, gViewportWidth, gViewportHeight);
+			Instancing_Submit(forwardBatch);
+			GpuTimer_End(timers.mGeometry);
+		} else {
+			GpuTimer_Begin(timers.mGeometry);
+			Deferred_BeginGeometry(deferred);
+			PipelineState_ApplyRaster(RasterState());
+			ShaderProgram_Use(gbufferProgram);
+			ShaderProgram_SetInt(gbufferProgram, "u_material.diffuse", 0);
+			ShaderProgram_SetInt(gbufferProgram, "u_material.specular", 1);
+			ShaderProgram_SetMat4(gbufferProgram, "u_view", view);
+			ShaderProgram_SetMat4(gbufferProgram, "u_projection", projection);
+			Instancing_Submit(gbufferBatch);
+			GpuTimer_End(timers.mGeometry);
+
+			DeferredLighting lighting;
+			lighting.mAmbient = glm::vec3(0.02f);
+			lighting.mSunDirection = glm::mat3(view) * sunDirection;
+			lighting.mSunColor = glm::vec3(0.05f, 0.05f, 0.08f);
+			lighting.mBackground = background;
+			GpuTimer_Begin(timers.mLighting);
+			Deferred_Light(deferred, grid, lighting, projection, gRenderPath == RenderPath::DeferredVolumes ? DeferredMode::LightVolumes : DeferredMode::Tiled);
+			GpuTimer_End(timers.mLighting);
+
+			GpuTimer_Begin(timers.mComposite);
+			Deferred_Composite(deferred, gView, gViewportWidth, gViewportHeight, projection);
+			GpuTimer_End(timers.mComposite);
+		}
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		const bool forward = (gRenderPath == RenderPath::Forward);
+		stats.mAccumulated += glfwGetTime() - currentFrameTime;
+		stats.mBuildAccumulated += std::chrono::duration<double, std::milli>(buildEnd - buildStart).count();
+		stats.mGeometryAccumulated += GpuTimer_GetMilliseconds(timers.mGeometry);
+		stats.mLightingAccumulated += forward ? 0.0 : GpuTimer_GetMilliseconds(timers.mLighting);
+		stats.mCompositeAccumulated += forward ? 0.0 : GpuTimer_GetMilliseconds(timers.mComposite);
+		stats.mVisibleLights += LightGrid_GetStats(grid).mLights;
+		stats.mFrames++;
+		if (currentFrameTime - stats.mLastReport >= 2.0) {
+			// the GPU times lag a few frames behind, the first report after a switch still mixes both paths
+			const double gpu = (stats.mGeometryAccumulated + stats.mLightingAccumulated + stats.mCompositeAccumulated) / stats.mFrames;
+			Log(tinyngine::Logger::Information, "%s: %u lights, %u visible, light grid %.3f ms, gpu %.3f ms (geometry %.3f, lighting %.3f, composite %.3f), %.3f ms/frame",
+				cRenderPathNames[gRenderPath], gLightsCount, uint32_t(stats.mVisibleLights / stats.mFrames), stats.mBuildAccumulated / stats.mFrames, gpu,
+				stats.mGeometryAccumulated / stats.mFrames, stats.mLightingAccumulated / stats.mFrames, stats.mCompositeAccumulated / stats.mFrames,
+				stats.mAccumulated * 1000.0 / stats.mFrames);
+			stats = FrameStats();
+			stats.mLastReport = currentFrameTime;
+		}
+	}
+
+	GpuTimer_Destroy(timers.mComposite);
+	GpuTimer_Destroy(timers.mLighting);
+	GpuTimer_Destroy(timers.mGeometry);
+	Deferred_Destroy(deferred);
+	LightGrid_Destroy(grid);
+	Instancing_DestroyBatch(gbufferBatch);
+	Instancing_DestroyBatch(forwardBatch);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(deferredParams.mCompositeProgram);
+	ShaderProgram_Destroy(deferredParams.mTiledProgram);
+	ShaderProgram_Destroy(deferredParams.mVolumeProgram);
+	ShaderProgram_Destroy(deferredParams.mAmbientProgram);
+	ShaderProgram_Destroy(gbufferProgram);
+	ShaderProgram_Destroy(forwardProgram);
+
+	glfwTerminate();
+	return 0;
+}
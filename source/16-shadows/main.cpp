@@ -0,0 +1,503 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "CascadedShadows.h"
+#include "Frustum.h"
+#include "Mesh.h"
+#include "Instancing.h"
+#include "PipelineState.h"
+#include "RenderTarget.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/constants.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+constexpr int32_t cFloorSize = 96;					// cubes per side
+constexpr int32_t cSectorSize = 16;					// floor cubes per side of a shadow caster sector
+constexpr int32_t cSectorsPerSide = cFloorSize / cSectorSize;
+constexpr int32_t cMaxHeight = 12;
+constexpr uint32_t cPillarsCount = 1500;
+constexpr uint32_t cMovingCubesCount = 16;
+constexpr float cNearPlane = 0.1f;
+constexpr float cFarPlane = 150.0f;
+constexpr uint8_t cShadowStage = 2;					// stages 0 and 1 hold the material textures
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+uint32_t gViewportWidth = 800;
+uint32_t gViewportHeight = 600;
+CascadedShadowParams gShadowParams;
+bool gShadowParamsChanged = false;
+bool gAnimateSun = false;
+bool gMoveCubes = true;
+bool gShowCascades = false;
+
+Camera gCamera;
+
+// Casters of a square of the floor, culled as a whole against each cascade.
+struct Sector {
+	InstanceBatchHandle mBatch;
+	glm::vec3 mCenter;
+	float mRadius;
+};
+
+struct MovingCube {
+	glm::vec3 mCenter;
+	float mOrbit;
+	float mSpeed;
+	float mPhase;
+	glm::vec3 mPosition;
+};
+
+struct FrameStats {
+	double mAccumulated = 0.0;
+	uint32_t mFrames = 0;
+	double mLastReport = 0.0;
+};
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+	gViewportWidth = uint32_t(width);
+	gViewportHeight = uint32_t(height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void ToggleCaching() {
+	gShadowParams.mCaching = !gShadowParams.mCaching;
+	gShadowParamsChanged = true;
+	Log(tinyngine::Logger::Information, "CASCADE CACHING: %s", gShadowParams.mCaching ? "ON" : "OFF");
+}
+
+void ToggleRoundRobin() {
+	gShadowParams.mFirstRoundRobin = gShadowParams.mFirstRoundRobin < cMaxShadowCascades ? cMaxShadowCascades : 2;
+	gShadowParamsChanged = true;
+	Log(tinyngine::Logger::Information, "ROUND ROBIN: %s", gShadowParams.mFirstRoundRobin < cMaxShadowCascades ? "ON" : "OFF");
+}
+
+void CycleCascades() {
+	gShadowParams.mCascadesCount = gShadowParams.mCascadesCount < cMaxShadowCascades ? gShadowParams.mCascadesCount + 1 : 2;
+	gShadowParamsChanged = true;
+	Log(tinyngine::Logger::Information, "CASCADES: %u", gShadowParams.mCascadesCount);
+}
+
+void ToggleSunAnimation() {
+	gAnimateSun = !gAnimateSun;
+	Log(tinyngine::Logger::Information, "SUN ANIMATION: %s", gAnimateSun ? "ON" : "OFF");
+}
+
+void ToggleMovingCubes() {
+	gMoveCubes = !gMoveCubes;
+	Log(tinyngine::Logger::Information, "MOVING CUBES: %s", gMoveCubes ? "ON" : "OFF");
+}
+
+void ToggleShowCascades() {
+	gShowCascades = !gShowCascades;
+}
+
+// Unit cubes tiling the floor with pillars on top, grouped by sector.
+void BuildScene(std::vector<std::vector<glm::vec3>>& sectors) {
+	sectors.resize(cSectorsPerSide * cSectorsPerSide);
+	auto sectorOf = [](int32_t x, int32_t z) {
+		return uint32_t((z + cFloorSize / 2) / cSectorSize * cSectorsPerSide + (x + cFloorSize / 2) / cSectorSize);
+	};
+	std::mt19937 generator(42);
+	std::uniform_int_distribution<int32_t> cell(-cFloorSize / 2, cFloorSize / 2 - 1);
+	std::uniform_int_distribution<int32_t> height(1, cMaxHeight);
+	for (int32_t z = -cFloorSize / 2; z < cFloorSize / 2; z++) {
+		for (int32_t x = -cFloorSize / 2; x < cFloorSize / 2; x++) {
+			sectors[sectorOf(x, z)].push_back(glm::vec3(float(x), -0.5f, float(z)));
+		}
+	}
+	for (uint32_t i = 0; i < cPillarsCount; i++) {
+		const int32_t x = cell(generator);
+		const int32_t z = cell(generator);
+		const int32_t levels = height(generator);
+		for (int32_t y = 0; y < levels; y++) {
+			sectors[sectorOf(x, z)].push_back(glm::vec3(float(x), 0.5f + float(y), float(z)));
+		}
+	}
+}
+
+void BuildMovingCubes(std::vector<MovingCube>& cubes) {
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> position(-12.0f, 12.0f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	cubes.resize(cMovingCubesCount);
+	for (MovingCube& cube : cubes) {
+		cube.mCenter = glm::vec3(position(generator), 3.0f + unit(generator) * 4.0f, position(generator));
+		cube.mOrbit = 1.0f + unit(generator) * 3.0f;
+		cube.mSpeed = (unit(generator) - 0.5f) * 2.0f;
+		cube.mPhase = unit(generator) * glm::two_pi<float>();
+		cube.mPosition = cube.mCenter;
+	}
+}
+
+ShaderProgramHandle CreateProgram(const char* vertexShader, const char* fragmentShader) {
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString(vertexShader, params.mVertexShaderData);
+	StringUtils::ReadFileToString(fragmentShader, params.mFragmentShaderData);
+	ShaderProgramHandle handle = ShaderProgram_Create(params);
+	if (!handle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program %s", fragmentShader);
+	}
+	return handle;
+}
+
+int main() {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// frame times are only meaningful without vsync
+	glfwSwapInterval(0);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_C, ToggleCaching);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_R, ToggleRoundRobin);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_K, CycleCascades);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_L, ToggleSunAnimation);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_P, ToggleMovingCubes);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_V, ToggleShowCascades);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	gViewportWidth = uint32_t(framebufferWidth);
+	gViewportHeight = uint32_t(framebufferHeight);
+
+	ShaderProgramHandle colorProgram = CreateProgram("14-clustered.vs", "16-shadows.fs");
+	ShaderProgramHandle depthProgram = CreateProgram("16-shadow_depth.vs", "16-shadow_depth.fs");
+	if (!colorProgram.IsValid() || !depthProgram.IsValid()) {
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices, sizeof(vertices));
+
+	MeshParams cubeParams;
+	cubeParams.mVertexBuffers[0] = vertexBuffer;
+	cubeParams.mVertexBuffersCount = 1;
+	cubeParams.mAttributesCount = 3;
+	cubeParams.mAttributes[0].mLocation = 0;
+	cubeParams.mAttributes[0].mComponents = 3;
+	cubeParams.mAttributes[0].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[1].mLocation = 1;
+	cubeParams.mAttributes[1].mComponents = 3;
+	cubeParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	cubeParams.mAttributes[1].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[2].mLocation = 2;
+	cubeParams.mAttributes[2].mComponents = 2;
+	cubeParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	cubeParams.mAttributes[2].mStride = 8 * sizeof(float);
+	cubeParams.mVertexCount = 36;
+
+	std::vector<std::vector<glm::vec3>> sectorCubes;
+	BuildScene(sectorCubes);
+	std::vector<MovingCube> movingCubes;
+	BuildMovingCubes(movingCubes);
+
+	InstanceBatchParams batchParams;
+	batchParams.mMesh = cubeParams;
+	batchParams.mTextures[0] = textureHandle1;
+	batchParams.mTextures[1] = textureHandle2;
+	batchParams.mTexturesCount = 2;
+	batchParams.mFormat = InstanceFormat::Matrix;
+
+	// the static scene is drawn in one batch, its casters in one batch per sector so cascades only render the
+	// sectors they overlap
+	uint32_t cubesCount = 0;
+	for (const auto& cubes : sectorCubes) {
+		cubesCount += uint32_t(cubes.size());
+	}
+	batchParams.mProgram = colorProgram;
+	batchParams.mMaxInstances = cubesCount;
+	InstanceBatchHandle sceneBatch = Instancing_CreateBatch(batchParams);
+	batchParams.mMaxInstances = cMovingCubesCount;
+	InstanceBatchHandle movingBatch = Instancing_CreateBatch(batchParams);
+	batchParams.mProgram = depthProgram;
+	batchParams.mTexturesCount = 0;
+	InstanceBatchHandle movingDepthBatch = Instancing_CreateBatch(batchParams);
+	if (!sceneBatch.IsValid() || !movingBatch.IsValid() || !movingDepthBatch.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create meshes");
+		return 1;
+	}
+
+	std::vector<Sector> sectors(sectorCubes.size());
+	for (size_t i = 0; i < sectorCubes.size(); i++) {
+		batchParams.mMaxInstances = uint32_t(sectorCubes[i].size());
+		sectors[i].mBatch = Instancing_CreateBatch(batchParams);
+		if (!sectors[i].mBatch.IsValid()) {
+			Log(tinyngine::Logger::Error, "Failed to create meshes");
+			return 1;
+		}
+		glm::vec3 boundsMin(FLT_MAX);
+		glm::vec3 boundsMax(-FLT_MAX);
+		for (const glm::vec3& cube : sectorCubes[i]) {
+			Instancing_Add(sceneBatch, glm::translate(glm::mat4(1.0f), cube));
+			Instancing_Add(sectors[i].mBatch, glm::translate(glm::mat4(1.0f), cube));
+			boundsMin = glm::min(boundsMin, cube - glm::vec3(0.5f));
+			boundsMax = glm::max(boundsMax, cube + glm::vec3(0.5f));
+		}
+		sectors[i].mCenter = 0.5f * (boundsMin + boundsMax);
+		sectors[i].mRadius = 0.5f * glm::length(boundsMax - boundsMin);
+	}
+
+	CascadedShadows shadows;
+	if (!CascadedShadows_Initialize(shadows, gShadowParams, depthProgram)) {
+		Log(tinyngine::Logger::Error, "Failed to create the shadow map");
+		return 1;
+	}
+
+	Log(tinyngine::Logger::Information, "%u cubes in %u sectors, %u moving cubes, %u cascades", cubesCount, uint32_t(sectors.size()), cMovingCubesCount, gShadowParams.mCascadesCount);
+
+	gCamera.SetPosition(glm::vec3(0.0f, 6.0f, 20.0f));
+
+	double lastFrameTime = 0.0;
+	double sunTime = 0.0;
+	const glm::vec3 background(0.45f, 0.55f, 0.7f);
+
+	FrameStats stats;
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		processInput(window, deltaTime);
+
+		if (gShadowParamsChanged) {
+			CascadedShadows_SetParams(shadows, gShadowParams);
+			gShadowParamsChanged = false;
+		}
+
+		const float aspect = float(gViewportWidth) / float(std::max(gViewportHeight, 1u));
+		glm::mat4 view = gCamera.GetViewMatrix();
+		glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspect, cNearPlane, cFarPlane);
+
+		if (gAnimateSun) {
+			sunTime += deltaTime;
+		}
+		const float sunAngle = 0.6f + float(sunTime) * 0.1f;
+		const glm::vec3 sunDirection = glm::normalize(glm::vec3(std::cos(sunAngle), 1.2f, std::sin(sunAngle)));
+
+		// a moving caster invalidates the cascades around where it was and where it is now
+		Instancing_Clear(movingBatch);
+		Instancing_Clear(movingDepthBatch);
+		for (MovingCube& cube : movingCubes) {
+			if (gMoveCubes) {
+				const glm::vec3 previous = cube.mPosition;
+				const float angle = float(std::fmod(currentFrameTime * cube.mSpeed + cube.mPhase, glm::two_pi<double>()));
+				cube.mPosition = cube.mCenter + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * cube.mOrbit;
+				CascadedShadows_Invalidate(shadows, glm::min(previous, cube.mPosition) - glm::vec3(0.5f), glm::max(previous, cube.mPosition) + glm::vec3(0.5f));
+			}
+			Instancing_Add(movingBatch, glm::translate(glm::mat4(1.0f), cube.mPosition));
+			Instancing_Add(movingDepthBatch, glm::translate(glm::mat4(1.0f), cube.mPosition));
+		}
+
+		CascadedShadows_Update(shadows, gCamera, aspect, cNearPlane, sunDirection, [&](uint32_t cascade, const glm::mat4& viewProjection, const Frustum& frustum) {
+			TINYNGINE_UNUSED(cascade);
+			ShaderProgram_SetMat4(depthProgram, "u_viewProjection", viewProjection);
+			uint32_t draws = 0;
+			for (const Sector& sector : sectors) {
+				if (Frustum_TestSphere(frustum, sector.mCenter, sector.mRadius)) {
+					Instancing_Submit(sector.mBatch);
+					draws++;
+				}
+			}
+			Instancing_Submit(movingDepthBatch);
+			return draws + 1;
+		});
+
+		RenderTarget_BindDefault(gViewportWidth, gViewportHeight);
+		PipelineState_ApplyDepth(DepthState());
+		PipelineState_ApplyBlend(BlendState());
+		PipelineState_ApplyRaster(RasterState());
+		glClearColor(background.r, background.g, background.b, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		ShaderProgram_Use(colorProgram);
+		ShaderProgram_SetInt(colorProgram, "u_material.diffuse", 0);
+		ShaderProgram_SetInt(colorProgram, "u_material.specular", 1);
+		ShaderProgram_SetFloat(colorProgram, "u_material.shininess", 32.0f);
+		ShaderProgram_SetVec3(colorProgram, "u_ambient", glm::vec3(0.25f, 0.28f, 0.35f));
+		ShaderProgram_SetVec3(colorProgram, "u_sunDirection", glm::mat3(view) * sunDirection);
+		ShaderProgram_SetVec3(colorProgram, "u_sunColor", glm::vec3(1.0f, 0.95f, 0.85f));
+		ShaderProgram_SetInt(colorProgram, "u_showCascades", gShowCascades ? 1 : 0);
+		ShaderProgram_SetMat4(colorProgram, "u_view", view);
+		ShaderProgram_SetMat4(colorProgram, "u_projection", projection);
+		CascadedShadows_Bind(shadows, colorProgram, cShadowStage, view);
+		Instancing_Submit(sceneBatch);
+		Instancing_Submit(movingBatch);
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		stats.mAccumulated += glfwGetTime() - currentFrameTime;
+		stats.mFrames++;
+		if (currentFrameTime - stats.mLastReport >= 2.0) {
+			Log(tinyngine::Logger::Information, "%u frames, %.3f ms/frame, caching %s, round robin %s", stats.mFrames, stats.mAccumulated * 1000.0 / stats.mFrames,
+				gShadowParams.mCaching ? "on" : "off", (gShadowParams.mCaching && gShadowParams.mFirstRoundRobin < gShadowParams.mCascadesCount) ? "on" : "off");
+			for (uint32_t i = 0; i < gShadowParams.mCascadesCount; i++) {
+				const ShadowCascadeStats& cascadeStats = CascadedShadows_GetStats(shadows, i);
+				Log(tinyngine::Logger::Information, "  cascade %u [%.1f, %.1f]: %u renders, %u cached, %u draws, %.3f ms", i, shadows.mCascades[i].mSplitNear, shadows.mCascades[i].mSplitFar,
+					cascadeStats.mRenders, cascadeStats.mCachedFrames, cascadeStats.mDraws, cascadeStats.mMilliseconds);
+			}
+			CascadedShadows_ResetStats(shadows);
+			stats = FrameStats();
+			stats.mLastReport = currentFrameTime;
+		}
+	}
+
+	CascadedShadows_Destroy(shadows);
+	for (const Sector& sector : sectors) {
+		Instancing_DestroyBatch(sector.mBatch);
+	}
+	Instancing_DestroyBatch(movingDepthBatch);
+	Instancing_DestroyBatch(movingBatch);
+	Instancing_DestroyBatch(sceneBatch);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(depthProgram);
+	ShaderProgram_Destroy(colorProgram);
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,577 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "Instancing.h"
+#include "PipelineState.h"
+#include "RenderTarget.h"
+#include "ShaderProgram.h"
+#include "ShadowAtlas.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/constants.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+constexpr uint32_t cDefaultLightsCount = 128;
+constexpr uint32_t cMinLightsCount = 16;
+constexpr uint32_t cMaxLightsCount = cShadowAtlasMaxLights;
+constexpr int32_t cFloorSize = 64;					// cubes per side
+constexpr int32_t cCellSize = 8;					// floor cubes per side of a caster culling cell
+constexpr int32_t cCellsPerSide = cFloorSize / cCellSize;
+constexpr uint32_t cPillarsCount = 600;
+constexpr uint32_t cMovingCubesCount = 16;
+constexpr uint32_t cLightTexels = 3;
+constexpr float cNearPlane = 0.1f;
+constexpr float cFarPlane = 150.0f;
+constexpr uint8_t cShadowAtlasStage = 2;			// stages 0 and 1 hold the material textures
+constexpr uint8_t cShadowLightsStage = 3;
+constexpr uint8_t cLightsStage = 4;
+
+const uint32_t cBudgets[] = { 6, 24, 96 };
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+uint32_t gViewportWidth = 800;
+uint32_t gViewportHeight = 600;
+uint32_t gLightsCount = cDefaultLightsCount;
+uint32_t gBudget = 1;
+bool gAnimateLights = true;
+bool gShowShadows = false;
+
+Camera gCamera;
+
+// Casters of a square of the floor, with their bounds for the light range tests.
+struct Cell {
+	std::vector<glm::vec3> mCubes;
+	glm::vec3 mMin;
+	glm::vec3 mMax;
+};
+
+// Point lights circle around a point, spot lights stay in place and sweep their cone around.
+struct AnimatedLight {
+	glm::vec3 mCenter;
+	float mOrbit;
+	float mSpeed;
+	float mPhase;
+};
+
+struct MovingCube {
+	glm::vec3 mCenter;
+	float mOrbit;
+	float mSpeed;
+	float mPhase;
+	glm::vec3 mPosition;
+};
+
+struct FrameStats {
+	double mAccumulated = 0.0;
+	uint64_t mUpdates = 0;
+	uint64_t mFaces = 0;
+	uint64_t mDraws = 0;
+	uint64_t mPending = 0;
+	uint32_t mFrames = 0;
+	double mLastReport = 0.0;
+};
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+	gViewportWidth = uint32_t(width);
+	gViewportHeight = uint32_t(height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void MoreLights() {
+	gLightsCount = std::min(gLightsCount * 2, cMaxLightsCount);
+	Log(tinyngine::Logger::Information, "LIGHTS: %u", gLightsCount);
+}
+
+void FewerLights() {
+	gLightsCount = std::max(gLightsCount / 2, cMinLightsCount);
+	Log(tinyngine::Logger::Information, "LIGHTS: %u", gLightsCount);
+}
+
+void CycleBudget() {
+	gBudget = (gBudget + 1) % (sizeof(cBudgets) / sizeof(cBudgets[0]));
+	Log(tinyngine::Logger::Information, "UPDATE BUDGET: %u faces", cBudgets[gBudget]);
+}
+
+void ToggleLightAnimation() {
+	gAnimateLights = !gAnimateLights;
+	Log(tinyngine::Logger::Information, "LIGHT ANIMATION: %s", gAnimateLights ? "ON" : "OFF");
+}
+
+void ToggleShowShadows() {
+	gShowShadows = !gShowShadows;
+}
+
+// Unit cubes tiling the floor with pillars on top, grouped by cell.
+void BuildScene(std::vector<Cell>& cells) {
+	cells.resize(cCellsPerSide * cCellsPerSide);
+	auto cellOf = [](int32_t x, int32_t z) {
+		return uint32_t((z + cFloorSize / 2) / cCellSize * cCellsPerSide + (x + cFloorSize / 2) / cCellSize);
+	};
+	std::mt19937 generator(42);
+	std::uniform_int_distribution<int32_t> position(-cFloorSize / 2, cFloorSize / 2 - 1);
+	std::uniform_int_distribution<int32_t> height(1, 6);
+	for (int32_t z = -cFloorSize / 2; z < cFloorSize / 2; z++) {
+		for (int32_t x = -cFloorSize / 2; x < cFloorSize / 2; x++) {
+			cells[cellOf(x, z)].mCubes.push_back(glm::vec3(float(x), -0.5f, float(z)));
+		}
+	}
+	for (uint32_t i = 0; i < cPillarsCount; i++) {
+		const int32_t x = position(generator);
+		const int32_t z = position(generator);
+		const int32_t levels = height(generator);
+		for (int32_t y = 0; y < levels; y++) {
+			cells[cellOf(x, z)].mCubes.push_back(glm::vec3(float(x), 0.5f + float(y), float(z)));
+		}
+	}
+	for (Cell& cell : cells) {
+		cell.mMin = glm::vec3(FLT_MAX);
+		cell.mMax = glm::vec3(-FLT_MAX);
+		for (const glm::vec3& cube : cell.mCubes) {
+			cell.mMin = glm::min(cell.mMin, cube - glm::vec3(0.5f));
+			cell.mMax = glm::max(cell.mMax, cube + glm::vec3(0.5f));
+		}
+	}
+}
+
+void BuildLights(std::vector<AnimatedLight>& animations, std::vector<ShadowLight>& lights, std::vector<glm::vec4>& colors) {
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> position(-cFloorSize * 0.5f, cFloorSize * 0.5f);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	animations.resize(cMaxLightsCount);
+	lights.resize(cMaxLightsCount);
+	colors.resize(cMaxLightsCount);
+	for (uint32_t i = 0; i < cMaxLightsCount; i++) {
+		ShadowLight& light = lights[i];
+		light.mType = (i % 2) ? ShadowLightType::Spot : ShadowLightType::Point;
+		animations[i].mCenter = glm::vec3(position(generator), light.mType == ShadowLightType::Spot ? 5.0f + unit(generator) * 3.0f : 1.0f + unit(generator) * 4.0f, position(generator));
+		animations[i].mOrbit = 0.5f + unit(generator) * 2.0f;
+		animations[i].mSpeed = (unit(generator) - 0.5f) * 2.0f;
+		animations[i].mPhase = unit(generator) * glm::two_pi<float>();
+		light.mPosition = animations[i].mCenter;
+		light.mRadius = light.mType == ShadowLightType::Spot ? 10.0f + unit(generator) * 4.0f : 4.0f + unit(generator) * 3.0f;
+		light.mOuterAngle = 0.4f + unit(generator) * 0.3f;
+
+		const float hue = unit(generator) * 6.0f;
+		const glm::vec3 color = glm::clamp(glm::vec3(std::fabs(hue - 3.0f) - 1.0f, 2.0f - std::fabs(hue - 2.0f), 2.0f - std::fabs(hue - 4.0f)), 0.0f, 1.0f);
+		colors[i] = glm::vec4(color * 3.0f * light.mRadius, float(light.mType));
+	}
+}
+
+void AnimateLights(const std::vector<AnimatedLight>& animations, std::vector<ShadowLight>& lights, uint32_t count, double time) {
+	for (uint32_t i = 0; i < count; i++) {
+		const float angle = float(std::fmod(time * animations[i].mSpeed + animations[i].mPhase, glm::two_pi<double>()));
+		const glm::vec3 circle(std::cos(angle), 0.0f, std::sin(angle));
+		if (lights[i].mType == ShadowLightType::Spot) {
+			lights[i].mDirection = glm::normalize(circle * 0.5f - glm::vec3(0.0f, 1.0f, 0.0f));
+		} else {
+			lights[i].mPosition = animations[i].mCenter + circle * animations[i].mOrbit;
+		}
+	}
+}
+
+bool Overlaps(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& center, float radius) {
+	const glm::vec3 offset = glm::clamp(center, boundsMin, boundsMax) - center;
+	return glm::dot(offset, offset) <= radius * radius;
+}
+
+ShaderProgramHandle CreateProgram(const char* vertexShader, const char* fragmentShader) {
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString(vertexShader, params.mVertexShaderData);
+	StringUtils::ReadFileToString(fragmentShader, params.mFragmentShaderData);
+	ShaderProgramHandle handle = ShaderProgram_Create(params);
+	if (!handle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program %s", fragmentShader);
+	}
+	return handle;
+}
+
+int main(int argc, char** argv) {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--lights") == 0 && i + 1 < argc) {
+			gLightsCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+			gLightsCount = std::min(std::max(gLightsCount, cMinLightsCount), cMaxLightsCount);
+		}
+	}
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// frame times are only meaningful without vsync
+	glfwSwapInterval(0);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_EQUAL, MoreLights);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_MINUS, FewerLights);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_B, CycleBudget);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_L, ToggleLightAnimation);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_V, ToggleShowShadows);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	gViewportWidth = uint32_t(framebufferWidth);
+	gViewportHeight = uint32_t(framebufferHeight);
+
+	ShaderProgramHandle colorProgram = CreateProgram("14-clustered.vs", "17-shadowatlas.fs");
+	ShaderProgramHandle depthProgram = CreateProgram("17-shadowatlas_depth.vs", "16-shadow_depth.fs");
+	if (!colorProgram.IsValid() || !depthProgram.IsValid()) {
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices, sizeof(vertices));
+
+	MeshParams cubeParams;
+	cubeParams.mVertexBuffers[0] = vertexBuffer;
+	cubeParams.mVertexBuffersCount = 1;
+	cubeParams.mAttributesCount = 3;
+	cubeParams.mAttributes[0].mLocation = 0;
+	cubeParams.mAttributes[0].mComponents = 3;
+	cubeParams.mAttributes[0].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[1].mLocation = 1;
+	cubeParams.mAttributes[1].mComponents = 3;
+	cubeParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	cubeParams.mAttributes[1].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[2].mLocation = 2;
+	cubeParams.mAttributes[2].mComponents = 2;
+	cubeParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	cubeParams.mAttributes[2].mStride = 8 * sizeof(float);
+	cubeParams.mVertexCount = 36;
+
+	std::vector<Cell> cells;
+	BuildScene(cells);
+	std::vector<MovingCube> movingCubes(cMovingCubesCount);
+	{
+		std::mt19937 generator(11);
+		std::uniform_real_distribution<float> position(-16.0f, 16.0f);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		for (MovingCube& cube : movingCubes) {
+			cube.mCenter = glm::vec3(position(generator), 2.0f + unit(generator) * 2.0f, position(generator));
+			cube.mOrbit = 1.0f + unit(generator) * 2.0f;
+			cube.mSpeed = (unit(generator) - 0.5f) * 2.0f;
+			cube.mPhase = unit(generator) * glm::two_pi<float>();
+			cube.mPosition = cube.mCenter;
+		}
+	}
+
+	uint32_t cubesCount = 0;
+	for (const Cell& cell : cells) {
+		cubesCount += uint32_t(cell.mCubes.size());
+	}
+
+	// the depth batches are refilled with the casters in range of each light before it is rendered, the point
+	// light one draws every cube once per cube face
+	InstanceBatchParams batchParams;
+	batchParams.mMesh = cubeParams;
+	batchParams.mTextures[0] = textureHandle1;
+	batchParams.mTextures[1] = textureHandle2;
+	batchParams.mTexturesCount = 2;
+	batchParams.mFormat = InstanceFormat::Matrix;
+	batchParams.mProgram = colorProgram;
+	batchParams.mMaxInstances = cubesCount;
+	InstanceBatchHandle sceneBatch = Instancing_CreateBatch(batchParams);
+	batchParams.mMaxInstances = cMovingCubesCount;
+	InstanceBatchHandle movingBatch = Instancing_CreateBatch(batchParams);
+	batchParams.mProgram = depthProgram;
+	batchParams.mMaxInstances = cubesCount + cMovingCubesCount;
+	batchParams.mTexturesCount = 0;
+	InstanceBatchHandle spotBatch = Instancing_CreateBatch(batchParams);
+	batchParams.mRepeat = 6;
+	InstanceBatchHandle pointBatch = Instancing_CreateBatch(batchParams);
+	if (!sceneBatch.IsValid() || !movingBatch.IsValid() || !spotBatch.IsValid() || !pointBatch.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create meshes");
+		return 1;
+	}
+	for (const Cell& cell : cells) {
+		for (const glm::vec3& cube : cell.mCubes) {
+			Instancing_Add(sceneBatch, glm::translate(glm::mat4(1.0f), cube));
+		}
+	}
+
+	std::vector<AnimatedLight> animations;
+	std::vector<ShadowLight> lights;
+	std::vector<glm::vec4> lightColors;
+	BuildLights(animations, lights, lightColors);
+
+	// position and radius, color and type, spot direction and cone cosine per light
+	std::vector<glm::vec4> lightData(cMaxLightsCount * cLightTexels);
+	BufferHandle lightBuffer = Buffer_Create(BufferType::Texture, nullptr, uint32_t(lightData.size() * sizeof(glm::vec4)), BufferUsage::Stream);
+	TextureHandle lightTexture = Texture_CreateBuffer(lightBuffer, TextureFormats::RGBA32F);
+
+	ShadowAtlas atlas;
+	if (!ShadowAtlas_Initialize(atlas, ShadowAtlasParams(), depthProgram)) {
+		Log(tinyngine::Logger::Error, "Failed to create the shadow atlas");
+		return 1;
+	}
+
+	Log(tinyngine::Logger::Information, "%u cubes, %u lights, %u x %u shadow atlas", cubesCount, gLightsCount, atlas.mParams.mSize, atlas.mParams.mSize);
+
+	gCamera.SetPosition(glm::vec3(0.0f, 8.0f, 24.0f));
+
+	double lastFrameTime = 0.0;
+	double lightTime = 0.0;
+
+	FrameStats stats;
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		processInput(window, deltaTime);
+
+		const float aspect = float(gViewportWidth) / float(std::max(gViewportHeight, 1u));
+		glm::mat4 view = gCamera.GetViewMatrix();
+		glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspect, cNearPlane, cFarPlane);
+
+		if (gAnimateLights) {
+			lightTime += deltaTime;
+			AnimateLights(animations, lights, gLightsCount, lightTime);
+			for (MovingCube& cube : movingCubes) {
+				const glm::vec3 previous = cube.mPosition;
+				const float angle = float(std::fmod(lightTime * cube.mSpeed + cube.mPhase, glm::two_pi<double>()));
+				cube.mPosition = cube.mCenter + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * cube.mOrbit;
+				ShadowAtlas_Invalidate(atlas, glm::min(previous, cube.mPosition) - glm::vec3(0.5f), glm::max(previous, cube.mPosition) + glm::vec3(0.5f));
+			}
+		}
+
+		atlas.mParams.mUpdateBudget = cBudgets[gBudget];
+		ShadowAtlas_Update(atlas, lights.data(), gLightsCount, view, projection, [&](uint32_t index) {
+			const ShadowLight& light = lights[index];
+			const InstanceBatchHandle& batch = light.mType == ShadowLightType::Point ? pointBatch : spotBatch;
+			Instancing_Clear(batch);
+			for (const Cell& cell : cells) {
+				if (!Overlaps(cell.mMin, cell.mMax, light.mPosition, light.mRadius)) {
+					continue;
+				}
+				for (const glm::vec3& cube : cell.mCubes) {
+					if (Overlaps(cube - glm::vec3(0.5f), cube + glm::vec3(0.5f), light.mPosition, light.mRadius)) {
+						Instancing_Add(batch, glm::translate(glm::mat4(1.0f), cube));
+					}
+				}
+			}
+			for (const MovingCube& cube : movingCubes) {
+				if (Overlaps(cube.mPosition - glm::vec3(0.5f), cube.mPosition + glm::vec3(0.5f), light.mPosition, light.mRadius)) {
+					Instancing_Add(batch, glm::translate(glm::mat4(1.0f), cube.mPosition));
+				}
+			}
+			if (Instancing_GetCount(batch) == 0) {
+				return 0u;
+			}
+			Instancing_Submit(batch);
+			return 1u;
+		});
+
+		for (uint32_t i = 0; i < gLightsCount; i++) {
+			const ShadowLight& light = lights[i];
+			lightData[cLightTexels * i] = glm::vec4(light.mPosition, light.mRadius);
+			lightData[cLightTexels * i + 1] = lightColors[i];
+			lightData[cLightTexels * i + 2] = glm::vec4(light.mDirection, std::cos(light.mOuterAngle));
+		}
+		Buffer_Update(lightBuffer, 0, lightData.data(), uint32_t(gLightsCount * cLightTexels * sizeof(glm::vec4)));
+
+		Instancing_Clear(movingBatch);
+		for (const MovingCube& cube : movingCubes) {
+			Instancing_Add(movingBatch, glm::translate(glm::mat4(1.0f), cube.mPosition));
+		}
+
+		RenderTarget_BindDefault(gViewportWidth, gViewportHeight);
+		PipelineState_ApplyDepth(DepthState());
+		PipelineState_ApplyBlend(BlendState());
+		PipelineState_ApplyRaster(RasterState());
+		glClearColor(0.02f, 0.02f, 0.03f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		ShaderProgram_Use(colorProgram);
+		ShaderProgram_SetInt(colorProgram, "u_material.diffuse", 0);
+		ShaderProgram_SetInt(colorProgram, "u_material.specular", 1);
+		ShaderProgram_SetFloat(colorProgram, "u_material.shininess", 32.0f);
+		ShaderProgram_SetVec3(colorProgram, "u_ambient", glm::vec3(0.03f));
+		ShaderProgram_SetInt(colorProgram, "u_lightsCount", int(gLightsCount));
+		ShaderProgram_SetInt(colorProgram, "u_showShadows", gShowShadows ? 1 : 0);
+		ShaderProgram_SetMat4(colorProgram, "u_view", view);
+		ShaderProgram_SetMat4(colorProgram, "u_projection", projection);
+		Texture_Bind(lightTexture, cLightsStage);
+		ShaderProgram_SetInt(colorProgram, "u_lights", cLightsStage);
+		ShadowAtlas_Bind(atlas, colorProgram, cShadowAtlasStage, cShadowLightsStage, view);
+		Instancing_Submit(sceneBatch);
+		Instancing_Submit(movingBatch);
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		const ShadowAtlasStats& atlasStats = ShadowAtlas_GetStats(atlas);
+		stats.mAccumulated += glfwGetTime() - currentFrameTime;
+		stats.mUpdates += atlasStats.mUpdates;
+		stats.mFaces += atlasStats.mFaces;
+		stats.mDraws += atlasStats.mDraws;
+		stats.mPending += atlasStats.mPending;
+		stats.mFrames++;
+		if (currentFrameTime - stats.mLastReport >= 2.0) {
+			Log(tinyngine::Logger::Information, "%u lights, %u with a tile, bias %u, %.0f%% allocated, %u repacks, per frame: %.1f shadows (%.1f faces, %.1f draws), %.1f pending, %.3f ms",
+				gLightsCount, atlasStats.mTiles, atlasStats.mLevelBias, atlasStats.mOccupancy * 100.0f, atlasStats.mRepacks, double(stats.mUpdates) / stats.mFrames,
+				double(stats.mFaces) / stats.mFrames, double(stats.mDraws) / stats.mFrames, double(stats.mPending) / stats.mFrames, stats.mAccumulated * 1000.0 / stats.mFrames);
+			ShadowAtlas_ResetStats(atlas);
+			stats = FrameStats();
+			stats.mLastReport = currentFrameTime;
+		}
+	}
+
+	ShadowAtlas_Destroy(atlas);
+	Texture_Destroy(lightTexture);
+	Buffer_Destroy(lightBuffer);
+	Instancing_DestroyBatch(pointBatch);
+	Instancing_DestroyBatch(spotBatch);
+	Instancing_DestroyBatch(movingBatch);
+	Instancing_DestroyBatch(sceneBatch);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(depthProgram);
+	ShaderProgram_Destroy(colorProgram);
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,526 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "FrameGraph.h"
+#include "Mesh.h"
+#include "PipelineState.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+constexpr uint32_t cMaxBlurPasses = 16;				// horizontal and vertical pairs
+constexpr float cNearPlane = 0.1f;
+constexpr float cFarPlane = 100.0f;
+constexpr float cBloomThreshold = 0.8f;
+constexpr uint32_t cCubesCount = 10;
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+bool gBloom = true;
+bool gEdges = false;
+uint32_t gBlurPasses = 2;
+uint32_t gViewportWidth = 800;
+uint32_t gViewportHeight = 600;
+
+Camera gCamera;
+
+const glm::vec3 cCubePositions[cCubesCount] = {
+	glm::vec3(0.0f,  0.0f,  0.0f),
+	glm::vec3(2.0f,  5.0f, -15.0f),
+	glm::vec3(-1.5f, -2.2f, -2.5f),
+	glm::vec3(-3.8f, -2.0f, -12.3f),
+	glm::vec3(2.4f, -0.4f, -3.5f),
+	glm::vec3(-1.7f,  3.0f, -7.5f),
+	glm::vec3(1.3f, -2.0f, -2.5f),
+	glm::vec3(1.5f,  2.0f, -2.5f),
+	glm::vec3(1.5f,  0.2f, -1.5f),
+	glm::vec3(-1.3f,  1.0f, -1.5f)
+};
+
+// Everything the passes need, alive until the frame graph is executed.
+struct FrameContext {
+	ShaderProgramHandle mSceneProgram;
+	ShaderProgramHandle mLightProgram;
+	ShaderProgramHandle mBrightProgram;
+	ShaderProgramHandle mBlurProgram;
+	ShaderProgramHandle mEdgesProgram;
+	ShaderProgramHandle mCompositeProgram;
+	PipelineStateHandle mBrightState;
+	PipelineStateHandle mBlurState;
+	PipelineStateHandle mEdgesState;
+	PipelineStateHandle mCompositeState;
+	TextureHandle mDiffuse;
+	TextureHandle mSpecular;
+	MeshHandle mCube;
+	MeshHandle mFullscreen;
+	glm::mat4 mView;
+	glm::mat4 mProjection;
+	glm::vec3 mLightPosition;
+	uint32_t mWidth;
+	uint32_t mHeight;
+};
+
+struct FrameStats {
+	double mAccumulated = 0.0;
+	uint32_t mFrames = 0;
+	double mLastReport = 0.0;
+};
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+	gViewportWidth = uint32_t(width);
+	gViewportHeight = uint32_t(height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+
+void ToggleBloom() {
+	gBloom = !gBloom;
+	Log(tinyngine::Logger::Information, "BLOOM: %s", gBloom ? "ON" : "OFF");
+}
+
+void ToggleEdges() {
+	gEdges = !gEdges;
+	Log(tinyngine::Logger::Information, "EDGES: %s", gEdges ? "ON" : "OFF");
+}
+
+void MoreBlurPasses() {
+	gBlurPasses = std::min(gBlurPasses + 1, cMaxBlurPasses);
+	Log(tinyngine::Logger::Information, "BLUR PASSES: %u", gBlurPasses * 2);
+}
+
+void FewerBlurPasses() {
+	gBlurPasses = std::max(gBlurPasses - 1, 1u);
+	Log(tinyngine::Logger::Information, "BLUR PASSES: %u", gBlurPasses * 2);
+}
+
+ShaderProgramHandle CreateProgram(const char* vertexShader, const char* fragmentShader) {
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString(vertexShader, params.mVertexShaderData);
+	StringUtils::ReadFileToString(fragmentShader, params.mFragmentShaderData);
+	ShaderProgramHandle handle = ShaderProgram_Create(params);
+	if (!handle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program %s", fragmentShader);
+	}
+	return handle;
+}
+
+void DrawScene(const FrameContext& context) {
+	PipelineState_ApplyDepth(DepthState());
+	PipelineState_ApplyBlend(BlendState());
+	glClearColor(0.02f, 0.02f, 0.03f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	const ShaderProgramHandle& program = context.mSceneProgram;
+	Texture_Bind(context.mDiffuse, 0);
+	Texture_Bind(context.mSpecular, 1);
+	ShaderProgram_Use(program);
+	ShaderProgram_SetInt(program, "u_material.diffuse", 0);
+	ShaderProgram_SetInt(program, "u_material.specular", 1);
+	ShaderProgram_SetFloat(program, "u_material.shininess", 32.0f);
+	// brighter than 1 so the bloom has something to pick
+	ShaderProgram_SetVec4(program, "u_light.direction", glm::vec4(context.mLightPosition, 1.0f));
+	ShaderProgram_SetVec3(program, "u_light.ambient", 0.02f, 0.02f, 0.02f);
+	ShaderProgram_SetVec3(program, "u_light.diffuse", 3.0f, 2.8f, 2.4f);
+	ShaderProgram_SetVec3(program, "u_light.specular", 4.0f, 4.0f, 4.0f);
+	ShaderProgram_SetFloat(program, "u_light.constant", 1.0f);
+	ShaderProgram_SetFloat(program, "u_light.linear", 0.09f);
+	ShaderProgram_SetFloat(program, "u_light.quadratic", 0.032f);
+	ShaderProgram_SetVec3(program, "u_viewPosition", gCamera.GetPosition());
+
+	for (uint32_t i = 0; i < cCubesCount; i++) {
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), cCubePositions[i]);
+		model = glm::rotate(model, glm::radians(20.0f * float(i)), glm::vec3(1.0f, 0.3f, 0.5f));
+		ShaderProgram_SetMat4(program, "u_model", model);
+		ShaderProgram_SetMat4(program, "u_modelView", context.mView * model);
+		ShaderProgram_SetMat4(program, "u_modelViewProj", context.mProjection * context.mView * model);
+		Mesh_Draw(context.mCube);
+	}
+
+	glm::mat4 model = glm::translate(glm::mat4(1.0f), context.mLightPosition);
+	model = glm::scale(model, glm::vec3(0.2f));
+	ShaderProgram_Use(context.mLightProgram);
+	ShaderProgram_SetMat4(context.mLightProgram, "u_modelViewProj", context.mProjection * context.mView * model);
+	Mesh_Draw(context.mCube);
+}
+
+// Declares the passes of a frame: the scene in HDR, edges found in its depth, a bloom made of a bright pass and
+// gBlurPasses separable blurs at half resolution, and the composite to the window. The edges and bloom passes are
+// always declared, the graph culls them when the composite does not read their result.
+void BuildFrame(FrameGraph& graph, const FrameContext& context) {
+	FrameGraph_Reset(graph);
+
+	FrameGraphTextureDesc colorDesc;
+	colorDesc.mWidth = context.mWidth;
+	colorDesc.mHeight = context.mHeight;
+	colorDesc.mFormat = TextureFormats::RGBA16F;
+	colorDesc.mFiltering = TextureFilteringMode::Bilinear;
+	FrameGraphTextureDesc depthDesc = colorDesc;
+	depthDesc.mFormat = TextureFormats::Depth24Stencil8;
+	depthDesc.mFiltering = TextureFilteringMode::Nearest;
+	FrameGraphTextureDesc edgesDesc = depthDesc;
+	edgesDesc.mFormat = TextureFormats::RGBA8;
+	FrameGraphTextureDesc halfDesc = colorDesc;
+	halfDesc.mWidth = std::max(context.mWidth / 2, 1u);
+	halfDesc.mHeight = std::max(context.mHeight / 2, 1u);
+	const glm::vec2 inverseHalfSize(1.0f / float(halfDesc.mWidth), 1.0f / float(halfDesc.mHeight));
+
+	const FrameGraphResource backbuffer = FrameGraph_ImportBackbuffer(graph, "backbuffer", context.mWidth, context.mHeight);
+	const FrameGraphResource sceneColor = FrameGraph_CreateTexture(graph, "scene color", colorDesc);
+	const FrameGraphResource sceneDepth = FrameGraph_CreateTexture(graph, "scene depth", depthDesc);
+	uint32_t pass = FrameGraph_AddPass(graph, "scene", [&context](const FrameGraph&) {
+		DrawScene(context);
+	});
+	FrameGraph_Write(graph, pass, sceneColor);
+	FrameGraph_Write(graph, pass, sceneDepth);
+
+	const FrameGraphResource edges = FrameGraph_CreateTexture(graph, "edges", edgesDesc);
+	pass = FrameGraph_AddPass(graph, "edges", [&context, sceneDepth](const FrameGraph& frame) {
+		const ShaderProgramHandle& program = context.mEdgesProgram;
+		PipelineState_Apply(context.mEdgesState);
+		Texture_Bind(FrameGraph_GetTexture(frame, sceneDepth), 0);
+		ShaderProgram_SetInt(program, "u_depth", 0);
+		ShaderProgram_SetVec2(program, "u_depthRange", glm::vec2(cNearPlane, cFarPlane));
+		Mesh_Draw(context.mFullscreen);
+	});
+	FrameGraph_Read(graph, pass, sceneDepth);
+	FrameGraph_Write(graph, pass, edges);
+
+	FrameGraphResource bloom = FrameGraph_CreateTexture(graph, "bright", halfDesc);
+	pass = FrameGraph_AddPass(graph, "bright", [&context, sceneColor, inverseHalfSize](const FrameGraph& frame) {
+		const ShaderProgramHandle& program = context.mBrightProgram;
+		PipelineState_Apply(context.mBrightState);
+		Texture_Bind(FrameGraph_GetTexture(frame, sceneColor), 0);
+		ShaderProgram_SetInt(program, "u_source", 0);
+		ShaderProgram_SetVec2(program, "u_inverseOutputSize", inverseHalfSize);
+		ShaderProgram_SetFloat(program, "u_threshold", cBloomThreshold);
+		Mesh_Draw(context.mFullscreen);
+	});
+	FrameGraph_Read(graph, pass, sceneColor);
+	FrameGraph_Write(graph, pass, bloom);
+
+	for (uint32_t i = 0; i < gBlurPasses * 2; i++) {
+		// every blur writes a new virtual texture, the graph aliases them to two physical ones
+		const glm::vec2 direction = (i % 2 == 0) ? glm::vec2(inverseHalfSize.x, 0.0f) : glm::vec2(0.0f, inverseHalfSize.y);
+		const FrameGraphResource source = bloom;
+		bloom = FrameGraph_CreateTexture(graph, "blur", halfDesc);
+		pass = FrameGraph_AddPass(graph, "blur", [&context, source, direction, inverseHalfSize](const FrameGraph& frame) {
+			const ShaderProgramHandle& program = context.mBlurProgram;
+			PipelineState_Apply(context.mBlurState);
+			Texture_Bind(FrameGraph_GetTexture(frame, source), 0);
+			ShaderProgram_SetInt(program, "u_source", 0);
+			ShaderProgram_SetVec2(program, "u_inverseOutputSize", inverseHalfSize);
+			ShaderProgram_SetVec2(program, "u_direction", direction);
+			Mesh_Draw(context.mFullscreen);
+		});
+		FrameGraph_Read(graph, pass, source);
+		FrameGraph_Write(graph, pass, bloom);
+	}
+
+	const bool useBloom = gBloom;
+	const bool useEdges = gEdges;
+	pass = FrameGraph_AddPass(graph, "composite", [&context, sceneColor, bloom, edges, useBloom, useEdges](const FrameGraph& frame) {
+		const ShaderProgramHandle& program = context.mCompositeProgram;
+		PipelineState_Apply(context.mCompositeState);
+		Texture_Bind(FrameGraph_GetTexture(frame, sceneColor), 0);
+		ShaderProgram_SetInt(program, "u_scene", 0);
+		if (useBloom) {
+			Texture_Bind(FrameGraph_GetTexture(frame, bloom), 1);
+		}
+		ShaderProgram_SetInt(program, "u_bloom", 1);
+		if (useEdges) {
+			Texture_Bind(FrameGraph_GetTexture(frame, edges), 2);
+		}
+		ShaderProgram_SetInt(program, "u_edges", 2);
+		ShaderProgram_SetVec2(program, "u_inverseOutputSize", glm::vec2(1.0f / float(context.mWidth), 1.0f / float(context.mHeight)));
+		ShaderProgram_SetInt(program, "u_useBloom", useBloom ? 1 : 0);
+		ShaderProgram_SetInt(program, "u_useEdges", useEdges ? 1 : 0);
+		ShaderProgram_SetFloat(program, "u_bloomIntensity", 0.6f);
+		ShaderProgram_SetFloat(program, "u_exposure", 1.0f);
+		Mesh_Draw(context.mFullscreen);
+	});
+	FrameGraph_Read(graph, pass, sceneColor);
+	if (useBloom) {
+		FrameGraph_Read(graph, pass, bloom);
+	}
+	if (useEdges) {
+		FrameGraph_Read(graph, pass, edges);
+	}
+	FrameGraph_Write(graph, pass, backbuffer);
+}
+
+int main() {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	// frame times are only meaningful without vsync
+	glfwSwapInterval(0);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_B, ToggleBloom);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_E, ToggleEdges);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_EQUAL, MoreBlurPasses);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_MINUS, FewerBlurPasses);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+	gViewportWidth = uint32_t(framebufferWidth);
+	gViewportHeight = uint32_t(framebufferHeight);
+
+	FrameContext context;
+	context.mSceneProgram = CreateProgram("06-lights.vs", "06-lights.fs");
+	context.mLightProgram = CreateProgram("dbg_light.vs", "dbg_light.fs");
+	context.mBrightProgram = CreateProgram("15-deferred_fullscreen.vs", "19-bright.fs");
+	context.mBlurProgram = CreateProgram("15-deferred_fullscreen.vs", "19-blur.fs");
+	context.mEdgesProgram = CreateProgram("15-deferred_fullscreen.vs", "19-edges.fs");
+	context.mCompositeProgram = CreateProgram("15-deferred_fullscreen.vs", "19-composite.fs");
+	if (!context.mSceneProgram.IsValid() || !context.mLightProgram.IsValid() || !context.mBrightProgram.IsValid() ||
+		!context.mBlurProgram.IsValid() || !context.mEdgesProgram.IsValid() || !context.mCompositeProgram.IsValid()) {
+		return 1;
+	}
+
+	context.mDiffuse = Texture_Create("container2.png", TextureFormats::RGB8);
+	context.mSpecular = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!context.mDiffuse.IsValid() || !context.mSpecular.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices, sizeof(vertices));
+
+	MeshParams cubeParams;
+	cubeParams.mVertexBuffers[0] = vertexBuffer;
+	cubeParams.mVertexBuffersCount = 1;
+	cubeParams.mAttributesCount = 3;
+	cubeParams.mAttributes[0].mLocation = 0;
+	cubeParams.mAttributes[0].mComponents = 3;
+	cubeParams.mAttributes[0].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[1].mLocation = 1;
+	cubeParams.mAttributes[1].mComponents = 3;
+	cubeParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	cubeParams.mAttributes[1].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[2].mLocation = 2;
+	cubeParams.mAttributes[2].mComponents = 2;
+	cubeParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	cubeParams.mAttributes[2].mStride = 8 * sizeof(float);
+	cubeParams.mVertexCount = 36;
+
+	context.mCube = Mesh_Create(cubeParams);
+
+	// one triangle covering the screen
+	const float fullscreen[] = { -1.0f, -1.0f, 3.0f, -1.0f, -1.0f, 3.0f };
+	BufferHandle fullscreenBuffer = Buffer_Create(BufferType::Vertex, fullscreen, sizeof(fullscreen));
+	MeshParams fullscreenParams;
+	fullscreenParams.mVertexBuffers[0] = fullscreenBuffer;
+	fullscreenParams.mVertexBuffersCount = 1;
+	fullscreenParams.mAttributesCount = 1;
+	fullscreenParams.mAttributes[0].mComponents = 2;
+	fullscreenParams.mAttributes[0].mStride = 2 * sizeof(float);
+	fullscreenParams.mVertexCount = 3;
+	context.mFullscreen = Mesh_Create(fullscreenParams);
+	if (!context.mCube.IsValid() || !context.mFullscreen.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create meshes");
+		return 1;
+	}
+
+	PipelineStateParams stateParams;
+	stateParams.mMesh = context.mFullscreen;
+	stateParams.mDepth.mTestEnable = false;
+	stateParams.mDepth.mWriteEnable = false;
+	stateParams.mProgram = context.mBrightProgram;
+	context.mBrightState = PipelineState_Create(stateParams);
+	stateParams.mProgram = context.mBlurProgram;
+	context.mBlurState = PipelineState_Create(stateParams);
+	stateParams.mProgram = context.mEdgesProgram;
+	context.mEdgesState = PipelineState_Create(stateParams);
+	stateParams.mProgram = context.mCompositeProgram;
+	context.mCompositeState = PipelineState_Create(stateParams);
+
+	FrameGraph graph;
+
+	gCamera.SetPosition(glm::vec3(0.0f, 0.0f, 3.0f));
+
+	double lastFrameTime = 0.0;
+	FrameStats stats;
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		processInput(window, deltaTime);
+
+		context.mWidth = std::max(gViewportWidth, 1u);
+		context.mHeight = std::max(gViewportHeight, 1u);
+		context.mView = gCamera.GetViewMatrix();
+		context.mProjection = glm::perspective(glm::radians(gCamera.GetFOV()), float(context.mWidth) / float(context.mHeight), cNearPlane, cFarPlane);
+		const float angle = float(std::fmod(currentFrameTime * 0.5, 6.283185307179586));
+		context.mLightPosition = glm::vec3(std::cos(angle) * 2.0f, 1.0f, std::sin(angle) * 2.0f - 1.0f);
+
+		BuildFrame(graph, context);
+		FrameGraph_Compile(graph);
+		FrameGraph_Execute(graph);
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		stats.mAccumulated += glfwGetTime() - currentFrameTime;
+		stats.mFrames++;
+		if (currentFrameTime - stats.mLastReport >= 2.0) {
+			const FrameGraphStats& graphStats = FrameGraph_GetStats(graph);
+			Log(tinyngine::Logger::Information, "%u passes (%u culled), %u transient textures in %u physical (%u pooled), %.2f MB instead of %.2f MB, %u invalidations, %.3f ms/frame",
+				graphStats.mPasses, graphStats.mCulledPasses, graphStats.mTransientTextures, graphStats.mPhysicalTextures, graphStats.mPooledTextures,
+				double(graphStats.mPhysicalBytes) / (1024.0 * 1024.0), double(graphStats.mTransientBytes) / (1024.0 * 1024.0), graphStats.mInvalidations,
+				stats.mAccumulated * 1000.0 / stats.mFrames);
+			stats = FrameStats();
+			stats.mLastReport = currentFrameTime;
+		}
+	}
+
+	FrameGraph_Destroy(graph);
+	PipelineState_Destroy(context.mCompositeState);
+	PipelineState_Destroy(context.mEdgesState);
+	PipelineState_Destroy(context.mBlurState);
+	PipelineState_Destroy(context.mBrightState);
+	Mesh_Destroy(context.mFullscreen);
+	Mesh_Destroy(context.mCube);
+	Buffer_Destroy(fullscreenBuffer);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(context.mSpecular);
+	Texture_Destroy(context.mDiffuse);
+	ShaderProgram_Destroy(context.mCompositeProgram);
+	ShaderProgram_Destroy(context.mEdgesProgram);
+	ShaderProgram_Destroy(context.mBlurProgram);
+	ShaderProgram_Destroy(context.mBrightProgram);
+	ShaderProgram_Destroy(context.mLightProgram);
+	ShaderProgram_Destroy(context.mSceneProgram);
+
+	glfwTerminate();
+	return 0;
+}
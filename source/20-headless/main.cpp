@@ -0,0 +1,333 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Context.h"
+#include "FrameLoop.h"
+#include "GLRecorder.h"
+#include "GpuTimer.h"
+#include "Mesh.h"
+#include "PipelineState.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+constexpr uint32_t cDefaultFrames = 600;
+constexpr uint32_t cDefaultWarmupFrames = 30;
+constexpr uint32_t cDefaultCubesSide = 24;			// cubes per side of the grid
+constexpr uint32_t cMaxCubesSide = 128;
+constexpr float cCubesSpacing = 1.6f;
+constexpr double cFrameDelta = 1.0 / 60.0;			// animation step, frame times do not drive it so runs are repeatable
+constexpr uint32_t cLoggedEntryPoints = 12;
+
+struct BenchmarkParams {
+	ContextParams mContext;
+	uint32_t mFrames = cDefaultFrames;
+	uint32_t mWarmupFrames = cDefaultWarmupFrames;
+	uint32_t mCubesSide = cDefaultCubesSide;
+};
+
+// Milliseconds of every measured frame, summarized once the run is over.
+struct BenchmarkSamples {
+	std::vector<double> mCpu;
+	std::vector<double> mGpu;
+};
+
+struct BenchmarkSummary {
+	double mAverage = 0.0;
+	double mMinimum = 0.0;
+	double mMedian = 0.0;
+	double mPercentile95 = 0.0;
+	double mMaximum = 0.0;
+};
+
+}
+
+void PrintUsage() {
+	Log(tinyngine::Logger::Information, "usage: 20-headless [--backend window|egl|egl-pbuffer|osmesa|null] [--frames N] [--warmup N] [--size WxH] [--cubes N] [--record] [--stream file]");
+}
+
+bool ParseArguments(int argc, char** argv, BenchmarkParams& params) {
+	params.mContext.mBackend = ContextBackend::EglSurfaceless;
+	params.mContext.mVsync = false;
+	for (int i = 1; i < argc; i++) {
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--backend") == 0 && hasValue) {
+			if (!Context_ParseBackend(argv[++i], params.mContext.mBackend)) {
+				Log(tinyngine::Logger::Error, "Unknown backend %s", argv[i]);
+				return false;
+			}
+		} else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+			params.mFrames = std::max(uint32_t(std::strtoul(argv[++i], nullptr, 10)), 1u);
+		} else if (std::strcmp(argv[i], "--warmup") == 0 && hasValue) {
+			params.mWarmupFrames = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		} else if (std::strcmp(argv[i], "--size") == 0 && hasValue) {
+			char* separator = nullptr;
+			params.mContext.mWidth = uint32_t(std::strtoul(argv[++i], &separator, 10));
+			params.mContext.mHeight = (*separator == 'x') ? uint32_t(std::strtoul(separator + 1, nullptr, 10)) : 0;
+			if (params.mContext.mWidth == 0 || params.mContext.mHeight == 0) {
+				Log(tinyngine::Logger::Error, "Invalid size %s", argv[i]);
+				return false;
+			}
+		} else if (std::strcmp(argv[i], "--cubes") == 0 && hasValue) {
+			params.mCubesSide = std::min(std::max(uint32_t(std::strtoul(argv[++i], nullptr, 10)), 1u), cMaxCubesSide);
+		} else if (std::strcmp(argv[i], "--record") == 0) {
+			params.mContext.mRecordCalls = true;
+		} else if (std::strcmp(argv[i], "--stream") == 0 && hasValue) {
+			params.mContext.mRecordCalls = true;
+			params.mContext.mRecordStream = argv[++i];
+		} else {
+			PrintUsage();
+			return false;
+		}
+	}
+	return true;
+}
+
+BenchmarkSummary Summarize(std::vector<double> samples) {
+	BenchmarkSummary summary;
+	if (samples.empty()) {
+		return summary;
+	}
+	std::sort(samples.begin(), samples.end());
+	double total = 0.0;
+	for (double sample : samples) {
+		total += sample;
+	}
+	summary.mAverage = total / double(samples.size());
+	summary.mMinimum = samples.front();
+	summary.mMedian = samples[samples.size() / 2];
+	summary.mPercentile95 = samples[std::min(size_t(double(samples.size()) * 0.95), samples.size() - 1)];
+	summary.mMaximum = samples.back();
+	return summary;
+}
+
+ShaderProgramHandle CreateProgram(const char* vertexShader, const char* fragmentShader) {
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString(vertexShader, params.mVertexShaderData);
+	StringUtils::ReadFileToString(fragmentShader, params.mFragmentShaderData);
+	ShaderProgramHandle handle = ShaderProgram_Create(params);
+	if (!handle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program %s", fragmentShader);
+	}
+	return handle;
+}
+
+// Renders the 06-lights material on a grid of spinning cubes for a fixed number of frames, into the window or into
+// the backbuffer target of a headless context, then prints the frame time distribution. The last line has a fixed
+// key=value layout meant to be collected by CI jobs. With the null backend of TINYNGINE_GL_RECORDER builds nothing
+// is rendered, the frame times are the CPU cost of the submission code alone; --record counts the calls on the
+// other backends.
+int main(int argc, char** argv) {
+	BenchmarkParams benchmark;
+	if (!ParseArguments(argc, argv, benchmark)) {
+		return 1;
+	}
+
+	Context context;
+	if (!Context_Create(context, benchmark.mContext)) {
+		Log(tinyngine::Logger::Error, "Failed to create the %s context", Context_GetBackendName(benchmark.mContext.mBackend));
+		return 1;
+	}
+	Context_LogInfo(context);
+
+	ShaderProgramHandle programHandle = CreateProgram("06-lights.vs", "06-lights.fs");
+	if (!programHandle.IsValid()) {
+		Context_Destroy(context);
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid() || !textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		Context_Destroy(context);
+		return 1;
+	}
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices, sizeof(vertices));
+
+	MeshParams cubeParams;
+	cubeParams.mVertexBuffers[0] = vertexBuffer;
+	cubeParams.mVertexBuffersCount = 1;
+	cubeParams.mAttributesCount = 3;
+	cubeParams.mAttributes[0].mLocation = 0;
+	cubeParams.mAttributes[0].mComponents = 3;
+	cubeParams.mAttributes[0].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[1].mLocation = 1;
+	cubeParams.mAttributes[1].mComponents = 3;
+	cubeParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	cubeParams.mAttributes[1].mStride = 8 * sizeof(float);
+	cubeParams.mAttributes[2].mLocation = 2;
+	cubeParams.mAttributes[2].mComponents = 2;
+	cubeParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	cubeParams.mAttributes[2].mStride = 8 * sizeof(float);
+	cubeParams.mVertexCount = 36;
+
+	MeshHandle meshHandle = Mesh_Create(cubeParams);
+
+	PipelineStateParams stateParams;
+	stateParams.mProgram = programHandle;
+	stateParams.mMesh = meshHandle;
+	PipelineStateHandle stateHandle = PipelineState_Create(stateParams);
+
+	GpuTimer gpuTimer;
+	GpuTimer_Create(gpuTimer);
+
+	const uint32_t width = benchmark.mContext.mWidth;
+	const uint32_t height = benchmark.mContext.mHeight;
+	const uint32_t cubesSide = benchmark.mCubesSide;
+	const float gridExtent = float(cubesSide - 1) * cCubesSpacing;
+	const glm::vec3 eye(0.0f, gridExtent * 0.6f + 4.0f, gridExtent * 0.75f + 4.0f);
+	const glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const glm::mat4 projection = glm::perspective(glm::radians(45.0f), float(width) / float(height), 0.1f, gridExtent * 3.0f + 20.0f);
+
+	BenchmarkSamples samples;
+	samples.mCpu.reserve(benchmark.mFrames);
+	samples.mGpu.reserve(benchmark.mFrames);
+	const uint32_t framesCount = benchmark.mWarmupFrames + benchmark.mFrames;
+	uint32_t frame = 0;
+	const double startTime = FrameLoop_GetTime();
+	for (; frame < framesCount && !Context_ShouldClose(context); frame++) {
+		const double frameStart = FrameLoop_GetTime();
+		if (frame == benchmark.mWarmupFrames) {
+			GLRecorder_ResetStats();
+		}
+		const float time = float(double(frame) * cFrameDelta);
+
+		GpuTimer_Begin(gpuTimer);
+		RenderTarget_BindDefault(width, height);
+		glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		PipelineState_Apply(stateHandle);
+		Texture_Bind(textureHandle1, 0);
+		Texture_Bind(textureHandle2, 1);
+		ShaderProgram_SetInt(programHandle, "u_material.diffuse", 0);
+		ShaderProgram_SetInt(programHandle, "u_material.specular", 1);
+		ShaderProgram_SetFloat(programHandle, "u_material.shininess", 32.0f);
+		const glm::vec4 lightPosition(std::cos(time) * gridExtent * 0.5f, 3.0f, std::sin(time) * gridExtent * 0.5f, 1.0f);
+		ShaderProgram_SetVec4(programHandle, "u_light.direction", lightPosition);
+		ShaderProgram_SetVec3(programHandle, "u_light.ambient", 0.05f, 0.05f, 0.05f);
+		ShaderProgram_SetVec3(programHandle, "u_light.diffuse", 1.0f, 1.0f, 0.8f);
+		ShaderProgram_SetVec3(programHandle, "u_light.specular", 1.0f, 1.0f, 1.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.constant", 1.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.linear", 0.007f);
+		ShaderProgram_SetFloat(programHandle, "u_light.quadratic", 0.0002f);
+		ShaderProgram_SetVec3(programHandle, "u_viewPosition", eye);
+
+		for (uint32_t z = 0; z < cubesSide; z++) {
+			for (uint32_t x = 0; x < cubesSide; x++) {
+				const glm::vec3 position(float(x) * cCubesSpacing - gridExtent * 0.5f, 0.0f, float(z) * cCubesSpacing - gridExtent * 0.5f);
+				glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+				model = glm::rotate(model, time + float(x * 7 + z * 13), glm::vec3(1.0f, 0.3f, 0.5f));
+				ShaderProgram_SetMat4(programHandle, "u_model", model);
+				ShaderProgram_SetMat4(programHandle, "u_modelView", view * model);
+				ShaderProgram_SetMat4(programHandle, "u_modelViewProj", projection * view * model);
+				Mesh_Draw(meshHandle);
+			}
+		}
+		GpuTimer_End(gpuTimer);
+
+		Context_EndFrame(context);
+
+		if (frame >= benchmark.mWarmupFrames) {
+			samples.mCpu.push_back((FrameLoop_GetTime() - frameStart) * 1000.0);
+		}
+		// the timer results are cGpuTimerQueries frames old, the first ones are skipped even without warm up
+		if (frame >= std::max(benchmark.mWarmupFrames, 2 * cGpuTimerQueries)) {
+			samples.mGpu.push_back(GpuTimer_GetMilliseconds(gpuTimer));
+		}
+	}
+	const double totalTime = FrameLoop_GetTime() - startTime;
+
+	const BenchmarkSummary cpu = Summarize(samples.mCpu);
+	const BenchmarkSummary gpu = Summarize(samples.mGpu);
+	const uint32_t measured = uint32_t(samples.mCpu.size());
+	Log(tinyngine::Logger::Information, "%u frames (%u warm up) of %u cubes at %ux%u in %.2f s", frame, std::min(frame, benchmark.mWarmupFrames),
+		cubesSide * cubesSide, width, height, totalTime);
+	Log(tinyngine::Logger::Information, "frame: avg %.3f ms, min %.3f, median %.3f, p95 %.3f, max %.3f, %.1f fps",
+		cpu.mAverage, cpu.mMinimum, cpu.mMedian, cpu.mPercentile95, cpu.mMaximum, (cpu.mAverage > 0.0) ? 1000.0 / cpu.mAverage : 0.0);
+	Log(tinyngine::Logger::Information, "gpu: avg %.3f ms, min %.3f, median %.3f, p95 %.3f, max %.3f",
+		gpu.mAverage, gpu.mMinimum, gpu.mMedian, gpu.mPercentile95, gpu.mMaximum);
+	// the recorder counters are appended per frame, so that the driver overhead of the submission code is tracked too
+	char recorded[256] = "";
+	if (GLRecorder_IsActive()) {
+		GLRecorder_LogStats(measured, cLoggedEntryPoints);
+		const GLRecorderStats& calls = GLRecorder_GetStats();
+		const double frames = double(std::max(measured, 1u));
+		snprintf(recorded, sizeof(recorded), " gl_calls=%.1f gl_draws=%.1f gl_bytes=%.0f gl_redundant_binds=%.1f gl_redundant_uniforms=%.1f",
+			double(calls.mCalls) / frames, double(calls.mDrawCalls) / frames, double(calls.mBytesUploaded) / frames,
+			double(calls.mRedundantBinds) / frames, double(calls.mRedundantUniforms) / frames);
+	}
+	Log(tinyngine::Logger::Information, "RESULT backend=%s frames=%u width=%u height=%u cubes=%u cpu_avg_ms=%.4f cpu_median_ms=%.4f cpu_p95_ms=%.4f gpu_avg_ms=%.4f gpu_median_ms=%.4f%s",
+		Context_GetBackendName(benchmark.mContext.mBackend), measured, width, height, cubesSide * cubesSide, cpu.mAverage, cpu.mMedian,
+		cpu.mPercentile95, gpu.mAverage, gpu.mMedian, recorded);
+
+	GpuTimer_Destroy(gpuTimer);
+	PipelineState_Destroy(stateHandle);
+	Mesh_Destroy(meshHandle);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(programHandle);
+
+	Context_Destroy(context);
+	return (measured > 0) ? 0 : 1;
+}
@@ -0,0 +1,348 @@
+#include "CommonDefine.h"
+#include "FrameLoop.h"
+#include "JobSystem.h"
+#include "Log.h"
+#include "SoftRaster.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+
+constexpr uint32_t cDefaultWidth = 800;
+constexpr uint32_t cDefaultHeight = 600;
+constexpr uint32_t cDefaultFrames = 120;
+constexpr uint32_t cCubesCount = 10;
+constexpr uint32_t cVertexStride = 8;				// position, normal, texture coordinates
+constexpr uint32_t cCubeVertexCount = 36;
+constexpr float cFrameDelta = 1.0f / 60.0f;			// animation step, frame times do not drive it so images are repeatable
+
+struct SoftRasterParams {
+	uint32_t mWidth = cDefaultWidth;
+	uint32_t mHeight = cDefaultHeight;
+	uint32_t mFrames = cDefaultFrames;
+	uint32_t mThreads = 0;							// one per hardware thread
+	TextureFilteringMode::Enum mFiltering = TextureFilteringMode::Trilinear;
+	bool mPointLight = false;						// directional light by default, as 06-lights
+	const char* mOutput = "21-softraster.ppm";
+};
+
+// Uniforms of 06-lights.vs and 06-lights.fs, captured by value by the shaders of each draw.
+struct LightsUniforms {
+	glm::mat4 mModel;
+	glm::mat3 mNormalMatrix;						// mat3(transpose(inverse(u_modelView)))
+	glm::mat4 mModelViewProj;
+	glm::vec3 mViewPosition;
+	glm::vec4 mLightDirection;						// w = 0 for a directional light
+	glm::vec3 mLightAmbient;
+	glm::vec3 mLightDiffuse;
+	glm::vec3 mLightSpecular;
+	float mLightConstant;
+	float mLightLinear;
+	float mLightQuadratic;
+	float mShininess;
+};
+
+// Varyings of 06-lights.vs, in the order the vertex shader writes them.
+struct LightsVaryings {
+	enum Enum {
+		TexcoordU,
+		TexcoordV,
+		ModelPositionX,
+		ModelPositionY,
+		ModelPositionZ,
+		NormalX,
+		NormalY,
+		NormalZ,
+
+		Count
+	};
+};
+
+const char* cFilteringNames[TextureFilteringMode::Count] = { "none", "nearest", "bilinear", "trilinear" };
+
+SoftTexture gDiffuse;
+SoftTexture gSpecular;
+
+}
+
+void PrintUsage() {
+	Log(tinyngine::Logger::Information, "usage: 21-softraster [--size WxH] [--frames N] [--threads N] [--filter nearest|bilinear|trilinear] [--light directional|point] [--output file.ppm]");
+}
+
+bool ParseArguments(int argc, char** argv, SoftRasterParams& params) {
+	for (int i = 1; i < argc; i++) {
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--size") == 0 && hasValue) {
+			char* separator = nullptr;
+			params.mWidth = uint32_t(std::strtoul(argv[++i], &separator, 10));
+			params.mHeight = (*separator == 'x') ? uint32_t(std::strtoul(separator + 1, nullptr, 10)) : 0;
+			if (params.mWidth == 0 || params.mHeight == 0 || params.mWidth > cSoftMaxTargetSize || params.mHeight > cSoftMaxTargetSize) {
+				Log(tinyngine::Logger::Error, "Invalid size %s, at most %ux%u", argv[i], cSoftMaxTargetSize, cSoftMaxTargetSize);
+				return false;
+			}
+		} else if (std::strcmp(argv[i], "--frames") == 0 && hasValue) {
+			params.mFrames = std::max(uint32_t(std::strtoul(argv[++i], nullptr, 10)), 1u);
+		} else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+			params.mThreads = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		} else if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+			++i;
+			uint32_t mode = TextureFilteringMode::Nearest;
+			while (mode < TextureFilteringMode::Count && std::strcmp(argv[i], cFilteringNames[mode]) != 0) {
+				mode++;
+			}
+			if (mode == TextureFilteringMode::Count) {
+				Log(tinyngine::Logger::Error, "Unknown filter %s", argv[i]);
+				return false;
+			}
+			params.mFiltering = TextureFilteringMode::Enum(mode);
+		} else if (std::strcmp(argv[i], "--light") == 0 && hasValue) {
+			++i;
+			if (std::strcmp(argv[i], "point") != 0 && std::strcmp(argv[i], "directional") != 0) {
+				Log(tinyngine::Logger::Error, "Unknown light %s", argv[i]);
+				return false;
+			}
+			params.mPointLight = std::strcmp(argv[i], "point") == 0;
+		} else if (std::strcmp(argv[i], "--output") == 0 && hasValue) {
+			params.mOutput = argv[++i];
+		} else {
+			PrintUsage();
+			return false;
+		}
+	}
+	return true;
+}
+
+// 06-lights.vs
+void LightsVertexShader(const LightsUniforms& uniforms, const float* attributes, SoftVertex& output) {
+	const glm::vec4 position(attributes[0], attributes[1], attributes[2], 1.0f);
+	const glm::vec3 normal(attributes[3], attributes[4], attributes[5]);
+
+	const glm::vec3 modelPosition = glm::vec3(uniforms.mModel * position);
+	const glm::vec3 viewNormal = uniforms.mNormalMatrix * normal;
+	float* varyings = output.mVaryings;
+	varyings[LightsVaryings::TexcoordU] = attributes[6];
+	varyings[LightsVaryings::TexcoordV] = attributes[7];
+	varyings[LightsVaryings::ModelPositionX] = modelPosition.x;
+	varyings[LightsVaryings::ModelPositionY] = modelPosition.y;
+	varyings[LightsVaryings::ModelPositionZ] = modelPosition.z;
+	varyings[LightsVaryings::NormalX] = viewNormal.x;
+	varyings[LightsVaryings::NormalY] = viewNormal.y;
+	varyings[LightsVaryings::NormalZ] = viewNormal.z;
+	output.mPosition = uniforms.mModelViewProj * position;
+}
+
+// 06-lights.fs, one quad at a time so that the texture fetches get their level of detail from the quad.
+void LightsFragmentShader(const LightsUniforms& uniforms, const SoftFragmentQuad& quad, glm::vec4* colors) {
+	glm::vec4 diffuseTexels[4];
+	glm::vec4 specularTexels[4];
+	SoftTexture_SampleQuad(gDiffuse, quad.mVaryings[LightsVaryings::TexcoordU], quad.mVaryings[LightsVaryings::TexcoordV], diffuseTexels);
+	SoftTexture_SampleQuad(gSpecular, quad.mVaryings[LightsVaryings::TexcoordU], quad.mVaryings[LightsVaryings::TexcoordV], specularTexels);
+
+	for (uint32_t lane = 0; lane < 4; lane++) {
+		if ((quad.mMask & (1u << lane)) == 0) {
+			continue;
+		}
+		const glm::vec3 modelPosition(quad.mVaryings[LightsVaryings::ModelPositionX][lane], quad.mVaryings[LightsVaryings::ModelPositionY][lane],
+			quad.mVaryings[LightsVaryings::ModelPositionZ][lane]);
+		const glm::vec3 norm = glm::normalize(glm::vec3(quad.mVaryings[LightsVaryings::NormalX][lane], quad.mVaryings[LightsVaryings::NormalY][lane],
+			quad.mVaryings[LightsVaryings::NormalZ][lane]));
+		const glm::vec3 viewDir = glm::normalize(uniforms.mViewPosition - modelPosition);
+
+		float attenuation = 1.0f;
+		glm::vec3 lightDir;
+		if (uniforms.mLightDirection.w == 0.0f) {
+			lightDir = glm::normalize(-glm::vec3(uniforms.mLightDirection));
+		} else {
+			lightDir = glm::normalize(glm::vec3(uniforms.mLightDirection) - modelPosition);
+			const float distance = glm::length(glm::vec3(uniforms.mLightDirection) - modelPosition);
+			attenuation = 1.0f / (uniforms.mLightConstant + uniforms.mLightLinear * distance + uniforms.mLightQuadratic * (distance * distance));
+		}
+
+		// diffuse
+		const float diff = std::max(glm::dot(norm, lightDir), 0.0f);
+		const glm::vec3 diffuse = uniforms.mLightDiffuse * diff * glm::vec3(diffuseTexels[lane]);
+
+		// specular
+		const glm::vec3 reflectDir = glm::reflect(-lightDir, norm);
+		const float spec = std::pow(std::max(glm::dot(viewDir, reflectDir), 0.0f), uniforms.mShininess);
+		const glm::vec3 specular = uniforms.mLightSpecular * spec * glm::vec3(specularTexels[lane]);
+
+		const glm::vec3 result = (uniforms.mLightAmbient + diffuse + specular) * attenuation;
+		colors[lane] = glm::vec4(result, 1.0f);
+	}
+}
+
+// Renders the 06-lights scene with the CPU rasterizer, no GL context involved, then reports the throughput and
+// writes the last frame as a reference image. Images do not depend on --threads.
+int main(int argc, char** argv) {
+	SoftRasterParams params;
+	if (!ParseArguments(argc, argv, params)) {
+		return 1;
+	}
+
+	if (!SoftTexture_Create(gDiffuse, "container2.png") || !SoftTexture_Create(gSpecular, "container2_specular.png")) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+	gDiffuse.mFiltering = params.mFiltering;
+	gSpecular.mFiltering = params.mFiltering;
+
+	Job_Initialize(params.mThreads);
+	const uint32_t threadsCount = Job_GetThreadsCount();
+
+	float vertices[] = {
+		// positions          // normals           // texture coords
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f,  0.0f,
+
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f,  1.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f,  0.0f,
+
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		-0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f,  0.0f,
+
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f,  1.0f,
+
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f,
+		0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  1.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f,  0.0f,
+		-0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  0.0f,
+		-0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f,  1.0f
+	};
+	// positions all containers
+	const glm::vec3 cubePositions[cCubesCount] = {
+		glm::vec3(0.0f,  0.0f,  0.0f),
+		glm::vec3(2.0f,  5.0f, -15.0f),
+		glm::vec3(-1.5f, -2.2f, -2.5f),
+		glm::vec3(-3.8f, -2.0f, -12.3f),
+		glm::vec3(2.4f, -0.4f, -3.5f),
+		glm::vec3(-1.7f,  3.0f, -7.5f),
+		glm::vec3(1.3f, -2.0f, -2.5f),
+		glm::vec3(1.5f,  2.0f, -2.5f),
+		glm::vec3(1.5f,  0.2f, -1.5f),
+		glm::vec3(-1.3f,  1.0f, -1.5f)
+	};
+
+	SoftRaster raster;
+	SoftRaster_Initialize(raster, params.mWidth, params.mHeight);
+
+	const glm::vec3 eye(0.0f, 0.0f, 3.0f);
+	const glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	const glm::mat4 projection = glm::perspective(glm::radians(45.0f), float(params.mWidth) / float(params.mHeight), 0.1f, 100.0f);
+
+	LightsUniforms uniforms;
+	uniforms.mViewPosition = eye;
+	uniforms.mLightAmbient = glm::vec3(0.01f, 0.01f, 0.01f);
+	uniforms.mLightDiffuse = glm::vec3(1.0f, 1.0f, 0.8f);
+	uniforms.mLightSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
+	uniforms.mLightConstant = 1.0f;
+	uniforms.mLightLinear = 0.09f;
+	uniforms.mLightQuadratic = 0.032f;
+	uniforms.mShininess = 32.0f;
+
+	SoftDraw cubeDraw;
+	cubeDraw.mVertices = vertices;
+	cubeDraw.mStride = cVertexStride;
+	cubeDraw.mVertexCount = cCubeVertexCount;
+	cubeDraw.mVaryingsCount = LightsVaryings::Count;
+	// no culling, as 06-lights: the winding of the cube faces is not consistent
+
+	SoftDraw lightDraw = cubeDraw;
+	lightDraw.mVaryingsCount = 0;
+	// dbg_light.fs
+	lightDraw.mFragmentShader = [](const SoftFragmentQuad& quad, glm::vec4* colors) {
+		TINYNGINE_UNUSED(quad);
+		for (uint32_t lane = 0; lane < 4; lane++) {
+			colors[lane] = glm::vec4(1.0f);
+		}
+	};
+
+	const double startTime = FrameLoop_GetTime();
+	for (uint32_t frame = 0; frame < params.mFrames; frame++) {
+		const float time = float(frame) * cFrameDelta;
+		const glm::vec4 lightPosition(std::cos(time) * 2.0f, 1.0f, std::sin(time) * 2.0f - 1.5f, 1.0f);
+		uniforms.mLightDirection = params.mPointLight ? lightPosition : glm::vec4(-0.2f, -1.0f, -0.3f, 0.0f);
+
+		SoftRaster_Begin(raster, glm::vec4(0.2f, 0.3f, 0.3f, 1.0f));
+		for (uint32_t i = 0; i < cCubesCount; i++) {
+			const float angle = 20.0f * float(i) + time * 30.0f;
+			uniforms.mModel = glm::translate(glm::mat4(1.0f), cubePositions[i]);
+			uniforms.mModel = glm::rotate(uniforms.mModel, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+			uniforms.mNormalMatrix = glm::mat3(glm::transpose(glm::inverse(view * uniforms.mModel)));
+			uniforms.mModelViewProj = projection * view * uniforms.mModel;
+			cubeDraw.mVertexShader = [uniforms](const float* attributes, SoftVertex& output) {
+				LightsVertexShader(uniforms, attributes, output);
+			};
+			cubeDraw.mFragmentShader = [uniforms](const SoftFragmentQuad& quad, glm::vec4* colors) {
+				LightsFragmentShader(uniforms, quad, colors);
+			};
+			SoftRaster_Draw(raster, cubeDraw);
+		}
+
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(lightPosition));
+		model = glm::scale(model, glm::vec3(0.2f));
+		const glm::mat4 lightModelViewProj = projection * view * model;
+		lightDraw.mVertexShader = [lightModelViewProj](const float* attributes, SoftVertex& output) {
+			output.mPosition = lightModelViewProj * glm::vec4(attributes[0], attributes[1], attributes[2], 1.0f);
+		};
+		SoftRaster_Draw(raster, lightDraw);
+
+		SoftRaster_Flush(raster, threadsCount);
+	}
+	const double totalTime = FrameLoop_GetTime() - startTime;
+
+	const SoftRasterStats& stats = SoftRaster_GetStats(raster);
+	const double frames = double(params.mFrames);
+	const double setupMilliseconds = stats.mSetupMilliseconds / frames;
+	const double rasterMilliseconds = stats.mRasterMilliseconds / frames;
+	const double megaPixels = (stats.mRasterMilliseconds > 0.0) ? double(stats.mShadedPixels) / (stats.mRasterMilliseconds * 1000.0) : 0.0;
+	const double frameMilliseconds = stats.mSetupMilliseconds + stats.mRasterMilliseconds;
+	const double triangles = (frameMilliseconds > 0.0) ? double(stats.mRasterizedTriangles) * 1000.0 / frameMilliseconds : 0.0;
+	Log(tinyngine::Logger::Information, "%u frames at %ux%u, %u threads, %s filtering, %s light, in %.2f s", params.mFrames, params.mWidth,
+		params.mHeight, threadsCount, cFilteringNames[params.mFiltering], params.mPointLight ? "point" : "directional", totalTime);
+	Log(tinyngine::Logger::Information, "per frame: setup %.3f ms, raster %.3f ms, %.0f triangles (%.0f binned), %.0f pixels shaded",
+		setupMilliseconds, rasterMilliseconds, double(stats.mRasterizedTriangles) / frames, double(stats.mBinnedTriangles) / frames,
+		double(stats.mShadedPixels) / frames);
+	Log(tinyngine::Logger::Information, "RESULT threads=%u width=%u height=%u setup_ms=%.4f raster_ms=%.4f mpix_per_s=%.2f tris_per_s=%.0f",
+		threadsCount, params.mWidth, params.mHeight, setupMilliseconds, rasterMilliseconds, megaPixels, triangles);
+
+	const bool saved = SoftRaster_SaveImage(raster, params.mOutput);
+	if (saved) {
+		Log(tinyngine::Logger::Information, "last frame written to %s", params.mOutput);
+	}
+
+	Job_Shutdown();
+	return saved ? 0 : 1;
+}
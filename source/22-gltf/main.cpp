@@ -0,0 +1,235 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "GltfLoader.h"
+#include "InputManager.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+bool gRotate = true;
+
+Camera gCamera;
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void ToggleRotation() {
+	gRotate = !gRotate;
+	Log(tinyngine::Logger::Information, "ROTATION: %s", gRotate ? "on" : "off");
+}
+
+// Loads a binary glTF file, the one given on the command line or the sample model, and draws its default scene with
+// the 06-lights shading. Materials without a diffuse or specular texture use the container ones.
+int main(int argc, char** argv) {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+	const char* filename = (argc > 1) ? argv[1] : "22-gltf.glb";
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_R, ToggleRotation);
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString("06-lights.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("06-lights.fs", params.mFragmentShaderData);
+	ShaderProgramHandle programHandle = ShaderProgram_Create(params);
+	if (!programHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	TextureHandle defaultDiffuse = Texture_Create("container2.png", TextureFormats::RGB8);
+	TextureHandle defaultSpecular = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!defaultDiffuse.IsValid() || !defaultSpecular.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	GltfModel model;
+	if (!Gltf_LoadBinary(filename, model)) {
+		Log(tinyngine::Logger::Error, "Failed to load %s", filename);
+		return 1;
+	}
+	for (Material& material : model.mMaterials) {
+		if (!material.mDiffuse.IsValid()) {
+			material.mDiffuse = defaultDiffuse;
+		}
+		if (!material.mSpecular.IsValid()) {
+			material.mSpecular = defaultSpecular;
+		}
+	}
+	Material defaultMaterial;
+	defaultMaterial.mDiffuse = defaultDiffuse;
+	defaultMaterial.mSpecular = defaultSpecular;
+
+	// frames the scene bounds, from the corners of every drawable bounding box
+	glm::vec3 sceneMin(FLT_MAX);
+	glm::vec3 sceneMax(-FLT_MAX);
+	for (const GltfDrawable& drawable : model.mDrawables) {
+		const GltfPrimitive& primitive = model.mPrimitives[drawable.mPrimitive];
+		for (uint32_t corner = 0; corner < 8; corner++) {
+			glm::vec3 local((corner & 1) ? primitive.mBoundsMax.x : primitive.mBoundsMin.x,
+				(corner & 2) ? primitive.mBoundsMax.y : primitive.mBoundsMin.y,
+				(corner & 4) ? primitive.mBoundsMax.z : primitive.mBoundsMin.z);
+			glm::vec3 world = glm::vec3(drawable.mTransform * glm::vec4(local, 1.0f));
+			sceneMin = glm::min(sceneMin, world);
+			sceneMax = glm::max(sceneMax, world);
+		}
+	}
+	if (model.mDrawables.empty()) {
+		sceneMin = glm::vec3(-1.0f);
+		sceneMax = glm::vec3(1.0f);
+	}
+	const glm::vec3 sceneCenter = (sceneMin + sceneMax) * 0.5f;
+	const float sceneRadius = std::max(glm::length(sceneMax - sceneMin) * 0.5f, 0.01f);
+
+	gCamera.SetPosition(sceneCenter + glm::vec3(0.0f, 0.0f, sceneRadius * 2.5f));
+
+	glm::vec4 lightDirection(-0.2f, -1.0f, -0.3f, 0.0);
+	double lastFrameTime = 0.0;
+	float rotationAngle = 0.0f;
+	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
+
+	glEnable(GL_DEPTH_TEST);
+
+	glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, sceneRadius * 0.01f, sceneRadius * 10.0f);
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		processInput(window, deltaTime);
+
+		if (gRotate) {
+			rotationAngle += deltaTime * 0.5f;
+		}
+		glm::mat4 view = gCamera.GetViewMatrix();
+		glm::mat4 sceneTransform = glm::translate(glm::mat4(1.0f), sceneCenter);
+		sceneTransform = glm::rotate(sceneTransform, rotationAngle, glm::vec3(0.0f, 1.0f, 0.0f));
+		sceneTransform = glm::translate(sceneTransform, -sceneCenter);
+
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		ShaderProgram_Use(programHandle);
+		ShaderProgram_SetVec4(programHandle, "u_light.direction", lightDirection);
+		ShaderProgram_SetVec3(programHandle, "u_light.ambient", 0.1f, 0.1f, 0.1f);
+		ShaderProgram_SetVec3(programHandle, "u_light.diffuse", 1.0f, 1.0f, 0.9f);
+		ShaderProgram_SetVec3(programHandle, "u_light.specular", 1.0f, 1.0f, 1.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.constant", 1.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.linear", 0.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.quadratic", 0.0f);
+		ShaderProgram_SetVec3(programHandle, "u_viewPosition", gCamera.GetPosition());
+
+		const Material* currentMaterial = nullptr;
+		for (const GltfDrawable& drawable : model.mDrawables) {
+			const GltfPrimitive& primitive = model.mPrimitives[drawable.mPrimitive];
+			const Material* material = (primitive.mMaterial < model.mMaterials.size()) ? &model.mMaterials[primitive.mMaterial] : &defaultMaterial;
+			if (material != currentMaterial) {
+				Material_Apply(programHandle, *material);
+				currentMaterial = material;
+			}
+
+			glm::mat4 world = sceneTransform * drawable.mTransform;
+			ShaderProgram_SetMat4(programHandle, "u_model", world);
+			ShaderProgram_SetMat4(programHandle, "u_modelView", view * world);
+			ShaderProgram_SetMat4(programHandle, "u_modelViewProj", projection * view * world);
+			Mesh_Draw(primitive.mMesh);
+		}
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+	}
+
+	Gltf_Destroy(model);
+	Texture_Destroy(defaultSpecular);
+	Texture_Destroy(defaultDiffuse);
+	ShaderProgram_Destroy(programHandle);
+
+	glfwTerminate();
+	return 0;
+}
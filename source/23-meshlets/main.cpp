@@ -0,0 +1,395 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "Meshlet.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "Frustum.h"
+#include "InputManager.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+enum class MeshletMode : uint8_t {
+	Off = 0,
+	Cpu,
+	Gpu,
+	Count
+};
+
+const char* cMeshletModeNames[] = {
+	"OFF",
+	"CPU",
+	"GPU",
+};
+
+constexpr uint32_t cVertexStride = 8;				// position, normal, texture coordinates
+constexpr uint32_t cTorusRings = 384;
+constexpr uint32_t cTorusSides = 192;
+constexpr float cTorusRadius = 1.0f;
+constexpr float cTubeRadius = 0.35f;
+constexpr uint32_t cInstancesSide = 5;
+constexpr float cInstancesSpacing = 3.0f;
+constexpr float cGroundSize = 20.0f;
+constexpr float cNearPlane = 0.1f;
+constexpr float cFarPlane = 100.0f;
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+bool gGpuCulling = false;
+MeshletMode gMeshletMode = MeshletMode::Cpu;
+
+Camera gCamera;
+
+void AddVertex(std::vector<float>& vertices, const glm::vec3& position, const glm::vec3& normal, float u, float v) {
+	vertices.insert(vertices.end(), { position.x, position.y, position.z, normal.x, normal.y, normal.z, u, v });
+}
+
+// Ground quad, drawn whole, at the start of the shared vertex and index buffers.
+void BuildGround(std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+	const float half = cGroundSize * 0.5f;
+	const float tiles = cGroundSize * 0.5f;
+	const glm::vec3 up(0.0f, 1.0f, 0.0f);
+	AddVertex(vertices, glm::vec3(-half, -1.0f, -half), up, 0.0f, 0.0f);
+	AddVertex(vertices, glm::vec3(half, -1.0f, -half), up, tiles, 0.0f);
+	AddVertex(vertices, glm::vec3(half, -1.0f, half), up, tiles, tiles);
+	AddVertex(vertices, glm::vec3(-half, -1.0f, half), up, 0.0f, tiles);
+	indices.insert(indices.end(), { 0, 2, 1, 0, 3, 2 });
+}
+
+// Dense torus standing up, so that both the frustum and the normal cone tests discard meshlets. Indices are relative
+// to the first torus vertex.
+void BuildTorus(std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+	const float twoPi = 6.28318530718f;
+	for (uint32_t ring = 0; ring <= cTorusRings; ring++) {
+		const float u = float(ring) / float(cTorusRings);
+		const glm::vec3 direction(std::cos(u * twoPi), std::sin(u * twoPi), 0.0f);
+		for (uint32_t side = 0; side <= cTorusSides; side++) {
+			const float v = float(side) / float(cTorusSides);
+			const glm::vec3 normal = direction * std::cos(v * twoPi) + glm::vec3(0.0f, 0.0f, std::sin(v * twoPi));
+			AddVertex(vertices, direction * cTorusRadius + normal * cTubeRadius, normal, u * 8.0f, v * 2.0f);
+		}
+	}
+	const uint32_t rowSize = cTorusSides + 1;
+	for (uint32_t ring = 0; ring < cTorusRings; ring++) {
+		for (uint32_t side = 0; side < cTorusSides; side++) {
+			const uint32_t a = ring * rowSize + side;
+			const uint32_t b = a + rowSize;
+			indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+		}
+	}
+}
+
+void SetAttributes(MeshParams& params, const BufferHandle& vertexBuffer, uint32_t firstVertex) {
+	params.mVertexBuffers[0] = vertexBuffer;
+	params.mVertexBuffersCount = 1;
+	params.mAttributesCount = 3;
+	for (uint32_t i = 0; i < 3; i++) {
+		params.mAttributes[i].mLocation = uint8_t(i);
+		params.mAttributes[i].mComponents = (i == 2) ? 2 : 3;
+		params.mAttributes[i].mOffset = (firstVertex * cVertexStride + i * 3) * sizeof(float);
+		params.mAttributes[i].mStride = cVertexStride * sizeof(float);
+	}
+}
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void SelectMeshletMode(MeshletMode mode) {
+	if (mode == MeshletMode::Gpu && !gGpuCulling) {
+		Log(tinyngine::Logger::Warning, "GPU meshlet culling needs GL 4.3");
+		return;
+	}
+	Log(tinyngine::Logger::Information, "SELECT MESHLET CULLING: %s", cMeshletModeNames[uint32_t(mode)]);
+	gMeshletMode = mode;
+}
+
+// A grid of dense tori split into meshlets, culled per meshlet against the frustum and by normal cone, on the CPU
+// into Mesh_MultiDraw ranges or with a compute shader into indirect commands. The tori share their buffers with the
+// ground and start at an index and vertex offset in them.
+int main() {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_1, []() { SelectMeshletMode(MeshletMode::Off); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_2, []() { SelectMeshletMode(MeshletMode::Cpu); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_3, []() { SelectMeshletMode(MeshletMode::Gpu); });
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString("06-lights.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("06-lights.fs", params.mFragmentShaderData);
+	ShaderProgramHandle programHandle = ShaderProgram_Create(params);
+	if (!programHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid() || !textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	std::vector<float> vertices;
+	std::vector<uint32_t> groundIndices;
+	BuildGround(vertices, groundIndices);
+	const uint32_t torusFirstVertex = uint32_t(vertices.size()) / cVertexStride;
+	std::vector<uint32_t> torusIndices;
+	BuildTorus(vertices, torusIndices);
+	const uint32_t torusVertexCount = uint32_t(vertices.size()) / cVertexStride - torusFirstVertex;
+
+	MeshletTable table;
+	if (!Meshlet_Build(vertices.data() + torusFirstVertex * cVertexStride, cVertexStride * sizeof(float), torusVertexCount,
+			torusIndices.data(), uint32_t(torusIndices.size()), table)) {
+		Log(tinyngine::Logger::Error, "Failed to build meshlets");
+		return 1;
+	}
+
+	// ground indices first, then the meshlet ordered torus indices
+	std::vector<uint32_t> indices(groundIndices);
+	indices.insert(indices.end(), table.mIndices.begin(), table.mIndices.end());
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices.data(), uint32_t(vertices.size() * sizeof(float)));
+	BufferHandle indexBuffer = Buffer_Create(BufferType::Index, indices.data(), uint32_t(indices.size() * sizeof(uint32_t)));
+
+	MeshParams groundParams;
+	SetAttributes(groundParams, vertexBuffer, 0);
+	groundParams.mIndexBuffer = indexBuffer;
+	groundParams.mIndexFormat = IndexFormat::UInt32;
+	groundParams.mIndexCount = uint32_t(groundIndices.size());
+	MeshHandle groundMesh = Mesh_Create(groundParams);
+
+	MeshParams torusParams;
+	SetAttributes(torusParams, vertexBuffer, torusFirstVertex);
+	torusParams.mIndexBuffer = indexBuffer;
+	torusParams.mIndexFormat = IndexFormat::UInt32;
+	torusParams.mIndexOffset = uint32_t(groundIndices.size() * sizeof(uint32_t));
+	torusParams.mIndexCount = uint32_t(table.mIndices.size());
+	MeshHandle torusMesh = Mesh_Create(torusParams);
+	if (!groundMesh.IsValid() || !torusMesh.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create meshes");
+		return 1;
+	}
+
+	ShaderProgramHandle cullProgramHandle = ShaderProgramHandle(cInvalidHandle);
+	MeshletGpuCuller culler;
+	if (Meshlet_IsGpuCullingSupported()) {
+		ShaderProgramParams cullParams;
+		StringUtils::ReadFileToString("meshlet_cull.cs", cullParams.mComputeShaderData);
+		cullProgramHandle = ShaderProgram_Create(cullParams);
+		gGpuCulling = Meshlet_CreateGpuCuller(table, torusMesh, cullProgramHandle, culler);
+	}
+	Log(tinyngine::Logger::Information, "%u meshlets of %u triangles per torus, %u tori, GPU culling %s", table.GetCount(),
+		uint32_t(table.mIndices.size() / 3), cInstancesSide * cInstancesSide, gGpuCulling ? "available" : "not available");
+
+	std::vector<glm::mat4> models;
+	for (uint32_t z = 0; z < cInstancesSide; z++) {
+		for (uint32_t x = 0; x < cInstancesSide; x++) {
+			const float offset = (float(cInstancesSide) - 1.0f) * 0.5f;
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((float(x) - offset) * cInstancesSpacing, 0.4f, (float(z) - offset) * cInstancesSpacing));
+			models.push_back(glm::rotate(model, glm::radians(37.0f * float(x + z * cInstancesSide)), glm::vec3(0.0f, 1.0f, 0.0f)));
+		}
+	}
+	MeshletDrawRanges ranges;
+
+	gCamera.SetPosition(glm::vec3(0.0f, 1.0f, 10.0f));
+
+	glm::vec4 lightDirection(-0.2f, -1.0f, -0.3f, 0.0);
+	double lastFrameTime = 0.0;
+	double lastReportTime = 0.0;
+	double cullMilliseconds = 0.0;
+	uint64_t visibleMeshlets = 0;
+	uint64_t drawnTriangles = 0;
+	uint32_t framesCount = 0;
+	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
+
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+
+	glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, cNearPlane, cFarPlane);
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		processInput(window, deltaTime);
+
+		glm::mat4 view = gCamera.GetViewMatrix();
+		const Frustum frustum = Frustum_FromMatrix(projection * view);
+		const glm::vec3 cameraPosition = gCamera.GetPosition();
+
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		ShaderProgram_Use(programHandle);
+		Texture_Bind(textureHandle1, 0);
+		Texture_Bind(textureHandle2, 1);
+		ShaderProgram_SetInt(programHandle, "u_material.diffuse", 0);
+		ShaderProgram_SetInt(programHandle, "u_material.specular", 1);
+		ShaderProgram_SetFloat(programHandle, "u_material.shininess", 32.0f);
+		ShaderProgram_SetVec4(programHandle, "u_light.direction", lightDirection);
+		ShaderProgram_SetVec3(programHandle, "u_light.ambient", 0.1f, 0.1f, 0.1f);
+		ShaderProgram_SetVec3(programHandle, "u_light.diffuse", 1.0f, 1.0f, 0.9f);
+		ShaderProgram_SetVec3(programHandle, "u_light.specular", 1.0f, 1.0f, 1.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.constant", 1.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.linear", 0.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.quadratic", 0.0f);
+		ShaderProgram_SetVec3(programHandle, "u_viewPosition", cameraPosition);
+
+		glm::mat4 model(1.0f);
+		ShaderProgram_SetMat4(programHandle, "u_model", model);
+		ShaderProgram_SetMat4(programHandle, "u_modelView", view);
+		ShaderProgram_SetMat4(programHandle, "u_modelViewProj", projection * view);
+		Mesh_Draw(groundMesh);
+
+		for (const glm::mat4& instance : models) {
+			if (gMeshletMode == MeshletMode::Gpu) {
+				// the commands buffer is shared by the instances, each one is culled right before it is drawn
+				Meshlet_CullGpu(culler, instance, cameraPosition, frustum);
+				ShaderProgram_Use(programHandle);
+			} else if (gMeshletMode == MeshletMode::Cpu) {
+				auto start = std::chrono::high_resolution_clock::now();
+				Meshlet_Cull(table, instance, cameraPosition, frustum, ranges);
+				cullMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+				visibleMeshlets += ranges.mVisibleMeshlets;
+				for (int32_t count : ranges.mCounts) {
+					drawnTriangles += uint32_t(count) / 3;
+				}
+				if (ranges.mCounts.empty()) {
+					continue;
+				}
+			} else {
+				visibleMeshlets += table.GetCount();
+				drawnTriangles += table.mIndices.size() / 3;
+			}
+
+			ShaderProgram_SetMat4(programHandle, "u_model", instance);
+			ShaderProgram_SetMat4(programHandle, "u_modelView", view * instance);
+			ShaderProgram_SetMat4(programHandle, "u_modelViewProj", projection * view * instance);
+			if (gMeshletMode == MeshletMode::Gpu) {
+				Meshlet_DrawGpu(culler);
+			} else if (gMeshletMode == MeshletMode::Cpu) {
+				Mesh_MultiDraw(torusMesh, ranges.mCounts.data(), ranges.mOffsets.data(), uint32_t(ranges.mCounts.size()));
+			} else {
+				Mesh_Draw(torusMesh);
+			}
+		}
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		framesCount++;
+		if (currentFrameTime - lastReportTime >= 2.0) {
+			if (gMeshletMode == MeshletMode::Gpu) {
+				// the visible meshlets stay on the GPU, reading the commands back would stall
+				Log(tinyngine::Logger::Information, "meshlet culling GPU, %u tori", uint32_t(models.size()));
+			} else {
+				Log(tinyngine::Logger::Information, "meshlet culling %s: %u of %u meshlets, %u triangles, cull %.3f ms/frame",
+					cMeshletModeNames[uint32_t(gMeshletMode)], uint32_t(visibleMeshlets / framesCount), table.GetCount() * uint32_t(models.size()),
+					uint32_t(drawnTriangles / framesCount), cullMilliseconds / double(framesCount));
+			}
+			visibleMeshlets = 0;
+			drawnTriangles = 0;
+			cullMilliseconds = 0.0;
+			framesCount = 0;
+			lastReportTime = currentFrameTime;
+		}
+	}
+
+	Meshlet_DestroyGpuCuller(culler);
+	ShaderProgram_Destroy(cullProgramHandle);
+	Mesh_Destroy(torusMesh);
+	Mesh_Destroy(groundMesh);
+	Buffer_Destroy(indexBuffer);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(programHandle);
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,332 @@
+#include "CommonDefine.h"
+#include "GLApi.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "MeshLod.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "StringUtils.h"
+#include "Camera.h"
+#include "InputManager.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+constexpr uint32_t cVertexStride = 8;				// position, normal, texture coordinates
+constexpr uint32_t cTorusRings = 128;
+constexpr uint32_t cTorusSides = 64;
+constexpr float cTorusRadius = 1.0f;
+constexpr float cTubeRadius = 0.35f;
+constexpr uint32_t cObjectsSide = 24;
+constexpr float cObjectsSpacing = 3.0f;
+constexpr float cNearPlane = 0.1f;
+constexpr float cFarPlane = 150.0f;
+constexpr float cHysteresis = 0.25f;
+
+// every level halves the triangles of the previous one
+const float cLodRatios[] = { 0.5f, 0.25f, 0.125f, 0.0625f, 0.03125f };
+
+float gLastX = 0;
+float gLastY = 0;
+bool gFirstMouse = true;
+bool gUseLod = true;
+bool gUseHysteresis = true;
+float gMaxPixelError = 1.0f;
+
+Camera gCamera;
+
+void BuildTorus(std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+	const float twoPi = 6.28318530718f;
+	for (uint32_t ring = 0; ring <= cTorusRings; ring++) {
+		const float u = float(ring) / float(cTorusRings);
+		const glm::vec3 direction(std::cos(u * twoPi), std::sin(u * twoPi), 0.0f);
+		for (uint32_t side = 0; side <= cTorusSides; side++) {
+			const float v = float(side) / float(cTorusSides);
+			const glm::vec3 normal = direction * std::cos(v * twoPi) + glm::vec3(0.0f, 0.0f, std::sin(v * twoPi));
+			const glm::vec3 position = direction * cTorusRadius + normal * cTubeRadius;
+			vertices.insert(vertices.end(), { position.x, position.y, position.z, normal.x, normal.y, normal.z, u * 8.0f, v * 2.0f });
+		}
+	}
+	const uint32_t rowSize = cTorusSides + 1;
+	for (uint32_t ring = 0; ring < cTorusRings; ring++) {
+		for (uint32_t side = 0; side < cTorusSides; side++) {
+			const uint32_t a = ring * rowSize + side;
+			const uint32_t b = a + rowSize;
+			indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+		}
+	}
+}
+
+}
+
+void processInput(GLFWwindow *window, float deltaTime) {
+	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+		glfwSetWindowShouldClose(window, true);
+	}
+
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Forward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Backward, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Left, deltaTime);
+	}
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+		gCamera.ProcessKeyboard(Camera::Move::Right, deltaTime);
+	}
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+	TINYNGINE_UNUSED(window);
+	glViewport(0, 0, width, height);
+}
+
+void mouse_callback(GLFWwindow* window, double posX, double posY) {
+	TINYNGINE_UNUSED(window);
+	if (gFirstMouse) {
+		gLastX = float(posX);
+		gLastY = float(posY);
+		gFirstMouse = false;
+	}
+
+	float xOffset = float(posX) - gLastX;
+	float yOffset = gLastY - float(posY);
+
+	gLastX = float(posX);
+	gLastY = float(posY);
+
+	gCamera.ProcessMouse(xOffset, yOffset);
+}
+
+void scroll_callback(GLFWwindow* window, double xOffset, double yOffset) {
+	TINYNGINE_UNUSED(window); TINYNGINE_UNUSED(xOffset);
+	gCamera.ProcessMouseScroll(float(yOffset));
+}
+
+void ToggleLod() {
+	gUseLod = !gUseLod;
+	Log(tinyngine::Logger::Information, "LOD: %s", gUseLod ? "ON" : "OFF");
+}
+
+void ToggleHysteresis() {
+	gUseHysteresis = !gUseHysteresis;
+	Log(tinyngine::Logger::Information, "LOD HYSTERESIS: %s", gUseHysteresis ? "ON" : "OFF");
+}
+
+void ScaleMaxPixelError(float scale) {
+	gMaxPixelError = std::min(std::max(gMaxPixelError * scale, 0.125f), 16.0f);
+	Log(tinyngine::Logger::Information, "LOD MAX PIXEL ERROR: %.3f", gMaxPixelError);
+}
+
+// A field of tori drawn with a level of detail chain: every object keeps the level it was drawn with, so that
+// MeshLod_Draw only moves it to a coarser level once the error is clearly below the threshold.
+int main() {
+	const uint32_t cScreenWidth = 800;
+	const uint32_t cScreenHeight = 600;
+
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
+#endif
+
+	GLFWwindow* window = glfwCreateWindow(cScreenWidth, cScreenHeight, "LearnOpenGL", NULL, NULL);
+	if (window == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetCursorPosCallback(window, mouse_callback);
+	glfwSetScrollCallback(window, scroll_callback);
+
+	// tell GLFW to capture our mouse
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+	Input_Initialize(window);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_L, ToggleLod);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_H, ToggleHysteresis);
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_EQUAL, []() { ScaleMaxPixelError(2.0f); });
+	Input_BindKeyEvent(KeyEventType::Press, GLFW_KEY_MINUS, []() { ScaleMaxPixelError(0.5f); });
+
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return 1;
+	}
+
+	ShaderProgramParams params;
+	StringUtils::ReadFileToString("06-lights.vs", params.mVertexShaderData);
+	StringUtils::ReadFileToString("06-lights.fs", params.mFragmentShaderData);
+	ShaderProgramHandle programHandle = ShaderProgram_Create(params);
+	if (!programHandle.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create shader program");
+		return 1;
+	}
+
+	TextureHandle textureHandle1 = Texture_Create("container2.png", TextureFormats::RGB8);
+	TextureHandle textureHandle2 = Texture_Create("container2_specular.png", TextureFormats::RGB8);
+	if (!textureHandle1.IsValid() || !textureHandle2.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create texture");
+		return 1;
+	}
+
+	std::vector<float> vertices;
+	std::vector<uint32_t> indices;
+	BuildTorus(vertices, indices);
+
+	SimplifyParams simplifyParams;
+	simplifyParams.mPositions = vertices.data();
+	simplifyParams.mPositionStride = cVertexStride * sizeof(float);
+	simplifyParams.mVertexCount = uint32_t(vertices.size()) / cVertexStride;
+	simplifyParams.mIndices = indices.data();
+	simplifyParams.mIndexCount = uint32_t(indices.size());
+	MeshLodChain chain;
+	if (!MeshLod_BuildChain(simplifyParams, cLodRatios, uint32_t(sizeof(cLodRatios) / sizeof(cLodRatios[0])), chain)) {
+		Log(tinyngine::Logger::Error, "Failed to build the LOD chain");
+		return 1;
+	}
+	for (uint32_t i = 0; i < chain.mLevels.size(); i++) {
+		Log(tinyngine::Logger::Information, "LOD %u: %u triangles, error %.5f", i, chain.mLevels[i].mIndexCount / 3, chain.mLevels[i].mError);
+	}
+
+	// one mesh holds every level, they are index ranges of it
+	BufferHandle vertexBuffer = Buffer_Create(BufferType::Vertex, vertices.data(), uint32_t(vertices.size() * sizeof(float)));
+	BufferHandle indexBuffer = Buffer_Create(BufferType::Index, chain.mIndices.data(), uint32_t(chain.mIndices.size() * sizeof(uint32_t)));
+	MeshParams meshParams;
+	meshParams.mVertexBuffers[0] = vertexBuffer;
+	meshParams.mVertexBuffersCount = 1;
+	meshParams.mAttributesCount = 3;
+	meshParams.mAttributes[0].mLocation = 0;
+	meshParams.mAttributes[0].mComponents = 3;
+	meshParams.mAttributes[0].mStride = cVertexStride * sizeof(float);
+	meshParams.mAttributes[1].mLocation = 1;
+	meshParams.mAttributes[1].mComponents = 3;
+	meshParams.mAttributes[1].mOffset = 3 * sizeof(float);
+	meshParams.mAttributes[1].mStride = cVertexStride * sizeof(float);
+	meshParams.mAttributes[2].mLocation = 2;
+	meshParams.mAttributes[2].mComponents = 2;
+	meshParams.mAttributes[2].mOffset = 6 * sizeof(float);
+	meshParams.mAttributes[2].mStride = cVertexStride * sizeof(float);
+	meshParams.mIndexBuffer = indexBuffer;
+	meshParams.mIndexFormat = IndexFormat::UInt32;
+	meshParams.mIndexCount = chain.mLevels[0].mIndexCount;
+	MeshHandle mesh = Mesh_Create(meshParams);
+	if (!mesh.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create meshes");
+		return 1;
+	}
+
+	std::vector<glm::mat4> models;
+	std::vector<glm::vec3> centers;
+	std::vector<MeshLodInstance> instances(cObjectsSide * cObjectsSide);
+	for (uint32_t z = 0; z < cObjectsSide; z++) {
+		for (uint32_t x = 0; x < cObjectsSide; x++) {
+			const glm::vec3 center((float(x) - float(cObjectsSide - 1) * 0.5f) * cObjectsSpacing, 0.0f, -float(z) * cObjectsSpacing);
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), center);
+			models.push_back(glm::rotate(model, glm::radians(37.0f * float(x + z * cObjectsSide)), glm::vec3(0.0f, 1.0f, 0.0f)));
+			centers.push_back(center);
+		}
+	}
+	std::vector<uint32_t> levelCounts(chain.mLevels.size());
+
+	gCamera.SetPosition(glm::vec3(0.0f, 2.0f, 6.0f));
+
+	glm::vec4 lightDirection(-0.2f, -1.0f, -0.3f, 0.0);
+	double lastFrameTime = 0.0;
+	double lastReportTime = 0.0;
+	uint64_t drawnTriangles = 0;
+	uint32_t levelChanges = 0;
+	uint32_t framesCount = 0;
+	float aspectRation = float(cScreenWidth) / float(cScreenHeight);
+
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+
+	glm::mat4 projection = glm::perspective(glm::radians(gCamera.GetFOV()), aspectRation, cNearPlane, cFarPlane);
+	const float projectionScale = MeshLod_GetProjectionScale(gCamera, cScreenHeight);
+
+	while (!glfwWindowShouldClose(window)) {
+		double currentFrameTime = glfwGetTime();
+		float deltaTime = float(currentFrameTime - lastFrameTime);
+		lastFrameTime = currentFrameTime;
+
+		processInput(window, deltaTime);
+
+		glm::mat4 view = gCamera.GetViewMatrix();
+		const glm::vec3 cameraPosition = gCamera.GetPosition();
+
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		ShaderProgram_Use(programHandle);
+		Texture_Bind(textureHandle1, 0);
+		Texture_Bind(textureHandle2, 1);
+		ShaderProgram_SetInt(programHandle, "u_material.diffuse", 0);
+		ShaderProgram_SetInt(programHandle, "u_material.specular", 1);
+		ShaderProgram_SetFloat(programHandle, "u_material.shininess", 32.0f);
+		ShaderProgram_SetVec4(programHandle, "u_light.direction", lightDirection);
+		ShaderProgram_SetVec3(programHandle, "u_light.ambient", 0.1f, 0.1f, 0.1f);
+		ShaderProgram_SetVec3(programHandle, "u_light.diffuse", 1.0f, 1.0f, 0.9f);
+		ShaderProgram_SetVec3(programHandle, "u_light.specular", 1.0f, 1.0f, 1.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.constant", 1.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.linear", 0.0f);
+		ShaderProgram_SetFloat(programHandle, "u_light.quadratic", 0.0f);
+		ShaderProgram_SetVec3(programHandle, "u_viewPosition", cameraPosition);
+
+		for (uint32_t i = 0; i < models.size(); i++) {
+			ShaderProgram_SetMat4(programHandle, "u_model", models[i]);
+			ShaderProgram_SetMat4(programHandle, "u_modelView", view * models[i]);
+			ShaderProgram_SetMat4(programHandle, "u_modelViewProj", projection * view * models[i]);
+
+			uint32_t level = 0;
+			if (gUseLod) {
+				const uint32_t previousLevel = instances[i].mLevel;
+				level = MeshLod_Draw(chain, mesh, instances[i], glm::length(centers[i] - cameraPosition), 1.0f, projectionScale,
+					gMaxPixelError, gUseHysteresis ? cHysteresis : 0.0f);
+				levelChanges += (level != previousLevel) ? 1 : 0;
+			} else {
+				Mesh_Draw(mesh);
+			}
+			levelCounts[level]++;
+			drawnTriangles += chain.mLevels[level].mIndexCount / 3;
+		}
+
+		glfwSwapBuffers(window);
+		glfwPollEvents();
+
+		framesCount++;
+		if (currentFrameTime - lastReportTime >= 2.0) {
+			Log(tinyngine::Logger::Information, "LOD %s, %.2f px: %u of %u triangles, %.1f level changes per frame", gUseLod ? "on" : "off", gMaxPixelError,
+				uint32_t(drawnTriangles / framesCount), uint32_t(models.size()) * chain.mLevels[0].mIndexCount / 3, float(levelChanges) / float(framesCount));
+			for (uint32_t i = 0; i < levelCounts.size(); i++) {
+				Log(tinyngine::Logger::Information, "  level %u: %u objects", i, levelCounts[i] / framesCount);
+				levelCounts[i] = 0;
+			}
+			drawnTriangles = 0;
+			levelChanges = 0;
+			framesCount = 0;
+			lastReportTime = currentFrameTime;
+		}
+	}
+
+	Mesh_Destroy(mesh);
+	Buffer_Destroy(indexBuffer);
+	Buffer_Destroy(vertexBuffer);
+	Texture_Destroy(textureHandle2);
+	Texture_Destroy(textureHandle1);
+	ShaderProgram_Destroy(programHandle);
+
+	glfwTerminate();
+	return 0;
+}
@@ -17,9 +17,12 @@ function(AddCompilerFlags target)
 		else()
 			add_definitions(-D_HAS_ITERATOR_DEBUGGING=0)
 		endif()
-	endif()
 
-	set_target_properties(${target} PROPERTIES COMPILE_FLAGS "/W4 /WX /GR- /Gy /arch:SSE2 /wd4201 /wd4324")
+		set_target_properties(${target} PROPERTIES COMPILE_FLAGS "/W4 /WX /GR- /Gy /arch:SSE2 /wd4201 /wd4324")
+	else()
+		# GCC and Clang, -fno-rtti is rejected by the C compiler of glad.c
+		target_compile_options(${target} PRIVATE -Wall -Wextra -Werror $<$<COMPILE_LANGUAGE:CXX>:-fno-rtti>)
+	endif()
 endfunction(AddCompilerFlags)
 
 function(SetLinkerSubsystem target)
@@ -43,9 +46,29 @@ target_include_directories(${target}
 	PUBLIC
 		"${PROJECT_SOURCE_DIR}/source/common"
 )
+if(WIN32)
+	target_link_libraries(${target}
+		common
+		opengl32.lib
+		glfw3.lib
+	)
+else()
+	target_link_libraries(${target}
+		common
+		${OPENGL_gl_LIBRARY}
+		glfw
+	)
+endif()
+endfunction(SetupSample)
+
+# Samples that neither open a window nor use GL, e.g. the software rasterizer: common only, built as console programs
+# so they run on hosts without a GPU nor a display.
+function(SetupConsoleSample target)
+target_include_directories(${target}
+	PUBLIC
+		"${PROJECT_SOURCE_DIR}/source/common"
+)
 target_link_libraries(${target}
 	common
-	opengl32.lib
-	glfw3.lib
 )
-endfunction(SetupSample)
\ No newline at end of file
+endfunction(SetupConsoleSample)
\ No newline at end of file
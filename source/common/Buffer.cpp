@@ -0,0 +1,181 @@
+#include "Buffer.h"
+
+#include "GLApi.h"
+#include <array>
+
+namespace
+{
+
+static const GLenum sBufferTargets[]{
+	GL_ARRAY_BUFFER,				// Vertex
+	GL_ELEMENT_ARRAY_BUFFER,		// Index
+	GL_UNIFORM_BUFFER,				// Uniform
+	GL_SHADER_STORAGE_BUFFER,		// ShaderStorage
+	GL_DRAW_INDIRECT_BUFFER,		// DrawIndirect
+	GL_TEXTURE_BUFFER,				// Texture
+};
+
+static const GLenum sBufferUsages[]{
+	GL_STATIC_DRAW,					// Static
+	GL_DYNAMIC_DRAW,				// Dynamic
+	GL_STREAM_DRAW,					// Stream
+};
+
+class Buffer {
+public:
+	Buffer() = default;
+	~Buffer() {
+		Destroy();
+	}
+
+	void Create(BufferType::Enum type, const void* data, uint32_t size, BufferUsage::Enum usage) {
+		mTarget = sBufferTargets[type];
+		mUsage = sBufferUsages[usage];
+
+		glGenBuffers(1, &mId);
+		GL_ERROR(mId == 0);
+
+		// index buffers are bound through the VAO, keep the current one untouched while uploading
+		GLenum uploadTarget = (type == BufferType::Index) ? GL_COPY_WRITE_BUFFER : mTarget;
+		GL_CHECK(glBindBuffer(uploadTarget, mId));
+		GL_CHECK(glBufferData(uploadTarget, size, data, mUsage));
+		GL_CHECK(glBindBuffer(uploadTarget, 0));
+
+		mSize = size;
+	}
+
+	void Destroy() {
+		if (IsValid()) {
+			GL_CHECK(glDeleteBuffers(1, &mId));
+			mId = 0;
+			mSize = 0;
+		}
+	}
+
+	void Bind() {
+		if (IsValid()) {
+			GL_CHECK(glBindBuffer(mTarget, mId));
+		}
+	}
+
+	void BindBase(uint32_t index) {
+		if (IsValid()) {
+			GL_CHECK(glBindBufferBase(mTarget, index, mId));
+		}
+	}
+
+	void BindRange(uint32_t index, uint32_t offset, uint32_t size) {
+		if (IsValid()) {
+			GL_CHECK(glBindBufferRange(mTarget, index, mId, offset, size));
+		}
+	}
+
+	void Update(uint32_t offset, const void* data, uint32_t size) {
+		if (IsValid() && data) {
+			GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, mId));
+			if (offset == 0 && (size >= mSize || mUsage == GL_STREAM_DRAW)) {
+				// orphan the previous storage so the driver does not stall on in-flight draws
+				mSize = (size > mSize) ? size : mSize;
+				GL_CHECK(glBufferData(GL_COPY_WRITE_BUFFER, mSize, nullptr, mUsage));
+			}
+			GL_CHECK(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data));
+			GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+		}
+	}
+
+	bool IsValid() const {
+		return mId > 0;
+	}
+
+	uint32_t GetSize() const {
+		return mSize;
+	}
+
+	GLuint GetId() const {
+		return mId;
+	}
+
+private:
+	GLuint mId = 0;
+	GLenum mTarget = GL_ARRAY_BUFFER;
+	GLenum mUsage = GL_STATIC_DRAW;
+	uint32_t mSize = 0;
+};
+
+static constexpr uint32_t cMaxBufferHandles = (1 << 10);
+uint32_t sBuffersCount = 0;
+std::array<Buffer, cMaxBufferHandles> sBuffers;
+
+}
+
+BufferHandle Buffer_Create(BufferType::Enum type, const void* data, uint32_t size, BufferUsage::Enum usage) {
+	if (size == 0 || sBuffersCount >= cMaxBufferHandles) {
+		return BufferHandle(cInvalidHandle);
+	}
+
+	BufferHandle handle = BufferHandle(sBuffersCount);
+	auto& buffer = sBuffers[handle.mHandle];
+	buffer.Create(type, data, size, usage);
+
+	if (buffer.IsValid()) {
+		sBuffersCount++;
+		return handle;
+	}
+	return BufferHandle(cInvalidHandle);
+}
+
+void Buffer_Destroy(const BufferHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& buffer = sBuffers[handle.mHandle];
+	buffer.Destroy();
+}
+
+void Buffer_Bind(const BufferHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& buffer = sBuffers[handle.mHandle];
+	buffer.Bind();
+}
+
+void Buffer_BindBase(const BufferHandle& handle, uint32_t index) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& buffer = sBuffers[handle.mHandle];
+	buffer.BindBase(index);
+}
+
+void Buffer_BindRange(const BufferHandle& handle, uint32_t index, uint32_t offset, uint32_t size) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& buffer = sBuffers[handle.mHandle];
+	buffer.BindRange(index, offset, size);
+}
+
+void Buffer_Update(const BufferHandle& handle, uint32_t offset, const void* data, uint32_t size) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& buffer = sBuffers[handle.mHandle];
+	buffer.Update(offset, data, size);
+}
+
+uint32_t Buffer_GetSize(const BufferHandle& handle) {
+	if (!handle.IsValid()) {
+		return 0;
+	}
+	auto& buffer = sBuffers[handle.mHandle];
+	return buffer.GetSize();
+}
+
+uint32_t Buffer_GetNativeId(const BufferHandle& handle) {
+	if (!handle.IsValid()) {
+		return 0;
+	}
+	auto& buffer = sBuffers[handle.mHandle];
+	return buffer.GetId();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "CommonDefine.h"
+
+struct BufferType {
+	enum Enum {
+		Vertex,
+		Index,
+		Uniform,
+		ShaderStorage,
+		DrawIndirect,
+		Texture,
+		Count
+	};
+};
+
+struct BufferUsage {
+	enum Enum {
+		Static,
+		Dynamic,
+		Stream,
+		Count
+	};
+};
+
+using BufferHandle = ResourceHandle;
+
+BufferHandle Buffer_Create(BufferType::Enum type, const void* data, uint32_t size, BufferUsage::Enum usage = BufferUsage::Static);
+
+void Buffer_Destroy(const BufferHandle& handle);
+
+void Buffer_Bind(const BufferHandle& handle);
+
+void Buffer_BindBase(const BufferHandle& handle, uint32_t index);
+
+void Buffer_BindRange(const BufferHandle& handle, uint32_t index, uint32_t offset, uint32_t size);
+
+void Buffer_Update(const BufferHandle& handle, uint32_t offset, const void* data, uint32_t size);
+
+uint32_t Buffer_GetSize(const BufferHandle& handle);
+
+uint32_t Buffer_GetNativeId(const BufferHandle& handle);
@@ -0,0 +1,534 @@
+#include "Bvh.h"
+
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+constexpr uint32_t cSahBins = 16;
+constexpr float cTraversalCost = 1.0f;
+constexpr float cObjectCost = 1.0f;
+
+constexpr uint8_t cFlagDirtyLeaf = 1 << 0;
+constexpr uint8_t cFlagRotationCandidate = 1 << 1;
+
+inline BvhAabb Union(const BvhAabb& a, const BvhAabb& b) {
+	BvhAabb result;
+	result.mMin = glm::min(a.mMin, b.mMin);
+	result.mMax = glm::max(a.mMax, b.mMax);
+	return result;
+}
+
+inline BvhAabb EmptyAabb() {
+	BvhAabb result;
+	result.mMin = glm::vec3(std::numeric_limits<float>::max());
+	result.mMax = glm::vec3(-std::numeric_limits<float>::max());
+	return result;
+}
+
+inline float Area(const BvhAabb& box) {
+	glm::vec3 size = glm::max(box.mMax - box.mMin, glm::vec3(0.0f));
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+inline bool Equal(const BvhAabb& a, const BvhAabb& b) {
+	return a.mMin == b.mMin && a.mMax == b.mMax;
+}
+
+inline bool Overlap(const BvhAabb& a, const BvhAabb& b) {
+	return a.mMin.x <= b.mMax.x && a.mMax.x >= b.mMin.x &&
+		a.mMin.y <= b.mMax.y && a.mMax.y >= b.mMin.y &&
+		a.mMin.z <= b.mMax.z && a.mMax.z >= b.mMin.z;
+}
+
+inline bool IsLeaf(const BvhNode& node) {
+	return node.mObjectsCount > 0;
+}
+
+BvhAabb LeafBounds(const Bvh& bvh, const BvhNode& node) {
+	BvhAabb bounds = EmptyAabb();
+	for (uint32_t i = 0; i < node.mObjectsCount; i++) {
+		bounds = Union(bounds, bvh.mObjectBounds[bvh.mObjectIndices[node.mFirstObject + i]]);
+	}
+	return bounds;
+}
+
+uint32_t AllocateNode(Bvh& bvh, uint32_t parent) {
+	BvhNode node;
+	node.mParent = parent;
+	bvh.mNodes.push_back(node);
+	return static_cast<uint32_t>(bvh.mNodes.size() - 1);
+}
+
+void MakeLeaf(Bvh& bvh, uint32_t nodeIndex, uint32_t first, uint32_t count) {
+	BvhNode& node = bvh.mNodes[nodeIndex];
+	node.mFirstObject = first;
+	node.mObjectsCount = count;
+	for (uint32_t i = first; i < first + count; i++) {
+		bvh.mObjectLeaves[bvh.mObjectIndices[i]] = nodeIndex;
+	}
+}
+
+// Returns the index of the first object of the right half, or first when no split improves on a leaf.
+uint32_t SplitBinnedSah(Bvh& bvh, const std::vector<glm::vec3>& centroids, uint32_t first, uint32_t count, const BvhAabb& bounds) {
+	uint32_t* indices = bvh.mObjectIndices.data() + first;
+
+	BvhAabb centroidBounds = EmptyAabb();
+	for (uint32_t i = 0; i < count; i++) {
+		centroidBounds.mMin = glm::min(centroidBounds.mMin, centroids[indices[i]]);
+		centroidBounds.mMax = glm::max(centroidBounds.mMax, centroids[indices[i]]);
+	}
+
+	float bestCost = std::numeric_limits<float>::max();
+	uint32_t bestAxis = 0;
+	uint32_t bestBin = 0;
+	// only the axis of largest centroid spread is binned, the other two rarely win and would triple the build time
+	const glm::vec3 spread = centroidBounds.mMax - centroidBounds.mMin;
+	const uint32_t largestAxis = (spread.x >= spread.y && spread.x >= spread.z) ? 0 : (spread.y >= spread.z ? 1 : 2);
+	{
+		const uint32_t axis = largestAxis;
+		const float minimum = centroidBounds.mMin[axis];
+		const float extent = centroidBounds.mMax[axis] - minimum;
+		if (extent <= 0.0f) {
+			// every centroid in the same place, split by count
+			return first + count / 2;
+		}
+		const float scale = float(cSahBins) / extent;
+
+		uint32_t binCounts[cSahBins] = {};
+		BvhAabb binBounds[cSahBins];
+		for (uint32_t bin = 0; bin < cSahBins; bin++) {
+			binBounds[bin] = EmptyAabb();
+		}
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t bin = std::min(uint32_t((centroids[indices[i]][axis] - minimum) * scale), cSahBins - 1);
+			binCounts[bin]++;
+			binBounds[bin] = Union(binBounds[bin], bvh.mObjectBounds[indices[i]]);
+		}
+
+		// sweep from the right to get the cost of every right half, then from the left
+		float rightAreas[cSahBins];
+		uint32_t rightCounts[cSahBins];
+		BvhAabb accumulated = EmptyAabb();
+		uint32_t accumulatedCount = 0;
+		for (uint32_t bin = cSahBins - 1; bin > 0; bin--) {
+			accumulated = Union(accumulated, binBounds[bin]);
+			accumulatedCount += binCounts[bin];
+			rightAreas[bin] = Area(accumulated);
+			rightCounts[bin] = accumulatedCount;
+		}
+		accumulated = EmptyAabb();
+		accumulatedCount = 0;
+		for (uint32_t bin = 1; bin < cSahBins; bin++) {
+			accumulated = Union(accumulated, binBounds[bin - 1]);
+			accumulatedCount += binCounts[bin - 1];
+			if (accumulatedCount == 0 || rightCounts[bin] == 0) {
+				continue;
+			}
+			float cost = Area(accumulated) * float(accumulatedCount) + rightAreas[bin] * float(rightCounts[bin]);
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = bin;
+			}
+		}
+	}
+
+	if (bestBin == 0) {
+		// no bin boundary separates the objects, split by count
+		return first + count / 2;
+	}
+	const float leafCost = Area(bounds) * float(count) * cObjectCost;
+	const float splitCost = Area(bounds) * cTraversalCost + bestCost * cObjectCost;
+	if (count <= cBvhMaxLeafObjects && leafCost <= splitCost) {
+		return first;
+	}
+
+	const float minimum = centroidBounds.mMin[bestAxis];
+	const float scale = float(cSahBins) / (centroidBounds.mMax[bestAxis] - minimum);
+	uint32_t* middle = std::partition(indices, indices + count, [&](uint32_t object) {
+		return std::min(uint32_t((centroids[object][bestAxis] - minimum) * scale), cSahBins - 1) < bestBin;
+	});
+	return first + static_cast<uint32_t>(middle - indices);
+}
+
+void Rebuild(Bvh& bvh) {
+	const uint32_t count = static_cast<uint32_t>(bvh.mObjectBounds.size());
+	bvh.mNodes.clear();
+	bvh.mDirtyLeaves.clear();
+	bvh.mRotationCandidates.clear();
+	bvh.mObjectIndices.resize(count);
+	bvh.mObjectLeaves.assign(count, cInvalidHandle);
+	bvh.mRoot = cInvalidHandle;
+	bvh.mBuildCost = 0.0f;
+	if (count == 0) {
+		bvh.mNodeFlags.clear();
+		return;
+	}
+
+	std::vector<glm::vec3> centroids(count);
+	for (uint32_t i = 0; i < count; i++) {
+		bvh.mObjectIndices[i] = i;
+		centroids[i] = (bvh.mObjectBounds[i].mMin + bvh.mObjectBounds[i].mMax) * 0.5f;
+	}
+
+	struct Task {
+		uint32_t mNode;
+		uint32_t mFirst;
+		uint32_t mCount;
+	};
+	std::vector<Task> tasks;
+	bvh.mNodes.reserve(2 * count);
+	bvh.mRoot = AllocateNode(bvh, cInvalidHandle);
+	tasks.push_back({ bvh.mRoot, 0, count });
+	while (!tasks.empty()) {
+		Task task = tasks.back();
+		tasks.pop_back();
+
+		BvhAabb bounds = EmptyAabb();
+		for (uint32_t i = task.mFirst; i < task.mFirst + task.mCount; i++) {
+			bounds = Union(bounds, bvh.mObjectBounds[bvh.mObjectIndices[i]]);
+		}
+		bvh.mNodes[task.mNode].mBounds = bounds;
+
+		uint32_t middle = (task.mCount > 1) ? SplitBinnedSah(bvh, centroids, task.mFirst, task.mCount, bounds) : task.mFirst;
+		if (middle == task.mFirst || middle == task.mFirst + task.mCount) {
+			MakeLeaf(bvh, task.mNode, task.mFirst, task.mCount);
+			continue;
+		}
+
+		uint32_t left = AllocateNode(bvh, task.mNode);
+		uint32_t right = AllocateNode(bvh, task.mNode);
+		bvh.mNodes[task.mNode].mChildren[0] = left;
+		bvh.mNodes[task.mNode].mChildren[1] = right;
+		tasks.push_back({ left, task.mFirst, middle - task.mFirst });
+		tasks.push_back({ right, middle, task.mFirst + task.mCount - middle });
+	}
+
+	bvh.mNodeFlags.assign(bvh.mNodes.size(), 0);
+	bvh.mBuildCost = Bvh_GetCost(bvh);
+}
+
+// Tries to swap one child of the node with a grandchild below the other child, keeping the swap that shrinks
+// the other child the most.
+bool Rotate(Bvh& bvh, uint32_t nodeIndex) {
+	BvhNode& node = bvh.mNodes[nodeIndex];
+	if (IsLeaf(node)) {
+		return false;
+	}
+
+	float bestGain = 0.0f;
+	uint32_t bestChild = 0;
+	uint32_t bestGrandchild = 0;
+	for (uint32_t child = 0; child < 2; child++) {
+		const BvhNode& sibling = bvh.mNodes[node.mChildren[1 - child]];
+		if (IsLeaf(sibling)) {
+			continue;
+		}
+		const BvhAabb& moved = bvh.mNodes[node.mChildren[child]].mBounds;
+		for (uint32_t grandchild = 0; grandchild < 2; grandchild++) {
+			// the sibling would then hold the moved child and the grandchild that stays
+			const BvhAabb& kept = bvh.mNodes[sibling.mChildren[1 - grandchild]].mBounds;
+			float gain = Area(sibling.mBounds) - Area(Union(moved, kept));
+			if (gain > bestGain) {
+				bestGain = gain;
+				bestChild = child;
+				bestGrandchild = grandchild;
+			}
+		}
+	}
+	if (bestGain <= 0.0f) {
+		return false;
+	}
+
+	const uint32_t childIndex = node.mChildren[bestChild];
+	const uint32_t siblingIndex = node.mChildren[1 - bestChild];
+	BvhNode& sibling = bvh.mNodes[siblingIndex];
+	const uint32_t grandchildIndex = sibling.mChildren[bestGrandchild];
+
+	node.mChildren[bestChild] = grandchildIndex;
+	sibling.mChildren[bestGrandchild] = childIndex;
+	bvh.mNodes[grandchildIndex].mParent = nodeIndex;
+	bvh.mNodes[childIndex].mParent = siblingIndex;
+	sibling.mBounds = Union(bvh.mNodes[sibling.mChildren[0]].mBounds, bvh.mNodes[sibling.mChildren[1]].mBounds);
+	return true;
+}
+
+void EmitSubtree(const Bvh& bvh, uint32_t nodeIndex, uint32_t* visible, uint32_t& written, std::vector<uint32_t>& stack) {
+	const size_t base = stack.size();
+	stack.push_back(nodeIndex);
+	while (stack.size() > base) {
+		const BvhNode& node = bvh.mNodes[stack.back()];
+		stack.pop_back();
+		if (IsLeaf(node)) {
+			for (uint32_t i = 0; i < node.mObjectsCount; i++) {
+				visible[written++] = bvh.mObjectIndices[node.mFirstObject + i];
+			}
+		} else {
+			stack.push_back(node.mChildren[0]);
+			stack.push_back(node.mChildren[1]);
+		}
+	}
+}
+
+// Clears the bits of the planes the box is fully inside of, returns false when the box is outside one of them.
+inline bool TestPlanes(const Frustum& frustum, const BvhAabb& box, uint32_t& mask, uint32_t& planeTests) {
+	const glm::vec3 center = (box.mMin + box.mMax) * 0.5f;
+	const glm::vec3 extent = (box.mMax - box.mMin) * 0.5f;
+	for (uint32_t plane = 0; plane < FrustumPlane::Count; plane++) {
+		if ((mask & (1u << plane)) == 0) {
+			continue;
+		}
+		planeTests++;
+		const glm::vec4& p = frustum.mPlanes[plane];
+		const float distance = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+		const float radius = std::abs(p.x) * extent.x + std::abs(p.y) * extent.y + std::abs(p.z) * extent.z;
+		if (distance + radius < 0.0f) {
+			return false;
+		}
+		if (distance - radius >= 0.0f) {
+			mask &= ~(1u << plane);
+		}
+	}
+	return true;
+}
+
+// Slab test, returns the entry distance or a negative value when the ray misses the box within maxDistance.
+inline float IntersectRay(const BvhAabb& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) {
+	glm::vec3 t0 = (box.mMin - origin) * inverseDirection;
+	glm::vec3 t1 = (box.mMax - origin) * inverseDirection;
+	glm::vec3 entries = glm::min(t0, t1);
+	glm::vec3 exits = glm::max(t0, t1);
+	float entry = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+	float exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, maxDistance));
+	return (entry <= exit) ? entry : -1.0f;
+}
+
+}
+
+void Bvh_Build(Bvh& bvh, const BvhAabb* bounds, uint32_t count) {
+	if (bounds == nullptr) {
+		count = 0;
+	}
+	bvh.mObjectBounds.assign(bounds, bounds + count);
+	Rebuild(bvh);
+}
+
+void Bvh_SetObjectBounds(Bvh& bvh, uint32_t object, const BvhAabb& bounds) {
+	if (object >= bvh.mObjectBounds.size()) {
+		return;
+	}
+	bvh.mObjectBounds[object] = bounds;
+	const uint32_t leaf = bvh.mObjectLeaves[object];
+	if ((bvh.mNodeFlags[leaf] & cFlagDirtyLeaf) == 0) {
+		bvh.mNodeFlags[leaf] |= cFlagDirtyLeaf;
+		bvh.mDirtyLeaves.push_back(leaf);
+	}
+}
+
+uint32_t Bvh_Refit(Bvh& bvh) {
+	uint32_t updated = 0;
+	for (uint32_t leaf : bvh.mDirtyLeaves) {
+		bvh.mNodeFlags[leaf] &= ~cFlagDirtyLeaf;
+
+		BvhAabb bounds = LeafBounds(bvh, bvh.mNodes[leaf]);
+		uint32_t nodeIndex = leaf;
+		while (!Equal(bounds, bvh.mNodes[nodeIndex].mBounds)) {
+			bvh.mNodes[nodeIndex].mBounds = bounds;
+			updated++;
+			nodeIndex = bvh.mNodes[nodeIndex].mParent;
+			if (nodeIndex == cInvalidHandle) {
+				break;
+			}
+			const BvhNode& node = bvh.mNodes[nodeIndex];
+			bounds = Union(bvh.mNodes[node.mChildren[0]].mBounds, bvh.mNodes[node.mChildren[1]].mBounds);
+			if ((bvh.mNodeFlags[nodeIndex] & cFlagRotationCandidate) == 0) {
+				bvh.mNodeFlags[nodeIndex] |= cFlagRotationCandidate;
+				bvh.mRotationCandidates.push_back(nodeIndex);
+			}
+		}
+	}
+	bvh.mDirtyLeaves.clear();
+	return updated;
+}
+
+bool Bvh_Optimize(Bvh& bvh, float rebuildRatio) {
+	if (bvh.mRoot == cInvalidHandle) {
+		return false;
+	}
+
+	// candidates were queued walking up from the leaves, children mostly come before their parents
+	for (uint32_t nodeIndex : bvh.mRotationCandidates) {
+		bvh.mNodeFlags[nodeIndex] &= ~cFlagRotationCandidate;
+		Rotate(bvh, nodeIndex);
+	}
+	bvh.mRotationCandidates.clear();
+
+	if (Bvh_GetCost(bvh) > bvh.mBuildCost * rebuildRatio) {
+		Rebuild(bvh);
+		return true;
+	}
+	return false;
+}
+
+float Bvh_GetCost(const Bvh& bvh) {
+	if (bvh.mRoot == cInvalidHandle) {
+		return 0.0f;
+	}
+	const float rootArea = Area(bvh.mNodes[bvh.mRoot].mBounds);
+	if (rootArea <= 0.0f) {
+		return 0.0f;
+	}
+	float cost = 0.0f;
+	for (const BvhNode& node : bvh.mNodes) {
+		cost += Area(node.mBounds) * (IsLeaf(node) ? cObjectCost * float(node.mObjectsCount) : cTraversalCost);
+	}
+	return cost / rootArea;
+}
+
+uint32_t Bvh_CullFrustum(const Bvh& bvh, const Frustum& frustum, uint32_t* visible, BvhStats* stats) {
+	if (visible == nullptr || bvh.mRoot == cInvalidHandle) {
+		return 0;
+	}
+
+	struct Entry {
+		uint32_t mNode;
+		uint32_t mMask;
+	};
+	const uint32_t cAllPlanes = (1u << FrustumPlane::Count) - 1;
+
+	BvhStats cullStats;
+	uint32_t written = 0;
+	std::vector<Entry> stack;
+	std::vector<uint32_t> emitStack;
+	stack.reserve(64);
+	stack.push_back({ bvh.mRoot, cAllPlanes });
+	while (!stack.empty()) {
+		Entry entry = stack.back();
+		stack.pop_back();
+		const BvhNode& node = bvh.mNodes[entry.mNode];
+		cullStats.mNodesVisited++;
+
+		uint32_t mask = entry.mMask;
+		if (!TestPlanes(frustum, node.mBounds, mask, cullStats.mPlaneTests)) {
+			continue;
+		}
+		if (mask == 0) {
+			EmitSubtree(bvh, entry.mNode, visible, written, emitStack);
+			continue;
+		}
+		if (IsLeaf(node)) {
+			for (uint32_t i = 0; i < node.mObjectsCount; i++) {
+				const uint32_t object = bvh.mObjectIndices[node.mFirstObject + i];
+				uint32_t objectMask = mask;
+				cullStats.mObjectsTested++;
+				visible[written] = object;
+				written += TestPlanes(frustum, bvh.mObjectBounds[object], objectMask, cullStats.mPlaneTests) ? 1 : 0;
+			}
+			continue;
+		}
+		stack.push_back({ node.mChildren[0], mask });
+		stack.push_back({ node.mChildren[1], mask });
+	}
+
+	if (stats) {
+		*stats = cullStats;
+	}
+	return written;
+}
+
+bool Bvh_RayCast(const Bvh& bvh, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BvhRayHit& hit, const BvhRayCallback& callback) {
+	hit = BvhRayHit();
+	if (bvh.mRoot == cInvalidHandle) {
+		return false;
+	}
+
+	// divisions by zero give infinities, which the slab test handles
+	const glm::vec3 inverseDirection = 1.0f / direction;
+	float best = maxDistance;
+
+	struct Entry {
+		uint32_t mNode;
+		float mDistance;
+	};
+	std::vector<Entry> stack;
+	stack.reserve(64);
+	float rootDistance = IntersectRay(bvh.mNodes[bvh.mRoot].mBounds, origin, inverseDirection, best);
+	if (rootDistance >= 0.0f) {
+		stack.push_back({ bvh.mRoot, rootDistance });
+	}
+	while (!stack.empty()) {
+		Entry entry = stack.back();
+		stack.pop_back();
+		if (entry.mDistance > best) {
+			continue;
+		}
+		const BvhNode& node = bvh.mNodes[entry.mNode];
+		if (IsLeaf(node)) {
+			for (uint32_t i = 0; i < node.mObjectsCount; i++) {
+				const uint32_t object = bvh.mObjectIndices[node.mFirstObject + i];
+				float distance = IntersectRay(bvh.mObjectBounds[object], origin, inverseDirection, best);
+				if (distance < 0.0f) {
+					continue;
+				}
+				if (callback && !callback(object, distance)) {
+					continue;
+				}
+				if (distance <= best) {
+					best = distance;
+					hit.mObject = object;
+					hit.mDistance = distance;
+				}
+			}
+			continue;
+		}
+
+		float distances[2];
+		for (uint32_t child = 0; child < 2; child++) {
+			distances[child] = IntersectRay(bvh.mNodes[node.mChildren[child]].mBounds, origin, inverseDirection, best);
+		}
+		// push the farther child first so the nearer one is popped next
+		const uint32_t nearChild = (distances[0] >= 0.0f && (distances[1] < 0.0f || distances[0] <= distances[1])) ? 0 : 1;
+		const uint32_t farChild = 1 - nearChild;
+		if (distances[farChild] >= 0.0f) {
+			stack.push_back({ node.mChildren[farChild], distances[farChild] });
+		}
+		if (distances[nearChild] >= 0.0f) {
+			stack.push_back({ node.mChildren[nearChild], distances[nearChild] });
+		}
+	}
+	return hit.mObject != cInvalidHandle;
+}
+
+uint32_t Bvh_QueryAabb(const Bvh& bvh, const BvhAabb& box, std::vector<uint32_t>& results) {
+	if (bvh.mRoot == cInvalidHandle) {
+		return 0;
+	}
+	const size_t previous = results.size();
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(bvh.mRoot);
+	while (!stack.empty()) {
+		const BvhNode& node = bvh.mNodes[stack.back()];
+		stack.pop_back();
+		if (!Overlap(node.mBounds, box)) {
+			continue;
+		}
+		if (IsLeaf(node)) {
+			for (uint32_t i = 0; i < node.mObjectsCount; i++) {
+				const uint32_t object = bvh.mObjectIndices[node.mFirstObject + i];
+				if (Overlap(bvh.mObjectBounds[object], box)) {
+					results.push_back(object);
+				}
+			}
+		} else {
+			stack.push_back(node.mChildren[0]);
+			stack.push_back(node.mChildren[1]);
+		}
+	}
+	return static_cast<uint32_t>(results.size() - previous);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Frustum.h"
+#include "glm/vec3.hpp"
+
+#include <functional>
+#include <vector>
+
+static constexpr uint32_t cBvhMaxLeafObjects = 4;
+
+struct BvhAabb {
+	glm::vec3 mMin = glm::vec3(0.0f);
+	glm::vec3 mMax = glm::vec3(0.0f);
+};
+
+// Interior nodes reference their children by index so rotations can swap subtrees without moving nodes,
+// leaves (mObjectsCount > 0) own a range of mObjectIndices.
+struct BvhNode {
+	BvhAabb mBounds;
+	uint32_t mParent = cInvalidHandle;
+	uint32_t mChildren[2] = { cInvalidHandle, cInvalidHandle };
+	uint32_t mFirstObject = 0;
+	uint32_t mObjectsCount = 0;
+};
+
+struct Bvh {
+	std::vector<BvhNode> mNodes;
+	std::vector<uint32_t> mObjectIndices;
+	std::vector<BvhAabb> mObjectBounds;
+	std::vector<uint32_t> mObjectLeaves;			// leaf node of every object
+	std::vector<uint32_t> mDirtyLeaves;
+	std::vector<uint32_t> mRotationCandidates;		// interior nodes grown or shrunk by refits since the last optimize
+	std::vector<uint8_t> mNodeFlags;				// per node, avoids queuing a node twice
+	uint32_t mRoot = cInvalidHandle;
+	float mBuildCost = 0.0f;						// SAH cost right after the last build
+};
+
+struct BvhStats {
+	uint32_t mNodesVisited = 0;
+	uint32_t mPlaneTests = 0;
+	uint32_t mObjectsTested = 0;
+};
+
+struct BvhRayHit {
+	uint32_t mObject = cInvalidHandle;
+	float mDistance = 0.0f;
+};
+
+// Refines a ray hit against the object bounds: returns false to ignore the object, otherwise may shorten distance
+// (which holds the bounds entry distance) to the exact hit.
+using BvhRayCallback = std::function<bool(uint32_t object, float& distance)>;
+
+// Top-down build with a 16 bins SAH split over the object centroids. Object indices are 0 to count - 1.
+void Bvh_Build(Bvh& bvh, const BvhAabb* bounds, uint32_t count);
+
+// Records the new bounds of a moved object, the tree is updated by the next Bvh_Refit.
+void Bvh_SetObjectBounds(Bvh& bvh, uint32_t object, const BvhAabb& bounds);
+
+// Refits the nodes above the leaves of the moved objects, stopping where the bounds do not change anymore.
+// Returns the number of nodes updated.
+uint32_t Bvh_Refit(Bvh& bvh);
+
+// Refits degrade the tree: applies the rotations that lower the SAH cost of the nodes refitted since the last call,
+// and rebuilds from scratch when the cost has still grown past rebuildRatio times the cost of the last build.
+// Returns true on rebuild.
+bool Bvh_Optimize(Bvh& bvh, float rebuildRatio = 1.5f);
+
+// SAH cost of the tree: sum of the interior node areas relative to the root area, plus leaf object costs.
+float Bvh_GetCost(const Bvh& bvh);
+
+// Hierarchical culling, planes a node is fully inside of are not tested again in its subtree and a node inside
+// all of them emits its whole subtree. visible must have room for every object, returns the visible count.
+uint32_t Bvh_CullFrustum(const Bvh& bvh, const Frustum& frustum, uint32_t* visible, BvhStats* stats = nullptr);
+
+// Nearest object whose bounds are crossed by the ray within maxDistance. direction does not need to be normalized,
+// distances are in units of its length.
+bool Bvh_RayCast(const Bvh& bvh, const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BvhRayHit& hit, const BvhRayCallback& callback = nullptr);
+
+// Appends the objects whose bounds overlap box to results, returns how many were appended.
+uint32_t Bvh_QueryAabb(const Bvh& bvh, const BvhAabb& box, std::vector<uint32_t>& results);
@@ -0,0 +1,271 @@
+#include "CascadedShadows.h"
+
+#include "GLApi.h"
+#include "glm/geometric.hpp"
+#include "glm/trigonometric.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+
+constexpr float cRadiusGranularity = 1.0f / 16.0f;	// fitted radii are rounded up to it so float noise never changes them
+constexpr float cLightEpsilon = 1e-5f;
+
+const char* const cShadowMatrixNames[cMaxShadowCascades] = {
+	"u_shadowMatrices[0]", "u_shadowMatrices[1]", "u_shadowMatrices[2]", "u_shadowMatrices[3]"
+};
+
+// Maps clip space to [0, 1] texture coordinates and depth.
+const glm::mat4 cClipToTexture(
+	0.5f, 0.0f, 0.0f, 0.0f,
+	0.0f, 0.5f, 0.0f, 0.0f,
+	0.0f, 0.0f, 0.5f, 0.0f,
+	0.5f, 0.5f, 0.5f, 1.0f);
+
+// Blend of the logarithmic and uniform split distances.
+float SplitDistance(const CascadedShadowParams& params, float nearPlane, uint32_t index) {
+	const float ratio = float(index) / float(params.mCascadesCount);
+	const float logarithmic = nearPlane * std::pow(params.mMaxDistance / nearPlane, ratio);
+	const float uniform = nearPlane + (params.mMaxDistance - nearPlane) * ratio;
+	return params.mSplitLambda * logarithmic + (1.0f - params.mSplitLambda) * uniform;
+}
+
+// Smallest sphere around the frustum slice between two view distances, its center lies on the view axis at a
+// distance that only depends on the split and the field of view (k is the tangent to the frustum corners).
+void SliceSphere(float sliceNear, float sliceFar, float k, float& distance, float& radius) {
+	const float k2 = k * k;
+	distance = 0.5f * (sliceFar + sliceNear) * (1.0f + k2);
+	if (distance >= sliceFar) {
+		distance = sliceFar;
+		radius = sliceFar * k;
+	} else {
+		radius = std::sqrt((sliceFar - distance) * (sliceFar - distance) + sliceFar * sliceFar * k2);
+	}
+	radius = std::ceil(radius / cRadiusGranularity) * cRadiusGranularity;
+}
+
+glm::vec3 LightUp(const glm::vec3& lightDirection) {
+	return std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+// Orthographic projection around the sphere, moved by whole texels only: the center is snapped on the light space
+// xy grid and the eye is pushed back towards the light to catch the casters in front of the sphere.
+void FitCascade(ShadowCascade& cascade, const CascadedShadowParams& params, const glm::vec3& center, float radius, const glm::vec3& lightDirection) {
+	const glm::vec3 up = LightUp(lightDirection);
+	const glm::mat4 rotation = glm::lookAt(glm::vec3(0.0f), -lightDirection, up);
+	const float texel = 2.0f * radius / float(params.mResolution);
+	glm::vec3 lightCenter = glm::vec3(rotation * glm::vec4(center, 1.0f));
+	lightCenter.x = std::floor(lightCenter.x / texel) * texel;
+	lightCenter.y = std::floor(lightCenter.y / texel) * texel;
+	const glm::vec3 snapped = glm::vec3(glm::affineInverse(rotation) * glm::vec4(lightCenter, 1.0f));
+
+	const glm::vec3 eye = snapped + lightDirection * (radius + params.mCasterDistance);
+	const glm::mat4 view = glm::lookAt(eye, snapped, up);
+	const glm::mat4 projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + params.mCasterDistance);
+	cascade.mViewProjection = projection * view;
+	cascade.mCenter = snapped;
+	cascade.mRadius = radius;
+	cascade.mLightDirection = lightDirection;
+	cascade.mValid = true;
+}
+
+void RenderCascade(CascadedShadows& shadows, uint32_t index, const ShadowDrawCallback& draw) {
+	ShadowCascade& cascade = shadows.mCascades[index];
+	const GLint size = GLint(shadows.mParams.mResolution);
+	const GLint x = GLint(index % 2) * size;
+	const GLint y = GLint(index / 2) * size;
+	GL_CHECK(glViewport(x, y, size, size));
+	GL_CHECK(glScissor(x, y, size, size));
+	GL_CHECK(glClear(GL_DEPTH_BUFFER_BIT));
+
+	GpuTimer_Begin(cascade.mTimer);
+	cascade.mStats.mDraws = draw(index, cascade.mViewProjection, Frustum_FromMatrix(cascade.mViewProjection));
+	GpuTimer_End(cascade.mTimer);
+	cascade.mStats.mMilliseconds = GpuTimer_GetMilliseconds(cascade.mTimer);
+	cascade.mStats.mRenders++;
+	cascade.mDirty = false;
+}
+
+}
+
+bool CascadedShadows_Initialize(CascadedShadows& shadows, const CascadedShadowParams& params, const ShaderProgramHandle& depthProgram) {
+	shadows.mParams = params;
+	shadows.mParams.mCascadesCount = std::min(std::max(params.mCascadesCount, 2u), cMaxShadowCascades);
+	const uint32_t size = 2 * shadows.mParams.mResolution;
+	shadows.mShadowMap = Texture_CreateRenderTarget(size, size, TextureFormats::Depth32F);
+	// bilinear comparisons: every sample of the shader is already a 2 x 2 PCF
+	Texture_SetFilteringMode(shadows.mShadowMap, TextureFilteringMode::Bilinear);
+	Texture_SetShadowCompare(shadows.mShadowMap, true);
+
+	RenderTargetParams targetParams;
+	targetParams.mDepth = shadows.mShadowMap;
+	shadows.mTarget = RenderTarget_Create(targetParams);
+	if (!shadows.mTarget.IsValid()) {
+		return false;
+	}
+
+	// depth only, sloped offset against acne, the scissor keeps the clears inside the cascade tile
+	PipelineStateParams stateParams;
+	stateParams.mProgram = depthProgram;
+	stateParams.mBlend.mColorWriteMask = 0;
+	stateParams.mRaster.mScissorEnable = true;
+	stateParams.mRaster.mPolygonOffsetFactor = 2.0f;
+	stateParams.mRaster.mPolygonOffsetUnits = 4.0f;
+	shadows.mDepthState = PipelineState_Create(stateParams);
+
+	for (auto& cascade : shadows.mCascades) {
+		GpuTimer_Create(cascade.mTimer);
+	}
+	return true;
+}
+
+void CascadedShadows_Destroy(CascadedShadows& shadows) {
+	for (auto& cascade : shadows.mCascades) {
+		GpuTimer_Destroy(cascade.mTimer);
+	}
+	PipelineState_Destroy(shadows.mDepthState);
+	RenderTarget_Destroy(shadows.mTarget);
+	Texture_Destroy(shadows.mShadowMap);
+	shadows = CascadedShadows();
+}
+
+void CascadedShadows_SetParams(CascadedShadows& shadows, const CascadedShadowParams& params) {
+	const uint32_t resolution = shadows.mParams.mResolution;
+	shadows.mParams = params;
+	shadows.mParams.mCascadesCount = std::min(std::max(params.mCascadesCount, 2u), cMaxShadowCascades);
+	if (params.mResolution != resolution) {
+		RenderTarget_Resize(shadows.mTarget, 2 * params.mResolution, 2 * params.mResolution);
+	}
+	for (auto& cascade : shadows.mCascades) {
+		cascade.mValid = false;
+		cascade.mDirty = true;
+	}
+	shadows.mRoundRobin = 0;
+}
+
+void CascadedShadows_Update(CascadedShadows& shadows, const Camera& camera, float aspectRatio, float nearPlane, const glm::vec3& lightDirection, const ShadowDrawCallback& draw) {
+	const CascadedShadowParams& params = shadows.mParams;
+	const glm::vec3 light = glm::normalize(lightDirection);
+	const glm::mat4 cameraWorld = glm::affineInverse(camera.GetViewMatrix());
+	const glm::vec3 position = glm::vec3(cameraWorld[3]);
+	const glm::vec3 forward = -glm::vec3(cameraWorld[2]);
+	const float tanY = std::tan(0.5f * glm::radians(camera.GetFOV()));
+	const float k = tanY * std::sqrt(1.0f + aspectRatio * aspectRatio);
+
+	// a cascade is due when it was never rendered, its casters changed, the light turned or the slice it has to
+	// cover is no longer inside the sphere it was fitted to
+	glm::vec3 centers[cMaxShadowCascades];
+	float radii[cMaxShadowCascades];
+	float splits[cMaxShadowCascades + 1];
+	bool due[cMaxShadowCascades];
+	for (uint32_t i = 0; i < params.mCascadesCount; i++) {
+		ShadowCascade& cascade = shadows.mCascades[i];
+		splits[i] = SplitDistance(params, nearPlane, i);
+		splits[i + 1] = SplitDistance(params, nearPlane, i + 1);
+		float distance = 0.0f;
+		SliceSphere(splits[i], splits[i + 1], k, distance, radii[i]);
+		centers[i] = position + forward * distance;
+
+		const bool lightChanged = glm::length(light - cascade.mLightDirection) > cLightEpsilon;
+		const bool uncovered = glm::length(centers[i] - cascade.mCenter) + radii[i] > cascade.mRadius;
+		due[i] = !params.mCaching || !cascade.mValid || cascade.mDirty || lightChanged || uncovered;
+	}
+
+	// distant cascades cover many more texels per pixel, one of them refreshed per update is enough; without caching
+	// there is nothing to refresh in turn, all of them are rendered
+	const uint32_t firstRoundRobin = std::min(params.mFirstRoundRobin, params.mCascadesCount);
+	const uint32_t roundRobinCount = params.mCaching ? params.mCascadesCount - firstRoundRobin : 0;
+	for (uint32_t i = 0; i < roundRobinCount; i++) {
+		const uint32_t index = firstRoundRobin + (shadows.mRoundRobin + i) % roundRobinCount;
+		if (due[index]) {
+			for (uint32_t other = firstRoundRobin; other < params.mCascadesCount; other++) {
+				due[other] = other == index;
+			}
+			shadows.mRoundRobin = (index - firstRoundRobin + 1) % roundRobinCount;
+			break;
+		}
+	}
+
+	bool bound = false;
+	for (uint32_t i = 0; i < params.mCascadesCount; i++) {
+		ShadowCascade& cascade = shadows.mCascades[i];
+		if (!due[i]) {
+			cascade.mStats.mCachedFrames++;
+			continue;
+		}
+		if (!bound) {
+			RenderTarget_Bind(shadows.mTarget);
+			PipelineState_Apply(shadows.mDepthState);
+			bound = true;
+		}
+		// the margin lets the camera move a little before the cascade has to be fitted and rendered again
+		const float radius = params.mCaching ? std::ceil(radii[i] * (1.0f + params.mCacheMargin) / cRadiusGranularity) * cRadiusGranularity : radii[i];
+		FitCascade(cascade, params, centers[i], radius, light);
+		cascade.mSplitNear = splits[i];
+		cascade.mSplitFar = splits[i + 1];
+		RenderCascade(shadows, i, draw);
+	}
+	if (bound) {
+		PipelineState_ApplyRaster(RasterState());
+	}
+}
+
+void CascadedShadows_Invalidate(CascadedShadows& shadows, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+	for (uint32_t i = 0; i < shadows.mParams.mCascadesCount; i++) {
+		ShadowCascade& cascade = shadows.mCascades[i];
+		if (!cascade.mValid || cascade.mDirty) {
+			continue;
+		}
+		// orthographic, the box corners need no perspective divide
+		glm::vec3 clipMin(FLT_MAX);
+		glm::vec3 clipMax(-FLT_MAX);
+		for (uint32_t corner = 0; corner < 8; corner++) {
+			const glm::vec3 point((corner & 1) ? boundsMax.x : boundsMin.x, (corner & 2) ? boundsMax.y : boundsMin.y, (corner & 4) ? boundsMax.z : boundsMin.z);
+			const glm::vec3 clip = glm::vec3(cascade.mViewProjection * glm::vec4(point, 1.0f));
+			clipMin = glm::min(clipMin, clip);
+			clipMax = glm::max(clipMax, clip);
+		}
+		cascade.mDirty = clipMin.x <= 1.0f && clipMax.x >= -1.0f && clipMin.y <= 1.0f && clipMax.y >= -1.0f && clipMin.z <= 1.0f && clipMax.z >= -1.0f;
+	}
+}
+
+void CascadedShadows_InvalidateAll(CascadedShadows& shadows) {
+	for (auto& cascade : shadows.mCascades) {
+		cascade.mDirty = true;
+	}
+}
+
+void CascadedShadows_Bind(const CascadedShadows& shadows, const ShaderProgramHandle& program, uint8_t stage, const glm::mat4& view) {
+	Texture_Bind(shadows.mShadowMap, stage);
+	ShaderProgram_SetInt(program, "u_shadowMap", stage);
+	ShaderProgram_SetInt(program, "u_shadowCascadesCount", int(shadows.mParams.mCascadesCount));
+	ShaderProgram_SetFloat(program, "u_shadowTexelSize", 1.0f / float(2 * shadows.mParams.mResolution));
+
+	const glm::mat4 viewToWorld = glm::affineInverse(view);
+	for (uint32_t i = 0; i < shadows.mParams.mCascadesCount; i++) {
+		const ShadowCascade& cascade = shadows.mCascades[i];
+		// a cascade never rendered maps everything outside of it
+		glm::mat4 matrix(0.0f);
+		matrix[3] = glm::vec4(-1.0f, -1.0f, -1.0f, 1.0f);
+		if (cascade.mValid) {
+			matrix = cClipToTexture * cascade.mViewProjection * viewToWorld;
+		}
+		ShaderProgram_SetMat4(program, cShadowMatrixNames[i], matrix);
+	}
+}
+
+const ShadowCascadeStats& CascadedShadows_GetStats(const CascadedShadows& shadows, uint32_t cascade) {
+	return shadows.mCascades[std::min(cascade, cMaxShadowCascades - 1)].mStats;
+}
+
+void CascadedShadows_ResetStats(CascadedShadows& shadows) {
+	for (auto& cascade : shadows.mCascades) {
+		cascade.mStats.mRenders = 0;
+		cascade.mStats.mCachedFrames = 0;
+	}
+}
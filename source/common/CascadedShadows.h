@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Camera.h"
+#include "Frustum.h"
+#include "GpuTimer.h"
+#include "PipelineState.h"
+#include "RenderTarget.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <functional>
+
+static constexpr uint32_t cMaxShadowCascades = 4;
+
+struct CascadedShadowParams {
+	uint32_t mCascadesCount = 4;				// 2 to cMaxShadowCascades
+	uint32_t mResolution = 1024;				// per cascade, the shadow map is a 2 x 2 atlas of them
+	float mMaxDistance = 80.0f;					// view distance covered by the last cascade
+	float mSplitLambda = 0.8f;					// blend between uniform (0) and logarithmic (1) splits
+	float mCasterDistance = 100.0f;				// how far towards the light casters are still rendered
+	float mCacheMargin = 0.1f;					// extra radius fitted around a slice so the camera can move without a refit
+	uint32_t mFirstRoundRobin = 2;				// with caching, cascades from this one on update at most one per frame
+	bool mCaching = true;						// off, every cascade is refitted and rendered every frame, without margin
+};
+
+struct ShadowCascadeStats {
+	uint32_t mDraws = 0;						// draws issued by the last render of the cascade
+	uint32_t mRenders = 0;						// since the last CascadedShadows_ResetStats
+	uint32_t mCachedFrames = 0;					// updates that reused the cascade as it was
+	double mMilliseconds = 0.0;					// GPU time of a recent render
+};
+
+// A cascade covers the bounding sphere of a slice of the view frustum with a square orthographic projection. The
+// sphere radius only depends on the split distances and the field of view, and its center is snapped to whole shadow
+// texels in light space, so the rasterization of the casters does not change when the camera moves or rotates.
+struct ShadowCascade {
+	glm::mat4 mViewProjection = glm::mat4(1.0f);
+	glm::vec3 mCenter = glm::vec3(0.0f);		// snapped center of the fitted sphere
+	float mRadius = 0.0f;
+	float mSplitNear = 0.0f;
+	float mSplitFar = 0.0f;
+	glm::vec3 mLightDirection = glm::vec3(0.0f);
+	bool mValid = false;						// fitted and rendered at least once
+	bool mDirty = true;							// casters inside changed since the last render
+	GpuTimer mTimer;
+	ShadowCascadeStats mStats;
+};
+
+// Directional light shadows. Each cascade is rendered again only when the light moved, a caster inside it was
+// invalidated or the camera left the area it covers, the first mFirstRoundRobin cascades as soon as that happens and
+// the distant ones in turn, one per update. Without caching every cascade is rendered on every update.
+struct CascadedShadows {
+	CascadedShadowParams mParams;
+	TextureHandle mShadowMap = TextureHandle(cInvalidHandle);
+	RenderTargetHandle mTarget = RenderTargetHandle(cInvalidHandle);
+	PipelineStateHandle mDepthState = PipelineStateHandle(cInvalidHandle);
+	ShadowCascade mCascades[cMaxShadowCascades];
+	uint32_t mRoundRobin = 0;					// next distant cascade considered for an update
+};
+
+// Renders the casters of a cascade with the depth program, view projection and culling frustum given, returns the
+// number of draws issued.
+using ShadowDrawCallback = std::function<uint32_t(uint32_t cascade, const glm::mat4& viewProjection, const Frustum& frustum)>;
+
+// depthProgram takes the light view projection in u_viewProjection (see 16-shadow_depth.vs).
+bool CascadedShadows_Initialize(CascadedShadows& shadows, const CascadedShadowParams& params, const ShaderProgramHandle& depthProgram);
+
+void CascadedShadows_Destroy(CascadedShadows& shadows);
+
+// The cascade count and splits may change, the cascades are invalidated.
+void CascadedShadows_SetParams(CascadedShadows& shadows, const CascadedShadowParams& params);
+
+// Fits the cascades to the camera frustum and renders the ones due with the depth state, through the callback.
+// lightDirection points towards the light. Leaves the shadow map target bound.
+void CascadedShadows_Update(CascadedShadows& shadows, const Camera& camera, float aspectRatio, float nearPlane, const glm::vec3& lightDirection, const ShadowDrawCallback& draw);
+
+// Marks the cascades overlapping a world space box, e.g. the bounds of a caster before and after it moved.
+void CascadedShadows_Invalidate(CascadedShadows& shadows, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+void CascadedShadows_InvalidateAll(CascadedShadows& shadows);
+
+// Binds the shadow map to a sampler2DShadow and sets the u_shadow* uniforms of 16-shadows.fs, the matrices take
+// view space positions so the view matrix is the one the program is drawn with.
+void CascadedShadows_Bind(const CascadedShadows& shadows, const ShaderProgramHandle& program, uint8_t stage, const glm::mat4& view);
+
+const ShadowCascadeStats& CascadedShadows_GetStats(const CascadedShadows& shadows, uint32_t cascade);
+
+void CascadedShadows_ResetStats(CascadedShadows& shadows);
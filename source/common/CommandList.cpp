@@ -0,0 +1,179 @@
+#include "CommandList.h"
+
+#include <cstring>
+
+namespace
+{
+
+struct CommandHeader {
+	uint16_t mType;
+	uint16_t mSize;
+};
+
+struct BindProgramCommand {
+	CommandHeader mHeader;
+	ShaderProgramHandle mProgram;
+};
+
+struct BindTextureCommand {
+	CommandHeader mHeader;
+	TextureHandle mTexture;
+	uint32_t mStage;
+};
+
+struct BindUniformRangeCommand {
+	CommandHeader mHeader;
+	uint32_t mBinding;
+	uint32_t mOffset;					// relative to the uniform memory of the list
+	uint32_t mSize;
+};
+
+struct DrawCommand {
+	CommandHeader mHeader;
+	MeshHandle mMesh;
+	uint32_t mFirstIndex;
+	uint32_t mCount;					// index count for DrawRange, instance count for DrawInstanced
+};
+
+template<typename T>
+T& Append(CommandList& list, CommandType::Enum type) {
+	static_assert(sizeof(T) % 4 == 0, "commands must keep 4 bytes alignment");
+	size_t offset = list.mCommands.size();
+	list.mCommands.resize(offset + sizeof(T));
+	T* command = reinterpret_cast<T*>(list.mCommands.data() + offset);
+	command->mHeader.mType = static_cast<uint16_t>(type);
+	command->mHeader.mSize = static_cast<uint16_t>(sizeof(T));
+	list.mCount++;
+	return *command;
+}
+
+std::vector<uint8_t> sUniformsStaging;
+
+}
+
+void CommandList_Reset(CommandList& list) {
+	list.mCommands.clear();
+	list.mUniforms.clear();
+	list.mCount = 0;
+}
+
+void CommandList_BindProgram(CommandList& list, const ShaderProgramHandle& program) {
+	BindProgramCommand& command = Append<BindProgramCommand>(list, CommandType::BindProgram);
+	command.mProgram = program;
+}
+
+void CommandList_BindTexture(CommandList& list, const TextureHandle& texture, uint8_t stage) {
+	BindTextureCommand& command = Append<BindTextureCommand>(list, CommandType::BindTexture);
+	command.mTexture = texture;
+	command.mStage = stage;
+}
+
+void CommandList_SetUniformBlock(CommandList& list, uint32_t binding, const void* data, uint32_t size) {
+	if (data == nullptr || size == 0) {
+		return;
+	}
+	size_t offset = (list.mUniforms.size() + cCommandListUniformAlignment - 1) & ~size_t(cCommandListUniformAlignment - 1);
+	list.mUniforms.resize(offset + size);
+	std::memcpy(list.mUniforms.data() + offset, data, size);
+
+	BindUniformRangeCommand& command = Append<BindUniformRangeCommand>(list, CommandType::BindUniformRange);
+	command.mBinding = binding;
+	command.mOffset = static_cast<uint32_t>(offset);
+	command.mSize = size;
+}
+
+void CommandList_Draw(CommandList& list, const MeshHandle& mesh) {
+	DrawCommand& command = Append<DrawCommand>(list, CommandType::Draw);
+	command.mMesh = mesh;
+	command.mFirstIndex = 0;
+	command.mCount = 0;
+}
+
+void CommandList_DrawRange(CommandList& list, const MeshHandle& mesh, uint32_t firstIndex, uint32_t indexCount) {
+	DrawCommand& command = Append<DrawCommand>(list, CommandType::DrawRange);
+	command.mMesh = mesh;
+	command.mFirstIndex = firstIndex;
+	command.mCount = indexCount;
+}
+
+void CommandList_DrawInstanced(CommandList& list, const MeshHandle& mesh, uint32_t instanceCount) {
+	DrawCommand& command = Append<DrawCommand>(list, CommandType::DrawInstanced);
+	command.mMesh = mesh;
+	command.mFirstIndex = 0;
+	command.mCount = instanceCount;
+}
+
+uint32_t CommandList_Execute(const CommandList* lists, uint32_t listsCount, const BufferHandle& uniformBuffer) {
+	if (lists == nullptr) {
+		return 0;
+	}
+
+	// lists are packed back to back, every base stays aligned so the recorded offsets only need rebasing
+	sUniformsStaging.clear();
+	for (uint32_t i = 0; i < listsCount; i++) {
+		const CommandList& list = lists[i];
+		size_t base = (sUniformsStaging.size() + cCommandListUniformAlignment - 1) & ~size_t(cCommandListUniformAlignment - 1);
+		sUniformsStaging.resize(base + list.mUniforms.size());
+		if (!list.mUniforms.empty()) {
+			std::memcpy(sUniformsStaging.data() + base, list.mUniforms.data(), list.mUniforms.size());
+		}
+	}
+	if (!sUniformsStaging.empty()) {
+		Buffer_Update(uniformBuffer, 0, sUniformsStaging.data(), static_cast<uint32_t>(sUniformsStaging.size()));
+	}
+
+	uint32_t executed = 0;
+	size_t uniformsBase = 0;
+	ShaderProgramHandle program = ShaderProgramHandle(cInvalidHandle);
+	for (uint32_t i = 0; i < listsCount; i++) {
+		const CommandList& list = lists[i];
+		uniformsBase = (uniformsBase + cCommandListUniformAlignment - 1) & ~size_t(cCommandListUniformAlignment - 1);
+
+		const uint8_t* current = list.mCommands.data();
+		const uint8_t* end = current + list.mCommands.size();
+		while (current < end) {
+			const CommandHeader* header = reinterpret_cast<const CommandHeader*>(current);
+			switch (header->mType) {
+			case CommandType::BindProgram: {
+				const BindProgramCommand* command = reinterpret_cast<const BindProgramCommand*>(current);
+				if (command->mProgram.mHandle != program.mHandle) {
+					program = command->mProgram;
+					ShaderProgram_Use(program);
+				}
+				break;
+			}
+			case CommandType::BindTexture: {
+				const BindTextureCommand* command = reinterpret_cast<const BindTextureCommand*>(current);
+				Texture_Bind(command->mTexture, static_cast<uint8_t>(command->mStage));
+				break;
+			}
+			case CommandType::BindUniformRange: {
+				const BindUniformRangeCommand* command = reinterpret_cast<const BindUniformRangeCommand*>(current);
+				Buffer_BindRange(uniformBuffer, command->mBinding, static_cast<uint32_t>(uniformsBase + command->mOffset), command->mSize);
+				break;
+			}
+			case CommandType::Draw: {
+				const DrawCommand* command = reinterpret_cast<const DrawCommand*>(current);
+				Mesh_Draw(command->mMesh);
+				break;
+			}
+			case CommandType::DrawRange: {
+				const DrawCommand* command = reinterpret_cast<const DrawCommand*>(current);
+				Mesh_DrawRange(command->mMesh, command->mFirstIndex, command->mCount);
+				break;
+			}
+			case CommandType::DrawInstanced: {
+				const DrawCommand* command = reinterpret_cast<const DrawCommand*>(current);
+				Mesh_DrawInstanced(command->mMesh, command->mCount);
+				break;
+			}
+			default:
+				break;
+			}
+			current += header->mSize;
+			executed++;
+		}
+		uniformsBase += list.mUniforms.size();
+	}
+	return executed;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+
+#include <vector>
+
+// Upper bound of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT on the implementations we target, uniform ranges recorded in
+// a list start on this boundary so they can be bound without knowing the context limits while recording.
+static constexpr uint32_t cCommandListUniformAlignment = 256;
+
+struct CommandType {
+	enum Enum {
+		BindProgram,
+		BindTexture,
+		BindUniformRange,
+		Draw,
+		DrawRange,
+		DrawInstanced,
+		Count
+	};
+};
+
+// A stream of POD commands recorded without touching GL, so any thread can fill its own list. Memory is linear
+// and kept across CommandList_Reset, after the first frames recording does not allocate.
+struct CommandList {
+	std::vector<uint8_t> mCommands;
+	std::vector<uint8_t> mUniforms;
+	uint32_t mCount = 0;
+};
+
+void CommandList_Reset(CommandList& list);
+
+void CommandList_BindProgram(CommandList& list, const ShaderProgramHandle& program);
+
+void CommandList_BindTexture(CommandList& list, const TextureHandle& texture, uint8_t stage);
+
+// Copies data into the list uniform memory and records a bind of that range to the uniform block binding point.
+void CommandList_SetUniformBlock(CommandList& list, uint32_t binding, const void* data, uint32_t size);
+
+void CommandList_Draw(CommandList& list, const MeshHandle& mesh);
+
+void CommandList_DrawRange(CommandList& list, const MeshHandle& mesh, uint32_t firstIndex, uint32_t indexCount);
+
+void CommandList_DrawInstanced(CommandList& list, const MeshHandle& mesh, uint32_t instanceCount);
+
+// GL thread only: uploads the uniform memory of all lists into uniformBuffer with a single update, then replays
+// the lists in array order. Returns the number of commands executed.
+uint32_t CommandList_Execute(const CommandList* lists, uint32_t listsCount, const BufferHandle& uniformBuffer);
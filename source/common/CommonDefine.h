@@ -41,7 +41,7 @@ struct ResourceHandle {
 
 	ResourceHandle& operator=(const ResourceHandle&) = default;
 
-	inline const bool IsValid() const { return mHandle != cInvalidHandle; }
+	inline bool IsValid() const { return mHandle != cInvalidHandle; }
 
 	uint32_t mHandle = 0;
 };
\ No newline at end of file
@@ -0,0 +1,476 @@
+#include "Context.h"
+
+#include "GLApi.h"
+#include "GLRecorder.h"
+
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+namespace
+{
+
+// Loads the GL functions of the current context, through the recorder when asked to.
+bool LoadFunctions(Context& context, GLADloadproc loader) {
+	if (context.mParams.mRecordCalls) {
+		GLRecorderParams params;
+		params.mMode = GLRecorderMode::Forward;
+		params.mLoader = loader;
+		params.mStreamFile = context.mParams.mRecordStream;
+		if (!GLRecorder_Initialize(params)) {
+			return false;
+		}
+		loader = GLRecorder_GetProcAddress;
+	}
+	if (!gladLoadGLLoader(loader)) {
+		return false;
+	}
+	// the version and extension queries of glad are not part of the measures
+	GLRecorder_ResetStats();
+	return true;
+}
+
+// The headless libraries are loaded at runtime so that neither their headers nor their import libraries are needed to
+// build, only the few entry points and enums used below are declared.
+#if !defined(_WIN32)
+using EGLDisplay = void*;
+using EGLConfig = void*;
+using EGLContext = void*;
+using EGLSurface = void*;
+using EGLint = int32_t;
+using EGLBoolean = uint32_t;
+using EGLenum = uint32_t;
+
+constexpr EGLint cEglNone = 0x3038;
+constexpr EGLint cEglExtensions = 0x3055;
+constexpr EGLint cEglSurfaceType = 0x3033;
+constexpr EGLint cEglPbufferBit = 0x0001;
+constexpr EGLint cEglRenderableType = 0x3040;
+constexpr EGLint cEglOpenGLBit = 0x0008;
+constexpr EGLint cEglRedSize = 0x3024;
+constexpr EGLint cEglGreenSize = 0x3023;
+constexpr EGLint cEglBlueSize = 0x3022;
+constexpr EGLint cEglAlphaSize = 0x3021;
+constexpr EGLint cEglDepthSize = 0x3025;
+constexpr EGLint cEglStencilSize = 0x3026;
+constexpr EGLint cEglWidth = 0x3057;
+constexpr EGLint cEglHeight = 0x3056;
+constexpr EGLint cEglContextMajorVersion = 0x3098;
+constexpr EGLint cEglContextMinorVersion = 0x30FB;
+constexpr EGLint cEglContextProfileMask = 0x30FD;
+constexpr EGLint cEglContextCoreProfileBit = 0x0001;
+constexpr EGLenum cEglOpenGLApi = 0x30A2;
+constexpr EGLenum cEglPlatformSurfacelessMesa = 0x31DD;
+
+using PFN_eglGetProcAddress = void* (*)(const char*);
+using PFN_eglGetError = EGLint (*)();
+using PFN_eglQueryString = const char* (*)(EGLDisplay, EGLint);
+using PFN_eglGetDisplay = EGLDisplay (*)(void*);
+using PFN_eglGetPlatformDisplayEXT = EGLDisplay (*)(EGLenum, void*, const EGLint*);
+using PFN_eglInitialize = EGLBoolean (*)(EGLDisplay, EGLint*, EGLint*);
+using PFN_eglTerminate = EGLBoolean (*)(EGLDisplay);
+using PFN_eglBindAPI = EGLBoolean (*)(EGLenum);
+using PFN_eglChooseConfig = EGLBoolean (*)(EGLDisplay, const EGLint*, EGLConfig*, EGLint, EGLint*);
+using PFN_eglCreateContext = EGLContext (*)(EGLDisplay, EGLConfig, EGLContext, const EGLint*);
+using PFN_eglDestroyContext = EGLBoolean (*)(EGLDisplay, EGLContext);
+using PFN_eglCreatePbufferSurface = EGLSurface (*)(EGLDisplay, EGLConfig, const EGLint*);
+using PFN_eglDestroySurface = EGLBoolean (*)(EGLDisplay, EGLSurface);
+using PFN_eglMakeCurrent = EGLBoolean (*)(EGLDisplay, EGLSurface, EGLSurface, EGLContext);
+
+constexpr int cOSMesaFormat = 0x22;
+constexpr int cOSMesaDepthBits = 0x30;
+constexpr int cOSMesaStencilBits = 0x31;
+constexpr int cOSMesaAccumBits = 0x32;
+constexpr int cOSMesaProfile = 0x33;
+constexpr int cOSMesaCoreProfile = 0x34;
+constexpr int cOSMesaContextMajorVersion = 0x36;
+constexpr int cOSMesaContextMinorVersion = 0x37;
+
+using PFN_OSMesaCreateContextAttribs = void* (*)(const int*, void*);
+using PFN_OSMesaDestroyContext = void (*)(void*);
+using PFN_OSMesaMakeCurrent = uint8_t (*)(void*, void*, GLenum, GLsizei, GLsizei);
+using PFN_OSMesaGetProcAddress = void* (*)(const char*);
+
+// glad loaders take no user data
+PFN_eglGetProcAddress sEglGetProcAddress = nullptr;
+PFN_OSMesaGetProcAddress sOSMesaGetProcAddress = nullptr;
+
+void* EglGetProcAddress(const char* name) {
+	// core entry points included, EGL_KHR_get_all_proc_addresses is exposed by Mesa and the desktop vendors
+	return sEglGetProcAddress(name);
+}
+
+void* OSMesaGetProcAddress(const char* name) {
+	return sOSMesaGetProcAddress(name);
+}
+
+void* OpenLibrary(const char* const* names, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		void* library = dlopen(names[i], RTLD_NOW | RTLD_LOCAL);
+		if (library != nullptr) {
+			return library;
+		}
+	}
+	Log(tinyngine::Logger::Error, "Failed to load %s", dlerror());
+	return nullptr;
+}
+
+template<typename T>
+bool LoadFunction(void* library, const char* name, T& function) {
+	function = reinterpret_cast<T>(dlsym(library, name));
+	if (function == nullptr) {
+		Log(tinyngine::Logger::Error, "Missing %s", name);
+		return false;
+	}
+	return true;
+}
+
+bool HasExtension(const char* extensions, const char* name) {
+	const size_t length = std::strlen(name);
+	for (const char* it = extensions; it != nullptr && *it != '\0';) {
+		const char* end = std::strchr(it, ' ');
+		const size_t itLength = (end != nullptr) ? size_t(end - it) : std::strlen(it);
+		if (itLength == length && std::strncmp(it, name, length) == 0) {
+			return true;
+		}
+		it = (end != nullptr) ? end + 1 : nullptr;
+	}
+	return false;
+}
+
+bool CreateEgl(Context& context, bool surfaceless) {
+	static const char* const cLibraries[] = { "libEGL.so.1", "libEGL.so" };
+	context.mLibrary = OpenLibrary(cLibraries, 2);
+	if (context.mLibrary == nullptr) {
+		return false;
+	}
+
+	PFN_eglGetError eglGetError = nullptr;
+	PFN_eglQueryString eglQueryString = nullptr;
+	PFN_eglGetDisplay eglGetDisplay = nullptr;
+	PFN_eglInitialize eglInitialize = nullptr;
+	PFN_eglBindAPI eglBindAPI = nullptr;
+	PFN_eglChooseConfig eglChooseConfig = nullptr;
+	PFN_eglCreateContext eglCreateContext = nullptr;
+	PFN_eglCreatePbufferSurface eglCreatePbufferSurface = nullptr;
+	PFN_eglMakeCurrent eglMakeCurrent = nullptr;
+	if (!LoadFunction(context.mLibrary, "eglGetProcAddress", sEglGetProcAddress) ||
+		!LoadFunction(context.mLibrary, "eglGetError", eglGetError) ||
+		!LoadFunction(context.mLibrary, "eglQueryString", eglQueryString) ||
+		!LoadFunction(context.mLibrary, "eglGetDisplay", eglGetDisplay) ||
+		!LoadFunction(context.mLibrary, "eglInitialize", eglInitialize) ||
+		!LoadFunction(context.mLibrary, "eglBindAPI", eglBindAPI) ||
+		!LoadFunction(context.mLibrary, "eglChooseConfig", eglChooseConfig) ||
+		!LoadFunction(context.mLibrary, "eglCreateContext", eglCreateContext) ||
+		!LoadFunction(context.mLibrary, "eglCreatePbufferSurface", eglCreatePbufferSurface) ||
+		!LoadFunction(context.mLibrary, "eglMakeCurrent", eglMakeCurrent)) {
+		return false;
+	}
+
+	const char* clientExtensions = eglQueryString(nullptr, cEglExtensions);
+	auto eglGetPlatformDisplayEXT = reinterpret_cast<PFN_eglGetPlatformDisplayEXT>(sEglGetProcAddress("eglGetPlatformDisplayEXT"));
+	const bool hasSurfacelessPlatform = HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless") && eglGetPlatformDisplayEXT != nullptr;
+	if (surfaceless && !hasSurfacelessPlatform) {
+		Log(tinyngine::Logger::Error, "EGL_MESA_platform_surfaceless is not supported");
+		return false;
+	}
+	EGLint major = 0;
+	EGLint minor = 0;
+	if (!surfaceless) {
+		// the default display needs a display server, Mesa also offers pbuffers on the surfaceless platform
+		context.mDisplay = eglGetDisplay(nullptr);
+		if (context.mDisplay == nullptr || !eglInitialize(context.mDisplay, &major, &minor)) {
+			context.mDisplay = nullptr;
+		}
+	}
+	if (context.mDisplay == nullptr && hasSurfacelessPlatform) {
+		context.mDisplay = eglGetPlatformDisplayEXT(cEglPlatformSurfacelessMesa, nullptr, nullptr);
+		if (context.mDisplay != nullptr && !eglInitialize(context.mDisplay, &major, &minor)) {
+			context.mDisplay = nullptr;
+		}
+	}
+	if (context.mDisplay == nullptr) {
+		Log(tinyngine::Logger::Error, "Failed to initialize the EGL display (0x%x)", eglGetError());
+		return false;
+	}
+	if (!eglBindAPI(cEglOpenGLApi)) {
+		Log(tinyngine::Logger::Error, "EGL %d.%d does not support desktop OpenGL", major, minor);
+		return false;
+	}
+
+	const EGLint configAttributes[] = {
+		cEglSurfaceType, surfaceless ? 0 : cEglPbufferBit,
+		cEglRenderableType, cEglOpenGLBit,
+		cEglRedSize, 8,
+		cEglGreenSize, 8,
+		cEglBlueSize, 8,
+		cEglAlphaSize, 8,
+		cEglDepthSize, surfaceless ? 0 : 24,
+		cEglStencilSize, surfaceless ? 0 : 8,
+		cEglNone
+	};
+	EGLConfig config = nullptr;
+	EGLint configsCount = 0;
+	if (!eglChooseConfig(context.mDisplay, configAttributes, &config, 1, &configsCount) || configsCount == 0) {
+		Log(tinyngine::Logger::Error, "No EGL config for desktop OpenGL (0x%x)", eglGetError());
+		return false;
+	}
+
+	const EGLint contextAttributes[] = {
+		cEglContextMajorVersion, 3,
+		cEglContextMinorVersion, 3,
+		cEglContextProfileMask, cEglContextCoreProfileBit,
+		cEglNone
+	};
+	context.mContext = eglCreateContext(context.mDisplay, config, nullptr, contextAttributes);
+	if (context.mContext == nullptr) {
+		Log(tinyngine::Logger::Error, "Failed to create a GL 3.3 core EGL context (0x%x)", eglGetError());
+		return false;
+	}
+
+	if (!surfaceless) {
+		const EGLint surfaceAttributes[] = {
+			cEglWidth, EGLint(context.mParams.mWidth),
+			cEglHeight, EGLint(context.mParams.mHeight),
+			cEglNone
+		};
+		context.mSurface = eglCreatePbufferSurface(context.mDisplay, config, surfaceAttributes);
+		if (context.mSurface == nullptr) {
+			Log(tinyngine::Logger::Error, "Failed to create the EGL pbuffer (0x%x)", eglGetError());
+			return false;
+		}
+	}
+	if (!eglMakeCurrent(context.mDisplay, context.mSurface, context.mSurface, context.mContext)) {
+		Log(tinyngine::Logger::Error, "Failed to make the EGL context current (0x%x)", eglGetError());
+		return false;
+	}
+	return LoadFunctions(context, EglGetProcAddress);
+}
+
+void DestroyEgl(Context& context) {
+	PFN_eglMakeCurrent eglMakeCurrent = reinterpret_cast<PFN_eglMakeCurrent>(dlsym(context.mLibrary, "eglMakeCurrent"));
+	PFN_eglDestroySurface eglDestroySurface = reinterpret_cast<PFN_eglDestroySurface>(dlsym(context.mLibrary, "eglDestroySurface"));
+	PFN_eglDestroyContext eglDestroyContext = reinterpret_cast<PFN_eglDestroyContext>(dlsym(context.mLibrary, "eglDestroyContext"));
+	PFN_eglTerminate eglTerminate = reinterpret_cast<PFN_eglTerminate>(dlsym(context.mLibrary, "eglTerminate"));
+	if (context.mDisplay == nullptr || eglMakeCurrent == nullptr || eglDestroySurface == nullptr || eglDestroyContext == nullptr ||
+		eglTerminate == nullptr) {
+		return;
+	}
+	eglMakeCurrent(context.mDisplay, nullptr, nullptr, nullptr);
+	if (context.mSurface != nullptr) {
+		eglDestroySurface(context.mDisplay, context.mSurface);
+	}
+	if (context.mContext != nullptr) {
+		eglDestroyContext(context.mDisplay, context.mContext);
+	}
+	eglTerminate(context.mDisplay);
+}
+
+bool CreateOSMesa(Context& context) {
+	static const char* const cLibraries[] = { "libOSMesa.so.8", "libOSMesa.so.6", "libOSMesa.so" };
+	context.mLibrary = OpenLibrary(cLibraries, 3);
+	if (context.mLibrary == nullptr) {
+		return false;
+	}
+
+	PFN_OSMesaCreateContextAttribs osMesaCreateContextAttribs = nullptr;
+	PFN_OSMesaMakeCurrent osMesaMakeCurrent = nullptr;
+	if (!LoadFunction(context.mLibrary, "OSMesaGetProcAddress", sOSMesaGetProcAddress) ||
+		!LoadFunction(context.mLibrary, "OSMesaCreateContextAttribs", osMesaCreateContextAttribs) ||
+		!LoadFunction(context.mLibrary, "OSMesaMakeCurrent", osMesaMakeCurrent)) {
+		return false;
+	}
+
+	const int attributes[] = {
+		cOSMesaFormat, GL_RGBA,
+		cOSMesaDepthBits, 24,
+		cOSMesaStencilBits, 8,
+		cOSMesaAccumBits, 0,
+		cOSMesaProfile, cOSMesaCoreProfile,
+		cOSMesaContextMajorVersion, 3,
+		cOSMesaContextMinorVersion, 3,
+		0
+	};
+	context.mContext = osMesaCreateContextAttribs(attributes, nullptr);
+	if (context.mContext == nullptr) {
+		Log(tinyngine::Logger::Error, "Failed to create a GL 3.3 core OSMesa context");
+		return false;
+	}
+	context.mPixels.resize(size_t(context.mParams.mWidth) * context.mParams.mHeight * 4);
+	if (!osMesaMakeCurrent(context.mContext, context.mPixels.data(), GL_UNSIGNED_BYTE, GLsizei(context.mParams.mWidth),
+		GLsizei(context.mParams.mHeight))) {
+		Log(tinyngine::Logger::Error, "Failed to make the OSMesa context current");
+		return false;
+	}
+	return LoadFunctions(context, OSMesaGetProcAddress);
+}
+
+void DestroyOSMesa(Context& context) {
+	PFN_OSMesaDestroyContext osMesaDestroyContext = reinterpret_cast<PFN_OSMesaDestroyContext>(dlsym(context.mLibrary, "OSMesaDestroyContext"));
+	if (context.mContext != nullptr && osMesaDestroyContext != nullptr) {
+		osMesaDestroyContext(context.mContext);
+	}
+}
+#endif
+
+bool CreateGlfwWindow(Context& context) {
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+	context.mWindow = glfwCreateWindow(int(context.mParams.mWidth), int(context.mParams.mHeight), context.mParams.mTitle, NULL, NULL);
+	if (context.mWindow == NULL) {
+		Log(tinyngine::Logger::Error, "Failed to create GLFW window");
+		return false;
+	}
+	glfwMakeContextCurrent(context.mWindow);
+	glfwSwapInterval(context.mParams.mVsync ? 1 : 0);
+
+	if (!LoadFunctions(context, (GLADloadproc)glfwGetProcAddress)) {
+		Log(tinyngine::Logger::Error, "Failed to initialize GLAD");
+		return false;
+	}
+	return true;
+}
+
+bool CreateNull(Context& context) {
+	GLRecorderParams params;
+	params.mStreamFile = context.mParams.mRecordStream;
+	if (!GLRecorder_Initialize(params) || !gladLoadGLLoader(GLRecorder_GetProcAddress)) {
+		return false;
+	}
+	GLRecorder_ResetStats();
+	return true;
+}
+
+// The headless backends get the same kind of target on all of them: the surfaceless one has no default framebuffer,
+// and rendering the pbuffer and OSMesa ones into textures too keeps the timings comparable.
+bool CreateBackbuffer(Context& context) {
+	const uint32_t width = context.mParams.mWidth;
+	const uint32_t height = context.mParams.mHeight;
+	context.mColor = Texture_CreateRenderTarget(width, height, TextureFormats::RGBA8);
+	context.mDepth = Texture_CreateRenderTarget(width, height, TextureFormats::Depth24Stencil8);
+	RenderTargetParams params;
+	params.mColors[0] = context.mColor;
+	params.mColorsCount = 1;
+	params.mDepth = context.mDepth;
+	context.mBackbuffer = RenderTarget_Create(params);
+	if (!context.mBackbuffer.IsValid()) {
+		Log(tinyngine::Logger::Error, "Failed to create the headless backbuffer");
+		return false;
+	}
+	RenderTarget_SetDefault(context.mBackbuffer);
+	RenderTarget_BindDefault(width, height);
+	return true;
+}
+
+}
+
+bool Context_ParseBackend(const char* name, ContextBackend::Enum& backend) {
+	for (uint32_t i = 0; i < ContextBackend::Count; i++) {
+		if (std::strcmp(name, Context_GetBackendName(ContextBackend::Enum(i))) == 0) {
+			backend = ContextBackend::Enum(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* Context_GetBackendName(ContextBackend::Enum backend) {
+	static const char* const cNames[ContextBackend::Count] = { "window", "egl", "egl-pbuffer", "osmesa", "null" };
+	return (backend < ContextBackend::Count) ? cNames[backend] : "<unknown>";
+}
+
+bool Context_Create(Context& context, const ContextParams& params) {
+	context = Context();
+	context.mParams = params;
+	if (params.mWidth == 0 || params.mHeight == 0) {
+		return false;
+	}
+
+	bool created = false;
+	switch (params.mBackend) {
+	case ContextBackend::Window:
+		created = CreateGlfwWindow(context);
+		break;
+#if !defined(_WIN32)
+	case ContextBackend::EglSurfaceless:
+	case ContextBackend::EglPbuffer:
+		created = CreateEgl(context, params.mBackend == ContextBackend::EglSurfaceless);
+		break;
+	case ContextBackend::OSMesa:
+		created = CreateOSMesa(context);
+		break;
+#endif
+	case ContextBackend::Null:
+		created = CreateNull(context);
+		break;
+	default:
+		Log(tinyngine::Logger::Error, "%s is not supported on this platform", Context_GetBackendName(params.mBackend));
+		break;
+	}
+
+	if (created && Context_IsHeadless(context)) {
+		created = CreateBackbuffer(context);
+	}
+	if (!created) {
+		Context_Destroy(context);
+	}
+	return created;
+}
+
+void Context_Destroy(Context& context) {
+	if (context.mBackbuffer.IsValid()) {
+		RenderTarget_SetDefault(RenderTargetHandle(cInvalidHandle));
+		RenderTarget_Destroy(context.mBackbuffer);
+		Texture_Destroy(context.mDepth);
+		Texture_Destroy(context.mColor);
+	}
+
+	if (context.mParams.mBackend == ContextBackend::Window) {
+		glfwTerminate();
+	}
+#if !defined(_WIN32)
+	if (context.mLibrary != nullptr) {
+		if (context.mParams.mBackend == ContextBackend::OSMesa) {
+			DestroyOSMesa(context);
+		} else {
+			DestroyEgl(context);
+		}
+		dlclose(context.mLibrary);
+	}
+#endif
+	if (context.mParams.mRecordCalls || context.mParams.mBackend == ContextBackend::Null) {
+		GLRecorder_Shutdown();
+	}
+	context = Context();
+}
+
+bool Context_IsHeadless(const Context& context) {
+	return context.mParams.mBackend != ContextBackend::Window;
+}
+
+bool Context_ShouldClose(const Context& context) {
+	return context.mWindow != nullptr && glfwWindowShouldClose(context.mWindow);
+}
+
+void Context_EndFrame(Context& context) {
+	if (context.mWindow != nullptr) {
+		glfwSwapBuffers(context.mWindow);
+		glfwPollEvents();
+	} else {
+		glFinish();
+	}
+}
+
+void Context_LogInfo(const Context& context) {
+	Log(tinyngine::Logger::Information, "%s: %s, %s, %s", Context_GetBackendName(context.mParams.mBackend),
+		reinterpret_cast<const char*>(glGetString(GL_VENDOR)), reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+		reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "RenderTarget.h"
+#include "Texture.h"
+
+#include <vector>
+
+struct GLFWwindow;
+
+// Window is the GLFW window every sample opens. The headless backends need no display server and load their library
+// at runtime, so they run on build servers with Mesa llvmpipe:
+// - EglSurfaceless: EGL_MESA_platform_surfaceless, no default framebuffer at all;
+// - EglPbuffer: the default EGL display with a pbuffer surface;
+// - OSMesa: software rendering into a client memory buffer;
+// - Null: no GL at all, the GLRecorder null GL counts the calls (needs the TINYNGINE_GL_RECORDER build option).
+struct ContextBackend {
+	enum Enum {
+		Window,
+		EglSurfaceless,
+		EglPbuffer,
+		OSMesa,
+		Null,
+
+		Count
+	};
+};
+
+struct ContextParams {
+	ContextBackend::Enum mBackend = ContextBackend::Window;
+	uint32_t mWidth = 800;
+	uint32_t mHeight = 600;
+	const char* mTitle = "LearnOpenGL";
+	bool mVsync = true;							// window only
+	bool mRecordCalls = false;					// through GLRecorder, always on for the null backend
+	const char* mRecordStream = nullptr;		// optional GLRecorder stream file
+};
+
+// Headless backends render into a backbuffer target that RenderTarget_BindDefault binds in place of the window
+// framebuffer.
+struct Context {
+	ContextParams mParams;
+	GLFWwindow* mWindow = nullptr;
+	void* mLibrary = nullptr;					// libEGL or libOSMesa
+	void* mDisplay = nullptr;
+	void* mSurface = nullptr;
+	void* mContext = nullptr;
+	std::vector<uint8_t> mPixels;				// OSMesa color buffer
+	TextureHandle mColor = TextureHandle(cInvalidHandle);
+	TextureHandle mDepth = TextureHandle(cInvalidHandle);
+	RenderTargetHandle mBackbuffer = RenderTargetHandle(cInvalidHandle);
+};
+
+// Parses a name returned by Context_GetBackendName, returns false for anything else.
+bool Context_ParseBackend(const char* name, ContextBackend::Enum& backend);
+
+// "window", "egl" (surfaceless), "egl-pbuffer", "osmesa" or "null".
+const char* Context_GetBackendName(ContextBackend::Enum backend);
+
+// Creates a GL 3.3 core context, makes it current and loads the GL functions. Returns false, after logging why,
+// when the backend is not available.
+bool Context_Create(Context& context, const ContextParams& params);
+
+void Context_Destroy(Context& context);
+
+bool Context_IsHeadless(const Context& context);
+
+// Always false for headless backends, they run for as many frames as the caller wants.
+bool Context_ShouldClose(const Context& context);
+
+// Swaps the window buffers and polls its events. Headless backends have nothing to present, they wait for the GPU
+// instead so that frame times measured around the call include the rendering.
+void Context_EndFrame(Context& context);
+
+// Vendor, renderer and version strings of the context.
+void Context_LogInfo(const Context& context);
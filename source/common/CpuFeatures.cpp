@@ -0,0 +1,75 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace
+{
+
+struct CpuFeatures {
+	bool mSSE41 = false;
+	bool mAVX2 = false;
+};
+
+void CpuId(uint32_t leaf, uint32_t subleaf, uint32_t registers[4]) {
+#if defined(_MSC_VER)
+	int values[4];
+	__cpuidex(values, int(leaf), int(subleaf));
+	for (uint32_t i = 0; i < 4; i++) {
+		registers[i] = uint32_t(values[i]);
+	}
+#else
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+uint64_t ReadXCR0() {
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (uint64_t(edx) << 32) | eax;
+#endif
+}
+
+CpuFeatures Detect() {
+	CpuFeatures features;
+	uint32_t registers[4];
+	CpuId(0, 0, registers);
+	const uint32_t maxLeaf = registers[0];
+	if (maxLeaf < 1) {
+		return features;
+	}
+
+	CpuId(1, 0, registers);
+	features.mSSE41 = (registers[2] & (1u << 19)) != 0;
+	const bool osxsave = (registers[2] & (1u << 27)) != 0;
+	const bool avx = (registers[2] & (1u << 28)) != 0;
+	const bool fma = (registers[2] & (1u << 12)) != 0;
+	// the OS has to save the ymm registers too
+	const bool ymmEnabled = osxsave && ((ReadXCR0() & 0x6) == 0x6);
+	if (maxLeaf >= 7 && avx && fma && ymmEnabled) {
+		CpuId(7, 0, registers);
+		features.mAVX2 = (registers[1] & (1u << 5)) != 0;
+	}
+	return features;
+}
+
+const CpuFeatures& GetFeatures() {
+	static const CpuFeatures sFeatures = Detect();
+	return sFeatures;
+}
+
+}
+
+bool Cpu_HasSSE41() {
+	return GetFeatures().mSSE41;
+}
+
+bool Cpu_HasAVX2() {
+	return GetFeatures().mAVX2;
+}
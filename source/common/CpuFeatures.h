@@ -0,0 +1,17 @@
+#pragma once
+
+#include "CommonDefine.h"
+
+// Functions using AVX2 intrinsics are compiled for AVX2 individually and only called after Cpu_HasAVX2(),
+// the rest of the code keeps targeting the build baseline (SSE2). They call _mm256_zeroupper() before returning:
+// GCC only inserts vzeroupper from -O2 on, and without it the SSE code running after them pays the AVX to SSE
+// transition penalty.
+#if defined(_MSC_VER)
+#define TINYNGINE_TARGET_AVX2
+#else
+#define TINYNGINE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+bool Cpu_HasSSE41();
+
+bool Cpu_HasAVX2();
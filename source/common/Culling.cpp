@@ -0,0 +1,312 @@
+#include "Culling.h"
+
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <cstring>
+
+namespace
+{
+
+// below this many objects per thread running slices as jobs costs more than it saves
+constexpr uint32_t cMinObjectsPerThread = 8192;
+
+const char* cPathNames[CullingPath::Count] = {
+	"SCALAR",
+	"SSE",
+	"AVX2",
+};
+
+CullingPath::Enum DetectBestPath() {
+	if (Cpu_HasAVX2()) {
+		return CullingPath::AVX2;
+	}
+	// SSE2 is the build baseline
+	return CullingPath::SSE;
+}
+
+CullingPath::Enum sBestPath = DetectBestPath();
+CullingPath::Enum sPath = sBestPath;
+
+// Planes splatted once per call, every lane of a register holds the same plane component.
+struct PlanesScalar {
+	float mX[FrustumPlane::Count];
+	float mY[FrustumPlane::Count];
+	float mZ[FrustumPlane::Count];
+	float mW[FrustumPlane::Count];
+	float mAbsX[FrustumPlane::Count];
+	float mAbsY[FrustumPlane::Count];
+	float mAbsZ[FrustumPlane::Count];
+};
+
+PlanesScalar MakePlanes(const Frustum& frustum) {
+	PlanesScalar planes;
+	for (uint32_t i = 0; i < FrustumPlane::Count; i++) {
+		const glm::vec4& plane = frustum.mPlanes[i];
+		planes.mX[i] = plane.x;
+		planes.mY[i] = plane.y;
+		planes.mZ[i] = plane.z;
+		planes.mW[i] = plane.w;
+		planes.mAbsX[i] = plane.x < 0.0f ? -plane.x : plane.x;
+		planes.mAbsY[i] = plane.y < 0.0f ? -plane.y : plane.y;
+		planes.mAbsZ[i] = plane.z < 0.0f ? -plane.z : plane.z;
+	}
+	return planes;
+}
+
+// Writes the lane indices of the set mask bits without branching on the mask.
+inline uint32_t Compact(uint32_t mask, uint32_t lanes, uint32_t base, uint32_t* visible, uint32_t written) {
+	for (uint32_t lane = 0; lane < lanes; lane++) {
+		visible[written] = base + lane;
+		written += (mask >> lane) & 1;
+	}
+	return written;
+}
+
+uint32_t SpheresScalar(const PlanesScalar& planes, const CullingSpheres& spheres, uint32_t begin, uint32_t end, uint32_t* visible, uint32_t written) {
+	for (uint32_t i = begin; i < end; i++) {
+		const float x = spheres.mCenterX[i];
+		const float y = spheres.mCenterY[i];
+		const float z = spheres.mCenterZ[i];
+		const float radius = spheres.mRadius[i];
+		bool inside = true;
+		for (uint32_t p = 0; p < FrustumPlane::Count; p++) {
+			inside &= (planes.mX[p] * x + planes.mY[p] * y + planes.mZ[p] * z + planes.mW[p] + radius) >= 0.0f;
+		}
+		visible[written] = i;
+		written += inside ? 1 : 0;
+	}
+	return written;
+}
+
+uint32_t BoxesScalar(const PlanesScalar& planes, const CullingBoxes& boxes, uint32_t begin, uint32_t end, uint32_t* visible, uint32_t written) {
+	for (uint32_t i = begin; i < end; i++) {
+		const float x = boxes.mCenterX[i];
+		const float y = boxes.mCenterY[i];
+		const float z = boxes.mCenterZ[i];
+		const float ex = boxes.mExtentX[i];
+		const float ey = boxes.mExtentY[i];
+		const float ez = boxes.mExtentZ[i];
+		bool inside = true;
+		for (uint32_t p = 0; p < FrustumPlane::Count; p++) {
+			// projected radius of the box on the plane normal
+			const float radius = planes.mAbsX[p] * ex + planes.mAbsY[p] * ey + planes.mAbsZ[p] * ez;
+			inside &= (planes.mX[p] * x + planes.mY[p] * y + planes.mZ[p] * z + planes.mW[p] + radius) >= 0.0f;
+		}
+		visible[written] = i;
+		written += inside ? 1 : 0;
+	}
+	return written;
+}
+
+uint32_t SpheresSSE(const PlanesScalar& planes, const CullingSpheres& spheres, uint32_t begin, uint32_t end, uint32_t* visible, uint32_t written) {
+	const __m128 zero = _mm_setzero_ps();
+	uint32_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		const __m128 x = _mm_loadu_ps(&spheres.mCenterX[i]);
+		const __m128 y = _mm_loadu_ps(&spheres.mCenterY[i]);
+		const __m128 z = _mm_loadu_ps(&spheres.mCenterZ[i]);
+		const __m128 radius = _mm_loadu_ps(&spheres.mRadius[i]);
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for (uint32_t p = 0; p < FrustumPlane::Count; p++) {
+			__m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.mX[p]), x), _mm_set1_ps(planes.mW[p]));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.mY[p]), y));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.mZ[p]), z));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+		}
+		written = Compact(uint32_t(_mm_movemask_ps(inside)), 4, i, visible, written);
+	}
+	return SpheresScalar(planes, spheres, i, end, visible, written);
+}
+
+uint32_t BoxesSSE(const PlanesScalar& planes, const CullingBoxes& boxes, uint32_t begin, uint32_t end, uint32_t* visible, uint32_t written) {
+	const __m128 zero = _mm_setzero_ps();
+	uint32_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		const __m128 x = _mm_loadu_ps(&boxes.mCenterX[i]);
+		const __m128 y = _mm_loadu_ps(&boxes.mCenterY[i]);
+		const __m128 z = _mm_loadu_ps(&boxes.mCenterZ[i]);
+		const __m128 ex = _mm_loadu_ps(&boxes.mExtentX[i]);
+		const __m128 ey = _mm_loadu_ps(&boxes.mExtentY[i]);
+		const __m128 ez = _mm_loadu_ps(&boxes.mExtentZ[i]);
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for (uint32_t p = 0; p < FrustumPlane::Count; p++) {
+			__m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.mX[p]), x), _mm_set1_ps(planes.mW[p]));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.mY[p]), y));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.mZ[p]), z));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.mAbsX[p]), ex));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.mAbsY[p]), ey));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes.mAbsZ[p]), ez));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+		}
+		written = Compact(uint32_t(_mm_movemask_ps(inside)), 4, i, visible, written);
+	}
+	return BoxesScalar(planes, boxes, i, end, visible, written);
+}
+
+TINYNGINE_TARGET_AVX2
+uint32_t SpheresAVX2(const PlanesScalar& planes, const CullingSpheres& spheres, uint32_t begin, uint32_t end, uint32_t* visible, uint32_t written) {
+	const __m256 zero = _mm256_setzero_ps();
+	uint32_t i = begin;
+	for (; i + 8 <= end; i += 8) {
+		const __m256 x = _mm256_loadu_ps(&spheres.mCenterX[i]);
+		const __m256 y = _mm256_loadu_ps(&spheres.mCenterY[i]);
+		const __m256 z = _mm256_loadu_ps(&spheres.mCenterZ[i]);
+		const __m256 radius = _mm256_loadu_ps(&spheres.mRadius[i]);
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (uint32_t p = 0; p < FrustumPlane::Count; p++) {
+			__m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.mX[p]), x, _mm256_set1_ps(planes.mW[p]));
+			distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.mY[p]), y, distance);
+			distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.mZ[p]), z, distance);
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+		}
+		written = Compact(uint32_t(_mm256_movemask_ps(inside)), 8, i, visible, written);
+	}
+	_mm256_zeroupper();
+	return SpheresScalar(planes, spheres, i, end, visible, written);
+}
+
+TINYNGINE_TARGET_AVX2
+uint32_t BoxesAVX2(const PlanesScalar& planes, const CullingBoxes& boxes, uint32_t begin, uint32_t end, uint32_t* visible, uint32_t written) {
+	const __m256 zero = _mm256_setzero_ps();
+	uint32_t i = begin;
+	for (; i + 8 <= end; i += 8) {
+		const __m256 x = _mm256_loadu_ps(&boxes.mCenterX[i]);
+		const __m256 y = _mm256_loadu_ps(&boxes.mCenterY[i]);
+		const __m256 z = _mm256_loadu_ps(&boxes.mCenterZ[i]);
+		const __m256 ex = _mm256_loadu_ps(&boxes.mExtentX[i]);
+		const __m256 ey = _mm256_loadu_ps(&boxes.mExtentY[i]);
+		const __m256 ez = _mm256_loadu_ps(&boxes.mExtentZ[i]);
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (uint32_t p = 0; p < FrustumPlane::Count; p++) {
+			__m256 distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.mX[p]), x, _mm256_set1_ps(planes.mW[p]));
+			distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.mY[p]), y, distance);
+			distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.mZ[p]), z, distance);
+			distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.mAbsX[p]), ex, distance);
+			distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.mAbsY[p]), ey, distance);
+			distance = _mm256_fmadd_ps(_mm256_set1_ps(planes.mAbsZ[p]), ez, distance);
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+		}
+		written = Compact(uint32_t(_mm256_movemask_ps(inside)), 8, i, visible, written);
+	}
+	_mm256_zeroupper();
+	return BoxesScalar(planes, boxes, i, end, visible, written);
+}
+
+using SpheresKernel = uint32_t(*)(const PlanesScalar&, const CullingSpheres&, uint32_t, uint32_t, uint32_t*, uint32_t);
+using BoxesKernel = uint32_t(*)(const PlanesScalar&, const CullingBoxes&, uint32_t, uint32_t, uint32_t*, uint32_t);
+
+const SpheresKernel cSpheresKernels[CullingPath::Count] = { SpheresScalar, SpheresSSE, SpheresAVX2 };
+const BoxesKernel cBoxesKernels[CullingPath::Count] = { BoxesScalar, BoxesSSE, BoxesAVX2 };
+
+// Every thread compacts its own slice in place, slices are then moved down next to each other. A slice never
+// moves up since the visible count before it is at most its first index.
+template<typename Volumes, typename Test>
+uint32_t TestParallel(const Volumes& volumes, uint32_t threadsCount, uint32_t* visible, Test test) {
+	const uint32_t count = volumes.mCount;
+	uint32_t maxThreads = count / cMinObjectsPerThread;
+	threadsCount = threadsCount < maxThreads ? threadsCount : maxThreads;
+	if (threadsCount <= 1) {
+		return test(0, count, visible);
+	}
+
+	std::vector<uint32_t> written(threadsCount, 0);
+	const uint32_t slice = (count + threadsCount - 1) / threadsCount;
+	Job_RunSlices(threadsCount, [&](uint32_t t) {
+		const uint32_t first = t * slice;
+		const uint32_t sliceCount = (first + slice < count) ? slice : count - first;
+		written[t] = test(first, sliceCount, visible + first);
+	});
+
+	uint32_t total = written[0];
+	for (uint32_t t = 1; t < threadsCount; t++) {
+		if (total != t * slice) {
+			std::memmove(visible + total, visible + t * slice, written[t] * sizeof(uint32_t));
+		}
+		total += written[t];
+	}
+	return total;
+}
+
+}
+
+void Culling_Resize(CullingSpheres& spheres, uint32_t count) {
+	spheres.mCenterX.resize(count);
+	spheres.mCenterY.resize(count);
+	spheres.mCenterZ.resize(count);
+	spheres.mRadius.resize(count);
+	spheres.mCount = count;
+}
+
+void Culling_Resize(CullingBoxes& boxes, uint32_t count) {
+	boxes.mCenterX.resize(count);
+	boxes.mCenterY.resize(count);
+	boxes.mCenterZ.resize(count);
+	boxes.mExtentX.resize(count);
+	boxes.mExtentY.resize(count);
+	boxes.mExtentZ.resize(count);
+	boxes.mCount = count;
+}
+
+void Culling_SetSphere(CullingSpheres& spheres, uint32_t index, const glm::vec3& center, float radius) {
+	spheres.mCenterX[index] = center.x;
+	spheres.mCenterY[index] = center.y;
+	spheres.mCenterZ[index] = center.z;
+	spheres.mRadius[index] = radius;
+}
+
+void Culling_SetBox(CullingBoxes& boxes, uint32_t index, const glm::vec3& minimum, const glm::vec3& maximum) {
+	const glm::vec3 center = (minimum + maximum) * 0.5f;
+	const glm::vec3 extent = (maximum - minimum) * 0.5f;
+	boxes.mCenterX[index] = center.x;
+	boxes.mCenterY[index] = center.y;
+	boxes.mCenterZ[index] = center.z;
+	boxes.mExtentX[index] = extent.x;
+	boxes.mExtentY[index] = extent.y;
+	boxes.mExtentZ[index] = extent.z;
+}
+
+CullingPath::Enum Culling_GetBestPath() {
+	return sBestPath;
+}
+
+void Culling_SetPath(CullingPath::Enum path) {
+	sPath = (path < CullingPath::Count && path <= sBestPath) ? path : sBestPath;
+}
+
+CullingPath::Enum Culling_GetPath() {
+	return sPath;
+}
+
+const char* Culling_GetPathName(CullingPath::Enum path) {
+	return (path < CullingPath::Count) ? cPathNames[path] : "UNKNOWN";
+}
+
+uint32_t Culling_TestSpheres(const Frustum& frustum, const CullingSpheres& spheres, uint32_t first, uint32_t count, uint32_t* visible) {
+	if (visible == nullptr || first >= spheres.mCount) {
+		return 0;
+	}
+	const uint32_t end = (count < spheres.mCount - first) ? first + count : spheres.mCount;
+	return cSpheresKernels[sPath](MakePlanes(frustum), spheres, first, end, visible, 0);
+}
+
+uint32_t Culling_TestBoxes(const Frustum& frustum, const CullingBoxes& boxes, uint32_t first, uint32_t count, uint32_t* visible) {
+	if (visible == nullptr || first >= boxes.mCount) {
+		return 0;
+	}
+	const uint32_t end = (count < boxes.mCount - first) ? first + count : boxes.mCount;
+	return cBoxesKernels[sPath](MakePlanes(frustum), boxes, first, end, visible, 0);
+}
+
+uint32_t Culling_TestSpheresParallel(const Frustum& frustum, const CullingSpheres& spheres, uint32_t threadsCount, uint32_t* visible) {
+	return TestParallel(spheres, threadsCount, visible, [&](uint32_t first, uint32_t count, uint32_t* output) {
+		return Culling_TestSpheres(frustum, spheres, first, count, output);
+	});
+}
+
+uint32_t Culling_TestBoxesParallel(const Frustum& frustum, const CullingBoxes& boxes, uint32_t threadsCount, uint32_t* visible) {
+	return TestParallel(boxes, threadsCount, visible, [&](uint32_t first, uint32_t count, uint32_t* output) {
+		return Culling_TestBoxes(frustum, boxes, first, count, output);
+	});
+}
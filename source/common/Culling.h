@@ -0,0 +1,61 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Frustum.h"
+
+#include <vector>
+
+// Bounding volumes are kept as structure of arrays so the kernels load 4 (SSE) or 8 (AVX2) objects with a single
+// load per component. Ranges that are not a multiple of the SIMD width finish on the scalar path.
+struct CullingSpheres {
+	std::vector<float> mCenterX;
+	std::vector<float> mCenterY;
+	std::vector<float> mCenterZ;
+	std::vector<float> mRadius;
+	uint32_t mCount = 0;
+};
+
+// Axis aligned boxes stored as center and half extents.
+struct CullingBoxes {
+	std::vector<float> mCenterX;
+	std::vector<float> mCenterY;
+	std::vector<float> mCenterZ;
+	std::vector<float> mExtentX;
+	std::vector<float> mExtentY;
+	std::vector<float> mExtentZ;
+	uint32_t mCount = 0;
+};
+
+struct CullingPath {
+	enum Enum {
+		Scalar,
+		SSE,		// 4 objects per iteration
+		AVX2,		// 8 objects per iteration
+		Count
+	};
+};
+
+void Culling_Resize(CullingSpheres& spheres, uint32_t count);
+void Culling_Resize(CullingBoxes& boxes, uint32_t count);
+
+void Culling_SetSphere(CullingSpheres& spheres, uint32_t index, const glm::vec3& center, float radius);
+void Culling_SetBox(CullingBoxes& boxes, uint32_t index, const glm::vec3& minimum, const glm::vec3& maximum);
+
+// The widest path supported by the CPU, selected once at startup.
+CullingPath::Enum Culling_GetBestPath();
+
+// Forces a path, used by benchmarks to compare them. Paths not supported by the CPU fall back to the best one.
+void Culling_SetPath(CullingPath::Enum path);
+CullingPath::Enum Culling_GetPath();
+
+const char* Culling_GetPathName(CullingPath::Enum path);
+
+// Tests the objects [first, first + count) and writes the indices of the visible ones to visible, which must have
+// room for count entries. Indices are written in increasing order, returns how many were written.
+uint32_t Culling_TestSpheres(const Frustum& frustum, const CullingSpheres& spheres, uint32_t first, uint32_t count, uint32_t* visible);
+uint32_t Culling_TestBoxes(const Frustum& frustum, const CullingBoxes& boxes, uint32_t first, uint32_t count, uint32_t* visible);
+
+// Splits the whole array in threadsCount slices run on the job system (the calling thread included), visible must
+// have room for every object. Small counts run on the calling thread only.
+uint32_t Culling_TestSpheresParallel(const Frustum& frustum, const CullingSpheres& spheres, uint32_t threadsCount, uint32_t* visible);
+uint32_t Culling_TestBoxesParallel(const Frustum& frustum, const CullingBoxes& boxes, uint32_t threadsCount, uint32_t* visible);
@@ -0,0 +1,268 @@
+#include "Deferred.h"
+
+#include "GLApi.h"
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+
+namespace
+{
+
+constexpr uint32_t cSphereSubdivisions = 2;		// 128 triangles
+constexpr uint8_t cGBufferStage = 0;			// albedo, normal and depth on three consecutive stages
+constexpr uint8_t cLightGridStage = 3;
+
+// Octahedron subdivided and pushed onto the unit sphere.
+void BuildSphere(std::vector<glm::vec3>& positions, std::vector<uint16_t>& indices) {
+	positions = { glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1) };
+	indices = { 0, 2, 4, 4, 2, 1, 1, 2, 5, 5, 2, 0, 4, 3, 0, 1, 3, 4, 5, 3, 1, 0, 3, 5 };
+	for (uint32_t level = 0; level < cSphereSubdivisions; level++) {
+		std::vector<uint16_t> subdivided;
+		subdivided.reserve(indices.size() * 4);
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			const uint16_t a = indices[i];
+			const uint16_t b = indices[i + 1];
+			const uint16_t c = indices[i + 2];
+			// edges are split once per triangle, the duplicated vertices are harmless for a light volume
+			const uint16_t ab = uint16_t(positions.size());
+			positions.push_back(glm::normalize(positions[a] + positions[b]));
+			const uint16_t bc = uint16_t(positions.size());
+			positions.push_back(glm::normalize(positions[b] + positions[c]));
+			const uint16_t ca = uint16_t(positions.size());
+			positions.push_back(glm::normalize(positions[c] + positions[a]));
+			const uint16_t triangles[] = { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca };
+			subdivided.insert(subdivided.end(), triangles, triangles + 12);
+		}
+		indices.swap(subdivided);
+	}
+}
+
+// Inverse of the distance from the center to the closest face, scaling the mesh by it puts every face outside of
+// the unit sphere.
+float CircumscribeScale(const std::vector<glm::vec3>& positions, const std::vector<uint16_t>& indices) {
+	float closest = 1.0f;
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		const glm::vec3& a = positions[indices[i]];
+		const glm::vec3 normal = glm::normalize(glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a));
+		closest = std::min(closest, std::abs(glm::dot(normal, a)));
+	}
+	return 1.0f / closest;
+}
+
+// Lets the shaders rebuild the view space position from the depth buffer: z = -w / (ndc + z), xy = ndc * -z * xy.
+glm::vec4 ProjectionParams(const glm::mat4& projection) {
+	return glm::vec4(1.0f / projection[0][0], 1.0f / projection[1][1], projection[2][2], projection[3][2]);
+}
+
+void SetGBufferUniforms(const DeferredRenderer& renderer, const ShaderProgramHandle& program, const glm::mat4& projection) {
+	Texture_Bind(renderer.mAlbedo, cGBufferStage);
+	Texture_Bind(renderer.mNormal, uint8_t(cGBufferStage + 1));
+	Texture_Bind(renderer.mDepth, uint8_t(cGBufferStage + 2));
+	ShaderProgram_SetInt(program, "u_gbufferAlbedo", cGBufferStage);
+	ShaderProgram_SetInt(program, "u_gbufferNormal", cGBufferStage + 1);
+	ShaderProgram_SetInt(program, "u_gbufferDepth", cGBufferStage + 2);
+	ShaderProgram_SetVec4(program, "u_projectionParams", ProjectionParams(projection));
+}
+
+void SetLightingUniforms(const ShaderProgramHandle& program, const DeferredLighting& lighting) {
+	ShaderProgram_SetVec3(program, "u_ambient", lighting.mAmbient);
+	ShaderProgram_SetVec3(program, "u_sunDirection", lighting.mSunDirection);
+	ShaderProgram_SetVec3(program, "u_sunColor", lighting.mSunColor);
+	ShaderProgram_SetVec3(program, "u_background", lighting.mBackground);
+	ShaderProgram_SetFloat(program, "u_shininess", lighting.mShininess);
+}
+
+}
+
+bool Deferred_Initialize(DeferredRenderer& renderer, const DeferredParams& params) {
+	renderer.mParams = params;
+	renderer.mAlbedo = Texture_CreateRenderTarget(params.mWidth, params.mHeight, TextureFormats::RGBA8);
+	renderer.mNormal = Texture_CreateRenderTarget(params.mWidth, params.mHeight, TextureFormats::RG16);
+	renderer.mDepth = Texture_CreateRenderTarget(params.mWidth, params.mHeight, TextureFormats::Depth24Stencil8);
+	renderer.mLighting = Texture_CreateRenderTarget(params.mWidth, params.mHeight, TextureFormats::RGBA16F);
+	renderer.mLightingDepth = Texture_CreateRenderTarget(params.mWidth, params.mHeight, TextureFormats::Depth24Stencil8);
+
+	RenderTargetParams gbufferParams;
+	gbufferParams.mColors[0] = renderer.mAlbedo;
+	gbufferParams.mColors[1] = renderer.mNormal;
+	gbufferParams.mColorsCount = 2;
+	gbufferParams.mDepth = renderer.mDepth;
+	renderer.mGBuffer = RenderTarget_Create(gbufferParams);
+
+	RenderTargetParams lightParams;
+	lightParams.mColors[0] = renderer.mLighting;
+	lightParams.mColorsCount = 1;
+	lightParams.mDepth = renderer.mLightingDepth;
+	renderer.mLightBuffer = RenderTarget_Create(lightParams);
+	if (!renderer.mGBuffer.IsValid() || !renderer.mLightBuffer.IsValid()) {
+		return false;
+	}
+
+	std::vector<glm::vec3> positions;
+	std::vector<uint16_t> indices;
+	BuildSphere(positions, indices);
+	renderer.mVolumeScale = CircumscribeScale(positions, indices);
+	renderer.mSphereVertices = Buffer_Create(BufferType::Vertex, positions.data(), uint32_t(positions.size() * sizeof(glm::vec3)));
+	renderer.mSphereIndices = Buffer_Create(BufferType::Index, indices.data(), uint32_t(indices.size() * sizeof(uint16_t)));
+	renderer.mInstances = Buffer_Create(BufferType::Vertex, nullptr, 1024 * 2 * sizeof(glm::vec4), BufferUsage::Stream);
+
+	MeshParams sphereParams;
+	sphereParams.mVertexBuffers[0] = renderer.mSphereVertices;
+	sphereParams.mVertexBuffers[1] = renderer.mInstances;
+	sphereParams.mVertexBuffersCount = 2;
+	sphereParams.mAttributesCount = 3;
+	sphereParams.mAttributes[0].mLocation = 0;
+	sphereParams.mAttributes[0].mComponents = 3;
+	sphereParams.mAttributes[0].mStride = sizeof(glm::vec3);
+	for (uint32_t i = 1; i < 3; i++) {
+		sphereParams.mAttributes[i].mLocation = uint8_t(i);
+		sphereParams.mAttributes[i].mBufferIndex = 1;
+		sphereParams.mAttributes[i].mComponents = 4;
+		sphereParams.mAttributes[i].mOffset = (i - 1) * sizeof(glm::vec4);
+		sphereParams.mAttributes[i].mStride = 2 * sizeof(glm::vec4);
+		sphereParams.mAttributes[i].mDivisor = 1;
+	}
+	sphereParams.mIndexBuffer = renderer.mSphereIndices;
+	sphereParams.mIndexFormat = IndexFormat::UInt16;
+	sphereParams.mIndexCount = uint32_t(indices.size());
+	renderer.mSphere = Mesh_Create(sphereParams);
+
+	// one triangle covering the screen
+	const float fullscreen[] = { -1.0f, -1.0f, 3.0f, -1.0f, -1.0f, 3.0f };
+	renderer.mFullscreenVertices = Buffer_Create(BufferType::Vertex, fullscreen, sizeof(fullscreen));
+	MeshParams fullscreenParams;
+	fullscreenParams.mVertexBuffers[0] = renderer.mFullscreenVertices;
+	fullscreenParams.mVertexBuffersCount = 1;
+	fullscreenParams.mAttributesCount = 1;
+	fullscreenParams.mAttributes[0].mComponents = 2;
+	fullscreenParams.mAttributes[0].mStride = 2 * sizeof(float);
+	fullscreenParams.mVertexCount = 3;
+	renderer.mFullscreen = Mesh_Create(fullscreenParams);
+
+	PipelineStateParams stateParams;
+	stateParams.mProgram = params.mAmbientProgram;
+	stateParams.mMesh = renderer.mFullscreen;
+	stateParams.mDepth.mTestEnable = false;
+	stateParams.mDepth.mWriteEnable = false;
+	renderer.mAmbientState = PipelineState_Create(stateParams);
+	stateParams.mProgram = params.mCompositeProgram;
+	renderer.mCompositeState = PipelineState_Create(stateParams);
+
+	// additive, the shader skips the background pixels
+	stateParams.mProgram = params.mTiledProgram;
+	stateParams.mBlend.mEnable = true;
+	stateParams.mBlend.mSrcColor = stateParams.mBlend.mSrcAlpha = BlendFactor::One;
+	stateParams.mBlend.mDstColor = stateParams.mBlend.mDstAlpha = BlendFactor::One;
+	renderer.mTiledState = PipelineState_Create(stateParams);
+
+	// back faces behind the scene: covers the pixels inside the volume wherever the camera is, inside included
+	stateParams.mProgram = params.mVolumeProgram;
+	stateParams.mMesh = renderer.mSphere;
+	stateParams.mDepth.mTestEnable = true;
+	stateParams.mDepth.mFunc = CompareFunc::GreaterEqual;
+	stateParams.mRaster.mCull = CullMode::Front;
+	renderer.mVolumeState = PipelineState_Create(stateParams);
+
+	return renderer.mSphere.IsValid() && renderer.mFullscreen.IsValid();
+}
+
+void Deferred_Destroy(DeferredRenderer& renderer) {
+	PipelineState_Destroy(renderer.mCompositeState);
+	PipelineState_Destroy(renderer.mVolumeState);
+	PipelineState_Destroy(renderer.mTiledState);
+	PipelineState_Destroy(renderer.mAmbientState);
+	Mesh_Destroy(renderer.mFullscreen);
+	Mesh_Destroy(renderer.mSphere);
+	Buffer_Destroy(renderer.mFullscreenVertices);
+	Buffer_Destroy(renderer.mInstances);
+	Buffer_Destroy(renderer.mSphereIndices);
+	Buffer_Destroy(renderer.mSphereVertices);
+	RenderTarget_Destroy(renderer.mLightBuffer);
+	RenderTarget_Destroy(renderer.mGBuffer);
+	Texture_Destroy(renderer.mLightingDepth);
+	Texture_Destroy(renderer.mLighting);
+	Texture_Destroy(renderer.mDepth);
+	Texture_Destroy(renderer.mNormal);
+	Texture_Destroy(renderer.mAlbedo);
+	renderer = DeferredRenderer();
+}
+
+void Deferred_Resize(DeferredRenderer& renderer, uint32_t width, uint32_t height) {
+	if (width == 0 || height == 0) {
+		return;
+	}
+	RenderTarget_Resize(renderer.mGBuffer, width, height);
+	RenderTarget_Resize(renderer.mLightBuffer, width, height);
+	renderer.mParams.mWidth = width;
+	renderer.mParams.mHeight = height;
+}
+
+void Deferred_BeginGeometry(DeferredRenderer& renderer) {
+	RenderTarget_Bind(renderer.mGBuffer);
+	PipelineState_ApplyDepth(DepthState());
+	PipelineState_ApplyBlend(BlendState());
+	// a zero normal and albedo is never read back, the background is told apart by its depth
+	GL_CHECK(glClearColor(0.0f, 0.0f, 0.0f, 0.0f));
+	GL_CHECK(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT));
+}
+
+void Deferred_Light(DeferredRenderer& renderer, const LightGrid& grid, const DeferredLighting& lighting, const glm::mat4& projection, DeferredMode::Enum mode) {
+	RenderTarget_Bind(renderer.mLightBuffer);
+	const glm::vec2 inverseSize(1.0f / float(renderer.mParams.mWidth), 1.0f / float(renderer.mParams.mHeight));
+
+	PipelineState_Apply(renderer.mAmbientState);
+	SetGBufferUniforms(renderer, renderer.mParams.mAmbientProgram, projection);
+	SetLightingUniforms(renderer.mParams.mAmbientProgram, lighting);
+	ShaderProgram_SetVec2(renderer.mParams.mAmbientProgram, "u_inverseScreenSize", inverseSize);
+	Mesh_Draw(renderer.mFullscreen);
+
+	renderer.mStats = DeferredStats();
+	if (mode == DeferredMode::LightVolumes) {
+		const uint32_t count = uint32_t(grid.mLightData.size() / 2);
+		renderer.mVolumes.clear();
+		for (uint32_t i = 0; i < count; i++) {
+			if (grid.mFirstSlice[i] <= grid.mLastSlice[i]) {
+				renderer.mVolumes.push_back(grid.mLightData[2 * i]);
+				renderer.mVolumes.push_back(grid.mLightData[2 * i + 1]);
+			}
+		}
+		renderer.mStats.mVolumes = uint32_t(renderer.mVolumes.size() / 2);
+		if (renderer.mStats.mVolumes == 0) {
+			return;
+		}
+		Buffer_Update(renderer.mInstances, 0, renderer.mVolumes.data(), uint32_t(renderer.mVolumes.size() * sizeof(glm::vec4)));
+		RenderTarget_BlitDepth(renderer.mGBuffer, renderer.mLightBuffer);
+
+		const ShaderProgramHandle& program = renderer.mParams.mVolumeProgram;
+		PipelineState_Apply(renderer.mVolumeState);
+		SetGBufferUniforms(renderer, program, projection);
+		ShaderProgram_SetFloat(program, "u_shininess", lighting.mShininess);
+		ShaderProgram_SetFloat(program, "u_volumeScale", renderer.mVolumeScale);
+		ShaderProgram_SetMat4(program, "u_projection", projection);
+		ShaderProgram_SetVec2(program, "u_inverseScreenSize", inverseSize);
+		Mesh_DrawInstanced(renderer.mSphere, renderer.mStats.mVolumes);
+	} else {
+		const ShaderProgramHandle& program = renderer.mParams.mTiledProgram;
+		PipelineState_Apply(renderer.mTiledState);
+		SetGBufferUniforms(renderer, program, projection);
+		ShaderProgram_SetFloat(program, "u_shininess", lighting.mShininess);
+		ShaderProgram_SetVec2(program, "u_inverseScreenSize", inverseSize);
+		LightGrid_Bind(grid, program, cLightGridStage, renderer.mParams.mWidth, renderer.mParams.mHeight);
+		Mesh_Draw(renderer.mFullscreen);
+	}
+}
+
+void Deferred_Composite(DeferredRenderer& renderer, DeferredView::Enum view, uint32_t width, uint32_t height, const glm::mat4& projection) {
+	RenderTarget_BindDefault(width, height);
+	const ShaderProgramHandle& program = renderer.mParams.mCompositeProgram;
+	PipelineState_Apply(renderer.mCompositeState);
+	SetGBufferUniforms(renderer, program, projection);
+	Texture_Bind(renderer.mLighting, uint8_t(cGBufferStage + 3));
+	ShaderProgram_SetInt(program, "u_lighting", cGBufferStage + 3);
+	ShaderProgram_SetInt(program, "u_view", int(view));
+	Mesh_Draw(renderer.mFullscreen);
+}
+
+const DeferredStats& Deferred_GetStats(const DeferredRenderer& renderer) {
+	return renderer.mStats;
+}
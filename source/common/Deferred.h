@@ -0,0 +1,108 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Buffer.h"
+#include "LightGrid.h"
+#include "Mesh.h"
+#include "PipelineState.h"
+#include "RenderTarget.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <vector>
+
+struct DeferredMode {
+	enum Enum {
+		LightVolumes,	// one instanced draw of spheres around the visible lights, shading the pixels they cover
+		Tiled,			// one full screen pass looping over the lights of the light grid cluster of each pixel
+		Count
+	};
+};
+
+struct DeferredView {
+	enum Enum {
+		Lighting,
+		Albedo,
+		Specular,
+		Normals,
+		Depth,
+		Count
+	};
+};
+
+// Programs of the passes, see the 15-deferred_* shaders in media.
+struct DeferredParams {
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	ShaderProgramHandle mAmbientProgram = ShaderProgramHandle(cInvalidHandle);
+	ShaderProgramHandle mVolumeProgram = ShaderProgramHandle(cInvalidHandle);
+	ShaderProgramHandle mTiledProgram = ShaderProgramHandle(cInvalidHandle);
+	ShaderProgramHandle mCompositeProgram = ShaderProgramHandle(cInvalidHandle);
+};
+
+// Lighting besides the point lights, directions are in view space like the lights of the grid.
+struct DeferredLighting {
+	glm::vec3 mAmbient = glm::vec3(0.02f);
+	glm::vec3 mSunDirection = glm::vec3(0.0f, 1.0f, 0.0f);	// towards the sun
+	glm::vec3 mSunColor = glm::vec3(0.0f);
+	glm::vec3 mBackground = glm::vec3(0.0f);
+	float mShininess = 32.0f;
+};
+
+struct DeferredStats {
+	uint32_t mVolumes = 0;						// light volumes drawn by the last DeferredMode::LightVolumes pass
+};
+
+// G-buffer of 12 bytes per pixel: albedo and specular intensity (RGBA8), octahedral view space normal (RG16) and
+// depth (Depth24Stencil8), from which the view space position is reconstructed. Lighting accumulates in an RGBA16F
+// target with a copy of that depth, so light volumes are depth tested against the scene while the shaders read the
+// G-buffer one (sampling a texture attached to the bound framebuffer is undefined before GL 4.5).
+struct DeferredRenderer {
+	DeferredParams mParams;
+	TextureHandle mAlbedo = TextureHandle(cInvalidHandle);
+	TextureHandle mNormal = TextureHandle(cInvalidHandle);
+	TextureHandle mDepth = TextureHandle(cInvalidHandle);
+	TextureHandle mLighting = TextureHandle(cInvalidHandle);
+	TextureHandle mLightingDepth = TextureHandle(cInvalidHandle);
+	RenderTargetHandle mGBuffer = RenderTargetHandle(cInvalidHandle);
+	RenderTargetHandle mLightBuffer = RenderTargetHandle(cInvalidHandle);
+
+	BufferHandle mSphereVertices = BufferHandle(cInvalidHandle);
+	BufferHandle mSphereIndices = BufferHandle(cInvalidHandle);
+	BufferHandle mInstances = BufferHandle(cInvalidHandle);
+	BufferHandle mFullscreenVertices = BufferHandle(cInvalidHandle);
+	MeshHandle mSphere = MeshHandle(cInvalidHandle);
+	MeshHandle mFullscreen = MeshHandle(cInvalidHandle);
+	float mVolumeScale = 1.0f;					// makes the sphere mesh circumscribe the light radius
+
+	PipelineStateHandle mAmbientState = PipelineStateHandle(cInvalidHandle);
+	PipelineStateHandle mVolumeState = PipelineStateHandle(cInvalidHandle);
+	PipelineStateHandle mTiledState = PipelineStateHandle(cInvalidHandle);
+	PipelineStateHandle mCompositeState = PipelineStateHandle(cInvalidHandle);
+
+	std::vector<glm::vec4> mVolumes;			// view position and radius, color, per visible light
+	DeferredStats mStats;
+};
+
+bool Deferred_Initialize(DeferredRenderer& renderer, const DeferredParams& params);
+
+void Deferred_Destroy(DeferredRenderer& renderer);
+
+void Deferred_Resize(DeferredRenderer& renderer, uint32_t width, uint32_t height);
+
+// Binds and clears the G-buffer. The geometry is then drawn with a program writing albedo and specular to output 0
+// and the encoded normal to output 1 (see 15-gbuffer.fs).
+void Deferred_BeginGeometry(DeferredRenderer& renderer);
+
+// Accumulates the ambient and sun lighting in a full screen pass, then adds the point lights of the last grid
+// build. The grid must have been uploaded for DeferredMode::Tiled. Light volumes reaching past the far plane are
+// clipped there, losing the pixels they would light behind it.
+void Deferred_Light(DeferredRenderer& renderer, const LightGrid& grid, const DeferredLighting& lighting, const glm::mat4& projection, DeferredMode::Enum mode);
+
+// Resolves the lighting, or one of the G-buffer channels, to the window framebuffer.
+void Deferred_Composite(DeferredRenderer& renderer, DeferredView::Enum view, uint32_t width, uint32_t height, const glm::mat4& projection);
+
+const DeferredStats& Deferred_GetStats(const DeferredRenderer& renderer);
@@ -0,0 +1,204 @@
+#include "DepthPrepass.h"
+
+#include <algorithm>
+
+namespace
+{
+
+uint32_t GetProbeFrames(const DepthPrepassParams& params) {
+	return std::max(params.mProbeFrames, cGpuTimerQueries + 1);
+}
+
+// The results read back during the first frames after a switch belong to the other way of drawing.
+bool IsSettled(const DepthPrepass& prepass) {
+	return prepass.mFramesRunning > cGpuTimerQueries;
+}
+
+// Sliding mean over as many frames as a probe measures, so both ways are compared over similar windows.
+void Accumulate(DepthPrepassMeasure& measure, double milliseconds, uint32_t window) {
+	if (measure.mFrames >= window) {
+		measure.mMilliseconds -= measure.mMilliseconds / double(measure.mFrames);
+		measure.mFrames--;
+	}
+	measure.mMilliseconds += milliseconds;
+	measure.mFrames++;
+}
+
+double GetMean(const DepthPrepassMeasure& measure) {
+	return (measure.mFrames > 0) ? measure.mMilliseconds / double(measure.mFrames) : 0.0;
+}
+
+void SetRunning(DepthPrepass& prepass, bool running) {
+	if (running != prepass.mRunning) {
+		prepass.mRunning = running;
+		prepass.mFramesRunning = 0;
+		prepass.mMeasures[running ? 1 : 0] = DepthPrepassMeasure();
+	}
+	prepass.mFramesRunning++;
+}
+
+void Decide(DepthPrepass& prepass) {
+	const double forward = GetMean(prepass.mMeasures[0]);
+	const double prepassed = GetMean(prepass.mMeasures[1]);
+	bool enabled = prepass.mEnabled;
+	if (forward > 0.0 && prepassed > 0.0) {
+		const double keep = 1.0 - double(prepass.mParams.mHysteresis);
+		enabled = prepass.mEnabled ? !(forward < prepassed * keep) : (prepassed < forward * keep);
+	} else {
+		// no timings, e.g. the results were not available in time
+		enabled = prepass.mOverdrawn;
+	}
+	if (enabled != prepass.mEnabled) {
+		prepass.mEnabled = enabled;
+		prepass.mStats.mSwitches++;
+	}
+	prepass.mOverdrawnAtProbe = prepass.mOverdrawn;
+	prepass.mFramesSinceProbe = 0;
+}
+
+void UpdateOverdraw(DepthPrepass& prepass) {
+	const uint64_t shaded = GpuTimer_GetResult(prepass.mShadingCounter);
+	if (prepass.mRunning) {
+		// after the pre-pass the shading pass touches every covered pixel once, the pre-pass sees the overdraw
+		if (shaded == 0) {
+			return;
+		}
+		prepass.mCoveredSamples = shaded;
+		prepass.mStats.mOverdraw = float(double(GpuTimer_GetResult(prepass.mDepthCounter)) / double(shaded));
+	} else if (prepass.mCoveredSamples > 0) {
+		// estimated from the coverage of the last frame measured with the pre-pass
+		prepass.mStats.mOverdraw = float(double(shaded) / double(prepass.mCoveredSamples));
+	}
+
+	const float threshold = prepass.mParams.mEnableOverdraw;
+	const float margin = threshold * prepass.mParams.mHysteresis;
+	if (prepass.mStats.mOverdraw > threshold + margin) {
+		prepass.mOverdrawn = true;
+	} else if (prepass.mStats.mOverdraw < threshold - margin) {
+		prepass.mOverdrawn = false;
+	}
+}
+
+}
+
+void DepthPrepass_Initialize(DepthPrepass& prepass, const DepthPrepassParams& params) {
+	prepass.mParams = params;
+
+	prepass.mDepthState = DepthState();
+	prepass.mShadingState = DepthState();
+	prepass.mShadingState.mWriteEnable = false;
+	prepass.mShadingState.mFunc = params.mShadingFunc;
+	prepass.mDepthBlend = BlendState();
+	prepass.mDepthBlend.mColorWriteMask = 0;
+
+	GpuTimer_Create(prepass.mDepthTimer);
+	GpuTimer_Create(prepass.mShadingTimers[0]);
+	GpuTimer_Create(prepass.mShadingTimers[1]);
+	GpuTimer_Create(prepass.mDepthCounter, GpuQueryTarget::SamplesPassed);
+	GpuTimer_Create(prepass.mShadingCounter, GpuQueryTarget::SamplesPassed);
+
+	prepass.mMeasures[0] = DepthPrepassMeasure();
+	prepass.mMeasures[1] = DepthPrepassMeasure();
+	prepass.mCoveredSamples = 0;
+	prepass.mEnabled = (params.mMode == DepthPrepassMode::On);
+	prepass.mOverdrawn = false;
+	prepass.mOverdrawnAtProbe = false;
+	prepass.mRunning = prepass.mEnabled;
+	prepass.mFramesRunning = 0;
+	// the first probe comes as soon as the initial way has been measured
+	prepass.mFramesSinceProbe = params.mProbeInterval - std::min(params.mProbeInterval, GetProbeFrames(params));
+	prepass.mProbeLeft = 0;
+	prepass.mStats = DepthPrepassStats();
+}
+
+void DepthPrepass_Destroy(DepthPrepass& prepass) {
+	GpuTimer_Destroy(prepass.mShadingCounter);
+	GpuTimer_Destroy(prepass.mDepthCounter);
+	GpuTimer_Destroy(prepass.mShadingTimers[1]);
+	GpuTimer_Destroy(prepass.mShadingTimers[0]);
+	GpuTimer_Destroy(prepass.mDepthTimer);
+}
+
+void DepthPrepass_SetMode(DepthPrepass& prepass, DepthPrepassMode::Enum mode) {
+	prepass.mParams.mMode = mode;
+	prepass.mProbeLeft = 0;
+	if (mode != DepthPrepassMode::Auto) {
+		prepass.mEnabled = (mode == DepthPrepassMode::On);
+	}
+}
+
+bool DepthPrepass_BeginFrame(DepthPrepass& prepass) {
+	const DepthPrepassParams& params = prepass.mParams;
+	bool running = prepass.mEnabled;
+	if (params.mMode != DepthPrepassMode::Auto) {
+		running = (params.mMode == DepthPrepassMode::On);
+	} else if (prepass.mProbeLeft > 0) {
+		prepass.mProbeLeft--;
+		if (prepass.mProbeLeft == 0) {
+			Decide(prepass);
+		}
+		running = (prepass.mProbeLeft > 0) ? !prepass.mEnabled : prepass.mEnabled;
+	} else {
+		prepass.mFramesSinceProbe++;
+		const bool crossed = (prepass.mOverdrawn != prepass.mOverdrawnAtProbe) && prepass.mFramesSinceProbe >= GetProbeFrames(params);
+		if (crossed || prepass.mFramesSinceProbe >= params.mProbeInterval) {
+			prepass.mProbeLeft = GetProbeFrames(params);
+			running = !prepass.mEnabled;
+		}
+	}
+	SetRunning(prepass, running);
+
+	prepass.mStats.mRunning = running;
+	prepass.mStats.mProbing = (prepass.mProbeLeft > 0);
+	return running;
+}
+
+void DepthPrepass_BeginDepth(DepthPrepass& prepass) {
+	PipelineState_ApplyDepth(prepass.mDepthState);
+	PipelineState_ApplyBlend(prepass.mDepthBlend);
+	GpuTimer_Begin(prepass.mDepthTimer);
+	GpuTimer_Begin(prepass.mDepthCounter);
+}
+
+void DepthPrepass_EndDepth(DepthPrepass& prepass) {
+	GpuTimer_End(prepass.mDepthCounter);
+	GpuTimer_End(prepass.mDepthTimer);
+}
+
+void DepthPrepass_BeginShading(DepthPrepass& prepass) {
+	const uint32_t way = prepass.mRunning ? 1 : 0;
+	PipelineState_ApplyDepth(prepass.mRunning ? prepass.mShadingState : DepthState());
+	PipelineState_ApplyBlend(BlendState());
+	GpuTimer_Begin(prepass.mShadingTimers[way]);
+	GpuTimer_Begin(prepass.mShadingCounter);
+
+	// both passes have read back the results of the same earlier frame by now
+	if (IsSettled(prepass)) {
+		UpdateOverdraw(prepass);
+		double milliseconds = GpuTimer_GetMilliseconds(prepass.mShadingTimers[way]);
+		if (prepass.mRunning) {
+			milliseconds += GpuTimer_GetMilliseconds(prepass.mDepthTimer);
+		}
+		if (milliseconds > 0.0) {
+			const uint32_t window = GetProbeFrames(prepass.mParams) - cGpuTimerQueries;
+			Accumulate(prepass.mMeasures[way], milliseconds, window);
+		}
+	}
+	prepass.mStats.mDepthMilliseconds = GpuTimer_GetMilliseconds(prepass.mDepthTimer);
+	prepass.mStats.mPrepassMilliseconds = GpuTimer_GetMilliseconds(prepass.mShadingTimers[1]);
+	prepass.mStats.mForwardMilliseconds = GpuTimer_GetMilliseconds(prepass.mShadingTimers[0]);
+}
+
+void DepthPrepass_EndShading(DepthPrepass& prepass) {
+	GpuTimer_End(prepass.mShadingCounter);
+	GpuTimer_End(prepass.mShadingTimers[prepass.mRunning ? 1 : 0]);
+	PipelineState_ApplyDepth(DepthState());
+}
+
+const DepthPrepassStats& DepthPrepass_GetStats(const DepthPrepass& prepass) {
+	return prepass.mStats;
+}
+
+void DepthPrepass_ResetStats(DepthPrepass& prepass) {
+	prepass.mStats.mSwitches = 0;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "GpuTimer.h"
+#include "PipelineState.h"
+
+struct DepthPrepassMode {
+	enum Enum {
+		Off,
+		On,
+		Auto,		// measures both ways of drawing from time to time and keeps the cheapest
+		Count
+	};
+};
+
+struct DepthPrepassParams {
+	DepthPrepassMode::Enum mMode = DepthPrepassMode::Auto;
+	// Equal needs the depth and shading programs to compute the same depth, i.e. the same position expression with
+	// invariant gl_Position. LessEqual is the same test once the pre-pass has filled the depth buffer.
+	CompareFunc::Enum mShadingFunc = CompareFunc::Equal;
+	float mEnableOverdraw = 1.5f;				// shaded fragments per covered pixel worth a measure of the pre-pass
+	float mHysteresis = 0.1f;					// relative gain needed to switch
+	uint32_t mProbeInterval = 300;				// frames between two measures of the unused way
+	uint32_t mProbeFrames = 12;					// at least cGpuTimerQueries + 1 so the probe measures itself
+};
+
+struct DepthPrepassStats {
+	bool mRunning = false;						// the pre-pass runs this frame
+	bool mProbing = false;
+	float mOverdraw = 0.0f;						// fragments shaded without the pre-pass per covered pixel
+	double mDepthMilliseconds = 0.0;			// pre-pass
+	double mPrepassMilliseconds = 0.0;			// shading after the pre-pass, not including it
+	double mForwardMilliseconds = 0.0;			// shading without the pre-pass
+	uint32_t mSwitches = 0;						// since the last DepthPrepass_ResetStats
+};
+
+// Mean GPU time of one way of drawing over the frames of its last stretch, skipping the frames still reading back
+// queries of the other way.
+struct DepthPrepassMeasure {
+	double mMilliseconds = 0.0;
+	uint32_t mFrames = 0;
+};
+
+// Optional depth-only pre-pass in front of an expensive shading pass: the scene is drawn once with color writes off,
+// then again with mShadingFunc and depth writes off so every covered pixel is shaded about once. It pays when the
+// saved fragment shading outweighs the second geometry pass, which depends on the view. In Auto mode the shading
+// pass counts its fragments and the passes are timed; the way not in use is measured for mProbeFrames every
+// mProbeInterval frames, or as soon as the overdraw crosses mEnableOverdraw, and the cheapest one is kept.
+struct DepthPrepass {
+	DepthPrepassParams mParams;
+	DepthState mDepthState;
+	DepthState mShadingState;
+	BlendState mDepthBlend;
+
+	GpuTimer mDepthTimer;
+	GpuTimer mShadingTimers[2];					// without, with the pre-pass
+	GpuTimer mDepthCounter;						// samples passed
+	GpuTimer mShadingCounter;
+	DepthPrepassMeasure mMeasures[2];			// shading without, pre-pass plus shading with
+	uint64_t mCoveredSamples = 0;				// shading fragments of the last frame measured with the pre-pass
+
+	bool mEnabled = false;						// Auto choice outside of probes
+	bool mOverdrawn = false;					// overdraw above mEnableOverdraw, with hysteresis
+	bool mOverdrawnAtProbe = false;
+	bool mRunning = false;
+	uint32_t mFramesRunning = 0;				// frames since mRunning last changed
+	uint32_t mFramesSinceProbe = 0;
+	uint32_t mProbeLeft = 0;
+	DepthPrepassStats mStats;
+};
+
+void DepthPrepass_Initialize(DepthPrepass& prepass, const DepthPrepassParams& params);
+
+void DepthPrepass_Destroy(DepthPrepass& prepass);
+
+void DepthPrepass_SetMode(DepthPrepass& prepass, DepthPrepassMode::Enum mode);
+
+// Picks the passes of the frame, returns true when the pre-pass has to be drawn.
+bool DepthPrepass_BeginFrame(DepthPrepass& prepass);
+
+// Depth only state: color writes off, depth test Less with writes. Draws in between can use a position only
+// program and should issue the same geometry as the shading pass.
+void DepthPrepass_BeginDepth(DepthPrepass& prepass);
+
+void DepthPrepass_EndDepth(DepthPrepass& prepass);
+
+// mShadingFunc without depth writes after the pre-pass, the default depth state otherwise.
+void DepthPrepass_BeginShading(DepthPrepass& prepass);
+
+// Restores the default depth state, e.g. for the depth clear of the next frame.
+void DepthPrepass_EndShading(DepthPrepass& prepass);
+
+const DepthPrepassStats& DepthPrepass_GetStats(const DepthPrepass& prepass);
+
+void DepthPrepass_ResetStats(DepthPrepass& prepass);
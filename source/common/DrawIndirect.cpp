@@ -0,0 +1,273 @@
+#include "DrawIndirect.h"
+
+#include "GLApi.h"
+#include <array>
+
+namespace
+{
+
+class DrawIndirectBuilder {
+public:
+	DrawIndirectBuilder() = default;
+	~DrawIndirectBuilder() {
+		Destroy();
+	}
+
+	void Create(const DrawIndirectBuilderParams& params) {
+		mProgram = DrawIndirect_IsMultiDrawSupported() ? params.mProgram : ShaderProgramHandle(cInvalidHandle);
+		mFallbackProgram = params.mFallbackProgram;
+		mDrawDataBinding = params.mDrawDataBinding;
+		mDrawDataStage = params.mDrawDataStage;
+		mTexturesCount = params.mTexturesCount < cMaxDrawIndirectTextures ? params.mTexturesCount : cMaxDrawIndirectTextures;
+		for (uint32_t i = 0; i < mTexturesCount; i++) {
+			mTextures[i] = params.mTextures[i];
+		}
+
+		MeshParams meshParams = params.mMesh;
+		if (params.mMaxDraws == 0 || meshParams.mIndexFormat == IndexFormat::None ||
+				meshParams.mVertexBuffersCount >= cMaxMeshVertexBuffers || meshParams.mAttributesCount >= cMaxMeshVertexAttributes) {
+			return;
+		}
+		mMaxDraws = params.mMaxDraws;
+
+		std::vector<uint32_t> drawIds(mMaxDraws);
+		for (uint32_t i = 0; i < mMaxDraws; i++) {
+			drawIds[i] = i;
+		}
+		mDrawIds = Buffer_Create(BufferType::Vertex, drawIds.data(), mMaxDraws * uint32_t(sizeof(uint32_t)));
+		// the storage buffer and draw indirect targets only exist from GL 4.3, the texture buffer view works with both
+		const uint32_t drawDataSize = mMaxDraws * uint32_t(sizeof(DrawIndirectData));
+		if (mProgram.IsValid()) {
+			mCommands = Buffer_Create(BufferType::DrawIndirect, nullptr, mMaxDraws * uint32_t(sizeof(DrawElementsIndirectCommand)), BufferUsage::Stream);
+			mDrawData = Buffer_Create(BufferType::ShaderStorage, nullptr, drawDataSize, BufferUsage::Stream);
+		} else {
+			mDrawData = Buffer_Create(BufferType::Texture, nullptr, drawDataSize, BufferUsage::Stream);
+		}
+		mDrawDataTexture = Texture_CreateBuffer(mDrawData, TextureFormats::RGBA32UI);
+		if (!mDrawIds.IsValid() || (mProgram.IsValid() && !mCommands.IsValid()) || !mDrawData.IsValid() || !mDrawDataTexture.IsValid()) {
+			Destroy();
+			return;
+		}
+
+		uint8_t bufferIndex = static_cast<uint8_t>(meshParams.mVertexBuffersCount++);
+		meshParams.mVertexBuffers[bufferIndex] = mDrawIds;
+		VertexAttribute& attribute = meshParams.mAttributes[meshParams.mAttributesCount++];
+		attribute.mLocation = params.mDrawIdLocation;
+		attribute.mBufferIndex = bufferIndex;
+		attribute.mComponents = 1;
+		attribute.mInteger = true;
+		attribute.mType = VertexComponentType::UnsignedInt;
+		attribute.mOffset = 0;
+		attribute.mStride = uint32_t(sizeof(uint32_t));
+		attribute.mDivisor = 1;
+		mMesh = Mesh_Create(meshParams);
+		if (!mMesh.IsValid()) {
+			Destroy();
+			return;
+		}
+		// indirect command first indices are absolute in the shared index buffer
+		mFirstIndex = Mesh_GetFirstIndex(mMesh);
+
+		mCommandsData.reserve(mMaxDraws);
+		mDrawDataData.reserve(mMaxDraws);
+	}
+
+	void Destroy() {
+		Mesh_Destroy(mMesh);
+		Texture_Destroy(mDrawDataTexture);
+		Buffer_Destroy(mDrawData);
+		Buffer_Destroy(mCommands);
+		Buffer_Destroy(mDrawIds);
+		mMesh = MeshHandle(cInvalidHandle);
+		mDrawDataTexture = TextureHandle(cInvalidHandle);
+		mDrawData = BufferHandle(cInvalidHandle);
+		mCommands = BufferHandle(cInvalidHandle);
+		mDrawIds = BufferHandle(cInvalidHandle);
+		Clear();
+	}
+
+	void Clear() {
+		mCommandsData.clear();
+		mDrawDataData.clear();
+	}
+
+	bool Add(const DrawIndirectMesh& mesh, const glm::mat4& model, uint32_t material) {
+		if (!IsValid() || GetCount() >= mMaxDraws) {
+			return false;
+		}
+		DrawElementsIndirectCommand command;
+		command.mCount = mesh.mIndexCount;
+		command.mInstanceCount = 1;
+		command.mFirstIndex = mFirstIndex + mesh.mFirstIndex;
+		command.mBaseVertex = mesh.mBaseVertex;
+		command.mBaseInstance = GetCount();
+		mCommandsData.push_back(command);
+
+		DrawIndirectData data;
+		data.mModel = model;
+		data.mMaterial = material;
+		data.mPadding[0] = data.mPadding[1] = data.mPadding[2] = 0;
+		mDrawDataData.push_back(data);
+		return true;
+	}
+
+	void Submit(bool allowMultiDraw) {
+		const uint32_t count = GetCount();
+		if (!IsValid() || count == 0) {
+			return;
+		}
+		const bool useMultiDraw = UsesMultiDraw(allowMultiDraw);
+		const ShaderProgramHandle& program = useMultiDraw ? mProgram : mFallbackProgram;
+		ShaderProgram_Use(program);
+		for (uint32_t i = 0; i < mTexturesCount; i++) {
+			Texture_Bind(mTextures[i], uint8_t(i));
+		}
+		Buffer_Update(mDrawData, 0, mDrawDataData.data(), count * uint32_t(sizeof(DrawIndirectData)));
+
+		if (useMultiDraw) {
+			Buffer_BindBase(mDrawData, mDrawDataBinding);
+			Buffer_Update(mCommands, 0, mCommandsData.data(), count * uint32_t(sizeof(DrawElementsIndirectCommand)));
+			Mesh_MultiDrawIndirect(mMesh, mCommands, count);
+		} else {
+			Texture_Bind(mDrawDataTexture, mDrawDataStage);
+			ShaderProgram_SetInt(program, "u_drawData", mDrawDataStage);
+			for (uint32_t i = 0; i < count; i++) {
+				// the draw index comes from the uniform, base instances need GL 4.2; client commands count from the
+				// first index of the mesh
+				DrawElementsIndirectCommand command = mCommandsData[i];
+				command.mFirstIndex -= mFirstIndex;
+				command.mBaseInstance = 0;
+				ShaderProgram_SetInt(program, "u_drawId", int(i));
+				Mesh_DrawCommands(mMesh, &command, 1);
+			}
+		}
+	}
+
+	bool UsesMultiDraw(bool allowMultiDraw) const {
+		return allowMultiDraw && mProgram.IsValid();
+	}
+
+	uint32_t GetCount() const {
+		return static_cast<uint32_t>(mCommandsData.size());
+	}
+
+	bool IsValid() const {
+		return mMesh.IsValid() && mFallbackProgram.IsValid();
+	}
+
+private:
+	MeshHandle mMesh = MeshHandle(cInvalidHandle);
+	BufferHandle mDrawIds = BufferHandle(cInvalidHandle);
+	BufferHandle mCommands = BufferHandle(cInvalidHandle);
+	BufferHandle mDrawData = BufferHandle(cInvalidHandle);
+	TextureHandle mDrawDataTexture = TextureHandle(cInvalidHandle);
+	ShaderProgramHandle mProgram = ShaderProgramHandle(cInvalidHandle);
+	ShaderProgramHandle mFallbackProgram = ShaderProgramHandle(cInvalidHandle);
+	TextureHandle mTextures[cMaxDrawIndirectTextures];
+	uint32_t mTexturesCount = 0;
+
+	uint32_t mDrawDataBinding = 0;
+	uint8_t mDrawDataStage = 0;
+	uint32_t mMaxDraws = 0;
+	uint32_t mFirstIndex = 0;
+
+	std::vector<DrawElementsIndirectCommand> mCommandsData;
+	std::vector<DrawIndirectData> mDrawDataData;
+};
+
+static constexpr uint32_t cMaxDrawIndirectBuilderHandles = (1 << 6);
+uint32_t sDrawIndirectBuildersCount = 0;
+std::array<DrawIndirectBuilder, cMaxDrawIndirectBuilderHandles> sDrawIndirectBuilders;
+
+}
+
+DrawIndirectMesh DrawIndirect_AppendMesh(DrawIndirectGeometry& geometry, const float* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount) {
+	DrawIndirectMesh mesh;
+	if (geometry.mVertexStride == 0) {
+		return mesh;
+	}
+	mesh.mFirstIndex = static_cast<uint32_t>(geometry.mIndices.size());
+	mesh.mIndexCount = indexCount;
+	mesh.mBaseVertex = static_cast<int32_t>(geometry.mVertices.size() / geometry.mVertexStride);
+
+	geometry.mVertices.insert(geometry.mVertices.end(), vertices, vertices + size_t(vertexCount) * geometry.mVertexStride);
+	geometry.mIndices.insert(geometry.mIndices.end(), indices, indices + indexCount);
+	return mesh;
+}
+
+bool DrawIndirect_CreateGeometryBuffers(const DrawIndirectGeometry& geometry, BufferHandle& vertexBuffer, BufferHandle& indexBuffer) {
+	if (geometry.mVertices.empty() || geometry.mIndices.empty()) {
+		return false;
+	}
+	vertexBuffer = Buffer_Create(BufferType::Vertex, geometry.mVertices.data(), uint32_t(geometry.mVertices.size() * sizeof(float)));
+	indexBuffer = Buffer_Create(BufferType::Index, geometry.mIndices.data(), uint32_t(geometry.mIndices.size() * sizeof(uint32_t)));
+	return vertexBuffer.IsValid() && indexBuffer.IsValid();
+}
+
+DrawIndirectBuilderHandle DrawIndirect_CreateBuilder(const DrawIndirectBuilderParams& params) {
+	if (!params.mFallbackProgram.IsValid() || sDrawIndirectBuildersCount >= cMaxDrawIndirectBuilderHandles) {
+		return DrawIndirectBuilderHandle(cInvalidHandle);
+	}
+
+	DrawIndirectBuilderHandle handle = DrawIndirectBuilderHandle(sDrawIndirectBuildersCount);
+	auto& builder = sDrawIndirectBuilders[handle.mHandle];
+	builder.Create(params);
+
+	if (builder.IsValid()) {
+		sDrawIndirectBuildersCount++;
+		return handle;
+	}
+	return DrawIndirectBuilderHandle(cInvalidHandle);
+}
+
+void DrawIndirect_DestroyBuilder(const DrawIndirectBuilderHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& builder = sDrawIndirectBuilders[handle.mHandle];
+	builder.Destroy();
+}
+
+void DrawIndirect_Clear(const DrawIndirectBuilderHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& builder = sDrawIndirectBuilders[handle.mHandle];
+	builder.Clear();
+}
+
+bool DrawIndirect_Add(const DrawIndirectBuilderHandle& handle, const DrawIndirectMesh& mesh, const glm::mat4& model, uint32_t material) {
+	if (!handle.IsValid()) {
+		return false;
+	}
+	auto& builder = sDrawIndirectBuilders[handle.mHandle];
+	return builder.Add(mesh, model, material);
+}
+
+uint32_t DrawIndirect_GetCount(const DrawIndirectBuilderHandle& handle) {
+	if (!handle.IsValid()) {
+		return 0;
+	}
+	auto& builder = sDrawIndirectBuilders[handle.mHandle];
+	return builder.GetCount();
+}
+
+bool DrawIndirect_IsMultiDrawSupported() {
+	return GLAD_GL_VERSION_4_3 != 0 && glMultiDrawElementsIndirect != nullptr;
+}
+
+bool DrawIndirect_UsesMultiDraw(const DrawIndirectBuilderHandle& handle, bool allowMultiDraw) {
+	if (!handle.IsValid()) {
+		return false;
+	}
+	auto& builder = sDrawIndirectBuilders[handle.mHandle];
+	return builder.UsesMultiDraw(allowMultiDraw);
+}
+
+void DrawIndirect_Submit(const DrawIndirectBuilderHandle& handle, bool allowMultiDraw) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& builder = sDrawIndirectBuilders[handle.mHandle];
+	builder.Submit(allowMultiDraw);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "glm/mat4x4.hpp"
+
+#include <vector>
+
+static constexpr uint32_t cMaxDrawIndirectTextures = 4;
+
+// Range of a mesh stored in the shared vertex/index buffers of a builder.
+struct DrawIndirectMesh {
+	uint32_t mFirstIndex = 0;
+	uint32_t mIndexCount = 0;
+	int32_t mBaseVertex = 0;
+};
+
+// Per draw record fetched by the vertex shader, from a shader storage buffer for multi draw (std430 layout, see
+// 08-multidraw.vs) or as five RGBA32UI texels of a texture buffer for the fallback loop (see 08-multidraw_fallback.vs).
+struct DrawIndirectData {
+	glm::mat4 mModel;
+	uint32_t mMaterial;
+	uint32_t mPadding[3];
+};
+
+// CPU staging of the shared geometry, meshes are appended and then uploaded once with DrawIndirect_CreateGeometryBuffers.
+struct DrawIndirectGeometry {
+	std::vector<float> mVertices;
+	std::vector<uint32_t> mIndices;
+	uint32_t mVertexStride = 0;			// in floats
+};
+
+DrawIndirectMesh DrawIndirect_AppendMesh(DrawIndirectGeometry& geometry, const float* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount);
+
+bool DrawIndirect_CreateGeometryBuffers(const DrawIndirectGeometry& geometry, BufferHandle& vertexBuffer, BufferHandle& indexBuffer);
+
+// mMesh describes the shared buffers. mProgram is used for multi draw (GL 4.3): the builder adds an integer per
+// instance attribute at mDrawIdLocation holding the draw index, read through the base instance of each command, and
+// binds the draw data as a shader storage buffer at mDrawDataBinding. mFallbackProgram is used for the loop (GL 3.3):
+// the draw data is the samplerBuffer u_drawData bound at mDrawDataStage and the draw index is the uniform u_drawId.
+// mProgram may be invalid when multi draw is not supported.
+struct DrawIndirectBuilderParams {
+	MeshParams mMesh;
+	uint8_t mDrawIdLocation = 3;
+	uint32_t mDrawDataBinding = 0;
+	uint8_t mDrawDataStage = cMaxDrawIndirectTextures;
+	uint32_t mMaxDraws = 4096;
+
+	ShaderProgramHandle mProgram = ShaderProgramHandle(cInvalidHandle);
+	ShaderProgramHandle mFallbackProgram = ShaderProgramHandle(cInvalidHandle);
+	TextureHandle mTextures[cMaxDrawIndirectTextures];
+	uint32_t mTexturesCount = 0;
+};
+
+using DrawIndirectBuilderHandle = ResourceHandle;
+
+DrawIndirectBuilderHandle DrawIndirect_CreateBuilder(const DrawIndirectBuilderParams& params);
+
+void DrawIndirect_DestroyBuilder(const DrawIndirectBuilderHandle& handle);
+
+void DrawIndirect_Clear(const DrawIndirectBuilderHandle& handle);
+
+bool DrawIndirect_Add(const DrawIndirectBuilderHandle& handle, const DrawIndirectMesh& mesh, const glm::mat4& model, uint32_t material);
+
+uint32_t DrawIndirect_GetCount(const DrawIndirectBuilderHandle& handle);
+
+// glMultiDrawElementsIndirect, shader storage buffers and GLSL 4.30 shaders, all core in GL 4.3.
+bool DrawIndirect_IsMultiDrawSupported();
+
+// True when DrawIndirect_Submit with allowMultiDraw goes through multi draw, the program whose per frame uniforms
+// must be set is then mProgram rather than mFallbackProgram.
+bool DrawIndirect_UsesMultiDraw(const DrawIndirectBuilderHandle& handle, bool allowMultiDraw = true);
+
+// Uploads commands and draw data and submits every draw with a single glMultiDrawElementsIndirect, or with one
+// call per draw when multi draw is not supported or not allowed. Per frame uniforms are expected to be already set.
+void DrawIndirect_Submit(const DrawIndirectBuilderHandle& handle, bool allowMultiDraw = true);
@@ -0,0 +1,160 @@
+#include "DynamicResolution.h"
+
+#include "GLApi.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+constexpr uint8_t cSceneStage = 0;
+constexpr double cSmoothing = 0.3;				// weight of the newest frame time
+
+uint32_t ScaleSize(uint32_t size, float scale) {
+	return std::max(uint32_t(std::lround(double(size) * double(scale))), 1u);
+}
+
+void ResizeTarget(DynamicResolution& resolution) {
+	const DynamicResolutionParams& params = resolution.mParams;
+	RenderTarget_Resize(resolution.mTarget, ScaleSize(params.mWidth, params.mMaxScale), ScaleSize(params.mHeight, params.mMaxScale));
+}
+
+void UpdateScale(DynamicResolution& resolution, double cpuFrameMilliseconds) {
+	const DynamicResolutionParams& params = resolution.mParams;
+	const double milliseconds = (params.mSource == FrameTimeSource::Gpu) ? GpuTimer_GetMilliseconds(resolution.mTimer) : cpuFrameMilliseconds;
+	if (milliseconds <= 0.0) {
+		// no GPU result yet
+		return;
+	}
+	if (resolution.mFilteredMilliseconds <= 0.0) {
+		resolution.mFilteredMilliseconds = milliseconds;
+	}
+	resolution.mFilteredMilliseconds += (milliseconds - resolution.mFilteredMilliseconds) * cSmoothing;
+
+	const double ratio = double(params.mTargetMilliseconds) / resolution.mFilteredMilliseconds;
+	if (std::fabs(ratio - 1.0) > double(params.mDeadBand)) {
+		// the cost follows the area, the scale the square root of it
+		const double wanted = double(resolution.mScale) * std::sqrt(ratio);
+		const double scale = double(resolution.mScale) + (wanted - double(resolution.mScale)) * double(params.mGain);
+		resolution.mScale = glm::clamp(float(scale), params.mMinScale, params.mMaxScale);
+	}
+}
+
+}
+
+bool DynamicResolution_Initialize(DynamicResolution& resolution, const DynamicResolutionParams& params) {
+	resolution.mParams = params;
+	resolution.mScale = params.mMaxScale;
+	resolution.mFilteredMilliseconds = 0.0;
+
+	const uint32_t width = ScaleSize(params.mWidth, params.mMaxScale);
+	const uint32_t height = ScaleSize(params.mHeight, params.mMaxScale);
+	resolution.mColor = Texture_CreateRenderTarget(width, height, TextureFormats::RGBA8);
+	resolution.mDepth = Texture_CreateRenderTarget(width, height, TextureFormats::Depth24Stencil8);
+	Texture_SetFilteringMode(resolution.mColor, TextureFilteringMode::Bilinear);
+
+	RenderTargetParams targetParams;
+	targetParams.mColors[0] = resolution.mColor;
+	targetParams.mColorsCount = 1;
+	targetParams.mDepth = resolution.mDepth;
+	resolution.mTarget = RenderTarget_Create(targetParams);
+
+	// one triangle covering the screen
+	const float fullscreen[] = { -1.0f, -1.0f, 3.0f, -1.0f, -1.0f, 3.0f };
+	resolution.mFullscreenVertices = Buffer_Create(BufferType::Vertex, fullscreen, sizeof(fullscreen));
+	MeshParams fullscreenParams;
+	fullscreenParams.mVertexBuffers[0] = resolution.mFullscreenVertices;
+	fullscreenParams.mVertexBuffersCount = 1;
+	fullscreenParams.mAttributesCount = 1;
+	fullscreenParams.mAttributes[0].mComponents = 2;
+	fullscreenParams.mAttributes[0].mStride = 2 * sizeof(float);
+	fullscreenParams.mVertexCount = 3;
+	resolution.mFullscreen = Mesh_Create(fullscreenParams);
+
+	PipelineStateParams stateParams;
+	stateParams.mProgram = params.mUpscaleProgram;
+	stateParams.mMesh = resolution.mFullscreen;
+	stateParams.mDepth.mTestEnable = false;
+	stateParams.mDepth.mWriteEnable = false;
+	resolution.mUpscaleState = PipelineState_Create(stateParams);
+
+	GpuTimer_Create(resolution.mTimer);
+	resolution.mStats = DynamicResolutionStats();
+
+	return resolution.mTarget.IsValid() && resolution.mFullscreen.IsValid();
+}
+
+void DynamicResolution_Destroy(DynamicResolution& resolution) {
+	GpuTimer_Destroy(resolution.mTimer);
+	PipelineState_Destroy(resolution.mUpscaleState);
+	Mesh_Destroy(resolution.mFullscreen);
+	Buffer_Destroy(resolution.mFullscreenVertices);
+	RenderTarget_Destroy(resolution.mTarget);
+	Texture_Destroy(resolution.mDepth);
+	Texture_Destroy(resolution.mColor);
+	resolution = DynamicResolution();
+}
+
+void DynamicResolution_SetParams(DynamicResolution& resolution, const DynamicResolutionParams& params) {
+	const float maxScale = resolution.mParams.mMaxScale;
+	const uint32_t width = resolution.mParams.mWidth;
+	const uint32_t height = resolution.mParams.mHeight;
+	const ShaderProgramHandle program = resolution.mParams.mUpscaleProgram;
+	resolution.mParams = params;
+	resolution.mParams.mWidth = width;
+	resolution.mParams.mHeight = height;
+	resolution.mParams.mUpscaleProgram = program;
+	if (params.mMaxScale != maxScale) {
+		ResizeTarget(resolution);
+	}
+	resolution.mScale = glm::clamp(resolution.mScale, params.mMinScale, params.mMaxScale);
+	// the previous measures may come from the other source
+	resolution.mFilteredMilliseconds = 0.0;
+}
+
+void DynamicResolution_Resize(DynamicResolution& resolution, uint32_t width, uint32_t height) {
+	if (width == 0 || height == 0) {
+		return;
+	}
+	resolution.mParams.mWidth = width;
+	resolution.mParams.mHeight = height;
+	ResizeTarget(resolution);
+}
+
+void DynamicResolution_BeginScene(DynamicResolution& resolution, double cpuFrameMilliseconds) {
+	UpdateScale(resolution, cpuFrameMilliseconds);
+
+	const DynamicResolutionParams& params = resolution.mParams;
+	DynamicResolutionStats& stats = resolution.mStats;
+	stats.mScale = resolution.mScale;
+	stats.mRenderWidth = std::min(ScaleSize(params.mWidth, resolution.mScale), RenderTarget_GetWidth(resolution.mTarget));
+	stats.mRenderHeight = std::min(ScaleSize(params.mHeight, resolution.mScale), RenderTarget_GetHeight(resolution.mTarget));
+	stats.mMilliseconds = resolution.mFilteredMilliseconds;
+
+	GpuTimer_Begin(resolution.mTimer);
+	RenderTarget_Bind(resolution.mTarget);
+	GL_CHECK(glViewport(0, 0, GLsizei(stats.mRenderWidth), GLsizei(stats.mRenderHeight)));
+}
+
+void DynamicResolution_Upscale(DynamicResolution& resolution) {
+	const DynamicResolutionParams& params = resolution.mParams;
+	const DynamicResolutionStats& stats = resolution.mStats;
+	const glm::vec2 targetSize(float(RenderTarget_GetWidth(resolution.mTarget)), float(RenderTarget_GetHeight(resolution.mTarget)));
+
+	RenderTarget_BindDefault(params.mWidth, params.mHeight);
+	const ShaderProgramHandle& program = params.mUpscaleProgram;
+	PipelineState_Apply(resolution.mUpscaleState);
+	Texture_Bind(resolution.mColor, cSceneStage);
+	ShaderProgram_SetInt(program, "u_scene", cSceneStage);
+	ShaderProgram_SetVec2(program, "u_outputSize", glm::vec2(float(params.mWidth), float(params.mHeight)));
+	ShaderProgram_SetVec2(program, "u_renderSize", glm::vec2(float(stats.mRenderWidth), float(stats.mRenderHeight)));
+	ShaderProgram_SetVec2(program, "u_inverseTargetSize", 1.0f / targetSize);
+	ShaderProgram_SetFloat(program, "u_sharpness", (params.mFilter == UpscaleFilter::Sharpen) ? params.mSharpness : 0.0f);
+	Mesh_Draw(resolution.mFullscreen);
+	GpuTimer_End(resolution.mTimer);
+}
+
+const DynamicResolutionStats& DynamicResolution_GetStats(const DynamicResolution& resolution) {
+	return resolution.mStats;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Buffer.h"
+#include "GpuTimer.h"
+#include "Mesh.h"
+#include "PipelineState.h"
+#include "RenderTarget.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+
+struct FrameTimeSource {
+	enum Enum {
+		Gpu,		// time elapsed queries from DynamicResolution_BeginScene to the end of DynamicResolution_Upscale
+		Cpu,		// frame time given to DynamicResolution_BeginScene, includes the swap when the GPU is the bottleneck
+		Count
+	};
+};
+
+struct UpscaleFilter {
+	enum Enum {
+		Bilinear,
+		Sharpen,	// bilinear followed by a contrast adaptive sharpening of the cross neighbors
+		Count
+	};
+};
+
+// mWidth x mHeight is the output size, the scene is rendered at a scale of it between mMinScale and mMaxScale.
+// The upscale program is 18-upscale.fs over 15-deferred_fullscreen.vs.
+struct DynamicResolutionParams {
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	ShaderProgramHandle mUpscaleProgram = ShaderProgramHandle(cInvalidHandle);
+	float mTargetMilliseconds = 16.0f;
+	float mMinScale = 0.5f;
+	float mMaxScale = 1.0f;
+	float mGain = 0.25f;						// fraction of the wanted scale change applied per frame
+	float mDeadBand = 0.05f;					// relative frame time error left uncorrected
+	FrameTimeSource::Enum mSource = FrameTimeSource::Gpu;
+	UpscaleFilter::Enum mFilter = UpscaleFilter::Sharpen;
+	float mSharpness = 0.5f;					// 0 to 1
+};
+
+struct DynamicResolutionStats {
+	float mScale = 1.0f;
+	uint32_t mRenderWidth = 0;
+	uint32_t mRenderHeight = 0;
+	double mMilliseconds = 0.0;					// smoothed frame time seen by the controller
+};
+
+// Renders the scene into an offscreen target at a fraction of the output resolution and stretches it over the
+// window framebuffer. The target is allocated once at the largest scale and only a corner of it is drawn into, so
+// the scale can change every frame without reallocating. Every frame the controller compares the smoothed frame
+// time to the target and moves the scale towards the one that would meet it, assuming the cost is proportional to
+// the number of pixels; the feedback takes care of the part that is not.
+struct DynamicResolution {
+	DynamicResolutionParams mParams;
+	TextureHandle mColor = TextureHandle(cInvalidHandle);
+	TextureHandle mDepth = TextureHandle(cInvalidHandle);
+	RenderTargetHandle mTarget = RenderTargetHandle(cInvalidHandle);
+	BufferHandle mFullscreenVertices = BufferHandle(cInvalidHandle);
+	MeshHandle mFullscreen = MeshHandle(cInvalidHandle);
+	PipelineStateHandle mUpscaleState = PipelineStateHandle(cInvalidHandle);
+	GpuTimer mTimer;
+	float mScale = 1.0f;
+	double mFilteredMilliseconds = 0.0;
+	DynamicResolutionStats mStats;
+};
+
+bool DynamicResolution_Initialize(DynamicResolution& resolution, const DynamicResolutionParams& params);
+
+void DynamicResolution_Destroy(DynamicResolution& resolution);
+
+// Keeps the target, the output size and programs of the new parameters are ignored.
+void DynamicResolution_SetParams(DynamicResolution& resolution, const DynamicResolutionParams& params);
+
+// New output size, the scale is kept.
+void DynamicResolution_Resize(DynamicResolution& resolution, uint32_t width, uint32_t height);
+
+// Updates the scale from the last frame time, binds the target with the viewport set to the render size of this
+// frame and starts timing the GPU. Clearing the whole target is fine, only the viewport is read back.
+void DynamicResolution_BeginScene(DynamicResolution& resolution, double cpuFrameMilliseconds);
+
+// Binds the window framebuffer and draws the scene over it with the filter of the parameters.
+void DynamicResolution_Upscale(DynamicResolution& resolution);
+
+const DynamicResolutionStats& DynamicResolution_GetStats(const DynamicResolution& resolution);
@@ -0,0 +1,433 @@
+#include "Ecs.h"
+
+#include "JobSystem.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+constexpr uint32_t cIndexMask = (1u << cEcsIndexBits) - 1;
+constexpr uint32_t cGenerationMask = 0x7f;
+
+struct CommandType {
+	enum Enum {
+		Create,
+		Destroy,
+		Add,
+		Remove,
+		Count
+	};
+};
+
+// Commands are stored back to back, the component data of Add follows its header.
+struct CommandHeader {
+	uint16_t mType;
+	uint16_t mComponent;
+	uint32_t mSize;						// header and payload, multiple of 8
+	Entity mEntity;
+	uint32_t mPadding;
+	EcsComponentMask mMask;
+};
+
+inline uint32_t AlignUp(uint32_t value, uint32_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+inline Entity MakeEntity(uint32_t index, uint32_t generation) {
+	return index | ((generation & cGenerationMask) << cEcsIndexBits);
+}
+
+EcsEntityRecord* GetRecord(EcsWorld& world, Entity entity) {
+	const uint32_t index = entity & cIndexMask;
+	if ((entity & cEcsPendingEntity) || index >= world.mEntities.size()) {
+		return nullptr;
+	}
+	EcsEntityRecord& record = world.mEntities[index];
+	if (record.mArchetype == cInvalidHandle || (record.mGeneration & cGenerationMask) != ((entity >> cEcsIndexBits) & cGenerationMask)) {
+		return nullptr;
+	}
+	return &record;
+}
+
+const EcsEntityRecord* GetRecord(const EcsWorld& world, Entity entity) {
+	return GetRecord(const_cast<EcsWorld&>(world), entity);
+}
+
+// Lays out the component arrays of a new archetype so that as many entities as possible fit in a chunk.
+uint32_t GetArchetype(EcsWorld& world, EcsComponentMask mask) {
+	auto found = world.mArchetypeLookup.find(mask);
+	if (found != world.mArchetypeLookup.end()) {
+		return found->second;
+	}
+
+	const uint32_t index = static_cast<uint32_t>(world.mArchetypes.size());
+	world.mArchetypes.emplace_back();
+	EcsArchetype& archetype = world.mArchetypes.back();
+	archetype.mMask = mask;
+	std::fill(archetype.mOffsets, archetype.mOffsets + cEcsMaxComponents, cInvalidHandle);
+	std::fill(archetype.mAddEdges, archetype.mAddEdges + cEcsMaxComponents, cInvalidHandle);
+	std::fill(archetype.mRemoveEdges, archetype.mRemoveEdges + cEcsMaxComponents, cInvalidHandle);
+
+	uint32_t entitySize = sizeof(Entity);
+	uint32_t alignmentPadding = 0;
+	for (uint32_t component = 0; component < world.mComponents.size(); component++) {
+		if (mask & Ecs_Mask(component)) {
+			entitySize += world.mComponents[component].mSize;
+			alignmentPadding += world.mComponents[component].mAlignment;
+		}
+	}
+	archetype.mCapacity = std::max((cEcsChunkSize - alignmentPadding) / entitySize, 1u);
+
+	uint32_t offset = archetype.mCapacity * sizeof(Entity);
+	for (uint32_t component = 0; component < world.mComponents.size(); component++) {
+		if (mask & Ecs_Mask(component)) {
+			offset = AlignUp(offset, world.mComponents[component].mAlignment);
+			archetype.mOffsets[component] = offset;
+			offset += archetype.mCapacity * world.mComponents[component].mSize;
+		}
+	}
+	// a single entity bigger than a chunk gets a chunk of its own size
+	archetype.mChunkBytes = std::max(offset, cEcsChunkSize);
+
+	world.mArchetypeLookup[mask] = index;
+	return index;
+}
+
+inline Entity* GetEntities(EcsChunk& chunk) {
+	return reinterpret_cast<Entity*>(chunk.mData.data());
+}
+
+// Appends a row to the last chunk of the archetype, the new components are zero filled.
+void AllocateRow(EcsWorld& world, uint32_t archetypeIndex, Entity entity, EcsEntityRecord& record) {
+	EcsArchetype& archetype = world.mArchetypes[archetypeIndex];
+	if (archetype.mChunks.empty() || archetype.mChunks.back().mCount == archetype.mCapacity) {
+		archetype.mChunks.emplace_back();
+		EcsChunk& chunk = archetype.mChunks.back();
+		if (!world.mFreeChunks.empty()) {
+			chunk.mData.swap(world.mFreeChunks.back());
+			world.mFreeChunks.pop_back();
+		}
+		chunk.mData.resize(archetype.mChunkBytes);
+	}
+
+	EcsChunk& chunk = archetype.mChunks.back();
+	const uint32_t row = chunk.mCount++;
+	GetEntities(chunk)[row] = entity;
+	for (uint32_t component = 0; component < world.mComponents.size(); component++) {
+		if (archetype.mOffsets[component] != cInvalidHandle) {
+			const uint32_t size = world.mComponents[component].mSize;
+			std::memset(chunk.mData.data() + archetype.mOffsets[component] + size_t(row) * size, 0, size);
+		}
+	}
+	archetype.mCount++;
+
+	record.mArchetype = archetypeIndex;
+	record.mChunk = static_cast<uint32_t>(archetype.mChunks.size()) - 1;
+	record.mRow = row;
+}
+
+// Fills the hole with the last row of the archetype so the chunks stay packed.
+void FreeRow(EcsWorld& world, const EcsEntityRecord& record) {
+	EcsArchetype& archetype = world.mArchetypes[record.mArchetype];
+	EcsChunk& chunk = archetype.mChunks[record.mChunk];
+	EcsChunk& last = archetype.mChunks.back();
+	const uint32_t lastRow = last.mCount - 1;
+
+	if (&chunk != &last || record.mRow != lastRow) {
+		const Entity moved = GetEntities(last)[lastRow];
+		GetEntities(chunk)[record.mRow] = moved;
+		for (uint32_t component = 0; component < world.mComponents.size(); component++) {
+			if (archetype.mOffsets[component] != cInvalidHandle) {
+				const uint32_t size = world.mComponents[component].mSize;
+				const size_t offset = archetype.mOffsets[component];
+				std::memcpy(chunk.mData.data() + offset + size_t(record.mRow) * size, last.mData.data() + offset + size_t(lastRow) * size, size);
+			}
+		}
+		EcsEntityRecord& movedRecord = world.mEntities[moved & cIndexMask];
+		movedRecord.mChunk = record.mChunk;
+		movedRecord.mRow = record.mRow;
+	}
+
+	last.mCount--;
+	archetype.mCount--;
+	if (last.mCount == 0) {
+		world.mFreeChunks.emplace_back();
+		world.mFreeChunks.back().swap(last.mData);
+		archetype.mChunks.pop_back();
+	}
+}
+
+void MoveEntity(EcsWorld& world, Entity entity, EcsEntityRecord& record, uint32_t destinationIndex) {
+	const EcsEntityRecord source = record;
+	AllocateRow(world, destinationIndex, entity, record);
+
+	const EcsArchetype& from = world.mArchetypes[source.mArchetype];
+	const EcsArchetype& to = world.mArchetypes[destinationIndex];
+	const uint8_t* fromData = from.mChunks[source.mChunk].mData.data();
+	uint8_t* toData = world.mArchetypes[destinationIndex].mChunks[record.mChunk].mData.data();
+	for (uint32_t component = 0; component < world.mComponents.size(); component++) {
+		if (from.mOffsets[component] != cInvalidHandle && to.mOffsets[component] != cInvalidHandle) {
+			const uint32_t size = world.mComponents[component].mSize;
+			std::memcpy(toData + to.mOffsets[component] + size_t(record.mRow) * size, fromData + from.mOffsets[component] + size_t(source.mRow) * size, size);
+		}
+	}
+	FreeRow(world, source);
+}
+
+void UpdateQuery(const EcsWorld& world, EcsQuery& query) {
+	const uint32_t archetypesCount = static_cast<uint32_t>(world.mArchetypes.size());
+	for (uint32_t index = query.mArchetypesChecked; index < archetypesCount; index++) {
+		const EcsComponentMask mask = world.mArchetypes[index].mMask;
+		if ((mask & query.mAll) == query.mAll && (mask & query.mNone) == 0) {
+			query.mArchetypes.push_back(index);
+		}
+	}
+	query.mArchetypesChecked = archetypesCount;
+}
+
+inline EcsChunkView MakeView(EcsArchetype& archetype, EcsChunk& chunk) {
+	EcsChunkView view;
+	view.mArchetype = &archetype;
+	view.mData = chunk.mData.data();
+	view.mEntities = GetEntities(chunk);
+	view.mCount = chunk.mCount;
+	return view;
+}
+
+CommandHeader& Record(EcsCommandBuffer& buffer, CommandType::Enum type, Entity entity, uint32_t payloadSize) {
+	const uint32_t size = AlignUp(sizeof(CommandHeader) + payloadSize, 8);
+	const size_t offset = buffer.mCommands.size();
+	buffer.mCommands.resize(offset + size);
+	CommandHeader& header = *reinterpret_cast<CommandHeader*>(buffer.mCommands.data() + offset);
+	header.mType = static_cast<uint16_t>(type);
+	header.mComponent = 0;
+	header.mSize = size;
+	header.mEntity = entity;
+	header.mPadding = 0;
+	header.mMask = 0;
+	buffer.mCount++;
+	return header;
+}
+
+}
+
+uint32_t Ecs_RegisterComponent(EcsWorld& world, uint32_t size, uint32_t alignment) {
+	if (world.mComponents.size() >= cEcsMaxComponents || size == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0) {
+		return cInvalidHandle;
+	}
+	EcsComponentInfo info;
+	info.mSize = size;
+	info.mAlignment = alignment;
+	world.mComponents.push_back(info);
+	return static_cast<uint32_t>(world.mComponents.size()) - 1;
+}
+
+Entity Ecs_CreateEntity(EcsWorld& world, EcsComponentMask mask) {
+	uint32_t index;
+	if (!world.mFreeEntities.empty()) {
+		index = world.mFreeEntities.back();
+		world.mFreeEntities.pop_back();
+	} else {
+		index = static_cast<uint32_t>(world.mEntities.size());
+		if (index > cIndexMask) {
+			return cInvalidHandle;
+		}
+		world.mEntities.emplace_back();
+	}
+
+	// components that were never registered are dropped from the mask
+	if (world.mComponents.size() < cEcsMaxComponents) {
+		mask &= Ecs_Mask(static_cast<uint32_t>(world.mComponents.size())) - 1;
+	}
+	EcsEntityRecord& record = world.mEntities[index];
+	const Entity entity = MakeEntity(index, record.mGeneration);
+	AllocateRow(world, GetArchetype(world, mask), entity, record);
+	world.mAliveCount++;
+	return entity;
+}
+
+void Ecs_DestroyEntity(EcsWorld& world, Entity entity) {
+	EcsEntityRecord* record = GetRecord(world, entity);
+	if (record == nullptr) {
+		return;
+	}
+	FreeRow(world, *record);
+	record->mArchetype = cInvalidHandle;
+	record->mGeneration++;
+	world.mFreeEntities.push_back(entity & cIndexMask);
+	world.mAliveCount--;
+}
+
+bool Ecs_IsAlive(const EcsWorld& world, Entity entity) {
+	return GetRecord(world, entity) != nullptr;
+}
+
+uint32_t Ecs_GetCount(const EcsWorld& world) {
+	return world.mAliveCount;
+}
+
+void Ecs_AddComponent(EcsWorld& world, Entity entity, uint32_t component, const void* data) {
+	EcsEntityRecord* record = GetRecord(world, entity);
+	if (record == nullptr || component >= world.mComponents.size()) {
+		return;
+	}
+	if ((world.mArchetypes[record->mArchetype].mMask & Ecs_Mask(component)) == 0) {
+		uint32_t destination = world.mArchetypes[record->mArchetype].mAddEdges[component];
+		if (destination == cInvalidHandle) {
+			destination = GetArchetype(world, world.mArchetypes[record->mArchetype].mMask | Ecs_Mask(component));
+			world.mArchetypes[record->mArchetype].mAddEdges[component] = destination;
+		}
+		MoveEntity(world, entity, *record, destination);
+	}
+	if (data) {
+		std::memcpy(Ecs_GetComponent(world, entity, component), data, world.mComponents[component].mSize);
+	}
+}
+
+void Ecs_RemoveComponent(EcsWorld& world, Entity entity, uint32_t component) {
+	EcsEntityRecord* record = GetRecord(world, entity);
+	if (record == nullptr || component >= world.mComponents.size() || (world.mArchetypes[record->mArchetype].mMask & Ecs_Mask(component)) == 0) {
+		return;
+	}
+	uint32_t destination = world.mArchetypes[record->mArchetype].mRemoveEdges[component];
+	if (destination == cInvalidHandle) {
+		destination = GetArchetype(world, world.mArchetypes[record->mArchetype].mMask & ~Ecs_Mask(component));
+		world.mArchetypes[record->mArchetype].mRemoveEdges[component] = destination;
+	}
+	MoveEntity(world, entity, *record, destination);
+}
+
+bool Ecs_HasComponent(const EcsWorld& world, Entity entity, uint32_t component) {
+	const EcsEntityRecord* record = GetRecord(world, entity);
+	return record && component < cEcsMaxComponents && (world.mArchetypes[record->mArchetype].mMask & Ecs_Mask(component)) != 0;
+}
+
+void* Ecs_GetComponent(EcsWorld& world, Entity entity, uint32_t component) {
+	const EcsEntityRecord* record = GetRecord(world, entity);
+	if (record == nullptr || component >= world.mComponents.size()) {
+		return nullptr;
+	}
+	EcsArchetype& archetype = world.mArchetypes[record->mArchetype];
+	if (archetype.mOffsets[component] == cInvalidHandle) {
+		return nullptr;
+	}
+	return archetype.mChunks[record->mChunk].mData.data() + archetype.mOffsets[component] + size_t(record->mRow) * world.mComponents[component].mSize;
+}
+
+EcsQuery Ecs_CreateQuery(EcsComponentMask all, EcsComponentMask none) {
+	EcsQuery query;
+	query.mAll = all;
+	query.mNone = none;
+	return query;
+}
+
+uint32_t Ecs_CountEntities(const EcsWorld& world, EcsQuery& query) {
+	UpdateQuery(world, query);
+	uint32_t count = 0;
+	for (uint32_t index : query.mArchetypes) {
+		count += world.mArchetypes[index].mCount;
+	}
+	return count;
+}
+
+void Ecs_ForEach(EcsWorld& world, EcsQuery& query, const EcsForEachCallback& callback) {
+	UpdateQuery(world, query);
+	for (uint32_t index : query.mArchetypes) {
+		EcsArchetype& archetype = world.mArchetypes[index];
+		for (EcsChunk& chunk : archetype.mChunks) {
+			callback(MakeView(archetype, chunk), 0);
+		}
+	}
+}
+
+void Ecs_ForEachParallel(EcsWorld& world, EcsQuery& query, uint32_t threadsCount, const EcsForEachCallback& callback) {
+	UpdateQuery(world, query);
+	std::vector<EcsChunkView> chunks;
+	for (uint32_t index : query.mArchetypes) {
+		EcsArchetype& archetype = world.mArchetypes[index];
+		for (EcsChunk& chunk : archetype.mChunks) {
+			chunks.push_back(MakeView(archetype, chunk));
+		}
+	}
+
+	const uint32_t chunksCount = static_cast<uint32_t>(chunks.size());
+	threadsCount = std::max(std::min(threadsCount, chunksCount), 1u);
+	auto run = [&chunks, &callback, chunksCount, threadsCount](uint32_t threadIndex) {
+		// contiguous ranges keep the chunks of an archetype on the same thread
+		const uint32_t first = uint32_t(uint64_t(chunksCount) * threadIndex / threadsCount);
+		const uint32_t last = uint32_t(uint64_t(chunksCount) * (threadIndex + 1) / threadsCount);
+		for (uint32_t i = first; i < last; i++) {
+			callback(chunks[i], threadIndex);
+		}
+	};
+
+	Job_RunSlices(threadsCount, run);
+}
+
+void Ecs_ResetCommands(EcsCommandBuffer& buffer) {
+	buffer.mCommands.clear();
+	buffer.mCount = 0;
+	buffer.mCreated = 0;
+}
+
+Entity Ecs_RecordCreate(EcsCommandBuffer& buffer, EcsComponentMask mask) {
+	const Entity pending = cEcsPendingEntity | buffer.mCreated++;
+	Record(buffer, CommandType::Create, pending, 0).mMask = mask;
+	return pending;
+}
+
+void Ecs_RecordDestroy(EcsCommandBuffer& buffer, Entity entity) {
+	Record(buffer, CommandType::Destroy, entity, 0);
+}
+
+void Ecs_RecordAdd(EcsCommandBuffer& buffer, Entity entity, uint32_t component, const void* data, uint32_t size) {
+	const uint32_t payloadSize = data ? size : 0;
+	CommandHeader& header = Record(buffer, CommandType::Add, entity, payloadSize);
+	header.mComponent = static_cast<uint16_t>(component);
+	if (payloadSize > 0) {
+		std::memcpy(&header + 1, data, payloadSize);
+	}
+}
+
+void Ecs_RecordRemove(EcsCommandBuffer& buffer, Entity entity, uint32_t component) {
+	Record(buffer, CommandType::Remove, entity, 0).mComponent = static_cast<uint16_t>(component);
+}
+
+uint32_t Ecs_Playback(EcsWorld& world, EcsCommandBuffer& buffer) {
+	std::vector<Entity> created(buffer.mCreated, cInvalidHandle);
+	const uint8_t* current = buffer.mCommands.data();
+	const uint8_t* end = current + buffer.mCommands.size();
+	while (current < end) {
+		const CommandHeader& header = *reinterpret_cast<const CommandHeader*>(current);
+		Entity entity = header.mEntity;
+		if (entity != cInvalidHandle && (entity & cEcsPendingEntity)) {
+			const uint32_t pending = entity & ~cEcsPendingEntity;
+			entity = (pending < created.size()) ? created[pending] : cInvalidHandle;
+		}
+
+		switch (header.mType) {
+		case CommandType::Create:
+			created[header.mEntity & ~cEcsPendingEntity] = Ecs_CreateEntity(world, header.mMask);
+			break;
+		case CommandType::Destroy:
+			Ecs_DestroyEntity(world, entity);
+			break;
+		case CommandType::Add: {
+			const bool hasData = header.mComponent < world.mComponents.size() && header.mSize - sizeof(CommandHeader) >= world.mComponents[header.mComponent].mSize;
+			Ecs_AddComponent(world, entity, header.mComponent, hasData ? &header + 1 : nullptr);
+			break;
+		}
+		case CommandType::Remove:
+			Ecs_RemoveComponent(world, entity, header.mComponent);
+			break;
+		default:
+			break;
+		}
+		current += header.mSize;
+	}
+
+	const uint32_t count = buffer.mCount;
+	Ecs_ResetCommands(buffer);
+	return count;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "CommonDefine.h"
+
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Entity ids pack a slot index (24 bits) and a generation (7 bits) so stale ids are detected after the slot is
+// reused. The top bit marks the entities created by a command buffer that was not played back yet.
+using Entity = uint32_t;
+using EcsComponentMask = uint64_t;
+
+static constexpr uint32_t cEcsMaxComponents = 64;
+static constexpr uint32_t cEcsChunkSize = 16 * 1024;
+static constexpr uint32_t cEcsIndexBits = 24;
+static constexpr Entity cEcsPendingEntity = 0x80000000;
+
+inline EcsComponentMask Ecs_Mask(uint32_t component) {
+	return EcsComponentMask(1) << component;
+}
+
+struct EcsComponentInfo {
+	uint32_t mSize = 0;
+	uint32_t mAlignment = 0;
+};
+
+// Fixed size block holding the entities of one archetype as arrays: the entity ids first, then one array per
+// component in component id order.
+struct EcsChunk {
+	std::vector<uint8_t> mData;
+	uint32_t mCount = 0;
+};
+
+// All the entities with exactly the same set of components. Every chunk is full except the last one.
+struct EcsArchetype {
+	EcsComponentMask mMask = 0;
+	uint32_t mCapacity = 0;							// entities per chunk
+	uint32_t mChunkBytes = 0;
+	uint32_t mCount = 0;
+	uint32_t mOffsets[cEcsMaxComponents];			// component array offset in a chunk, cInvalidHandle when absent
+	uint32_t mAddEdges[cEcsMaxComponents];			// archetype reached by adding a component, resolved on first use
+	uint32_t mRemoveEdges[cEcsMaxComponents];
+	std::vector<EcsChunk> mChunks;
+};
+
+struct EcsEntityRecord {
+	uint32_t mArchetype = cInvalidHandle;
+	uint32_t mChunk = 0;
+	uint32_t mRow = 0;
+	uint32_t mGeneration = 0;
+};
+
+struct EcsWorld {
+	std::vector<EcsComponentInfo> mComponents;
+	std::vector<EcsArchetype> mArchetypes;
+	std::unordered_map<EcsComponentMask, uint32_t> mArchetypeLookup;
+	std::vector<EcsEntityRecord> mEntities;
+	std::vector<uint32_t> mFreeEntities;
+	std::vector<std::vector<uint8_t>> mFreeChunks;
+	uint32_t mAliveCount = 0;
+};
+
+// Matches the archetypes holding every component of mAll and none of mNone. The matching archetypes are cached,
+// archetypes are never removed so every run only tests the ones created since the previous run.
+struct EcsQuery {
+	EcsComponentMask mAll = 0;
+	EcsComponentMask mNone = 0;
+	std::vector<uint32_t> mArchetypes;
+	uint32_t mArchetypesChecked = 0;
+};
+
+struct EcsChunkView {
+	const EcsArchetype* mArchetype = nullptr;
+	uint8_t* mData = nullptr;
+	const Entity* mEntities = nullptr;
+	uint32_t mCount = 0;
+};
+
+// threadIndex is in [0, threadsCount) for Ecs_ForEachParallel and 0 for Ecs_ForEach, to select per thread scratch data.
+using EcsForEachCallback = std::function<void(const EcsChunkView& chunk, uint32_t threadIndex)>;
+
+// Structural changes recorded while the world is iterated (possibly one buffer per thread) and applied later by
+// Ecs_Playback on a single thread. Entities created by the buffer can be referenced by the following commands.
+struct EcsCommandBuffer {
+	std::vector<uint8_t> mCommands;
+	uint32_t mCount = 0;
+	uint32_t mCreated = 0;
+};
+
+// Components are plain data moved with memcpy. Returns the component id, cInvalidHandle once cEcsMaxComponents exist.
+uint32_t Ecs_RegisterComponent(EcsWorld& world, uint32_t size, uint32_t alignment);
+
+template<typename T>
+uint32_t Ecs_RegisterComponent(EcsWorld& world) {
+	static_assert(std::is_trivially_copyable<T>::value, "components are moved with memcpy");
+	return Ecs_RegisterComponent(world, sizeof(T), alignof(T));
+}
+
+// New components are zero filled.
+Entity Ecs_CreateEntity(EcsWorld& world, EcsComponentMask mask);
+
+void Ecs_DestroyEntity(EcsWorld& world, Entity entity);
+
+bool Ecs_IsAlive(const EcsWorld& world, Entity entity);
+
+uint32_t Ecs_GetCount(const EcsWorld& world);
+
+// Moves the entity to the archetype with the component added and copies data into it when not null.
+void Ecs_AddComponent(EcsWorld& world, Entity entity, uint32_t component, const void* data = nullptr);
+
+void Ecs_RemoveComponent(EcsWorld& world, Entity entity, uint32_t component);
+
+bool Ecs_HasComponent(const EcsWorld& world, Entity entity, uint32_t component);
+
+// Pointers stay valid until the next structural change of the world.
+void* Ecs_GetComponent(EcsWorld& world, Entity entity, uint32_t component);
+
+template<typename T>
+T* Ecs_GetComponent(EcsWorld& world, Entity entity, uint32_t component) {
+	return static_cast<T*>(Ecs_GetComponent(world, entity, component));
+}
+
+template<typename T>
+void Ecs_SetComponent(EcsWorld& world, Entity entity, uint32_t component, const T& value) {
+	T* data = Ecs_GetComponent<T>(world, entity, component);
+	if (data) {
+		*data = value;
+	} else {
+		Ecs_AddComponent(world, entity, component, &value);
+	}
+}
+
+EcsQuery Ecs_CreateQuery(EcsComponentMask all, EcsComponentMask none = 0);
+
+uint32_t Ecs_CountEntities(const EcsWorld& world, EcsQuery& query);
+
+// Calls callback once per non empty chunk of the matching archetypes. Structural changes are not allowed from the
+// callback, they have to be recorded in a command buffer.
+void Ecs_ForEach(EcsWorld& world, EcsQuery& query, const EcsForEachCallback& callback);
+
+// Same as Ecs_ForEach with the chunks split in threadsCount slices run on the job system, the callback must only
+// write the chunk it receives.
+void Ecs_ForEachParallel(EcsWorld& world, EcsQuery& query, uint32_t threadsCount, const EcsForEachCallback& callback);
+
+template<typename T>
+T* Ecs_GetArray(const EcsChunkView& chunk, uint32_t component) {
+	const uint32_t offset = chunk.mArchetype->mOffsets[component];
+	return (offset == cInvalidHandle) ? nullptr : reinterpret_cast<T*>(chunk.mData + offset);
+}
+
+void Ecs_ResetCommands(EcsCommandBuffer& buffer);
+
+// Returns a pending entity only valid inside the same buffer.
+Entity Ecs_RecordCreate(EcsCommandBuffer& buffer, EcsComponentMask mask);
+
+void Ecs_RecordDestroy(EcsCommandBuffer& buffer, Entity entity);
+
+// Adds the component if missing, then copies data into it.
+void Ecs_RecordAdd(EcsCommandBuffer& buffer, Entity entity, uint32_t component, const void* data, uint32_t size);
+
+template<typename T>
+void Ecs_RecordAdd(EcsCommandBuffer& buffer, Entity entity, uint32_t component, const T& value) {
+	Ecs_RecordAdd(buffer, entity, component, &value, sizeof(T));
+}
+
+void Ecs_RecordRemove(EcsCommandBuffer& buffer, Entity entity, uint32_t component);
+
+// Applies the commands in recording order and resets the buffer. Returns the number of commands applied.
+uint32_t Ecs_Playback(EcsWorld& world, EcsCommandBuffer& buffer);
@@ -0,0 +1,158 @@
+#include "EcsRender.h"
+
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+glm::mat4 Compose(const EcsTransform& transform) {
+	const glm::quat& q = transform.mRotation;
+	const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+	glm::mat4 world;
+	world[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * transform.mScale.x;
+	world[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * transform.mScale.y;
+	world[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * transform.mScale.z;
+	world[3] = glm::vec4(transform.mTranslation, 1.0f);
+	return world;
+}
+
+inline RenderPacket MakePacket(const EcsRenderMesh& mesh, const EcsTransform& transform) {
+	RenderPacket packet;
+	packet.mProgram = mesh.mProgram;
+	packet.mMesh = mesh.mMesh;
+	packet.mMaterial = mesh.mMaterial;
+	packet.mFirstIndex = mesh.mFirstIndex;
+	packet.mIndexCount = mesh.mIndexCount;
+	packet.mLayer = mesh.mLayer;
+	packet.mTranslucent = mesh.mTranslucent;
+	packet.mModel = transform.mWorld;
+	return packet;
+}
+
+void ExtractChunk(EcsRenderSystem& system, const EcsChunkView& chunk, uint32_t threadIndex, const Frustum& frustum) {
+	const EcsTransform* transforms = Ecs_GetArray<EcsTransform>(chunk, EcsRenderComponent::Transform);
+	const EcsRenderMesh* meshes = Ecs_GetArray<EcsRenderMesh>(chunk, EcsRenderComponent::RenderMesh);
+	const EcsBounds* bounds = Ecs_GetArray<EcsBounds>(chunk, EcsRenderComponent::Bounds);
+	std::vector<RenderPacket>& packets = system.mThreadPackets[threadIndex];
+
+	if (bounds == nullptr) {
+		for (uint32_t i = 0; i < chunk.mCount; i++) {
+			packets.push_back(MakePacket(meshes[i], transforms[i]));
+		}
+		return;
+	}
+
+	CullingSpheres& spheres = system.mThreadSpheres[threadIndex];
+	std::vector<uint32_t>& visible = system.mThreadVisible[threadIndex];
+	if (spheres.mCount < chunk.mCount) {
+		Culling_Resize(spheres, chunk.mCount);
+		visible.resize(chunk.mCount);
+	}
+	for (uint32_t i = 0; i < chunk.mCount; i++) {
+		// the radius grows with the largest scale of the world matrix
+		const glm::mat4& world = transforms[i].mWorld;
+		const float scale = std::sqrt(std::max(std::max(glm::dot(glm::vec3(world[0]), glm::vec3(world[0])), glm::dot(glm::vec3(world[1]), glm::vec3(world[1]))),
+			glm::dot(glm::vec3(world[2]), glm::vec3(world[2]))));
+		Culling_SetSphere(spheres, i, glm::vec3(world * glm::vec4(bounds[i].mCenter, 1.0f)), bounds[i].mRadius * scale);
+	}
+	const uint32_t visibleCount = Culling_TestSpheres(frustum, spheres, 0, chunk.mCount, visible.data());
+	for (uint32_t v = 0; v < visibleCount; v++) {
+		const uint32_t i = visible[v];
+		packets.push_back(MakePacket(meshes[i], transforms[i]));
+	}
+}
+
+}
+
+bool EcsRender_Initialize(EcsWorld& world, EcsRenderSystem& system) {
+	if (!world.mComponents.empty()) {
+		return false;
+	}
+	Ecs_RegisterComponent<EcsTransform>(world);
+	Ecs_RegisterComponent<EcsRenderMesh>(world);
+	Ecs_RegisterComponent<EcsLight>(world);
+	Ecs_RegisterComponent<EcsBounds>(world);
+
+	system.mTransforms = Ecs_CreateQuery(Ecs_Mask(EcsRenderComponent::Transform));
+	system.mRenderables = Ecs_CreateQuery(Ecs_Mask(EcsRenderComponent::Transform) | Ecs_Mask(EcsRenderComponent::RenderMesh));
+	system.mLights = Ecs_CreateQuery(Ecs_Mask(EcsRenderComponent::Light));
+	system.mStats = EcsRenderStats();
+	return true;
+}
+
+void EcsRender_UpdateTransforms(EcsWorld& world, EcsRenderSystem& system, uint32_t threadsCount) {
+	Ecs_ForEachParallel(world, system.mTransforms, threadsCount, [](const EcsChunkView& chunk, uint32_t threadIndex) {
+		TINYNGINE_UNUSED(threadIndex);
+		EcsTransform* transforms = Ecs_GetArray<EcsTransform>(chunk, EcsRenderComponent::Transform);
+		for (uint32_t i = 0; i < chunk.mCount; i++) {
+			transforms[i].mWorld = Compose(transforms[i]);
+		}
+	});
+	system.mStats.mTransforms = Ecs_CountEntities(world, system.mTransforms);
+}
+
+uint32_t EcsRender_Extract(EcsWorld& world, EcsRenderSystem& system, const Frustum& frustum, uint32_t threadsCount, std::vector<RenderPacket>& packets) {
+	threadsCount = std::max(threadsCount, 1u);
+	if (system.mThreadPackets.size() < threadsCount) {
+		system.mThreadPackets.resize(threadsCount);
+		system.mThreadSpheres.resize(threadsCount);
+		system.mThreadVisible.resize(threadsCount);
+	}
+	for (uint32_t t = 0; t < threadsCount; t++) {
+		system.mThreadPackets[t].clear();
+	}
+
+	Ecs_ForEachParallel(world, system.mRenderables, threadsCount, [&system, &frustum](const EcsChunkView& chunk, uint32_t threadIndex) {
+		ExtractChunk(system, chunk, threadIndex, frustum);
+	});
+
+	// every thread got a contiguous range of chunks, appending them in thread order keeps the chunks order
+	packets.clear();
+	for (uint32_t t = 0; t < threadsCount; t++) {
+		packets.insert(packets.end(), system.mThreadPackets[t].begin(), system.mThreadPackets[t].end());
+	}
+
+	system.mStats.mRenderables = Ecs_CountEntities(world, system.mRenderables);
+	system.mStats.mVisible = static_cast<uint32_t>(packets.size());
+	return system.mStats.mVisible;
+}
+
+void EcsRender_GatherLights(EcsWorld& world, EcsRenderSystem& system, std::vector<EcsLightInstance>& lights) {
+	lights.clear();
+	Ecs_ForEach(world, system.mLights, [&lights](const EcsChunkView& chunk, uint32_t threadIndex) {
+		TINYNGINE_UNUSED(threadIndex);
+		const EcsLight* components = Ecs_GetArray<EcsLight>(chunk, EcsRenderComponent::Light);
+		const EcsTransform* transforms = Ecs_GetArray<EcsTransform>(chunk, EcsRenderComponent::Transform);
+		for (uint32_t i = 0; i < chunk.mCount; i++) {
+			EcsLightInstance light;
+			light.mLight = components[i];
+			light.mEntity = chunk.mEntities[i];
+			if (components[i].mDirectional) {
+				const glm::vec3 direction = transforms ? -glm::vec3(transforms[i].mWorld[2]) : glm::vec3(0.0f, 0.0f, -1.0f);
+				light.mDirection = glm::vec4(glm::normalize(direction), 0.0f);
+			} else {
+				light.mDirection = transforms ? glm::vec4(glm::vec3(transforms[i].mWorld[3]), 1.0f) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+			}
+			lights.push_back(light);
+		}
+	});
+}
+
+void EcsRender_SetLight(const ShaderProgramHandle& program, const EcsLightInstance& light) {
+	ShaderProgram_SetVec4(program, "u_light.direction", light.mDirection);
+	ShaderProgram_SetVec3(program, "u_light.ambient", light.mLight.mAmbient);
+	ShaderProgram_SetVec3(program, "u_light.diffuse", light.mLight.mDiffuse);
+	ShaderProgram_SetVec3(program, "u_light.specular", light.mLight.mSpecular);
+	ShaderProgram_SetFloat(program, "u_light.constant", light.mLight.mConstant);
+	ShaderProgram_SetFloat(program, "u_light.linear", light.mLight.mLinear);
+	ShaderProgram_SetFloat(program, "u_light.quadratic", light.mLight.mQuadratic);
+}
+
+const EcsRenderStats& EcsRender_GetStats(const EcsRenderSystem& system) {
+	return system.mStats;
+}
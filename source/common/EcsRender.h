@@ -0,0 +1,102 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Culling.h"
+#include "Ecs.h"
+#include "Frustum.h"
+#include "RenderQueue.h"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include <vector>
+
+// Component ids of the renderer, registered first by EcsRender_Initialize so they are the same in every world.
+struct EcsRenderComponent {
+	enum Enum {
+		Transform,
+		RenderMesh,
+		Light,
+		Bounds,
+		Count
+	};
+};
+
+// mWorld is written by EcsRender_UpdateTransforms from the translation, rotation and scale.
+struct EcsTransform {
+	glm::vec3 mTranslation = glm::vec3(0.0f);
+	glm::quat mRotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 mScale = glm::vec3(1.0f);
+	glm::mat4 mWorld = glm::mat4(1.0f);
+};
+
+// Same fields as RenderPacket, the model matrix comes from the transform.
+struct EcsRenderMesh {
+	ShaderProgramHandle mProgram = ShaderProgramHandle(cInvalidHandle);
+	MeshHandle mMesh = MeshHandle(cInvalidHandle);
+	uint32_t mMaterial = 0;
+	uint32_t mFirstIndex = 0;
+	uint32_t mIndexCount = 0;
+	uint8_t mLayer = 0;
+	bool mTranslucent = false;
+};
+
+// The u_light parameters of the lights shaders. Point lights are placed by the transform translation,
+// directional lights point along the transform -Z axis.
+struct EcsLight {
+	bool mDirectional = false;
+	glm::vec3 mAmbient = glm::vec3(0.05f);
+	glm::vec3 mDiffuse = glm::vec3(1.0f);
+	glm::vec3 mSpecular = glm::vec3(1.0f);
+	float mConstant = 1.0f;
+	float mLinear = 0.09f;
+	float mQuadratic = 0.032f;
+};
+
+// Bounding sphere in object space, entities with a mesh but no bounds are never culled.
+struct EcsBounds {
+	glm::vec3 mCenter = glm::vec3(0.0f);
+	float mRadius = 0.87f;
+};
+
+struct EcsLightInstance {
+	glm::vec4 mDirection;					// as u_light.direction: w = 0 for a direction, w = 1 for a position
+	EcsLight mLight;
+	Entity mEntity;
+};
+
+struct EcsRenderStats {
+	uint32_t mTransforms = 0;
+	uint32_t mRenderables = 0;
+	uint32_t mVisible = 0;
+};
+
+// Queries and per thread scratch memory of the render systems.
+struct EcsRenderSystem {
+	EcsQuery mTransforms;
+	EcsQuery mRenderables;
+	EcsQuery mLights;
+	std::vector<std::vector<RenderPacket>> mThreadPackets;
+	std::vector<CullingSpheres> mThreadSpheres;
+	std::vector<std::vector<uint32_t>> mThreadVisible;
+	EcsRenderStats mStats;
+};
+
+// Registers the render components, the world must not have any component yet.
+bool EcsRender_Initialize(EcsWorld& world, EcsRenderSystem& system);
+
+// Recomputes the world matrix of every transform.
+void EcsRender_UpdateTransforms(EcsWorld& world, EcsRenderSystem& system, uint32_t threadsCount);
+
+// Culls the entities with a mesh against the frustum (bounds spheres go through the SIMD culling paths chunk by
+// chunk) and writes a render packet per visible entity, ready for RenderQueue_Add or an instance batch.
+// Packets are ordered by archetype and chunk whatever the threads count. Returns the number of packets.
+uint32_t EcsRender_Extract(EcsWorld& world, EcsRenderSystem& system, const Frustum& frustum, uint32_t threadsCount, std::vector<RenderPacket>& packets);
+
+void EcsRender_GatherLights(EcsWorld& world, EcsRenderSystem& system, std::vector<EcsLightInstance>& lights);
+
+// Sets the u_light uniforms of the lights shaders, the program must be in use.
+void EcsRender_SetLight(const ShaderProgramHandle& program, const EcsLightInstance& light);
+
+const EcsRenderStats& EcsRender_GetStats(const EcsRenderSystem& system);
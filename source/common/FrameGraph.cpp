@@ -0,0 +1,399 @@
+#include "FrameGraph.h"
+
+#include "Log.h"
+
+#include <algorithm>
+
+namespace
+{
+
+constexpr uint32_t cDepthAttachment = cMaxRenderTargetColors;
+
+bool IsDepthFormat(TextureFormats::Enum format) {
+	return format == TextureFormats::Depth24Stencil8 || format == TextureFormats::Depth32F;
+}
+
+uint64_t GetBytes(const FrameGraphTextureDesc& desc) {
+	// RGB8 is stored padded to 4 bytes by most drivers
+	static const uint32_t cBytesPerPixel[TextureFormats::Count] = { 4, 4, 2, 4, 8, 16, 16, 4, 8, 4, 4 };
+	return uint64_t(desc.mWidth) * uint64_t(desc.mHeight) * cBytesPerPixel[desc.mFormat];
+}
+
+bool IsTransient(const FrameGraphResourceEntry& resource) {
+	return !resource.mImported;
+}
+
+bool IsSameTarget(const RenderTargetParams& a, const RenderTargetParams& b) {
+	if (a.mColorsCount != b.mColorsCount || a.mDepth.mHandle != b.mDepth.mHandle) {
+		return false;
+	}
+	for (uint32_t i = 0; i < a.mColorsCount; i++) {
+		if (a.mColors[i].mHandle != b.mColors[i].mHandle) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Pool texture of the description: a free one of the same size first, then one of the same format left unused by
+// this frame, resized, and only then a new one.
+uint32_t AcquireTexture(FrameGraph& graph, const FrameGraphTextureDesc& desc) {
+	uint32_t found = ~0u;
+	for (uint32_t i = 0; i < graph.mPool.size() && found == ~0u; i++) {
+		const FrameGraphPooledTexture& pooled = graph.mPool[i];
+		if (!pooled.mInUse && pooled.mDesc.mFormat == desc.mFormat && pooled.mDesc.mWidth == desc.mWidth && pooled.mDesc.mHeight == desc.mHeight) {
+			found = i;
+		}
+	}
+	for (uint32_t i = 0; i < graph.mPool.size() && found == ~0u; i++) {
+		FrameGraphPooledTexture& pooled = graph.mPool[i];
+		if (!pooled.mInUse && pooled.mDesc.mFormat == desc.mFormat && pooled.mFrame != graph.mFrame) {
+			Texture_Resize(pooled.mTexture, desc.mWidth, desc.mHeight);
+			pooled.mDesc.mWidth = desc.mWidth;
+			pooled.mDesc.mHeight = desc.mHeight;
+			found = i;
+		}
+	}
+	if (found == ~0u) {
+		FrameGraphPooledTexture pooled;
+		pooled.mTexture = Texture_CreateRenderTarget(desc.mWidth, desc.mHeight, desc.mFormat);
+		if (!pooled.mTexture.IsValid()) {
+			return ~0u;
+		}
+		pooled.mDesc = desc;
+		pooled.mDesc.mFiltering = TextureFilteringMode::Nearest;
+		found = uint32_t(graph.mPool.size());
+		graph.mPool.push_back(pooled);
+	}
+
+	FrameGraphPooledTexture& pooled = graph.mPool[found];
+	if (pooled.mDesc.mFiltering != desc.mFiltering) {
+		Texture_SetFilteringMode(pooled.mTexture, desc.mFiltering);
+		pooled.mDesc.mFiltering = desc.mFiltering;
+	}
+	pooled.mInUse = true;
+	pooled.mFrame = graph.mFrame;
+	return found;
+}
+
+// Passes start with a reference per written resource and resources with one per reading pass, imported ones being
+// read after the frame. Resources nobody reads release their writers, and the passes left without reference the
+// resources they read.
+void Cull(FrameGraph& graph) {
+	for (FrameGraphPass& pass : graph.mPasses) {
+		pass.mRefCount = uint32_t(pass.mWrites.size()) + (pass.mSideEffect ? 1 : 0);
+		pass.mCulled = false;
+	}
+	for (FrameGraphResourceEntry& resource : graph.mResources) {
+		resource.mRefCount = resource.mImported ? 1 : 0;
+	}
+	for (const FrameGraphPass& pass : graph.mPasses) {
+		for (FrameGraphResource read : pass.mReads) {
+			graph.mResources[read].mRefCount++;
+		}
+	}
+
+	std::vector<FrameGraphResource> unused;
+	for (uint32_t i = 0; i < graph.mResources.size(); i++) {
+		if (graph.mResources[i].mRefCount == 0) {
+			unused.push_back(i);
+		}
+	}
+	while (!unused.empty()) {
+		const FrameGraphResource resource = unused.back();
+		unused.pop_back();
+		for (FrameGraphPass& pass : graph.mPasses) {
+			if (pass.mCulled || std::find(pass.mWrites.begin(), pass.mWrites.end(), resource) == pass.mWrites.end()) {
+				continue;
+			}
+			if (--pass.mRefCount == 0) {
+				pass.mCulled = true;
+				for (FrameGraphResource read : pass.mReads) {
+					if (--graph.mResources[read].mRefCount == 0) {
+						unused.push_back(read);
+					}
+				}
+			}
+		}
+	}
+}
+
+bool SetupTarget(FrameGraph& graph, FrameGraphPass& pass, uint32_t slot) {
+	RenderTargetParams params;
+	for (FrameGraphResource write : pass.mWrites) {
+		const FrameGraphResourceEntry& resource = graph.mResources[write];
+		if (IsDepthFormat(resource.mDesc.mFormat)) {
+			params.mDepth = resource.mTexture;
+		} else if (params.mColorsCount < cMaxRenderTargetColors) {
+			params.mColors[params.mColorsCount++] = resource.mTexture;
+		}
+	}
+
+	const TextureHandle& first = (params.mColorsCount > 0) ? params.mColors[0] : params.mDepth;
+	const uint32_t width = Texture_GetWidth(first);
+	const uint32_t height = Texture_GetHeight(first);
+
+	if (slot == graph.mTargets.size()) {
+		FrameGraphTarget target;
+		target.mTarget = RenderTarget_Create(params);
+		target.mParams = params;
+		if (!target.mTarget.IsValid()) {
+			return false;
+		}
+		graph.mTargets.push_back(target);
+	} else if (!IsSameTarget(graph.mTargets[slot].mParams, params) || RenderTarget_GetWidth(graph.mTargets[slot].mTarget) != width ||
+		RenderTarget_GetHeight(graph.mTargets[slot].mTarget) != height) {
+		// other textures, or the same ones resized by the pool
+		FrameGraphTarget& target = graph.mTargets[slot];
+		target.mParams = params;
+		if (!RenderTarget_SetAttachments(target.mTarget, params)) {
+			// forces the attachments to be set again next frame
+			target.mParams = RenderTargetParams();
+			return false;
+		}
+	}
+	pass.mTarget = slot;
+
+	uint32_t color = 0;
+	for (FrameGraphResource write : pass.mWrites) {
+		FrameGraphResourceEntry& resource = graph.mResources[write];
+		resource.mTarget = graph.mTargets[slot].mTarget;
+		resource.mAttachment = IsDepthFormat(resource.mDesc.mFormat) ? cDepthAttachment : color++;
+	}
+	return true;
+}
+
+void InvalidateAttachment(FrameGraph& graph, const RenderTargetHandle& target, uint32_t attachment) {
+	const bool depth = (attachment == cDepthAttachment);
+	if (RenderTarget_Invalidate(target, depth ? 0u : (1u << attachment), depth)) {
+		graph.mStats.mInvalidations++;
+	}
+}
+
+}
+
+void FrameGraph_Destroy(FrameGraph& graph) {
+	for (FrameGraphTarget& target : graph.mTargets) {
+		RenderTarget_Destroy(target.mTarget);
+	}
+	for (FrameGraphPooledTexture& pooled : graph.mPool) {
+		Texture_Destroy(pooled.mTexture);
+	}
+	graph = FrameGraph();
+}
+
+void FrameGraph_Reset(FrameGraph& graph) {
+	graph.mPasses.clear();
+	graph.mResources.clear();
+	graph.mCompiled = false;
+}
+
+FrameGraphResource FrameGraph_CreateTexture(FrameGraph& graph, const char* name, const FrameGraphTextureDesc& desc) {
+	FrameGraphResourceEntry resource;
+	resource.mName = name;
+	resource.mDesc = desc;
+	graph.mResources.push_back(resource);
+	return FrameGraphResource(graph.mResources.size() - 1);
+}
+
+FrameGraphResource FrameGraph_ImportTexture(FrameGraph& graph, const char* name, const TextureHandle& texture) {
+	FrameGraphResourceEntry resource;
+	resource.mName = name;
+	resource.mDesc.mWidth = Texture_GetWidth(texture);
+	resource.mDesc.mHeight = Texture_GetHeight(texture);
+	resource.mDesc.mFormat = Texture_GetFormat(texture);
+	resource.mTexture = texture;
+	resource.mImported = true;
+	graph.mResources.push_back(resource);
+	return FrameGraphResource(graph.mResources.size() - 1);
+}
+
+FrameGraphResource FrameGraph_ImportBackbuffer(FrameGraph& graph, const char* name, uint32_t width, uint32_t height) {
+	FrameGraphResourceEntry resource;
+	resource.mName = name;
+	resource.mDesc.mWidth = width;
+	resource.mDesc.mHeight = height;
+	resource.mImported = true;
+	resource.mBackbuffer = true;
+	graph.mResources.push_back(resource);
+	return FrameGraphResource(graph.mResources.size() - 1);
+}
+
+uint32_t FrameGraph_AddPass(FrameGraph& graph, const char* name, const FrameGraphExecute& execute) {
+	FrameGraphPass pass;
+	pass.mName = name;
+	pass.mExecute = execute;
+	graph.mPasses.push_back(pass);
+	return uint32_t(graph.mPasses.size() - 1);
+}
+
+void FrameGraph_Read(FrameGraph& graph, uint32_t pass, FrameGraphResource resource) {
+	if (pass < graph.mPasses.size() && resource < graph.mResources.size() && !graph.mResources[resource].mBackbuffer) {
+		graph.mPasses[pass].mReads.push_back(resource);
+	}
+}
+
+void FrameGraph_Write(FrameGraph& graph, uint32_t pass, FrameGraphResource resource) {
+	if (pass < graph.mPasses.size() && resource < graph.mResources.size()) {
+		graph.mPasses[pass].mWrites.push_back(resource);
+	}
+}
+
+void FrameGraph_SetSideEffect(FrameGraph& graph, uint32_t pass) {
+	if (pass < graph.mPasses.size()) {
+		graph.mPasses[pass].mSideEffect = true;
+	}
+}
+
+bool FrameGraph_Compile(FrameGraph& graph) {
+	graph.mFrame++;
+	graph.mStats = FrameGraphStats();
+	for (FrameGraphPooledTexture& pooled : graph.mPool) {
+		pooled.mInUse = false;
+	}
+
+	Cull(graph);
+
+	const uint32_t passesCount = uint32_t(graph.mPasses.size());
+	for (uint32_t p = 0; p < passesCount; p++) {
+		FrameGraphPass& pass = graph.mPasses[p];
+		if (pass.mCulled) {
+			graph.mStats.mCulledPasses++;
+			continue;
+		}
+		graph.mStats.mPasses++;
+		for (const std::vector<FrameGraphResource>* list : { &pass.mReads, &pass.mWrites }) {
+			for (FrameGraphResource used : *list) {
+				FrameGraphResourceEntry& resource = graph.mResources[used];
+				resource.mFirstPass = std::min(resource.mFirstPass, p);
+				resource.mLastPass = std::max(resource.mLastPass, p);
+			}
+		}
+	}
+
+	// textures are taken from the pool at the first pass using them and given back after the last one, so later
+	// passes can alias them
+	bool complete = true;
+	uint32_t slot = 0;
+	for (uint32_t p = 0; p < passesCount; p++) {
+		FrameGraphPass& pass = graph.mPasses[p];
+		if (pass.mCulled) {
+			continue;
+		}
+		for (const std::vector<FrameGraphResource>* list : { &pass.mReads, &pass.mWrites }) {
+			for (FrameGraphResource used : *list) {
+				FrameGraphResourceEntry& resource = graph.mResources[used];
+				if (IsTransient(resource) && resource.mFirstPass == p && resource.mPooled == ~0u) {
+					resource.mPooled = AcquireTexture(graph, resource.mDesc);
+					if (resource.mPooled != ~0u) {
+						resource.mTexture = graph.mPool[resource.mPooled].mTexture;
+					}
+					graph.mStats.mTransientTextures++;
+					graph.mStats.mTransientBytes += GetBytes(resource.mDesc);
+				}
+				if (IsTransient(resource) && resource.mLastPass == p && std::find(pass.mReleases.begin(), pass.mReleases.end(), used) == pass.mReleases.end()) {
+					pass.mReleases.push_back(used);
+				}
+			}
+		}
+
+		for (FrameGraphResource write : pass.mWrites) {
+			pass.mBackbuffer = pass.mBackbuffer || graph.mResources[write].mBackbuffer;
+		}
+		bool valid = true;
+		for (FrameGraphResource write : pass.mWrites) {
+			valid = valid && graph.mResources[write].mTexture.IsValid();
+		}
+		if (!pass.mBackbuffer && !pass.mWrites.empty()) {
+			if (valid && SetupTarget(graph, pass, slot)) {
+				slot++;
+			} else {
+				Log(tinyngine::Logger::Error, "Frame graph: skipping pass %s, its target could not be set up", pass.mName);
+				pass.mCulled = true;
+				complete = false;
+			}
+		}
+
+		for (FrameGraphResource release : pass.mReleases) {
+			const FrameGraphResourceEntry& resource = graph.mResources[release];
+			if (resource.mPooled != ~0u) {
+				graph.mPool[resource.mPooled].mInUse = false;
+			}
+		}
+	}
+
+	for (const FrameGraphPooledTexture& pooled : graph.mPool) {
+		if (pooled.mFrame == graph.mFrame) {
+			graph.mStats.mPhysicalTextures++;
+			graph.mStats.mPhysicalBytes += GetBytes(pooled.mDesc);
+		}
+	}
+	graph.mStats.mPooledTextures = uint32_t(graph.mPool.size());
+	graph.mCompiled = true;
+	return complete;
+}
+
+void FrameGraph_Execute(FrameGraph& graph) {
+	if (!graph.mCompiled) {
+		FrameGraph_Compile(graph);
+	}
+
+	const uint32_t passesCount = uint32_t(graph.mPasses.size());
+	for (uint32_t p = 0; p < passesCount; p++) {
+		const FrameGraphPass& pass = graph.mPasses[p];
+		if (pass.mCulled) {
+			continue;
+		}
+
+		if (pass.mBackbuffer) {
+			const FrameGraphResourceEntry* backbuffer = nullptr;
+			for (FrameGraphResource write : pass.mWrites) {
+				if (graph.mResources[write].mBackbuffer) {
+					backbuffer = &graph.mResources[write];
+				}
+			}
+			RenderTarget_BindDefault(backbuffer->mDesc.mWidth, backbuffer->mDesc.mHeight);
+		} else if (pass.mTarget != ~0u) {
+			// the previous content of aliased textures is garbage, it does not have to be loaded
+			const RenderTargetHandle& target = graph.mTargets[pass.mTarget].mTarget;
+			uint32_t colorsMask = 0;
+			bool depth = false;
+			for (FrameGraphResource write : pass.mWrites) {
+				const FrameGraphResourceEntry& resource = graph.mResources[write];
+				if (IsTransient(resource) && resource.mFirstPass == p) {
+					if (resource.mAttachment == cDepthAttachment) {
+						depth = true;
+					} else {
+						colorsMask |= 1u << resource.mAttachment;
+					}
+				}
+			}
+			if ((colorsMask != 0 || depth) && RenderTarget_Invalidate(target, colorsMask, depth)) {
+				graph.mStats.mInvalidations++;
+			}
+			RenderTarget_Bind(target);
+		}
+
+		pass.mExecute(graph);
+
+		// nothing reads these any more, e.g. the depth buffer once the scene is drawn
+		for (FrameGraphResource release : pass.mReleases) {
+			const FrameGraphResourceEntry& resource = graph.mResources[release];
+			if (resource.mTarget.IsValid()) {
+				InvalidateAttachment(graph, resource.mTarget, resource.mAttachment);
+			}
+		}
+	}
+	graph.mCompiled = false;
+}
+
+TextureHandle FrameGraph_GetTexture(const FrameGraph& graph, FrameGraphResource resource) {
+	if (resource >= graph.mResources.size()) {
+		return TextureHandle(cInvalidHandle);
+	}
+	return graph.mResources[resource].mTexture;
+}
+
+const FrameGraphStats& FrameGraph_GetStats(const FrameGraph& graph) {
+	return graph.mStats;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "RenderTarget.h"
+#include "Texture.h"
+
+#include <functional>
+#include <vector>
+
+// Index of a virtual resource of the current frame.
+using FrameGraphResource = uint32_t;
+
+static constexpr FrameGraphResource cFrameGraphInvalidResource = ~0u;
+
+struct FrameGraphTextureDesc {
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	TextureFormats::Enum mFormat = TextureFormats::RGBA8;
+	TextureFilteringMode::Enum mFiltering = TextureFilteringMode::Nearest;	// not part of the aliasing key
+};
+
+struct FrameGraph;
+
+// Records the GL work of a pass. The graph has bound the target made of the pass writes (or the window framebuffer)
+// with the viewport set to its size; transient textures are fetched with FrameGraph_GetTexture.
+using FrameGraphExecute = std::function<void(const FrameGraph& graph)>;
+
+struct FrameGraphStats {
+	uint32_t mPasses = 0;
+	uint32_t mCulledPasses = 0;
+	uint32_t mTransientTextures = 0;			// virtual textures of the executed passes
+	uint32_t mPhysicalTextures = 0;				// pooled textures backing them this frame
+	uint32_t mPooledTextures = 0;				// pool size, the peak of the frames so far
+	uint32_t mInvalidations = 0;				// glInvalidateFramebuffer calls
+	uint64_t mTransientBytes = 0;				// memory the virtual textures would need without aliasing
+	uint64_t mPhysicalBytes = 0;
+};
+
+struct FrameGraphResourceEntry {
+	const char* mName = nullptr;
+	FrameGraphTextureDesc mDesc;
+	TextureHandle mTexture = TextureHandle(cInvalidHandle);
+	bool mImported = false;						// owned outside of the graph, never aliased nor invalidated
+	bool mBackbuffer = false;					// the window framebuffer
+	uint32_t mRefCount = 0;
+	uint32_t mFirstPass = ~0u;					// lifetime in executed passes
+	uint32_t mLastPass = 0;
+	uint32_t mPooled = ~0u;						// index in the pool of a transient texture
+	RenderTargetHandle mTarget = RenderTargetHandle(cInvalidHandle);	// where it was last written
+	uint32_t mAttachment = 0;					// color index in mTarget, cMaxRenderTargetColors for depth
+};
+
+struct FrameGraphPass {
+	const char* mName = nullptr;
+	FrameGraphExecute mExecute;
+	std::vector<FrameGraphResource> mReads;
+	std::vector<FrameGraphResource> mWrites;
+	std::vector<FrameGraphResource> mReleases;	// transient textures whose lifetime ends with the pass
+	bool mSideEffect = false;
+	bool mCulled = false;
+	uint32_t mRefCount = 0;
+	uint32_t mTarget = ~0u;						// index in FrameGraph::mTargets, ~0 when the pass writes no texture
+	bool mBackbuffer = false;					// writes the window framebuffer
+};
+
+struct FrameGraphPooledTexture {
+	FrameGraphTextureDesc mDesc;
+	TextureHandle mTexture = TextureHandle(cInvalidHandle);
+	bool mInUse = false;
+	uint64_t mFrame = 0;						// last frame it was used
+};
+
+// Framebuffer object reused by the passes in the same position every frame, re-pointed only when its attachments
+// change.
+struct FrameGraphTarget {
+	RenderTargetHandle mTarget = RenderTargetHandle(cInvalidHandle);
+	RenderTargetParams mParams;
+};
+
+// Passes declare the virtual textures they read (sampled) and write (attachments), then the graph is compiled and
+// executed once per frame. Compiling culls the passes that contribute to no imported resource nor have side
+// effects, computes the lifetime of every transient texture over the remaining passes, and backs them with pooled
+// textures that are handed over to the next transient of the same description once a lifetime ends. Texture and
+// framebuffer handles are never recycled, so the pool only grows to the peak need and stale textures are resized
+// rather than replaced. The attachments of a transient texture are invalidated before its first write and after
+// its last use.
+struct FrameGraph {
+	std::vector<FrameGraphPass> mPasses;
+	std::vector<FrameGraphResourceEntry> mResources;
+	std::vector<FrameGraphPooledTexture> mPool;
+	std::vector<FrameGraphTarget> mTargets;
+	uint64_t mFrame = 0;
+	bool mCompiled = false;
+	FrameGraphStats mStats;
+};
+
+void FrameGraph_Destroy(FrameGraph& graph);
+
+// Forgets the passes and resources of the previous frame, keeps the pool.
+void FrameGraph_Reset(FrameGraph& graph);
+
+// Texture allocated by the graph for the passes using it.
+FrameGraphResource FrameGraph_CreateTexture(FrameGraph& graph, const char* name, const FrameGraphTextureDesc& desc);
+
+// Texture owned by the caller, e.g. a shadow map kept across frames. Writing it keeps the writers alive.
+FrameGraphResource FrameGraph_ImportTexture(FrameGraph& graph, const char* name, const TextureHandle& texture);
+
+// The window framebuffer. A pass writing it cannot write textures.
+FrameGraphResource FrameGraph_ImportBackbuffer(FrameGraph& graph, const char* name, uint32_t width, uint32_t height);
+
+// Names must outlive the frame, e.g. string literals.
+uint32_t FrameGraph_AddPass(FrameGraph& graph, const char* name, const FrameGraphExecute& execute);
+
+void FrameGraph_Read(FrameGraph& graph, uint32_t pass, FrameGraphResource resource);
+
+// Color textures are attached in the order of the calls, a depth format texture is the depth attachment.
+void FrameGraph_Write(FrameGraph& graph, uint32_t pass, FrameGraphResource resource);
+
+// The pass is never culled, e.g. it reads back results or writes buffers.
+void FrameGraph_SetSideEffect(FrameGraph& graph, uint32_t pass);
+
+// Culls the passes, assigns the pooled textures and sets up the framebuffers. Returns false when a target could not
+// be set up, the passes using it are then skipped.
+bool FrameGraph_Compile(FrameGraph& graph);
+
+// Runs the passes left by FrameGraph_Compile in the order they were added.
+void FrameGraph_Execute(FrameGraph& graph);
+
+// Texture of a resource, valid from the compilation to the end of the last pass using it.
+TextureHandle FrameGraph_GetTexture(const FrameGraph& graph, FrameGraphResource resource);
+
+const FrameGraphStats& FrameGraph_GetStats(const FrameGraph& graph);
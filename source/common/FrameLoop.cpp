@@ -0,0 +1,131 @@
+#include "FrameLoop.h"
+
+#include "GLApi.h"
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+
+constexpr GLuint64 cFenceTimeout = 1000000000;	// 1 s, only reached when the GPU hangs
+
+using Clock = std::chrono::steady_clock;
+
+double Milliseconds(double start) {
+	return (FrameLoop_GetTime() - start) * 1000.0;
+}
+
+FrameTime Advance(FrameLoop& loop) {
+	FrameTime time;
+	time.mTime = FrameLoop_GetTime();
+	time.mFrame = loop.mLastTime.mFrame + 1;
+	time.mDelta = (loop.mLastTime.mFrame > 0) ? time.mTime - loop.mLastTime.mTime : 0.0;
+	loop.mLastTime = time;
+	return time;
+}
+
+void Simulate(FrameLoop& loop, uint32_t snapshot, const FrameSimulateCallback& simulate) {
+	const double start = FrameLoop_GetTime();
+	simulate(snapshot, loop.mTimes[snapshot]);
+	loop.mSimulateTime = Milliseconds(start);
+}
+
+// Waits for the oldest frames until fewer than maxLatency are in flight.
+void WaitFences(FrameLoop& loop, uint32_t maxLatency) {
+	uint32_t retired = 0;
+	while (loop.mFencesCount - retired >= maxLatency) {
+		GLsync fence = static_cast<GLsync>(loop.mFences[retired]);
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, cFenceTimeout);
+		glDeleteSync(fence);
+		retired++;
+	}
+	if (retired > 0) {
+		std::copy(loop.mFences + retired, loop.mFences + loop.mFencesCount, loop.mFences);
+		loop.mFencesCount -= retired;
+	}
+}
+
+void Render(FrameLoop& loop, const FrameRenderCallback& render) {
+	const double waitStart = FrameLoop_GetTime();
+	WaitFences(loop, loop.mParams.mMaxFrameLatency);
+	loop.mStats.mGpuWait = Milliseconds(waitStart);
+
+	const double renderStart = FrameLoop_GetTime();
+	render(loop.mFront, loop.mTimes[loop.mFront]);
+	loop.mFences[loop.mFencesCount++] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	loop.mStats.mRender = Milliseconds(renderStart);
+}
+
+}
+
+double FrameLoop_GetTime() {
+	static const Clock::time_point sStart = Clock::now();
+	return std::chrono::duration<double>(Clock::now() - sStart).count();
+}
+
+void FrameLoop_Initialize(FrameLoop& loop, const FrameLoopParams& params) {
+	FrameLoop_SetParams(loop, params);
+	loop.mTimes[0] = FrameTime();
+	loop.mTimes[1] = FrameTime();
+	loop.mLastTime = FrameTime();
+	loop.mFront = 0;
+	loop.mPending = false;
+	loop.mFencesCount = 0;
+	loop.mStats = FrameLoopStats();
+}
+
+void FrameLoop_Shutdown(FrameLoop& loop) {
+	FrameLoop_Flush(loop);
+	loop.mPending = false;
+	for (uint32_t i = 0; i < loop.mFencesCount; i++) {
+		glDeleteSync(static_cast<GLsync>(loop.mFences[i]));
+	}
+	loop.mFencesCount = 0;
+}
+
+void FrameLoop_SetParams(FrameLoop& loop, const FrameLoopParams& params) {
+	loop.mParams = params;
+	loop.mParams.mMaxFrameLatency = std::min(std::max(params.mMaxFrameLatency, 1u), cFrameLoopMaxLatency);
+}
+
+void FrameLoop_Frame(FrameLoop& loop, const FrameSimulateCallback& simulate, const FrameRenderCallback& render) {
+	loop.mStats = FrameLoopStats();
+	bool simulated = false;
+	if (loop.mPending) {
+		const double waitStart = FrameLoop_GetTime();
+		Job_Wait(loop.mSimulation);
+		loop.mStats.mSimulationWait = Milliseconds(waitStart);
+		loop.mStats.mSimulate = loop.mSimulateTime;
+		loop.mFront ^= 1;
+		loop.mPending = false;
+		simulated = true;
+	}
+
+	// sequential frames, and the first pipelined one, render what they just simulated
+	if (!simulated) {
+		loop.mTimes[loop.mFront] = Advance(loop);
+		Simulate(loop, loop.mFront, simulate);
+		loop.mStats.mSimulate = loop.mSimulateTime;
+	}
+
+	if (loop.mParams.mPipelined) {
+		// the time is taken here, right after the input was processed, not when a worker picks the job up
+		const uint32_t back = loop.mFront ^ 1;
+		loop.mTimes[back] = Advance(loop);
+		loop.mPending = true;
+		FrameLoop* self = &loop;
+		Job_Run([self, back, simulate]() { Simulate(*self, back, simulate); }, &loop.mSimulation);
+	}
+
+	Render(loop, render);
+}
+
+void FrameLoop_Flush(FrameLoop& loop) {
+	if (loop.mPending) {
+		Job_Wait(loop.mSimulation);
+	}
+}
+
+const FrameLoopStats& FrameLoop_GetStats(const FrameLoop& loop) {
+	return loop.mStats;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "JobSystem.h"
+
+#include <functional>
+
+static constexpr uint32_t cFrameLoopMaxLatency = 4;
+
+struct FrameTime {
+	uint64_t mFrame = 0;
+	double mTime = 0.0;							// seconds from FrameLoop_GetTime
+	double mDelta = 0.0;
+};
+
+struct FrameLoopParams {
+	bool mPipelined = true;
+	uint32_t mMaxFrameLatency = 2;				// frames the GPU may run behind the submission, 1 to cFrameLoopMaxLatency
+};
+
+// Timings of the last frame in milliseconds.
+struct FrameLoopStats {
+	double mSimulate = 0.0;
+	double mSimulationWait = 0.0;				// time the render thread waited for the simulation to finish
+	double mGpuWait = 0.0;						// time spent waiting on the fence of an older frame
+	double mRender = 0.0;
+};
+
+// Simulation and rendering share two snapshots: a pipelined frame simulates N + 1 on the job system into one of
+// them while N is rendered from the other. The simulation callback owns everything it touches until the next
+// FrameLoop_Frame or FrameLoop_Flush, the render callback must only read its snapshot (and render thread state,
+// e.g. a camera updated from the latest input).
+struct FrameLoop {
+	FrameLoopParams mParams;
+	JobCounter mSimulation;
+	FrameTime mTimes[2];
+	FrameTime mLastTime;
+	uint32_t mFront = 0;						// snapshot rendered this frame
+	bool mPending = false;						// the other snapshot is being (or was) simulated and is not rendered yet
+	double mSimulateTime = 0.0;					// written by the simulation job, copied to mStats once it is waited for
+	void* mFences[cFrameLoopMaxLatency];		// GLsync of the frames in flight, oldest first
+	uint32_t mFencesCount = 0;
+	FrameLoopStats mStats;
+};
+
+using FrameSimulateCallback = std::function<void(uint32_t snapshot, const FrameTime& time)>;
+using FrameRenderCallback = std::function<void(uint32_t snapshot, const FrameTime& time)>;
+
+// Monotonic seconds since the first call, in double precision so frame deltas stay exact over long uptimes.
+double FrameLoop_GetTime();
+
+void FrameLoop_Initialize(FrameLoop& loop, const FrameLoopParams& params = FrameLoopParams());
+
+// Waits for the simulation in flight and releases the fences.
+void FrameLoop_Shutdown(FrameLoop& loop);
+
+// Applied from the next frame. When pipelining is turned off, the snapshot in flight is still rendered first.
+void FrameLoop_SetParams(FrameLoop& loop, const FrameLoopParams& params);
+
+// GL thread only. Pipelined, waits for the simulation started by the previous call, starts the next one into the
+// other snapshot, then renders the finished one. Otherwise simulates and renders the same snapshot in sequence.
+// Before rendering, waits until at most mMaxFrameLatency - 1 older frames are still queued on the GPU; the
+// fence of this frame is inserted after render returns, the caller swaps buffers afterwards.
+void FrameLoop_Frame(FrameLoop& loop, const FrameSimulateCallback& simulate, const FrameRenderCallback& render);
+
+// Waits for the simulation in flight, after which the render thread may touch the simulation state.
+void FrameLoop_Flush(FrameLoop& loop);
+
+const FrameLoopStats& FrameLoop_GetStats(const FrameLoop& loop);
@@ -0,0 +1,39 @@
+#include "Frustum.h"
+
+#include "Camera.h"
+#include "glm/geometric.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+Frustum Frustum_FromMatrix(const glm::mat4& viewProjection) {
+	// Gribb/Hartmann extraction, glm matrices are column major so rows are gathered across columns
+	glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	Frustum frustum;
+	frustum.mPlanes[FrustumPlane::Left] = row3 + row0;
+	frustum.mPlanes[FrustumPlane::Right] = row3 - row0;
+	frustum.mPlanes[FrustumPlane::Bottom] = row3 + row1;
+	frustum.mPlanes[FrustumPlane::Top] = row3 - row1;
+	frustum.mPlanes[FrustumPlane::Near] = row3 + row2;
+	frustum.mPlanes[FrustumPlane::Far] = row3 - row2;
+	for (auto& plane : frustum.mPlanes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+	return frustum;
+}
+
+Frustum Frustum_FromCamera(const Camera& camera, float aspectRatio, float nearPlane, float farPlane) {
+	glm::mat4 projection = glm::perspective(glm::radians(camera.GetFOV()), aspectRatio, nearPlane, farPlane);
+	return Frustum_FromMatrix(projection * camera.GetViewMatrix());
+}
+
+bool Frustum_TestSphere(const Frustum& frustum, const glm::vec3& center, float radius) {
+	for (const auto& plane : frustum.mPlanes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+
+class Camera;
+
+struct FrustumPlane {
+	enum Enum {
+		Left,
+		Right,
+		Bottom,
+		Top,
+		Near,
+		Far,
+		Count
+	};
+};
+
+// Planes are normalized and point inwards: a point p is inside when dot(plane.xyz, p) + plane.w >= 0.
+struct Frustum {
+	glm::vec4 mPlanes[FrustumPlane::Count];
+};
+
+Frustum Frustum_FromMatrix(const glm::mat4& viewProjection);
+
+// Same perspective projection the samples build from the camera field of view.
+Frustum Frustum_FromCamera(const Camera& camera, float aspectRatio, float nearPlane, float farPlane);
+
+bool Frustum_TestSphere(const Frustum& frustum, const glm::vec3& center, float radius);
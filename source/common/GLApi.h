@@ -15,4 +15,4 @@ namespace gl { namespace details { const char* GetErrorString(GLenum _enum); } }
 			_call; \
 			GLenum glError = glGetError(); \
 			if (glError != GL_NO_ERROR) { Log(tinyngine::Logger::Error, "GL error 0x%x %s", glError, gl::details::GetErrorString(glError)); abort(); } \
-			break; }
\ No newline at end of file
+			break; }
@@ -0,0 +1,673 @@
+#include "GLRecorder.h"
+
+#include "GLApi.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(TINYNGINE_GL_RECORDER)
+#include <climits>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+struct BufferRange {
+	GLuint mBuffer = 0;
+	GLintptr mOffset = 0;
+	GLsizeiptr mSize = -1;						// whole buffer
+
+	bool operator==(const BufferRange& other) const {
+		return mBuffer == other.mBuffer && mOffset == other.mOffset && mSize == other.mSize;
+	}
+};
+
+struct Recorder {
+	GLRecorderParams mParams;
+	bool mActive = false;
+	FILE* mStream = nullptr;
+	std::string mStreamFile;
+	void* mFunctions[GLEntryPoint::Count] = {};	// driver entry points when forwarding
+	GLRecorderStats mStats;
+
+	// GL state as set by the recorded calls, to find the redundant ones
+	GLenum mActiveTexture = GL_TEXTURE0;
+	GLuint mProgram = 0;
+	GLuint mVertexArray = 0;
+	GLuint mDrawFramebuffer = 0;
+	GLuint mReadFramebuffer = 0;
+	std::map<GLenum, GLuint> mBuffers;									// per target, but the element array one
+	std::map<GLuint, GLuint> mElementBuffers;							// per vertex array
+	std::map<std::pair<GLenum, GLuint>, BufferRange> mIndexedBuffers;	// per target and index
+	std::map<std::pair<GLenum, GLenum>, GLuint> mTextures;				// per texture unit and target
+	std::map<std::pair<GLuint, GLint>, std::vector<uint8_t>> mUniforms;	// per program and location
+
+	// null GL
+	GLuint mNextName = 0;
+	std::map<GLuint, std::map<std::string, GLint>> mLocations;			// per program, uniforms and blocks
+};
+
+Recorder sRecorder;
+
+template<GLEntryPoint::Enum Entry>
+struct GLTag {};
+
+// Converts to the default value of any return type, for the entry points without a null implementation.
+struct NullValue {
+	template<typename T>
+	operator T() const { return T(); }
+};
+
+const char* const cEntryPointNames[GLEntryPoint::Count] = {
+#define TINYNGINE_GL_RECORDER_NAME(name) "gl" #name,
+	TINYNGINE_GL_RECORDER_ENTRY_POINTS(TINYNGINE_GL_RECORDER_NAME)
+#undef TINYNGINE_GL_RECORDER_NAME
+};
+
+bool IsDrawCall(GLEntryPoint::Enum entryPoint) {
+	switch (entryPoint) {
+	case GLEntryPoint::DispatchCompute:
+	case GLEntryPoint::DrawArrays:
+	case GLEntryPoint::DrawArraysInstanced:
+	case GLEntryPoint::DrawElements:
+	case GLEntryPoint::DrawElementsInstanced:
+	case GLEntryPoint::DrawElementsInstancedBaseVertex:
+	case GLEntryPoint::DrawElementsInstancedBaseVertexBaseInstance:
+	case GLEntryPoint::MultiDrawElements:
+	case GLEntryPoint::MultiDrawElementsIndirect:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Stream arguments: integers and floats as they are, pointers are only told apart from null so that streams of
+// different runs can be compared, strings (uniform names) are quoted.
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type WriteArgument(FILE* stream, T value) {
+	fprintf(stream, " %lld", static_cast<long long>(value));
+}
+
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type WriteArgument(FILE* stream, T value) {
+	fprintf(stream, " %llu", static_cast<unsigned long long>(value));
+}
+
+template<typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type WriteArgument(FILE* stream, T value) {
+	fprintf(stream, " %g", static_cast<double>(value));
+}
+
+template<typename T>
+void WriteArgument(FILE* stream, T* value) {
+	fputs((value != nullptr) ? " ptr" : " null", stream);
+}
+
+void WriteArgument(FILE* stream, const char* value) {
+	if (value != nullptr) {
+		fprintf(stream, " \"%s\"", value);
+	} else {
+		fputs(" null", stream);
+	}
+}
+
+template<typename... Args>
+void RecordCall(GLEntryPoint::Enum entryPoint, Args... args) {
+	sRecorder.mStats.mCalls++;
+	sRecorder.mStats.mEntryPointCalls[entryPoint]++;
+	if (IsDrawCall(entryPoint)) {
+		sRecorder.mStats.mDrawCalls++;
+	}
+	if (sRecorder.mStream != nullptr) {
+		fputs(cEntryPointNames[entryPoint], sRecorder.mStream);
+		const int expand[] = { 0, (WriteArgument(sRecorder.mStream, args), 0)... };
+		TINYNGINE_UNUSED(expand);
+		fputc('\n', sRecorder.mStream);
+	}
+}
+
+template<typename T>
+void SetBinding(T& binding, const T& value) {
+	if (binding == value) {
+		sRecorder.mStats.mRedundantBinds++;
+	}
+	binding = value;
+}
+
+void SetUniform(GLint location, const void* data, size_t size) {
+	if (location < 0) {
+		return;
+	}
+	std::vector<uint8_t>& value = sRecorder.mUniforms[std::make_pair(sRecorder.mProgram, location)];
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	if (value.size() == size && std::equal(value.begin(), value.end(), bytes)) {
+		sRecorder.mStats.mRedundantUniforms++;
+		return;
+	}
+	value.assign(bytes, bytes + size);
+}
+
+// Linking resets the uniforms of a program.
+void ForgetUniforms(GLuint program) {
+	auto begin = sRecorder.mUniforms.lower_bound(std::make_pair(program, GLint(INT_MIN)));
+	auto end = sRecorder.mUniforms.upper_bound(std::make_pair(program, GLint(INT_MAX)));
+	sRecorder.mUniforms.erase(begin, end);
+}
+
+// Tightly packed pixels, the unpack alignment is not accounted for.
+uint64_t GetPixelSize(GLenum format, GLenum type) {
+	switch (type) {
+	case GL_UNSIGNED_INT_24_8:
+	case GL_UNSIGNED_INT_10F_11F_11F_REV:
+	case GL_UNSIGNED_INT_2_10_10_10_REV:
+	case GL_UNSIGNED_INT_5_9_9_9_REV:
+		return 4;
+	case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+		return 8;
+	default:
+		break;
+	}
+	uint64_t components = 4;
+	switch (format) {
+	case GL_RED:
+	case GL_RED_INTEGER:
+	case GL_DEPTH_COMPONENT:
+	case GL_STENCIL_INDEX:
+		components = 1;
+		break;
+	case GL_RG:
+	case GL_RG_INTEGER:
+		components = 2;
+		break;
+	case GL_RGB:
+	case GL_BGR:
+	case GL_RGB_INTEGER:
+		components = 3;
+		break;
+	default:
+		break;
+	}
+	switch (type) {
+	case GL_UNSIGNED_SHORT:
+	case GL_SHORT:
+	case GL_HALF_FLOAT:
+		return components * 2;
+	case GL_UNSIGNED_INT:
+	case GL_INT:
+	case GL_FLOAT:
+		return components * 4;
+	default:
+		return components;
+	}
+}
+
+// State tracking, done whether the call is forwarded or not.
+template<GLEntryPoint::Enum Entry, typename... Args>
+void Track(GLTag<Entry>, Args...) {}
+
+void Track(GLTag<GLEntryPoint::ActiveTexture>, GLenum texture) {
+	SetBinding(sRecorder.mActiveTexture, texture);
+}
+
+void Track(GLTag<GLEntryPoint::BindBuffer>, GLenum target, GLuint buffer) {
+	SetBinding((target == GL_ELEMENT_ARRAY_BUFFER) ? sRecorder.mElementBuffers[sRecorder.mVertexArray] : sRecorder.mBuffers[target], buffer);
+}
+
+// Indexed binds bind the generic binding point too.
+void Track(GLTag<GLEntryPoint::BindBufferBase>, GLenum target, GLuint index, GLuint buffer) {
+	BufferRange range;
+	range.mBuffer = buffer;
+	SetBinding(sRecorder.mIndexedBuffers[std::make_pair(target, index)], range);
+	sRecorder.mBuffers[target] = buffer;
+}
+
+void Track(GLTag<GLEntryPoint::BindBufferRange>, GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+	BufferRange range;
+	range.mBuffer = buffer;
+	range.mOffset = offset;
+	range.mSize = size;
+	SetBinding(sRecorder.mIndexedBuffers[std::make_pair(target, index)], range);
+	sRecorder.mBuffers[target] = buffer;
+}
+
+void Track(GLTag<GLEntryPoint::BindFramebuffer>, GLenum target, GLuint framebuffer) {
+	if (target == GL_FRAMEBUFFER) {
+		if (sRecorder.mDrawFramebuffer == framebuffer && sRecorder.mReadFramebuffer == framebuffer) {
+			sRecorder.mStats.mRedundantBinds++;
+		}
+		sRecorder.mDrawFramebuffer = framebuffer;
+		sRecorder.mReadFramebuffer = framebuffer;
+	} else {
+		SetBinding((target == GL_READ_FRAMEBUFFER) ? sRecorder.mReadFramebuffer : sRecorder.mDrawFramebuffer, framebuffer);
+	}
+}
+
+void Track(GLTag<GLEntryPoint::BindTexture>, GLenum target, GLuint texture) {
+	SetBinding(sRecorder.mTextures[std::make_pair(sRecorder.mActiveTexture, target)], texture);
+}
+
+void Track(GLTag<GLEntryPoint::BindVertexArray>, GLuint array) {
+	SetBinding(sRecorder.mVertexArray, array);
+}
+
+void Track(GLTag<GLEntryPoint::UseProgram>, GLuint program) {
+	SetBinding(sRecorder.mProgram, program);
+}
+
+void Track(GLTag<GLEntryPoint::BufferData>, GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+	TINYNGINE_UNUSED(target); TINYNGINE_UNUSED(usage);
+	if (data != nullptr && size > 0) {
+		sRecorder.mStats.mBytesUploaded += uint64_t(size);
+	}
+}
+
+void Track(GLTag<GLEntryPoint::BufferSubData>, GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+	TINYNGINE_UNUSED(target); TINYNGINE_UNUSED(offset);
+	if (data != nullptr && size > 0) {
+		sRecorder.mStats.mBytesUploaded += uint64_t(size);
+	}
+}
+
+void Track(GLTag<GLEntryPoint::TexImage2D>, GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border,
+	GLenum format, GLenum type, const void* pixels) {
+	TINYNGINE_UNUSED(target); TINYNGINE_UNUSED(level); TINYNGINE_UNUSED(internalformat); TINYNGINE_UNUSED(border);
+	if (pixels != nullptr && width > 0 && height > 0) {
+		sRecorder.mStats.mBytesUploaded += uint64_t(width) * uint64_t(height) * GetPixelSize(format, type);
+	}
+}
+
+// Deleting a bound object reverts the bindings of the context to 0, names may be reused right after.
+void Track(GLTag<GLEntryPoint::DeleteBuffers>, GLsizei n, const GLuint* buffers) {
+	for (GLsizei i = 0; i < n; i++) {
+		for (auto& binding : sRecorder.mBuffers) {
+			binding.second = (binding.second == buffers[i]) ? 0 : binding.second;
+		}
+		for (auto& binding : sRecorder.mIndexedBuffers) {
+			binding.second = (binding.second.mBuffer == buffers[i]) ? BufferRange() : binding.second;
+		}
+		GLuint& elements = sRecorder.mElementBuffers[sRecorder.mVertexArray];
+		elements = (elements == buffers[i]) ? 0 : elements;
+	}
+}
+
+void Track(GLTag<GLEntryPoint::DeleteFramebuffers>, GLsizei n, const GLuint* framebuffers) {
+	for (GLsizei i = 0; i < n; i++) {
+		sRecorder.mDrawFramebuffer = (sRecorder.mDrawFramebuffer == framebuffers[i]) ? 0 : sRecorder.mDrawFramebuffer;
+		sRecorder.mReadFramebuffer = (sRecorder.mReadFramebuffer == framebuffers[i]) ? 0 : sRecorder.mReadFramebuffer;
+	}
+}
+
+void Track(GLTag<GLEntryPoint::DeleteProgram>, GLuint program) {
+	ForgetUniforms(program);
+}
+
+void Track(GLTag<GLEntryPoint::DeleteTextures>, GLsizei n, const GLuint* textures) {
+	for (GLsizei i = 0; i < n; i++) {
+		for (auto& binding : sRecorder.mTextures) {
+			binding.second = (binding.second == textures[i]) ? 0 : binding.second;
+		}
+	}
+}
+
+void Track(GLTag<GLEntryPoint::DeleteVertexArrays>, GLsizei n, const GLuint* arrays) {
+	for (GLsizei i = 0; i < n; i++) {
+		sRecorder.mVertexArray = (sRecorder.mVertexArray == arrays[i]) ? 0 : sRecorder.mVertexArray;
+		sRecorder.mElementBuffers.erase(arrays[i]);
+	}
+}
+
+void Track(GLTag<GLEntryPoint::LinkProgram>, GLuint program) {
+	ForgetUniforms(program);
+}
+
+void Track(GLTag<GLEntryPoint::Uniform1f>, GLint location, GLfloat v0) {
+	SetUniform(location, &v0, sizeof(v0));
+}
+
+void Track(GLTag<GLEntryPoint::Uniform1i>, GLint location, GLint v0) {
+	SetUniform(location, &v0, sizeof(v0));
+}
+
+void Track(GLTag<GLEntryPoint::Uniform2f>, GLint location, GLfloat v0, GLfloat v1) {
+	const GLfloat value[] = { v0, v1 };
+	SetUniform(location, value, sizeof(value));
+}
+
+void Track(GLTag<GLEntryPoint::Uniform3f>, GLint location, GLfloat v0, GLfloat v1, GLfloat v2) {
+	const GLfloat value[] = { v0, v1, v2 };
+	SetUniform(location, value, sizeof(value));
+}
+
+void Track(GLTag<GLEntryPoint::Uniform4f>, GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3) {
+	const GLfloat value[] = { v0, v1, v2, v3 };
+	SetUniform(location, value, sizeof(value));
+}
+
+void Track(GLTag<GLEntryPoint::Uniform2fv>, GLint location, GLsizei count, const GLfloat* value) {
+	SetUniform(location, value, size_t(count) * 2 * sizeof(GLfloat));
+}
+
+void Track(GLTag<GLEntryPoint::Uniform3fv>, GLint location, GLsizei count, const GLfloat* value) {
+	SetUniform(location, value, size_t(count) * 3 * sizeof(GLfloat));
+}
+
+void Track(GLTag<GLEntryPoint::Uniform4fv>, GLint location, GLsizei count, const GLfloat* value) {
+	SetUniform(location, value, size_t(count) * 4 * sizeof(GLfloat));
+}
+
+void Track(GLTag<GLEntryPoint::UniformMatrix2fv>, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+	TINYNGINE_UNUSED(transpose);
+	SetUniform(location, value, size_t(count) * 4 * sizeof(GLfloat));
+}
+
+void Track(GLTag<GLEntryPoint::UniformMatrix3fv>, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+	TINYNGINE_UNUSED(transpose);
+	SetUniform(location, value, size_t(count) * 9 * sizeof(GLfloat));
+}
+
+void Track(GLTag<GLEntryPoint::UniformMatrix4fv>, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+	TINYNGINE_UNUSED(transpose);
+	SetUniform(location, value, size_t(count) * 16 * sizeof(GLfloat));
+}
+
+// Null GL: everything succeeds, names are never reused and queries return zeros unless a caller needs more.
+template<GLEntryPoint::Enum Entry, typename... Args>
+NullValue NullCall(GLTag<Entry>, Args...) {
+	return NullValue();
+}
+
+void GenerateNames(GLsizei n, GLuint* names) {
+	for (GLsizei i = 0; i < n; i++) {
+		names[i] = ++sRecorder.mNextName;
+	}
+}
+
+GLint GetLocation(GLuint program, const GLchar* name) {
+	std::map<std::string, GLint>& locations = sRecorder.mLocations[program];
+	auto found = locations.find(name);
+	if (found != locations.end()) {
+		return found->second;
+	}
+	const GLint location = GLint(locations.size());
+	locations[name] = location;
+	return location;
+}
+
+void NullCall(GLTag<GLEntryPoint::GenBuffers>, GLsizei n, GLuint* buffers) {
+	GenerateNames(n, buffers);
+}
+
+void NullCall(GLTag<GLEntryPoint::GenFramebuffers>, GLsizei n, GLuint* framebuffers) {
+	GenerateNames(n, framebuffers);
+}
+
+void NullCall(GLTag<GLEntryPoint::GenQueries>, GLsizei n, GLuint* ids) {
+	GenerateNames(n, ids);
+}
+
+void NullCall(GLTag<GLEntryPoint::GenTextures>, GLsizei n, GLuint* textures) {
+	GenerateNames(n, textures);
+}
+
+void NullCall(GLTag<GLEntryPoint::GenVertexArrays>, GLsizei n, GLuint* arrays) {
+	GenerateNames(n, arrays);
+}
+
+GLuint NullCall(GLTag<GLEntryPoint::CreateProgram>) {
+	return ++sRecorder.mNextName;
+}
+
+GLuint NullCall(GLTag<GLEntryPoint::CreateShader>, GLenum type) {
+	TINYNGINE_UNUSED(type);
+	return ++sRecorder.mNextName;
+}
+
+GLsync NullCall(GLTag<GLEntryPoint::FenceSync>, GLenum condition, GLbitfield flags) {
+	TINYNGINE_UNUSED(condition); TINYNGINE_UNUSED(flags);
+	return reinterpret_cast<GLsync>(uintptr_t(++sRecorder.mNextName));
+}
+
+GLenum NullCall(GLTag<GLEntryPoint::ClientWaitSync>, GLsync sync, GLbitfield flags, GLuint64 timeout) {
+	TINYNGINE_UNUSED(sync); TINYNGINE_UNUSED(flags); TINYNGINE_UNUSED(timeout);
+	return GL_ALREADY_SIGNALED;
+}
+
+GLenum NullCall(GLTag<GLEntryPoint::CheckFramebufferStatus>, GLenum target) {
+	TINYNGINE_UNUSED(target);
+	return GL_FRAMEBUFFER_COMPLETE;
+}
+
+GLint NullCall(GLTag<GLEntryPoint::GetUniformLocation>, GLuint program, const GLchar* name) {
+	return GetLocation(program, name);
+}
+
+GLuint NullCall(GLTag<GLEntryPoint::GetUniformBlockIndex>, GLuint program, const GLchar* uniformBlockName) {
+	return GLuint(GetLocation(program, uniformBlockName));
+}
+
+// glad parses the version and lists the extensions, it fails without any: a single made up one is reported.
+const GLubyte* NullCall(GLTag<GLEntryPoint::GetString>, GLenum name) {
+	switch (name) {
+	case GL_VENDOR: return reinterpret_cast<const GLubyte*>("tinyngine");
+	case GL_RENDERER: return reinterpret_cast<const GLubyte*>("GLRecorder null");
+	case GL_VERSION: return reinterpret_cast<const GLubyte*>("3.3.0 GLRecorder null");
+	case GL_SHADING_LANGUAGE_VERSION: return reinterpret_cast<const GLubyte*>("3.30");
+	default: return nullptr;
+	}
+}
+
+const GLubyte* NullCall(GLTag<GLEntryPoint::GetStringi>, GLenum name, GLuint index) {
+	TINYNGINE_UNUSED(name); TINYNGINE_UNUSED(index);
+	return reinterpret_cast<const GLubyte*>("GL_TINYNGINE_null");
+}
+
+void NullCall(GLTag<GLEntryPoint::GetIntegerv>, GLenum pname, GLint* data) {
+	switch (pname) {
+	case GL_MAJOR_VERSION:
+	case GL_MINOR_VERSION:
+		data[0] = 3;
+		break;
+	case GL_NUM_EXTENSIONS:
+		data[0] = 1;
+		break;
+	case GL_VIEWPORT:
+	case GL_SCISSOR_BOX:
+	case GL_COLOR_WRITEMASK:
+		data[0] = data[1] = data[2] = data[3] = 0;
+		break;
+	default:
+		data[0] = 0;
+		break;
+	}
+}
+
+void NullCall(GLTag<GLEntryPoint::GetShaderiv>, GLuint shader, GLenum pname, GLint* params) {
+	TINYNGINE_UNUSED(shader);
+	*params = (pname == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+}
+
+void NullCall(GLTag<GLEntryPoint::GetProgramiv>, GLuint program, GLenum pname, GLint* params) {
+	TINYNGINE_UNUSED(program);
+	*params = (pname == GL_LINK_STATUS || pname == GL_VALIDATE_STATUS) ? GL_TRUE : 0;
+}
+
+void NullCall(GLTag<GLEntryPoint::GetShaderInfoLog>, GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+	TINYNGINE_UNUSED(shader);
+	if (length != nullptr) {
+		*length = 0;
+	}
+	if (infoLog != nullptr && bufSize > 0) {
+		infoLog[0] = '\0';
+	}
+}
+
+void NullCall(GLTag<GLEntryPoint::GetProgramInfoLog>, GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog) {
+	NullCall(GLTag<GLEntryPoint::GetShaderInfoLog>(), program, bufSize, length, infoLog);
+}
+
+void NullCall(GLTag<GLEntryPoint::GetQueryObjectiv>, GLuint id, GLenum pname, GLint* params) {
+	TINYNGINE_UNUSED(id);
+	*params = (pname == GL_QUERY_RESULT_AVAILABLE) ? GL_TRUE : 0;
+}
+
+void NullCall(GLTag<GLEntryPoint::GetQueryObjectui64v>, GLuint id, GLenum pname, GLuint64* params) {
+	TINYNGINE_UNUSED(id); TINYNGINE_UNUSED(pname);
+	*params = 0;
+}
+
+template<GLEntryPoint::Enum Entry, typename Function>
+struct GLStub;
+
+// Has the exact signature of the glad function pointer it replaces.
+template<GLEntryPoint::Enum Entry, typename Result, typename... Args>
+struct GLStub<Entry, Result (APIENTRYP)(Args...)> {
+	static Result APIENTRY Call(Args... args) {
+		RecordCall(Entry, args...);
+		Track(GLTag<Entry>(), args...);
+		if (sRecorder.mParams.mMode == GLRecorderMode::Forward) {
+			return reinterpret_cast<Result (APIENTRYP)(Args...)>(sRecorder.mFunctions[Entry])(args...);
+		}
+		return Result(NullCall(GLTag<Entry>(), args...));
+	}
+};
+
+void* const cStubs[GLEntryPoint::Count] = {
+#define TINYNGINE_GL_RECORDER_STUB(name) reinterpret_cast<void*>(&GLStub<GLEntryPoint::name, decltype(glad_gl##name)>::Call),
+	TINYNGINE_GL_RECORDER_ENTRY_POINTS(TINYNGINE_GL_RECORDER_STUB)
+#undef TINYNGINE_GL_RECORDER_STUB
+};
+
+}
+
+bool GLRecorder_Initialize(const GLRecorderParams& params) {
+	GLRecorder_Shutdown();
+	if (params.mMode == GLRecorderMode::Forward && params.mLoader == nullptr) {
+		Log(tinyngine::Logger::Error, "GLRecorder: forwarding needs the loader of the context");
+		return false;
+	}
+
+	sRecorder = Recorder();
+	sRecorder.mParams = params;
+	if (params.mStreamFile != nullptr) {
+		sRecorder.mStream = fopen(params.mStreamFile, "w");
+		if (sRecorder.mStream == nullptr) {
+			Log(tinyngine::Logger::Error, "GLRecorder: failed to open %s", params.mStreamFile);
+			return false;
+		}
+		sRecorder.mStreamFile = params.mStreamFile;
+	}
+	sRecorder.mParams.mStreamFile = nullptr;
+	sRecorder.mActive = true;
+	return true;
+}
+
+void GLRecorder_Shutdown() {
+	if (sRecorder.mStream != nullptr) {
+		fclose(sRecorder.mStream);
+		sRecorder.mStream = nullptr;
+	}
+	sRecorder.mActive = false;
+}
+
+bool GLRecorder_IsActive() {
+	return sRecorder.mActive;
+}
+
+void* GLRecorder_GetProcAddress(const char* name) {
+	if (!sRecorder.mActive) {
+		return nullptr;
+	}
+	uint32_t entryPoint = 0;
+	while (entryPoint < GLEntryPoint::Count && std::strcmp(cEntryPointNames[entryPoint], name) != 0) {
+		entryPoint++;
+	}
+	if (sRecorder.mParams.mMode == GLRecorderMode::Forward) {
+		void* function = sRecorder.mParams.mLoader(name);
+		if (entryPoint == GLEntryPoint::Count || function == nullptr) {
+			return function;
+		}
+		sRecorder.mFunctions[entryPoint] = function;
+	} else if (entryPoint == GLEntryPoint::Count) {
+		return nullptr;
+	}
+	return cStubs[entryPoint];
+}
+
+const char* GLRecorder_GetEntryPointName(GLEntryPoint::Enum entryPoint) {
+	return (entryPoint < GLEntryPoint::Count) ? cEntryPointNames[entryPoint] : "<unknown>";
+}
+
+const GLRecorderStats& GLRecorder_GetStats() {
+	return sRecorder.mStats;
+}
+
+void GLRecorder_ResetStats() {
+	sRecorder.mStats = GLRecorderStats();
+	// the stream restarts with the counters, e.g. without the startup queries of glad nor the warm up frames
+	if (sRecorder.mStream != nullptr) {
+		sRecorder.mStream = freopen(sRecorder.mStreamFile.c_str(), "w", sRecorder.mStream);
+		if (sRecorder.mStream == nullptr) {
+			Log(tinyngine::Logger::Error, "GLRecorder: failed to reopen %s", sRecorder.mStreamFile.c_str());
+		}
+	}
+}
+
+#else
+
+bool GLRecorder_Initialize(const GLRecorderParams& params) {
+	TINYNGINE_UNUSED(params);
+	Log(tinyngine::Logger::Error, "GLRecorder: not built, configure with -DTINYNGINE_GL_RECORDER=ON");
+	return false;
+}
+
+void GLRecorder_Shutdown() {
+}
+
+bool GLRecorder_IsActive() {
+	return false;
+}
+
+void* GLRecorder_GetProcAddress(const char* name) {
+	TINYNGINE_UNUSED(name);
+	return nullptr;
+}
+
+const char* GLRecorder_GetEntryPointName(GLEntryPoint::Enum entryPoint) {
+	TINYNGINE_UNUSED(entryPoint);
+	return "<unknown>";
+}
+
+const GLRecorderStats& GLRecorder_GetStats() {
+	static const GLRecorderStats cStats;
+	return cStats;
+}
+
+void GLRecorder_ResetStats() {
+}
+
+#endif
+
+void GLRecorder_LogStats(uint32_t framesCount, uint32_t maxEntryPoints) {
+	const GLRecorderStats& stats = GLRecorder_GetStats();
+	const double frames = double(std::max(framesCount, 1u));
+	Log(tinyngine::Logger::Information, "gl calls per frame: %.1f calls, %.1f draws, %.0f bytes uploaded, %.1f redundant binds, %.1f redundant uniform sets",
+		double(stats.mCalls) / frames, double(stats.mDrawCalls) / frames, double(stats.mBytesUploaded) / frames,
+		double(stats.mRedundantBinds) / frames, double(stats.mRedundantUniforms) / frames);
+
+	uint32_t entryPoints[GLEntryPoint::Count];
+	for (uint32_t i = 0; i < GLEntryPoint::Count; i++) {
+		entryPoints[i] = i;
+	}
+	std::stable_sort(entryPoints, entryPoints + GLEntryPoint::Count, [&stats](uint32_t a, uint32_t b) {
+		return stats.mEntryPointCalls[a] > stats.mEntryPointCalls[b];
+	});
+	for (uint32_t i = 0; i < std::min(maxEntryPoints, uint32_t(GLEntryPoint::Count)) && stats.mEntryPointCalls[entryPoints[i]] > 0; i++) {
+		Log(tinyngine::Logger::Information, "  %-28s %10.1f", GLRecorder_GetEntryPointName(GLEntryPoint::Enum(entryPoints[i])),
+			double(stats.mEntryPointCalls[entryPoints[i]]) / frames);
+	}
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "CommonDefine.h"
+
+// Replaces the glad function pointers with stubs that count the calls of every entry point, the bytes uploaded and
+// the binds and uniform sets that do not change anything, and can write the call stream to a text file. The stubs
+// either forward to the driver or implement a null GL: queries return success, object names are counters and
+// nothing is drawn, so the CPU cost of the submission code is measured without any driver nor context.
+//
+// Only built with the TINYNGINE_GL_RECORDER CMake option, GLRecorder_Initialize fails otherwise. Entry points that
+// are not listed below are passed through when forwarding and left null by the null GL.
+#define TINYNGINE_GL_RECORDER_ENTRY_POINTS(X) \
+	X(ActiveTexture) \
+	X(AttachShader) \
+	X(BeginQuery) \
+	X(BindBuffer) \
+	X(BindBufferBase) \
+	X(BindBufferRange) \
+	X(BindFramebuffer) \
+	X(BindTexture) \
+	X(BindVertexArray) \
+	X(BlendEquationSeparate) \
+	X(BlendFuncSeparate) \
+	X(BlitFramebuffer) \
+	X(BufferData) \
+	X(BufferSubData) \
+	X(CheckFramebufferStatus) \
+	X(Clear) \
+	X(ClearColor) \
+	X(ClientWaitSync) \
+	X(ColorMask) \
+	X(CompileShader) \
+	X(CreateProgram) \
+	X(CreateShader) \
+	X(CullFace) \
+	X(DeleteBuffers) \
+	X(DeleteFramebuffers) \
+	X(DeleteProgram) \
+	X(DeleteQueries) \
+	X(DeleteShader) \
+	X(DeleteSync) \
+	X(DeleteTextures) \
+	X(DeleteVertexArrays) \
+	X(DepthFunc) \
+	X(DepthMask) \
+	X(Disable) \
+	X(DispatchCompute) \
+	X(DrawArrays) \
+	X(DrawArraysInstanced) \
+	X(DrawBuffer) \
+	X(DrawBuffers) \
+	X(DrawElements) \
+	X(DrawElementsInstanced) \
+	X(DrawElementsInstancedBaseVertex) \
+	X(DrawElementsInstancedBaseVertexBaseInstance) \
+	X(Enable) \
+	X(EnableVertexAttribArray) \
+	X(EndQuery) \
+	X(FenceSync) \
+	X(Finish) \
+	X(FramebufferTexture2D) \
+	X(FrontFace) \
+	X(GenBuffers) \
+	X(GenFramebuffers) \
+	X(GenQueries) \
+	X(GenTextures) \
+	X(GenVertexArrays) \
+	X(GenerateMipmap) \
+	X(GetError) \
+	X(GetIntegerv) \
+	X(GetProgramInfoLog) \
+	X(GetProgramiv) \
+	X(GetQueryObjectiv) \
+	X(GetQueryObjectui64v) \
+	X(GetShaderInfoLog) \
+	X(GetShaderiv) \
+	X(GetString) \
+	X(GetStringi) \
+	X(GetUniformBlockIndex) \
+	X(GetUniformLocation) \
+	X(InvalidateFramebuffer) \
+	X(LinkProgram) \
+	X(MemoryBarrier) \
+	X(MultiDrawElements) \
+	X(MultiDrawElementsIndirect) \
+	X(PixelStorei) \
+	X(PolygonMode) \
+	X(PolygonOffset) \
+	X(ReadBuffer) \
+	X(Scissor) \
+	X(ShaderSource) \
+	X(StencilFunc) \
+	X(StencilMask) \
+	X(StencilOp) \
+	X(TexBuffer) \
+	X(TexImage2D) \
+	X(TexParameteri) \
+	X(Uniform1f) \
+	X(Uniform1i) \
+	X(Uniform2f) \
+	X(Uniform2fv) \
+	X(Uniform3f) \
+	X(Uniform3fv) \
+	X(Uniform4f) \
+	X(Uniform4fv) \
+	X(UniformBlockBinding) \
+	X(UniformMatrix2fv) \
+	X(UniformMatrix3fv) \
+	X(UniformMatrix4fv) \
+	X(UseProgram) \
+	X(VertexAttribDivisor) \
+	X(VertexAttribIPointer) \
+	X(VertexAttribPointer) \
+	X(Viewport)
+
+struct GLEntryPoint {
+	enum Enum {
+#define TINYNGINE_GL_RECORDER_ENUM(name) name,
+		TINYNGINE_GL_RECORDER_ENTRY_POINTS(TINYNGINE_GL_RECORDER_ENUM)
+#undef TINYNGINE_GL_RECORDER_ENUM
+
+		Count
+	};
+};
+
+struct GLRecorderMode {
+	enum Enum {
+		Null,										// no context needed
+		Forward,									// records on top of the context loaded by mLoader
+
+		Count
+	};
+};
+
+// Same signature as GLADloadproc.
+using GLRecorderLoader = void* (*)(const char* name);
+
+struct GLRecorderParams {
+	GLRecorderMode::Enum mMode = GLRecorderMode::Null;
+	GLRecorderLoader mLoader = nullptr;			// forward only, e.g. glfwGetProcAddress
+	const char* mStreamFile = nullptr;			// optional, one line per call: the entry point and its scalar arguments,
+												// from the last GLRecorder_ResetStats
+};
+
+struct GLRecorderStats {
+	uint64_t mCalls = 0;
+	uint64_t mDrawCalls = 0;					// draws, multi draws and dispatches
+	uint64_t mBytesUploaded = 0;				// buffer and texture data passed by the application
+	uint64_t mRedundantBinds = 0;				// binding what is already bound, selecting the active texture unit again
+	uint64_t mRedundantUniforms = 0;			// setting a uniform of a program to the value it already has
+	uint64_t mEntryPointCalls[GLEntryPoint::Count] = {};
+};
+
+// Must be followed by gladLoadGLLoader(GLRecorder_GetProcAddress), the recorder then stays active until
+// GLRecorder_Shutdown. Returns false, after logging why, when the recorder is not built or the stream file cannot
+// be opened.
+bool GLRecorder_Initialize(const GLRecorderParams& params);
+
+// Closes the stream file. The glad function pointers are not restored, no GL call may follow without loading them
+// again.
+void GLRecorder_Shutdown();
+
+bool GLRecorder_IsActive();
+
+void* GLRecorder_GetProcAddress(const char* name);
+
+// "glBindTexture" for GLEntryPoint::BindTexture.
+const char* GLRecorder_GetEntryPointName(GLEntryPoint::Enum entryPoint);
+
+const GLRecorderStats& GLRecorder_GetStats();
+
+// Counters only, the tracked GL state used to find the redundant calls is kept. The stream file is truncated so that
+// it holds the same calls as the counters.
+void GLRecorder_ResetStats();
+
+// Totals and the maxEntryPoints most called entry points, averaged over framesCount frames.
+void GLRecorder_LogStats(uint32_t framesCount, uint32_t maxEntryPoints);
@@ -0,0 +1,530 @@
+#include "GltfLoader.h"
+
+#include "JsonParser.h"
+#include "MappedFile.h"
+#include "Log.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+constexpr uint32_t cGlbMagic = 0x46546C67;		// "glTF"
+constexpr uint32_t cGlbChunkJson = 0x4E4F534A;	// "JSON"
+constexpr uint32_t cGlbChunkBin = 0x004E4942;	// "BIN\0"
+constexpr uint32_t cGlbHeaderSize = 12;
+constexpr uint32_t cGlbChunkHeaderSize = 8;
+
+constexpr uint32_t cComponentByte = 5120;
+constexpr uint32_t cComponentUnsignedByte = 5121;
+constexpr uint32_t cComponentShort = 5122;
+constexpr uint32_t cComponentUnsignedShort = 5123;
+constexpr uint32_t cComponentUnsignedInt = 5125;
+constexpr uint32_t cComponentFloat = 5126;
+
+struct MeshRange {
+	uint32_t mFirst = cInvalidHandle;
+	uint32_t mCount = 0;
+};
+
+struct LoaderContext {
+	LoaderContext(const JsonDocument& doc, GltfModel& model) : mDoc(doc), mModel(model) {}
+
+	const JsonDocument& mDoc;
+	GltfModel& mModel;
+
+	const uint8_t* mBin = nullptr;
+	uint32_t mBinSize = 0;
+
+	std::vector<uint32_t> mAccessors;
+	std::vector<uint32_t> mBufferViews;
+	std::vector<uint32_t> mMaterials;
+	std::vector<uint32_t> mTextures;
+	std::vector<uint32_t> mImages;
+	std::vector<uint32_t> mMeshes;
+	std::vector<uint32_t> mNodes;
+
+	std::vector<BufferHandle> mBufferViewHandles;
+	std::vector<TextureHandle> mTextureHandles;
+	std::vector<uint32_t> mMaterialIndices;
+	std::vector<MeshRange> mMeshRanges;
+};
+
+uint32_t Read32(const uint8_t* data) {
+	uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+void BuildElementTable(const JsonDocument& doc, const char* name, std::vector<uint32_t>& table) {
+	uint32_t array = doc.FindMember(0, name);
+	uint32_t count = doc.GetSize(array);
+	if (array == cJsonInvalidToken || doc.GetToken(array).mType != JsonTokenType::Array) {
+		return;
+	}
+	table.reserve(count);
+	uint32_t element = array + 1;
+	for (uint32_t i = 0; i < count; i++) {
+		table.push_back(element);
+		element = doc.GetToken(element).mNext;
+	}
+}
+
+uint32_t GetTableEntry(const std::vector<uint32_t>& table, uint32_t index) {
+	return (index < table.size()) ? table[index] : cJsonInvalidToken;
+}
+
+uint32_t GetComponentsCount(const JsonDocument& doc, uint32_t type) {
+	const char* cTypes[] = { "SCALAR", "VEC2", "VEC3", "VEC4" };
+	for (uint32_t i = 0; i < TINYNGINE_COUNTOF(cTypes); i++) {
+		if (doc.Equals(type, cTypes[i])) {
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+bool GetComponentType(uint32_t componentType, VertexComponentType::Enum& type) {
+	switch (componentType) {
+	case cComponentByte: type = VertexComponentType::Byte; return true;
+	case cComponentUnsignedByte: type = VertexComponentType::UnsignedByte; return true;
+	case cComponentShort: type = VertexComponentType::Short; return true;
+	case cComponentUnsignedShort: type = VertexComponentType::UnsignedShort; return true;
+	case cComponentUnsignedInt: type = VertexComponentType::UnsignedInt; return true;
+	case cComponentFloat: type = VertexComponentType::Float; return true;
+	default: return false;
+	}
+}
+
+uint32_t GetComponentSize(uint32_t componentType) {
+	switch (componentType) {
+	case cComponentByte: case cComponentUnsignedByte: return 1;
+	case cComponentShort: case cComponentUnsignedShort: return 2;
+	case cComponentUnsignedInt: case cComponentFloat: return 4;
+	default: return 0;
+	}
+}
+
+bool GetPrimitiveType(uint32_t mode, PrimitiveType::Enum& type) {
+	switch (mode) {
+	case 0: type = PrimitiveType::Points; return true;
+	case 1: type = PrimitiveType::Lines; return true;
+	case 3: type = PrimitiveType::LineStrip; return true;
+	case 4: type = PrimitiveType::Triangles; return true;
+	case 5: type = PrimitiveType::TriangleStrip; return true;
+	case 6: type = PrimitiveType::TriangleFan; return true;
+	default: return false;
+	}
+}
+
+// Returns the byte range of a buffer view inside the BIN chunk, nullptr if it is not backed by it.
+const uint8_t* GetBufferViewData(LoaderContext& context, uint32_t bufferView, uint32_t& length) {
+	const JsonDocument& doc = context.mDoc;
+	uint32_t view = GetTableEntry(context.mBufferViews, bufferView);
+	if (view == cJsonInvalidToken) {
+		return nullptr;
+	}
+	uint32_t buffer = doc.GetMemberUInt(view, "buffer");
+	uint32_t offset = doc.GetMemberUInt(view, "byteOffset");
+	length = doc.GetMemberUInt(view, "byteLength");
+	if (buffer != 0 || context.mBin == nullptr || uint64_t(offset) + length > context.mBinSize) {
+		Log(tinyngine::Logger::Error, "glTF buffer view %u is not stored in the GLB binary chunk", bufferView);
+		return nullptr;
+	}
+	return context.mBin + offset;
+}
+
+// Returns the data of an accessor of count elements, elementSize bytes each and stride bytes apart, nullptr if they do
+// not all fit in its buffer view: drawing it would read past the uploaded buffer.
+const uint8_t* GetAccessorData(LoaderContext& context, uint32_t accessor, uint32_t bufferView, uint32_t count, uint32_t elementSize, uint32_t stride) {
+	uint32_t length = 0;
+	const uint8_t* data = GetBufferViewData(context, bufferView, length);
+	if (data == nullptr) {
+		return nullptr;
+	}
+	uint32_t offset = context.mDoc.GetMemberUInt(accessor, "byteOffset");
+	uint64_t end = uint64_t(offset) + ((count > 0) ? uint64_t(count - 1) * stride + elementSize : 0);
+	if (end > length) {
+		Log(tinyngine::Logger::Error, "glTF accessor of %u elements at offset %u does not fit in the %u bytes of buffer view %u", count,
+			offset, length, bufferView);
+		return nullptr;
+	}
+	return data + offset;
+}
+
+uint32_t GetMaxIndex(const uint8_t* indices, uint32_t count, uint32_t indexSize) {
+	uint32_t maxIndex = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t index = 0;
+		if (indexSize == 1) {
+			index = indices[i];
+		} else if (indexSize == 2) {
+			uint16_t value;
+			std::memcpy(&value, indices + i * 2, sizeof(value));
+			index = value;
+		} else {
+			index = Read32(indices + i * 4);
+		}
+		maxIndex = std::max(maxIndex, index);
+	}
+	return maxIndex;
+}
+
+BufferHandle GetBufferViewHandle(LoaderContext& context, uint32_t bufferView, BufferType::Enum type) {
+	if (bufferView >= context.mBufferViewHandles.size()) {
+		return BufferHandle(cInvalidHandle);
+	}
+	BufferHandle& handle = context.mBufferViewHandles[bufferView];
+	if (!handle.IsValid()) {
+		uint32_t length = 0;
+		const uint8_t* data = GetBufferViewData(context, bufferView, length);
+		if (data != nullptr) {
+			handle = Buffer_Create(type, data, length);
+			if (handle.IsValid()) {
+				context.mModel.mBuffers.push_back(handle);
+				context.mModel.mUploadedBytes += length;
+			}
+		}
+	}
+	return handle;
+}
+
+TextureHandle GetTextureHandle(LoaderContext& context, uint32_t textureInfo, TextureFormats::Enum format) {
+	const JsonDocument& doc = context.mDoc;
+	uint32_t textureIndex = doc.GetMemberUInt(textureInfo, "index", cInvalidHandle);
+	if (textureIndex >= context.mTextureHandles.size()) {
+		return TextureHandle(cInvalidHandle);
+	}
+	TextureHandle& handle = context.mTextureHandles[textureIndex];
+	if (!handle.IsValid()) {
+		uint32_t texture = GetTableEntry(context.mTextures, textureIndex);
+		uint32_t image = GetTableEntry(context.mImages, doc.GetMemberUInt(texture, "source", cInvalidHandle));
+		uint32_t bufferView = doc.GetMemberUInt(image, "bufferView", cInvalidHandle);
+		uint32_t length = 0;
+		const uint8_t* data = GetBufferViewData(context, bufferView, length);
+		if (data != nullptr) {
+			handle = Texture_CreateFromMemory(data, length, format);
+			if (handle.IsValid()) {
+				context.mModel.mTextures.push_back(handle);
+				context.mModel.mUploadedBytes += length;
+			}
+		}
+	}
+	return handle;
+}
+
+float ShininessFromRoughness(float roughness) {
+	// Blinn-Phong exponent matching a GGX distribution of the same width
+	float alpha = std::max(roughness * roughness, 1e-3f);
+	return glm::clamp(2.0f / (alpha * alpha) - 2.0f, 1.0f, 256.0f);
+}
+
+uint32_t GetMaterialIndex(LoaderContext& context, uint32_t materialIndex) {
+	if (materialIndex >= context.mMaterialIndices.size()) {
+		return cInvalidHandle;
+	}
+	uint32_t& index = context.mMaterialIndices[materialIndex];
+	if (index != cInvalidHandle) {
+		return index;
+	}
+
+	const JsonDocument& doc = context.mDoc;
+	uint32_t material = GetTableEntry(context.mMaterials, materialIndex);
+	uint32_t pbr = doc.FindMember(material, "pbrMetallicRoughness");
+	uint32_t extensions = doc.FindMember(material, "extensions");
+	uint32_t specularGlossiness = doc.FindMember(extensions, "KHR_materials_pbrSpecularGlossiness");
+
+	Material result;
+	if (specularGlossiness != cJsonInvalidToken) {
+		result.mDiffuse = GetTextureHandle(context, doc.FindMember(specularGlossiness, "diffuseTexture"), TextureFormats::RGBA8);
+		result.mSpecular = GetTextureHandle(context, doc.FindMember(specularGlossiness, "specularGlossinessTexture"), TextureFormats::RGB8);
+		result.mShininess = ShininessFromRoughness(1.0f - doc.GetMemberFloat(specularGlossiness, "glossinessFactor", 1.0f));
+	} else {
+		result.mDiffuse = GetTextureHandle(context, doc.FindMember(pbr, "baseColorTexture"), TextureFormats::RGBA8);
+		uint32_t specular = doc.FindMember(extensions, "KHR_materials_specular");
+		result.mSpecular = GetTextureHandle(context, doc.FindMember(specular, "specularColorTexture"), TextureFormats::RGB8);
+		result.mShininess = ShininessFromRoughness(doc.GetMemberFloat(pbr, "roughnessFactor", 1.0f));
+	}
+	result.mEmissive = GetTextureHandle(context, doc.FindMember(material, "emissiveTexture"), TextureFormats::RGB8);
+
+	index = static_cast<uint32_t>(context.mModel.mMaterials.size());
+	context.mModel.mMaterials.push_back(result);
+	return index;
+}
+
+// The accessor must hold params.mVertexCount vertices, the draws read that many whatever its own count.
+bool AddVertexAttribute(LoaderContext& context, MeshParams& params, uint32_t accessorIndex, uint8_t location) {
+	const JsonDocument& doc = context.mDoc;
+	uint32_t accessor = GetTableEntry(context.mAccessors, accessorIndex);
+	uint32_t bufferView = doc.GetMemberUInt(accessor, "bufferView", cInvalidHandle);
+	if (accessor == cJsonInvalidToken || bufferView == cInvalidHandle || params.mAttributesCount >= cMaxMeshVertexAttributes) {
+		return false;
+	}
+
+	VertexAttribute& attribute = params.mAttributes[params.mAttributesCount];
+	uint32_t componentType = doc.GetMemberUInt(accessor, "componentType");
+	if (!GetComponentType(componentType, attribute.mType)) {
+		return false;
+	}
+	attribute.mComponents = static_cast<uint8_t>(GetComponentsCount(doc, doc.FindMember(accessor, "type")));
+	if (attribute.mComponents == 0) {
+		return false;
+	}
+	uint32_t elementSize = attribute.mComponents * GetComponentSize(componentType);
+	uint32_t stride = doc.GetMemberUInt(GetTableEntry(context.mBufferViews, bufferView), "byteStride");
+	if (GetAccessorData(context, accessor, bufferView, params.mVertexCount, elementSize, (stride != 0) ? stride : elementSize) == nullptr) {
+		return false;
+	}
+
+	BufferHandle buffer = GetBufferViewHandle(context, bufferView, BufferType::Vertex);
+	if (!buffer.IsValid()) {
+		return false;
+	}
+	uint32_t bufferIndex = 0;
+	while (bufferIndex < params.mVertexBuffersCount && params.mVertexBuffers[bufferIndex].mHandle != buffer.mHandle) {
+		bufferIndex++;
+	}
+	if (bufferIndex == params.mVertexBuffersCount) {
+		if (bufferIndex >= cMaxMeshVertexBuffers) {
+			return false;
+		}
+		params.mVertexBuffers[params.mVertexBuffersCount++] = buffer;
+	}
+
+	attribute.mLocation = location;
+	attribute.mBufferIndex = static_cast<uint8_t>(bufferIndex);
+	attribute.mNormalized = doc.GetBool(doc.FindMember(accessor, "normalized"));
+	attribute.mOffset = doc.GetMemberUInt(accessor, "byteOffset");
+	attribute.mStride = stride;
+	params.mAttributesCount++;
+	return true;
+}
+
+bool LoadPrimitive(LoaderContext& context, uint32_t primitive, GltfPrimitive& result) {
+	const JsonDocument& doc = context.mDoc;
+	uint32_t attributes = doc.FindMember(primitive, "attributes");
+	uint32_t positionIndex = doc.GetMemberUInt(attributes, "POSITION", cInvalidHandle);
+	uint32_t position = GetTableEntry(context.mAccessors, positionIndex);
+	if (position == cJsonInvalidToken) {
+		return false;
+	}
+
+	MeshParams params;
+	if (!GetPrimitiveType(doc.GetMemberUInt(primitive, "mode", 4), params.mPrimitiveType)) {
+		Log(tinyngine::Logger::Warning, "glTF primitive mode not supported");
+		return false;
+	}
+	params.mVertexCount = doc.GetMemberUInt(position, "count");
+	if (!AddVertexAttribute(context, params, positionIndex, GltfAttributeLocation::Position)) {
+		return false;
+	}
+	uint32_t normal = doc.GetMemberUInt(attributes, "NORMAL", cInvalidHandle);
+	if (normal != cInvalidHandle) {
+		AddVertexAttribute(context, params, normal, GltfAttributeLocation::Normal);
+	}
+	uint32_t texcoord = doc.GetMemberUInt(attributes, "TEXCOORD_0", cInvalidHandle);
+	if (texcoord != cInvalidHandle) {
+		AddVertexAttribute(context, params, texcoord, GltfAttributeLocation::TexCoord0);
+	}
+
+	uint32_t indices = GetTableEntry(context.mAccessors, doc.GetMemberUInt(primitive, "indices", cInvalidHandle));
+	if (indices != cJsonInvalidToken) {
+		switch (doc.GetMemberUInt(indices, "componentType")) {
+		case cComponentUnsignedByte: params.mIndexFormat = IndexFormat::UInt8; break;
+		case cComponentUnsignedShort: params.mIndexFormat = IndexFormat::UInt16; break;
+		case cComponentUnsignedInt: params.mIndexFormat = IndexFormat::UInt32; break;
+		default: return false;
+		}
+		uint32_t bufferView = doc.GetMemberUInt(indices, "bufferView", cInvalidHandle);
+		uint32_t indexSize = GetComponentSize(doc.GetMemberUInt(indices, "componentType"));
+		params.mIndexCount = doc.GetMemberUInt(indices, "count");
+		const uint8_t* data = GetAccessorData(context, indices, bufferView, params.mIndexCount, indexSize, indexSize);
+		if (data == nullptr) {
+			return false;
+		}
+		// the indices may reach past the vertex accessors as well
+		if (params.mIndexCount > 0 && GetMaxIndex(data, params.mIndexCount, indexSize) >= params.mVertexCount) {
+			Log(tinyngine::Logger::Error, "glTF indices reference vertices past the %u of the primitive", params.mVertexCount);
+			return false;
+		}
+		params.mIndexBuffer = GetBufferViewHandle(context, bufferView, BufferType::Index);
+		if (!params.mIndexBuffer.IsValid()) {
+			return false;
+		}
+		params.mIndexOffset = doc.GetMemberUInt(indices, "byteOffset");
+	}
+
+	result.mMesh = Mesh_Create(params);
+	if (!result.mMesh.IsValid()) {
+		return false;
+	}
+	result.mMaterial = GetMaterialIndex(context, doc.GetMemberUInt(primitive, "material", cInvalidHandle));
+	doc.GetFloatArray(doc.FindMember(position, "min"), &result.mBoundsMin[0], 3);
+	doc.GetFloatArray(doc.FindMember(position, "max"), &result.mBoundsMax[0], 3);
+	return true;
+}
+
+MeshRange LoadMesh(LoaderContext& context, uint32_t meshIndex) {
+	if (meshIndex >= context.mMeshRanges.size()) {
+		return MeshRange();
+	}
+	MeshRange& range = context.mMeshRanges[meshIndex];
+	if (range.mFirst != cInvalidHandle) {
+		return range;
+	}
+
+	const JsonDocument& doc = context.mDoc;
+	uint32_t primitives = doc.FindMember(GetTableEntry(context.mMeshes, meshIndex), "primitives");
+	range.mFirst = static_cast<uint32_t>(context.mModel.mPrimitives.size());
+	for (uint32_t i = 0; i < doc.GetSize(primitives); i++) {
+		GltfPrimitive primitive;
+		if (LoadPrimitive(context, doc.GetElement(primitives, i), primitive)) {
+			context.mModel.mPrimitives.push_back(primitive);
+		} else {
+			Log(tinyngine::Logger::Warning, "glTF mesh %u primitive %u skipped", meshIndex, i);
+		}
+	}
+	range.mCount = static_cast<uint32_t>(context.mModel.mPrimitives.size()) - range.mFirst;
+	return range;
+}
+
+glm::mat4 GetNodeTransform(const JsonDocument& doc, uint32_t node) {
+	uint32_t matrix = doc.FindMember(node, "matrix");
+	if (matrix != cJsonInvalidToken) {
+		glm::mat4 result(1.0f);
+		doc.GetFloatArray(matrix, glm::value_ptr(result), 16);
+		return result;
+	}
+	float t[3] = { 0.0f, 0.0f, 0.0f };
+	float r[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	float s[3] = { 1.0f, 1.0f, 1.0f };
+	doc.GetFloatArray(doc.FindMember(node, "translation"), t, 3);
+	doc.GetFloatArray(doc.FindMember(node, "rotation"), r, 4);
+	doc.GetFloatArray(doc.FindMember(node, "scale"), s, 3);
+
+	glm::mat4 result = glm::translate(glm::mat4(1.0f), glm::vec3(t[0], t[1], t[2]));
+	result *= glm::mat4_cast(glm::quat(r[3], r[0], r[1], r[2]));
+	return glm::scale(result, glm::vec3(s[0], s[1], s[2]));
+}
+
+void LoadNode(LoaderContext& context, uint32_t nodeIndex, const glm::mat4& parent, uint32_t depth) {
+	uint32_t node = GetTableEntry(context.mNodes, nodeIndex);
+	if (node == cJsonInvalidToken || depth > 64) {
+		return;
+	}
+	const JsonDocument& doc = context.mDoc;
+	glm::mat4 transform = parent * GetNodeTransform(doc, node);
+
+	uint32_t mesh = doc.GetMemberUInt(node, "mesh", cInvalidHandle);
+	if (mesh != cInvalidHandle) {
+		MeshRange range = LoadMesh(context, mesh);
+		for (uint32_t i = 0; i < range.mCount; i++) {
+			context.mModel.mDrawables.push_back(GltfDrawable{ range.mFirst + i, transform });
+		}
+	}
+
+	uint32_t children = doc.FindMember(node, "children");
+	uint32_t child = children + 1;
+	for (uint32_t i = 0; i < doc.GetSize(children); i++) {
+		LoadNode(context, doc.GetUInt(child, cInvalidHandle), transform, depth + 1);
+		child = doc.GetToken(child).mNext;
+	}
+}
+
+}
+
+bool Gltf_LoadBinary(const char* filename, GltfModel& model) {
+	MappedFile file;
+	if (!file.Open(filename)) {
+		Log(tinyngine::Logger::Error, "Failed to open %s", filename);
+		return false;
+	}
+
+	const uint8_t* data = file.GetData();
+	size_t size = file.GetSize();
+	if (size < cGlbHeaderSize + cGlbChunkHeaderSize || Read32(data) != cGlbMagic || Read32(data + 4) != 2) {
+		Log(tinyngine::Logger::Error, "%s is not a glTF 2.0 binary file", filename);
+		return false;
+	}
+	size = std::min<size_t>(size, Read32(data + 8));
+
+	uint32_t jsonLength = Read32(data + cGlbHeaderSize);
+	if (Read32(data + cGlbHeaderSize + 4) != cGlbChunkJson || cGlbHeaderSize + cGlbChunkHeaderSize + uint64_t(jsonLength) > size) {
+		Log(tinyngine::Logger::Error, "%s has an invalid JSON chunk", filename);
+		return false;
+	}
+	const char* json = reinterpret_cast<const char*>(data + cGlbHeaderSize + cGlbChunkHeaderSize);
+
+	int32_t tokensCount = Json_Parse(json, jsonLength, nullptr, 0);
+	if (tokensCount <= 0) {
+		Log(tinyngine::Logger::Error, "%s has a malformed JSON chunk", filename);
+		return false;
+	}
+	std::vector<JsonToken> tokens(static_cast<size_t>(tokensCount));
+	Json_Parse(json, jsonLength, tokens.data(), static_cast<uint32_t>(tokens.size()));
+	JsonDocument doc(json, tokens.data(), static_cast<uint32_t>(tokens.size()));
+
+	LoaderContext context(doc, model);
+	size_t binChunk = cGlbHeaderSize + cGlbChunkHeaderSize + jsonLength;
+	if (binChunk + cGlbChunkHeaderSize <= size && Read32(data + binChunk + 4) == cGlbChunkBin) {
+		context.mBin = data + binChunk + cGlbChunkHeaderSize;
+		context.mBinSize = static_cast<uint32_t>(std::min<size_t>(Read32(data + binChunk), size - binChunk - cGlbChunkHeaderSize));
+	}
+
+	BuildElementTable(doc, "accessors", context.mAccessors);
+	BuildElementTable(doc, "bufferViews", context.mBufferViews);
+	BuildElementTable(doc, "materials", context.mMaterials);
+	BuildElementTable(doc, "textures", context.mTextures);
+	BuildElementTable(doc, "images", context.mImages);
+	BuildElementTable(doc, "meshes", context.mMeshes);
+	BuildElementTable(doc, "nodes", context.mNodes);
+	context.mBufferViewHandles.assign(context.mBufferViews.size(), BufferHandle(cInvalidHandle));
+	context.mTextureHandles.assign(context.mTextures.size(), TextureHandle(cInvalidHandle));
+	context.mMaterialIndices.assign(context.mMaterials.size(), cInvalidHandle);
+	context.mMeshRanges.resize(context.mMeshes.size());
+
+	uint32_t scenes = doc.FindMember(0, "scenes");
+	uint32_t scene = doc.GetElement(scenes, doc.GetMemberUInt(0, "scene", 0));
+	if (scene != cJsonInvalidToken) {
+		uint32_t nodes = doc.FindMember(scene, "nodes");
+		uint32_t node = nodes + 1;
+		for (uint32_t i = 0; i < doc.GetSize(nodes); i++) {
+			LoadNode(context, doc.GetUInt(node, cInvalidHandle), glm::mat4(1.0f), 0);
+			node = doc.GetToken(node).mNext;
+		}
+	} else {
+		// no scene description, every mesh is placed at the origin
+		for (uint32_t i = 0; i < context.mMeshes.size(); i++) {
+			MeshRange range = LoadMesh(context, i);
+			for (uint32_t p = 0; p < range.mCount; p++) {
+				model.mDrawables.push_back(GltfDrawable{ range.mFirst + p, glm::mat4(1.0f) });
+			}
+		}
+	}
+
+	Log(tinyngine::Logger::Information, "Loaded %s: %u primitives, %u materials, %u of %u bytes uploaded", filename,
+		uint32_t(model.mPrimitives.size()), uint32_t(model.mMaterials.size()), model.mUploadedBytes, uint32_t(size));
+	return !model.mPrimitives.empty();
+}
+
+void Gltf_Destroy(GltfModel& model) {
+	for (auto& primitive : model.mPrimitives) {
+		Mesh_Destroy(primitive.mMesh);
+	}
+	for (auto& buffer : model.mBuffers) {
+		Buffer_Destroy(buffer);
+	}
+	for (auto& texture : model.mTextures) {
+		Texture_Destroy(texture);
+	}
+	model.mPrimitives.clear();
+	model.mDrawables.clear();
+	model.mMaterials.clear();
+	model.mBuffers.clear();
+	model.mTextures.clear();
+	model.mUploadedBytes = 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Buffer.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <vector>
+
+// Vertex attributes are bound to the locations used by the sample shaders.
+struct GltfAttributeLocation {
+	enum Enum {
+		Position = 0,
+		Normal = 1,
+		TexCoord0 = 2,
+	};
+};
+
+struct GltfPrimitive {
+	MeshHandle mMesh = MeshHandle(cInvalidHandle);
+	uint32_t mMaterial = cInvalidHandle;
+	glm::vec3 mBoundsMin = glm::vec3(0.0f);
+	glm::vec3 mBoundsMax = glm::vec3(0.0f);
+};
+
+struct GltfDrawable {
+	uint32_t mPrimitive;
+	glm::mat4 mTransform;
+};
+
+struct GltfModel {
+	std::vector<GltfPrimitive> mPrimitives;
+	std::vector<GltfDrawable> mDrawables;
+	std::vector<Material> mMaterials;
+	std::vector<BufferHandle> mBuffers;
+	std::vector<TextureHandle> mTextures;
+	uint32_t mUploadedBytes = 0;
+};
+
+// Loads a binary glTF 2.0 (.glb) file. The file is memory mapped and buffer views are uploaded
+// straight from the mapping, only the ones referenced by the default scene are touched.
+bool Gltf_LoadBinary(const char* filename, GltfModel& model);
+
+void Gltf_Destroy(GltfModel& model);
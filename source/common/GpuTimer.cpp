@@ -0,0 +1,66 @@
+#include "GpuTimer.h"
+
+#include "GLApi.h"
+
+namespace
+{
+
+static const GLenum sQueryTargets[]{
+	GL_TIME_ELAPSED,					// TimeElapsed
+	GL_SAMPLES_PASSED,					// SamplesPassed
+};
+
+}
+
+void GpuTimer_Create(GpuTimer& timer, GpuQueryTarget::Enum target) {
+	GL_CHECK(glGenQueries(GLsizei(cGpuTimerQueries), timer.mQueries));
+	for (uint32_t i = 0; i < cGpuTimerQueries; i++) {
+		timer.mIssued[i] = false;
+	}
+	timer.mNext = 0;
+	timer.mTarget = target;
+	timer.mResult = 0;
+	timer.mMilliseconds = 0.0;
+}
+
+void GpuTimer_Destroy(GpuTimer& timer) {
+	if (timer.mQueries[0] != 0) {
+		GL_CHECK(glDeleteQueries(GLsizei(cGpuTimerQueries), timer.mQueries));
+		for (uint32_t i = 0; i < cGpuTimerQueries; i++) {
+			timer.mQueries[i] = 0;
+		}
+	}
+}
+
+void GpuTimer_Begin(GpuTimer& timer) {
+	const uint32_t index = timer.mNext;
+	const GLuint query = timer.mQueries[index];
+	if (timer.mIssued[index]) {
+		// the oldest query is normally done by now, if not its result is dropped rather than waited for
+		GLint available = 0;
+		GL_CHECK(glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available));
+		if (available) {
+			GLuint64 result = 0;
+			GL_CHECK(glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result));
+			timer.mResult = result;
+			if (timer.mTarget == GpuQueryTarget::TimeElapsed) {
+				timer.mMilliseconds = double(result) * 1e-6;
+			}
+		}
+	}
+	GL_CHECK(glBeginQuery(sQueryTargets[timer.mTarget], query));
+	timer.mIssued[index] = true;
+}
+
+void GpuTimer_End(GpuTimer& timer) {
+	GL_CHECK(glEndQuery(sQueryTargets[timer.mTarget]));
+	timer.mNext = (timer.mNext + 1) % cGpuTimerQueries;
+}
+
+double GpuTimer_GetMilliseconds(const GpuTimer& timer) {
+	return timer.mMilliseconds;
+}
+
+uint64_t GpuTimer_GetResult(const GpuTimer& timer) {
+	return timer.mResult;
+}
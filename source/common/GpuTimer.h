@@ -0,0 +1,41 @@
+#pragma once
+
+#include "CommonDefine.h"
+
+// Queries in flight per timer, results are read this many Begin calls later so the CPU never waits for them.
+static constexpr uint32_t cGpuTimerQueries = 4;
+
+struct GpuQueryTarget {
+	enum Enum {
+		TimeElapsed,							// nanoseconds
+		SamplesPassed,							// samples passing the depth and stencil tests
+
+		Count
+	};
+};
+
+// Measures the GPU time spent between GpuTimer_Begin and GpuTimer_End with GL_TIME_ELAPSED queries, or counts the
+// samples drawn in between with a SamplesPassed target. Queries of the same target cannot nest, timers of the same
+// frame and target must be used one after the other.
+struct GpuTimer {
+	uint32_t mQueries[cGpuTimerQueries] = {};
+	bool mIssued[cGpuTimerQueries] = {};
+	uint32_t mNext = 0;
+	GpuQueryTarget::Enum mTarget = GpuQueryTarget::TimeElapsed;
+	uint64_t mResult = 0;						// last result read back
+	double mMilliseconds = 0.0;					// of the last result, time elapsed only
+};
+
+void GpuTimer_Create(GpuTimer& timer, GpuQueryTarget::Enum target = GpuQueryTarget::TimeElapsed);
+
+void GpuTimer_Destroy(GpuTimer& timer);
+
+void GpuTimer_Begin(GpuTimer& timer);
+
+void GpuTimer_End(GpuTimer& timer);
+
+// Latest available measure, a few frames old.
+double GpuTimer_GetMilliseconds(const GpuTimer& timer);
+
+// Latest available result in the unit of the target, a few frames old.
+uint64_t GpuTimer_GetResult(const GpuTimer& timer);
@@ -2,6 +2,7 @@
 #include "Log.h"
 
 #include <unordered_map>
+#include <vector>
 
 namespace {
 
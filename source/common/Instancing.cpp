@@ -0,0 +1,210 @@
+#include "Instancing.h"
+
+#include "Buffer.h"
+#include <array>
+#include <vector>
+
+namespace
+{
+
+static const uint32_t sInstanceStrides[]{
+	sizeof(glm::mat4),				// Matrix
+	sizeof(InstanceTRS),			// TRS
+};
+
+static const uint32_t sInstanceLocations[]{
+	4,								// Matrix
+	2,								// TRS
+};
+
+class InstanceBatch {
+public:
+	InstanceBatch() = default;
+	~InstanceBatch() {
+		Destroy();
+	}
+
+	void Create(const InstanceBatchParams& params) {
+		mFormat = params.mFormat;
+		mStride = sInstanceStrides[mFormat];
+		mRepeat = params.mRepeat > 0 ? params.mRepeat : 1;
+		mProgram = params.mProgram;
+		mTexturesCount = params.mTexturesCount < cMaxInstanceBatchTextures ? params.mTexturesCount : cMaxInstanceBatchTextures;
+		for (uint32_t i = 0; i < mTexturesCount; i++) {
+			mTextures[i] = params.mTextures[i];
+		}
+
+		uint32_t capacity = params.mMaxInstances > 0 ? params.mMaxInstances : 1;
+		mData.reserve(size_t(capacity) * mStride);
+		mBuffer = Buffer_Create(BufferType::Vertex, nullptr, capacity * mStride, BufferUsage::Stream);
+
+		MeshParams meshParams = params.mMesh;
+		if (!mBuffer.IsValid() || meshParams.mVertexBuffersCount >= cMaxMeshVertexBuffers ||
+				meshParams.mAttributesCount + sInstanceLocations[mFormat] > cMaxMeshVertexAttributes) {
+			Destroy();
+			return;
+		}
+		uint8_t bufferIndex = static_cast<uint8_t>(meshParams.mVertexBuffersCount++);
+		meshParams.mVertexBuffers[bufferIndex] = mBuffer;
+		for (uint32_t i = 0; i < sInstanceLocations[mFormat]; i++) {
+			VertexAttribute& attribute = meshParams.mAttributes[meshParams.mAttributesCount++];
+			attribute.mLocation = static_cast<uint8_t>(params.mFirstLocation + i);
+			attribute.mBufferIndex = bufferIndex;
+			attribute.mComponents = 4;
+			attribute.mType = VertexComponentType::Float;
+			attribute.mOffset = i * uint32_t(sizeof(glm::vec4));
+			attribute.mStride = mStride;
+			attribute.mDivisor = mRepeat;
+		}
+		mMesh = Mesh_Create(meshParams);
+		if (!mMesh.IsValid()) {
+			Destroy();
+		}
+	}
+
+	void Destroy() {
+		Mesh_Destroy(mMesh);
+		Buffer_Destroy(mBuffer);
+		mMesh = MeshHandle(cInvalidHandle);
+		mBuffer = BufferHandle(cInvalidHandle);
+		mData.clear();
+		mCount = 0;
+	}
+
+	void Clear() {
+		mData.clear();
+		mCount = 0;
+	}
+
+	bool Add(const void* instance, uint32_t size) {
+		if (!IsValid() || size != mStride) {
+			return false;
+		}
+		const uint8_t* bytes = static_cast<const uint8_t*>(instance);
+		mData.insert(mData.end(), bytes, bytes + size);
+		mCount++;
+		return true;
+	}
+
+	void Submit() {
+		if (!IsValid() || mCount == 0) {
+			return;
+		}
+		ShaderProgram_Use(mProgram);
+		for (uint32_t i = 0; i < mTexturesCount; i++) {
+			Texture_Bind(mTextures[i], uint8_t(i));
+		}
+		Buffer_Update(mBuffer, 0, mData.data(), mCount * mStride);
+		Mesh_DrawInstanced(mMesh, mCount * mRepeat);
+	}
+
+	InstanceFormat::Enum GetFormat() const {
+		return mFormat;
+	}
+
+	uint32_t GetCount() const {
+		return mCount;
+	}
+
+	bool IsValid() const {
+		return mMesh.IsValid();
+	}
+
+private:
+	MeshHandle mMesh = MeshHandle(cInvalidHandle);
+	BufferHandle mBuffer = BufferHandle(cInvalidHandle);
+	ShaderProgramHandle mProgram = ShaderProgramHandle(cInvalidHandle);
+	TextureHandle mTextures[cMaxInstanceBatchTextures];
+	uint32_t mTexturesCount = 0;
+
+	InstanceFormat::Enum mFormat = InstanceFormat::Matrix;
+	uint32_t mStride = 0;
+	uint32_t mRepeat = 1;
+	uint32_t mCount = 0;
+	std::vector<uint8_t> mData;
+};
+
+static constexpr uint32_t cMaxInstanceBatchHandles = (1 << 6);
+uint32_t sInstanceBatchesCount = 0;
+std::array<InstanceBatch, cMaxInstanceBatchHandles> sInstanceBatches;
+
+}
+
+InstanceBatchHandle Instancing_CreateBatch(const InstanceBatchParams& params) {
+	if (!params.mProgram.IsValid() || sInstanceBatchesCount >= cMaxInstanceBatchHandles) {
+		return InstanceBatchHandle(cInvalidHandle);
+	}
+
+	InstanceBatchHandle handle = InstanceBatchHandle(sInstanceBatchesCount);
+	auto& batch = sInstanceBatches[handle.mHandle];
+	batch.Create(params);
+
+	if (batch.IsValid()) {
+		sInstanceBatchesCount++;
+		return handle;
+	}
+	return InstanceBatchHandle(cInvalidHandle);
+}
+
+void Instancing_DestroyBatch(const InstanceBatchHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& batch = sInstanceBatches[handle.mHandle];
+	batch.Destroy();
+}
+
+void Instancing_Clear(const InstanceBatchHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& batch = sInstanceBatches[handle.mHandle];
+	batch.Clear();
+}
+
+bool Instancing_Add(const InstanceBatchHandle& handle, const glm::mat4& model) {
+	if (!handle.IsValid()) {
+		return false;
+	}
+	auto& batch = sInstanceBatches[handle.mHandle];
+	if (batch.GetFormat() == InstanceFormat::Matrix) {
+		return batch.Add(&model, sizeof(model));
+	}
+	// only rigid transforms with uniform scale can be expressed as TRS
+	glm::vec3 scale(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])));
+	glm::mat3 rotation(glm::vec3(model[0]) / scale.x, glm::vec3(model[1]) / scale.y, glm::vec3(model[2]) / scale.z);
+	return Instancing_Add(handle, glm::vec3(model[3]), glm::quat_cast(rotation), scale.x);
+}
+
+bool Instancing_Add(const InstanceBatchHandle& handle, const glm::vec3& translation, const glm::quat& rotation, float scale) {
+	if (!handle.IsValid()) {
+		return false;
+	}
+	auto& batch = sInstanceBatches[handle.mHandle];
+	if (batch.GetFormat() == InstanceFormat::TRS) {
+		InstanceTRS instance{ glm::vec4(translation, scale), glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w) };
+		return batch.Add(&instance, sizeof(instance));
+	}
+	glm::mat4 model = glm::mat4_cast(rotation);
+	model[0] *= scale;
+	model[1] *= scale;
+	model[2] *= scale;
+	model[3] = glm::vec4(translation, 1.0f);
+	return batch.Add(&model, sizeof(model));
+}
+
+uint32_t Instancing_GetCount(const InstanceBatchHandle& handle) {
+	if (!handle.IsValid()) {
+		return 0;
+	}
+	auto& batch = sInstanceBatches[handle.mHandle];
+	return batch.GetCount();
+}
+
+void Instancing_Submit(const InstanceBatchHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& batch = sInstanceBatches[handle.mHandle];
+	batch.Submit();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Mesh.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+struct InstanceFormat {
+	enum Enum {
+		Matrix,		// mat4 model matrix, four attribute locations
+		TRS,		// vec4 translation + uniform scale, vec4 rotation quaternion, two attribute locations
+		Count
+	};
+};
+
+struct InstanceTRS {
+	glm::vec4 mTranslationScale;
+	glm::vec4 mRotation;
+};
+
+static constexpr uint32_t cMaxInstanceBatchTextures = 4;
+
+// A batch groups the instances drawn with the same mesh, program and textures. The mesh description is
+// extended with the per instance attributes starting at mFirstLocation (see 06-lights_instanced.vs).
+struct InstanceBatchParams {
+	MeshParams mMesh;
+	InstanceFormat::Enum mFormat = InstanceFormat::Matrix;
+	uint8_t mFirstLocation = 3;
+	uint32_t mMaxInstances = 1024;
+	uint32_t mRepeat = 1;		// copies drawn of every instance, told apart in the shader by gl_InstanceID % mRepeat
+
+	ShaderProgramHandle mProgram = ShaderProgramHandle(cInvalidHandle);
+	TextureHandle mTextures[cMaxInstanceBatchTextures];
+	uint32_t mTexturesCount = 0;
+};
+
+using InstanceBatchHandle = ResourceHandle;
+
+InstanceBatchHandle Instancing_CreateBatch(const InstanceBatchParams& params);
+
+void Instancing_DestroyBatch(const InstanceBatchHandle& handle);
+
+void Instancing_Clear(const InstanceBatchHandle& handle);
+
+bool Instancing_Add(const InstanceBatchHandle& handle, const glm::mat4& model);
+bool Instancing_Add(const InstanceBatchHandle& handle, const glm::vec3& translation, const glm::quat& rotation, float scale);
+
+uint32_t Instancing_GetCount(const InstanceBatchHandle& handle);
+
+// Uploads the instances added since the last clear and draws them with a single instanced call.
+// Per frame uniforms are expected to be already set on the batch program.
+void Instancing_Submit(const InstanceBatchHandle& handle);
@@ -0,0 +1,475 @@
+#include "JobSystem.h"
+
+#include "Log.h"
+#include <condition_variable>
+#include <deque>
+
+struct Job {
+	JobFunction mFunction;
+	JobCounter* mCounter = nullptr;
+};
+
+namespace
+{
+
+constexpr int64_t cDequeCapacity = 4096;		// power of two, a full deque runs new jobs inline
+constexpr uint32_t cSpinsBeforeSleep = 64;
+constexpr uint32_t cCacheLine = 64;
+
+// Chase-Lev deque: the owner pushes and pops at the bottom without locks, thieves take from the top and only
+// race with the owner for the last job, through the compare exchange on mTop.
+struct WorkDeque {
+	std::atomic<int64_t> mTop{ 0 };
+	uint8_t mPadding0[cCacheLine - sizeof(std::atomic<int64_t>)];
+	std::atomic<int64_t> mBottom{ 0 };
+	uint8_t mPadding1[cCacheLine - sizeof(std::atomic<int64_t>)];
+	std::atomic<Job*> mJobs[cDequeCapacity];
+};
+
+bool Deque_Push(WorkDeque& deque, Job* job) {
+	const int64_t bottom = deque.mBottom.load(std::memory_order_relaxed);
+	const int64_t top = deque.mTop.load(std::memory_order_acquire);
+	if (bottom - top >= cDequeCapacity) {
+		return false;
+	}
+	deque.mJobs[bottom & (cDequeCapacity - 1)].store(job, std::memory_order_relaxed);
+	deque.mBottom.store(bottom + 1, std::memory_order_release);
+	return true;
+}
+
+Job* Deque_Pop(WorkDeque& deque) {
+	const int64_t bottom = deque.mBottom.load(std::memory_order_relaxed) - 1;
+	deque.mBottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = deque.mTop.load(std::memory_order_relaxed);
+	if (top > bottom) {
+		deque.mBottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	Job* job = deque.mJobs[bottom & (cDequeCapacity - 1)].load(std::memory_order_relaxed);
+	if (top == bottom) {
+		if (!deque.mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+			job = nullptr;
+		}
+		deque.mBottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* Deque_Steal(WorkDeque& deque) {
+	int64_t top = deque.mTop.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const int64_t bottom = deque.mBottom.load(std::memory_order_acquire);
+	if (top >= bottom) {
+		return nullptr;
+	}
+	Job* job = deque.mJobs[top & (cDequeCapacity - 1)].load(std::memory_order_relaxed);
+	if (!deque.mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+		return nullptr;
+	}
+	return job;
+}
+
+bool Deque_IsEmpty(const WorkDeque& deque) {
+	return deque.mBottom.load(std::memory_order_relaxed) <= deque.mTop.load(std::memory_order_relaxed);
+}
+
+// Statistics are only written by the owner thread, relaxed atomics let Job_GetStats read them at any time.
+struct Worker {
+	WorkDeque mDeque;
+	std::thread mThread;
+	uint32_t mRandom = 0;
+	std::atomic<uint64_t> mExecuted{ 0 };
+	std::atomic<uint64_t> mStolen{ 0 };
+	std::atomic<uint64_t> mSleeps{ 0 };
+	uint8_t mPadding[cCacheLine];
+};
+
+struct JobSystem {
+	~JobSystem() {
+		Job_Shutdown();
+	}
+
+	std::vector<std::unique_ptr<Worker>> mWorkers;
+	std::atomic<bool> mInitialized{ false };
+	std::atomic<bool> mQuit{ false };
+	std::atomic<uint32_t> mGeneration{ 0 };		// changed by every initialization and shutdown
+	std::mutex mInitMutex;
+
+	// jobs queued by threads outside of the system
+	std::mutex mInjectedMutex;
+	std::deque<Job*> mInjected;
+
+	// queued jobs not taken yet, idle workers sleep while it is zero
+	std::atomic<uint32_t> mQueued{ 0 };
+	std::atomic<uint32_t> mSleeping{ 0 };
+	std::mutex mSleepMutex;
+	std::condition_variable mWakeUp;
+};
+
+JobSystem sJobSystem;
+
+// Worker index of the thread, only valid for the generation of the system that assigned it: a shutdown called from
+// another thread cannot reset it.
+struct ThreadSlot {
+	uint32_t mIndex = cInvalidHandle;
+	uint32_t mGeneration = 0;
+};
+thread_local ThreadSlot sThreadSlot;
+
+uint32_t GetThreadIndex() {
+	return (sThreadSlot.mGeneration == sJobSystem.mGeneration.load(std::memory_order_relaxed)) ? sThreadSlot.mIndex : cInvalidHandle;
+}
+
+void SetThreadIndex(uint32_t index) {
+	sThreadSlot.mIndex = index;
+	sThreadSlot.mGeneration = sJobSystem.mGeneration.load(std::memory_order_relaxed);
+}
+
+inline void Increment(std::atomic<uint64_t>& value) {
+	value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void Initialize(uint32_t threadsCount, bool callerIsWorker);
+
+void EnsureInitialized() {
+	if (!sJobSystem.mInitialized.load(std::memory_order_acquire)) {
+		Initialize(0, false);
+	}
+}
+
+void WakeUp() {
+	if (sJobSystem.mSleeping.load() > 0) {
+		std::lock_guard<std::mutex> lock(sJobSystem.mSleepMutex);
+		sJobSystem.mWakeUp.notify_one();
+	}
+}
+
+void Execute(Job* job);
+
+// mQueued is raised first so a thief taking the job right away never sees it below zero.
+void Push(Job* job) {
+	const uint32_t index = GetThreadIndex();
+	sJobSystem.mQueued.fetch_add(1);
+	if (index == cInvalidHandle) {
+		std::lock_guard<std::mutex> lock(sJobSystem.mInjectedMutex);
+		sJobSystem.mInjected.push_back(job);
+	} else if (!Deque_Push(sJobSystem.mWorkers[index]->mDeque, job)) {
+		sJobSystem.mQueued.fetch_sub(1);
+		Execute(job);
+		return;
+	}
+	WakeUp();
+}
+
+// Only the zero transition takes the counter lock: it makes queuing continuations race free and lets Job_Wait
+// know when the finishing thread is done with the counter.
+void Decrement(JobCounter& counter) {
+	uint32_t value = counter.mValue.load(std::memory_order_relaxed);
+	while (value > 1) {
+		if (counter.mValue.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+			return;
+		}
+	}
+
+	std::vector<Job*> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter.mMutex);
+		if (counter.mValue.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			continuations.swap(counter.mContinuations);
+		}
+	}
+	for (Job* job : continuations) {
+		Push(job);
+	}
+}
+
+void Execute(Job* job) {
+	job->mFunction();
+	if (job->mCounter) {
+		Decrement(*job->mCounter);
+	}
+	delete job;
+	const uint32_t index = GetThreadIndex();
+	if (index != cInvalidHandle) {
+		Increment(sJobSystem.mWorkers[index]->mExecuted);
+	}
+}
+
+Job* TakeInjected() {
+	std::lock_guard<std::mutex> lock(sJobSystem.mInjectedMutex);
+	if (sJobSystem.mInjected.empty()) {
+		return nullptr;
+	}
+	Job* job = sJobSystem.mInjected.front();
+	sJobSystem.mInjected.pop_front();
+	return job;
+}
+
+// Own deque first (newest job, its data is likely still in cache), then the oldest job of a random victim, which
+// tends to be the biggest piece of a split range.
+Job* Take(uint32_t index) {
+	Job* job = nullptr;
+	const uint32_t workersCount = static_cast<uint32_t>(sJobSystem.mWorkers.size());
+	if (index != cInvalidHandle) {
+		Worker& worker = *sJobSystem.mWorkers[index];
+		job = Deque_Pop(worker.mDeque);
+		if (job == nullptr && workersCount > 1) {
+			worker.mRandom ^= worker.mRandom << 13;
+			worker.mRandom ^= worker.mRandom >> 17;
+			worker.mRandom ^= worker.mRandom << 5;
+			const uint32_t first = worker.mRandom % workersCount;
+			for (uint32_t i = 0; i < workersCount && job == nullptr; i++) {
+				const uint32_t victim = (first + i) % workersCount;
+				if (victim != index) {
+					job = Deque_Steal(sJobSystem.mWorkers[victim]->mDeque);
+				}
+			}
+			if (job) {
+				Increment(worker.mStolen);
+			}
+		}
+	} else {
+		for (uint32_t victim = 0; victim < workersCount && job == nullptr; victim++) {
+			job = Deque_Steal(sJobSystem.mWorkers[victim]->mDeque);
+		}
+	}
+	if (job == nullptr) {
+		job = TakeInjected();
+	}
+	if (job) {
+		sJobSystem.mQueued.fetch_sub(1);
+	}
+	return job;
+}
+
+void WorkerLoop(uint32_t index) {
+	SetThreadIndex(index);
+	Worker& worker = *sJobSystem.mWorkers[index];
+	uint32_t spins = 0;
+	while (!sJobSystem.mQuit.load(std::memory_order_relaxed)) {
+		Job* job = Take(index);
+		if (job) {
+			Execute(job);
+			spins = 0;
+			continue;
+		}
+		if (++spins < cSpinsBeforeSleep) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		// mSleeping is raised before testing mQueued and Push raises mQueued before testing mSleeping, so either
+		// this thread sees the job or the pushing thread sees a sleeper to notify
+		spins = 0;
+		Increment(worker.mSleeps);
+		std::unique_lock<std::mutex> lock(sJobSystem.mSleepMutex);
+		sJobSystem.mSleeping.fetch_add(1);
+		sJobSystem.mWakeUp.wait(lock, []() { return sJobSystem.mQueued.load() > 0 || sJobSystem.mQuit.load(); });
+		sJobSystem.mSleeping.fetch_sub(1);
+	}
+}
+
+struct ParallelForContext {
+	const std::function<void(uint32_t, uint32_t)>* mBody;
+	uint32_t mGrain;
+	JobCounter mCounter;
+};
+
+void RunRange(ParallelForContext& context, uint32_t begin, uint32_t end) {
+	while (end - begin > context.mGrain) {
+		const uint32_t index = GetThreadIndex();
+		if (index != cInvalidHandle && Deque_IsEmpty(sJobSystem.mWorkers[index]->mDeque)) {
+			// nothing left for thieves: hand them the upper half
+			const uint32_t middle = begin + (end - begin) / 2;
+			context.mCounter.mValue.fetch_add(1, std::memory_order_relaxed);
+			Job* job = new Job();
+			job->mFunction = [&context, middle, end]() { RunRange(context, middle, end); };
+			job->mCounter = &context.mCounter;
+			Push(job);
+			end = middle;
+		} else {
+			(*context.mBody)(begin, begin + context.mGrain);
+			begin += context.mGrain;
+		}
+	}
+	(*context.mBody)(begin, end);
+}
+
+// Only an explicit Job_Initialize makes the calling thread worker 0, a lazy initialization may run on any thread and
+// starts a thread for every worker instead.
+void Initialize(uint32_t threadsCount, bool callerIsWorker) {
+	std::lock_guard<std::mutex> lock(sJobSystem.mInitMutex);
+	if (sJobSystem.mInitialized.load()) {
+		return;
+	}
+	if (threadsCount == 0) {
+		threadsCount = std::thread::hardware_concurrency();
+		threadsCount = threadsCount > 0 ? threadsCount : 1;
+	}
+
+	sJobSystem.mQuit.store(false);
+	sJobSystem.mWorkers.resize(threadsCount);
+	for (uint32_t i = 0; i < threadsCount; i++) {
+		sJobSystem.mWorkers[i].reset(new Worker());
+		sJobSystem.mWorkers[i]->mRandom = 0x9e3779b9u * (i + 1);
+	}
+	sJobSystem.mGeneration.fetch_add(1);
+	const uint32_t firstThread = callerIsWorker ? 1 : 0;
+	if (callerIsWorker) {
+		SetThreadIndex(0);
+	}
+	for (uint32_t i = firstThread; i < threadsCount; i++) {
+		sJobSystem.mWorkers[i]->mThread = std::thread(WorkerLoop, i);
+	}
+	sJobSystem.mInitialized.store(true, std::memory_order_release);
+	Log(tinyngine::Logger::Information, "Job system: %u threads", threadsCount);
+}
+
+}
+
+void Job_Initialize(uint32_t threadsCount) {
+	Initialize(threadsCount, true);
+}
+
+void Job_Shutdown() {
+	std::lock_guard<std::mutex> lock(sJobSystem.mInitMutex);
+	if (!sJobSystem.mInitialized.load()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> sleepLock(sJobSystem.mSleepMutex);
+		sJobSystem.mQuit.store(true);
+		sJobSystem.mWakeUp.notify_all();
+	}
+	for (auto& worker : sJobSystem.mWorkers) {
+		if (worker->mThread.joinable()) {
+			worker->mThread.join();
+		}
+		while (Job* job = Deque_Pop(worker->mDeque)) {
+			delete job;
+		}
+	}
+	for (Job* job : sJobSystem.mInjected) {
+		delete job;
+	}
+	sJobSystem.mInjected.clear();
+	sJobSystem.mWorkers.clear();
+	sJobSystem.mQueued.store(0);
+	sJobSystem.mInitialized.store(false);
+	// invalidates the index of worker 0 as well, whichever thread holds it
+	sJobSystem.mGeneration.fetch_add(1);
+	sThreadSlot = ThreadSlot();
+}
+
+uint32_t Job_GetThreadsCount() {
+	EnsureInitialized();
+	return static_cast<uint32_t>(sJobSystem.mWorkers.size());
+}
+
+uint32_t Job_GetThreadIndex() {
+	return GetThreadIndex();
+}
+
+void Job_Run(const JobFunction& function, JobCounter* counter) {
+	EnsureInitialized();
+	if (counter) {
+		counter->mValue.fetch_add(1, std::memory_order_relaxed);
+	}
+	Job* job = new Job();
+	job->mFunction = function;
+	job->mCounter = counter;
+	Push(job);
+}
+
+void Job_RunAfter(JobCounter& dependency, const JobFunction& function, JobCounter* counter) {
+	EnsureInitialized();
+	if (counter) {
+		counter->mValue.fetch_add(1, std::memory_order_relaxed);
+	}
+	Job* job = new Job();
+	job->mFunction = function;
+	job->mCounter = counter;
+	{
+		std::lock_guard<std::mutex> lock(dependency.mMutex);
+		if (dependency.mValue.load(std::memory_order_acquire) > 0) {
+			dependency.mContinuations.push_back(job);
+			return;
+		}
+	}
+	Push(job);
+}
+
+void Job_Wait(JobCounter& counter) {
+	EnsureInitialized();
+	const uint32_t index = GetThreadIndex();
+	while (counter.mValue.load(std::memory_order_acquire) > 0) {
+		Job* job = Take(index);
+		if (job) {
+			Execute(job);
+		} else {
+			std::this_thread::yield();
+		}
+	}
+	// the thread releasing the last job may still hold the lock
+	std::lock_guard<std::mutex> lock(counter.mMutex);
+}
+
+bool Job_IsDone(const JobCounter& counter) {
+	return counter.mValue.load(std::memory_order_acquire) == 0;
+}
+
+void Job_RunSlices(uint32_t slicesCount, const std::function<void(uint32_t slice)>& task) {
+	if (slicesCount <= 1) {
+		if (slicesCount == 1) {
+			task(0);
+		}
+		return;
+	}
+	JobCounter counter;
+	for (uint32_t slice = 1; slice < slicesCount; slice++) {
+		Job_Run([&task, slice]() { task(slice); }, &counter);
+	}
+	task(0);
+	Job_Wait(counter);
+}
+
+void Job_ParallelFor(uint32_t count, uint32_t minGrain, const std::function<void(uint32_t begin, uint32_t end)>& body) {
+	minGrain = minGrain > 0 ? minGrain : 1;
+	if (count <= minGrain) {
+		if (count > 0) {
+			body(0, count);
+		}
+		return;
+	}
+	EnsureInitialized();
+
+	ParallelForContext context;
+	context.mBody = &body;
+	context.mGrain = minGrain;
+	if (GetThreadIndex() == cInvalidHandle) {
+		// splitting relies on a deque of our own, hand the whole range to the workers
+		Job_Run([&context, count]() { RunRange(context, 0, count); }, &context.mCounter);
+	} else {
+		RunRange(context, 0, count);
+	}
+	Job_Wait(context.mCounter);
+}
+
+JobStats Job_GetStats() {
+	JobStats stats;
+	for (auto& worker : sJobSystem.mWorkers) {
+		stats.mExecuted += worker->mExecuted.load(std::memory_order_relaxed);
+		stats.mStolen += worker->mStolen.load(std::memory_order_relaxed);
+		stats.mSleeps += worker->mSleeps.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+void Job_ResetStats() {
+	for (auto& worker : sJobSystem.mWorkers) {
+		worker->mExecuted.store(0, std::memory_order_relaxed);
+		worker->mStolen.store(0, std::memory_order_relaxed);
+		worker->mSleeps.store(0, std::memory_order_relaxed);
+	}
+}
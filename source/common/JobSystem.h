@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CommonDefine.h"
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+struct Job;
+
+using JobFunction = std::function<void()>;
+
+// Counts the unfinished jobs started with it. Jobs started with Job_RunAfter on a counter are released when it
+// reaches zero. A counter must outlive its jobs, Job_Wait returning is enough to destroy or reuse it.
+struct JobCounter {
+	std::atomic<uint32_t> mValue{ 0 };
+	std::mutex mMutex;							// taken when the value reaches zero and to queue continuations
+	std::vector<Job*> mContinuations;
+};
+
+struct JobStats {
+	uint64_t mExecuted = 0;
+	uint64_t mStolen = 0;						// jobs taken from the deque of another thread
+	uint64_t mSleeps = 0;
+};
+
+// Starts threadsCount - 1 workers, the calling thread is worker 0 and only runs jobs while it waits. 0 uses one
+// thread per hardware thread. Every other function initializes the system with the default count when needed, every
+// worker is a thread then and the calling thread stays outside of the system.
+void Job_Initialize(uint32_t threadsCount = 0);
+
+// Waits for the workers to finish their current job, jobs still queued are dropped. May be called from any thread,
+// the thread that was worker 0 is outside of the system afterwards.
+void Job_Shutdown();
+
+// Worker threads plus the thread that called Job_Initialize, if any.
+uint32_t Job_GetThreadsCount();
+
+// In [0, Job_GetThreadsCount()) on the threads of the system, cInvalidHandle on any other thread.
+uint32_t Job_GetThreadIndex();
+
+// Queues the job on the calling thread deque, idle workers steal from there. Threads outside of the system
+// queue on a shared list instead.
+void Job_Run(const JobFunction& function, JobCounter* counter = nullptr);
+
+// Queues the job once dependency reaches zero. counter is incremented right away.
+void Job_RunAfter(JobCounter& dependency, const JobFunction& function, JobCounter* counter = nullptr);
+
+// Runs queued jobs (its own first, then stolen ones) until counter reaches zero.
+void Job_Wait(JobCounter& counter);
+
+bool Job_IsDone(const JobCounter& counter);
+
+// Calls task(slice) for every slice in [0, slicesCount) as separate jobs, the calling thread runs slice 0.
+// Returns when all the slices are done.
+void Job_RunSlices(uint32_t slicesCount, const std::function<void(uint32_t slice)>& task);
+
+// Calls body over consecutive ranges covering [0, count). Ranges are split in halves only while the running
+// thread has nothing queued, so the grain adapts to how many threads are actually idle; minGrain is the
+// smallest range worth a job. Returns when the whole range is done.
+void Job_ParallelFor(uint32_t count, uint32_t minGrain, const std::function<void(uint32_t begin, uint32_t end)>& body);
+
+JobStats Job_GetStats();
+
+void Job_ResetStats();
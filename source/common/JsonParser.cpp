@@ -0,0 +1,327 @@
+#include "JsonParser.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+namespace
+{
+
+constexpr uint32_t cMaxDepth = 64;
+constexpr int cMaxExponent = DBL_MAX_10_EXP;	// larger exponents overflow to infinity or underflow to zero anyway
+
+struct ParserState {
+	const char* mJson;
+	size_t mLength;
+	size_t mPosition;
+	JsonToken* mTokens;
+	uint32_t mMaxTokens;
+	uint32_t mCount;
+};
+
+bool IsWhitespace(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+void SkipWhitespaces(ParserState& state) {
+	while (state.mPosition < state.mLength && IsWhitespace(state.mJson[state.mPosition])) {
+		state.mPosition++;
+	}
+}
+
+uint32_t AllocToken(ParserState& state, JsonTokenType::Enum type, size_t start) {
+	if (state.mTokens != nullptr) {
+		if (state.mCount >= state.mMaxTokens) {
+			return cJsonInvalidToken;
+		}
+		JsonToken& token = state.mTokens[state.mCount];
+		token.mType = type;
+		token.mStart = static_cast<uint32_t>(start);
+		token.mEnd = static_cast<uint32_t>(start);
+		token.mSize = 0;
+		token.mNext = state.mCount + 1;
+	}
+	return state.mCount++;
+}
+
+void CloseToken(ParserState& state, uint32_t index, size_t end, uint32_t size) {
+	if (state.mTokens != nullptr) {
+		JsonToken& token = state.mTokens[index];
+		token.mEnd = static_cast<uint32_t>(end);
+		token.mSize = size;
+		token.mNext = state.mCount;
+	}
+}
+
+bool ParseValue(ParserState& state, uint32_t depth);
+
+bool ParseString(ParserState& state) {
+	size_t start = ++state.mPosition;
+	uint32_t index = AllocToken(state, JsonTokenType::String, start);
+	if (index == cJsonInvalidToken) {
+		return false;
+	}
+	while (state.mPosition < state.mLength) {
+		char c = state.mJson[state.mPosition];
+		if (c == '"') {
+			CloseToken(state, index, state.mPosition, 0);
+			state.mPosition++;
+			return true;
+		}
+		if (c == '\\') {
+			state.mPosition++;
+		}
+		state.mPosition++;
+	}
+	return false;
+}
+
+bool ParsePrimitive(ParserState& state) {
+	size_t start = state.mPosition;
+	uint32_t index = AllocToken(state, JsonTokenType::Primitive, start);
+	if (index == cJsonInvalidToken) {
+		return false;
+	}
+	while (state.mPosition < state.mLength) {
+		char c = state.mJson[state.mPosition];
+		if (c == ',' || c == ']' || c == '}' || IsWhitespace(c)) {
+			break;
+		}
+		if (c < 32 || c >= 127) {
+			return false;
+		}
+		state.mPosition++;
+	}
+	if (state.mPosition == start) {
+		return false;
+	}
+	CloseToken(state, index, state.mPosition, 0);
+	return true;
+}
+
+bool ParseContainer(ParserState& state, uint32_t depth, bool isObject) {
+	if (depth >= cMaxDepth) {
+		return false;
+	}
+	const char closing = isObject ? '}' : ']';
+	uint32_t index = AllocToken(state, isObject ? JsonTokenType::Object : JsonTokenType::Array, state.mPosition);
+	if (index == cJsonInvalidToken) {
+		return false;
+	}
+	state.mPosition++;
+
+	uint32_t size = 0;
+	SkipWhitespaces(state);
+	if (state.mPosition < state.mLength && state.mJson[state.mPosition] == closing) {
+		state.mPosition++;
+		CloseToken(state, index, state.mPosition, 0);
+		return true;
+	}
+
+	while (state.mPosition < state.mLength) {
+		SkipWhitespaces(state);
+		if (isObject) {
+			if (state.mPosition >= state.mLength || state.mJson[state.mPosition] != '"' || !ParseString(state)) {
+				return false;
+			}
+			SkipWhitespaces(state);
+			if (state.mPosition >= state.mLength || state.mJson[state.mPosition] != ':') {
+				return false;
+			}
+			state.mPosition++;
+		}
+		if (!ParseValue(state, depth + 1)) {
+			return false;
+		}
+		size++;
+
+		SkipWhitespaces(state);
+		if (state.mPosition >= state.mLength) {
+			return false;
+		}
+		char c = state.mJson[state.mPosition++];
+		if (c == closing) {
+			CloseToken(state, index, state.mPosition, size);
+			return true;
+		}
+		if (c != ',') {
+			return false;
+		}
+	}
+	return false;
+}
+
+bool ParseValue(ParserState& state, uint32_t depth) {
+	SkipWhitespaces(state);
+	if (state.mPosition >= state.mLength) {
+		return false;
+	}
+	switch (state.mJson[state.mPosition]) {
+	case '{':
+		return ParseContainer(state, depth, true);
+	case '[':
+		return ParseContainer(state, depth, false);
+	case '"':
+		return ParseString(state);
+	default:
+		return ParsePrimitive(state);
+	}
+}
+
+double ParseNumber(const char* str, const char* end) {
+	double sign = 1.0;
+	if (str < end && (*str == '-' || *str == '+')) {
+		sign = (*str == '-') ? -1.0 : 1.0;
+		str++;
+	}
+	double value = 0.0;
+	while (str < end && *str >= '0' && *str <= '9') {
+		value = value * 10.0 + double(*str - '0');
+		str++;
+	}
+	if (str < end && *str == '.') {
+		str++;
+		double scale = 0.1;
+		while (str < end && *str >= '0' && *str <= '9') {
+			value += double(*str - '0') * scale;
+			scale *= 0.1;
+			str++;
+		}
+	}
+	if (str < end && (*str == 'e' || *str == 'E')) {
+		str++;
+		bool negative = false;
+		if (str < end && (*str == '-' || *str == '+')) {
+			negative = (*str == '-');
+			str++;
+		}
+		int exponent = 0;
+		while (str < end && *str >= '0' && *str <= '9') {
+			exponent = std::min(exponent * 10 + (*str - '0'), cMaxExponent);
+			str++;
+		}
+		double factor = 1.0;
+		while (exponent-- > 0) {
+			factor *= 10.0;
+		}
+		value = negative ? value / factor : value * factor;
+	}
+	return sign * value;
+}
+
+}
+
+int32_t Json_Parse(const char* json, size_t length, JsonToken* tokens, uint32_t maxTokens) {
+	if (json == nullptr) {
+		return -1;
+	}
+	ParserState state{ json, length, 0, tokens, maxTokens, 0 };
+	if (!ParseValue(state, 0)) {
+		return -1;
+	}
+	// trailing padding (the GLB JSON chunk is padded with spaces) and NUL terminators are accepted
+	while (state.mPosition < state.mLength && (IsWhitespace(json[state.mPosition]) || json[state.mPosition] == '\0')) {
+		state.mPosition++;
+	}
+	if (state.mPosition != state.mLength) {
+		return -1;
+	}
+	return static_cast<int32_t>(state.mCount);
+}
+
+//====================================================================================================================
+
+uint32_t JsonDocument::FindMember(uint32_t object, const char* key) const {
+	if (object >= mCount || mTokens[object].mType != JsonTokenType::Object) {
+		return cJsonInvalidToken;
+	}
+	uint32_t index = object + 1;
+	for (uint32_t i = 0; i < mTokens[object].mSize; i++) {
+		uint32_t value = index + 1;
+		if (Equals(index, key)) {
+			return value;
+		}
+		index = mTokens[value].mNext;
+	}
+	return cJsonInvalidToken;
+}
+
+uint32_t JsonDocument::GetElement(uint32_t array, uint32_t element) const {
+	if (array >= mCount || mTokens[array].mType != JsonTokenType::Array || element >= mTokens[array].mSize) {
+		return cJsonInvalidToken;
+	}
+	uint32_t index = array + 1;
+	for (uint32_t i = 0; i < element; i++) {
+		index = mTokens[index].mNext;
+	}
+	return index;
+}
+
+uint32_t JsonDocument::GetSize(uint32_t index) const {
+	return (index < mCount) ? mTokens[index].mSize : 0;
+}
+
+bool JsonDocument::Equals(uint32_t index, const char* str) const {
+	if (index >= mCount || str == nullptr) {
+		return false;
+	}
+	const JsonToken& token = mTokens[index];
+	size_t length = std::strlen(str);
+	return (token.mEnd - token.mStart) == length && std::memcmp(mJson + token.mStart, str, length) == 0;
+}
+
+uint32_t JsonDocument::GetUInt(uint32_t index, uint32_t defaultValue) const {
+	if (index >= mCount || mTokens[index].mType != JsonTokenType::Primitive) {
+		return defaultValue;
+	}
+	const JsonToken& token = mTokens[index];
+	double value = ParseNumber(mJson + token.mStart, mJson + token.mEnd);
+	// the conversion is undefined out of range, NaN fails both comparisons
+	return (value >= 0.0 && value <= double(UINT32_MAX)) ? static_cast<uint32_t>(value) : defaultValue;
+}
+
+float JsonDocument::GetFloat(uint32_t index, float defaultValue) const {
+	if (index >= mCount || mTokens[index].mType != JsonTokenType::Primitive) {
+		return defaultValue;
+	}
+	const JsonToken& token = mTokens[index];
+	double value = ParseNumber(mJson + token.mStart, mJson + token.mEnd);
+	return (value >= -double(FLT_MAX) && value <= double(FLT_MAX)) ? static_cast<float>(value) : defaultValue;
+}
+
+bool JsonDocument::GetBool(uint32_t index, bool defaultValue) const {
+	if (index >= mCount || mTokens[index].mType != JsonTokenType::Primitive) {
+		return defaultValue;
+	}
+	return mJson[mTokens[index].mStart] == 't';
+}
+
+uint32_t JsonDocument::GetFloatArray(uint32_t index, float* values, uint32_t maxValues) const {
+	if (index >= mCount || mTokens[index].mType != JsonTokenType::Array) {
+		return 0;
+	}
+	uint32_t count = (mTokens[index].mSize < maxValues) ? mTokens[index].mSize : maxValues;
+	uint32_t element = index + 1;
+	for (uint32_t i = 0; i < count; i++) {
+		values[i] = GetFloat(element, values[i]);
+		element = mTokens[element].mNext;
+	}
+	return count;
+}
+
+uint32_t JsonDocument::GetMemberUInt(uint32_t object, const char* key, uint32_t defaultValue) const {
+	return GetUInt(FindMember(object, key), defaultValue);
+}
+
+float JsonDocument::GetMemberFloat(uint32_t object, const char* key, float defaultValue) const {
+	return GetFloat(FindMember(object, key), defaultValue);
+}
+
+const char* JsonDocument::GetString(uint32_t index, uint32_t& length) const {
+	if (index >= mCount || mTokens[index].mType != JsonTokenType::String) {
+		length = 0;
+		return nullptr;
+	}
+	length = mTokens[index].mEnd - mTokens[index].mStart;
+	return mJson + mTokens[index].mStart;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CommonDefine.h"
+
+// Minimal in-place JSON tokenizer: tokens reference ranges of the source text and live in caller provided storage,
+// so parsing never allocates. Strings are not unescaped.
+
+struct JsonTokenType {
+	enum Enum {
+		Undefined,
+		Object,
+		Array,
+		String,
+		Primitive,
+		Count
+	};
+};
+
+struct JsonToken {
+	JsonTokenType::Enum mType;
+	uint32_t mStart;
+	uint32_t mEnd;
+	uint32_t mSize;		// members for objects, elements for arrays
+	uint32_t mNext;		// index of the first token after this subtree
+};
+
+static const uint32_t cJsonInvalidToken = UINT32_MAX;
+
+// Returns the number of tokens parsed, or -1 on malformed input or when maxTokens is exceeded.
+// Passing nullptr as tokens only counts them.
+int32_t Json_Parse(const char* json, size_t length, JsonToken* tokens, uint32_t maxTokens);
+
+class JsonDocument final {
+public:
+	JsonDocument(const char* json, const JsonToken* tokens, uint32_t count) : mJson(json), mTokens(tokens), mCount(count) {}
+
+	const JsonToken& GetToken(uint32_t index) const { return mTokens[index]; }
+	uint32_t GetTokensCount() const { return mCount; }
+
+	uint32_t FindMember(uint32_t object, const char* key) const;
+	uint32_t GetElement(uint32_t array, uint32_t element) const;
+	uint32_t GetSize(uint32_t index) const;
+
+	bool Equals(uint32_t index, const char* str) const;
+
+	uint32_t GetUInt(uint32_t index, uint32_t defaultValue = 0) const;
+	float GetFloat(uint32_t index, float defaultValue = 0.0f) const;
+	bool GetBool(uint32_t index, bool defaultValue = false) const;
+	uint32_t GetFloatArray(uint32_t index, float* values, uint32_t maxValues) const;
+
+	uint32_t GetMemberUInt(uint32_t object, const char* key, uint32_t defaultValue = 0) const;
+	float GetMemberFloat(uint32_t object, const char* key, float defaultValue = 0.0f) const;
+
+	const char* GetString(uint32_t index, uint32_t& length) const;
+
+private:
+	const char* mJson;
+	const JsonToken* mTokens;
+	uint32_t mCount;
+};
@@ -0,0 +1,348 @@
+#include "LightGrid.h"
+
+#include "JobSystem.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+
+// smallest number of lights worth a culling job
+constexpr uint32_t cMinLightsPerJob = 256;
+
+inline uint32_t RoundUp4(uint32_t value) {
+	return (value + 3) & ~3u;
+}
+
+inline uint32_t PopCount4(int mask) {
+	return uint32_t((mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1));
+}
+
+// Tangents of the interior boundaries between tiles, the planes go through the eye so x + t * z has the sign of
+// the side a view space point is on. NaN lanes never pass a comparison.
+void BuildPlanes(std::vector<float>& planes, uint32_t tiles, float tanHalfFov) {
+	planes.assign(RoundUp4(tiles - 1), std::numeric_limits<float>::quiet_NaN());
+	for (uint32_t i = 1; i < tiles; i++) {
+		planes[i - 1] = (-1.0f + 2.0f * float(i) / float(tiles)) * tanHalfFov;
+	}
+}
+
+// Range of tiles overlapped by a disc of radius r around (x, -depth) swept over [nearDepth, farDepth]: the first
+// tile is the count of boundaries the whole shape is right of, the last one discounts those it is left of.
+inline void TileRange(const std::vector<float>& planes, uint32_t tiles, float x, float r, float nearDepth, float farDepth, uint8_t& first, uint8_t& last) {
+	const __m128 centerMinus = _mm_set1_ps(x - r);
+	const __m128 centerPlus = _mm_set1_ps(x + r);
+	const __m128 zNear = _mm_set1_ps(-nearDepth);
+	const __m128 zFar = _mm_set1_ps(-farDepth);
+	const __m128 zero = _mm_setzero_ps();
+	uint32_t right = 0;
+	uint32_t left = 0;
+	for (size_t i = 0; i < planes.size(); i += 4) {
+		const __m128 t = _mm_loadu_ps(&planes[i]);
+		const __m128 a = _mm_mul_ps(t, zNear);
+		const __m128 b = _mm_mul_ps(t, zFar);
+		const __m128 minimum = _mm_add_ps(centerMinus, _mm_min_ps(a, b));
+		const __m128 maximum = _mm_add_ps(centerPlus, _mm_max_ps(a, b));
+		right += PopCount4(_mm_movemask_ps(_mm_cmpgt_ps(minimum, zero)));
+		left += PopCount4(_mm_movemask_ps(_mm_cmplt_ps(maximum, zero)));
+	}
+	first = uint8_t(right);
+	last = uint8_t(tiles - 1 - std::min(left, tiles - 1));
+}
+
+// Transforms 4 lights at a time to view space and rejects those outside of the frustum, then finds the depth
+// slices covered by the others.
+void CullLights(LightGrid& grid, const PointLight* lights, uint32_t count, const glm::mat4& view, float tanHalfX, float tanHalfY, uint32_t begin, uint32_t end) {
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 nearDepth = _mm_set1_ps(grid.mNear);
+	const __m128 farDepth = _mm_set1_ps(grid.mFar);
+	// side planes normals, unnormalized: x - tanHalfX * depth <= r * length means inside of the right plane
+	const __m128 tanX = _mm_set1_ps(tanHalfX);
+	const __m128 tanY = _mm_set1_ps(tanHalfY);
+	const __m128 lengthX = _mm_set1_ps(std::sqrt(1.0f + tanHalfX * tanHalfX));
+	const __m128 lengthY = _mm_set1_ps(std::sqrt(1.0f + tanHalfY * tanHalfY));
+	const float logNear = std::log(grid.mNear);
+	const uint32_t lastSlice = grid.mParams.mSlices - 1;
+
+	for (uint32_t i = begin; i < end; i += 4) {
+		float px[4], py[4], pz[4], pr[4];
+		for (uint32_t lane = 0; lane < 4; lane++) {
+			const uint32_t index = std::min(i + lane, count - 1);
+			px[lane] = lights[index].mPosition.x;
+			py[lane] = lights[index].mPosition.y;
+			pz[lane] = lights[index].mPosition.z;
+			pr[lane] = (i + lane < count) ? lights[index].mRadius : -1.0f;
+		}
+		const __m128 x = _mm_loadu_ps(px);
+		const __m128 y = _mm_loadu_ps(py);
+		const __m128 z = _mm_loadu_ps(pz);
+		const __m128 r = _mm_loadu_ps(pr);
+
+		__m128 vx = _mm_set1_ps(view[3][0]);
+		__m128 vy = _mm_set1_ps(view[3][1]);
+		__m128 vz = _mm_set1_ps(view[3][2]);
+		vx = _mm_add_ps(vx, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(view[0][0]), x), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(view[1][0]), y), _mm_mul_ps(_mm_set1_ps(view[2][0]), z))));
+		vy = _mm_add_ps(vy, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(view[0][1]), x), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(view[1][1]), y), _mm_mul_ps(_mm_set1_ps(view[2][1]), z))));
+		vz = _mm_add_ps(vz, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(view[0][2]), x), _mm_add_ps(_mm_mul_ps(_mm_set1_ps(view[1][2]), y), _mm_mul_ps(_mm_set1_ps(view[2][2]), z))));
+		_mm_storeu_ps(&grid.mViewX[i], vx);
+		_mm_storeu_ps(&grid.mViewY[i], vy);
+		_mm_storeu_ps(&grid.mViewZ[i], vz);
+		_mm_storeu_ps(&grid.mRadius[i], r);
+
+		const __m128 depth = _mm_sub_ps(zero, vz);
+		__m128 inside = _mm_cmpgt_ps(r, zero);
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(depth, r), nearDepth));
+		inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_sub_ps(depth, r), farDepth));
+		const __m128 edgeX = _mm_mul_ps(tanX, depth);
+		const __m128 edgeY = _mm_mul_ps(tanY, depth);
+		const __m128 reachX = _mm_mul_ps(r, lengthX);
+		const __m128 reachY = _mm_mul_ps(r, lengthY);
+		inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_sub_ps(vx, edgeX), reachX));
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(vx, edgeX), _mm_sub_ps(zero, reachX)));
+		inside = _mm_and_ps(inside, _mm_cmple_ps(_mm_sub_ps(vy, edgeY), reachY));
+		inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(vy, edgeY), _mm_sub_ps(zero, reachY)));
+
+		const int mask = _mm_movemask_ps(inside);
+		for (uint32_t lane = 0; lane < 4 && i + lane < end; lane++) {
+			const uint32_t index = i + lane;
+			if ((mask & (1 << lane)) == 0) {
+				grid.mFirstSlice[index] = 1;
+				grid.mLastSlice[index] = 0;
+				continue;
+			}
+			const float lightDepth = -grid.mViewZ[index];
+			const float minDepth = std::max(lightDepth - grid.mRadius[index], grid.mNear);
+			const float maxDepth = std::min(lightDepth + grid.mRadius[index], grid.mFar);
+			const float first = (std::log(minDepth) - logNear) * grid.mSliceScale;
+			const float last = (std::log(maxDepth) - logNear) * grid.mSliceScale;
+			grid.mFirstSlice[index] = uint8_t(std::min(uint32_t(std::max(first, 0.0f)), lastSlice));
+			grid.mLastSlice[index] = uint8_t(std::min(uint32_t(std::max(last, 0.0f)), lastSlice));
+		}
+	}
+}
+
+// Finds the tile rectangle of every light crossing the slice, counts the lights per tile, then lays the index
+// lists of the slice clusters out one after the other.
+void BuildSlice(LightGrid& grid, uint32_t slice, uint32_t count) {
+	const uint32_t tilesX = grid.mParams.mTilesX;
+	const uint32_t tilesY = grid.mParams.mTilesY;
+	const float sliceNear = grid.mSliceDepths[slice];
+	const float sliceFar = grid.mSliceDepths[slice + 1];
+	uint32_t* counts = &grid.mClusters[2 * slice * tilesX * tilesY];
+
+	std::vector<LightGridRect>& rects = grid.mSliceRects[slice];
+	rects.clear();
+	for (uint32_t i = 0; i < count; i++) {
+		if (slice < grid.mFirstSlice[i] || slice > grid.mLastSlice[i]) {
+			continue;
+		}
+		// the part of the sphere in the slice fits in a cylinder, as wide as the sphere section closest to its center
+		const float depth = -grid.mViewZ[i];
+		const float radius = grid.mRadius[i];
+		const float closest = std::min(std::max(depth, sliceNear), sliceFar);
+		const float offset = depth - closest;
+		const float sectionSquared = radius * radius - offset * offset;
+		if (sectionSquared <= 0.0f) {
+			continue;
+		}
+		const float section = std::sqrt(sectionSquared);
+		const float nearDepth = std::max(sliceNear, depth - radius);
+		const float farDepth = std::min(sliceFar, depth + radius);
+
+		LightGridRect rect;
+		rect.mLight = uint16_t(i);
+		TileRange(grid.mPlanesX, tilesX, grid.mViewX[i], section, nearDepth, farDepth, rect.mMinX, rect.mMaxX);
+		TileRange(grid.mPlanesY, tilesY, grid.mViewY[i], section, nearDepth, farDepth, rect.mMinY, rect.mMaxY);
+		if (rect.mMinX > rect.mMaxX || rect.mMinY > rect.mMaxY) {
+			continue;
+		}
+		rects.push_back(rect);
+		for (uint32_t y = rect.mMinY; y <= rect.mMaxY; y++) {
+			for (uint32_t x = rect.mMinX; x <= rect.mMaxX; x++) {
+				counts[2 * (y * tilesX + x) + 1]++;
+			}
+		}
+	}
+
+	uint32_t total = 0;
+	for (uint32_t tile = 0; tile < tilesX * tilesY; tile++) {
+		counts[2 * tile] = total;
+		total += counts[2 * tile + 1];
+	}
+
+	// offsets are relative to the slice until the slices are concatenated
+	std::vector<uint16_t>& indices = grid.mSliceIndices[slice];
+	indices.resize(total);
+	std::vector<uint32_t> cursors(tilesX * tilesY);
+	for (uint32_t tile = 0; tile < tilesX * tilesY; tile++) {
+		cursors[tile] = counts[2 * tile];
+	}
+	for (const LightGridRect& rect : rects) {
+		for (uint32_t y = rect.mMinY; y <= rect.mMaxY; y++) {
+			for (uint32_t x = rect.mMinX; x <= rect.mMaxX; x++) {
+				indices[cursors[y * tilesX + x]++] = rect.mLight;
+			}
+		}
+	}
+}
+
+}
+
+void LightGrid_Initialize(LightGrid& grid, const LightGridParams& params) {
+	grid.mParams = params;
+	grid.mParams.mTilesX = std::min(std::max(params.mTilesX, 1u), cLightGridMaxTiles);
+	grid.mParams.mTilesY = std::min(std::max(params.mTilesY, 1u), cLightGridMaxTiles);
+	grid.mParams.mSlices = std::min(std::max(params.mSlices, 1u), cLightGridMaxSlices);
+	grid.mSliceRects.resize(grid.mParams.mSlices);
+	grid.mSliceIndices.resize(grid.mParams.mSlices);
+	grid.mSliceOffsets.resize(grid.mParams.mSlices + 1);
+	grid.mClusters.assign(2 * grid.mParams.mTilesX * grid.mParams.mTilesY * grid.mParams.mSlices, 0);
+	grid.mStats = LightGridStats();
+}
+
+void LightGrid_CreateTextures(LightGrid& grid) {
+	const uint32_t clustersBytes = uint32_t(grid.mClusters.size() * sizeof(uint32_t));
+	grid.mLightBuffer = Buffer_Create(BufferType::Texture, nullptr, 1024 * 2 * sizeof(glm::vec4), BufferUsage::Stream);
+	grid.mClusterBuffer = Buffer_Create(BufferType::Texture, nullptr, clustersBytes, BufferUsage::Stream);
+	grid.mIndexBuffer = Buffer_Create(BufferType::Texture, nullptr, 64 * 1024 * sizeof(uint16_t), BufferUsage::Stream);
+	grid.mLightTexture = Texture_CreateBuffer(grid.mLightBuffer, TextureFormats::RGBA32F);
+	grid.mClusterTexture = Texture_CreateBuffer(grid.mClusterBuffer, TextureFormats::RG32UI);
+	grid.mIndexTexture = Texture_CreateBuffer(grid.mIndexBuffer, TextureFormats::R16UI);
+}
+
+void LightGrid_Destroy(LightGrid& grid) {
+	Texture_Destroy(grid.mIndexTexture);
+	Texture_Destroy(grid.mClusterTexture);
+	Texture_Destroy(grid.mLightTexture);
+	Buffer_Destroy(grid.mIndexBuffer);
+	Buffer_Destroy(grid.mClusterBuffer);
+	Buffer_Destroy(grid.mLightBuffer);
+	grid.mLightTexture = grid.mClusterTexture = grid.mIndexTexture = TextureHandle(cInvalidHandle);
+	grid.mLightBuffer = grid.mClusterBuffer = grid.mIndexBuffer = BufferHandle(cInvalidHandle);
+}
+
+void LightGrid_Build(LightGrid& grid, const PointLight* lights, uint32_t count, const glm::mat4& view, float fovY, float aspect, float nearPlane, float farPlane, uint32_t threadsCount) {
+	count = std::min(count, cLightGridMaxLights);
+	const uint32_t tilesX = grid.mParams.mTilesX;
+	const uint32_t tilesY = grid.mParams.mTilesY;
+	const uint32_t slices = grid.mParams.mSlices;
+	const float tanHalfY = std::tan(fovY * 0.5f);
+	const float tanHalfX = tanHalfY * aspect;
+
+	grid.mNear = nearPlane;
+	grid.mFar = farPlane;
+	grid.mSliceScale = float(slices) / std::log(farPlane / nearPlane);
+	grid.mSliceDepths.resize(slices + 1);
+	for (uint32_t s = 0; s <= slices; s++) {
+		grid.mSliceDepths[s] = nearPlane * std::pow(farPlane / nearPlane, float(s) / float(slices));
+	}
+	BuildPlanes(grid.mPlanesX, tilesX, tanHalfX);
+	BuildPlanes(grid.mPlanesY, tilesY, tanHalfY);
+
+	const uint32_t padded = RoundUp4(count);
+	grid.mViewX.resize(padded);
+	grid.mViewY.resize(padded);
+	grid.mViewZ.resize(padded);
+	grid.mRadius.resize(padded);
+	grid.mFirstSlice.resize(padded);
+	grid.mLastSlice.resize(padded);
+	std::fill(grid.mClusters.begin(), grid.mClusters.end(), 0u);
+
+	// ranges are kept on multiples of 4 lights so no two jobs write the same SIMD lanes
+	const uint32_t groups = padded / 4;
+	auto cull = [&grid, lights, count, &view, tanHalfX, tanHalfY](uint32_t begin, uint32_t end) {
+		CullLights(grid, lights, count, view, tanHalfX, tanHalfY, begin * 4, std::min(end * 4, count));
+	};
+	auto build = [&grid, count](uint32_t begin, uint32_t end) {
+		for (uint32_t slice = begin; slice < end; slice++) {
+			BuildSlice(grid, slice, count);
+		}
+	};
+	if (threadsCount > 1) {
+		Job_ParallelFor(groups, cMinLightsPerJob / 4, cull);
+		Job_ParallelFor(slices, 1, build);
+	} else {
+		cull(0, groups);
+		build(0, slices);
+	}
+
+	grid.mSliceOffsets[0] = 0;
+	for (uint32_t s = 0; s < slices; s++) {
+		grid.mSliceOffsets[s + 1] = grid.mSliceOffsets[s] + uint32_t(grid.mSliceIndices[s].size());
+	}
+	grid.mIndices.resize(grid.mSliceOffsets[slices]);
+
+	auto concatenate = [&grid, tilesX, tilesY](uint32_t begin, uint32_t end) {
+		for (uint32_t slice = begin; slice < end; slice++) {
+			const std::vector<uint16_t>& indices = grid.mSliceIndices[slice];
+			if (!indices.empty()) {
+				std::memcpy(&grid.mIndices[grid.mSliceOffsets[slice]], indices.data(), indices.size() * sizeof(uint16_t));
+			}
+			uint32_t* clusters = &grid.mClusters[2 * slice * tilesX * tilesY];
+			for (uint32_t tile = 0; tile < tilesX * tilesY; tile++) {
+				clusters[2 * tile] += grid.mSliceOffsets[slice];
+			}
+		}
+	};
+	if (threadsCount > 1) {
+		Job_ParallelFor(slices, 4, concatenate);
+	} else {
+		concatenate(0, slices);
+	}
+
+	grid.mLightData.resize(2 * count);
+	LightGridStats stats;
+	for (uint32_t i = 0; i < count; i++) {
+		grid.mLightData[2 * i] = glm::vec4(grid.mViewX[i], grid.mViewY[i], grid.mViewZ[i], grid.mRadius[i]);
+		grid.mLightData[2 * i + 1] = glm::vec4(lights[i].mColor * lights[i].mIntensity, 1.0f);
+		stats.mLights += (grid.mFirstSlice[i] <= grid.mLastSlice[i]) ? 1 : 0;
+	}
+	stats.mIndices = uint32_t(grid.mIndices.size());
+	for (size_t cluster = 0; cluster < grid.mClusters.size(); cluster += 2) {
+		stats.mMaxPerCluster = std::max(stats.mMaxPerCluster, grid.mClusters[cluster + 1]);
+		stats.mOccupiedClusters += (grid.mClusters[cluster + 1] > 0) ? 1 : 0;
+	}
+	grid.mStats = stats;
+}
+
+void LightGrid_Upload(LightGrid& grid) {
+	if (!grid.mLightData.empty()) {
+		Buffer_Update(grid.mLightBuffer, 0, grid.mLightData.data(), uint32_t(grid.mLightData.size() * sizeof(glm::vec4)));
+	}
+	Buffer_Update(grid.mClusterBuffer, 0, grid.mClusters.data(), uint32_t(grid.mClusters.size() * sizeof(uint32_t)));
+	if (!grid.mIndices.empty()) {
+		Buffer_Update(grid.mIndexBuffer, 0, grid.mIndices.data(), uint32_t(grid.mIndices.size() * sizeof(uint16_t)));
+	}
+}
+
+void LightGrid_Bind(const LightGrid& grid, const ShaderProgramHandle& program, uint8_t firstStage, uint32_t viewportWidth, uint32_t viewportHeight) {
+	Texture_Bind(grid.mLightTexture, firstStage);
+	Texture_Bind(grid.mClusterTexture, uint8_t(firstStage + 1));
+	Texture_Bind(grid.mIndexTexture, uint8_t(firstStage + 2));
+	ShaderProgram_SetInt(program, "u_lightGridLights", firstStage);
+	ShaderProgram_SetInt(program, "u_lightGridClusters", firstStage + 1);
+	ShaderProgram_SetInt(program, "u_lightGridIndices", firstStage + 2);
+	ShaderProgram_SetInt(program, "u_lightGridTilesX", int(grid.mParams.mTilesX));
+	ShaderProgram_SetInt(program, "u_lightGridTilesY", int(grid.mParams.mTilesY));
+	ShaderProgram_SetInt(program, "u_lightGridSlices", int(grid.mParams.mSlices));
+	// tile = fragment coordinate * xy, slice = log(depth) * z + w
+	ShaderProgram_SetVec4(program, "u_lightGridScale", float(grid.mParams.mTilesX) / float(std::max(viewportWidth, 1u)),
+		float(grid.mParams.mTilesY) / float(std::max(viewportHeight, 1u)), grid.mSliceScale, -std::log(grid.mNear) * grid.mSliceScale);
+}
+
+const uint16_t* LightGrid_GetClusterLights(const LightGrid& grid, uint32_t tileX, uint32_t tileY, uint32_t slice, uint32_t& count) {
+	count = 0;
+	if (tileX >= grid.mParams.mTilesX || tileY >= grid.mParams.mTilesY || slice >= grid.mParams.mSlices) {
+		return nullptr;
+	}
+	const uint32_t cluster = (slice * grid.mParams.mTilesY + tileY) * grid.mParams.mTilesX + tileX;
+	count = grid.mClusters[2 * cluster + 1];
+	return count > 0 ? &grid.mIndices[grid.mClusters[2 * cluster]] : nullptr;
+}
+
+const LightGridStats& LightGrid_GetStats(const LightGrid& grid) {
+	return grid.mStats;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Buffer.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <vector>
+
+// Light indices are stored on 16 bits.
+static constexpr uint32_t cLightGridMaxLights = 65535;
+static constexpr uint32_t cLightGridMaxTiles = 64;
+static constexpr uint32_t cLightGridMaxSlices = 64;
+
+// Point light with a finite range, the shaders fade it out smoothly at mRadius.
+struct PointLight {
+	glm::vec3 mPosition;
+	float mRadius = 1.0f;
+	glm::vec3 mColor = glm::vec3(1.0f);
+	float mIntensity = 1.0f;
+};
+
+// The view frustum is divided in mTilesX x mTilesY screen tiles and mSlices depth slices, exponentially spaced
+// so clusters keep roughly the same proportions at every distance.
+struct LightGridParams {
+	uint32_t mTilesX = 16;
+	uint32_t mTilesY = 9;
+	uint32_t mSlices = 24;
+};
+
+struct LightGridStats {
+	uint32_t mLights = 0;						// lights touching the frustum
+	uint32_t mIndices = 0;						// light references over all the clusters
+	uint32_t mMaxPerCluster = 0;
+	uint32_t mOccupiedClusters = 0;
+};
+
+// Screen tile rectangle covered by a light within one slice.
+struct LightGridRect {
+	uint16_t mLight;
+	uint8_t mMinX;
+	uint8_t mMaxX;
+	uint8_t mMinY;
+	uint8_t mMaxY;
+};
+
+struct LightGrid {
+	LightGridParams mParams;
+	float mNear = 0.1f;
+	float mFar = 100.0f;
+	float mSliceScale = 0.0f;					// slices / log(far / near)
+	std::vector<float> mSliceDepths;			// mSlices + 1 view depths
+	std::vector<float> mPlanesX;				// tan of the interior tile boundaries, padded with NaN to a multiple of 4
+	std::vector<float> mPlanesY;
+
+	// view space lights (SoA, padded to a multiple of 4) and their slice range, empty when the first is above the last
+	std::vector<float> mViewX;
+	std::vector<float> mViewY;
+	std::vector<float> mViewZ;
+	std::vector<float> mRadius;
+	std::vector<uint8_t> mFirstSlice;
+	std::vector<uint8_t> mLastSlice;
+
+	// per slice scratch, filled by one job each
+	std::vector<std::vector<LightGridRect>> mSliceRects;
+	std::vector<std::vector<uint16_t>> mSliceIndices;
+	std::vector<uint32_t> mSliceOffsets;
+
+	// GPU layout: 2 texels per light (view position and radius, color times intensity), an offset and count per
+	// cluster, then the light indices of every cluster one after the other
+	std::vector<glm::vec4> mLightData;
+	std::vector<uint32_t> mClusters;
+	std::vector<uint16_t> mIndices;
+
+	BufferHandle mLightBuffer = BufferHandle(cInvalidHandle);
+	BufferHandle mClusterBuffer = BufferHandle(cInvalidHandle);
+	BufferHandle mIndexBuffer = BufferHandle(cInvalidHandle);
+	TextureHandle mLightTexture = TextureHandle(cInvalidHandle);
+	TextureHandle mClusterTexture = TextureHandle(cInvalidHandle);
+	TextureHandle mIndexTexture = TextureHandle(cInvalidHandle);
+
+	LightGridStats mStats;
+};
+
+// Tiles and slices are clamped to cLightGridMaxTiles and cLightGridMaxSlices. CPU only, LightGrid_CreateTextures
+// adds the GL objects.
+void LightGrid_Initialize(LightGrid& grid, const LightGridParams& params = LightGridParams());
+
+void LightGrid_CreateTextures(LightGrid& grid);
+
+void LightGrid_Destroy(LightGrid& grid);
+
+// Assigns the lights (at most cLightGridMaxLights) to the clusters of the perspective camera. Lights are culled
+// and their depth range found 4 at a time with SSE, then every slice refines the tile rectangles of its lights
+// and builds its index lists; with threadsCount above 1 both steps run on the job system.
+void LightGrid_Build(LightGrid& grid, const PointLight* lights, uint32_t count, const glm::mat4& view, float fovY, float aspect, float nearPlane, float farPlane, uint32_t threadsCount);
+
+// GL thread only, uploads the data of the last build.
+void LightGrid_Upload(LightGrid& grid);
+
+// Binds the three texture buffers from firstStage on and sets the u_lightGrid* uniforms of 14-clustered.fs.
+void LightGrid_Bind(const LightGrid& grid, const ShaderProgramHandle& program, uint8_t firstStage, uint32_t viewportWidth, uint32_t viewportHeight);
+
+// Indices of the lights of a cluster, tile (0, 0) is the bottom left one as for gl_FragCoord.
+const uint16_t* LightGrid_GetClusterLights(const LightGrid& grid, uint32_t tileX, uint32_t tileY, uint32_t slice, uint32_t& count);
+
+const LightGridStats& LightGrid_GetStats(const LightGrid& grid);
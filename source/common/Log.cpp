@@ -1,5 +1,7 @@
 #include "Log.h"
 #include <cstdarg>
+#include <cstdio>
+#include <cstring>
 #include <memory>
 
 #if defined(_WIN32)
@@ -34,18 +36,27 @@ namespace {
 #endif
 		vsnprintf(buffer, 4095, formatString, argumentList);
 
-#if defined(_WIN32) && !defined(_CONSOLE)
+#if defined(_WIN32)
 		if (IsDebuggerPresent())
 		{
 			OutputDebugString(severityString);
 			OutputDebugString(buffer);
 			OutputDebugString("\n");
 		}
+		// console programs and redirected output, e.g. the benchmarks run by CI
+		HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
+		if (output != NULL && output != INVALID_HANDLE_VALUE)
+		{
+			printf("%s", severityString);
+			vprintf(formatString, tempList);
+			printf("\n");
+		}
 #else
-		printf("%s", messageTypes[severity]);
+		printf("%s", severityString);
 		vprintf(formatString, tempList);
 		printf("\n");
 #endif
+		va_end(tempList);
 #endif
 	}
 
@@ -0,0 +1,106 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+	Close();
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const char* filename) {
+	Close();
+	if (filename == nullptr) {
+		return false;
+	}
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		CloseHandle(file);
+		return false;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mData = static_cast<const uint8_t*>(data);
+	mSize = static_cast<size_t>(size.QuadPart);
+	mFile = reinterpret_cast<intptr_t>(file);
+	mMapping = reinterpret_cast<intptr_t>(mapping);
+	return true;
+}
+
+void MappedFile::Close() {
+	if (mData != nullptr) {
+		UnmapViewOfFile(mData);
+		CloseHandle(reinterpret_cast<HANDLE>(mMapping));
+		CloseHandle(reinterpret_cast<HANDLE>(mFile));
+	}
+	mData = nullptr;
+	mSize = 0;
+	mFile = -1;
+	mMapping = -1;
+}
+
+#else
+
+bool MappedFile::Open(const char* filename) {
+	Close();
+	if (filename == nullptr) {
+		return false;
+	}
+
+	int file = open(filename, O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0) {
+		close(file);
+		return false;
+	}
+	void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	if (data == MAP_FAILED) {
+		close(file);
+		return false;
+	}
+
+	mData = static_cast<const uint8_t*>(data);
+	mSize = static_cast<size_t>(info.st_size);
+	mFile = file;
+	return true;
+}
+
+void MappedFile::Close() {
+	if (mData != nullptr) {
+		munmap(const_cast<uint8_t*>(mData), mSize);
+		close(static_cast<int>(mFile));
+	}
+	mData = nullptr;
+	mSize = 0;
+	mFile = -1;
+	mMapping = -1;
+}
+
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "CommonDefine.h"
+
+class MappedFile final {
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const char* filename);
+	void Close();
+
+	const uint8_t* GetData() const { return mData; }
+	size_t GetSize() const { return mSize; }
+	bool IsOpen() const { return mData != nullptr; }
+
+private:
+	const uint8_t* mData = nullptr;
+	size_t mSize = 0;
+	intptr_t mFile = -1;
+	intptr_t mMapping = -1;
+};
@@ -0,0 +1,27 @@
+#include "Material.h"
+
+namespace
+{
+
+// Slots without a texture are unbound rather than skipped, the stage would keep the texture of the previous material.
+void ApplyStage(const ShaderProgramHandle& program, const char* name, const TextureHandle& texture, uint8_t stage) {
+	if (texture.IsValid()) {
+		Texture_Bind(texture, stage);
+	} else {
+		Texture_Unbind(stage);
+	}
+	ShaderProgram_SetInt(program, name, stage);
+}
+
+}
+
+void Material_Apply(const ShaderProgramHandle& program, const Material& material, uint8_t firstStage) {
+	if (!program.IsValid()) {
+		return;
+	}
+
+	ApplyStage(program, "u_material.diffuse", material.mDiffuse, firstStage);
+	ApplyStage(program, "u_material.specular", material.mSpecular, uint8_t(firstStage + 1));
+	ApplyStage(program, "u_material.emissive", material.mEmissive, uint8_t(firstStage + 2));
+	ShaderProgram_SetFloat(program, "u_material.shininess", material.mShininess);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+
+// Mirrors the u_material struct declared by the lighting shaders (05-lightingmaps.fs, 06-lights.fs).
+struct Material {
+	TextureHandle mDiffuse = TextureHandle(cInvalidHandle);
+	TextureHandle mSpecular = TextureHandle(cInvalidHandle);
+	TextureHandle mEmissive = TextureHandle(cInvalidHandle);
+	float mShininess = 32.0f;
+};
+
+// Diffuse, specular and emissive go to firstStage, firstStage + 1 and firstStage + 2; the stages of missing textures
+// are unbound.
+void Material_Apply(const ShaderProgramHandle& program, const Material& material, uint8_t firstStage = 0);
@@ -0,0 +1,292 @@
+#include "Mesh.h"
+
+#include "GLApi.h"
+#include <array>
+#include <vector>
+
+namespace
+{
+
+static const GLenum sComponentTypes[]{
+	GL_BYTE,						// Byte
+	GL_UNSIGNED_BYTE,				// UnsignedByte
+	GL_SHORT,						// Short
+	GL_UNSIGNED_SHORT,				// UnsignedShort
+	GL_UNSIGNED_INT,				// UnsignedInt
+	GL_FLOAT,						// Float
+};
+
+static const GLenum sIndexTypes[]{
+	GL_NONE,						// None
+	GL_UNSIGNED_BYTE,				// UInt8
+	GL_UNSIGNED_SHORT,				// UInt16
+	GL_UNSIGNED_INT,				// UInt32
+};
+
+static const GLenum sPrimitiveTypes[]{
+	GL_POINTS,						// Points
+	GL_LINES,						// Lines
+	GL_LINE_STRIP,					// LineStrip
+	GL_TRIANGLES,					// Triangles
+	GL_TRIANGLE_STRIP,				// TriangleStrip
+	GL_TRIANGLE_FAN,				// TriangleFan
+};
+
+// glBindVertexArray is skipped when the vertex array is already bound
+GLuint sBoundVertexArray = 0;
+
+// multi draw offsets moved by the index offset of the mesh
+std::vector<const void*> sOffsets;
+
+class Mesh {
+public:
+	Mesh() = default;
+	~Mesh() {
+		Destroy();
+	}
+
+	void Create(const MeshParams& params) {
+		glGenVertexArrays(1, &mId);
+		GL_ERROR(mId == 0);
+
+		GL_CHECK(glBindVertexArray(mId));
+		for (uint32_t i = 0; i < params.mAttributesCount; i++) {
+			const VertexAttribute& attribute = params.mAttributes[i];
+			if (attribute.mBufferIndex >= params.mVertexBuffersCount) {
+				continue;
+			}
+			GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, Buffer_GetNativeId(params.mVertexBuffers[attribute.mBufferIndex])));
+			if (attribute.mInteger) {
+				GL_CHECK(glVertexAttribIPointer(attribute.mLocation, attribute.mComponents, sComponentTypes[attribute.mType],
+					attribute.mStride, (const void*)(uintptr_t)attribute.mOffset));
+			} else {
+				GL_CHECK(glVertexAttribPointer(attribute.mLocation, attribute.mComponents, sComponentTypes[attribute.mType],
+					attribute.mNormalized ? GL_TRUE : GL_FALSE, attribute.mStride, (const void*)(uintptr_t)attribute.mOffset));
+			}
+			GL_CHECK(glEnableVertexAttribArray(attribute.mLocation));
+			if (attribute.mDivisor > 0) {
+				GL_CHECK(glVertexAttribDivisor(attribute.mLocation, attribute.mDivisor));
+			}
+		}
+		if (params.mIndexFormat != IndexFormat::None) {
+			GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, Buffer_GetNativeId(params.mIndexBuffer)));
+		}
+		GL_CHECK(glBindVertexArray(0));
+		GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, 0));
+		sBoundVertexArray = 0;
+
+		mPrimitiveType = sPrimitiveTypes[params.mPrimitiveType];
+		mIndexType = sIndexTypes[params.mIndexFormat];
+		mIndexOffset = params.mIndexOffset;
+		mIndexCount = params.mIndexCount;
+		mVertexCount = params.mVertexCount;
+	}
+
+	void Destroy() {
+		if (IsValid()) {
+			GL_CHECK(glDeleteVertexArrays(1, &mId));
+			if (sBoundVertexArray == mId) {
+				sBoundVertexArray = 0;
+			}
+			mId = 0;
+		}
+	}
+
+	void Bind() {
+		if (IsValid() && sBoundVertexArray != mId) {
+			GL_CHECK(glBindVertexArray(mId));
+			sBoundVertexArray = mId;
+		}
+	}
+
+	void Draw() {
+		if (IsValid()) {
+			if (mIndexType != GL_NONE) {
+				GL_CHECK(glDrawElements(mPrimitiveType, mIndexCount, mIndexType, (const void*)(uintptr_t)mIndexOffset));
+			} else {
+				GL_CHECK(glDrawArrays(mPrimitiveType, 0, mVertexCount));
+			}
+		}
+	}
+
+	void DrawInstanced(uint32_t instanceCount) {
+		if (IsValid() && instanceCount > 0) {
+			if (mIndexType != GL_NONE) {
+				GL_CHECK(glDrawElementsInstanced(mPrimitiveType, mIndexCount, mIndexType, (const void*)(uintptr_t)mIndexOffset, instanceCount));
+			} else {
+				GL_CHECK(glDrawArraysInstanced(mPrimitiveType, 0, mVertexCount, instanceCount));
+			}
+		}
+	}
+
+	void DrawRange(uint32_t firstIndex, uint32_t indexCount) {
+		if (IsValid() && mIndexType != GL_NONE) {
+			uint32_t offset = mIndexOffset + firstIndex * GetIndexSize();
+			GL_CHECK(glDrawElements(mPrimitiveType, indexCount, mIndexType, (const void*)(uintptr_t)offset));
+		}
+	}
+
+	void MultiDraw(const int32_t* counts, const void* const* offsets, uint32_t drawCount) {
+		if (IsValid() && mIndexType != GL_NONE && drawCount > 0) {
+			if (mIndexOffset != 0) {
+				sOffsets.resize(drawCount);
+				for (uint32_t i = 0; i < drawCount; i++) {
+					sOffsets[i] = (const void*)((uintptr_t)offsets[i] + mIndexOffset);
+				}
+				offsets = sOffsets.data();
+			}
+			GL_CHECK(glMultiDrawElements(mPrimitiveType, counts, mIndexType, offsets, drawCount));
+		}
+	}
+
+	void MultiDrawIndirect(GLuint commands, uint32_t drawCount, uint32_t offset) {
+		if (IsValid() && mIndexType != GL_NONE && drawCount > 0) {
+			GL_CHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands));
+			GL_CHECK(glMultiDrawElementsIndirect(mPrimitiveType, mIndexType, (const void*)(uintptr_t)offset, drawCount, sizeof(DrawElementsIndirectCommand)));
+			GL_CHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+		}
+	}
+
+	void DrawCommands(const DrawElementsIndirectCommand* commands, uint32_t drawCount) {
+		if (IsValid() && mIndexType != GL_NONE) {
+			const uint32_t indexSize = GetIndexSize();
+			for (uint32_t i = 0; i < drawCount; i++) {
+				const DrawElementsIndirectCommand& command = commands[i];
+				if (command.mCount == 0 || command.mInstanceCount == 0) {
+					continue;
+				}
+				const void* offset = (const void*)(uintptr_t)(mIndexOffset + command.mFirstIndex * indexSize);
+				if (command.mBaseInstance == 0) {
+					GL_CHECK(glDrawElementsInstancedBaseVertex(mPrimitiveType, command.mCount, mIndexType, offset, command.mInstanceCount,
+						command.mBaseVertex));
+				} else if (GLAD_GL_VERSION_4_2 != 0) {
+					GL_CHECK(glDrawElementsInstancedBaseVertexBaseInstance(mPrimitiveType, command.mCount, mIndexType, offset,
+						command.mInstanceCount, command.mBaseVertex, command.mBaseInstance));
+				}
+			}
+		}
+	}
+
+	bool IsValid() const {
+		return mId > 0;
+	}
+
+	uint32_t GetIndexSize() const {
+		return (mIndexType == GL_UNSIGNED_INT) ? 4 : (mIndexType == GL_UNSIGNED_SHORT) ? 2 : 1;
+	}
+
+	uint32_t GetFirstIndex() const {
+		return (mIndexType != GL_NONE) ? mIndexOffset / GetIndexSize() : 0;
+	}
+
+private:
+	GLuint mId = 0;
+	GLenum mPrimitiveType = GL_TRIANGLES;
+	GLenum mIndexType = GL_NONE;
+	uint32_t mIndexOffset = 0;
+	uint32_t mIndexCount = 0;
+	uint32_t mVertexCount = 0;
+};
+
+static constexpr uint32_t cMaxMeshHandles = (1 << 10);
+uint32_t sMeshesCount = 0;
+std::array<Mesh, cMaxMeshHandles> sMeshes;
+
+}
+
+MeshHandle Mesh_Create(const MeshParams& params) {
+	if (params.mAttributesCount == 0 || sMeshesCount >= cMaxMeshHandles) {
+		return MeshHandle(cInvalidHandle);
+	}
+
+	MeshHandle handle = MeshHandle(sMeshesCount);
+	auto& mesh = sMeshes[handle.mHandle];
+	mesh.Create(params);
+
+	if (mesh.IsValid()) {
+		sMeshesCount++;
+		return handle;
+	}
+	return MeshHandle(cInvalidHandle);
+}
+
+void Mesh_Destroy(const MeshHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& mesh = sMeshes[handle.mHandle];
+	mesh.Destroy();
+}
+
+void Mesh_Bind(const MeshHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& mesh = sMeshes[handle.mHandle];
+	mesh.Bind();
+}
+
+uint32_t Mesh_GetFirstIndex(const MeshHandle& handle) {
+	if (!handle.IsValid()) {
+		return 0;
+	}
+	return sMeshes[handle.mHandle].GetFirstIndex();
+}
+
+void Mesh_InvalidateCache() {
+	sBoundVertexArray = 0;
+}
+
+void Mesh_Draw(const MeshHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& mesh = sMeshes[handle.mHandle];
+	mesh.Bind();
+	mesh.Draw();
+}
+
+void Mesh_DrawInstanced(const MeshHandle& handle, uint32_t instanceCount) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& mesh = sMeshes[handle.mHandle];
+	mesh.Bind();
+	mesh.DrawInstanced(instanceCount);
+}
+
+void Mesh_DrawRange(const MeshHandle& handle, uint32_t firstIndex, uint32_t indexCount) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& mesh = sMeshes[handle.mHandle];
+	mesh.Bind();
+	mesh.DrawRange(firstIndex, indexCount);
+}
+
+void Mesh_MultiDraw(const MeshHandle& handle, const int32_t* counts, const void* const* offsets, uint32_t drawCount) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& mesh = sMeshes[handle.mHandle];
+	mesh.Bind();
+	mesh.MultiDraw(counts, offsets, drawCount);
+}
+
+void Mesh_MultiDrawIndirect(const MeshHandle& handle, const BufferHandle& commands, uint32_t drawCount, uint32_t offset) {
+	if (!handle.IsValid() || !commands.IsValid()) {
+		return;
+	}
+	auto& mesh = sMeshes[handle.mHandle];
+	mesh.Bind();
+	mesh.MultiDrawIndirect(Buffer_GetNativeId(commands), drawCount, offset);
+}
+
+void Mesh_DrawCommands(const MeshHandle& handle, const DrawElementsIndirectCommand* commands, uint32_t drawCount) {
+	if (!handle.IsValid() || commands == nullptr) {
+		return;
+	}
+	auto& mesh = sMeshes[handle.mHandle];
+	mesh.Bind();
+	mesh.DrawCommands(commands, drawCount);
+}
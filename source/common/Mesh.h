@@ -0,0 +1,111 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Buffer.h"
+
+struct VertexComponentType {
+	enum Enum {
+		Byte,
+		UnsignedByte,
+		Short,
+		UnsignedShort,
+		UnsignedInt,
+		Float,
+		Count
+	};
+};
+
+struct IndexFormat {
+	enum Enum {
+		None,
+		UInt8,
+		UInt16,
+		UInt32,
+		Count
+	};
+};
+
+struct PrimitiveType {
+	enum Enum {
+		Points,
+		Lines,
+		LineStrip,
+		Triangles,
+		TriangleStrip,
+		TriangleFan,
+		Count
+	};
+};
+
+struct VertexAttribute {
+	uint8_t mLocation = 0;
+	uint8_t mBufferIndex = 0;
+	uint8_t mComponents = 0;
+	bool mNormalized = false;
+	bool mInteger = false;				// fetched as ivec/uvec in the shader, mNormalized is ignored
+	VertexComponentType::Enum mType = VertexComponentType::Float;
+	uint32_t mOffset = 0;
+	uint32_t mStride = 0;
+	uint32_t mDivisor = 0;
+};
+
+static constexpr uint32_t cMaxMeshVertexBuffers = 8;
+static constexpr uint32_t cMaxMeshVertexAttributes = 12;
+
+struct MeshParams {
+	BufferHandle mVertexBuffers[cMaxMeshVertexBuffers];
+	uint32_t mVertexBuffersCount = 0;
+
+	VertexAttribute mAttributes[cMaxMeshVertexAttributes];
+	uint32_t mAttributesCount = 0;
+
+	BufferHandle mIndexBuffer = BufferHandle(cInvalidHandle);
+	IndexFormat::Enum mIndexFormat = IndexFormat::None;
+	uint32_t mIndexOffset = 0;
+	uint32_t mIndexCount = 0;
+
+	uint32_t mVertexCount = 0;
+	PrimitiveType::Enum mPrimitiveType = PrimitiveType::Triangles;
+};
+
+// Layout mandated by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+	uint32_t mCount;
+	uint32_t mInstanceCount;
+	uint32_t mFirstIndex;
+	int32_t mBaseVertex;
+	uint32_t mBaseInstance;
+};
+
+using MeshHandle = ResourceHandle;
+
+MeshHandle Mesh_Create(const MeshParams& params);
+
+void Mesh_Destroy(const MeshHandle& handle);
+
+void Mesh_Bind(const MeshHandle& handle);
+
+// MeshParams::mIndexOffset in indices, what indirect commands add to their first index.
+uint32_t Mesh_GetFirstIndex(const MeshHandle& handle);
+
+// Forgets the bound vertex array, to be called after glBindVertexArray was called outside of this module.
+void Mesh_InvalidateCache();
+
+void Mesh_Draw(const MeshHandle& handle);
+
+void Mesh_DrawRange(const MeshHandle& handle, uint32_t firstIndex, uint32_t indexCount);
+
+void Mesh_DrawInstanced(const MeshHandle& handle, uint32_t instanceCount);
+
+// Draws index ranges of an indexed mesh in one call, offsets are in bytes from the first index of the mesh
+// (MeshParams::mIndexOffset).
+void Mesh_MultiDraw(const MeshHandle& handle, const int32_t* counts, const void* const* offsets, uint32_t drawCount);
+
+// The GPU reads the first index of the commands as it is, from the start of the index buffer: commands written for
+// a mesh with an index offset must add Mesh_GetFirstIndex to it.
+void Mesh_MultiDrawIndirect(const MeshHandle& handle, const BufferHandle& commands, uint32_t drawCount, uint32_t offset = 0);
+
+// Issues the commands one by one from client memory, for contexts without glMultiDrawElementsIndirect. Like
+// Mesh_DrawRange the first index of the commands counts from the first index of the mesh. Commands with a base
+// instance other than 0 require GL 4.2 and are skipped without it.
+void Mesh_DrawCommands(const MeshHandle& handle, const DrawElementsIndirectCommand* commands, uint32_t drawCount);
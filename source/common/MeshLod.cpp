@@ -0,0 +1,355 @@
+#include "MeshLod.h"
+
+#include "glm/geometric.hpp"
+#include "glm/trigonometric.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+
+struct Quadric {
+	float mA00 = 0.0f, mA11 = 0.0f, mA22 = 0.0f;
+	float mA10 = 0.0f, mA20 = 0.0f, mA21 = 0.0f;
+	float mB0 = 0.0f, mB1 = 0.0f, mB2 = 0.0f;
+	float mC = 0.0f;
+	float mWeight = 0.0f;
+
+	void AddPlane(const glm::vec3& n, float d, float weight) {
+		mA00 += weight * n.x * n.x;
+		mA11 += weight * n.y * n.y;
+		mA22 += weight * n.z * n.z;
+		mA10 += weight * n.y * n.x;
+		mA20 += weight * n.z * n.x;
+		mA21 += weight * n.z * n.y;
+		mB0 += weight * n.x * d;
+		mB1 += weight * n.y * d;
+		mB2 += weight * n.z * d;
+		mC += weight * d * d;
+		mWeight += weight;
+	}
+
+	void Add(const Quadric& q) {
+		mA00 += q.mA00; mA11 += q.mA11; mA22 += q.mA22;
+		mA10 += q.mA10; mA20 += q.mA20; mA21 += q.mA21;
+		mB0 += q.mB0; mB1 += q.mB1; mB2 += q.mB2;
+		mC += q.mC;
+		mWeight += q.mWeight;
+	}
+
+	// mean squared distance of p from the accumulated planes
+	float Evaluate(const glm::vec3& p) const {
+		float rx = mA00 * p.x + mA10 * p.y + mA20 * p.z + 2.0f * mB0;
+		float ry = mA10 * p.x + mA11 * p.y + mA21 * p.z + 2.0f * mB1;
+		float rz = mA20 * p.x + mA21 * p.y + mA22 * p.z + 2.0f * mB2;
+		float error = rx * p.x + ry * p.y + rz * p.z + mC;
+		return (mWeight > 0.0f) ? std::fabs(error) / mWeight : 0.0f;
+	}
+};
+
+struct Collapse {
+	uint32_t mFrom;
+	uint32_t mTo;
+	float mCost;
+};
+
+struct SimplifyContext {
+	const SimplifyParams& mParams;
+	std::vector<uint8_t> mLocked;
+	std::vector<Quadric> mQuadrics;
+
+	explicit SimplifyContext(const SimplifyParams& params) : mParams(params) {}
+
+	glm::vec3 GetPosition(uint32_t vertex) const {
+		const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(mParams.mPositions) + size_t(vertex) * mParams.mPositionStride);
+		return glm::vec3(p[0], p[1], p[2]);
+	}
+
+	float GetAttributeDistance(uint32_t a, uint32_t b) const {
+		if (mParams.mAttributes == nullptr) {
+			return 0.0f;
+		}
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(mParams.mAttributes);
+		const float* va = reinterpret_cast<const float*>(base + size_t(a) * mParams.mAttributeStride);
+		const float* vb = reinterpret_cast<const float*>(base + size_t(b) * mParams.mAttributeStride);
+		float distance = 0.0f;
+		for (uint32_t i = 0; i < mParams.mAttributeComponents; i++) {
+			distance += (va[i] - vb[i]) * (va[i] - vb[i]);
+		}
+		return distance;
+	}
+};
+
+// Vertices that share a position with another vertex sit on an attribute seam, vertices on an edge used by a single
+// triangle sit on a border. Both are kept in place so seams do not tear and borders between meshes stay watertight.
+void ClassifyVertices(SimplifyContext& context, const std::vector<uint32_t>& indices) {
+	const SimplifyParams& params = context.mParams;
+	const uint32_t vertexCount = params.mVertexCount;
+
+	std::vector<uint32_t> order(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; i++) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&context](uint32_t a, uint32_t b) {
+		glm::vec3 pa = context.GetPosition(a);
+		glm::vec3 pb = context.GetPosition(b);
+		return (pa.x != pb.x) ? pa.x < pb.x : (pa.y != pb.y) ? pa.y < pb.y : pa.z < pb.z;
+	});
+
+	std::vector<uint32_t> canonical(vertexCount);
+	context.mLocked.assign(vertexCount, 0);
+	for (uint32_t i = 0; i < vertexCount;) {
+		uint32_t j = i + 1;
+		while (j < vertexCount && context.GetPosition(order[j]) == context.GetPosition(order[i])) {
+			j++;
+		}
+		for (uint32_t k = i; k < j; k++) {
+			canonical[order[k]] = order[i];
+			context.mLocked[order[k]] = (j - i > 1) ? 1 : 0;
+		}
+		i = j;
+	}
+
+	if (!params.mLockBorders) {
+		return;
+	}
+	std::vector<uint64_t> edges;
+	edges.reserve(indices.size());
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		for (uint32_t e = 0; e < 3; e++) {
+			uint32_t a = canonical[indices[i + e]];
+			uint32_t b = canonical[indices[i + (e + 1) % 3]];
+			edges.push_back((uint64_t(std::min(a, b)) << 32) | std::max(a, b));
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	std::vector<uint8_t> border(vertexCount, 0);
+	for (size_t i = 0; i < edges.size();) {
+		size_t j = i + 1;
+		while (j < edges.size() && edges[j] == edges[i]) {
+			j++;
+		}
+		if (j - i == 1) {
+			border[uint32_t(edges[i] >> 32)] = 1;
+			border[uint32_t(edges[i] & 0xffffffffu)] = 1;
+		}
+		i = j;
+	}
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		context.mLocked[v] |= border[canonical[v]];
+	}
+}
+
+void ComputeQuadrics(SimplifyContext& context, const std::vector<uint32_t>& indices) {
+	context.mQuadrics.assign(context.mParams.mVertexCount, Quadric());
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		glm::vec3 p0 = context.GetPosition(indices[i + 0]);
+		glm::vec3 p1 = context.GetPosition(indices[i + 1]);
+		glm::vec3 p2 = context.GetPosition(indices[i + 2]);
+		glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+		float area = glm::length(n);
+		if (area <= 0.0f) {
+			continue;
+		}
+		n /= area;
+		float d = -glm::dot(n, p0);
+		for (uint32_t k = 0; k < 3; k++) {
+			context.mQuadrics[indices[i + k]].AddPlane(n, d, area);
+		}
+	}
+}
+
+bool FlipsTriangle(const SimplifyContext& context, const uint32_t* triangle, uint32_t from, uint32_t to) {
+	glm::vec3 p[3];
+	glm::vec3 q[3];
+	for (uint32_t k = 0; k < 3; k++) {
+		p[k] = context.GetPosition(triangle[k]);
+		q[k] = context.GetPosition(triangle[k] == from ? to : triangle[k]);
+	}
+	glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+	glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+	return glm::dot(before, after) <= 0.0f;
+}
+
+}
+
+float MeshLod_Simplify(const SimplifyParams& params, uint32_t targetIndexCount, float maxError, std::vector<uint32_t>& result) {
+	result.assign(params.mIndices, params.mIndices + params.mIndexCount);
+	if (params.mPositions == nullptr || params.mIndexCount % 3 != 0 || params.mIndexCount <= targetIndexCount) {
+		return 0.0f;
+	}
+
+	SimplifyContext context(params);
+	ClassifyVertices(context, result);
+	ComputeQuadrics(context, result);
+
+	const uint32_t vertexCount = params.mVertexCount;
+	const float maxCost = maxError * maxError;
+	float resultCost = 0.0f;
+
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<uint8_t> touched(vertexCount);
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+
+	while (result.size() > targetIndexCount) {
+		// candidate half edge collapses, cheapest first
+		collapses.clear();
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (uint32_t e = 0; e < 3; e++) {
+				uint32_t a = result[i + e];
+				uint32_t b = result[i + (e + 1) % 3];
+				if (!context.mLocked[a]) {
+					float cost = context.mQuadrics[a].Evaluate(context.GetPosition(b)) + params.mAttributeWeight * context.GetAttributeDistance(a, b);
+					collapses.push_back(Collapse{ a, b, cost });
+				}
+				if (!context.mLocked[b]) {
+					float cost = context.mQuadrics[b].Evaluate(context.GetPosition(a)) + params.mAttributeWeight * context.GetAttributeDistance(a, b);
+					collapses.push_back(Collapse{ b, a, cost });
+				}
+			}
+		}
+		if (collapses.empty()) {
+			break;
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.mCost < b.mCost; });
+
+		// vertex -> triangles adjacency for the flip test
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : result) {
+			adjacencyOffsets[index + 1]++;
+		}
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		}
+		adjacency.resize(result.size());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < result.size(); i++) {
+			adjacency[fill[result[i]]++] = uint32_t(i / 3);
+		}
+
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			remap[v] = v;
+		}
+		std::fill(touched.begin(), touched.end(), 0);
+
+		// apply independent collapses until the pass would overshoot the target
+		size_t triangles = result.size() / 3;
+		const size_t targetTriangles = targetIndexCount / 3;
+		uint32_t applied = 0;
+		for (const Collapse& collapse : collapses) {
+			if (triangles <= targetTriangles || collapse.mCost > maxCost) {
+				break;
+			}
+			if (touched[collapse.mFrom] || touched[collapse.mTo]) {
+				continue;
+			}
+
+			bool valid = true;
+			uint32_t removed = 0;
+			for (uint32_t a = adjacencyOffsets[collapse.mFrom]; a < adjacencyOffsets[collapse.mFrom + 1] && valid; a++) {
+				const uint32_t* triangle = &result[adjacency[a] * 3];
+				if (triangle[0] == collapse.mTo || triangle[1] == collapse.mTo || triangle[2] == collapse.mTo) {
+					removed++;
+				} else {
+					valid = !FlipsTriangle(context, triangle, collapse.mFrom, collapse.mTo);
+				}
+			}
+			if (!valid || removed == 0) {
+				continue;
+			}
+
+			remap[collapse.mFrom] = collapse.mTo;
+			context.mQuadrics[collapse.mTo].Add(context.mQuadrics[collapse.mFrom]);
+			resultCost = std::max(resultCost, collapse.mCost);
+			for (uint32_t a = adjacencyOffsets[collapse.mFrom]; a < adjacencyOffsets[collapse.mFrom + 1]; a++) {
+				const uint32_t* triangle = &result[adjacency[a] * 3];
+				touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+			}
+			triangles -= removed;
+			applied++;
+		}
+		if (applied == 0) {
+			break;
+		}
+
+		// remap and drop the triangles that became degenerate
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3) {
+			uint32_t a = remap[result[i + 0]];
+			uint32_t b = remap[result[i + 1]];
+			uint32_t c = remap[result[i + 2]];
+			if (a != b && b != c && a != c) {
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+		}
+		result.resize(write);
+	}
+	return std::sqrt(resultCost);
+}
+
+bool MeshLod_BuildChain(const SimplifyParams& params, const float* ratios, uint32_t ratiosCount, MeshLodChain& chain) {
+	chain.mIndices.assign(params.mIndices, params.mIndices + params.mIndexCount);
+	chain.mLevels.clear();
+	chain.mLevels.push_back(MeshLodLevel{ 0, params.mIndexCount, 0.0f });
+
+	std::vector<uint32_t> lod;
+	SimplifyParams levelParams = params;
+	float error = 0.0f;
+	for (uint32_t i = 0; i < ratiosCount; i++) {
+		const MeshLodLevel& previous = chain.mLevels.back();
+		uint32_t target = uint32_t(float(params.mIndexCount / 3) * ratios[i]) * 3;
+		if (target >= previous.mIndexCount) {
+			continue;
+		}
+		// each level starts from the previous one, errors are accumulated so they stay monotonic
+		std::vector<uint32_t> source(chain.mIndices.begin() + previous.mFirstIndex, chain.mIndices.begin() + previous.mFirstIndex + previous.mIndexCount);
+		levelParams.mIndices = source.data();
+		levelParams.mIndexCount = previous.mIndexCount;
+		error += MeshLod_Simplify(levelParams, target, FLT_MAX, lod);
+		if (lod.size() >= previous.mIndexCount) {
+			break;
+		}
+		chain.mLevels.push_back(MeshLodLevel{ uint32_t(chain.mIndices.size()), uint32_t(lod.size()), error });
+		chain.mIndices.insert(chain.mIndices.end(), lod.begin(), lod.end());
+	}
+	return chain.mLevels.size() > 1;
+}
+
+float MeshLod_GetProjectionScale(const Camera& camera, uint32_t viewportHeight) {
+	return float(viewportHeight) / (2.0f * std::tan(glm::radians(camera.GetFOV()) * 0.5f));
+}
+
+uint32_t MeshLod_Select(const MeshLodChain& chain, uint32_t currentLevel, float distance, float objectScale, float projectionScale,
+		float maxPixelError, float hysteresis) {
+	const uint32_t count = static_cast<uint32_t>(chain.mLevels.size());
+	if (count == 0) {
+		return 0;
+	}
+	const float pixelsPerUnit = objectScale * projectionScale / std::max(distance, 1e-4f);
+
+	uint32_t level = std::min(currentLevel, count - 1);
+	while (level > 0 && chain.mLevels[level].mError * pixelsPerUnit > maxPixelError) {
+		level--;
+	}
+	while (level + 1 < count && chain.mLevels[level + 1].mError * pixelsPerUnit <= maxPixelError * (1.0f - hysteresis)) {
+		level++;
+	}
+	return level;
+}
+
+uint32_t MeshLod_Draw(const MeshLodChain& chain, const MeshHandle& mesh, MeshLodInstance& instance, float distance, float objectScale,
+		float projectionScale, float maxPixelError, float hysteresis) {
+	if (chain.mLevels.empty()) {
+		return 0;
+	}
+	instance.mLevel = MeshLod_Select(chain, instance.mLevel, distance, objectScale, projectionScale, maxPixelError, hysteresis);
+	const MeshLodLevel& level = chain.mLevels[instance.mLevel];
+	Mesh_DrawRange(mesh, level.mFirstIndex, level.mIndexCount);
+	return instance.mLevel;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Camera.h"
+#include "Mesh.h"
+
+#include <vector>
+
+struct SimplifyParams {
+	const float* mPositions = nullptr;
+	uint32_t mPositionStride = 0;
+	uint32_t mVertexCount = 0;
+
+	// optional per vertex attributes (normals, texture coordinates) folded into the collapse cost
+	const float* mAttributes = nullptr;
+	uint32_t mAttributeStride = 0;
+	uint32_t mAttributeComponents = 0;
+	float mAttributeWeight = 0.5f;
+
+	const uint32_t* mIndices = nullptr;
+	uint32_t mIndexCount = 0;
+
+	bool mLockBorders = true;
+};
+
+// Quadric error edge collapse. Vertices are never moved or created, so the result indexes the source vertices.
+// Returns the geometric error of the simplified mesh in object space units.
+float MeshLod_Simplify(const SimplifyParams& params, uint32_t targetIndexCount, float maxError, std::vector<uint32_t>& result);
+
+struct MeshLodLevel {
+	uint32_t mFirstIndex;
+	uint32_t mIndexCount;
+	float mError;
+};
+
+// All the levels share the source vertex buffer, their index lists are stored back to back in mIndices.
+struct MeshLodChain {
+	std::vector<uint32_t> mIndices;
+	std::vector<MeshLodLevel> mLevels;
+};
+
+bool MeshLod_BuildChain(const SimplifyParams& params, const float* ratios, uint32_t ratiosCount, MeshLodChain& chain);
+
+// Pixels covered by one object space unit at distance 1 for the camera field of view and the viewport height.
+float MeshLod_GetProjectionScale(const Camera& camera, uint32_t viewportHeight);
+
+// Picks the coarsest level whose projected error stays under maxPixelError. Moving to a coarser level requires the error
+// to drop below maxPixelError * (1 - hysteresis), so objects hovering around a threshold do not pop back and forth.
+uint32_t MeshLod_Select(const MeshLodChain& chain, uint32_t currentLevel, float distance, float objectScale, float projectionScale,
+	float maxPixelError = 1.0f, float hysteresis = 0.25f);
+
+// Per object state of an object drawn with MeshLod_Draw, the level it was drawn with last time feeds the hysteresis
+// of the next selection.
+struct MeshLodInstance {
+	uint32_t mLevel = 0;
+};
+
+// Selects the level of the instance with MeshLod_Select and draws its index range from mesh, which holds
+// chain.mIndices as 32-bit indices. Returns the level drawn.
+uint32_t MeshLod_Draw(const MeshLodChain& chain, const MeshHandle& mesh, MeshLodInstance& instance, float distance, float objectScale,
+	float projectionScale, float maxPixelError = 1.0f, float hysteresis = 0.25f);
@@ -0,0 +1,325 @@
+#include "Meshlet.h"
+
+#include "GLApi.h"
+#include "glm/geometric.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+constexpr uint32_t cGpuGroupSize = 64;
+
+const char* cPlaneUniforms[FrustumPlane::Count] = {
+	"u_planes[0]", "u_planes[1]", "u_planes[2]", "u_planes[3]", "u_planes[4]", "u_planes[5]"
+};
+
+// std430 layout consumed by meshlet_cull.cs
+struct GpuMeshlet {
+	float mSphere[4];
+	float mCone[4];
+	uint32_t mFirstIndex;
+	uint32_t mIndexCount;
+	uint32_t mPadding[2];
+};
+
+glm::vec3 GetPosition(const float* positions, uint32_t positionStride, uint32_t vertex) {
+	const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + size_t(vertex) * positionStride);
+	return glm::vec3(p[0], p[1], p[2]);
+}
+
+void ComputeBounds(const float* positions, uint32_t positionStride, const uint32_t* vertices, uint32_t verticesCount,
+		const uint32_t* indices, uint32_t indexCount, MeshletTable& table) {
+	// Ritter bounding sphere: start from the two most distant points found by two sweeps, then grow
+	glm::vec3 a = GetPosition(positions, positionStride, vertices[0]);
+	glm::vec3 b = a;
+	float distance = 0.0f;
+	for (uint32_t i = 0; i < verticesCount; i++) {
+		glm::vec3 p = GetPosition(positions, positionStride, vertices[i]);
+		float d = glm::dot(p - a, p - a);
+		if (d > distance) {
+			distance = d;
+			b = p;
+		}
+	}
+	glm::vec3 c = b;
+	distance = 0.0f;
+	for (uint32_t i = 0; i < verticesCount; i++) {
+		glm::vec3 p = GetPosition(positions, positionStride, vertices[i]);
+		float d = glm::dot(p - b, p - b);
+		if (d > distance) {
+			distance = d;
+			c = p;
+		}
+	}
+	glm::vec3 center = (b + c) * 0.5f;
+	float radius = std::sqrt(distance) * 0.5f;
+	for (uint32_t i = 0; i < verticesCount; i++) {
+		glm::vec3 p = GetPosition(positions, positionStride, vertices[i]);
+		float d = glm::length(p - center);
+		if (d > radius) {
+			float newRadius = (radius + d) * 0.5f;
+			center += (p - center) * ((newRadius - radius) / d);
+			radius = newRadius;
+		}
+	}
+
+	// normal cone: average triangle normal and the widest deviation from it
+	glm::vec3 normals[cMeshletMaxTriangles];
+	uint32_t normalsCount = 0;
+	glm::vec3 axis(0.0f);
+	for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+		glm::vec3 p0 = GetPosition(positions, positionStride, indices[i + 0]);
+		glm::vec3 p1 = GetPosition(positions, positionStride, indices[i + 1]);
+		glm::vec3 p2 = GetPosition(positions, positionStride, indices[i + 2]);
+		glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(n);
+		if (length > 0.0f) {
+			normals[normalsCount] = n / length;
+			axis += normals[normalsCount];
+			normalsCount++;
+		}
+	}
+	float cutoff = 1.0f;
+	float axisLength = glm::length(axis);
+	if (axisLength > 0.0f) {
+		axis /= axisLength;
+		float minDot = 1.0f;
+		for (uint32_t i = 0; i < normalsCount; i++) {
+			minDot = std::min(minDot, glm::dot(normals[i], axis));
+		}
+		// cones wider than ~84 degrees never pass the backface test, keep them always visible
+		cutoff = (minDot <= 0.1f) ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+	}
+
+	table.mCenterX.push_back(center.x);
+	table.mCenterY.push_back(center.y);
+	table.mCenterZ.push_back(center.z);
+	table.mRadius.push_back(radius);
+	table.mConeAxisX.push_back(axis.x);
+	table.mConeAxisY.push_back(axis.y);
+	table.mConeAxisZ.push_back(axis.z);
+	table.mConeCutoff.push_back(cutoff);
+}
+
+}
+
+bool Meshlet_Build(const float* positions, uint32_t positionStride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, MeshletTable& table) {
+	if (positions == nullptr || indices == nullptr || indexCount == 0 || (indexCount % 3) != 0) {
+		return false;
+	}
+	for (uint32_t i = 0; i < indexCount; i++) {
+		if (indices[i] >= vertexCount) {
+			return false;
+		}
+	}
+
+	const uint32_t trianglesCount = indexCount / 3;
+
+	// vertex -> triangles adjacency
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	std::vector<uint32_t> adjacency(indexCount);
+	for (uint32_t i = 0; i < indexCount; i++) {
+		adjacencyOffsets[indices[i] + 1]++;
+	}
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+	}
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (uint32_t i = 0; i < indexCount; i++) {
+		adjacency[fill[indices[i]]++] = i / 3;
+	}
+
+	table = MeshletTable();
+	table.mIndices.reserve(indexCount);
+
+	std::vector<uint8_t> emitted(trianglesCount, 0);
+	std::vector<uint32_t> vertexMeshlet(vertexCount, cInvalidHandle);
+	std::vector<uint32_t> candidates;
+	candidates.reserve(cMeshletMaxVertices * 8);
+
+	uint32_t meshletVertices[cMeshletMaxVertices];
+	uint32_t seed = 0;
+	while (true) {
+		while (seed < trianglesCount && emitted[seed]) {
+			seed++;
+		}
+		if (seed == trianglesCount) {
+			break;
+		}
+
+		const uint32_t meshlet = table.GetCount();
+		const uint32_t firstIndex = static_cast<uint32_t>(table.mIndices.size());
+		uint32_t verticesCount = 0;
+		uint32_t meshletTriangles = 0;
+		glm::vec3 centroid(0.0f);
+		candidates.clear();
+
+		uint32_t triangle = seed;
+		while (triangle != cInvalidHandle) {
+			emitted[triangle] = 1;
+			meshletTriangles++;
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t v = indices[triangle * 3 + k];
+				table.mIndices.push_back(v);
+				if (vertexMeshlet[v] != meshlet) {
+					vertexMeshlet[v] = meshlet;
+					meshletVertices[verticesCount++] = v;
+					centroid += GetPosition(positions, positionStride, v);
+					candidates.insert(candidates.end(), adjacency.begin() + adjacencyOffsets[v], adjacency.begin() + adjacencyOffsets[v + 1]);
+				}
+			}
+			if (meshletTriangles == cMeshletMaxTriangles) {
+				break;
+			}
+
+			// grow towards the adjacent triangle that adds the fewest new vertices, ties go to the one closest
+			// to the cluster centroid to keep the bounds tight
+			triangle = cInvalidHandle;
+			uint32_t bestNewVertices = 4;
+			float bestDistance = 0.0f;
+			glm::vec3 center = centroid / float(verticesCount);
+			for (size_t c = 0; c < candidates.size();) {
+				uint32_t candidate = candidates[c];
+				if (emitted[candidate]) {
+					candidates[c] = candidates.back();
+					candidates.pop_back();
+					continue;
+				}
+				c++;
+				uint32_t newVertices = 0;
+				glm::vec3 triangleCenter(0.0f);
+				for (uint32_t k = 0; k < 3; k++) {
+					uint32_t v = indices[candidate * 3 + k];
+					newVertices += (vertexMeshlet[v] != meshlet) ? 1 : 0;
+					triangleCenter += GetPosition(positions, positionStride, v);
+				}
+				if (newVertices > bestNewVertices || verticesCount + newVertices > cMeshletMaxVertices) {
+					continue;
+				}
+				glm::vec3 delta = triangleCenter * (1.0f / 3.0f) - center;
+				float distance = glm::dot(delta, delta);
+				if (newVertices < bestNewVertices || distance < bestDistance) {
+					bestNewVertices = newVertices;
+					bestDistance = distance;
+					triangle = candidate;
+				}
+			}
+		}
+
+		uint32_t meshletIndexCount = static_cast<uint32_t>(table.mIndices.size()) - firstIndex;
+		table.mFirstIndex.push_back(firstIndex);
+		table.mIndexCount.push_back(meshletIndexCount);
+		table.mVertexCount.push_back(static_cast<uint8_t>(verticesCount));
+		ComputeBounds(positions, positionStride, meshletVertices, verticesCount, table.mIndices.data() + firstIndex, meshletIndexCount, table);
+	}
+	return true;
+}
+
+void Meshlet_Cull(const MeshletTable& table, const glm::mat4& model, const glm::vec3& cameraPosition, const Frustum& frustum, MeshletDrawRanges& ranges) {
+	ranges.mCounts.clear();
+	ranges.mOffsets.clear();
+	ranges.mVisibleMeshlets = 0;
+
+	const glm::mat3 rotation(model);
+	const float scale = std::max(glm::length(rotation[0]), std::max(glm::length(rotation[1]), glm::length(rotation[2])));
+	const uint32_t count = table.GetCount();
+	uint32_t previousVisible = cInvalidHandle;
+	for (uint32_t i = 0; i < count; i++) {
+		glm::vec3 center = glm::vec3(model * glm::vec4(table.mCenterX[i], table.mCenterY[i], table.mCenterZ[i], 1.0f));
+		float radius = table.mRadius[i] * scale;
+		if (!Frustum_TestSphere(frustum, center, radius)) {
+			continue;
+		}
+		float cutoff = table.mConeCutoff[i];
+		if (cutoff < 1.0f) {
+			glm::vec3 axis = rotation * glm::vec3(table.mConeAxisX[i], table.mConeAxisY[i], table.mConeAxisZ[i]) / scale;
+			glm::vec3 view = center - cameraPosition;
+			if (glm::dot(view, axis) >= cutoff * glm::length(view) + radius) {
+				continue;
+			}
+		}
+
+		ranges.mVisibleMeshlets++;
+		if (previousVisible != cInvalidHandle && previousVisible + 1 == i) {
+			ranges.mCounts.back() += static_cast<int32_t>(table.mIndexCount[i]);
+		} else {
+			ranges.mCounts.push_back(static_cast<int32_t>(table.mIndexCount[i]));
+			ranges.mOffsets.push_back((const void*)(uintptr_t)(table.mFirstIndex[i] * sizeof(uint32_t)));
+		}
+		previousVisible = i;
+	}
+}
+
+bool Meshlet_IsGpuCullingSupported() {
+	return GLAD_GL_VERSION_4_3 != 0 && glDispatchCompute != nullptr && glMultiDrawElementsIndirect != nullptr;
+}
+
+bool Meshlet_CreateGpuCuller(const MeshletTable& table, const MeshHandle& mesh, const ShaderProgramHandle& program, MeshletGpuCuller& culler) {
+	const uint32_t count = table.GetCount();
+	if (!Meshlet_IsGpuCullingSupported() || !mesh.IsValid() || !program.IsValid() || count == 0) {
+		return false;
+	}
+
+	// the commands are read as they are by the GPU, their first index is absolute in the index buffer
+	const uint32_t meshFirstIndex = Mesh_GetFirstIndex(mesh);
+
+	std::vector<GpuMeshlet> meshlets(count);
+	for (uint32_t i = 0; i < count; i++) {
+		GpuMeshlet& meshlet = meshlets[i];
+		meshlet.mSphere[0] = table.mCenterX[i];
+		meshlet.mSphere[1] = table.mCenterY[i];
+		meshlet.mSphere[2] = table.mCenterZ[i];
+		meshlet.mSphere[3] = table.mRadius[i];
+		meshlet.mCone[0] = table.mConeAxisX[i];
+		meshlet.mCone[1] = table.mConeAxisY[i];
+		meshlet.mCone[2] = table.mConeAxisZ[i];
+		meshlet.mCone[3] = table.mConeCutoff[i];
+		meshlet.mFirstIndex = meshFirstIndex + table.mFirstIndex[i];
+		meshlet.mIndexCount = table.mIndexCount[i];
+		meshlet.mPadding[0] = meshlet.mPadding[1] = 0;
+	}
+
+	culler.mProgram = program;
+	culler.mMesh = mesh;
+	culler.mMeshlets = Buffer_Create(BufferType::ShaderStorage, meshlets.data(), uint32_t(meshlets.size() * sizeof(GpuMeshlet)));
+	culler.mCommands = Buffer_Create(BufferType::ShaderStorage, nullptr, count * uint32_t(sizeof(DrawElementsIndirectCommand)), BufferUsage::Dynamic);
+	culler.mCount = count;
+	return culler.mMeshlets.IsValid() && culler.mCommands.IsValid();
+}
+
+void Meshlet_DestroyGpuCuller(MeshletGpuCuller& culler) {
+	Buffer_Destroy(culler.mCommands);
+	Buffer_Destroy(culler.mMeshlets);
+	culler = MeshletGpuCuller();
+}
+
+void Meshlet_CullGpu(const MeshletGpuCuller& culler, const glm::mat4& model, const glm::vec3& cameraPosition, const Frustum& frustum) {
+	if (culler.mCount == 0) {
+		return;
+	}
+	const glm::mat3 rotation(model);
+	const float scale = std::max(glm::length(rotation[0]), std::max(glm::length(rotation[1]), glm::length(rotation[2])));
+
+	ShaderProgram_Use(culler.mProgram);
+	ShaderProgram_SetMat4(culler.mProgram, "u_model", model);
+	ShaderProgram_SetFloat(culler.mProgram, "u_scale", scale);
+	ShaderProgram_SetVec3(culler.mProgram, "u_cameraPosition", cameraPosition);
+	ShaderProgram_SetInt(culler.mProgram, "u_meshletCount", int(culler.mCount));
+	for (uint32_t i = 0; i < FrustumPlane::Count; i++) {
+		ShaderProgram_SetVec4(culler.mProgram, cPlaneUniforms[i], frustum.mPlanes[i]);
+	}
+
+	Buffer_BindBase(culler.mMeshlets, 0);
+	Buffer_BindBase(culler.mCommands, 1);
+	ShaderProgram_Dispatch(culler.mProgram, (culler.mCount + cGpuGroupSize - 1) / cGpuGroupSize);
+	GL_CHECK(glMemoryBarrier(GL_COMMAND_BARRIER_BIT));
+}
+
+void Meshlet_DrawGpu(const MeshletGpuCuller& culler) {
+	if (culler.mCount == 0) {
+		return;
+	}
+	Mesh_MultiDrawIndirect(culler.mMesh, culler.mCommands, culler.mCount);
+}
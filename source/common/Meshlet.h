@@ -0,0 +1,70 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Buffer.h"
+#include "Frustum.h"
+#include "Mesh.h"
+#include "ShaderProgram.h"
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <vector>
+
+static constexpr uint32_t cMeshletMaxVertices = 64;
+static constexpr uint32_t cMeshletMaxTriangles = 124;
+
+// Clusters of an indexed triangle mesh. mIndices is the source index buffer reordered so that the triangles
+// of each meshlet are contiguous; per meshlet data is stored as structure of arrays.
+struct MeshletTable {
+	std::vector<uint32_t> mIndices;
+
+	std::vector<uint32_t> mFirstIndex;
+	std::vector<uint32_t> mIndexCount;
+	std::vector<uint8_t> mVertexCount;
+
+	std::vector<float> mCenterX;
+	std::vector<float> mCenterY;
+	std::vector<float> mCenterZ;
+	std::vector<float> mRadius;
+
+	std::vector<float> mConeAxisX;
+	std::vector<float> mConeAxisY;
+	std::vector<float> mConeAxisZ;
+	std::vector<float> mConeCutoff;		// sine of the cone half angle, >= 1 when the cluster cannot be backface culled
+
+	uint32_t GetCount() const { return static_cast<uint32_t>(mFirstIndex.size()); }
+};
+
+struct MeshletDrawRanges {
+	std::vector<int32_t> mCounts;
+	std::vector<const void*> mOffsets;
+	uint32_t mVisibleMeshlets = 0;
+};
+
+bool Meshlet_Build(const float* positions, uint32_t positionStride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, MeshletTable& table);
+
+// Culls the meshlets of an instance placed with model (uniform scale) against the world space frustum and camera
+// position, adjacent visible meshlets are merged into a single range ready for Mesh_MultiDraw. The mesh drawn holds
+// mIndices as 32-bit indices, from its index offset on.
+void Meshlet_Cull(const MeshletTable& table, const glm::mat4& model, const glm::vec3& cameraPosition, const Frustum& frustum, MeshletDrawRanges& ranges);
+
+// Optional GPU path: a compute shader (meshlet_cull.cs) writes one indirect command per meshlet of the mesh, culled
+// ones with zero count. Needs GL 4.3 for compute shaders, storage buffers and glMultiDrawElementsIndirect.
+struct MeshletGpuCuller {
+	ShaderProgramHandle mProgram = ShaderProgramHandle(cInvalidHandle);
+	MeshHandle mMesh = MeshHandle(cInvalidHandle);
+	BufferHandle mMeshlets = BufferHandle(cInvalidHandle);
+	BufferHandle mCommands = BufferHandle(cInvalidHandle);
+	uint32_t mCount = 0;
+};
+
+bool Meshlet_IsGpuCullingSupported();
+
+// program is meshlet_cull.cs. Fails without GL 4.3, Meshlet_Cull is the fallback then.
+bool Meshlet_CreateGpuCuller(const MeshletTable& table, const MeshHandle& mesh, const ShaderProgramHandle& program, MeshletGpuCuller& culler);
+
+void Meshlet_DestroyGpuCuller(MeshletGpuCuller& culler);
+
+void Meshlet_CullGpu(const MeshletGpuCuller& culler, const glm::mat4& model, const glm::vec3& cameraPosition, const Frustum& frustum);
+
+void Meshlet_DrawGpu(const MeshletGpuCuller& culler);
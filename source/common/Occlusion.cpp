@@ -0,0 +1,549 @@
+#include "Occlusion.h"
+
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+
+constexpr uint32_t cFullRow = 0xffffffffu;
+constexpr uint32_t cMinTrianglesPerThread = 256;
+constexpr uint32_t cMinOccludeesPerThread = 1024;
+
+struct ClipVertex {
+	glm::vec4 mPosition;
+};
+
+// x intercept of an edge for a row: x = mSlope * y + mOffset, or a constant coverage when the edge is horizontal.
+struct EdgeSpan {
+	float mSlope;
+	float mOffset;
+	int32_t mSide;								// 1 left bound, -1 right bound, 0 horizontal
+	bool mInside;								// horizontal edges only
+	float mB;
+	float mC;
+};
+
+using CoverageFunction = void(*)(const EdgeSpan* edges, float tileX, float tileY, uint32_t* rows);
+
+void PrepareEdges(const OcclusionTriangle& triangle, EdgeSpan* edges) {
+	const float* a = triangle.mEdgeA;
+	const float* b = triangle.mEdgeB;
+	const float* c = triangle.mEdgeC;
+	for (uint32_t i = 0; i < 3; i++) {
+		EdgeSpan& edge = edges[i];
+		edge.mB = b[i];
+		edge.mC = c[i];
+		edge.mInside = false;
+		if (a[i] == 0.0f) {
+			edge.mSide = 0;
+			edge.mSlope = 0.0f;
+			edge.mOffset = 0.0f;
+		} else {
+			edge.mSide = a[i] > 0.0f ? 1 : -1;
+			edge.mSlope = -b[i] / a[i];
+			edge.mOffset = -c[i] / a[i];
+		}
+	}
+}
+
+inline uint32_t LeftMask(float first) {
+	// pixels i >= first, first clamped to [0, 32]
+	first = std::min(std::max(first, 0.0f), 32.0f);
+	uint32_t shift = uint32_t(first);
+	return shift >= 32 ? 0u : (cFullRow << shift);
+}
+
+inline uint32_t RightMask(float last) {
+	// pixels i <= last, last clamped to [-1, 31]
+	last = std::min(std::max(last, -1.0f), 31.0f);
+	int32_t bits = int32_t(last);
+	return bits < 0 ? 0u : (cFullRow >> (31 - bits));
+}
+
+void CoverageScalar(const EdgeSpan* edges, float tileX, float tileY, uint32_t* rows) {
+	for (uint32_t row = 0; row < cOcclusionTileHeight; row++) {
+		const float y = tileY + float(row) + 0.5f;
+		uint32_t mask = cFullRow;
+		for (uint32_t i = 0; i < 3; i++) {
+			const EdgeSpan& edge = edges[i];
+			if (edge.mSide == 0) {
+				mask &= (edge.mB * y + edge.mC >= 0.0f) ? cFullRow : 0u;
+				continue;
+			}
+			// pixel i is covered when its center tileX + i + 0.5 is on the inner side of the intercept
+			const float intercept = edge.mSlope * y + edge.mOffset - tileX - 0.5f;
+			mask &= (edge.mSide > 0) ? LeftMask(std::ceil(intercept)) : RightMask(std::floor(intercept));
+		}
+		rows[row] = mask;
+	}
+}
+
+// The 8 rows of a tile are the 8 lanes, variable shifts turn the row intercepts into 32 bits masks.
+TINYNGINE_TARGET_AVX2
+void CoverageAVX2(const EdgeSpan* edges, float tileX, float tileY, uint32_t* rows) {
+	const __m256 y = _mm256_add_ps(_mm256_set1_ps(tileY + 0.5f), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+	const __m256i full = _mm256_set1_epi32(-1);
+	__m256i mask = full;
+	for (uint32_t i = 0; i < 3; i++) {
+		const EdgeSpan& edge = edges[i];
+		if (edge.mSide == 0) {
+			__m256 value = _mm256_fmadd_ps(_mm256_set1_ps(edge.mB), y, _mm256_set1_ps(edge.mC));
+			mask = _mm256_and_si256(mask, _mm256_castps_si256(_mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GE_OQ)));
+			continue;
+		}
+		__m256 intercept = _mm256_fmadd_ps(_mm256_set1_ps(edge.mSlope), y, _mm256_set1_ps(edge.mOffset - tileX - 0.5f));
+		if (edge.mSide > 0) {
+			// shifts of 32 or more give zero, which is what a bound past the tile needs
+			__m256 first = _mm256_min_ps(_mm256_max_ps(_mm256_ceil_ps(intercept), _mm256_setzero_ps()), _mm256_set1_ps(32.0f));
+			mask = _mm256_and_si256(mask, _mm256_sllv_epi32(full, _mm256_cvtps_epi32(first)));
+		} else {
+			__m256 last = _mm256_min_ps(_mm256_max_ps(_mm256_floor_ps(intercept), _mm256_set1_ps(-1.0f)), _mm256_set1_ps(31.0f));
+			__m256i shift = _mm256_sub_epi32(_mm256_set1_epi32(31), _mm256_cvtps_epi32(last));
+			mask = _mm256_and_si256(mask, _mm256_srlv_epi32(full, shift));
+		}
+	}
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(rows), mask);
+	_mm256_zeroupper();
+}
+
+const CoverageFunction sCoverage = Cpu_HasAVX2() ? CoverageAVX2 : CoverageScalar;
+
+void ResetTile(OcclusionTile& tile) {
+	std::memset(tile.mMask, 0, sizeof(tile.mMask));
+	tile.mZMax0 = 1.0f;
+	tile.mZMax1 = 0.0f;
+}
+
+// Merges a triangle covering the rows mask at depths up to z into the tile, see the buffer description.
+bool UpdateTile(OcclusionTile& tile, const uint32_t* coverage, float z) {
+	if (z >= tile.mZMax0) {
+		return false;
+	}
+	uint32_t any = 0;
+	for (uint32_t row = 0; row < cOcclusionTileHeight; row++) {
+		any |= coverage[row];
+	}
+	if (any == 0) {
+		return false;
+	}
+
+	uint32_t layer = 0;
+	for (uint32_t row = 0; row < cOcclusionTileHeight; row++) {
+		layer |= tile.mMask[row];
+	}
+	// when the triangle is much closer than the working layer, starting over from it keeps the bound tight
+	const bool discard = (layer == 0) || (tile.mZMax1 - z > tile.mZMax0 - tile.mZMax1);
+	uint32_t full = cFullRow;
+	for (uint32_t row = 0; row < cOcclusionTileHeight; row++) {
+		tile.mMask[row] = discard ? coverage[row] : (tile.mMask[row] | coverage[row]);
+		full &= tile.mMask[row];
+	}
+	tile.mZMax1 = discard ? z : std::max(tile.mZMax1, z);
+
+	if (full == cFullRow) {
+		tile.mZMax0 = std::min(tile.mZMax0, tile.mZMax1);
+		std::memset(tile.mMask, 0, sizeof(tile.mMask));
+		tile.mZMax1 = 0.0f;
+	}
+	return true;
+}
+
+// Clips against the near plane (z >= -w), returns the vertex count of the resulting polygon (0, 3 or 4).
+uint32_t ClipNear(const glm::vec4* input, glm::vec4* output) {
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < 3; i++) {
+		const glm::vec4& current = input[i];
+		const glm::vec4& next = input[(i + 1) % 3];
+		const float currentDistance = current.z + current.w;
+		const float nextDistance = next.z + next.w;
+		if (currentDistance >= 0.0f) {
+			output[count++] = current;
+		}
+		if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+			const float t = currentDistance / (currentDistance - nextDistance);
+			output[count++] = current + (next - current) * t;
+		}
+	}
+	return count;
+}
+
+bool SetupTriangle(const OcclusionBuffer& buffer, const glm::vec4* clip, OcclusionTriangle& triangle) {
+	glm::vec3 screen[3];
+	for (uint32_t i = 0; i < 3; i++) {
+		const float inverseW = 1.0f / clip[i].w;
+		screen[i].x = (clip[i].x * inverseW * 0.5f + 0.5f) * float(buffer.mWidth);
+		screen[i].y = (clip[i].y * inverseW * 0.5f + 0.5f) * float(buffer.mHeight);
+		screen[i].z = clip[i].z * inverseW * 0.5f + 0.5f;
+	}
+
+	float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+	if (area == 0.0f) {
+		return false;
+	}
+	if (area < 0.0f) {
+		std::swap(screen[1], screen[2]);
+		area = -area;
+	}
+
+	const float minX = std::min(std::min(screen[0].x, screen[1].x), screen[2].x);
+	const float maxX = std::max(std::max(screen[0].x, screen[1].x), screen[2].x);
+	const float minY = std::min(std::min(screen[0].y, screen[1].y), screen[2].y);
+	const float maxY = std::max(std::max(screen[0].y, screen[1].y), screen[2].y);
+	if (maxX < 0.0f || maxY < 0.0f || minX >= float(buffer.mWidth) || minY >= float(buffer.mHeight)) {
+		return false;
+	}
+	triangle.mTileMinX = static_cast<uint16_t>(std::max(minX, 0.0f) / cOcclusionTileWidth);
+	triangle.mTileMinY = static_cast<uint16_t>(std::max(minY, 0.0f) / cOcclusionTileHeight);
+	triangle.mTileMaxX = static_cast<uint16_t>(std::min(maxX / cOcclusionTileWidth, float(buffer.mTilesX - 1)));
+	triangle.mTileMaxY = static_cast<uint16_t>(std::min(maxY / cOcclusionTileHeight, float(buffer.mTilesY - 1)));
+
+	// counter clockwise: the inside is on the left of every edge
+	for (uint32_t i = 0; i < 3; i++) {
+		const glm::vec3& from = screen[i];
+		const glm::vec3& to = screen[(i + 1) % 3];
+		triangle.mEdgeA[i] = from.y - to.y;
+		triangle.mEdgeB[i] = to.x - from.x;
+		triangle.mEdgeC[i] = -(triangle.mEdgeA[i] * from.x + triangle.mEdgeB[i] * from.y);
+	}
+
+	const float inverseArea = 1.0f / area;
+	triangle.mZdX = ((screen[1].z - screen[0].z) * (screen[2].y - screen[0].y) - (screen[2].z - screen[0].z) * (screen[1].y - screen[0].y)) * inverseArea;
+	triangle.mZdY = ((screen[2].z - screen[0].z) * (screen[1].x - screen[0].x) - (screen[1].z - screen[0].z) * (screen[2].x - screen[0].x)) * inverseArea;
+	triangle.mZ0 = screen[0].z - triangle.mZdX * screen[0].x - triangle.mZdY * screen[0].y;
+	triangle.mZMin = std::min(std::min(screen[0].z, screen[1].z), screen[2].z);
+	triangle.mZMax = std::max(std::max(screen[0].z, screen[1].z), screen[2].z);
+	return true;
+}
+
+struct SetupRange {
+	uint32_t mOccluder;
+	uint32_t mTriangle;
+};
+
+// Sets up the triangles [first, end) of the queued occluders (global triangle numbering) into the bins of a thread.
+uint32_t SetupTriangles(OcclusionBuffer& buffer, const std::vector<uint32_t>& firstTriangles, uint32_t first, uint32_t end, std::vector<OcclusionTriangle>* bins, uint32_t bandsCount) {
+	uint32_t setupCount = 0;
+	uint32_t occluderIndex = static_cast<uint32_t>(std::upper_bound(firstTriangles.begin(), firstTriangles.end(), first) - firstTriangles.begin()) - 1;
+	glm::mat4 modelViewProj = buffer.mViewProj * buffer.mOccluders[occluderIndex].mModel;
+	for (uint32_t global = first; global < end; global++) {
+		while (global >= firstTriangles[occluderIndex + 1]) {
+			occluderIndex++;
+			modelViewProj = buffer.mViewProj * buffer.mOccluders[occluderIndex].mModel;
+		}
+		const OcclusionOccluder& occluder = buffer.mOccluders[occluderIndex];
+		const uint32_t* indices = occluder.mIndices + (global - firstTriangles[occluderIndex]) * 3;
+
+		glm::vec4 clip[3];
+		bool valid = true;
+		for (uint32_t i = 0; i < 3; i++) {
+			if (indices[i] >= occluder.mVertexCount) {
+				valid = false;
+				break;
+			}
+			const float* position = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(occluder.mPositions) + size_t(indices[i]) * occluder.mPositionStride);
+			clip[i] = modelViewProj * glm::vec4(position[0], position[1], position[2], 1.0f);
+		}
+		if (!valid) {
+			continue;
+		}
+
+		// trivially outside one of the side or far planes
+		bool outside = false;
+		for (uint32_t axis = 0; axis < 3 && !outside; axis++) {
+			outside = (clip[0][axis] > clip[0].w && clip[1][axis] > clip[1].w && clip[2][axis] > clip[2].w);
+			if (axis < 2) {
+				outside = outside || (clip[0][axis] < -clip[0].w && clip[1][axis] < -clip[1].w && clip[2][axis] < -clip[2].w);
+			}
+		}
+		if (outside) {
+			continue;
+		}
+
+		glm::vec4 polygon[4];
+		const uint32_t polygonCount = ClipNear(clip, polygon);
+		for (uint32_t fan = 2; fan < polygonCount; fan++) {
+			const glm::vec4 vertices[3] = { polygon[0], polygon[fan - 1], polygon[fan] };
+			OcclusionTriangle triangle;
+			if (!SetupTriangle(buffer, vertices, triangle)) {
+				continue;
+			}
+			setupCount++;
+			const uint32_t firstBand = triangle.mTileMinY * bandsCount / buffer.mTilesY;
+			const uint32_t lastBand = triangle.mTileMaxY * bandsCount / buffer.mTilesY;
+			for (uint32_t band = firstBand; band <= lastBand; band++) {
+				bins[band].push_back(triangle);
+			}
+		}
+	}
+	return setupCount;
+}
+
+uint32_t RasterizeBand(OcclusionBuffer& buffer, uint32_t band, uint32_t bandsCount, uint32_t setupThreads) {
+	const uint32_t bandFirstRow = (band * buffer.mTilesY + bandsCount - 1) / bandsCount;
+	const uint32_t bandEndRow = ((band + 1) * buffer.mTilesY + bandsCount - 1) / bandsCount;
+	uint32_t updates = 0;
+	uint32_t coverage[cOcclusionTileHeight];
+	EdgeSpan edges[3];
+	for (uint32_t thread = 0; thread < setupThreads; thread++) {
+		for (const OcclusionTriangle& triangle : buffer.mBins[thread * bandsCount + band]) {
+			PrepareEdges(triangle, edges);
+			const uint32_t firstRow = std::max<uint32_t>(triangle.mTileMinY, bandFirstRow);
+			const uint32_t endRow = std::min<uint32_t>(triangle.mTileMaxY + 1u, bandEndRow);
+			for (uint32_t tileY = firstRow; tileY < endRow; tileY++) {
+				const float y0 = float(tileY * cOcclusionTileHeight);
+				const float y1 = y0 + float(cOcclusionTileHeight);
+				for (uint32_t tileX = triangle.mTileMinX; tileX <= triangle.mTileMaxX; tileX++) {
+					const float x0 = float(tileX * cOcclusionTileWidth);
+					const float x1 = x0 + float(cOcclusionTileWidth);
+					OcclusionTile& tile = buffer.mTiles[tileY * buffer.mTilesX + tileX];
+
+					// farthest depth of the triangle plane over the tile, the plane is linear so a corner holds it
+					float z = triangle.mZ0 + std::max(triangle.mZdX * x0, triangle.mZdX * x1) + std::max(triangle.mZdY * y0, triangle.mZdY * y1);
+					z = std::min(std::max(z, triangle.mZMin), triangle.mZMax);
+					if (z >= tile.mZMax0) {
+						continue;
+					}
+					sCoverage(edges, x0, y0, coverage);
+					updates += UpdateTile(tile, coverage, z) ? 1 : 0;
+				}
+			}
+		}
+	}
+	return updates;
+}
+
+struct ScreenRect {
+	int32_t mMinX;
+	int32_t mMinY;
+	int32_t mMaxX;
+	int32_t mMaxY;
+	float mZMin;
+};
+
+// Returns 1 for a rectangle to test, 0 when the box is off screen and -1 when it crosses the near plane.
+int32_t ProjectBox(const OcclusionBuffer& buffer, const glm::vec3& minimum, const glm::vec3& maximum, ScreenRect& rect) {
+	// the corners are the clip space center plus or minus the clip space half axes, 4 transforms instead of 8
+	const glm::vec3 center = (minimum + maximum) * 0.5f;
+	const glm::vec3 extent = (maximum - minimum) * 0.5f;
+	const glm::mat4& viewProj = buffer.mViewProj;
+	const glm::vec4 clipCenter = viewProj[0] * center.x + viewProj[1] * center.y + viewProj[2] * center.z + viewProj[3];
+	const glm::vec4 axisX = viewProj[0] * extent.x;
+	const glm::vec4 axisY = viewProj[1] * extent.y;
+	const glm::vec4 axisZ = viewProj[2] * extent.z;
+
+	float minX = std::numeric_limits<float>::max();
+	float minY = std::numeric_limits<float>::max();
+	float maxX = -std::numeric_limits<float>::max();
+	float maxY = -std::numeric_limits<float>::max();
+	float minZ = std::numeric_limits<float>::max();
+	for (uint32_t corner = 0; corner < 8; corner++) {
+		glm::vec4 clip = clipCenter;
+		clip += (corner & 1) ? axisX : -axisX;
+		clip += (corner & 2) ? axisY : -axisY;
+		clip += (corner & 4) ? axisZ : -axisZ;
+		if (clip.z < -clip.w || clip.w <= 0.0f) {
+			return -1;
+		}
+		const float inverseW = 1.0f / clip.w;
+		minX = std::min(minX, clip.x * inverseW);
+		maxX = std::max(maxX, clip.x * inverseW);
+		minY = std::min(minY, clip.y * inverseW);
+		maxY = std::max(maxY, clip.y * inverseW);
+		minZ = std::min(minZ, clip.z * inverseW);
+	}
+	const float width = float(buffer.mWidth);
+	const float height = float(buffer.mHeight);
+	minX = (minX * 0.5f + 0.5f) * width;
+	maxX = (maxX * 0.5f + 0.5f) * width;
+	minY = (minY * 0.5f + 0.5f) * height;
+	maxY = (maxY * 0.5f + 0.5f) * height;
+	if (maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height) {
+		return 0;
+	}
+	// clamped before the conversion, near the w = 0 plane the corners are far out of the int32_t range
+	rect.mMinX = int32_t(std::max(minX, 0.0f));
+	rect.mMinY = int32_t(std::max(minY, 0.0f));
+	rect.mMaxX = int32_t(std::min(maxX, width - 1.0f));
+	rect.mMaxY = int32_t(std::min(maxY, height - 1.0f));
+	rect.mZMin = minZ * 0.5f + 0.5f;
+	return 1;
+}
+
+bool TestRect(const OcclusionBuffer& buffer, const ScreenRect& rect) {
+	const uint32_t tileMinX = uint32_t(rect.mMinX) / cOcclusionTileWidth;
+	const uint32_t tileMaxX = uint32_t(rect.mMaxX) / cOcclusionTileWidth;
+	const uint32_t tileMinY = uint32_t(rect.mMinY) / cOcclusionTileHeight;
+	const uint32_t tileMaxY = uint32_t(rect.mMaxY) / cOcclusionTileHeight;
+	for (uint32_t tileY = tileMinY; tileY <= tileMaxY; tileY++) {
+		for (uint32_t tileX = tileMinX; tileX <= tileMaxX; tileX++) {
+			const OcclusionTile& tile = buffer.mTiles[tileY * buffer.mTilesX + tileX];
+			if (rect.mZMin >= tile.mZMax0) {
+				continue;
+			}
+			// the working layer is always nearer than the tile layer, in front of it the box is visible anywhere
+			if (rect.mZMin < tile.mZMax1) {
+				return true;
+			}
+
+			// visible when the rectangle reaches a pixel outside of the working layer
+			const int32_t x0 = std::max(rect.mMinX - int32_t(tileX * cOcclusionTileWidth), 0);
+			const int32_t x1 = std::min(rect.mMaxX - int32_t(tileX * cOcclusionTileWidth), int32_t(cOcclusionTileWidth) - 1);
+			const uint32_t rowMask = (cFullRow << x0) & (cFullRow >> (31 - x1));
+			const int32_t y0 = std::max(rect.mMinY - int32_t(tileY * cOcclusionTileHeight), 0);
+			const int32_t y1 = std::min(rect.mMaxY - int32_t(tileY * cOcclusionTileHeight), int32_t(cOcclusionTileHeight) - 1);
+			for (int32_t row = y0; row <= y1; row++) {
+				if ((rowMask & ~tile.mMask[row]) != 0) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+}
+
+void Occlusion_Initialize(OcclusionBuffer& buffer, uint32_t width, uint32_t height) {
+	buffer.mTilesX = (width + cOcclusionTileWidth - 1) / cOcclusionTileWidth;
+	buffer.mTilesY = (height + cOcclusionTileHeight - 1) / cOcclusionTileHeight;
+	buffer.mTilesX = buffer.mTilesX > 0 ? buffer.mTilesX : 1;
+	buffer.mTilesY = buffer.mTilesY > 0 ? buffer.mTilesY : 1;
+	buffer.mWidth = buffer.mTilesX * cOcclusionTileWidth;
+	buffer.mHeight = buffer.mTilesY * cOcclusionTileHeight;
+	buffer.mTiles.resize(buffer.mTilesX * buffer.mTilesY);
+	for (OcclusionTile& tile : buffer.mTiles) {
+		ResetTile(tile);
+	}
+}
+
+void Occlusion_Begin(OcclusionBuffer& buffer, const glm::mat4& viewProjection) {
+	buffer.mViewProj = viewProjection;
+	buffer.mOccluders.clear();
+	buffer.mStats = OcclusionStats();
+	for (OcclusionTile& tile : buffer.mTiles) {
+		ResetTile(tile);
+	}
+}
+
+void Occlusion_AddOccluder(OcclusionBuffer& buffer, const OcclusionOccluder& occluder) {
+	if (occluder.mPositions == nullptr || occluder.mIndices == nullptr || occluder.mIndexCount < 3) {
+		return;
+	}
+	OcclusionOccluder queued = occluder;
+	if (queued.mPositionStride == 0) {
+		queued.mPositionStride = 3 * sizeof(float);
+	}
+	buffer.mOccluders.push_back(queued);
+}
+
+void Occlusion_Rasterize(OcclusionBuffer& buffer, uint32_t threadsCount) {
+	std::vector<uint32_t> firstTriangles(buffer.mOccluders.size() + 1, 0);
+	for (size_t i = 0; i < buffer.mOccluders.size(); i++) {
+		firstTriangles[i + 1] = firstTriangles[i] + buffer.mOccluders[i].mIndexCount / 3;
+	}
+	const uint32_t trianglesCount = firstTriangles.back();
+	buffer.mStats.mOccluderTriangles = trianglesCount;
+	if (trianglesCount == 0 || buffer.mTiles.empty()) {
+		return;
+	}
+
+	threadsCount = std::max(threadsCount, 1u);
+	const uint32_t setupThreads = std::max(std::min(threadsCount, trianglesCount / cMinTrianglesPerThread), 1u);
+	const uint32_t bandsCount = std::min(threadsCount, buffer.mTilesY);
+
+	buffer.mBins.resize(setupThreads * bandsCount);
+	for (auto& bin : buffer.mBins) {
+		bin.clear();
+	}
+
+	std::vector<uint32_t> setupCounts(setupThreads, 0);
+	const uint32_t slice = (trianglesCount + setupThreads - 1) / setupThreads;
+	Job_RunSlices(setupThreads, [&](uint32_t thread) {
+		const uint32_t first = thread * slice;
+		const uint32_t end = std::min(first + slice, trianglesCount);
+		if (first < end) {
+			setupCounts[thread] = SetupTriangles(buffer, firstTriangles, first, end, &buffer.mBins[thread * bandsCount], bandsCount);
+		}
+	});
+
+	std::vector<uint32_t> updates(bandsCount, 0);
+	Job_RunSlices(bandsCount, [&](uint32_t band) {
+		updates[band] = RasterizeBand(buffer, band, bandsCount, setupThreads);
+	});
+
+	for (uint32_t count : setupCounts) {
+		buffer.mStats.mRasterizedTriangles += count;
+	}
+	for (uint32_t count : updates) {
+		buffer.mStats.mTileUpdates += count;
+	}
+}
+
+bool Occlusion_TestBox(const OcclusionBuffer& buffer, const glm::vec3& minimum, const glm::vec3& maximum) {
+	ScreenRect rect;
+	const int32_t projection = ProjectBox(buffer, minimum, maximum, rect);
+	if (projection <= 0) {
+		return projection < 0;
+	}
+	return TestRect(buffer, rect);
+}
+
+uint32_t Occlusion_TestBoxes(OcclusionBuffer& buffer, const CullingBoxes& boxes, const uint32_t* candidates, uint32_t candidatesCount, uint32_t threadsCount, uint32_t* visible) {
+	if (candidates == nullptr || visible == nullptr) {
+		return 0;
+	}
+
+	auto test = [&](uint32_t first, uint32_t end) {
+		uint32_t written = 0;
+		for (uint32_t i = first; i < end; i++) {
+			const uint32_t object = candidates[i];
+			const glm::vec3 center(boxes.mCenterX[object], boxes.mCenterY[object], boxes.mCenterZ[object]);
+			const glm::vec3 extent(boxes.mExtentX[object], boxes.mExtentY[object], boxes.mExtentZ[object]);
+			// written never passes i, so compacting in place over candidates is safe
+			const bool isVisible = Occlusion_TestBox(buffer, center - extent, center + extent);
+			visible[first + written] = object;
+			written += isVisible ? 1 : 0;
+		}
+		return written;
+	};
+
+	threadsCount = std::max(std::min(threadsCount, candidatesCount / cMinOccludeesPerThread), 1u);
+	std::vector<uint32_t> written(threadsCount, 0);
+	const uint32_t slice = (candidatesCount + threadsCount - 1) / threadsCount;
+	Job_RunSlices(threadsCount, [&](uint32_t thread) {
+		const uint32_t first = thread * slice;
+		const uint32_t end = std::min(first + slice, candidatesCount);
+		written[thread] = first < end ? test(first, end) : 0;
+	});
+
+	uint32_t total = written[0];
+	for (uint32_t t = 1; t < threadsCount; t++) {
+		if (total != t * slice) {
+			std::memmove(visible + total, visible + t * slice, written[t] * sizeof(uint32_t));
+		}
+		total += written[t];
+	}
+
+	buffer.mStats.mOccludeesTested += candidatesCount;
+	buffer.mStats.mOccludeesCulled += candidatesCount - total;
+	return total;
+}
+
+void Occlusion_ResolveDepth(const OcclusionBuffer& buffer, float* depth) {
+	if (depth == nullptr) {
+		return;
+	}
+	for (uint32_t y = 0; y < buffer.mHeight; y++) {
+		for (uint32_t x = 0; x < buffer.mWidth; x++) {
+			const OcclusionTile& tile = buffer.mTiles[(y / cOcclusionTileHeight) * buffer.mTilesX + x / cOcclusionTileWidth];
+			const bool masked = (tile.mMask[y % cOcclusionTileHeight] >> (x % cOcclusionTileWidth)) & 1;
+			depth[y * buffer.mWidth + x] = masked ? tile.mZMax1 : tile.mZMax0;
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Culling.h"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <vector>
+
+// Masked occlusion buffer: the screen is split in 32x8 pixels tiles, each one storing a 1 bit per pixel coverage mask
+// and two conservative depths instead of per pixel depth. mZMax0 bounds every pixel of the tile, mZMax1 bounds the
+// pixels set in the mask (the working layer); once the mask is full the working layer replaces the tile layer.
+// Depths are window space, 0 near and 1 far.
+static constexpr uint32_t cOcclusionTileWidth = 32;
+static constexpr uint32_t cOcclusionTileHeight = 8;
+
+struct OcclusionTile {
+	uint32_t mMask[cOcclusionTileHeight];		// bit x of row y covers pixel (x, y) of the tile
+	float mZMax0;
+	float mZMax1;
+};
+
+struct OcclusionOccluder {
+	const float* mPositions = nullptr;
+	uint32_t mPositionStride = 0;				// in bytes
+	uint32_t mVertexCount = 0;
+	const uint32_t* mIndices = nullptr;
+	uint32_t mIndexCount = 0;
+	glm::mat4 mModel = glm::mat4(1.0f);
+};
+
+// Screen space triangle ready to be rasterized, produced by the setup of the occluders.
+struct OcclusionTriangle {
+	float mEdgeA[3];
+	float mEdgeB[3];
+	float mEdgeC[3];							// edge i covers (x, y) when a * x + b * y + c >= 0
+	float mZ0;									// depth plane z = mZ0 + mZdX * x + mZdY * y
+	float mZdX;
+	float mZdY;
+	float mZMin;
+	float mZMax;
+	uint16_t mTileMinX;
+	uint16_t mTileMinY;
+	uint16_t mTileMaxX;
+	uint16_t mTileMaxY;
+};
+
+struct OcclusionStats {
+	uint32_t mOccluderTriangles = 0;
+	uint32_t mRasterizedTriangles = 0;		// after backface, frustum and near plane clipping
+	uint32_t mTileUpdates = 0;
+	uint32_t mOccludeesTested = 0;
+	uint32_t mOccludeesCulled = 0;
+};
+
+struct OcclusionBuffer {
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	uint32_t mTilesX = 0;
+	uint32_t mTilesY = 0;
+	std::vector<OcclusionTile> mTiles;
+
+	glm::mat4 mViewProj = glm::mat4(1.0f);
+	std::vector<OcclusionOccluder> mOccluders;
+	std::vector<std::vector<OcclusionTriangle>> mBins;		// per setup thread, per tile row band
+	OcclusionStats mStats;
+};
+
+// Width and height are rounded up to whole tiles. A quarter of the window resolution or less is usually enough.
+void Occlusion_Initialize(OcclusionBuffer& buffer, uint32_t width, uint32_t height);
+
+// Resets the depth to the far plane and forgets the queued occluders.
+void Occlusion_Begin(OcclusionBuffer& buffer, const glm::mat4& viewProjection);
+
+// Queues a low poly occluder, positions and indices are referenced until Occlusion_Rasterize returns.
+// Both faces of every triangle occlude.
+void Occlusion_AddOccluder(OcclusionBuffer& buffer, const OcclusionOccluder& occluder);
+
+// Sets up the queued occluder triangles in parallel and bins them to horizontal bands of tiles, every thread then
+// rasterizes its own bands, so no two threads ever touch the same tile.
+void Occlusion_Rasterize(OcclusionBuffer& buffer, uint32_t threadsCount);
+
+// True when some part of the box could be in front of the occluders. Boxes crossing the near plane are visible.
+bool Occlusion_TestBox(const OcclusionBuffer& buffer, const glm::vec3& minimum, const glm::vec3& maximum);
+
+// Tests the boxes listed in candidates (e.g. the output of the frustum culling) and writes the visible ones to
+// visible, which may alias candidates. Returns the visible count.
+uint32_t Occlusion_TestBoxes(OcclusionBuffer& buffer, const CullingBoxes& boxes, const uint32_t* candidates, uint32_t candidatesCount, uint32_t threadsCount, uint32_t* visible);
+
+// Farthest depth of every pixel, for debugging (width * height floats).
+void Occlusion_ResolveDepth(const OcclusionBuffer& buffer, float* depth);
@@ -0,0 +1,367 @@
+#include "PipelineState.h"
+
+#include "GLApi.h"
+#include <array>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+static const GLenum sCompareFuncs[]{
+	GL_NEVER,						// Never
+	GL_LESS,						// Less
+	GL_EQUAL,						// Equal
+	GL_LEQUAL,						// LessEqual
+	GL_GREATER,						// Greater
+	GL_NOTEQUAL,					// NotEqual
+	GL_GEQUAL,						// GreaterEqual
+	GL_ALWAYS,						// Always
+};
+
+static const GLenum sStencilOps[]{
+	GL_KEEP,						// Keep
+	GL_ZERO,						// Zero
+	GL_REPLACE,						// Replace
+	GL_INCR,						// Increment
+	GL_INCR_WRAP,					// IncrementWrap
+	GL_DECR,						// Decrement
+	GL_DECR_WRAP,					// DecrementWrap
+	GL_INVERT,						// Invert
+};
+
+static const GLenum sBlendFactors[]{
+	GL_ZERO,						// Zero
+	GL_ONE,							// One
+	GL_SRC_COLOR,					// SrcColor
+	GL_ONE_MINUS_SRC_COLOR,			// OneMinusSrcColor
+	GL_DST_COLOR,					// DstColor
+	GL_ONE_MINUS_DST_COLOR,			// OneMinusDstColor
+	GL_SRC_ALPHA,					// SrcAlpha
+	GL_ONE_MINUS_SRC_ALPHA,			// OneMinusSrcAlpha
+	GL_DST_ALPHA,					// DstAlpha
+	GL_ONE_MINUS_DST_ALPHA,			// OneMinusDstAlpha
+};
+
+static const GLenum sBlendOps[]{
+	GL_FUNC_ADD,					// Add
+	GL_FUNC_SUBTRACT,				// Subtract
+	GL_FUNC_REVERSE_SUBTRACT,		// ReverseSubtract
+	GL_MIN,							// Min
+	GL_MAX,							// Max
+};
+
+static const GLenum sCullFaces[]{
+	GL_NONE,						// None
+	GL_FRONT,						// Front
+	GL_BACK,						// Back
+};
+
+static const GLenum sPolygonModes[]{
+	GL_FILL,						// Fill
+	GL_LINE,						// Line
+	GL_POINT,						// Point
+};
+
+// Last state set through this module, a category is set unconditionally until its valid flag is raised.
+struct CachedState {
+	bool mDepthValid = false;
+	bool mStencilValid = false;
+	bool mBlendValid = false;
+	bool mRasterValid = false;
+	DepthState mDepth;
+	StencilState mStencil;
+	BlendState mBlend;
+	RasterState mRaster;
+};
+
+CachedState sCurrent;
+PipelineStateStats sStats;
+
+// Returns true when the call has to be issued, updating the stats either way.
+inline bool Changed(bool valid, bool changed) {
+	changed = changed || !valid;
+	if (changed) {
+		sStats.mStateCalls++;
+	} else {
+		sStats.mSkippedCalls++;
+	}
+	return changed;
+}
+
+inline void SetCapability(GLenum capability, bool enable) {
+	if (enable) {
+		GL_CHECK(glEnable(capability));
+	} else {
+		GL_CHECK(glDisable(capability));
+	}
+}
+
+void ApplyDepth(const DepthState& state) {
+	DepthState& current = sCurrent.mDepth;
+	const bool valid = sCurrent.mDepthValid;
+	if (Changed(valid, state.mTestEnable != current.mTestEnable)) {
+		SetCapability(GL_DEPTH_TEST, state.mTestEnable);
+	}
+	if (Changed(valid, state.mWriteEnable != current.mWriteEnable)) {
+		GL_CHECK(glDepthMask(state.mWriteEnable ? GL_TRUE : GL_FALSE));
+	}
+	if (Changed(valid, state.mFunc != current.mFunc)) {
+		GL_CHECK(glDepthFunc(sCompareFuncs[state.mFunc]));
+	}
+	current = state;
+	sCurrent.mDepthValid = true;
+}
+
+void ApplyStencil(const StencilState& state) {
+	StencilState& current = sCurrent.mStencil;
+	const bool valid = sCurrent.mStencilValid;
+	if (Changed(valid, state.mEnable != current.mEnable)) {
+		SetCapability(GL_STENCIL_TEST, state.mEnable);
+	}
+	if (Changed(valid, state.mFunc != current.mFunc || state.mReference != current.mReference || state.mReadMask != current.mReadMask)) {
+		GL_CHECK(glStencilFunc(sCompareFuncs[state.mFunc], state.mReference, state.mReadMask));
+	}
+	if (Changed(valid, state.mFail != current.mFail || state.mDepthFail != current.mDepthFail || state.mPass != current.mPass)) {
+		GL_CHECK(glStencilOp(sStencilOps[state.mFail], sStencilOps[state.mDepthFail], sStencilOps[state.mPass]));
+	}
+	if (Changed(valid, state.mWriteMask != current.mWriteMask)) {
+		GL_CHECK(glStencilMask(state.mWriteMask));
+	}
+	current = state;
+	sCurrent.mStencilValid = true;
+}
+
+void ApplyBlend(const BlendState& state) {
+	BlendState& current = sCurrent.mBlend;
+	const bool valid = sCurrent.mBlendValid;
+	if (Changed(valid, state.mEnable != current.mEnable)) {
+		SetCapability(GL_BLEND, state.mEnable);
+	}
+	if (Changed(valid, state.mSrcColor != current.mSrcColor || state.mDstColor != current.mDstColor ||
+			state.mSrcAlpha != current.mSrcAlpha || state.mDstAlpha != current.mDstAlpha)) {
+		GL_CHECK(glBlendFuncSeparate(sBlendFactors[state.mSrcColor], sBlendFactors[state.mDstColor], sBlendFactors[state.mSrcAlpha], sBlendFactors[state.mDstAlpha]));
+	}
+	if (Changed(valid, state.mColorOp != current.mColorOp || state.mAlphaOp != current.mAlphaOp)) {
+		GL_CHECK(glBlendEquationSeparate(sBlendOps[state.mColorOp], sBlendOps[state.mAlphaOp]));
+	}
+	if (Changed(valid, state.mColorWriteMask != current.mColorWriteMask)) {
+		GL_CHECK(glColorMask((state.mColorWriteMask & 1) ? GL_TRUE : GL_FALSE, (state.mColorWriteMask & 2) ? GL_TRUE : GL_FALSE,
+			(state.mColorWriteMask & 4) ? GL_TRUE : GL_FALSE, (state.mColorWriteMask & 8) ? GL_TRUE : GL_FALSE));
+	}
+	current = state;
+	sCurrent.mBlendValid = true;
+}
+
+void ApplyRaster(const RasterState& state) {
+	RasterState& current = sCurrent.mRaster;
+	const bool valid = sCurrent.mRasterValid;
+	if (Changed(valid, (state.mCull == CullMode::None) != (current.mCull == CullMode::None))) {
+		SetCapability(GL_CULL_FACE, state.mCull != CullMode::None);
+	}
+	if (state.mCull != CullMode::None && Changed(valid, state.mCull != current.mCull)) {
+		GL_CHECK(glCullFace(sCullFaces[state.mCull]));
+	}
+	if (Changed(valid, state.mFrontCounterClockwise != current.mFrontCounterClockwise)) {
+		GL_CHECK(glFrontFace(state.mFrontCounterClockwise ? GL_CCW : GL_CW));
+	}
+	if (Changed(valid, state.mPolygon != current.mPolygon)) {
+		GL_CHECK(glPolygonMode(GL_FRONT_AND_BACK, sPolygonModes[state.mPolygon]));
+	}
+	if (Changed(valid, state.mScissorEnable != current.mScissorEnable)) {
+		SetCapability(GL_SCISSOR_TEST, state.mScissorEnable);
+	}
+	const bool offset = (state.mPolygonOffsetFactor != 0.0f || state.mPolygonOffsetUnits != 0.0f);
+	const bool currentOffset = (current.mPolygonOffsetFactor != 0.0f || current.mPolygonOffsetUnits != 0.0f);
+	if (Changed(valid, offset != currentOffset)) {
+		SetCapability(GL_POLYGON_OFFSET_FILL, offset);
+	}
+	if (offset && Changed(valid, state.mPolygonOffsetFactor != current.mPolygonOffsetFactor || state.mPolygonOffsetUnits != current.mPolygonOffsetUnits)) {
+		GL_CHECK(glPolygonOffset(state.mPolygonOffsetFactor, state.mPolygonOffsetUnits));
+	}
+	current = state;
+	sCurrent.mRasterValid = true;
+}
+
+// Padding free description of a state, used both for hashing and for equality.
+void Serialize(const PipelineStateParams& params, std::vector<uint32_t>& words) {
+	auto floatBits = [](float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	};
+	words = {
+		params.mProgram.mHandle, params.mMesh.mHandle,
+		params.mDepth.mTestEnable, params.mDepth.mWriteEnable, uint32_t(params.mDepth.mFunc),
+		params.mStencil.mEnable, uint32_t(params.mStencil.mFunc), params.mStencil.mReference, params.mStencil.mReadMask, params.mStencil.mWriteMask,
+		uint32_t(params.mStencil.mFail), uint32_t(params.mStencil.mDepthFail), uint32_t(params.mStencil.mPass),
+		params.mBlend.mEnable, uint32_t(params.mBlend.mSrcColor), uint32_t(params.mBlend.mDstColor), uint32_t(params.mBlend.mSrcAlpha), uint32_t(params.mBlend.mDstAlpha),
+		uint32_t(params.mBlend.mColorOp), uint32_t(params.mBlend.mAlphaOp), params.mBlend.mColorWriteMask,
+		uint32_t(params.mRaster.mCull), params.mRaster.mFrontCounterClockwise, uint32_t(params.mRaster.mPolygon), params.mRaster.mScissorEnable,
+		floatBits(params.mRaster.mPolygonOffsetFactor), floatBits(params.mRaster.mPolygonOffsetUnits),
+	};
+}
+
+uint64_t Hash(const std::vector<uint32_t>& words) {
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for (uint32_t word : words) {
+		for (uint32_t i = 0; i < 4; i++) {
+			hash ^= (word >> (i * 8)) & 0xff;
+			hash *= 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+class PipelineState {
+public:
+	PipelineState() = default;
+	~PipelineState() = default;
+
+	void Create(const PipelineStateParams& params, const std::vector<uint32_t>& key, uint64_t hash) {
+		mParams = params;
+		mKey = key;
+		mHash = hash;
+		mReferences = 1;
+	}
+
+	// returns true when the last reference was released
+	bool Release() {
+		if (mReferences > 0 && --mReferences == 0) {
+			mKey.clear();
+			return true;
+		}
+		return false;
+	}
+
+	void AddReference() {
+		mReferences++;
+	}
+
+	void Apply() {
+		if (!IsValid()) {
+			return;
+		}
+		sStats.mApplies++;
+		ShaderProgram_Use(mParams.mProgram);
+		Mesh_Bind(mParams.mMesh);
+		ApplyDepth(mParams.mDepth);
+		ApplyStencil(mParams.mStencil);
+		ApplyBlend(mParams.mBlend);
+		ApplyRaster(mParams.mRaster);
+	}
+
+	bool Equals(const std::vector<uint32_t>& key) const {
+		return IsValid() && mKey == key;
+	}
+
+	uint64_t GetHash() const {
+		return mHash;
+	}
+
+	bool IsValid() const {
+		return mReferences > 0;
+	}
+
+private:
+	PipelineStateParams mParams;
+	std::vector<uint32_t> mKey;
+	uint64_t mHash = 0;
+	uint32_t mReferences = 0;
+};
+
+static constexpr uint32_t cMaxPipelineStateHandles = (1 << 8);
+uint32_t sPipelineStatesCount = 0;
+uint32_t sPipelineStatesAlive = 0;
+std::array<PipelineState, cMaxPipelineStateHandles> sPipelineStates;
+std::unordered_multimap<uint64_t, uint32_t> sPipelineStatesByHash;
+
+}
+
+PipelineStateHandle PipelineState_Create(const PipelineStateParams& params) {
+	std::vector<uint32_t> key;
+	Serialize(params, key);
+	uint64_t hash = Hash(key);
+
+	auto range = sPipelineStatesByHash.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		auto& existing = sPipelineStates[it->second];
+		if (existing.Equals(key)) {
+			existing.AddReference();
+			return PipelineStateHandle(it->second);
+		}
+	}
+
+	if (sPipelineStatesCount >= cMaxPipelineStateHandles) {
+		return PipelineStateHandle(cInvalidHandle);
+	}
+
+	PipelineStateHandle handle = PipelineStateHandle(sPipelineStatesCount++);
+	auto& state = sPipelineStates[handle.mHandle];
+	state.Create(params, key, hash);
+	sPipelineStatesByHash.emplace(hash, handle.mHandle);
+	sPipelineStatesAlive++;
+	return handle;
+}
+
+void PipelineState_Destroy(const PipelineStateHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& state = sPipelineStates[handle.mHandle];
+	const uint64_t hash = state.GetHash();
+	if (state.Release()) {
+		auto range = sPipelineStatesByHash.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->second == handle.mHandle) {
+				sPipelineStatesByHash.erase(it);
+				break;
+			}
+		}
+		sPipelineStatesAlive--;
+	}
+}
+
+void PipelineState_Apply(const PipelineStateHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& state = sPipelineStates[handle.mHandle];
+	state.Apply();
+}
+
+void PipelineState_ApplyDepth(const DepthState& state) {
+	ApplyDepth(state);
+}
+
+void PipelineState_ApplyStencil(const StencilState& state) {
+	ApplyStencil(state);
+}
+
+void PipelineState_ApplyBlend(const BlendState& state) {
+	ApplyBlend(state);
+}
+
+void PipelineState_ApplyRaster(const RasterState& state) {
+	ApplyRaster(state);
+}
+
+void PipelineState_InvalidateCache() {
+	sCurrent = CachedState();
+	ShaderProgram_InvalidateCache();
+	Mesh_InvalidateCache();
+}
+
+uint32_t PipelineState_GetCount() {
+	return sPipelineStatesAlive;
+}
+
+const PipelineStateStats& PipelineState_GetStats() {
+	return sStats;
+}
+
+void PipelineState_ResetStats() {
+	sStats = PipelineStateStats();
+}
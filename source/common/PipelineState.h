@@ -0,0 +1,158 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Mesh.h"
+#include "ShaderProgram.h"
+
+struct CompareFunc {
+	enum Enum {
+		Never,
+		Less,
+		Equal,
+		LessEqual,
+		Greater,
+		NotEqual,
+		GreaterEqual,
+		Always,
+		Count
+	};
+};
+
+struct StencilOp {
+	enum Enum {
+		Keep,
+		Zero,
+		Replace,
+		Increment,
+		IncrementWrap,
+		Decrement,
+		DecrementWrap,
+		Invert,
+		Count
+	};
+};
+
+struct BlendFactor {
+	enum Enum {
+		Zero,
+		One,
+		SrcColor,
+		OneMinusSrcColor,
+		DstColor,
+		OneMinusDstColor,
+		SrcAlpha,
+		OneMinusSrcAlpha,
+		DstAlpha,
+		OneMinusDstAlpha,
+		Count
+	};
+};
+
+struct BlendOp {
+	enum Enum {
+		Add,
+		Subtract,
+		ReverseSubtract,
+		Min,
+		Max,
+		Count
+	};
+};
+
+struct CullMode {
+	enum Enum {
+		None,
+		Front,
+		Back,
+		Count
+	};
+};
+
+struct PolygonMode {
+	enum Enum {
+		Fill,
+		Line,
+		Point,
+		Count
+	};
+};
+
+// Defaults match the initial GL state, except the depth test which every sample enables.
+struct DepthState {
+	bool mTestEnable = true;
+	bool mWriteEnable = true;
+	CompareFunc::Enum mFunc = CompareFunc::Less;
+};
+
+struct StencilState {
+	bool mEnable = false;
+	CompareFunc::Enum mFunc = CompareFunc::Always;
+	uint8_t mReference = 0;
+	uint8_t mReadMask = 0xff;
+	uint8_t mWriteMask = 0xff;
+	StencilOp::Enum mFail = StencilOp::Keep;
+	StencilOp::Enum mDepthFail = StencilOp::Keep;
+	StencilOp::Enum mPass = StencilOp::Keep;
+};
+
+struct BlendState {
+	bool mEnable = false;
+	BlendFactor::Enum mSrcColor = BlendFactor::One;
+	BlendFactor::Enum mDstColor = BlendFactor::Zero;
+	BlendFactor::Enum mSrcAlpha = BlendFactor::One;
+	BlendFactor::Enum mDstAlpha = BlendFactor::Zero;
+	BlendOp::Enum mColorOp = BlendOp::Add;
+	BlendOp::Enum mAlphaOp = BlendOp::Add;
+	uint8_t mColorWriteMask = 0xf;		// rgba bits
+};
+
+struct RasterState {
+	CullMode::Enum mCull = CullMode::None;
+	bool mFrontCounterClockwise = true;
+	PolygonMode::Enum mPolygon = PolygonMode::Fill;
+	bool mScissorEnable = false;
+	float mPolygonOffsetFactor = 0.0f;	// polygon offset is enabled when either value is not zero
+	float mPolygonOffsetUnits = 0.0f;
+};
+
+// An invalid program or mesh leaves the currently bound one untouched.
+struct PipelineStateParams {
+	ShaderProgramHandle mProgram = ShaderProgramHandle(cInvalidHandle);
+	MeshHandle mMesh = MeshHandle(cInvalidHandle);
+	DepthState mDepth;
+	StencilState mStencil;
+	BlendState mBlend;
+	RasterState mRaster;
+};
+
+struct PipelineStateStats {
+	uint32_t mApplies = 0;
+	uint32_t mStateCalls = 0;		// fixed function GL calls issued
+	uint32_t mSkippedCalls = 0;		// fixed function GL calls elided because the state was already set
+};
+
+using PipelineStateHandle = ResourceHandle;
+
+// States are hashed at creation, creating a state equal to an existing one returns the same handle.
+PipelineStateHandle PipelineState_Create(const PipelineStateParams& params);
+
+// Releases one reference, the state is freed with the last one.
+void PipelineState_Destroy(const PipelineStateHandle& handle);
+
+void PipelineState_Apply(const PipelineStateHandle& handle);
+
+// Partial applies for code that only owns part of the pipeline (e.g. the render queue translucent pass).
+void PipelineState_ApplyDepth(const DepthState& state);
+void PipelineState_ApplyStencil(const StencilState& state);
+void PipelineState_ApplyBlend(const BlendState& state);
+void PipelineState_ApplyRaster(const RasterState& state);
+
+// Forgets the cached state, the current program and the bound vertex array included, to be called after GL state
+// was changed outside of this module.
+void PipelineState_InvalidateCache();
+
+uint32_t PipelineState_GetCount();
+
+const PipelineStateStats& PipelineState_GetStats();
+
+void PipelineState_ResetStats();
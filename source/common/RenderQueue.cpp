@@ -0,0 +1,218 @@
+#include "RenderQueue.h"
+
+#include "PipelineState.h"
+#include "Texture.h"
+#include <utility>
+
+namespace
+{
+
+constexpr uint32_t cLayerBits = 4;
+constexpr uint32_t cProgramBits = 6;
+constexpr uint32_t cMaterialBits = 12;
+constexpr uint32_t cMeshBits = 10;
+constexpr uint32_t cDepthBits = 24;
+
+constexpr uint32_t cMaterialStages = 3;
+
+inline uint64_t Bits(uint32_t value, uint32_t bits) {
+	return uint64_t(value) & ((uint64_t(1) << bits) - 1);
+}
+
+uint64_t MakeKey(const RenderPacket& packet, uint32_t depth) {
+	uint64_t key = Bits(packet.mLayer, cLayerBits);
+	key = (key << 1) | (packet.mTranslucent ? 1 : 0);
+	if (packet.mTranslucent) {
+		key = (key << cDepthBits) | Bits(~depth, cDepthBits);
+		key = (key << cProgramBits) | Bits(packet.mProgram.mHandle, cProgramBits);
+		key = (key << cMaterialBits) | Bits(packet.mMaterial, cMaterialBits);
+		key = (key << cMeshBits) | Bits(packet.mMesh.mHandle, cMeshBits);
+	} else {
+		key = (key << cProgramBits) | Bits(packet.mProgram.mHandle, cProgramBits);
+		key = (key << cMaterialBits) | Bits(packet.mMaterial, cMaterialBits);
+		key = (key << cMeshBits) | Bits(packet.mMesh.mHandle, cMeshBits);
+		key = (key << cDepthBits) | Bits(depth, cDepthBits);
+	}
+	return key;
+}
+
+// Walks the packets in queue order tracking the bound state; GL calls are only issued when submit is set.
+void Walk(const RenderQueue& queue, const Material* materials, uint32_t materialsCount, const RenderQueueProgramCallback* callback, bool submit, RenderQueueStats& stats) {
+	static const char* cSamplerNames[cMaterialStages] = { "u_material.diffuse", "u_material.specular", "u_material.emissive" };
+
+	stats = RenderQueueStats();
+
+	uint32_t program = cInvalidHandle;
+	uint32_t material = cInvalidHandle;
+	uint32_t mesh = cInvalidHandle;
+	uint32_t textures[cMaterialStages] = { cInvalidHandle, cInvalidHandle, cInvalidHandle };
+	bool translucent = false;
+
+	DepthState opaqueDepth;
+	DepthState translucentDepth;
+	translucentDepth.mWriteEnable = false;
+	BlendState opaqueBlend;
+	BlendState translucentBlend;
+	translucentBlend.mEnable = true;
+	translucentBlend.mSrcColor = BlendFactor::SrcAlpha;
+	translucentBlend.mDstColor = BlendFactor::OneMinusSrcAlpha;
+	translucentBlend.mSrcAlpha = BlendFactor::SrcAlpha;
+	translucentBlend.mDstAlpha = BlendFactor::OneMinusSrcAlpha;
+
+	for (uint32_t index : queue.mOrder) {
+		const RenderPacket& packet = queue.mPackets[index];
+		if (!packet.mProgram.IsValid() || !packet.mMesh.IsValid()) {
+			continue;
+		}
+
+		if (submit && packet.mTranslucent != translucent) {
+			translucent = packet.mTranslucent;
+			PipelineState_ApplyDepth(translucent ? translucentDepth : opaqueDepth);
+			PipelineState_ApplyBlend(translucent ? translucentBlend : opaqueBlend);
+		}
+
+		const bool programChanged = (packet.mProgram.mHandle != program);
+		if (programChanged) {
+			program = packet.mProgram.mHandle;
+			material = cInvalidHandle;
+			stats.mProgramChanges++;
+			if (submit) {
+				ShaderProgram_Use(packet.mProgram);
+				if (*callback) {
+					(*callback)(packet.mProgram);
+				}
+			}
+		}
+
+		if (packet.mMaterial != material && packet.mMaterial < materialsCount) {
+			material = packet.mMaterial;
+			stats.mMaterialChanges++;
+
+			const Material& data = materials[material];
+			const TextureHandle stageTextures[cMaterialStages] = { data.mDiffuse, data.mSpecular, data.mEmissive };
+			for (uint8_t stage = 0; stage < cMaterialStages; stage++) {
+				if (!stageTextures[stage].IsValid()) {
+					continue;
+				}
+				if (stageTextures[stage].mHandle != textures[stage]) {
+					textures[stage] = stageTextures[stage].mHandle;
+					stats.mTextureBinds++;
+					if (submit) {
+						Texture_Bind(stageTextures[stage], stage);
+					}
+				}
+				// sampler units are program state, only set them when the program changed
+				if (submit && programChanged) {
+					ShaderProgram_SetInt(packet.mProgram, cSamplerNames[stage], stage);
+				}
+			}
+			if (submit) {
+				ShaderProgram_SetFloat(packet.mProgram, "u_material.shininess", data.mShininess);
+			}
+		}
+
+		if (packet.mMesh.mHandle != mesh) {
+			mesh = packet.mMesh.mHandle;
+			stats.mMeshChanges++;
+		}
+
+		stats.mDraws++;
+		if (submit) {
+			ShaderProgram_SetMat4(packet.mProgram, "u_model", packet.mModel);
+			ShaderProgram_SetMat4(packet.mProgram, "u_modelView", queue.mView * packet.mModel);
+			ShaderProgram_SetMat4(packet.mProgram, "u_modelViewProj", queue.mViewProj * packet.mModel);
+			if (packet.mIndexCount > 0) {
+				Mesh_DrawRange(packet.mMesh, packet.mFirstIndex, packet.mIndexCount);
+			} else {
+				Mesh_Draw(packet.mMesh);
+			}
+		}
+	}
+
+	if (submit && translucent) {
+		PipelineState_ApplyDepth(opaqueDepth);
+		PipelineState_ApplyBlend(opaqueBlend);
+	}
+}
+
+}
+
+void RenderQueue_Begin(RenderQueue& queue, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane) {
+	queue.mPackets.clear();
+	queue.mKeys.clear();
+	queue.mOrder.clear();
+	queue.mView = view;
+	queue.mViewProj = projection * view;
+	queue.mNear = nearPlane;
+	queue.mFar = farPlane;
+}
+
+void RenderQueue_Add(RenderQueue& queue, const RenderPacket& packet) {
+	// view space distance of the object origin, quantized over the clip range
+	float distance = -(queue.mView * packet.mModel[3]).z;
+	float depth = (distance - queue.mNear) / (queue.mFar - queue.mNear);
+	depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+	uint32_t quantized = uint32_t(depth * float((1 << cDepthBits) - 1));
+
+	queue.mOrder.push_back(static_cast<uint32_t>(queue.mPackets.size()));
+	queue.mKeys.push_back(MakeKey(packet, quantized));
+	queue.mPackets.push_back(packet);
+}
+
+void RenderQueue_Sort(RenderQueue& queue) {
+	const size_t count = queue.mKeys.size();
+	if (count < 2) {
+		return;
+	}
+	queue.mScratchKeys.resize(count);
+	queue.mScratchOrder.resize(count);
+
+	uint64_t* keys = queue.mKeys.data();
+	uint32_t* order = queue.mOrder.data();
+	uint64_t* scratchKeys = queue.mScratchKeys.data();
+	uint32_t* scratchOrder = queue.mScratchOrder.data();
+
+	bool swapped = false;
+	for (uint32_t shift = 0; shift < 64; shift += 8) {
+		size_t histogram[256] = {};
+		for (size_t i = 0; i < count; i++) {
+			histogram[(keys[i] >> shift) & 0xff]++;
+		}
+		if (histogram[(keys[0] >> shift) & 0xff] == count) {
+			continue;
+		}
+
+		size_t offset = 0;
+		for (uint32_t digit = 0; digit < 256; digit++) {
+			size_t digitCount = histogram[digit];
+			histogram[digit] = offset;
+			offset += digitCount;
+		}
+		for (size_t i = 0; i < count; i++) {
+			size_t destination = histogram[(keys[i] >> shift) & 0xff]++;
+			scratchKeys[destination] = keys[i];
+			scratchOrder[destination] = order[i];
+		}
+
+		std::swap(keys, scratchKeys);
+		std::swap(order, scratchOrder);
+		swapped = !swapped;
+	}
+
+	if (swapped) {
+		queue.mKeys.swap(queue.mScratchKeys);
+		queue.mOrder.swap(queue.mScratchOrder);
+	}
+}
+
+void RenderQueue_CountStateChanges(const RenderQueue& queue, const Material* materials, uint32_t materialsCount, RenderQueueStats& stats) {
+	Walk(queue, materials, materialsCount, nullptr, false, stats);
+}
+
+void RenderQueue_Submit(const RenderQueue& queue, const Material* materials, uint32_t materialsCount, const RenderQueueProgramCallback& callback, RenderQueueStats* stats) {
+	RenderQueueStats submitStats;
+	Walk(queue, materials, materialsCount, &callback, true, submitStats);
+	if (stats) {
+		*stats = submitStats;
+	}
+}
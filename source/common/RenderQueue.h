@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "ShaderProgram.h"
+#include "glm/mat4x4.hpp"
+
+#include <functional>
+#include <vector>
+
+// One draw of a mesh (or of an index range of it when mIndexCount > 0). mMaterial indexes the materials array
+// passed to RenderQueue_Submit; the queue sets u_model, u_modelView and u_modelViewProj for every packet.
+struct RenderPacket {
+	ShaderProgramHandle mProgram = ShaderProgramHandle(cInvalidHandle);
+	MeshHandle mMesh = MeshHandle(cInvalidHandle);
+	uint32_t mMaterial = 0;
+	uint32_t mFirstIndex = 0;
+	uint32_t mIndexCount = 0;
+	uint8_t mLayer = 0;
+	bool mTranslucent = false;
+	glm::mat4 mModel = glm::mat4(1.0f);
+};
+
+struct RenderQueueStats {
+	uint32_t mDraws = 0;
+	uint32_t mProgramChanges = 0;
+	uint32_t mMaterialChanges = 0;
+	uint32_t mTextureBinds = 0;
+	uint32_t mMeshChanges = 0;
+};
+
+// Called whenever the submission switches program, to set the per frame uniforms (lights, camera...).
+using RenderQueueProgramCallback = std::function<void(const ShaderProgramHandle&)>;
+
+// Sort key, most significant bits first:
+//   opaque:      layer (4) | 0 | program (6) | material (12) | mesh (10) | depth (24), front to back
+//   translucent: layer (4) | 1 | inverted depth (24) | program (6) | material (12) | mesh (10), back to front
+struct RenderQueue {
+	std::vector<RenderPacket> mPackets;
+	std::vector<uint64_t> mKeys;
+	std::vector<uint32_t> mOrder;
+	std::vector<uint64_t> mScratchKeys;
+	std::vector<uint32_t> mScratchOrder;
+
+	glm::mat4 mView = glm::mat4(1.0f);
+	glm::mat4 mViewProj = glm::mat4(1.0f);
+	float mNear = 0.1f;
+	float mFar = 100.0f;
+};
+
+void RenderQueue_Begin(RenderQueue& queue, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane);
+
+void RenderQueue_Add(RenderQueue& queue, const RenderPacket& packet);
+
+// LSD radix sort of the packet keys, 8 bits per pass; passes where every key shares the same digit are skipped.
+void RenderQueue_Sort(RenderQueue& queue);
+
+// Counts the state changes the current packet order would cause, without issuing any GL call.
+void RenderQueue_CountStateChanges(const RenderQueue& queue, const Material* materials, uint32_t materialsCount, RenderQueueStats& stats);
+
+// Draws the packets in their current order, skipping program, texture and uniform updates that would not change anything.
+void RenderQueue_Submit(const RenderQueue& queue, const Material* materials, uint32_t materialsCount, const RenderQueueProgramCallback& callback, RenderQueueStats* stats = nullptr);
@@ -0,0 +1,264 @@
+#include "RenderTarget.h"
+
+#include "GLApi.h"
+#include <array>
+
+namespace
+{
+
+// framebuffer standing for the window one, a render target when the context is headless
+GLuint sDefaultFramebuffer = 0;
+
+class RenderTarget {
+public:
+	RenderTarget() = default;
+	~RenderTarget() {
+		Destroy();
+	}
+
+	void Create(const RenderTargetParams& params) {
+		glGenFramebuffers(1, &mId);
+		GL_ERROR(mId == 0);
+
+		mParams = params;
+		mWidth = (params.mColorsCount > 0) ? Texture_GetWidth(params.mColors[0]) : Texture_GetWidth(params.mDepth);
+		mHeight = (params.mColorsCount > 0) ? Texture_GetHeight(params.mColors[0]) : Texture_GetHeight(params.mDepth);
+
+		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, mId));
+		Attach();
+		if (!SetDrawBuffers()) {
+			Destroy();
+		}
+	}
+
+	bool SetAttachments(const RenderTargetParams& params) {
+		if (!IsValid()) {
+			return false;
+		}
+		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, mId));
+		Detach();
+		mParams = params;
+		mWidth = (params.mColorsCount > 0) ? Texture_GetWidth(params.mColors[0]) : Texture_GetWidth(params.mDepth);
+		mHeight = (params.mColorsCount > 0) ? Texture_GetHeight(params.mColors[0]) : Texture_GetHeight(params.mDepth);
+		Attach();
+		return SetDrawBuffers();
+	}
+
+	bool Invalidate(uint32_t colorsMask, bool depth) {
+		GLenum attachments[cMaxRenderTargetColors + 1];
+		GLsizei count = 0;
+		for (uint32_t i = 0; i < mParams.mColorsCount; i++) {
+			if (colorsMask & (1u << i)) {
+				attachments[count++] = GL_COLOR_ATTACHMENT0 + i;
+			}
+		}
+		if (depth && mParams.mDepth.IsValid()) {
+			attachments[count++] = GetDepthAttachment();
+		}
+		if (!IsValid() || count == 0) {
+			return false;
+		}
+		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, mId));
+		GL_CHECK(glInvalidateFramebuffer(GL_FRAMEBUFFER, count, attachments));
+		return true;
+	}
+
+	void Destroy() {
+		if (IsValid()) {
+			GL_CHECK(glDeleteFramebuffers(1, &mId));
+			mId = 0;
+		}
+	}
+
+	void Bind() {
+		if (IsValid()) {
+			GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, mId));
+			GL_CHECK(glViewport(0, 0, GLsizei(mWidth), GLsizei(mHeight)));
+		}
+	}
+
+	GLuint GetId() const {
+		return mId;
+	}
+
+	void Resize(uint32_t width, uint32_t height) {
+		if (!IsValid() || (width == mWidth && height == mHeight)) {
+			return;
+		}
+		for (uint32_t i = 0; i < mParams.mColorsCount; i++) {
+			Texture_Resize(mParams.mColors[i], width, height);
+		}
+		Texture_Resize(mParams.mDepth, width, height);
+		mWidth = width;
+		mHeight = height;
+
+		// reattaching makes the framebuffer revalidated against the new storage on every driver
+		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, mId));
+		Attach();
+		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, sDefaultFramebuffer));
+	}
+
+	bool IsValid() const {
+		return mId > 0;
+	}
+
+	uint32_t GetWidth() const {
+		return mWidth;
+	}
+
+	uint32_t GetHeight() const {
+		return mHeight;
+	}
+
+private:
+	GLenum GetDepthAttachment() const {
+		return (Texture_GetFormat(mParams.mDepth) == TextureFormats::Depth24Stencil8) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+	}
+
+	void Attach() {
+		for (uint32_t i = 0; i < mParams.mColorsCount; i++) {
+			GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, Texture_GetNativeId(mParams.mColors[i]), 0));
+		}
+		if (mParams.mDepth.IsValid()) {
+			GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GetDepthAttachment(), GL_TEXTURE_2D, Texture_GetNativeId(mParams.mDepth), 0));
+		}
+	}
+
+	void Detach() {
+		for (uint32_t i = 0; i < mParams.mColorsCount; i++) {
+			GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, 0, 0));
+		}
+		if (mParams.mDepth.IsValid()) {
+			GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GetDepthAttachment(), GL_TEXTURE_2D, 0, 0));
+		}
+	}
+
+	// Expects the framebuffer bound, unbinds it.
+	bool SetDrawBuffers() {
+		GLenum drawBuffers[cMaxRenderTargetColors];
+		for (uint32_t i = 0; i < mParams.mColorsCount; i++) {
+			drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		}
+		if (mParams.mColorsCount > 0) {
+			GL_CHECK(glDrawBuffers(GLsizei(mParams.mColorsCount), drawBuffers));
+			GL_CHECK(glReadBuffer(GL_COLOR_ATTACHMENT0));
+		} else {
+			// depth only, e.g. shadow maps
+			GL_CHECK(glDrawBuffer(GL_NONE));
+			GL_CHECK(glReadBuffer(GL_NONE));
+		}
+
+		const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, sDefaultFramebuffer));
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			Log(tinyngine::Logger::Error, "Incomplete framebuffer 0x%x", status);
+			return false;
+		}
+		return true;
+	}
+
+	GLuint mId = 0;
+	RenderTargetParams mParams;
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+};
+
+static constexpr uint32_t cMaxRenderTargetHandles = (1 << 6);
+uint32_t sRenderTargetsCount = 0;
+std::array<RenderTarget, cMaxRenderTargetHandles> sRenderTargets;
+
+}
+
+RenderTargetHandle RenderTarget_Create(const RenderTargetParams& params) {
+	if (params.mColorsCount > cMaxRenderTargetColors || (params.mColorsCount == 0 && !params.mDepth.IsValid()) ||
+		sRenderTargetsCount >= cMaxRenderTargetHandles) {
+		return RenderTargetHandle(cInvalidHandle);
+	}
+
+	RenderTargetHandle handle = RenderTargetHandle(sRenderTargetsCount);
+	auto& renderTarget = sRenderTargets[handle.mHandle];
+	renderTarget.Create(params);
+
+	if (renderTarget.IsValid()) {
+		sRenderTargetsCount++;
+		return handle;
+	}
+	return RenderTargetHandle(cInvalidHandle);
+}
+
+void RenderTarget_Destroy(const RenderTargetHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& renderTarget = sRenderTargets[handle.mHandle];
+	renderTarget.Destroy();
+}
+
+void RenderTarget_Bind(const RenderTargetHandle& handle) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& renderTarget = sRenderTargets[handle.mHandle];
+	renderTarget.Bind();
+}
+
+void RenderTarget_BindDefault(uint32_t width, uint32_t height) {
+	GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, sDefaultFramebuffer));
+	GL_CHECK(glViewport(0, 0, GLsizei(width), GLsizei(height)));
+}
+
+void RenderTarget_SetDefault(const RenderTargetHandle& handle) {
+	sDefaultFramebuffer = handle.IsValid() ? sRenderTargets[handle.mHandle].GetId() : 0;
+	GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, sDefaultFramebuffer));
+}
+
+void RenderTarget_BlitDepth(const RenderTargetHandle& source, const RenderTargetHandle& destination) {
+	if (!source.IsValid() || !destination.IsValid()) {
+		return;
+	}
+	const auto& from = sRenderTargets[source.mHandle];
+	auto& to = sRenderTargets[destination.mHandle];
+	GL_CHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, from.GetId()));
+	GL_CHECK(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, to.GetId()));
+	GL_CHECK(glBlitFramebuffer(0, 0, GLint(from.GetWidth()), GLint(from.GetHeight()), 0, 0, GLint(to.GetWidth()), GLint(to.GetHeight()),
+		GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST));
+	to.Bind();
+}
+
+void RenderTarget_Resize(const RenderTargetHandle& handle, uint32_t width, uint32_t height) {
+	if (!handle.IsValid() || width == 0 || height == 0) {
+		return;
+	}
+	auto& renderTarget = sRenderTargets[handle.mHandle];
+	renderTarget.Resize(width, height);
+}
+
+bool RenderTarget_SetAttachments(const RenderTargetHandle& handle, const RenderTargetParams& params) {
+	if (!handle.IsValid() || params.mColorsCount > cMaxRenderTargetColors || (params.mColorsCount == 0 && !params.mDepth.IsValid())) {
+		return false;
+	}
+	auto& renderTarget = sRenderTargets[handle.mHandle];
+	return renderTarget.SetAttachments(params);
+}
+
+bool RenderTarget_Invalidate(const RenderTargetHandle& handle, uint32_t colorsMask, bool depth) {
+	if (!handle.IsValid() || GLAD_GL_VERSION_4_3 == 0 || glInvalidateFramebuffer == nullptr) {
+		return false;
+	}
+	auto& renderTarget = sRenderTargets[handle.mHandle];
+	return renderTarget.Invalidate(colorsMask, depth);
+}
+
+uint32_t RenderTarget_GetWidth(const RenderTargetHandle& handle) {
+	if (!handle.IsValid()) {
+		return 0;
+	}
+	return sRenderTargets[handle.mHandle].GetWidth();
+}
+
+uint32_t RenderTarget_GetHeight(const RenderTargetHandle& handle) {
+	if (!handle.IsValid()) {
+		return 0;
+	}
+	return sRenderTargets[handle.mHandle].GetHeight();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Texture.h"
+
+static constexpr uint32_t cMaxRenderTargetColors = 4;
+
+// Framebuffer object over render target textures (see Texture_CreateRenderTarget), all of the same size. Color
+// attachments are written by the fragment shader outputs 0 to mColorsCount - 1, a Depth24Stencil8 depth texture is
+// attached to the stencil too.
+struct RenderTargetParams {
+	TextureHandle mColors[cMaxRenderTargetColors];
+	uint32_t mColorsCount = 0;
+	TextureHandle mDepth = TextureHandle(cInvalidHandle);
+};
+
+using RenderTargetHandle = ResourceHandle;
+
+// Returns an invalid handle when the attachments do not make a complete framebuffer.
+RenderTargetHandle RenderTarget_Create(const RenderTargetParams& params);
+
+// The attachments are not destroyed.
+void RenderTarget_Destroy(const RenderTargetHandle& handle);
+
+// Binds the target for drawing and sets the viewport to its size.
+void RenderTarget_Bind(const RenderTargetHandle& handle);
+
+// Binds the window framebuffer back.
+void RenderTarget_BindDefault(uint32_t width, uint32_t height);
+
+// Target bound in place of the window framebuffer from now on, by RenderTarget_BindDefault and whenever a target is
+// unbound, e.g. the backbuffer of a headless context. An invalid handle restores the window framebuffer.
+void RenderTarget_SetDefault(const RenderTargetHandle& handle);
+
+// Copies depth and stencil between two targets of the same size and depth format, leaves the destination bound.
+void RenderTarget_BlitDepth(const RenderTargetHandle& source, const RenderTargetHandle& destination);
+
+// Resizes every attachment, to be called instead of Texture_Resize on them.
+void RenderTarget_Resize(const RenderTargetHandle& handle, uint32_t width, uint32_t height);
+
+// Replaces the attachments of a target, keeping its framebuffer object and handle. Returns false when the new ones do
+// not make a complete framebuffer. The previous attachments are not destroyed.
+bool RenderTarget_SetAttachments(const RenderTargetHandle& handle, const RenderTargetParams& params);
+
+// Tells the driver the content of the selected attachments is no longer needed (glInvalidateFramebuffer), so tiled
+// GPUs do not store it and others can skip decompressing it. Bit i of colorsMask selects color attachment i. Leaves
+// the target bound without setting the viewport, returns false when GL 4.3 is not available.
+bool RenderTarget_Invalidate(const RenderTargetHandle& handle, uint32_t colorsMask, bool depth);
+
+uint32_t RenderTarget_GetWidth(const RenderTargetHandle& handle);
+
+uint32_t RenderTarget_GetHeight(const RenderTargetHandle& handle);
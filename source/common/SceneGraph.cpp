@@ -0,0 +1,368 @@
+#include "SceneGraph.h"
+
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include <immintrin.h>
+#include <algorithm>
+
+namespace
+{
+
+constexpr uint8_t cFlagLocalDirty = 1 << 0;
+constexpr uint8_t cFlagWorldDirty = 1 << 1;
+
+// smallest range of dirty nodes of a depth worth a job
+constexpr uint32_t cMinNodesPerJob = 2048;
+
+using MultiplyFunction = void(*)(const float* a, const float* b, float* out);
+
+// column j of the result is a combination of the columns of a weighted by column j of b
+void MultiplySSE(const float* a, const float* b, float* out) {
+	const __m128 a0 = _mm_loadu_ps(a + 0);
+	const __m128 a1 = _mm_loadu_ps(a + 4);
+	const __m128 a2 = _mm_loadu_ps(a + 8);
+	const __m128 a3 = _mm_loadu_ps(a + 12);
+	for (uint32_t column = 0; column < 4; column++) {
+		const float* bColumn = b + column * 4;
+		__m128 result = _mm_mul_ps(a0, _mm_set1_ps(bColumn[0]));
+		result = _mm_add_ps(result, _mm_mul_ps(a1, _mm_set1_ps(bColumn[1])));
+		result = _mm_add_ps(result, _mm_mul_ps(a2, _mm_set1_ps(bColumn[2])));
+		result = _mm_add_ps(result, _mm_mul_ps(a3, _mm_set1_ps(bColumn[3])));
+		_mm_storeu_ps(out + column * 4, result);
+	}
+}
+
+// two result columns per register: the columns of a are duplicated in both halves, the in-lane permutes
+// broadcast the weights of the two columns of b
+TINYNGINE_TARGET_AVX2
+void MultiplyAVX2(const float* a, const float* b, float* out) {
+	const __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 0));
+	const __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 4));
+	const __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 8));
+	const __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 12));
+	for (uint32_t column = 0; column < 4; column += 2) {
+		const __m256 weights = _mm256_loadu_ps(b + column * 4);
+		__m256 result = _mm256_mul_ps(a0, _mm256_permute_ps(weights, 0x00));
+		result = _mm256_fmadd_ps(a1, _mm256_permute_ps(weights, 0x55), result);
+		result = _mm256_fmadd_ps(a2, _mm256_permute_ps(weights, 0xaa), result);
+		result = _mm256_fmadd_ps(a3, _mm256_permute_ps(weights, 0xff), result);
+		_mm256_storeu_ps(out + column * 4, result);
+	}
+	_mm256_zeroupper();
+}
+
+const MultiplyFunction sMultiply = Cpu_HasAVX2() ? MultiplyAVX2 : MultiplySSE;
+
+// Builds the local matrices of 4 slots at a time from the structure of arrays, one node per lane.
+void ComposeLocal(SceneGraph& graph, const uint32_t* slots, uint32_t count) {
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	for (uint32_t first = 0; first < count; first += 4) {
+		uint32_t lanes[4];
+		for (uint32_t lane = 0; lane < 4; lane++) {
+			// a partial batch repeats its last slot, computing it twice is harmless
+			lanes[lane] = slots[std::min(first + lane, count - 1)];
+		}
+		auto gather = [&lanes](const std::vector<float>& values) {
+			return _mm_setr_ps(values[lanes[0]], values[lanes[1]], values[lanes[2]], values[lanes[3]]);
+		};
+		const __m128 x = gather(graph.mRotationX);
+		const __m128 y = gather(graph.mRotationY);
+		const __m128 z = gather(graph.mRotationZ);
+		const __m128 w = gather(graph.mRotationW);
+		const __m128 scaleX = gather(graph.mScaleX);
+		const __m128 scaleY = gather(graph.mScaleY);
+		const __m128 scaleZ = gather(graph.mScaleZ);
+
+		const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+		const __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+		const __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+		__m128 column0[4] = {
+			_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), scaleX),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), scaleX),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), scaleX),
+			_mm_setzero_ps()
+		};
+		__m128 column1[4] = {
+			_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), scaleY),
+			_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), scaleY),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), scaleY),
+			_mm_setzero_ps()
+		};
+		__m128 column2[4] = {
+			_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), scaleZ),
+			_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), scaleZ),
+			_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), scaleZ),
+			_mm_setzero_ps()
+		};
+		__m128 column3[4] = { gather(graph.mTranslationX), gather(graph.mTranslationY), gather(graph.mTranslationZ), one };
+
+		// from one component of every node per register to one column of a node per register
+		_MM_TRANSPOSE4_PS(column0[0], column0[1], column0[2], column0[3]);
+		_MM_TRANSPOSE4_PS(column1[0], column1[1], column1[2], column1[3]);
+		_MM_TRANSPOSE4_PS(column2[0], column2[1], column2[2], column2[3]);
+		_MM_TRANSPOSE4_PS(column3[0], column3[1], column3[2], column3[3]);
+		for (uint32_t lane = 0; lane < 4 && first + lane < count; lane++) {
+			float* local = &graph.mLocal[lanes[lane]][0][0];
+			_mm_storeu_ps(local + 0, column0[lane]);
+			_mm_storeu_ps(local + 4, column1[lane]);
+			_mm_storeu_ps(local + 8, column2[lane]);
+			_mm_storeu_ps(local + 12, column3[lane]);
+		}
+	}
+}
+
+// World matrices of independent slots (same depth), parents are already up to date.
+void UpdateWorld(SceneGraph& graph, const uint32_t* slots, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		const uint32_t slot = slots[i];
+		const uint32_t parent = graph.mParents[slot];
+		if (parent == cInvalidHandle) {
+			graph.mWorld[slot] = graph.mLocal[slot];
+		} else {
+			sMultiply(&graph.mWorld[parent][0][0], &graph.mLocal[slot][0][0], &graph.mWorld[slot][0][0]);
+		}
+	}
+}
+
+template<typename T>
+void Permute(std::vector<T>& values, const std::vector<uint32_t>& order) {
+	std::vector<T> sorted(values.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		sorted[i] = values[order[i]];
+	}
+	values.swap(sorted);
+}
+
+// Stable counting sort of the slots by depth, every node is dirty afterwards.
+void Sort(SceneGraph& graph) {
+	const uint32_t count = static_cast<uint32_t>(graph.mNodes.size());
+	uint32_t levels = 0;
+	for (uint32_t depth : graph.mDepths) {
+		levels = std::max(levels, depth + 1);
+	}
+	graph.mLevelStarts.assign(levels + 1, 0);
+	for (uint32_t depth : graph.mDepths) {
+		graph.mLevelStarts[depth + 1]++;
+	}
+	for (uint32_t level = 0; level < levels; level++) {
+		graph.mLevelStarts[level + 1] += graph.mLevelStarts[level];
+	}
+
+	std::vector<uint32_t> order(count);
+	std::vector<uint32_t> newSlots(count);
+	std::vector<uint32_t> cursors(graph.mLevelStarts.begin(), graph.mLevelStarts.end() - 1);
+	for (uint32_t slot = 0; slot < count; slot++) {
+		const uint32_t sortedSlot = cursors[graph.mDepths[slot]]++;
+		order[sortedSlot] = slot;
+		newSlots[slot] = sortedSlot;
+	}
+
+	Permute(graph.mTranslationX, order);
+	Permute(graph.mTranslationY, order);
+	Permute(graph.mTranslationZ, order);
+	Permute(graph.mRotationX, order);
+	Permute(graph.mRotationY, order);
+	Permute(graph.mRotationZ, order);
+	Permute(graph.mRotationW, order);
+	Permute(graph.mScaleX, order);
+	Permute(graph.mScaleY, order);
+	Permute(graph.mScaleZ, order);
+	Permute(graph.mParents, order);
+	Permute(graph.mDepths, order);
+	Permute(graph.mNodes, order);
+	for (uint32_t& parent : graph.mParents) {
+		parent = (parent == cInvalidHandle) ? cInvalidHandle : newSlots[parent];
+	}
+	for (uint32_t slot = 0; slot < count; slot++) {
+		graph.mSlots[graph.mNodes[slot]] = slot;
+	}
+
+	graph.mLocal.resize(count);
+	graph.mWorld.resize(count);
+	graph.mFlags.assign(count, cFlagLocalDirty);
+	graph.mDirtySlots.resize(count);
+	for (uint32_t slot = 0; slot < count; slot++) {
+		graph.mDirtySlots[slot] = slot;
+	}
+	graph.mNeedsSort = false;
+}
+
+void MarkDirty(SceneGraph& graph, uint32_t slot) {
+	if ((graph.mFlags[slot] & cFlagLocalDirty) == 0) {
+		graph.mFlags[slot] |= cFlagLocalDirty;
+		graph.mDirtySlots.push_back(slot);
+	}
+}
+
+}
+
+SceneNode SceneGraph_AddNode(SceneGraph& graph, SceneNode parent, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+	const uint32_t parentSlot = (parent < graph.mSlots.size()) ? graph.mSlots[parent] : cInvalidHandle;
+	const SceneNode node = static_cast<SceneNode>(graph.mSlots.size());
+	const uint32_t slot = static_cast<uint32_t>(graph.mNodes.size());
+
+	graph.mSlots.push_back(slot);
+	graph.mNodes.push_back(node);
+	graph.mParents.push_back(parentSlot);
+	graph.mDepths.push_back(parentSlot == cInvalidHandle ? 0 : graph.mDepths[parentSlot] + 1);
+	graph.mTranslationX.push_back(translation.x);
+	graph.mTranslationY.push_back(translation.y);
+	graph.mTranslationZ.push_back(translation.z);
+	graph.mRotationX.push_back(rotation.x);
+	graph.mRotationY.push_back(rotation.y);
+	graph.mRotationZ.push_back(rotation.z);
+	graph.mRotationW.push_back(rotation.w);
+	graph.mScaleX.push_back(scale.x);
+	graph.mScaleY.push_back(scale.y);
+	graph.mScaleZ.push_back(scale.z);
+	graph.mFlags.push_back(0);
+	graph.mLocal.push_back(glm::mat4(1.0f));
+	graph.mWorld.push_back(glm::mat4(1.0f));
+	// slots are sorted again at the next update
+	graph.mNeedsSort = true;
+	return node;
+}
+
+uint32_t SceneGraph_GetCount(const SceneGraph& graph) {
+	return static_cast<uint32_t>(graph.mNodes.size());
+}
+
+void SceneGraph_SetTranslation(SceneGraph& graph, SceneNode node, const glm::vec3& translation) {
+	if (node >= graph.mSlots.size()) {
+		return;
+	}
+	const uint32_t slot = graph.mSlots[node];
+	graph.mTranslationX[slot] = translation.x;
+	graph.mTranslationY[slot] = translation.y;
+	graph.mTranslationZ[slot] = translation.z;
+	MarkDirty(graph, slot);
+}
+
+void SceneGraph_SetRotation(SceneGraph& graph, SceneNode node, const glm::quat& rotation) {
+	if (node >= graph.mSlots.size()) {
+		return;
+	}
+	const uint32_t slot = graph.mSlots[node];
+	graph.mRotationX[slot] = rotation.x;
+	graph.mRotationY[slot] = rotation.y;
+	graph.mRotationZ[slot] = rotation.z;
+	graph.mRotationW[slot] = rotation.w;
+	MarkDirty(graph, slot);
+}
+
+void SceneGraph_SetScale(SceneGraph& graph, SceneNode node, const glm::vec3& scale) {
+	if (node >= graph.mSlots.size()) {
+		return;
+	}
+	const uint32_t slot = graph.mSlots[node];
+	graph.mScaleX[slot] = scale.x;
+	graph.mScaleY[slot] = scale.y;
+	graph.mScaleZ[slot] = scale.z;
+	MarkDirty(graph, slot);
+}
+
+void SceneGraph_SetLocal(SceneGraph& graph, SceneNode node, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+	SceneGraph_SetTranslation(graph, node, translation);
+	SceneGraph_SetRotation(graph, node, rotation);
+	SceneGraph_SetScale(graph, node, scale);
+}
+
+glm::vec3 SceneGraph_GetTranslation(const SceneGraph& graph, SceneNode node) {
+	if (node >= graph.mSlots.size()) {
+		return glm::vec3(0.0f);
+	}
+	const uint32_t slot = graph.mSlots[node];
+	return glm::vec3(graph.mTranslationX[slot], graph.mTranslationY[slot], graph.mTranslationZ[slot]);
+}
+
+glm::quat SceneGraph_GetRotation(const SceneGraph& graph, SceneNode node) {
+	if (node >= graph.mSlots.size()) {
+		return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	}
+	const uint32_t slot = graph.mSlots[node];
+	return glm::quat(graph.mRotationW[slot], graph.mRotationX[slot], graph.mRotationY[slot], graph.mRotationZ[slot]);
+}
+
+const glm::mat4& SceneGraph_GetWorld(const SceneGraph& graph, SceneNode node) {
+	static const glm::mat4 sIdentity(1.0f);
+	return (node < graph.mSlots.size()) ? graph.mWorld[graph.mSlots[node]] : sIdentity;
+}
+
+uint32_t SceneGraph_Update(SceneGraph& graph, uint32_t threadsCount, SceneGraphStats* stats) {
+	SceneGraphStats updateStats;
+	if (graph.mNeedsSort) {
+		Sort(graph);
+	}
+	if (graph.mDirtySlots.empty()) {
+		if (stats) {
+			*stats = updateStats;
+		}
+		return 0;
+	}
+
+	const uint32_t dirtyCount = static_cast<uint32_t>(graph.mDirtySlots.size());
+	ComposeLocal(graph, graph.mDirtySlots.data(), dirtyCount);
+	uint32_t minLevel = static_cast<uint32_t>(graph.mLevelStarts.size());
+	uint32_t maxLevel = 0;
+	for (uint32_t slot : graph.mDirtySlots) {
+		graph.mFlags[slot] = cFlagWorldDirty;
+		minLevel = std::min(minLevel, graph.mDepths[slot]);
+		maxLevel = std::max(maxLevel, graph.mDepths[slot]);
+	}
+	updateStats.mLocalUpdates = dirtyCount;
+
+	// a node is recomputed when its local transform or its parent world matrix changed
+	std::vector<uint32_t>& updated = graph.mScratch;
+	updated.clear();
+	const uint32_t levels = static_cast<uint32_t>(graph.mLevelStarts.size()) - 1;
+	for (uint32_t level = minLevel; level < levels; level++) {
+		const size_t levelFirst = updated.size();
+		for (uint32_t slot = graph.mLevelStarts[level]; slot < graph.mLevelStarts[level + 1]; slot++) {
+			const uint32_t parent = graph.mParents[slot];
+			if ((graph.mFlags[slot] & cFlagWorldDirty) || (parent != cInvalidHandle && (graph.mFlags[parent] & cFlagWorldDirty))) {
+				graph.mFlags[slot] = cFlagWorldDirty;
+				updated.push_back(slot);
+			}
+		}
+		updateStats.mLevelsVisited++;
+
+		const uint32_t levelCount = static_cast<uint32_t>(updated.size() - levelFirst);
+		if (levelCount == 0) {
+			if (level >= maxLevel) {
+				break;
+			}
+			continue;
+		}
+
+		const uint32_t* levelSlots = updated.data() + levelFirst;
+		if (threadsCount <= 1) {
+			UpdateWorld(graph, levelSlots, levelCount);
+			continue;
+		}
+		Job_ParallelFor(levelCount, cMinNodesPerJob, [&graph, levelSlots](uint32_t begin, uint32_t end) {
+			UpdateWorld(graph, levelSlots + begin, end - begin);
+		});
+	}
+
+	for (uint32_t slot : updated) {
+		graph.mFlags[slot] = 0;
+	}
+	graph.mDirtySlots.clear();
+
+	updateStats.mWorldUpdates = static_cast<uint32_t>(updated.size());
+	if (stats) {
+		*stats = updateStats;
+	}
+	return updateStats.mWorldUpdates;
+}
+
+void SceneGraph_MultiplyBatch(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, uint32_t count) {
+	if (a == nullptr || b == nullptr || out == nullptr) {
+		return;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		sMultiply(&a[i][0][0], &b[i][0][0], &out[i][0][0]);
+	}
+}
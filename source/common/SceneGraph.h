@@ -0,0 +1,71 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include <vector>
+
+// Node ids are stable and returned by SceneGraph_AddNode. Internally nodes live in slots sorted by depth, so every
+// parent comes before its children and the nodes of one depth form a contiguous range whose world matrices do not
+// depend on each other.
+using SceneNode = uint32_t;
+
+struct SceneGraphStats {
+	uint32_t mLocalUpdates = 0;
+	uint32_t mWorldUpdates = 0;
+	uint32_t mLevelsVisited = 0;
+};
+
+struct SceneGraph {
+	// per slot, local transforms as structure of arrays
+	std::vector<float> mTranslationX;
+	std::vector<float> mTranslationY;
+	std::vector<float> mTranslationZ;
+	std::vector<float> mRotationX;
+	std::vector<float> mRotationY;
+	std::vector<float> mRotationZ;
+	std::vector<float> mRotationW;
+	std::vector<float> mScaleX;
+	std::vector<float> mScaleY;
+	std::vector<float> mScaleZ;
+	std::vector<uint32_t> mParents;			// parent slot, cInvalidHandle for roots
+	std::vector<uint32_t> mDepths;
+	std::vector<uint8_t> mFlags;
+	std::vector<glm::mat4> mLocal;
+	std::vector<glm::mat4> mWorld;
+
+	std::vector<uint32_t> mSlots;			// node to slot
+	std::vector<uint32_t> mNodes;			// slot to node
+	std::vector<uint32_t> mLevelStarts;		// first slot of every depth, plus the slots count
+	std::vector<uint32_t> mDirtySlots;		// slots whose local transform changed since the last update
+	std::vector<uint32_t> mScratch;
+	bool mNeedsSort = false;
+};
+
+SceneNode SceneGraph_AddNode(SceneGraph& graph, SceneNode parent, const glm::vec3& translation = glm::vec3(0.0f),
+	const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+
+uint32_t SceneGraph_GetCount(const SceneGraph& graph);
+
+void SceneGraph_SetTranslation(SceneGraph& graph, SceneNode node, const glm::vec3& translation);
+void SceneGraph_SetRotation(SceneGraph& graph, SceneNode node, const glm::quat& rotation);
+void SceneGraph_SetScale(SceneGraph& graph, SceneNode node, const glm::vec3& scale);
+void SceneGraph_SetLocal(SceneGraph& graph, SceneNode node, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+
+glm::vec3 SceneGraph_GetTranslation(const SceneGraph& graph, SceneNode node);
+glm::quat SceneGraph_GetRotation(const SceneGraph& graph, SceneNode node);
+
+// World matrix as of the last SceneGraph_Update.
+const glm::mat4& SceneGraph_GetWorld(const SceneGraph& graph, SceneNode node);
+
+// Recomputes the local matrices of the changed nodes and the world matrices of their subtrees, depth by depth.
+// Nothing is touched when no node changed. With threadsCount above 1, depths with enough dirty nodes are split in
+// job system ranges.
+// Returns the number of world matrices recomputed.
+uint32_t SceneGraph_Update(SceneGraph& graph, uint32_t threadsCount = 1, SceneGraphStats* stats = nullptr);
+
+// Batched out[i] = a[i] * b[i] (SSE, or two columns per instruction with AVX2), exposed for benchmarks and callers
+// composing their own matrices.
+void SceneGraph_MultiplyBatch(const glm::mat4* a, const glm::mat4* b, glm::mat4* out, uint32_t count);
@@ -30,6 +30,9 @@ bool CheckProgramDidCompile(uint32_t program) {
 	return true;
 }
 
+// glUseProgram is skipped when the program is already current
+GLuint sCurrentProgram = 0;
+
 class ShaderProgram {
 public:
 	ShaderProgram() = default;
@@ -46,6 +49,9 @@ public:
 	void Destroy() {
 		if (IsValid()) {
 			GL_CHECK(glDeleteProgram(mId));
+			if (sCurrentProgram == mId) {
+				sCurrentProgram = 0;
+			}
 			mId = 0;
 		}
 	}
@@ -80,8 +86,9 @@ public:
 	}
 
 	void Use() {
-		if (IsValid()) {
+		if (IsValid() && sCurrentProgram != mId) {
 			GL_CHECK(glUseProgram(mId));
+			sCurrentProgram = mId;
 		}
 	}
 
@@ -173,6 +180,14 @@ public:
 		}
 	}
 
+	void SetUniformBlock(const char* name, GLuint binding) {
+		if (IsValid() && name) {
+			GLuint index = glGetUniformBlockIndex(mId, name);
+			GL_ERROR(index == GL_INVALID_INDEX);
+			GL_CHECK(glUniformBlockBinding(mId, index, binding));
+		}
+	}
+
 	bool IsValid() const {
 		return mId > 0;
 	}
@@ -189,19 +204,22 @@ std::array<ShaderProgram, cMaxShaderProgramHandles> sShaderPrograms;
 }
 
 ShaderProgramHandle ShaderProgram_Create(const ShaderProgramParams& params) {
-	if (params.mVertexShaderData.empty()) {
+	if (params.mVertexShaderData.empty() && params.mComputeShaderData.empty()) {
 		return ShaderProgramHandle(cInvalidHandle);
 	}
 
-	const char* vertexShaderCode = params.mVertexShaderData.c_str();
-	const char* fragmentShaderCode = !params.mFragmentShaderData.empty() ? params.mFragmentShaderData.c_str() : nullptr;
-
 	ShaderProgramHandle handle = ShaderProgramHandle(sProgramsCount);
 	auto& program = sShaderPrograms[handle.mHandle];
 
 	program.Create();
-	program.AttachShader(GL_VERTEX_SHADER, vertexShaderCode);
-	program.AttachShader(GL_FRAGMENT_SHADER, fragmentShaderCode);
+	if (!params.mComputeShaderData.empty()) {
+		program.AttachShader(GL_COMPUTE_SHADER, params.mComputeShaderData.c_str());
+	} else {
+		const char* vertexShaderCode = params.mVertexShaderData.c_str();
+		const char* fragmentShaderCode = !params.mFragmentShaderData.empty() ? params.mFragmentShaderData.c_str() : nullptr;
+		program.AttachShader(GL_VERTEX_SHADER, vertexShaderCode);
+		program.AttachShader(GL_FRAGMENT_SHADER, fragmentShaderCode);
+	}
 	program.Link();
 
 	if (program.IsValid()) {
@@ -227,6 +245,19 @@ void ShaderProgram_Use(const ShaderProgramHandle& handle) {
 	program.Use();
 }
 
+void ShaderProgram_InvalidateCache() {
+	sCurrentProgram = 0;
+}
+
+void ShaderProgram_Dispatch(const ShaderProgramHandle& handle, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& program = sShaderPrograms[handle.mHandle];
+	program.Use();
+	GL_CHECK(glDispatchCompute(groupsX, groupsY, groupsZ));
+}
+
 void ShaderProgram_SetInt(const ShaderProgramHandle & handle, const char * name, int data) {
 	if (!handle.IsValid()) {
 		return;
@@ -315,3 +346,11 @@ void ShaderProgram_SetMat4(const ShaderProgramHandle & handle, const char * name
 	auto& program = sShaderPrograms[handle.mHandle];
 	program.SetUniformMat4v(name, &data[0][0]);
 }
+
+void ShaderProgram_SetUniformBlock(const ShaderProgramHandle& handle, const char* name, uint32_t binding) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& program = sShaderPrograms[handle.mHandle];
+	program.SetUniformBlock(name, binding);
+}
\ No newline at end of file
@@ -15,6 +15,7 @@ using ShaderProgramHandle = ResourceHandle;
 struct ShaderProgramParams {
 	std::string mVertexShaderData;
 	std::string mFragmentShaderData;
+	std::string mComputeShaderData;
 };
 
 ShaderProgramHandle ShaderProgram_Create(const ShaderProgramParams& params);
@@ -23,6 +24,11 @@ void ShaderProgram_Destroy(const ShaderProgramHandle& handle);
 
 void ShaderProgram_Use(const ShaderProgramHandle& handle);
 
+// Forgets the current program, to be called after glUseProgram was called outside of this module.
+void ShaderProgram_InvalidateCache();
+
+void ShaderProgram_Dispatch(const ShaderProgramHandle& handle, uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1);
+
 void ShaderProgram_SetInt(const ShaderProgramHandle& handle, const char* name, int data);
 void ShaderProgram_SetFloat(const ShaderProgramHandle& handle, const char* name, float data);
 void ShaderProgram_SetVec2(const ShaderProgramHandle& handle, const char* name, float f0, float f1);
@@ -33,4 +39,6 @@ void ShaderProgram_SetVec3(const ShaderProgramHandle& handle, const char* name,
 void ShaderProgram_SetVec4(const ShaderProgramHandle& handle, const char* name, const glm::vec4& data);
 void ShaderProgram_SetMat2(const ShaderProgramHandle& handle, const char* name, const glm::mat2& data);
 void ShaderProgram_SetMat3(const ShaderProgramHandle& handle, const char* name, const glm::mat3& data);
-void ShaderProgram_SetMat4(const ShaderProgramHandle& handle, const char* name, const glm::mat4& data);
\ No newline at end of file
+void ShaderProgram_SetMat4(const ShaderProgramHandle& handle, const char* name, const glm::mat4& data);
+
+void ShaderProgram_SetUniformBlock(const ShaderProgramHandle& handle, const char* name, uint32_t binding);
\ No newline at end of file
@@ -0,0 +1,439 @@
+#include "ShadowAtlas.h"
+
+#include "Frustum.h"
+#include "GLApi.h"
+#include "glm/geometric.hpp"
+#include "glm/trigonometric.hpp"
+#include "glm/gtc/constants.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "stb_rect_pack.h"
+
+namespace
+{
+
+constexpr uint32_t cMaxFaces = 6;
+constexpr uint32_t cMaxLevelBias = 8;
+constexpr float cPackedFill = 0.9f;				// demand above it raises the level bias
+constexpr float cRelaxedFill = 0.6f;			// demand of the next lower bias under it lowers it
+constexpr float cReclaimableFill = 0.25f;		// area held by shrunk, hidden or abandoned tiles that triggers a repack
+constexpr float cShrinkHysteresis = 0.7f;		// a tile keeps its size while the ideal one stays within these ratios
+constexpr float cGrowHysteresis = 2.5f;
+constexpr float cNeverRenderedPriority = 1e6f;
+constexpr uint32_t cStarvedRepackDelay = 60;		// updates starved lights wait for free space before forcing a repack
+
+// Cube faces, in the order the shaders expect: +X, -X, +Y, -Y, +Z, -Z.
+const glm::vec3 cFaceDirections[cMaxFaces] = {
+	glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)
+};
+const glm::vec3 cFaceUps[cMaxFaces] = {
+	glm::vec3(0, 1, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, 1), glm::vec3(0, 1, 0), glm::vec3(0, 1, 0)
+};
+
+const char* const cFaceMatrixNames[cMaxFaces] = {
+	"u_faceMatrices[0]", "u_faceMatrices[1]", "u_faceMatrices[2]", "u_faceMatrices[3]", "u_faceMatrices[4]", "u_faceMatrices[5]"
+};
+const char* const cFaceRectNames[cMaxFaces] = {
+	"u_faceRects[0]", "u_faceRects[1]", "u_faceRects[2]", "u_faceRects[3]", "u_faceRects[4]", "u_faceRects[5]"
+};
+
+const glm::mat4 cClipToTexture(
+	0.5f, 0.0f, 0.0f, 0.0f,
+	0.0f, 0.5f, 0.0f, 0.0f,
+	0.0f, 0.0f, 0.5f, 0.0f,
+	0.5f, 0.5f, 0.5f, 1.0f);
+
+uint32_t PowerOfTwoFloor(float value) {
+	uint32_t result = 1;
+	while (float(result * 2) <= value) {
+		result *= 2;
+	}
+	return result;
+}
+
+uint32_t FacesCount(const ShadowLight& light) {
+	return light.mType == ShadowLightType::Point ? 6 : 1;
+}
+
+uint32_t TileWidth(const ShadowLight& light, uint32_t size) {
+	return light.mType == ShadowLightType::Point ? 3 * size : size;
+}
+
+uint32_t TileHeight(const ShadowLight& light, uint32_t size) {
+	return light.mType == ShadowLightType::Point ? 2 * size : size;
+}
+
+uint64_t TileArea(const ShadowLight& light, uint32_t size) {
+	return uint64_t(FacesCount(light)) * size * size;
+}
+
+bool SameLight(const ShadowLight& a, const ShadowLight& b) {
+	return a.mType == b.mType && a.mPosition == b.mPosition && a.mRadius == b.mRadius &&
+		(a.mType == ShadowLightType::Point || (a.mDirection == b.mDirection && a.mOuterAngle == b.mOuterAngle));
+}
+
+glm::vec3 SpotUp(const glm::vec3& direction) {
+	return std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+glm::mat4 SpotViewProjection(const ShadowLight& light, float nearPlane) {
+	const float angle = std::min(std::max(light.mOuterAngle, 0.05f), 1.4f);
+	const glm::vec3 direction = glm::normalize(light.mDirection);
+	const glm::mat4 projection = glm::perspective(2.0f * angle, 1.0f, nearPlane, light.mRadius);
+	return projection * glm::lookAt(light.mPosition, light.mPosition + direction, SpotUp(direction));
+}
+
+glm::mat4 FaceViewProjection(const ShadowLight& light, uint32_t face, float nearPlane) {
+	const glm::mat4 projection = glm::perspective(glm::half_pi<float>(), 1.0f, nearPlane, light.mRadius);
+	return projection * glm::lookAt(light.mPosition, light.mPosition + cFaceDirections[face], cFaceUps[face]);
+}
+
+// Size from the importance, kept while the ideal size stays close to the current one so tiles do not flip between
+// two sizes as the camera moves.
+uint32_t WantedSize(const ShadowAtlasParams& params, const ShadowAtlasTile& tile, uint32_t bias) {
+	if (tile.mImportance <= 0.0f) {
+		return 0;
+	}
+	const float ideal = tile.mImportance * float(params.mMaxTileSize) / float(1u << bias);
+	if (tile.mSize > 0 && ideal >= cShrinkHysteresis * float(tile.mSize) && ideal < cGrowHysteresis * float(tile.mSize)) {
+		return std::min(std::max(tile.mSize, params.mMinTileSize), params.mMaxTileSize);
+	}
+	return std::min(std::max(PowerOfTwoFloor(ideal), params.mMinTileSize), params.mMaxTileSize);
+}
+
+uint64_t Demand(const ShadowAtlas& atlas, uint32_t bias) {
+	uint64_t area = 0;
+	for (const auto& tile : atlas.mTiles) {
+		area += TileArea(tile.mLight, WantedSize(atlas.mParams, tile, bias));
+	}
+	return area;
+}
+
+void Place(ShadowAtlasTile& tile, const stbrp_rect& rect, uint32_t size) {
+	if (tile.mSize != size || tile.mX != uint32_t(rect.x) || tile.mY != uint32_t(rect.y)) {
+		tile.mValid = false;
+	}
+	tile.mSize = size;
+	tile.mX = rect.x;
+	tile.mY = rect.y;
+}
+
+// Packs every visible light from scratch, the ones the packer cannot place lose their tile and are retried by the
+// following updates.
+void Repack(ShadowAtlas& atlas) {
+	const int size = int(atlas.mParams.mSize);
+	stbrp_init_target(&atlas.mPacker, size, size, atlas.mNodes.data(), int(atlas.mNodes.size()));
+	atlas.mRects.clear();
+	for (uint32_t i = 0; i < atlas.mTiles.size(); i++) {
+		ShadowAtlasTile& tile = atlas.mTiles[i];
+		tile.mStarved = false;
+		if (tile.mWantedSize == 0) {
+			tile.mSize = 0;
+			tile.mValid = false;
+			continue;
+		}
+		stbrp_rect rect = {};
+		rect.id = int(i);
+		rect.w = stbrp_coord(TileWidth(tile.mLight, tile.mWantedSize));
+		rect.h = stbrp_coord(TileHeight(tile.mLight, tile.mWantedSize));
+		atlas.mRects.push_back(rect);
+	}
+	if (!atlas.mRects.empty()) {
+		stbrp_pack_rects(&atlas.mPacker, atlas.mRects.data(), int(atlas.mRects.size()));
+	}
+	atlas.mAllocatedArea = 0;
+	atlas.mStarvedUpdates = 0;
+	for (const stbrp_rect& rect : atlas.mRects) {
+		ShadowAtlasTile& tile = atlas.mTiles[rect.id];
+		if (rect.was_packed) {
+			Place(tile, rect, tile.mWantedSize);
+			atlas.mAllocatedArea += TileArea(tile.mLight, tile.mSize);
+		} else {
+			tile.mSize = 0;
+			tile.mValid = false;
+			tile.mStarved = true;
+		}
+	}
+	atlas.mStats.mRepacks++;
+}
+
+void Allocate(ShadowAtlas& atlas) {
+	const uint64_t atlasArea = uint64_t(atlas.mParams.mSize) * atlas.mParams.mSize;
+	bool repack = false;
+
+	// one bias for all the lights: sizes keep their ratios when there are too many of them
+	const uint32_t bias = atlas.mLevelBias;
+	while (atlas.mLevelBias < cMaxLevelBias && float(Demand(atlas, atlas.mLevelBias)) > cPackedFill * float(atlasArea)) {
+		atlas.mLevelBias++;
+	}
+	while (atlas.mLevelBias > 0 && float(Demand(atlas, atlas.mLevelBias - 1)) < cRelaxedFill * float(atlasArea)) {
+		atlas.mLevelBias--;
+	}
+	repack = (atlas.mLevelBias != bias);
+
+	uint64_t liveArea = 0;
+	uint64_t reclaimable = 0;
+	atlas.mRects.clear();
+	for (uint32_t i = 0; i < atlas.mTiles.size(); i++) {
+		ShadowAtlasTile& tile = atlas.mTiles[i];
+		tile.mWantedSize = WantedSize(atlas.mParams, tile, atlas.mLevelBias);
+		liveArea += TileArea(tile.mLight, tile.mSize);
+		if (tile.mWantedSize == 0) {
+			tile.mStarved = false;
+		}
+		if (tile.mWantedSize < tile.mSize) {
+			reclaimable += TileArea(tile.mLight, tile.mSize) - TileArea(tile.mLight, tile.mWantedSize);
+		} else if (tile.mWantedSize > tile.mSize) {
+			stbrp_rect rect = {};
+			rect.id = int(i);
+			rect.w = stbrp_coord(TileWidth(tile.mLight, tile.mWantedSize));
+			rect.h = stbrp_coord(TileHeight(tile.mLight, tile.mWantedSize));
+			atlas.mRects.push_back(rect);
+		}
+	}
+	reclaimable += atlas.mAllocatedArea - std::min(liveArea, atlas.mAllocatedArea);
+	repack = repack || float(reclaimable) > cReclaimableFill * float(atlasArea);
+
+	// new and growing lights go into the free space left, their previous tile is abandoned until the next repack.
+	// Starved lights are retried without repacking again, unless they have waited for too long.
+	bool starved = false;
+	if (!repack && !atlas.mRects.empty()) {
+		stbrp_pack_rects(&atlas.mPacker, atlas.mRects.data(), int(atlas.mRects.size()));
+		for (const stbrp_rect& rect : atlas.mRects) {
+			ShadowAtlasTile& tile = atlas.mTiles[rect.id];
+			if (!rect.was_packed) {
+				repack = repack || !tile.mStarved;
+				starved = starved || tile.mStarved;
+				continue;
+			}
+			tile.mStarved = false;
+			Place(tile, rect, tile.mWantedSize);
+			atlas.mAllocatedArea += TileArea(tile.mLight, tile.mSize);
+		}
+	}
+	atlas.mStarvedUpdates = starved ? atlas.mStarvedUpdates + 1 : 0;
+	repack = repack || atlas.mStarvedUpdates >= cStarvedRepackDelay;
+	if (repack) {
+		Repack(atlas);
+	}
+}
+
+void RenderTile(ShadowAtlas& atlas, uint32_t index, const ShadowAtlasDrawCallback& draw) {
+	ShadowAtlasTile& tile = atlas.mTiles[index];
+	const ShadowLight& light = tile.mLight;
+	const float atlasSize = float(atlas.mParams.mSize);
+	GL_CHECK(glScissor(GLint(tile.mX), GLint(tile.mY), GLsizei(TileWidth(light, tile.mSize)), GLsizei(TileHeight(light, tile.mSize))));
+	GL_CHECK(glClear(GL_DEPTH_BUFFER_BIT));
+
+	// the vertex shader squeezes the clip space of each face into its rectangle of the atlas clip space
+	const uint32_t facesCount = FacesCount(light);
+	const float scale = float(tile.mSize) / atlasSize;
+	for (uint32_t face = 0; face < facesCount; face++) {
+		const float x = float(tile.mX + (face % 3) * tile.mSize);
+		const float y = float(tile.mY + (face / 3) * tile.mSize);
+		const glm::vec4 rect(scale, scale, 2.0f * x / atlasSize - 1.0f + scale, 2.0f * y / atlasSize - 1.0f + scale);
+		const glm::mat4 viewProjection = light.mType == ShadowLightType::Point ? FaceViewProjection(light, face, atlas.mParams.mNearPlane) : SpotViewProjection(light, atlas.mParams.mNearPlane);
+		ShaderProgram_SetMat4(atlas.mDepthProgram, cFaceMatrixNames[face], viewProjection);
+		ShaderProgram_SetVec4(atlas.mDepthProgram, cFaceRectNames[face], rect);
+	}
+	ShaderProgram_SetInt(atlas.mDepthProgram, "u_facesCount", int(facesCount));
+	atlas.mStats.mDraws += draw(index);
+	atlas.mStats.mFaces += facesCount;
+	atlas.mStats.mUpdates++;
+
+	tile.mRendered = light;
+	tile.mValid = true;
+	tile.mDirty = false;
+	tile.mAge = 0;
+}
+
+// Lookup data of a light, see 17-shadowatlas.fs: the tile rectangle in texture coordinates and the light type, then
+// the position and the depth of a distance along a face axis for point lights, or the matrix to the [0, 1] tile
+// coordinates and depth for spot lights.
+void WriteLightData(const ShadowAtlas& atlas, const ShadowAtlasTile& tile, glm::vec4* data) {
+	for (uint32_t i = 0; i < cShadowAtlasTexelsPerLight; i++) {
+		data[i] = glm::vec4(0.0f);
+	}
+	if (!tile.mValid || tile.mSize == 0) {
+		return;
+	}
+	const ShadowLight& light = tile.mRendered;
+	const float atlasSize = float(atlas.mParams.mSize);
+	data[0] = glm::vec4(float(tile.mX) / atlasSize, float(tile.mY) / atlasSize, float(tile.mSize) / atlasSize, float(light.mType + 1));
+	if (light.mType == ShadowLightType::Point) {
+		const float nearPlane = atlas.mParams.mNearPlane;
+		const float farPlane = light.mRadius;
+		data[1] = glm::vec4(light.mPosition, 0.0f);
+		data[2] = glm::vec4(farPlane / (farPlane - nearPlane), -farPlane * nearPlane / (farPlane - nearPlane), 0.0f, 0.0f);
+	} else {
+		const glm::mat4 matrix = cClipToTexture * SpotViewProjection(light, atlas.mParams.mNearPlane);
+		for (uint32_t row = 0; row < 4; row++) {
+			data[1 + row] = glm::vec4(matrix[0][row], matrix[1][row], matrix[2][row], matrix[3][row]);
+		}
+	}
+}
+
+}
+
+bool ShadowAtlas_Initialize(ShadowAtlas& atlas, const ShadowAtlasParams& params, const ShaderProgramHandle& depthProgram) {
+	atlas.mParams = params;
+	atlas.mParams.mMaxTileSize = std::min(PowerOfTwoFloor(float(params.mMaxTileSize)), PowerOfTwoFloor(float(params.mSize) / 3.0f));
+	atlas.mParams.mMinTileSize = std::min(PowerOfTwoFloor(float(std::max(params.mMinTileSize, 1u))), atlas.mParams.mMaxTileSize);
+	atlas.mDepthProgram = depthProgram;
+
+	atlas.mAtlas = Texture_CreateRenderTarget(params.mSize, params.mSize, TextureFormats::Depth32F);
+	Texture_SetFilteringMode(atlas.mAtlas, TextureFilteringMode::Bilinear);
+	Texture_SetShadowCompare(atlas.mAtlas, true);
+	RenderTargetParams targetParams;
+	targetParams.mDepth = atlas.mAtlas;
+	atlas.mTarget = RenderTarget_Create(targetParams);
+	if (!atlas.mTarget.IsValid()) {
+		return false;
+	}
+
+	PipelineStateParams stateParams;
+	stateParams.mProgram = depthProgram;
+	stateParams.mBlend.mColorWriteMask = 0;
+	stateParams.mRaster.mScissorEnable = true;
+	stateParams.mRaster.mPolygonOffsetFactor = 2.0f;
+	stateParams.mRaster.mPolygonOffsetUnits = 4.0f;
+	atlas.mDepthState = PipelineState_Create(stateParams);
+
+	atlas.mLightBuffer = Buffer_Create(BufferType::Texture, nullptr, cShadowAtlasMaxLights * cShadowAtlasTexelsPerLight * sizeof(glm::vec4), BufferUsage::Stream);
+	atlas.mLightTexture = Texture_CreateBuffer(atlas.mLightBuffer, TextureFormats::RGBA32F);
+
+	// one node per column gives the packer its best results
+	atlas.mNodes.resize(params.mSize);
+	stbrp_init_target(&atlas.mPacker, int(params.mSize), int(params.mSize), atlas.mNodes.data(), int(atlas.mNodes.size()));
+	return atlas.mLightTexture.IsValid();
+}
+
+void ShadowAtlas_Destroy(ShadowAtlas& atlas) {
+	Texture_Destroy(atlas.mLightTexture);
+	Buffer_Destroy(atlas.mLightBuffer);
+	PipelineState_Destroy(atlas.mDepthState);
+	RenderTarget_Destroy(atlas.mTarget);
+	Texture_Destroy(atlas.mAtlas);
+	atlas = ShadowAtlas();
+}
+
+void ShadowAtlas_Update(ShadowAtlas& atlas, const ShadowLight* lights, uint32_t count, const glm::mat4& view, const glm::mat4& projection, const ShadowAtlasDrawCallback& draw) {
+	count = std::min(count, cShadowAtlasMaxLights);
+	atlas.mTiles.resize(count);
+	const Frustum frustum = Frustum_FromMatrix(projection * view);
+	const float focal = projection[1][1];
+
+	// screen coverage, and the lights that changed since their tile was rendered
+	for (uint32_t i = 0; i < count; i++) {
+		ShadowAtlasTile& tile = atlas.mTiles[i];
+		const ShadowLight& light = lights[i];
+		if (!SameLight(light, tile.mLight)) {
+			// the tile has the shape of the other type, it is left to the next repack
+			if (tile.mLight.mType != light.mType) {
+				tile.mSize = 0;
+				tile.mValid = false;
+			}
+			tile.mLight = light;
+			tile.mDirty = true;
+		}
+		tile.mImportance = 0.0f;
+		if (Frustum_TestSphere(frustum, light.mPosition, light.mRadius)) {
+			const float distance = glm::length(glm::vec3(view * glm::vec4(light.mPosition, 1.0f)));
+			tile.mImportance = std::min(light.mRadius * focal / std::max(distance, light.mRadius), 1.0f);
+		}
+	}
+	Allocate(atlas);
+
+	atlas.mQueue.clear();
+	for (uint32_t i = 0; i < count; i++) {
+		const ShadowAtlasTile& tile = atlas.mTiles[i];
+		if (tile.mSize > 0 && tile.mImportance > 0.0f && (!tile.mValid || tile.mDirty)) {
+			atlas.mQueue.push_back(i);
+		}
+	}
+	auto priority = [&atlas](uint32_t index) {
+		const ShadowAtlasTile& tile = atlas.mTiles[index];
+		return (tile.mValid ? 0.0f : cNeverRenderedPriority) + tile.mImportance * float(1 + tile.mAge);
+	};
+	std::sort(atlas.mQueue.begin(), atlas.mQueue.end(), [&priority](uint32_t a, uint32_t b) {
+		return priority(a) > priority(b);
+	});
+
+	atlas.mStats.mUpdates = 0;
+	atlas.mStats.mFaces = 0;
+	atlas.mStats.mDraws = 0;
+	atlas.mStats.mPending = 0;
+	bool bound = false;
+	uint32_t budget = atlas.mParams.mUpdateBudget;
+	for (uint32_t index : atlas.mQueue) {
+		ShadowAtlasTile& tile = atlas.mTiles[index];
+		const uint32_t facesCount = FacesCount(tile.mLight);
+		// a spot light further down may still fit in what is left
+		if (facesCount > budget) {
+			tile.mAge++;
+			atlas.mStats.mPending++;
+			continue;
+		}
+		if (!bound) {
+			RenderTarget_Bind(atlas.mTarget);
+			PipelineState_Apply(atlas.mDepthState);
+			for (uint32_t plane = 0; plane < 4; plane++) {
+				GL_CHECK(glEnable(GL_CLIP_DISTANCE0 + plane));
+			}
+			bound = true;
+		}
+		budget -= facesCount;
+		RenderTile(atlas, index, draw);
+	}
+	if (bound) {
+		for (uint32_t plane = 0; plane < 4; plane++) {
+			GL_CHECK(glDisable(GL_CLIP_DISTANCE0 + plane));
+		}
+		PipelineState_ApplyRaster(RasterState());
+	}
+
+	atlas.mLightData.resize(size_t(count) * cShadowAtlasTexelsPerLight);
+	uint64_t liveArea = 0;
+	atlas.mStats.mTiles = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		const ShadowAtlasTile& tile = atlas.mTiles[i];
+		WriteLightData(atlas, tile, &atlas.mLightData[size_t(i) * cShadowAtlasTexelsPerLight]);
+		liveArea += TileArea(tile.mLight, tile.mSize);
+		atlas.mStats.mTiles += tile.mSize > 0 ? 1 : 0;
+	}
+	if (!atlas.mLightData.empty()) {
+		Buffer_Update(atlas.mLightBuffer, 0, atlas.mLightData.data(), uint32_t(atlas.mLightData.size() * sizeof(glm::vec4)));
+	}
+	atlas.mStats.mLevelBias = atlas.mLevelBias;
+	atlas.mStats.mOccupancy = float(double(liveArea) / (double(atlas.mParams.mSize) * atlas.mParams.mSize));
+}
+
+void ShadowAtlas_Invalidate(ShadowAtlas& atlas, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+	for (auto& tile : atlas.mTiles) {
+		if (tile.mSize == 0 || tile.mDirty) {
+			continue;
+		}
+		const glm::vec3 closest = glm::clamp(tile.mLight.mPosition, boundsMin, boundsMax);
+		const glm::vec3 offset = closest - tile.mLight.mPosition;
+		tile.mDirty = glm::dot(offset, offset) <= tile.mLight.mRadius * tile.mLight.mRadius;
+	}
+}
+
+void ShadowAtlas_Bind(const ShadowAtlas& atlas, const ShaderProgramHandle& program, uint8_t atlasStage, uint8_t lightsStage, const glm::mat4& view) {
+	Texture_Bind(atlas.mAtlas, atlasStage);
+	Texture_Bind(atlas.mLightTexture, lightsStage);
+	ShaderProgram_SetInt(program, "u_shadowAtlas", atlasStage);
+	ShaderProgram_SetInt(program, "u_shadowAtlasLights", lightsStage);
+	ShaderProgram_SetFloat(program, "u_shadowAtlasTexelSize", 1.0f / float(atlas.mParams.mSize));
+	ShaderProgram_SetMat4(program, "u_shadowAtlasInverseView", glm::inverse(view));
+}
+
+const ShadowAtlasStats& ShadowAtlas_GetStats(const ShadowAtlas& atlas) {
+	return atlas.mStats;
+}
+
+void ShadowAtlas_ResetStats(ShadowAtlas& atlas) {
+	atlas.mStats.mRepacks = 0;
+}
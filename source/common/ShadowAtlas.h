@@ -0,0 +1,120 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "Buffer.h"
+#include "PipelineState.h"
+#include "RenderTarget.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+#include "stb_rect_pack.h"
+
+#include <functional>
+#include <vector>
+
+static constexpr uint32_t cShadowAtlasMaxLights = 1024;
+static constexpr uint32_t cShadowAtlasTexelsPerLight = 5;
+
+struct ShadowLightType {
+	enum Enum {
+		Spot,
+		Point,		// six cube faces laid out 3 x 2 in one tile
+		Count
+	};
+};
+
+struct ShadowLight {
+	ShadowLightType::Enum mType = ShadowLightType::Point;
+	glm::vec3 mPosition = glm::vec3(0.0f);
+	glm::vec3 mDirection = glm::vec3(0.0f, -1.0f, 0.0f);	// spot lights only
+	float mRadius = 1.0f;									// far plane of the shadow projections
+	float mOuterAngle = 0.5f;								// spot lights only, half angle of the cone in radians
+};
+
+struct ShadowAtlasParams {
+	uint32_t mSize = 4096;						// the atlas is mSize x mSize texels whatever the number of lights
+	uint32_t mMaxTileSize = 1024;				// spot light or cube face of a light covering the screen
+	uint32_t mMinTileSize = 64;
+	uint32_t mUpdateBudget = 24;				// faces rendered per update, 1 per spot light and 6 per point light
+	float mNearPlane = 0.05f;
+};
+
+struct ShadowAtlasStats {
+	uint32_t mTiles = 0;						// lights holding a tile
+	uint32_t mPending = 0;						// visible lights left out of date by the last update
+	uint32_t mUpdates = 0;						// lights rendered by the last update
+	uint32_t mFaces = 0;
+	uint32_t mDraws = 0;
+	uint32_t mRepacks = 0;						// since the last ShadowAtlas_ResetStats
+	uint32_t mLevelBias = 0;					// tile sizes are divided by 2^bias so every visible light fits
+	float mOccupancy = 0.0f;					// fraction of the atlas allocated
+};
+
+// Allocation and update state of one light. Tiles are square powers of two for spot lights and 3 x 2 of them for
+// point lights.
+struct ShadowAtlasTile {
+	ShadowLight mLight;							// latest state
+	ShadowLight mRendered;						// as rendered in the tile
+	float mImportance = 0.0f;					// projected radius over the viewport height, 0 when not visible
+	uint32_t mWantedSize = 0;
+	uint32_t mSize = 0;							// face size, 0 without a tile
+	uint32_t mX = 0;
+	uint32_t mY = 0;
+	uint32_t mAge = 0;							// updates spent waiting since the tile became out of date
+	bool mValid = false;						// the tile holds a render of mRendered
+	bool mDirty = false;						// the light or a caster around it changed since
+	bool mStarved = false;						// left out by a repack, retried in the free space by the next updates
+};
+
+// Shadows of many local lights in one depth atlas. Tiles are sized from the screen coverage of the lights and allocated
+// with stb_rect_pack, incrementally while the atlas has room and with a full repack when it runs out, when too much of
+// it is held by shrunk or hidden lights, or when lights left out by a repack still find no room later. Each update
+// renders the out of date tiles in order of priority (tiles never rendered first, then importance times the time
+// waited) until the face budget is spent; lights that have not been rendered yet are unshadowed in the meantime.
+struct ShadowAtlas {
+	ShadowAtlasParams mParams;
+	TextureHandle mAtlas = TextureHandle(cInvalidHandle);
+	RenderTargetHandle mTarget = RenderTargetHandle(cInvalidHandle);
+	PipelineStateHandle mDepthState = PipelineStateHandle(cInvalidHandle);
+	ShaderProgramHandle mDepthProgram = ShaderProgramHandle(cInvalidHandle);
+	BufferHandle mLightBuffer = BufferHandle(cInvalidHandle);
+	TextureHandle mLightTexture = TextureHandle(cInvalidHandle);
+
+	std::vector<ShadowAtlasTile> mTiles;
+	std::vector<glm::vec4> mLightData;			// cShadowAtlasTexelsPerLight per light, see 17-shadowatlas.fs
+	std::vector<uint32_t> mQueue;
+	std::vector<stbrp_rect> mRects;
+	std::vector<stbrp_node> mNodes;
+	stbrp_context mPacker;
+	uint32_t mLevelBias = 0;
+	uint64_t mAllocatedArea = 0;				// including the tiles left behind by lights that moved to a bigger one
+	uint32_t mStarvedUpdates = 0;				// updates since the last repack that could not place the starved lights
+	ShadowAtlasStats mStats;
+};
+
+// Renders the casters around a light with the depth program and the face uniforms already set. Point lights need
+// instanced batches drawing every instance 6 times (InstanceBatchParams::mRepeat), spot lights once. Returns the
+// number of draws issued.
+using ShadowAtlasDrawCallback = std::function<uint32_t(uint32_t light)>;
+
+// depthProgram is 17-shadowatlas_depth.vs. The largest tile is reduced so a point light still fits in the atlas.
+bool ShadowAtlas_Initialize(ShadowAtlas& atlas, const ShadowAtlasParams& params, const ShaderProgramHandle& depthProgram);
+
+void ShadowAtlas_Destroy(ShadowAtlas& atlas);
+
+// Sizes and allocates the tiles of the lights (at most cShadowAtlasMaxLights, indexed as in the array) from the
+// camera, renders the ones due within the budget and uploads the lookup data. Leaves the atlas target bound.
+void ShadowAtlas_Update(ShadowAtlas& atlas, const ShadowLight* lights, uint32_t count, const glm::mat4& view, const glm::mat4& projection, const ShadowAtlasDrawCallback& draw);
+
+// Marks the lights whose range overlaps a world space box, e.g. the bounds of a caster before and after it moved.
+void ShadowAtlas_Invalidate(ShadowAtlas& atlas, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+// Binds the atlas to a sampler2DShadow and the per light data to a samplerBuffer, and sets the u_shadowAtlas*
+// uniforms of 17-shadowatlas.fs.
+void ShadowAtlas_Bind(const ShadowAtlas& atlas, const ShaderProgramHandle& program, uint8_t atlasStage, uint8_t lightsStage, const glm::mat4& view);
+
+const ShadowAtlasStats& ShadowAtlas_GetStats(const ShadowAtlas& atlas);
+
+void ShadowAtlas_ResetStats(ShadowAtlas& atlas);
@@ -0,0 +1,624 @@
+#include "SoftRaster.h"
+
+#include "FrameLoop.h"
+#include "JobSystem.h"
+#include "Log.h"
+#include "stb_image.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+
+constexpr uint32_t cSubpixelBits = 4;
+constexpr int32_t cSubpixels = 1 << cSubpixelBits;
+constexpr uint32_t cClipPlanesCount = 5;					// sides and near, depths beyond the far plane are rejected per pixel
+constexpr uint32_t cMaxClipVertices = 3 + cClipPlanesCount;
+
+inline uint32_t PackColor(const glm::vec4& color) {
+	uint32_t packed = 0;
+	for (uint32_t i = 0; i < 4; i++) {
+		const float channel = std::min(std::max(color[i], 0.0f), 1.0f);
+		packed |= uint32_t(channel * 255.0f + 0.5f) << (i * 8);
+	}
+	return packed;
+}
+
+inline glm::vec4 UnpackColor(uint32_t packed) {
+	const float scale = 1.0f / 255.0f;
+	return glm::vec4(float(packed & 0xff) * scale, float((packed >> 8) & 0xff) * scale, float((packed >> 16) & 0xff) * scale,
+		float(packed >> 24) * scale);
+}
+
+inline uint32_t WrapRepeat(int32_t coordinate, uint32_t size) {
+	const int32_t wrapped = coordinate % int32_t(size);
+	return uint32_t(wrapped < 0 ? wrapped + int32_t(size) : wrapped);
+}
+
+glm::vec4 SampleNearest(const SoftTextureLevel& level, const glm::vec2& uv) {
+	const uint32_t x = WrapRepeat(int32_t(std::floor(uv.x * float(level.mWidth))), level.mWidth);
+	const uint32_t y = WrapRepeat(int32_t(std::floor(uv.y * float(level.mHeight))), level.mHeight);
+	return UnpackColor(level.mTexels[y * level.mWidth + x]);
+}
+
+glm::vec4 SampleBilinear(const SoftTextureLevel& level, const glm::vec2& uv) {
+	const float x = uv.x * float(level.mWidth) - 0.5f;
+	const float y = uv.y * float(level.mHeight) - 0.5f;
+	const float floorX = std::floor(x);
+	const float floorY = std::floor(y);
+	const float fractionX = x - floorX;
+	const float fractionY = y - floorY;
+	const uint32_t x0 = WrapRepeat(int32_t(floorX), level.mWidth);
+	const uint32_t x1 = WrapRepeat(int32_t(floorX) + 1, level.mWidth);
+	const uint32_t y0 = WrapRepeat(int32_t(floorY), level.mHeight) * level.mWidth;
+	const uint32_t y1 = WrapRepeat(int32_t(floorY) + 1, level.mHeight) * level.mWidth;
+	const glm::vec4 bottom = glm::mix(UnpackColor(level.mTexels[y0 + x0]), UnpackColor(level.mTexels[y0 + x1]), fractionX);
+	const glm::vec4 top = glm::mix(UnpackColor(level.mTexels[y1 + x0]), UnpackColor(level.mTexels[y1 + x1]), fractionX);
+	return glm::mix(bottom, top, fractionY);
+}
+
+void BuildMips(SoftTexture& texture) {
+	while (texture.mLevels.back().mWidth > 1 || texture.mLevels.back().mHeight > 1) {
+		const SoftTextureLevel& source = texture.mLevels.back();
+		SoftTextureLevel level;
+		level.mWidth = std::max(source.mWidth / 2, 1u);
+		level.mHeight = std::max(source.mHeight / 2, 1u);
+		level.mTexels.resize(size_t(level.mWidth) * level.mHeight);
+		for (uint32_t y = 0; y < level.mHeight; y++) {
+			const uint32_t y0 = std::min(y * 2, source.mHeight - 1) * source.mWidth;
+			const uint32_t y1 = std::min(y * 2 + 1, source.mHeight - 1) * source.mWidth;
+			for (uint32_t x = 0; x < level.mWidth; x++) {
+				const uint32_t x0 = std::min(x * 2, source.mWidth - 1);
+				const uint32_t x1 = std::min(x * 2 + 1, source.mWidth - 1);
+				const glm::vec4 sum = UnpackColor(source.mTexels[y0 + x0]) + UnpackColor(source.mTexels[y0 + x1]) +
+					UnpackColor(source.mTexels[y1 + x0]) + UnpackColor(source.mTexels[y1 + x1]);
+				level.mTexels[y * level.mWidth + x] = PackColor(sum * 0.25f);
+			}
+		}
+		// moved in last, push_back may reallocate the levels source points to
+		texture.mLevels.push_back(std::move(level));
+	}
+}
+
+// Sutherland-Hodgman against one plane, distance is positive inside.
+uint32_t ClipPolygon(const SoftVertex* input, uint32_t count, SoftVertex* output, uint32_t plane, uint32_t varyingsCount) {
+	auto distance = [plane](const SoftVertex& vertex) {
+		const glm::vec4& p = vertex.mPosition;
+		switch (plane) {
+		case 0: return p.w - p.x;
+		case 1: return p.w + p.x;
+		case 2: return p.w - p.y;
+		case 3: return p.w + p.y;
+		default: return p.w + p.z;
+		}
+	};
+
+	uint32_t outputCount = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		const SoftVertex& current = input[i];
+		const SoftVertex& next = input[(i + 1) % count];
+		const float currentDistance = distance(current);
+		const float nextDistance = distance(next);
+		if (currentDistance >= 0.0f) {
+			output[outputCount++] = current;
+		}
+		if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+			const float t = currentDistance / (currentDistance - nextDistance);
+			SoftVertex& clipped = output[outputCount++];
+			clipped.mPosition = current.mPosition + (next.mPosition - current.mPosition) * t;
+			for (uint32_t k = 0; k < varyingsCount; k++) {
+				clipped.mVaryings[k] = current.mVaryings[k] + (next.mVaryings[k] - current.mVaryings[k]) * t;
+			}
+		}
+	}
+	return outputCount;
+}
+
+// Returns false when the triangle is culled, degenerate or covers no pixel center.
+bool SetupTriangle(const SoftRaster& raster, const SoftDraw& draw, const SoftVertex* const* vertices, SoftTriangle& triangle) {
+	float windowX[3];
+	float windowY[3];
+	float windowZ[3];
+	int32_t x[3];
+	int32_t y[3];
+	for (uint32_t i = 0; i < 3; i++) {
+		const glm::vec4& clip = vertices[i]->mPosition;
+		triangle.mInverseW[i] = 1.0f / clip.w;
+		windowX[i] = (clip.x * triangle.mInverseW[i] * 0.5f + 0.5f) * float(raster.mWidth);
+		windowY[i] = (clip.y * triangle.mInverseW[i] * 0.5f + 0.5f) * float(raster.mHeight);
+		windowZ[i] = clip.z * triangle.mInverseW[i] * 0.5f + 0.5f;
+		x[i] = int32_t(std::floor(windowX[i] * float(cSubpixels) + 0.5f));
+		y[i] = int32_t(std::floor(windowY[i] * float(cSubpixels) + 0.5f));
+	}
+
+	int64_t area = int64_t(x[1] - x[0]) * (y[2] - y[0]) - int64_t(x[2] - x[0]) * (y[1] - y[0]);
+	if (area == 0 || (area > 0 && draw.mCull == CullMode::Front) || (area < 0 && draw.mCull == CullMode::Back)) {
+		return false;
+	}
+	uint32_t order[3] = { 0, 1, 2 };
+	if (area < 0) {
+		// back faces that are not culled are turned counter clockwise
+		std::swap(order[1], order[2]);
+		area = -area;
+	}
+
+	int32_t minX = INT32_MAX;
+	int32_t minY = INT32_MAX;
+	int32_t maxX = INT32_MIN;
+	int32_t maxY = INT32_MIN;
+	for (uint32_t i = 0; i < 3; i++) {
+		minX = std::min(minX, x[i]);
+		minY = std::min(minY, y[i]);
+		maxX = std::max(maxX, x[i]);
+		maxY = std::max(maxY, y[i]);
+	}
+	// pixels whose center (p + 0.5) lies in the bounding box
+	const int32_t half = cSubpixels / 2;
+	triangle.mMinX = std::max((minX - half + cSubpixels - 1) >> cSubpixelBits, 0);
+	triangle.mMinY = std::max((minY - half + cSubpixels - 1) >> cSubpixelBits, 0);
+	triangle.mMaxX = std::min((maxX - half) >> cSubpixelBits, int32_t(raster.mWidth) - 1);
+	triangle.mMaxY = std::min((maxY - half) >> cSubpixelBits, int32_t(raster.mHeight) - 1);
+	if (triangle.mMinX > triangle.mMaxX || triangle.mMinY > triangle.mMaxY) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < 3; i++) {
+		const uint32_t from = order[i];
+		const uint32_t to = order[(i + 1) % 3];
+		const int32_t a = y[from] - y[to];
+		const int32_t b = x[to] - x[from];
+		// top left rule: with y up, the inside is on the right of left edges (a > 0) and below top edges
+		const bool topLeft = a > 0 || (a == 0 && b < 0);
+		triangle.mEdgeA[i] = a;
+		triangle.mEdgeB[i] = b;
+		triangle.mEdgeC[i] = -(int64_t(a) * x[from] + int64_t(b) * y[from]) - (topLeft ? 0 : 1);
+	}
+	triangle.mInverseArea = 1.0f / float(area);
+
+	const float* z = windowZ;
+	const float ax = windowX[order[1]] - windowX[order[0]];
+	const float ay = windowY[order[1]] - windowY[order[0]];
+	const float bx = windowX[order[2]] - windowX[order[0]];
+	const float by = windowY[order[2]] - windowY[order[0]];
+	const float az = z[order[1]] - z[order[0]];
+	const float bz = z[order[2]] - z[order[0]];
+	const float determinant = ax * by - bx * ay;
+	if (determinant == 0.0f) {
+		return false;
+	}
+	triangle.mZdX = (az * by - bz * ay) / determinant;
+	triangle.mZdY = (bz * ax - az * bx) / determinant;
+	triangle.mZ0 = z[order[0]] - triangle.mZdX * windowX[order[0]] - triangle.mZdY * windowY[order[0]];
+
+	float inverseW[3];
+	for (uint32_t i = 0; i < 3; i++) {
+		inverseW[i] = triangle.mInverseW[order[i]];
+		for (uint32_t k = 0; k < draw.mVaryingsCount; k++) {
+			triangle.mVaryings[i][k] = vertices[order[i]]->mVaryings[k];
+		}
+	}
+	for (uint32_t i = 0; i < 3; i++) {
+		triangle.mInverseW[i] = inverseW[i];
+	}
+	return true;
+}
+
+struct SetupCounts {
+	uint64_t mTriangles = 0;
+	uint64_t mBinned = 0;
+};
+
+void BinTriangle(SoftRaster& raster, const SoftTriangle& triangle, uint32_t index, std::vector<uint32_t>* bins, SetupCounts& counts) {
+	const uint32_t tileMinX = uint32_t(triangle.mMinX) / cSoftTileSize;
+	const uint32_t tileMinY = uint32_t(triangle.mMinY) / cSoftTileSize;
+	const uint32_t tileMaxX = uint32_t(triangle.mMaxX) / cSoftTileSize;
+	const uint32_t tileMaxY = uint32_t(triangle.mMaxY) / cSoftTileSize;
+	for (uint32_t tileY = tileMinY; tileY <= tileMaxY; tileY++) {
+		for (uint32_t tileX = tileMinX; tileX <= tileMaxX; tileX++) {
+			bins[tileY * raster.mTilesX + tileX].push_back(index);
+			counts.mBinned++;
+		}
+	}
+}
+
+// Shades the vertices of the draws [first, end), clips, sets up and bins their triangles into the bins of a thread.
+SetupCounts SetupDraws(SoftRaster& raster, uint32_t thread, uint32_t first, uint32_t end) {
+	SetupCounts counts;
+	std::vector<SoftVertex>& vertices = raster.mVertices[thread];
+	std::vector<SoftTriangle>& triangles = raster.mTriangles[thread];
+	std::vector<uint32_t>* bins = &raster.mBins[size_t(thread) * raster.mTilesX * raster.mTilesY];
+	SoftVertex polygons[2][cMaxClipVertices];
+
+	for (uint32_t drawIndex = first; drawIndex < end; drawIndex++) {
+		const SoftDraw& draw = raster.mDraws[drawIndex];
+		vertices.resize(draw.mVertexCount);
+		for (uint32_t i = 0; i < draw.mVertexCount; i++) {
+			draw.mVertexShader(draw.mVertices + size_t(i) * draw.mStride, vertices[i]);
+		}
+
+		const uint32_t trianglesCount = (draw.mIndices != nullptr) ? draw.mIndexCount / 3 : draw.mVertexCount / 3;
+		for (uint32_t t = 0; t < trianglesCount; t++) {
+			const SoftVertex* corners[3];
+			bool valid = true;
+			for (uint32_t i = 0; i < 3; i++) {
+				const uint32_t index = (draw.mIndices != nullptr) ? draw.mIndices[t * 3 + i] : t * 3 + i;
+				valid = valid && index < draw.mVertexCount;
+				corners[i] = valid ? &vertices[index] : nullptr;
+			}
+			if (!valid) {
+				continue;
+			}
+
+			// outcodes: trivially rejected when all the corners are outside of the same plane, passed through when
+			// none is outside of any
+			uint32_t outsideAll = (1u << cClipPlanesCount) - 1;
+			uint32_t outsideAny = 0;
+			for (uint32_t i = 0; i < 3; i++) {
+				const glm::vec4& p = corners[i]->mPosition;
+				const uint32_t outside = (p.x > p.w ? 1u : 0u) | (p.x < -p.w ? 2u : 0u) | (p.y > p.w ? 4u : 0u) | (p.y < -p.w ? 8u : 0u) |
+					(p.z < -p.w ? 16u : 0u);
+				outsideAll &= outside;
+				outsideAny |= outside;
+			}
+			if (outsideAll != 0) {
+				continue;
+			}
+
+			SoftTriangle triangle;
+			triangle.mDraw = drawIndex;
+			if (outsideAny == 0) {
+				if (SetupTriangle(raster, draw, corners, triangle)) {
+					triangles.push_back(triangle);
+					BinTriangle(raster, triangle, uint32_t(triangles.size() - 1), bins, counts);
+					counts.mTriangles++;
+				}
+				continue;
+			}
+
+			uint32_t count = 3;
+			uint32_t current = 0;
+			for (uint32_t i = 0; i < 3; i++) {
+				polygons[current][i] = *corners[i];
+			}
+			for (uint32_t plane = 0; plane < cClipPlanesCount && count >= 3; plane++) {
+				if ((outsideAny & (1u << plane)) != 0) {
+					count = ClipPolygon(polygons[current], count, polygons[1 - current], plane, draw.mVaryingsCount);
+					current = 1 - current;
+				}
+			}
+			for (uint32_t fan = 2; fan < count; fan++) {
+				const SoftVertex* fanCorners[3] = { &polygons[current][0], &polygons[current][fan - 1], &polygons[current][fan] };
+				if (SetupTriangle(raster, draw, fanCorners, triangle)) {
+					triangles.push_back(triangle);
+					BinTriangle(raster, triangle, uint32_t(triangles.size() - 1), bins, counts);
+					counts.mTriangles++;
+				}
+			}
+		}
+	}
+	return counts;
+}
+
+struct RasterCounts {
+	uint64_t mQuads = 0;
+	uint64_t mPixels = 0;
+};
+
+inline uint32_t PopCount4(uint32_t mask) {
+	return (mask & 1u) + ((mask >> 1) & 1u) + ((mask >> 2) & 1u) + ((mask >> 3) & 1u);
+}
+
+// Interpolates the varyings of the 4 lanes, e0 to e2 being the edge functions of the lanes.
+void InterpolateQuad(const SoftTriangle& triangle, uint32_t varyingsCount, __m128i e0, __m128i e1, __m128i e2, SoftFragmentQuad& quad) {
+	const __m128 inverseArea = _mm_set1_ps(triangle.mInverseArea);
+	// edge i weighs vertex i + 2, weights divided by w for perspective correction
+	__m128 w0 = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(e1), inverseArea), _mm_set1_ps(triangle.mInverseW[0]));
+	__m128 w1 = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(e2), inverseArea), _mm_set1_ps(triangle.mInverseW[1]));
+	__m128 w2 = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(e0), inverseArea), _mm_set1_ps(triangle.mInverseW[2]));
+	const __m128 normalize = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_add_ps(w0, w1), w2));
+	w0 = _mm_mul_ps(w0, normalize);
+	w1 = _mm_mul_ps(w1, normalize);
+	w2 = _mm_mul_ps(w2, normalize);
+	for (uint32_t k = 0; k < varyingsCount; k++) {
+		const __m128 value = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, _mm_set1_ps(triangle.mVaryings[0][k])),
+			_mm_mul_ps(w1, _mm_set1_ps(triangle.mVaryings[1][k]))), _mm_mul_ps(w2, _mm_set1_ps(triangle.mVaryings[2][k])));
+		_mm_storeu_ps(quad.mVaryings[k], value);
+	}
+}
+
+void RasterizeTriangle(SoftRaster& raster, const SoftTriangle& triangle, uint32_t tileX, uint32_t tileY, RasterCounts& counts) {
+	const SoftDraw& draw = raster.mDraws[triangle.mDraw];
+	// quads start on even pixels, the targets are padded to whole tiles so they never go past a row
+	const int32_t x0 = std::max(triangle.mMinX, int32_t(tileX)) & ~1;
+	const int32_t y0 = std::max(triangle.mMinY, int32_t(tileY)) & ~1;
+	const int32_t x1 = std::min(triangle.mMaxX, int32_t(tileX + cSoftTileSize - 1));
+	const int32_t y1 = std::min(triangle.mMaxY, int32_t(tileY + cSoftTileSize - 1));
+	if (x0 > x1 || y0 > y1) {
+		return;
+	}
+
+	// edge functions of the 4 lanes at the first quad, then stepped by 2 pixels
+	const int32_t half = cSubpixels / 2;
+	__m128i edges[3];
+	__m128i edgeStepX[3];
+	__m128i edgeStepY[3];
+	for (uint32_t i = 0; i < 3; i++) {
+		const int32_t a = triangle.mEdgeA[i] * cSubpixels;
+		const int32_t b = triangle.mEdgeB[i] * cSubpixels;
+		const int32_t origin = int32_t(int64_t(triangle.mEdgeA[i]) * (x0 * cSubpixels + half) + int64_t(triangle.mEdgeB[i]) * (y0 * cSubpixels + half) + triangle.mEdgeC[i]);
+		edges[i] = _mm_add_epi32(_mm_set1_epi32(origin), _mm_setr_epi32(0, a, b, a + b));
+		edgeStepX[i] = _mm_set1_epi32(a * 2);
+		edgeStepY[i] = _mm_set1_epi32(b * 2);
+	}
+	const float centerX = float(x0) + 0.5f;
+	const float centerY = float(y0) + 0.5f;
+	__m128 depthRow = _mm_add_ps(_mm_set1_ps(triangle.mZ0 + triangle.mZdX * centerX + triangle.mZdY * centerY),
+		_mm_setr_ps(0.0f, triangle.mZdX, triangle.mZdY, triangle.mZdX + triangle.mZdY));
+	const __m128 depthStepX = _mm_set1_ps(triangle.mZdX * 2.0f);
+	const __m128 depthStepY = _mm_set1_ps(triangle.mZdY * 2.0f);
+	const __m128 farPlane = _mm_set1_ps(1.0f);
+
+	SoftFragmentQuad quad;
+	glm::vec4 colors[4];
+	for (int32_t y = y0; y <= y1; y += 2) {
+		__m128i e0 = edges[0];
+		__m128i e1 = edges[1];
+		__m128i e2 = edges[2];
+		__m128 depth = depthRow;
+		float* depthBottom = &raster.mDepth[size_t(y) * raster.mPitch];
+		float* depthTop = depthBottom + raster.mPitch;
+		for (int32_t x = x0; x <= x1; x += 2) {
+			// a lane is outside when any of its edge functions is negative
+			const uint32_t outside = uint32_t(_mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(_mm_or_si128(e0, e1), e2))));
+			if (outside != 0xf) {
+				const __m128 stored = _mm_setr_ps(depthBottom[x], depthBottom[x + 1], depthTop[x], depthTop[x + 1]);
+				const __m128 passed = _mm_and_ps(_mm_cmplt_ps(depth, stored), _mm_cmple_ps(depth, farPlane));
+				const uint32_t mask = uint32_t(_mm_movemask_ps(passed)) & ~outside;
+				if (mask != 0) {
+					quad.mMask = mask;
+					quad.mX = uint32_t(x);
+					quad.mY = uint32_t(y);
+					InterpolateQuad(triangle, draw.mVaryingsCount, e0, e1, e2, quad);
+					draw.mFragmentShader(quad, colors);
+
+					float depths[4];
+					_mm_storeu_ps(depths, depth);
+					uint32_t* colorBottom = &raster.mColor[size_t(y) * raster.mPitch + uint32_t(x)];
+					uint32_t* colorTop = colorBottom + raster.mPitch;
+					float* depthLanes[4] = { &depthBottom[x], &depthBottom[x + 1], &depthTop[x], &depthTop[x + 1] };
+					uint32_t* colorLanes[4] = { &colorBottom[0], &colorBottom[1], &colorTop[0], &colorTop[1] };
+					for (uint32_t lane = 0; lane < 4; lane++) {
+						if ((mask & (1u << lane)) != 0) {
+							*depthLanes[lane] = depths[lane];
+							*colorLanes[lane] = PackColor(colors[lane]);
+						}
+					}
+					counts.mQuads++;
+					counts.mPixels += PopCount4(mask);
+				}
+			}
+			e0 = _mm_add_epi32(e0, edgeStepX[0]);
+			e1 = _mm_add_epi32(e1, edgeStepX[1]);
+			e2 = _mm_add_epi32(e2, edgeStepX[2]);
+			depth = _mm_add_ps(depth, depthStepX);
+		}
+		for (uint32_t i = 0; i < 3; i++) {
+			edges[i] = _mm_add_epi32(edges[i], edgeStepY[i]);
+		}
+		depthRow = _mm_add_ps(depthRow, depthStepY);
+	}
+}
+
+// Walks the bins of a tile in submission order: the setup threads own consecutive ranges of draws.
+RasterCounts RasterizeTile(SoftRaster& raster, uint32_t tile, uint32_t setupThreads) {
+	RasterCounts counts;
+	const uint32_t tilesCount = raster.mTilesX * raster.mTilesY;
+	const uint32_t tileX = (tile % raster.mTilesX) * cSoftTileSize;
+	const uint32_t tileY = (tile / raster.mTilesX) * cSoftTileSize;
+	for (uint32_t thread = 0; thread < setupThreads; thread++) {
+		const std::vector<SoftTriangle>& triangles = raster.mTriangles[thread];
+		for (uint32_t index : raster.mBins[size_t(thread) * tilesCount + tile]) {
+			RasterizeTriangle(raster, triangles[index], tileX, tileY, counts);
+		}
+	}
+	return counts;
+}
+
+}
+
+bool SoftTexture_Create(SoftTexture& texture, const char* filename) {
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* data = stbi_load(filename, &width, &height, &channels, 4);
+	stbi_set_flip_vertically_on_load(false);
+	if (data == nullptr) {
+		Log(tinyngine::Logger::Error, "Failed to load %s", filename);
+		return false;
+	}
+	// 4 channels were requested, the texels are RGBA8 in memory order
+	std::vector<uint32_t> texels(size_t(width) * size_t(height));
+	for (size_t i = 0; i < texels.size(); i++) {
+		const unsigned char* texel = data + i * 4;
+		texels[i] = uint32_t(texel[0]) | (uint32_t(texel[1]) << 8) | (uint32_t(texel[2]) << 16) | (uint32_t(texel[3]) << 24);
+	}
+	stbi_image_free(data);
+	return SoftTexture_Create(texture, uint32_t(width), uint32_t(height), texels.data());
+}
+
+bool SoftTexture_Create(SoftTexture& texture, uint32_t width, uint32_t height, const uint32_t* texels) {
+	texture.mLevels.clear();
+	if (width == 0 || height == 0 || texels == nullptr) {
+		return false;
+	}
+	SoftTextureLevel level;
+	level.mWidth = width;
+	level.mHeight = height;
+	level.mTexels.assign(texels, texels + size_t(width) * height);
+	texture.mLevels.push_back(std::move(level));
+	BuildMips(texture);
+	return true;
+}
+
+glm::vec4 SoftTexture_Sample(const SoftTexture& texture, const glm::vec2& uv, float lod) {
+	if (texture.mLevels.empty()) {
+		return glm::vec4(0.0f);
+	}
+	if (texture.mFiltering == TextureFilteringMode::None || texture.mFiltering == TextureFilteringMode::Nearest) {
+		return SampleNearest(texture.mLevels[0], uv);
+	}
+	// NaN (degenerate derivatives) and magnification both use the first level
+	const float maxLevel = float(texture.mLevels.size() - 1);
+	lod = (lod > 0.0f) ? std::min(lod, maxLevel) : 0.0f;
+	if (texture.mFiltering == TextureFilteringMode::Bilinear) {
+		return SampleBilinear(texture.mLevels[uint32_t(lod + 0.5f)], uv);
+	}
+	const uint32_t level = uint32_t(lod);
+	const float fraction = lod - float(level);
+	const glm::vec4 finer = SampleBilinear(texture.mLevels[level], uv);
+	if (fraction == 0.0f) {
+		return finer;
+	}
+	return glm::mix(finer, SampleBilinear(texture.mLevels[level + 1], uv), fraction);
+}
+
+void SoftTexture_SampleQuad(const SoftTexture& texture, const float* u, const float* v, glm::vec4* colors) {
+	float lod = 0.0f;
+	if (!texture.mLevels.empty()) {
+		const float width = float(texture.mLevels[0].mWidth);
+		const float height = float(texture.mLevels[0].mHeight);
+		const float dudx = (u[1] - u[0]) * width;
+		const float dvdx = (v[1] - v[0]) * height;
+		const float dudy = (u[2] - u[0]) * width;
+		const float dvdy = (v[2] - v[0]) * height;
+		const float rho = std::max(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy);
+		lod = 0.5f * std::log2(rho);
+	}
+	for (uint32_t lane = 0; lane < 4; lane++) {
+		colors[lane] = SoftTexture_Sample(texture, glm::vec2(u[lane], v[lane]), lod);
+	}
+}
+
+void SoftRaster_Initialize(SoftRaster& raster, uint32_t width, uint32_t height) {
+	raster.mWidth = std::min(std::max(width, 1u), cSoftMaxTargetSize);
+	raster.mHeight = std::min(std::max(height, 1u), cSoftMaxTargetSize);
+	raster.mTilesX = (raster.mWidth + cSoftTileSize - 1) / cSoftTileSize;
+	raster.mTilesY = (raster.mHeight + cSoftTileSize - 1) / cSoftTileSize;
+	raster.mPitch = raster.mTilesX * cSoftTileSize;
+	raster.mColor.assign(size_t(raster.mPitch) * raster.mTilesY * cSoftTileSize, 0u);
+	raster.mDepth.assign(raster.mColor.size(), 1.0f);
+	raster.mDraws.clear();
+	raster.mBins.clear();
+	raster.mStats = SoftRasterStats();
+}
+
+void SoftRaster_Begin(SoftRaster& raster, const glm::vec4& clearColor, float clearDepth) {
+	std::fill(raster.mColor.begin(), raster.mColor.end(), PackColor(clearColor));
+	std::fill(raster.mDepth.begin(), raster.mDepth.end(), clearDepth);
+	raster.mDraws.clear();
+}
+
+void SoftRaster_Draw(SoftRaster& raster, const SoftDraw& draw) {
+	if (draw.mVertices == nullptr || draw.mVertexCount == 0 || draw.mVaryingsCount > cSoftMaxVaryings || !draw.mVertexShader ||
+		!draw.mFragmentShader) {
+		return;
+	}
+	raster.mDraws.push_back(draw);
+	raster.mStats.mTriangles += (draw.mIndices != nullptr) ? draw.mIndexCount / 3 : draw.mVertexCount / 3;
+}
+
+void SoftRaster_Flush(SoftRaster& raster, uint32_t threadsCount) {
+	const uint32_t drawsCount = uint32_t(raster.mDraws.size());
+	if (drawsCount == 0 || raster.mColor.empty()) {
+		return;
+	}
+
+	const double setupStart = FrameLoop_GetTime();
+	const uint32_t tilesCount = raster.mTilesX * raster.mTilesY;
+	const uint32_t setupThreads = std::min(std::max(threadsCount, 1u), drawsCount);
+	raster.mVertices.resize(setupThreads);
+	raster.mTriangles.resize(setupThreads);
+	raster.mBins.resize(size_t(setupThreads) * tilesCount);
+	for (uint32_t thread = 0; thread < setupThreads; thread++) {
+		raster.mTriangles[thread].clear();
+	}
+	for (auto& bin : raster.mBins) {
+		bin.clear();
+	}
+
+	std::vector<SetupCounts> setupCounts(setupThreads);
+	const uint32_t slice = (drawsCount + setupThreads - 1) / setupThreads;
+	Job_RunSlices(setupThreads, [&](uint32_t thread) {
+		const uint32_t first = thread * slice;
+		const uint32_t end = std::min(first + slice, drawsCount);
+		if (first < end) {
+			setupCounts[thread] = SetupDraws(raster, thread, first, end);
+		}
+	});
+	const double rasterStart = FrameLoop_GetTime();
+
+	std::atomic<uint64_t> quads{ 0 };
+	std::atomic<uint64_t> pixels{ 0 };
+	Job_ParallelFor(tilesCount, 1, [&](uint32_t begin, uint32_t end) {
+		RasterCounts counts;
+		for (uint32_t tile = begin; tile < end; tile++) {
+			const RasterCounts tileCounts = RasterizeTile(raster, tile, setupThreads);
+			counts.mQuads += tileCounts.mQuads;
+			counts.mPixels += tileCounts.mPixels;
+		}
+		quads += counts.mQuads;
+		pixels += counts.mPixels;
+	});
+	const double rasterEnd = FrameLoop_GetTime();
+
+	for (const SetupCounts& counts : setupCounts) {
+		raster.mStats.mRasterizedTriangles += counts.mTriangles;
+		raster.mStats.mBinnedTriangles += counts.mBinned;
+	}
+	raster.mStats.mShadedQuads += quads.load();
+	raster.mStats.mShadedPixels += pixels.load();
+	raster.mStats.mSetupMilliseconds += (rasterStart - setupStart) * 1000.0;
+	raster.mStats.mRasterMilliseconds += (rasterEnd - rasterStart) * 1000.0;
+	raster.mDraws.clear();
+}
+
+uint32_t SoftRaster_GetPixel(const SoftRaster& raster, uint32_t x, uint32_t y) {
+	if (x >= raster.mWidth || y >= raster.mHeight) {
+		return 0;
+	}
+	return raster.mColor[size_t(y) * raster.mPitch + x];
+}
+
+bool SoftRaster_SaveImage(const SoftRaster& raster, const char* filename) {
+	FILE* file = fopen(filename, "wb");
+	if (file == nullptr) {
+		Log(tinyngine::Logger::Error, "Failed to open %s", filename);
+		return false;
+	}
+	fprintf(file, "P6\n%u %u\n255\n", raster.mWidth, raster.mHeight);
+	std::vector<uint8_t> row(size_t(raster.mWidth) * 3);
+	for (uint32_t y = raster.mHeight; y-- > 0;) {
+		for (uint32_t x = 0; x < raster.mWidth; x++) {
+			const uint32_t color = SoftRaster_GetPixel(raster, x, y);
+			row[x * 3 + 0] = uint8_t(color & 0xff);
+			row[x * 3 + 1] = uint8_t((color >> 8) & 0xff);
+			row[x * 3 + 2] = uint8_t((color >> 16) & 0xff);
+		}
+		fwrite(row.data(), 1, row.size(), file);
+	}
+	const bool written = ferror(file) == 0;
+	fclose(file);
+	return written;
+}
+
+const SoftRasterStats& SoftRaster_GetStats(const SoftRaster& raster) {
+	return raster.mStats;
+}
+
+void SoftRaster_ResetStats(SoftRaster& raster) {
+	raster.mStats = SoftRasterStats();
+}
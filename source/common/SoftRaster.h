@@ -0,0 +1,147 @@
+#pragma once
+
+#include "CommonDefine.h"
+#include "PipelineState.h"
+#include "Texture.h"
+#include "glm/vec2.hpp"
+#include "glm/vec4.hpp"
+
+#include <functional>
+#include <vector>
+
+// CPU rasterizer for deterministic, GPU-free renders of the samples: shaders are C++ callbacks, the output does not
+// depend on the threads count nor the instruction set, so it can be compared against reference images.
+//
+// SoftRaster_Flush runs in two parallel phases. The draws are split in as many contiguous ranges as threads, each
+// thread shades the vertices of its range, clips and sets up the triangles and bins them to the 64x64 tiles they
+// touch. Then every tile walks its bins in submission order, evaluates the fixed point edge functions of 2x2 pixel
+// quads with SSE2, depth tests them and calls the fragment shader on the covered quads. No two threads touch the same
+// tile, so there is no locking and no ordering issue.
+static constexpr uint32_t cSoftTileSize = 64;
+static constexpr uint32_t cSoftMaxVaryings = 12;			// floats passed from the vertex to the fragment shader
+static constexpr uint32_t cSoftMaxTargetSize = 2048;		// keeps the fixed point edge functions in 32 bits
+
+// RGBA8 mip chain, repeat wrapping, the first row is the bottom of the image as with GL textures.
+struct SoftTextureLevel {
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	std::vector<uint32_t> mTexels;
+};
+
+struct SoftTexture {
+	std::vector<SoftTextureLevel> mLevels;
+	TextureFilteringMode::Enum mFiltering = TextureFilteringMode::Trilinear;	// Bilinear uses the nearest mip as GL does
+};
+
+struct SoftVertex {
+	glm::vec4 mPosition;						// clip space, as gl_Position
+	float mVaryings[cSoftMaxVaryings];
+};
+
+// Attributes of one vertex in, clip position and varyings out.
+using SoftVertexShader = std::function<void(const float* attributes, SoftVertex& output)>;
+
+// The varyings of a 2x2 quad, perspective correct, stored per varying: mVaryings[i][lane]. Lanes are (x, y),
+// (x + 1, y), (x, y + 1), (x + 1, y + 1). Lanes outside of mMask are still interpolated so that derivatives (and
+// the mip selection of SoftTexture_SampleQuad) work on triangle edges.
+struct SoftFragmentQuad {
+	float mVaryings[cSoftMaxVaryings][4];
+	uint32_t mMask = 0;							// bit i set when lane i is written
+	uint32_t mX = 0;
+	uint32_t mY = 0;
+};
+
+// Writes the 4 colors of a quad, only the lanes in mMask are stored.
+using SoftFragmentShader = std::function<void(const SoftFragmentQuad& quad, glm::vec4* colors)>;
+
+// Shaders capture their uniforms by value: draws are only executed by SoftRaster_Flush.
+struct SoftDraw {
+	const float* mVertices = nullptr;			// interleaved attributes, referenced until SoftRaster_Flush returns
+	uint32_t mStride = 0;						// in floats
+	uint32_t mVertexCount = 0;
+	const uint32_t* mIndices = nullptr;			// optional, triangle list
+	uint32_t mIndexCount = 0;
+	uint32_t mVaryingsCount = 0;
+	CullMode::Enum mCull = CullMode::None;		// counter clockwise front faces
+	SoftVertexShader mVertexShader;
+	SoftFragmentShader mFragmentShader;
+};
+
+struct SoftRasterStats {
+	uint64_t mTriangles = 0;					// submitted
+	uint64_t mRasterizedTriangles = 0;			// after culling and clipping, a clipped triangle may give several
+	uint64_t mBinnedTriangles = 0;				// triangle and tile pairs
+	uint64_t mShadedQuads = 0;
+	uint64_t mShadedPixels = 0;					// covered and depth tested pixels written
+	double mSetupMilliseconds = 0.0;			// vertex shading, clipping and binning
+	double mRasterMilliseconds = 0.0;			// rasterization and shading
+};
+
+// Screen space triangle ready to be rasterized, produced by the setup of the draws. Edge i goes from vertex i to
+// i + 1 and covers a pixel when mEdgeA * x + mEdgeB * y + mEdgeC >= 0, x and y being its center in 1/16 pixels
+// (the fill rule is folded in mEdgeC). Its value is proportional to the barycentric weight of vertex i + 2.
+struct SoftTriangle {
+	int32_t mEdgeA[3];
+	int32_t mEdgeB[3];
+	int64_t mEdgeC[3];
+	float mInverseArea;							// of the edge functions, to turn them into barycentric weights
+	float mZ0;									// window depth plane z = mZ0 + mZdX * x + mZdY * y, in pixels
+	float mZdX;
+	float mZdY;
+	float mInverseW[3];
+	float mVaryings[3][cSoftMaxVaryings];
+	uint32_t mDraw;
+	int32_t mMinX;								// pixels whose center may be covered, inclusive
+	int32_t mMinY;
+	int32_t mMaxX;
+	int32_t mMaxY;
+};
+
+struct SoftRaster {
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	uint32_t mTilesX = 0;
+	uint32_t mTilesY = 0;
+	uint32_t mPitch = 0;						// mTilesX * cSoftTileSize
+	std::vector<uint32_t> mColor;				// RGBA8, rows padded to whole tiles, bottom row first
+	std::vector<float> mDepth;					// window space, 0 near and 1 far
+
+	std::vector<SoftDraw> mDraws;
+	std::vector<std::vector<SoftVertex>> mVertices;			// per setup thread
+	std::vector<std::vector<SoftTriangle>> mTriangles;		// per setup thread
+	std::vector<std::vector<uint32_t>> mBins;				// per setup thread, per tile: indices in mTriangles
+	SoftRasterStats mStats;
+};
+
+// Loads an image file as Texture_Create does and builds the mip chain with a box filter.
+bool SoftTexture_Create(SoftTexture& texture, const char* filename);
+
+bool SoftTexture_Create(SoftTexture& texture, uint32_t width, uint32_t height, const uint32_t* texels);
+
+// Filtered sample at an explicit level of detail (log2 of the texels per pixel).
+glm::vec4 SoftTexture_Sample(const SoftTexture& texture, const glm::vec2& uv, float lod);
+
+// Samples the 4 lanes of a quad, the level of detail comes from the differences between the lanes as the GPU
+// derivatives do.
+void SoftTexture_SampleQuad(const SoftTexture& texture, const float* u, const float* v, glm::vec4* colors);
+
+// Width and height are clamped to cSoftMaxTargetSize.
+void SoftRaster_Initialize(SoftRaster& raster, uint32_t width, uint32_t height);
+
+// Forgets the queued draws and clears the targets.
+void SoftRaster_Begin(SoftRaster& raster, const glm::vec4& clearColor, float clearDepth = 1.0f);
+
+void SoftRaster_Draw(SoftRaster& raster, const SoftDraw& draw);
+
+// Executes the queued draws, with up to threadsCount threads of the job system.
+void SoftRaster_Flush(SoftRaster& raster, uint32_t threadsCount);
+
+// Color of the pixel (x, y), y = 0 being the bottom row.
+uint32_t SoftRaster_GetPixel(const SoftRaster& raster, uint32_t x, uint32_t y);
+
+// Binary PPM, top row first, e.g. for reference images.
+bool SoftRaster_SaveImage(const SoftRaster& raster, const char* filename);
+
+const SoftRasterStats& SoftRaster_GetStats(const SoftRaster& raster);
+
+void SoftRaster_ResetStats(SoftRaster& raster);
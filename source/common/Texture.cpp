@@ -17,6 +17,22 @@ struct TextureFormatInfo {
 static TextureFormatInfo sTextureFormats[]{
 	{ GL_RGB, GL_RGB, GL_UNSIGNED_BYTE },			// RGB8
 	{ GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE },			// RGBA8
+	{ GL_R16UI, GL_RED_INTEGER, GL_UNSIGNED_SHORT },	// R16UI
+	{ GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT },	// R32UI
+	{ GL_RG32UI, GL_RG_INTEGER, GL_UNSIGNED_INT },	// RG32UI
+	{ GL_RGBA32UI, GL_RGBA_INTEGER, GL_UNSIGNED_INT },	// RGBA32UI
+	{ GL_RGBA32F, GL_RGBA, GL_FLOAT },				// RGBA32F
+	{ GL_RG16, GL_RG, GL_UNSIGNED_SHORT },			// RG16
+	{ GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT },			// RGBA16F
+	{ GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8 },	// Depth24Stencil8
+	{ GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT },		// Depth32F
+};
+
+static const GLenum sWrapModes[]{
+	GL_REPEAT,
+	GL_CLAMP_TO_EDGE,
+	GL_MIRRORED_REPEAT,
+	GL_CLAMP_TO_BORDER,
 };
 
 class Texture {
@@ -47,15 +63,59 @@ public:
 
 		GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
 
+		mTarget = GL_TEXTURE_2D;
+		mFormat = textureFormat;
 		mWidth = width;
 		mHeight = height;
+		mMipmaps = true;
+	}
+
+	void CreateRenderTarget(uint32_t width, uint32_t height, TextureFormats::Enum textureFormat) {
+		glGenTextures(1, &mId);
+		GL_ERROR(mId == 0);
+
+		GL_CHECK(glBindTexture(GL_TEXTURE_2D, mId));
+		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+		GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
+		GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+
+		mTarget = GL_TEXTURE_2D;
+		mFormat = textureFormat;
+		mMipmaps = false;
+		Resize(width, height);
+	}
+
+	void Resize(uint32_t width, uint32_t height) {
+		if (IsValid() && mTarget == GL_TEXTURE_2D && !mMipmaps) {
+			const TextureFormatInfo& info = sTextureFormats[mFormat];
+			GL_CHECK(glBindTexture(GL_TEXTURE_2D, mId));
+			GL_CHECK(glTexImage2D(GL_TEXTURE_2D, 0, info.mInternalFormat, width, height, 0, info.mFormat, info.mType, nullptr));
+			GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+			mWidth = width;
+			mHeight = height;
+		}
+	}
+
+	void CreateBuffer(GLuint buffer, TextureFormats::Enum textureFormat) {
+		glGenTextures(1, &mId);
+		GL_ERROR(mId == 0);
+
+		GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, mId));
+		GL_CHECK(glTexBuffer(GL_TEXTURE_BUFFER, sTextureFormats[textureFormat].mInternalFormat, buffer));
+		GL_CHECK(glBindTexture(GL_TEXTURE_BUFFER, 0));
+
+		mTarget = GL_TEXTURE_BUFFER;
+		mFormat = textureFormat;
 	}
 
 	void Destroy() {
 		if (IsValid()) {
-			GL_CHECK(glBindTexture(GL_TEXTURE_2D, mId));
+			GL_CHECK(glBindTexture(mTarget, mId));
 			GL_CHECK(glDeleteTextures(1, &mId));
-			GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+			GL_CHECK(glBindTexture(mTarget, 0));
 			mId = 0;
 		}
 	}
@@ -63,7 +123,43 @@ public:
 	void Bind(uint8_t stage = 0) {
 		if (IsValid()) {
 			GL_CHECK(glActiveTexture(GL_TEXTURE0 + stage));
+			GL_CHECK(glBindTexture(mTarget, mId));
+		}
+	}
+
+	void SetFilteringMode(TextureFilteringMode::Enum mode) {
+		if (IsValid() && mTarget == GL_TEXTURE_2D) {
+			GLenum minFilter = GL_NEAREST;
+			GLenum magFilter = GL_NEAREST;
+			if (mode == TextureFilteringMode::Bilinear) {
+				minFilter = mMipmaps ? GL_LINEAR_MIPMAP_NEAREST : GL_LINEAR;
+				magFilter = GL_LINEAR;
+			} else if (mode == TextureFilteringMode::Trilinear) {
+				minFilter = mMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
+				magFilter = GL_LINEAR;
+			}
 			GL_CHECK(glBindTexture(GL_TEXTURE_2D, mId));
+			GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter));
+			GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter));
+			GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+		}
+	}
+
+	void SetWrappingMode(TextureWrapMode::Enum mode) {
+		if (IsValid() && mTarget == GL_TEXTURE_2D) {
+			GL_CHECK(glBindTexture(GL_TEXTURE_2D, mId));
+			GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, sWrapModes[mode]));
+			GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, sWrapModes[mode]));
+			GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+		}
+	}
+
+	void SetShadowCompare(bool enable) {
+		if (IsValid() && mTarget == GL_TEXTURE_2D) {
+			GL_CHECK(glBindTexture(GL_TEXTURE_2D, mId));
+			GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, enable ? GL_COMPARE_REF_TO_TEXTURE : GL_NONE));
+			GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL));
+			GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
 		}
 	}
 
@@ -71,10 +167,29 @@ public:
 		return mId > 0;
 	}
 
+	TextureFormats::Enum GetFormat() const {
+		return mFormat;
+	}
+
+	GLuint GetId() const {
+		return mId;
+	}
+
+	uint32_t GetWidth() const {
+		return mWidth;
+	}
+
+	uint32_t GetHeight() const {
+		return mHeight;
+	}
+
 private:
 	GLuint mId = 0;
+	GLenum mTarget = GL_TEXTURE_2D;
+	TextureFormats::Enum mFormat = TextureFormats::RGB8;
 	uint32_t mWidth = 0;
 	uint32_t mHeight = 0;
+	bool mMipmaps = false;
 };
 
 static constexpr uint32_t cMaxTextureHandles = (1 << 6);
@@ -103,6 +218,63 @@ TextureHandle Texture_Create(const char* filename, TextureFormats::Enum format)
 	return TextureHandle(cInvalidHandle);
 }
 
+TextureHandle Texture_CreateFromMemory(const uint8_t* data, uint32_t size, TextureFormats::Enum format) {
+	if (data != nullptr && size > 0) {
+		int width, height, channels;
+		int desiredChannels = (format == TextureFormats::RGBA8) ? 4 : 3;
+		stbi_set_flip_vertically_on_load(false);
+		unsigned char *pixels = stbi_load_from_memory(data, int(size), &width, &height, &channels, desiredChannels);
+		TINYNGINE_UNUSED(channels);
+		if (pixels) {
+			TextureHandle handle = TextureHandle(sTexturesCount);
+			auto& texture = sTextures[handle.mHandle];
+			texture.Create(width, height, format, pixels);
+
+			stbi_image_free(pixels);
+			sTexturesCount++;
+
+			return handle;
+		}
+	}
+	return TextureHandle(cInvalidHandle);
+}
+
+TextureHandle Texture_CreateBuffer(const BufferHandle& buffer, TextureFormats::Enum format) {
+	if (!buffer.IsValid() || sTexturesCount >= cMaxTextureHandles) {
+		return TextureHandle(cInvalidHandle);
+	}
+	TextureHandle handle = TextureHandle(sTexturesCount);
+	auto& texture = sTextures[handle.mHandle];
+	texture.CreateBuffer(Buffer_GetNativeId(buffer), format);
+	if (!texture.IsValid()) {
+		return TextureHandle(cInvalidHandle);
+	}
+	sTexturesCount++;
+	return handle;
+}
+
+TextureHandle Texture_CreateRenderTarget(uint32_t width, uint32_t height, TextureFormats::Enum format) {
+	if (width == 0 || height == 0 || sTexturesCount >= cMaxTextureHandles) {
+		return TextureHandle(cInvalidHandle);
+	}
+	TextureHandle handle = TextureHandle(sTexturesCount);
+	auto& texture = sTextures[handle.mHandle];
+	texture.CreateRenderTarget(width, height, format);
+	if (!texture.IsValid()) {
+		return TextureHandle(cInvalidHandle);
+	}
+	sTexturesCount++;
+	return handle;
+}
+
+void Texture_Resize(const TextureHandle& handle, uint32_t width, uint32_t height) {
+	if (!handle.IsValid() || width == 0 || height == 0) {
+		return;
+	}
+	auto& texture = sTextures[handle.mHandle];
+	texture.Resize(width, height);
+}
+
 void Texture_Destroy(const TextureHandle& handle) {
 	if (!handle.IsValid()) {
 		return;
@@ -119,10 +291,59 @@ void Texture_Bind(const TextureHandle& handle, uint8_t stage) {
 	texture.Bind(stage);
 }
 
+void Texture_Unbind(uint8_t stage) {
+	GL_CHECK(glActiveTexture(GL_TEXTURE0 + stage));
+	GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
 void Texture_SetFilteringMode(const TextureHandle & handle, TextureFilteringMode::Enum mode) {
-	(void)handle; (void)mode;
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& texture = sTextures[handle.mHandle];
+	texture.SetFilteringMode(mode);
 }
 
 void Texture_SetWrappingMode(const TextureHandle & handle, TextureWrapMode::Enum mode) {
-	(void)handle; (void)mode;
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& texture = sTextures[handle.mHandle];
+	texture.SetWrappingMode(mode);
+}
+
+void Texture_SetShadowCompare(const TextureHandle& handle, bool enable) {
+	if (!handle.IsValid()) {
+		return;
+	}
+	auto& texture = sTextures[handle.mHandle];
+	texture.SetShadowCompare(enable);
+}
+
+uint32_t Texture_GetWidth(const TextureHandle& handle) {
+	if (!handle.IsValid()) {
+		return 0;
+	}
+	return sTextures[handle.mHandle].GetWidth();
+}
+
+uint32_t Texture_GetHeight(const TextureHandle& handle) {
+	if (!handle.IsValid()) {
+		return 0;
+	}
+	return sTextures[handle.mHandle].GetHeight();
+}
+
+TextureFormats::Enum Texture_GetFormat(const TextureHandle& handle) {
+	if (!handle.IsValid()) {
+		return TextureFormats::Count;
+	}
+	return sTextures[handle.mHandle].GetFormat();
+}
+
+uint32_t Texture_GetNativeId(const TextureHandle& handle) {
+	if (!handle.IsValid()) {
+		return 0;
+	}
+	return sTextures[handle.mHandle].GetId();
 }
@@ -1,11 +1,21 @@
 #pragma once
 
 #include "CommonDefine.h"
+#include "Buffer.h"
 
 struct TextureFormats {
 	enum Enum {
 		RGB8,
 		RGBA8,
+		R16UI,
+		R32UI,
+		RG32UI,
+		RGBA32UI,
+		RGBA32F,
+		RG16,
+		RGBA16F,
+		Depth24Stencil8,
+		Depth32F,
 		Count
 	};
 };
@@ -34,10 +44,36 @@ using TextureHandle = ResourceHandle;
 
 TextureHandle Texture_Create(const char* filename, TextureFormats::Enum format);
 
+TextureHandle Texture_CreateFromMemory(const uint8_t* data, uint32_t size, TextureFormats::Enum format);
+
+// Texture buffer exposing the content of a BufferType::Texture buffer to shaders (samplerBuffer, usamplerBuffer),
+// the buffer can be updated or grown afterwards.
+TextureHandle Texture_CreateBuffer(const BufferHandle& buffer, TextureFormats::Enum format);
+
+// Uninitialized texture without mipmaps to render into, sampled with nearest filtering and clamped to the edges.
+TextureHandle Texture_CreateRenderTarget(uint32_t width, uint32_t height, TextureFormats::Enum format);
+
+// Reallocates the storage of a render target texture, the previous content is lost.
+void Texture_Resize(const TextureHandle& handle, uint32_t width, uint32_t height);
+
 void Texture_Destroy(const TextureHandle& handle);
 
 void Texture_Bind(const TextureHandle& handle, uint8_t stage);
 
+// Binds no 2D texture to the stage, shaders sampling it read black.
+void Texture_Unbind(uint8_t stage);
+
 void Texture_SetFilteringMode(const TextureHandle& handle, TextureFilteringMode::Enum mode);
 
-void Texture_SetWrappingMode(const TextureHandle& handle, TextureWrapMode::Enum mode);
\ No newline at end of file
+void Texture_SetWrappingMode(const TextureHandle& handle, TextureWrapMode::Enum mode);
+
+// Depth textures only: sampled through a sampler2DShadow, returning the result of reference <= depth, filtered.
+void Texture_SetShadowCompare(const TextureHandle& handle, bool enable);
+
+uint32_t Texture_GetWidth(const TextureHandle& handle);
+
+uint32_t Texture_GetHeight(const TextureHandle& handle);
+
+TextureFormats::Enum Texture_GetFormat(const TextureHandle& handle);
+
+uint32_t Texture_GetNativeId(const TextureHandle& handle);
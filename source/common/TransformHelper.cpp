@@ -26,13 +26,13 @@ struct TransformHelper::Impl {
 	glm::mat4 mModelViewProjectionMatrix;
 };
 
-TransformHelper::TransformHelper() : mImpl(std::make_unique<Impl>()) {
+TransformHelper::TransformHelper() : mImpl(std::unique_ptr<Impl>(new Impl())) {
 	Reset();
 }
 
 TransformHelper::TransformHelper(TransformHelper& rhs) : mImpl(nullptr) {
 	if (rhs.mImpl != nullptr) {
-		mImpl = std::make_unique<Impl>((*rhs.mImpl));
+		mImpl = std::unique_ptr<Impl>(new Impl(*rhs.mImpl));
 	}
 }
 
@@ -41,7 +41,7 @@ TransformHelper& TransformHelper::operator=(TransformHelper& rhs) {
 		mImpl.reset();
 	}
 	else if (mImpl == nullptr) {
-		mImpl = std::make_unique<Impl>((*rhs.mImpl));
+		mImpl = std::unique_ptr<Impl>(new Impl(*rhs.mImpl));
 	} else {
 		*mImpl = *rhs.mImpl;
 	}